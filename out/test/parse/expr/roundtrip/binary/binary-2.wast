@@ -0,0 +1,179 @@
+(module
+  (type (;0;) (func))
+  (func (;0;) (type 0)
+    i32.const 0
+    i32.const 0
+    i32.add
+    drop
+    i64.const 0
+    i64.const 0
+    i64.add
+    drop
+    f32.const 0x0p+0 (;=0;)
+    f32.const 0x0p+0 (;=0;)
+    f32.add
+    drop
+    f64.const 0x0p+0 (;=0;)
+    f64.const 0x0p+0 (;=0;)
+    f64.add
+    drop
+    i32.const 0
+    i32.const 0
+    i32.sub
+    drop
+    i64.const 0
+    i64.const 0
+    i64.sub
+    drop
+    f32.const 0x0p+0 (;=0;)
+    f32.const 0x0p+0 (;=0;)
+    f32.sub
+    drop
+    f64.const 0x0p+0 (;=0;)
+    f64.const 0x0p+0 (;=0;)
+    f64.sub
+    drop
+    i32.const 0
+    i32.const 0
+    i32.mul
+    drop
+    i64.const 0
+    i64.const 0
+    i64.mul
+    drop
+    f32.const 0x0p+0 (;=0;)
+    f32.const 0x0p+0 (;=0;)
+    f32.mul
+    drop
+    f64.const 0x0p+0 (;=0;)
+    f64.const 0x0p+0 (;=0;)
+    f64.mul
+    drop
+    i32.const 0
+    i32.const 0
+    i32.div_s
+    drop
+    i64.const 0
+    i64.const 0
+    i64.div_s
+    drop
+    i32.const 0
+    i32.const 0
+    i32.div_u
+    drop
+    i64.const 0
+    i64.const 0
+    i64.div_u
+    drop
+    f32.const 0x0p+0 (;=0;)
+    f32.const 0x0p+0 (;=0;)
+    f32.div
+    drop
+    f64.const 0x0p+0 (;=0;)
+    f64.const 0x0p+0 (;=0;)
+    f64.div
+    drop
+    i32.const 0
+    i32.const 0
+    i32.rem_s
+    drop
+    i64.const 0
+    i64.const 0
+    i64.rem_s
+    drop
+    i32.const 0
+    i32.const 0
+    i32.rem_u
+    drop
+    i64.const 0
+    i64.const 0
+    i64.rem_u
+    drop
+    f32.const 0x0p+0 (;=0;)
+    f32.const 0x0p+0 (;=0;)
+    f32.min
+    drop
+    f64.const 0x0p+0 (;=0;)
+    f64.const 0x0p+0 (;=0;)
+    f64.min
+    drop
+    f32.const 0x0p+0 (;=0;)
+    f32.const 0x0p+0 (;=0;)
+    f32.max
+    drop
+    f64.const 0x0p+0 (;=0;)
+    f64.const 0x0p+0 (;=0;)
+    f64.max
+    drop
+    i32.const 0
+    i32.const 0
+    i32.and
+    drop
+    i64.const 0
+    i64.const 0
+    i64.and
+    drop
+    i32.const 0
+    i32.const 0
+    i32.or
+    drop
+    i64.const 0
+    i64.const 0
+    i64.or
+    drop
+    i32.const 0
+    i32.const 0
+    i32.xor
+    drop
+    i64.const 0
+    i64.const 0
+    i64.xor
+    drop
+    i32.const 0
+    i32.const 0
+    i32.shl
+    drop
+    i64.const 0
+    i64.const 0
+    i64.shl
+    drop
+    i32.const 0
+    i32.const 0
+    i32.shr_u
+    drop
+    i64.const 0
+    i64.const 0
+    i64.shr_u
+    drop
+    i32.const 0
+    i32.const 0
+    i32.shr_s
+    drop
+    i64.const 0
+    i64.const 0
+    i64.shr_s
+    drop
+    i32.const 0
+    i32.const 0
+    i32.rotl
+    drop
+    i64.const 0
+    i64.const 0
+    i64.rotl
+    drop
+    i32.const 0
+    i32.const 0
+    i32.rotr
+    drop
+    i64.const 0
+    i64.const 0
+    i64.rotr
+    drop
+    f32.const 0x0p+0 (;=0;)
+    f32.const 0x0p+0 (;=0;)
+    f32.copysign
+    drop
+    f64.const 0x0p+0 (;=0;)
+    f64.const 0x0p+0 (;=0;)
+    f64.copysign
+    drop))
@@ -0,0 +1,19 @@
+(module
+  (type (;0;) (func))
+  (func (;0;) (type 0)
+    block  ;; label = @1
+      block  ;; label = @2
+        block  ;; label = @3
+          block  ;; label = @4
+            block  ;; label = @5
+              i32.const 0
+              br_table 4 (;@1;) 3 (;@2;) 2 (;@3;) 1 (;@4;) 0 (;@5;)
+            end
+            nop
+          end
+          nop
+        end
+        nop
+      end
+      nop
+    end))
@@ -0,0 +1,6 @@
+(module
+  (type (;0;) (func (param i32) (result i32)))
+  (import "foo" "bar" (func (;0;) (type 0)))
+  (func (;1;) (type 0) (param i32) (result i32)
+    i32.const 0
+    call 0))
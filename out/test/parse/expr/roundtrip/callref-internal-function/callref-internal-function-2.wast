@@ -0,0 +1,13 @@
+(module
+  (type (;0;) (func (result i32)))
+  (type (;1;) (func (param i32) (result i32)))
+  (func (;0;) (type 0) (result i32)
+    i32.const 10
+    ref.func 1
+    call_ref)
+  (func (;1;) (type 1) (param i32) (result i32)
+    local.get 0
+    i32.const 19
+    i32.add)
+  (export "main" (func 0))
+  (elem (;0;) declare func 1))
@@ -0,0 +1,15 @@
+(module
+  (type (;0;) (func))
+  (func (;0;) (type 0)
+    i32.const 0
+    f32.reinterpret_i32
+    drop
+    f32.const 0x0p+0 (;=0;)
+    i32.reinterpret_f32
+    drop
+    i64.const 0
+    f64.reinterpret_i64
+    drop
+    f64.const 0x0p+0 (;=0;)
+    i64.reinterpret_f64
+    drop))
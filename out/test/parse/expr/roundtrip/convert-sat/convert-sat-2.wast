@@ -0,0 +1,27 @@
+(module
+  (type (;0;) (func))
+  (func (;0;) (type 0)
+    f32.const 0x0p+0 (;=0;)
+    i32.trunc_sat_f32_s
+    drop
+    f32.const 0x0p+0 (;=0;)
+    i32.trunc_sat_f32_u
+    drop
+    f64.const 0x0p+0 (;=0;)
+    i32.trunc_sat_f64_s
+    drop
+    f64.const 0x0p+0 (;=0;)
+    i32.trunc_sat_f64_u
+    drop
+    f32.const 0x0p+0 (;=0;)
+    i64.trunc_sat_f32_s
+    drop
+    f32.const 0x0p+0 (;=0;)
+    i64.trunc_sat_f32_u
+    drop
+    f64.const 0x0p+0 (;=0;)
+    i64.trunc_sat_f64_s
+    drop
+    f64.const 0x0p+0 (;=0;)
+    i64.trunc_sat_f64_u
+    drop))
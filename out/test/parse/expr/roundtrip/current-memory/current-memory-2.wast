@@ -0,0 +1,6 @@
+(module
+  (type (;0;) (func))
+  (func (;0;) (type 0)
+    memory.size
+    drop)
+  (memory (;0;) 1))
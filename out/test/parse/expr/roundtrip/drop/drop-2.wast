@@ -0,0 +1,11 @@
+(module
+  (type (;0;) (func))
+  (func (;0;) (type 0)
+    i32.const 0
+    drop
+    i64.const 0
+    drop
+    f32.const 0x0p+0 (;=0;)
+    drop
+    f64.const 0x0p+0 (;=0;)
+    drop))
@@ -0,0 +1,6 @@
+(module
+  (type (;0;) (func (result externref)))
+  (func (;0;) (type 0) (result externref)
+    i32.const 0
+    table.get 0)
+  (table (;0;) 1 externref))
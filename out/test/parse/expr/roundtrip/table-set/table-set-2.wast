@@ -0,0 +1,7 @@
+(module
+  (type (;0;) (func (param externref)))
+  (func (;0;) (type 0) (param externref)
+    i32.const 0
+    local.get 0
+    table.set 0)
+  (table (;0;) 1 externref))
@@ -0,0 +1,18 @@
+(module
+  (type (;0;) (func))
+  (func (;0;) (type 0)
+    i32.const 0
+    i32.extend8_s
+    drop
+    i32.const 0
+    i32.extend16_s
+    drop
+    i64.const 0
+    i64.extend8_s
+    drop
+    i64.const 0
+    i64.extend16_s
+    drop
+    i64.const 0
+    i64.extend32_s
+    drop))
@@ -0,0 +1,263 @@
+(module
+  (type (;0;) (func))
+  (func (;0;) (type 0)
+    (drop
+      (memory.atomic.notify
+        (i64.const 0)
+        (i32.const 0)))
+    (drop
+      (memory.atomic.wait32
+        (i64.const 0)
+        (i32.const 0)
+        (i64.const 0)))
+    (drop
+      (memory.atomic.wait64
+        (i64.const 0)
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i32.atomic.load
+        (i64.const 0)))
+    (drop
+      (i64.atomic.load
+        (i64.const 0)))
+    (drop
+      (i32.atomic.load8_u
+        (i64.const 0)))
+    (drop
+      (i32.atomic.load16_u
+        (i64.const 0)))
+    (drop
+      (i64.atomic.load8_u
+        (i64.const 0)))
+    (drop
+      (i64.atomic.load16_u
+        (i64.const 0)))
+    (drop
+      (i64.atomic.load32_u
+        (i64.const 0)))
+    (i32.atomic.store
+      (i64.const 0)
+      (i32.const 0))
+    (i64.atomic.store
+      (i64.const 0)
+      (i64.const 0))
+    (i32.atomic.store8
+      (i64.const 0)
+      (i32.const 0))
+    (i32.atomic.store16
+      (i64.const 0)
+      (i32.const 0))
+    (i64.atomic.store8
+      (i64.const 0)
+      (i64.const 0))
+    (i64.atomic.store16
+      (i64.const 0)
+      (i64.const 0))
+    (i64.atomic.store32
+      (i64.const 0)
+      (i64.const 0))
+    (drop
+      (i32.atomic.rmw.add
+        (i64.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.atomic.rmw.add
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i32.atomic.rmw8.add_u
+        (i64.const 0)
+        (i32.const 0)))
+    (drop
+      (i32.atomic.rmw16.add_u
+        (i64.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.atomic.rmw8.add_u
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i64.atomic.rmw16.add_u
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i64.atomic.rmw32.add_u
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i32.atomic.rmw.sub
+        (i64.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.atomic.rmw.sub
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i32.atomic.rmw8.sub_u
+        (i64.const 0)
+        (i32.const 0)))
+    (drop
+      (i32.atomic.rmw16.sub_u
+        (i64.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.atomic.rmw8.sub_u
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i64.atomic.rmw16.sub_u
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i64.atomic.rmw32.sub_u
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i32.atomic.rmw.and
+        (i64.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.atomic.rmw.and
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i32.atomic.rmw8.and_u
+        (i64.const 0)
+        (i32.const 0)))
+    (drop
+      (i32.atomic.rmw16.and_u
+        (i64.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.atomic.rmw8.and_u
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i64.atomic.rmw16.and_u
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i64.atomic.rmw32.and_u
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i32.atomic.rmw.or
+        (i64.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.atomic.rmw.or
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i32.atomic.rmw8.or_u
+        (i64.const 0)
+        (i32.const 0)))
+    (drop
+      (i32.atomic.rmw16.or_u
+        (i64.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.atomic.rmw8.or_u
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i64.atomic.rmw16.or_u
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i64.atomic.rmw32.or_u
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i32.atomic.rmw.xor
+        (i64.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.atomic.rmw.xor
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i32.atomic.rmw8.xor_u
+        (i64.const 0)
+        (i32.const 0)))
+    (drop
+      (i32.atomic.rmw16.xor_u
+        (i64.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.atomic.rmw8.xor_u
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i64.atomic.rmw16.xor_u
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i64.atomic.rmw32.xor_u
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i32.atomic.rmw.xchg
+        (i64.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.atomic.rmw.xchg
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i32.atomic.rmw8.xchg_u
+        (i64.const 0)
+        (i32.const 0)))
+    (drop
+      (i32.atomic.rmw16.xchg_u
+        (i64.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.atomic.rmw8.xchg_u
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i64.atomic.rmw16.xchg_u
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i64.atomic.rmw32.xchg_u
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i32.atomic.rmw.cmpxchg
+        (i64.const 0)
+        (i32.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.atomic.rmw.cmpxchg
+        (i64.const 0)
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i32.atomic.rmw8.cmpxchg_u
+        (i64.const 0)
+        (i32.const 0)
+        (i32.const 0)))
+    (drop
+      (i32.atomic.rmw16.cmpxchg_u
+        (i64.const 0)
+        (i32.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.atomic.rmw8.cmpxchg_u
+        (i64.const 0)
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i64.atomic.rmw16.cmpxchg_u
+        (i64.const 0)
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i64.atomic.rmw32.cmpxchg_u
+        (i64.const 0)
+        (i64.const 0)
+        (i64.const 0))))
+  (memory (;0;) i64 1 1 shared))
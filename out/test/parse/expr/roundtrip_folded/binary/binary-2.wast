@@ -0,0 +1,179 @@
+(module
+  (type (;0;) (func))
+  (func (;0;) (type 0)
+    (drop
+      (i32.add
+        (i32.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.add
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (f32.add
+        (f32.const 0x0p+0 (;=0;))
+        (f32.const 0x0p+0 (;=0;))))
+    (drop
+      (f64.add
+        (f64.const 0x0p+0 (;=0;))
+        (f64.const 0x0p+0 (;=0;))))
+    (drop
+      (i32.sub
+        (i32.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.sub
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (f32.sub
+        (f32.const 0x0p+0 (;=0;))
+        (f32.const 0x0p+0 (;=0;))))
+    (drop
+      (f64.sub
+        (f64.const 0x0p+0 (;=0;))
+        (f64.const 0x0p+0 (;=0;))))
+    (drop
+      (i32.mul
+        (i32.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.mul
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (f32.mul
+        (f32.const 0x0p+0 (;=0;))
+        (f32.const 0x0p+0 (;=0;))))
+    (drop
+      (f64.mul
+        (f64.const 0x0p+0 (;=0;))
+        (f64.const 0x0p+0 (;=0;))))
+    (drop
+      (i32.div_s
+        (i32.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.div_s
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i32.div_u
+        (i32.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.div_u
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (f32.div
+        (f32.const 0x0p+0 (;=0;))
+        (f32.const 0x0p+0 (;=0;))))
+    (drop
+      (f64.div
+        (f64.const 0x0p+0 (;=0;))
+        (f64.const 0x0p+0 (;=0;))))
+    (drop
+      (i32.rem_s
+        (i32.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.rem_s
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i32.rem_u
+        (i32.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.rem_u
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (f32.min
+        (f32.const 0x0p+0 (;=0;))
+        (f32.const 0x0p+0 (;=0;))))
+    (drop
+      (f64.min
+        (f64.const 0x0p+0 (;=0;))
+        (f64.const 0x0p+0 (;=0;))))
+    (drop
+      (f32.max
+        (f32.const 0x0p+0 (;=0;))
+        (f32.const 0x0p+0 (;=0;))))
+    (drop
+      (f64.max
+        (f64.const 0x0p+0 (;=0;))
+        (f64.const 0x0p+0 (;=0;))))
+    (drop
+      (i32.and
+        (i32.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.and
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i32.or
+        (i32.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.or
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i32.xor
+        (i32.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.xor
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i32.shl
+        (i32.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.shl
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i32.shr_u
+        (i32.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.shr_u
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i32.shr_s
+        (i32.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.shr_s
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i32.rotl
+        (i32.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.rotl
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (i32.rotr
+        (i32.const 0)
+        (i32.const 0)))
+    (drop
+      (i64.rotr
+        (i64.const 0)
+        (i64.const 0)))
+    (drop
+      (f32.copysign
+        (f32.const 0x0p+0 (;=0;))
+        (f32.const 0x0p+0 (;=0;))))
+    (drop
+      (f64.copysign
+        (f64.const 0x0p+0 (;=0;))
+        (f64.const 0x0p+0 (;=0;))))))
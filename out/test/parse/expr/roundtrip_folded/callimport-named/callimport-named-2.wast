@@ -0,0 +1,7 @@
+(module
+  (type (;0;) (func (param f32)))
+  (type (;1;) (func))
+  (import "foo" "bar" (func (;0;) (type 0)))
+  (func (;1;) (type 1)
+    (call 0
+      (f32.const 0x0p+0 (;=0;)))))
@@ -0,0 +1,15 @@
+(module
+  (type (;0;) (func))
+  (func (;0;) (type 0)
+    (drop
+      (f32.reinterpret_i32
+        (i32.const 0)))
+    (drop
+      (i32.reinterpret_f32
+        (f32.const 0x0p+0 (;=0;))))
+    (drop
+      (f64.reinterpret_i64
+        (i64.const 0)))
+    (drop
+      (i64.reinterpret_f64
+        (f64.const 0x0p+0 (;=0;))))))
@@ -0,0 +1,87 @@
+(module
+  (type (;0;) (func))
+  (func (;0;) (type 0)
+    (drop
+      (i32.const 0))
+    (drop
+      (i32.const -2147483648))
+    (drop
+      (i32.const -1))
+    (drop
+      (i32.const -2147483648))
+    (drop
+      (i32.const -1))
+    (drop
+      (i64.const 0))
+    (drop
+      (i64.const -9223372036854775808))
+    (drop
+      (i64.const -1))
+    (drop
+      (i64.const -9223372036854775808))
+    (drop
+      (i64.const -1))
+    (drop
+      (f32.const 0x0p+0 (;=0;)))
+    (drop
+      (f32.const 0x1.c6bf52p+49 (;=1e+15;)))
+    (drop
+      (f32.const 0x1.52d02cp+76 (;=1e+23;)))
+    (drop
+      (f32.const 0x1.9e40c2p-17 (;=1.23457e-05;)))
+    (drop
+      (f32.const nan (;=nan;)))
+    (drop
+      (f32.const -nan (;=-nan;)))
+    (drop
+      (f32.const nan (;=nan;)))
+    (drop
+      (f32.const nan:0xabc (;=nan;)))
+    (drop
+      (f32.const -nan:0xabc (;=-nan;)))
+    (drop
+      (f32.const nan:0xabc (;=nan;)))
+    (drop
+      (f32.const inf (;=inf;)))
+    (drop
+      (f32.const -inf (;=-inf;)))
+    (drop
+      (f32.const inf (;=inf;)))
+    (drop
+      (f32.const -0x1p-1 (;=-0.5;)))
+    (drop
+      (f32.const 0x1.921fb6p+2 (;=6.28319;)))
+    (drop
+      (f64.const 0x0p+0 (;=0;)))
+    (drop
+      (f64.const 0x1.7e43c8800759cp+996 (;=1e+300;)))
+    (drop
+      (f64.const -0x1.f9add3c0e56b8p-1 (;=-0.987654;)))
+    (drop
+      (f64.const 0x1.921fb54442d18p+2 (;=6.28319;)))
+    (drop
+      (f64.const nan (;=nan;)))
+    (drop
+      (f64.const -nan (;=-nan;)))
+    (drop
+      (f64.const nan (;=nan;)))
+    (drop
+      (f64.const nan:0xabc (;=nan;)))
+    (drop
+      (f64.const -nan:0xabc (;=-nan;)))
+    (drop
+      (f64.const nan:0xabc (;=nan;)))
+    (drop
+      (f64.const inf (;=inf;)))
+    (drop
+      (f64.const -inf (;=-inf;)))
+    (drop
+      (f64.const inf (;=inf;)))
+    (drop
+      (f64.const -0x1p-1 (;=-0.5;)))
+    (drop
+      (f64.const 0x1.921fb54442d18p+2 (;=6.28319;)))
+    (drop
+      (v128.const i32x4 0x11223344 0x55667788 0x99aabbcc 0xddeeff00))
+    (drop
+      (v128.const i32x4 0x11223344 0x55667788 0x99aabbcc 0xddeeff00))))
@@ -0,0 +1,66 @@
+(module
+  (type (;0;) (func))
+  (func (;0;) (type 0)
+    (drop
+      (i32.wrap_i64
+        (i64.const 0)))
+    (drop
+      (i64.extend_i32_u
+        (i32.const 0)))
+    (drop
+      (i64.extend_i32_s
+        (i32.const 0)))
+    (drop
+      (i32.trunc_f32_s
+        (f32.const 0x0p+0 (;=0;))))
+    (drop
+      (i32.trunc_f32_u
+        (f32.const 0x0p+0 (;=0;))))
+    (drop
+      (i32.trunc_f64_s
+        (f64.const 0x0p+0 (;=0;))))
+    (drop
+      (i32.trunc_f64_u
+        (f64.const 0x0p+0 (;=0;))))
+    (drop
+      (i64.trunc_f32_s
+        (f32.const 0x0p+0 (;=0;))))
+    (drop
+      (i64.trunc_f32_u
+        (f32.const 0x0p+0 (;=0;))))
+    (drop
+      (i64.trunc_f64_s
+        (f64.const 0x0p+0 (;=0;))))
+    (drop
+      (i64.trunc_f64_u
+        (f64.const 0x0p+0 (;=0;))))
+    (drop
+      (f32.convert_i32_s
+        (i32.const 0)))
+    (drop
+      (f32.convert_i32_u
+        (i32.const 0)))
+    (drop
+      (f32.convert_i64_s
+        (i64.const 0)))
+    (drop
+      (f32.convert_i64_u
+        (i64.const 0)))
+    (drop
+      (f64.convert_i32_s
+        (i32.const 0)))
+    (drop
+      (f64.convert_i32_u
+        (i32.const 0)))
+    (drop
+      (f64.convert_i64_s
+        (i64.const 0)))
+    (drop
+      (f64.convert_i64_u
+        (i64.const 0)))
+    (drop
+      (f32.demote_f64
+        (f64.const 0x0p+0 (;=0;))))
+    (drop
+      (f64.promote_f32
+        (f32.const 0x0p+0 (;=0;))))))
@@ -0,0 +1,46 @@
+(module
+  (type (;0;) (func))
+  (func (;0;) (type 0)
+    (drop
+      (i32.load
+        (i32.const 0)))
+    (drop
+      (i32.load8_s
+        (i32.const 0)))
+    (drop
+      (i32.load16_s
+        (i32.const 0)))
+    (drop
+      (i32.load8_u
+        (i32.const 0)))
+    (drop
+      (i32.load16_u
+        (i32.const 0)))
+    (drop
+      (i64.load
+        (i32.const 0)))
+    (drop
+      (i64.load8_s
+        (i32.const 0)))
+    (drop
+      (i64.load16_s
+        (i32.const 0)))
+    (drop
+      (i64.load32_s
+        (i32.const 0)))
+    (drop
+      (i64.load8_u
+        (i32.const 0)))
+    (drop
+      (i64.load16_u
+        (i32.const 0)))
+    (drop
+      (i64.load32_u
+        (i32.const 0)))
+    (drop
+      (f32.load
+        (i32.const 0)))
+    (drop
+      (f64.load
+        (i32.const 0))))
+  (memory (;0;) 1))
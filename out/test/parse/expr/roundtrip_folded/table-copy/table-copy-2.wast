@@ -0,0 +1,9 @@
+(module
+  (type (;0;) (func))
+  (func (;0;) (type 0)
+    (table.copy
+      (i32.const 0)
+      (i32.const 0)
+      (i32.const 0)))
+  (table (;0;) 0 funcref)
+  (memory (;0;) 0))
@@ -0,0 +1,6 @@
+(module
+  (type (;0;) (func (result externref)))
+  (func (;0;) (type 0) (result externref)
+    (table.get 0
+      (i32.const 0)))
+  (table (;0;) 1 externref))
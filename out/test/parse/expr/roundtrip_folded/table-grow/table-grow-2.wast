@@ -0,0 +1,7 @@
+(module
+  (type (;0;) (func (result i32)))
+  (func (;0;) (type 0) (result i32)
+    (table.grow 0
+      (ref.null extern)
+      (i32.const 0)))
+  (table (;0;) 1 externref))
@@ -0,0 +1,3 @@
+(module
+  (type (;0;) (func))
+  (func (;0;) (type 0)))
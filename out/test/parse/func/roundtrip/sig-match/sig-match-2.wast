@@ -0,0 +1,14 @@
+(module
+  (type (;0;) (func))
+  (type (;1;) (func (param i32)))
+  (type (;2;) (func (param f32) (result i32)))
+  (type (;3;) (func (param i32 i32) (result i32)))
+  (type (;4;) (func (result f32)))
+  (func (;0;) (type 0))
+  (func (;1;) (type 1) (param i32))
+  (func (;2;) (type 2) (param f32) (result i32)
+    i32.const 0)
+  (func (;3;) (type 3) (param i32 i32) (result i32)
+    i32.const 0)
+  (func (;4;) (type 4) (result f32)
+    f32.const 0x0p+0 (;=0;)))
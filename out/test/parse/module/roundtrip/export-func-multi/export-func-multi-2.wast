@@ -0,0 +1,6 @@
+(module
+  (type (;0;) (func))
+  (func (;0;) (type 0)
+    nop)
+  (export "a" (func 0))
+  (export "b" (func 0)))
@@ -0,0 +1,4 @@
+(module
+  (global (;0;) i32 (i32.const 0))
+  (global (;1;) (mut f32) (f32.const 0x0p+0 (;=0;)))
+  (export "global0" (global 0)))
@@ -0,0 +1,3 @@
+(module
+  (type (;0;) (func (param i32 i64 f32 f64) (result i32)))
+  (import "foo" "bar" (func (;0;) (type 0))))
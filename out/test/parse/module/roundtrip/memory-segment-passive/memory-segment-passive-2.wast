@@ -0,0 +1,3 @@
+(module
+  (memory (;0;) 1)
+  (data (;0;) "hi"))
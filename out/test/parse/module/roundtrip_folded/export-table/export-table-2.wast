@@ -0,0 +1,3 @@
+(module
+  (table (;0;) 0 funcref)
+  (export "my_table" (table 0)))
@@ -0,0 +1,3 @@
+(module
+  (type (;0;) (func))
+  (import "foo" "bar" (func (;0;) (type 0))))
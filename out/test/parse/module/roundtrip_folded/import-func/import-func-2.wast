@@ -0,0 +1,13 @@
+(module
+  (type (;0;) (func (param i32) (result i64)))
+  (type (;1;) (func (param i32)))
+  (type (;2;) (func (param i32 i32) (result i32)))
+  (type (;3;) (func (param f32) (result f32)))
+  (type (;4;) (func (param f64) (result f64)))
+  (type (;5;) (func (param i64) (result i64)))
+  (import "foo" "bar" (func (;0;) (type 0)))
+  (import "stdio" "print" (func (;1;) (type 1)))
+  (import "math" "add" (func (;2;) (type 2)))
+  (import "test" "f32" (func (;3;) (type 3)))
+  (import "test" "f64" (func (;4;) (type 4)))
+  (import "test" "i64" (func (;5;) (type 5))))
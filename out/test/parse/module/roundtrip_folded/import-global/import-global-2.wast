@@ -0,0 +1,5 @@
+(module
+  (import "foo" "1" (global (;0;) i32))
+  (import "foo" "2" (global (;1;) i64))
+  (import "foo" "3" (global (;2;) f32))
+  (import "foo" "4" (global (;3;) f64)))
@@ -0,0 +1,3 @@
+(module
+  (type (;0;) (func (param f64 f32)))
+  (import "foo" "1" (tag (;0;) (type 0) (param f64 f32))))
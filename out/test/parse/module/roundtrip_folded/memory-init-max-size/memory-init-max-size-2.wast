@@ -0,0 +1,2 @@
+(module
+  (memory (;0;) 1 2))
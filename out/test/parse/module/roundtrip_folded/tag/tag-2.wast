@@ -0,0 +1,9 @@
+(module
+  (type (;0;) (func (param f64)))
+  (type (;1;) (func))
+  (type (;2;) (func (param i32)))
+  (type (;3;) (func (param f32 f32 f32)))
+  (tag (;0;) (type 1))
+  (tag (;1;) (type 2) (param i32))
+  (tag (;2;) (type 3) (param f32 f32 f32))
+  (tag (;3;) (type 0) (param f64)))
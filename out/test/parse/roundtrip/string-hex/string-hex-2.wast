@@ -0,0 +1,4 @@
+(module
+  (type (;0;) (func))
+  (func (;0;) (type 0))
+  (export "foo\de\ad\ca\bb" (func 0)))
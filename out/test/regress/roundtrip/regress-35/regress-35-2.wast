@@ -0,0 +1,17 @@
+(module
+  (type (;0;) (func (param i32 i32) (result i32)))
+  (type (;1;) (func))
+  (func (;0;) (type 0) (param i32 i32) (result i32)
+    local.get 0
+    local.get 1
+    i32.add
+    return)
+  (func (;1;) (type 1)
+    i32.const 4444
+    i32.const 5555
+    i32.const 0
+    call_indirect (type 0)
+    drop)
+  (table (;0;) 1 funcref)
+  (export "run" (func 1))
+  (elem (;0;) (i32.const 0) func 0))
@@ -0,0 +1,10 @@
+(module $m1
+  (type (;0;) (func))
+  (type (;1;) (func (param i32 i64)))
+  (func $f1 (type 0))
+  (func $f2 (type 1) (param $p1 i32) (param $p2 i64)
+    (local $l1 f32) (local $l2 f64))
+  (table $bar_table 0 funcref)
+  (memory $foo_memory 1)
+  (elem $foo_elem_seg (i32.const 0) func $f1 $f2)
+  (data $baz_data_seg (i32.const 1024) "hello world"))
@@ -0,0 +1,346 @@
+/* Automically generated by wasm2c */
+#include "out/test/wasm2c/cache-dir/out_impl.h"
+
+static void init_func_types(wasm2c_sandbox_t* const sbx) {
+  sbx->func_types[0] = 0x94000000u;
+}
+
+#if defined(ENTRY_PROLOGUE) || defined(ENTRY_EPILOGUE)
+FUNC_EXPORT u32 w2centry_w2c_f0(wasm2c_sandbox_t* const sbx, u32 p0) {
+  ENTRY_PROLOGUE;
+  u32 ret = w2c_f0(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT u32 w2centry_w2c_alpha(wasm2c_sandbox_t* const sbx, u32 p0) {
+  ENTRY_PROLOGUE;
+  u32 ret = w2c_alpha(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT u32 w2centry_w2c_beta(wasm2c_sandbox_t* const sbx, u32 p0) {
+  ENTRY_PROLOGUE;
+  u32 ret = w2c_beta(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT u32 w2centry_w2c_gamma(wasm2c_sandbox_t* const sbx, u32 p0) {
+  ENTRY_PROLOGUE;
+  u32 ret = w2c_gamma(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT u32 w2centry_w2c_delta(wasm2c_sandbox_t* const sbx, u32 p0) {
+  ENTRY_PROLOGUE;
+  u32 ret = w2c_delta(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT u32 w2centry_w2c_epsilon(wasm2c_sandbox_t* const sbx, u32 p0) {
+  ENTRY_PROLOGUE;
+  u32 ret = w2c_epsilon(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT u32 w2centry_w2c_zeta(wasm2c_sandbox_t* const sbx, u32 p0) {
+  ENTRY_PROLOGUE;
+  u32 ret = w2c_zeta(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+#endif
+
+static void init_globals(wasm2c_sandbox_t* const sbx) {
+  (void)sbx;
+}
+
+
+static bool init_memory(wasm2c_sandbox_t* const sbx, uint32_t max_wasm_pages_from_rt) {
+  const uint32_t max_pages_specified_in_module = 0;
+  const uint32_t max_pages = max_wasm_pages_from_rt == 0? max_pages_specified_in_module : max_wasm_pages_from_rt;
+  const bool success = wasm_rt_allocate_memory(&(sbx->w2c_M0), 1, max_pages);
+  if (!success) { return false; }
+  WASM2C_SHADOW_MEMORY_INIT_SAMPLE_RATE(&(sbx->w2c_M0));
+  
+  sbx->wasi_data.heap_memory = &(sbx->w2c_M0);
+  return true;
+}
+
+static bool init_thread_memory(wasm2c_sandbox_t* const sbx, wasm2c_sandbox_t* const parent) {
+  (void)sbx;
+  (void)parent;
+  return false;
+}
+
+static void cleanup_memory(wasm2c_sandbox_t* const sbx) {
+  wasm_rt_deallocate_memory(&(sbx->w2c_M0));
+}
+
+static void init_table(wasm2c_sandbox_t* const sbx) {
+  uint32_t offset = 0;
+  wasm_rt_allocate_table(&(sbx->w2c_T0), 0, 4294967295);
+  sbx->w2c_T0_current_index = offset + 0;
+}
+
+static void cleanup_table(wasm2c_sandbox_t* const sbx) {
+  wasm_rt_deallocate_table(&(sbx->w2c_T0));
+}
+
+typedef struct {
+  const char* name;
+  /* The function, with the index of its type, or 0 for other exports. */
+  wasm_rt_anyfunc_t func;
+  u32 func_type;
+  /* The offset of other exports in the sandbox. */
+  u32 offset;
+  /* Whether the sandbox holds a pointer to the export instead. */
+  u32 is_pointer;
+} wasm2c_export_t;
+
+static const u32 wasm2c_export_seeds[4] = {
+  25, 5, 11, 0,
+};
+
+static const wasm2c_export_t wasm2c_exports[9] = {
+  { "w2c_gamma", (wasm_rt_anyfunc_t)&w2c_gamma, 0, 0, 0 },
+  { "w2c_epsilon", (wasm_rt_anyfunc_t)&w2c_epsilon, 0, 0, 0 },
+  { "w2c_T0", 0, 0, offsetof(wasm2c_sandbox_t, w2c_T0), 0 },
+  { "w2c_f0", (wasm_rt_anyfunc_t)&w2c_f0, 0, 0, 0 },
+  { "w2c_zeta", (wasm_rt_anyfunc_t)&w2c_zeta, 0, 0, 0 },
+  { "w2c_beta", (wasm_rt_anyfunc_t)&w2c_beta, 0, 0, 0 },
+  { "w2c_M0", 0, 0, offsetof(wasm2c_sandbox_t, w2c_M0), 0 },
+  { "w2c_delta", (wasm_rt_anyfunc_t)&w2c_delta, 0, 0, 0 },
+  { "w2c_alpha", (wasm_rt_anyfunc_t)&w2c_alpha, 0, 0, 0 },
+};
+
+static u32 hash_wasm2c_export_name(const char* name, u32 seed) {
+  u32 hash = (2166136261u ^ seed) * 16777619u;
+  for (; *name; name++) {
+    hash = (hash ^ (u8)*name) * 16777619u;
+  }
+  hash = (hash ^ (hash >> 16)) * 0x85ebca6bu;
+  hash = (hash ^ (hash >> 13)) * 0xc2b2ae35u;
+  return hash ^ (hash >> 16);
+}
+
+static const wasm2c_export_t* find_wasm2c_export(const char* name) {
+  u32 seed = wasm2c_export_seeds[hash_wasm2c_export_name(name, 0) % 4];
+  const wasm2c_export_t* entry = &wasm2c_exports[hash_wasm2c_export_name(name, seed) % 9];
+  return entry->name && strcmp(entry->name, name) == 0 ? entry : 0;
+}
+
+static void* lookup_wasm2c_nonfunc_export(void* sbx_ptr, const char* name) {
+  const wasm2c_export_t* entry = find_wasm2c_export(name);
+  if (!entry || entry->func) {
+    return 0;
+  }
+  void* field = (char*) sbx_ptr + entry->offset;
+  return entry->is_pointer ? *(void**) field : field;
+}
+
+static wasm_rt_anyfunc_t lookup_wasm2c_func_export(void* sbx_ptr, const char* name, u32* func_type) {
+  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) sbx_ptr;
+  const wasm2c_export_t* entry = find_wasm2c_export(name);
+  if (!entry || !entry->func) {
+    return 0;
+  }
+  if (func_type) {
+    *func_type = sbx->func_types[entry->func_type];
+  }
+  return entry->func;
+}
+
+static wasm_rt_table_t* get_wasm2c_callback_table(void* sbx_ptr){
+  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) sbx_ptr;
+  return &(sbx->w2c_T0);
+}
+
+static wasm_rt_memory_t* get_wasm2c_memory(wasm2c_sandbox_t* const sbx){
+  return &(sbx->w2c_M0);
+}
+
+static void init_profile(wasm2c_sandbox_t* const sbx) {
+  (void)sbx;
+}
+
+static void cleanup_profile(wasm2c_sandbox_t* const sbx) {
+  (void)sbx;
+}
+
+static wasm_rt_profile_t* get_wasm2c_profile(wasm2c_sandbox_t* const sbx) {
+  (void)sbx;
+  return 0;
+}
+
+static void init_module_starts(wasm2c_sandbox_t* const sbx) {
+  (void)sbx;
+}
+//test
+
+static u32 add_wasm2c_callback(void* sbx_ptr, u32 func_type_idx, void* func_ptr, wasm_rt_elem_target_class_t func_class) {
+  wasm_rt_table_t* table = get_wasm2c_callback_table(sbx_ptr);
+  u32 i = wasm_rt_table_alloc_slot(table);
+  table->data[i] = (wasm_rt_elem_t){ func_class, func_type_idx, (wasm_rt_anyfunc_t) func_ptr };
+  return i;
+}
+
+static void remove_wasm2c_callback(void* sbx_ptr, u32 callback_idx) {
+  wasm_rt_table_t* table = get_wasm2c_callback_table(sbx_ptr);
+  wasm_rt_table_free_slot(table, callback_idx);
+}
+
+static u32 lookup_wasm2c_func_index(void* sbx_ptr, u32 param_count, u32 result_count, wasm_rt_type_t* types) {
+  // Function type indices are shared by all sandboxes.
+  (void) sbx_ptr;
+  return wasm_rt_register_func_type(param_count, result_count, types);
+}
+
+static void* create_wasm2c_sandbox(uint32_t max_wasm_pages) {
+  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) calloc(sizeof(wasm2c_sandbox_t), 1);
+  if (!init_memory(sbx, max_wasm_pages)) {
+    free(sbx);
+    return 0;
+  }
+  init_func_types(sbx);
+  init_globals(sbx);
+  init_table(sbx);
+  init_profile(sbx);
+  wasm_rt_init_wasi(&(sbx->wasi_data));
+  init_module_starts(sbx);
+  return sbx;
+}
+
+// Creates another instance of the module for a new thread. It has its own
+// globals and table, but shares the (shared) linear memory of `parent_ptr`,
+// which must stay alive until every thread sandbox created from it has been
+// destroyed. Returns 0 if the module has no shared memory, or if out of memory.
+static void* create_wasm2c_sandbox_thread(void* parent_ptr) {
+  wasm2c_sandbox_t* const parent = (wasm2c_sandbox_t* const) parent_ptr;
+  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) calloc(sizeof(wasm2c_sandbox_t), 1);
+  if (!sbx) {
+    return 0;
+  }
+  if (!init_thread_memory(sbx, parent)) {
+    free(sbx);
+    return 0;
+  }
+  init_func_types(sbx);
+  init_globals(sbx);
+  init_table(sbx);
+  init_profile(sbx);
+  wasm_rt_init_wasi(&(sbx->wasi_data));
+  return sbx;
+}
+
+static void destroy_wasm2c_sandbox(void* aSbx) {
+  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) aSbx;
+  cleanup_memory(sbx);
+  cleanup_table(sbx);
+  cleanup_profile(sbx);
+  wasm_rt_cleanup_wasi(&(sbx->wasi_data));
+  free(sbx);
+}
+
+// A copy of the linear memory, globals and table of an initialized sandbox.
+// The copy of the sandbox struct holds the globals, the table's size and the
+// function type indices; everything it points to is copied separately.
+typedef struct wasm2c_sandbox_snapshot_t {
+  wasm2c_sandbox_t sbx;
+  wasm_rt_memory_image_t memory_image;
+  wasm_rt_elem_t* table_data;
+} wasm2c_sandbox_snapshot_t;
+
+// Returns 0 if the module's memory is shared, or if memory images are not
+// supported.
+static void* create_wasm2c_sandbox_snapshot(void* sbx_ptr) {
+  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) sbx_ptr;
+  wasm_rt_memory_t* memory = get_wasm2c_memory(sbx);
+  if (!memory || memory->is_shared) {
+    return 0;
+  }
+  wasm2c_sandbox_snapshot_t* const snapshot = (wasm2c_sandbox_snapshot_t*) calloc(sizeof(wasm2c_sandbox_snapshot_t), 1);
+  if (!snapshot) {
+    return 0;
+  }
+  if (!wasm_rt_create_memory_image(&snapshot->memory_image, memory)) {
+    free(snapshot);
+    return 0;
+  }
+  memcpy(&snapshot->sbx, sbx, sizeof(wasm2c_sandbox_t));
+  wasm_rt_table_t* table = get_wasm2c_callback_table(sbx);
+  snapshot->table_data = (wasm_rt_elem_t*) malloc((table->size ? table->size : 1) * sizeof(wasm_rt_elem_t));
+  if (!snapshot->table_data) {
+    wasm_rt_free_memory_image(&snapshot->memory_image);
+    free(snapshot);
+    return 0;
+  }
+  memcpy(snapshot->table_data, table->data, table->size * sizeof(wasm_rt_elem_t));
+  return snapshot;
+}
+
+// Creates a sandbox in the state the snapshot was taken in, without running
+// any of the module's initialization. Its memory is mapped copy-on-write from
+// the snapshot. The WASI state and the profile are not part of the snapshot,
+// and start out fresh as in create_wasm2c_sandbox.
+static void* create_wasm2c_sandbox_from_snapshot(void* snapshot_ptr, uint32_t max_wasm_pages) {
+  wasm2c_sandbox_snapshot_t* const snapshot = (wasm2c_sandbox_snapshot_t* const) snapshot_ptr;
+  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) malloc(sizeof(wasm2c_sandbox_t));
+  if (!sbx) {
+    return 0;
+  }
+  memcpy(sbx, &snapshot->sbx, sizeof(wasm2c_sandbox_t));
+  wasm_rt_memory_t* memory = get_wasm2c_memory(sbx);
+  const uint32_t max_pages = max_wasm_pages == 0 ? memory->max_pages : max_wasm_pages;
+  if (!wasm_rt_allocate_memory_from_image(memory, &snapshot->memory_image, max_pages)) {
+    free(sbx);
+    return 0;
+  }
+  WASM2C_SHADOW_MEMORY_INIT_SAMPLE_RATE(memory);
+  wasm_rt_table_t* table = get_wasm2c_callback_table(sbx);
+  wasm_rt_allocate_table(table, table->size, table->max_size);
+  memcpy(table->data, snapshot->table_data, table->size * sizeof(wasm_rt_elem_t));
+  init_profile(sbx);
+  memset(&(sbx->wasi_data), 0, sizeof(sbx->wasi_data));
+  sbx->wasi_data.heap_memory = memory;
+  wasm_rt_init_wasi(&(sbx->wasi_data));
+  return sbx;
+}
+
+static void destroy_wasm2c_sandbox_snapshot(void* snapshot_ptr) {
+  wasm2c_sandbox_snapshot_t* const snapshot = (wasm2c_sandbox_snapshot_t* const) snapshot_ptr;
+  wasm_rt_free_memory_image(&snapshot->memory_image);
+  free(snapshot->table_data);
+  free(snapshot);
+}
+
+// Returns false if the module was compiled without --instrument, or without
+// --instrument=cycles for the folded format.
+static bool dump_wasm2c_profile(void* sbx_ptr, FILE* out, wasm_rt_profile_format_t format) {
+  wasm_rt_profile_t* profile = get_wasm2c_profile((wasm2c_sandbox_t*) sbx_ptr);
+  return profile && wasm_rt_profile_dump(profile, out, format);
+}
+
+FUNC_EXPORT wasm2c_sandbox_funcs_t WASM_CURR_ADD_PREFIX(get_wasm2c_sandbox_info)() {
+  wasm2c_sandbox_funcs_t ret;
+  ret.wasm_rt_sys_init = &wasm_rt_sys_init;
+  ret.create_wasm2c_sandbox = &create_wasm2c_sandbox;
+  ret.destroy_wasm2c_sandbox = &destroy_wasm2c_sandbox;
+  ret.lookup_wasm2c_nonfunc_export = &lookup_wasm2c_nonfunc_export;
+  ret.lookup_wasm2c_func_index = &lookup_wasm2c_func_index;
+  ret.add_wasm2c_callback = &add_wasm2c_callback;
+  ret.remove_wasm2c_callback = &remove_wasm2c_callback;
+  ret.create_wasm2c_sandbox_thread = &create_wasm2c_sandbox_thread;
+  ret.create_wasm2c_sandbox_snapshot = &create_wasm2c_sandbox_snapshot;
+  ret.create_wasm2c_sandbox_from_snapshot = &create_wasm2c_sandbox_from_snapshot;
+  ret.destroy_wasm2c_sandbox_snapshot = &destroy_wasm2c_sandbox_snapshot;
+  ret.lookup_wasm2c_func_export = &lookup_wasm2c_func_export;
+  ret.dump_wasm2c_profile = &dump_wasm2c_profile;
+  return ret;
+}
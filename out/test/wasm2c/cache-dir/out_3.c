@@ -0,0 +1,22 @@
+/* Automically generated by wasm2c */
+#include "out/test/wasm2c/cache-dir/out_impl.h"
+
+FUNC_EXPORT u32 w2c_f0(wasm2c_sandbox_t* const sbx, u32 w2c_p0) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0, w2c_i1;
+  w2c_i0 = w2c_p0;
+  w2c_i1 = 1u;
+  w2c_i0 -= w2c_i1;
+  FUNC_EPILOGUE;
+  return w2c_i0;
+}
+
+FUNC_EXPORT u32 w2c_alpha(wasm2c_sandbox_t* const sbx, u32 w2c_p0) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0, w2c_i1;
+  w2c_i0 = w2c_p0;
+  w2c_i1 = 1u;
+  w2c_i0 += w2c_i1;
+  FUNC_EPILOGUE;
+  return w2c_i0;
+}
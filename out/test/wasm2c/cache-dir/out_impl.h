@@ -0,0 +1,576 @@
+#ifndef OUT_TEST_WASM2C_CACHE_DIR_OUT_IMPL_H_GENERATED_
+#define OUT_TEST_WASM2C_CACHE_DIR_OUT_IMPL_H_GENERATED_
+
+/* Automically generated by wasm2c */
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "out/test/wasm2c/cache-dir/out.h"
+#if defined(_MSC_VER)
+#  define UNLIKELY(x) (x)
+#  define LIKELY(x) (x)
+#else
+#  define UNLIKELY(x) __builtin_expect(!!(x), 0)
+#  define LIKELY(x) __builtin_expect(!!(x), 1)
+#endif
+
+#define TRAP(x) (wasm_rt_trap(WASM_RT_TRAP_##x), 0)
+
+// Large data segments are page aligned, so they can be mapped directly.
+#if defined(_MSC_VER)
+#  define DATA_SEGMENT_ALIGN __declspec(align(4096))
+#else
+#  define DATA_SEGMENT_ALIGN __attribute__((aligned(4096)))
+#endif
+
+// Functions that would be static in a single output file, but are shared
+// between the shards when wasm2c splits its output across several files.
+#if defined(_WIN32)
+#  define FUNC_INTERNAL
+#else
+#  define FUNC_INTERNAL __attribute__((visibility("hidden")))
+#endif
+
+// Functions that the profile given to wasm2c with --profile-use found hot, or
+// never saw called. GCC also moves them to .text.hot and .text.unlikely, which
+// keeps the hot code together.
+#if defined(__has_attribute)
+#  if __has_attribute(hot) && __has_attribute(cold)
+#    define FUNC_HOT __attribute__((hot))
+#    define FUNC_COLD __attribute__((cold))
+#  endif
+#endif
+#ifndef FUNC_HOT
+#  define FUNC_HOT
+#  define FUNC_COLD
+#endif
+
+// Counts whether the condition `c` of an if or br_if holds, with
+// --instrument=branches.
+#define PROFILE_BRANCH(sbx, site, c) \
+  profile_branch(&(sbx)->profile, site, c)
+
+static inline u32 profile_branch(wasm_rt_profile_t* profile, u32 site, u32 c) {
+  ++profile->branches[2 * site + (c != 0)];
+  return c;
+}
+
+// Tail calls skip the FUNC_EPILOGUE of the caller, and the
+// EXTERNAL_CALLBACK_EPILOGUE of callbacks, so they are only made with musttail
+// when the embedder doesn't define those.
+#if !defined(WASM_RT_MUSTTAIL) && !defined(FUNC_EPILOGUE) && \
+    !defined(EXTERNAL_CALLBACK_EPILOGUE) && defined(__has_attribute)
+#  if __has_attribute(musttail)
+#    define WASM_RT_MUSTTAIL __attribute__((musttail))
+#  endif
+#endif
+
+#ifndef FUNC_PROLOGUE
+#define FUNC_PROLOGUE
+#endif
+
+#ifndef FUNC_EPILOGUE
+#define FUNC_EPILOGUE
+#endif
+
+#ifdef EXTERNAL_CALLBACK_PROLOGUE
+#define EXTERNAL_CALLBACK_PROLOGUE_EXEC(table, x)                        \
+  if (UNLIKELY(table.data[x].func_class == WASM_RT_EXTERNAL_FUNCTION)) { \
+    EXTERNAL_CALLBACK_PROLOGUE;                                          \
+  }
+#else
+#define EXTERNAL_CALLBACK_PROLOGUE_EXEC(table, x)
+#endif
+
+#ifdef EXTERNAL_CALLBACK_EPILOGUE
+#define EXTERNAL_CALLBACK_EPILOGUE_EXEC(table, x)                        \
+  if (UNLIKELY(table.data[x].func_class == WASM_RT_EXTERNAL_FUNCTION)) { \
+    EXTERNAL_CALLBACK_EPILOGUE;                                          \
+  }
+#else
+#define EXTERNAL_CALLBACK_EPILOGUE_EXEC(table, x)
+#endif
+
+#define UNREACHABLE (void) TRAP(UNREACHABLE)
+
+// Empty table elements have function type 0, which no function type has, so
+// the type check also rejects them. `type_id` is usually a constant.
+#define CALL_INDIRECT_VOID(table, t, type_id, x, ...)                     \
+  if (LIKELY((x) < table.size && table.data[x].func_type == (type_id))) { \
+    EXTERNAL_CALLBACK_PROLOGUE_EXEC(table, x);                            \
+    ((t)table.data[x].func)(__VA_ARGS__);                                 \
+    EXTERNAL_CALLBACK_EPILOGUE_EXEC(table, x);                            \
+  } else {                                                                \
+    wasm_rt_callback_error_trap(&table, x, type_id);                      \
+  }
+
+#define CALL_INDIRECT_RES(res, table, t, type_id, x, ...)                 \
+  if (LIKELY((x) < table.size && table.data[x].func_type == (type_id))) { \
+    EXTERNAL_CALLBACK_PROLOGUE_EXEC(table, x);                            \
+    res = ((t)table.data[x].func)(__VA_ARGS__);                           \
+    EXTERNAL_CALLBACK_EPILOGUE_EXEC(table, x);                            \
+  } else {                                                                \
+    wasm_rt_callback_error_trap(&table, x, type_id);                      \
+  }
+
+#if defined(WASM2C_MALLOC_FAIL_CALLBACK)
+void WASM2C_MALLOC_FAIL_CALLBACK(u32 ptr_size);
+# define WASM2C_MALLOC_FAIL_CHECK(ptr, ptr_size)  \
+  if (!ptr) {                                     \
+    WASM2C_MALLOC_FAIL_CALLBACK(ptr_size);        \
+  }
+#else
+# define WASM2C_MALLOC_FAIL_CHECK(ptr, ptr_size)
+#endif
+
+#if defined(WASM_CHECK_SHADOW_MEMORY)
+#  if defined(WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE)
+#    if defined(WASM_CHECK_SHADOW_MEMORY_UNINIT_READ)
+#      error "WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE can't be used with WASM_CHECK_SHADOW_MEMORY_UNINIT_READ"
+#    endif
+// Only check about one in WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE loads and
+// stores, plus every access from the functions given to wasm2c with
+// --shadow-check-function. Allocations and frees are always tracked. Each
+// thread counts down to its next checked access, and the runtime picks the
+// length of every countdown at random so the checks don't line up with loops.
+// The rate is stored in the memory when it is allocated, so the runtime
+// doesn't need to be built with the same WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE.
+static WASM_RT_THREAD_LOCAL u32 wasm2c_shadow_sample_countdown = 1;
+#    define WASM2C_SHADOW_MEMORY_SAMPLED(mem, shadow_class)                      \
+  (((shadow_class) & WASM2C_SHADOW_FUNC_ALWAYS_CHECK) ||                       \
+   (UNLIKELY(--wasm2c_shadow_sample_countdown == 0) &&                         \
+    (wasm2c_shadow_sample_countdown = wasm2c_shadow_memory_next_sample(mem), 1)))
+#    define WASM2C_SHADOW_MEMORY_INIT_SAMPLE_RATE(mem)                           \
+  wasm2c_shadow_memory_set_sample_rate(mem, WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE)
+#  else
+#    define WASM2C_SHADOW_MEMORY_SAMPLED(mem, shadow_class) 1
+#    define WASM2C_SHADOW_MEMORY_INIT_SAMPLE_RATE(mem)
+#  endif
+#  define WASM2C_SHADOW_MEMORY_LOAD(mem, shadow_class, func_name, ptr, ptr_size)   \
+  do {                                                                           \
+    if (WASM2C_SHADOW_MEMORY_SAMPLED(mem, shadow_class))                         \
+      wasm2c_shadow_memory_load(mem, shadow_class, func_name, ptr, ptr_size);    \
+  } while (0)
+#  define WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, ptr, ptr_size)  \
+  do {                                                                           \
+    if (WASM2C_SHADOW_MEMORY_SAMPLED(mem, shadow_class))                         \
+      wasm2c_shadow_memory_store(mem, shadow_class, func_name, ptr, ptr_size);   \
+  } while (0)
+#  define WASM2C_SHADOW_MEMORY_RESERVE(mem, ptr, ptr_size)          wasm2c_shadow_memory_reserve(mem, ptr, ptr_size)
+#  define WASM2C_SHADOW_MEMORY_DLMALLOC(mem, ptr, ptr_size)         wasm2c_shadow_memory_dlmalloc(mem, ptr, ptr_size)
+#  define WASM2C_SHADOW_MEMORY_DLFREE(mem, ptr)                     wasm2c_shadow_memory_dlfree(mem, ptr)
+#  define WASM2C_SHADOW_MEMORY_MARK_GLOBALS_HEAP_BOUNDARY(mem, ptr) wasm2c_shadow_memory_mark_globals_heap_boundary(mem, ptr)
+#else
+// Consume the arguments that the load and store helpers only take for shadow
+// memory, so that they don't warn about unused parameters.
+#  define WASM2C_SHADOW_MEMORY_LOAD(mem, shadow_class, func_name, ptr, ptr_size) \
+  ((void)(mem), (void)(shadow_class), (void)(func_name))
+#  define WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, ptr, ptr_size) \
+  ((void)(mem), (void)(shadow_class), (void)(func_name))
+#  define WASM2C_SHADOW_MEMORY_RESERVE(mem, ptr, ptr_size)
+#  define WASM2C_SHADOW_MEMORY_DLMALLOC(mem, ptr, ptr_size)
+#  define WASM2C_SHADOW_MEMORY_DLFREE(mem, ptr)
+#  define WASM2C_SHADOW_MEMORY_MARK_GLOBALS_HEAP_BOUNDARY(mem, ptr)
+#  define WASM2C_SHADOW_MEMORY_INIT_SAMPLE_RATE(mem)
+#endif
+
+// Another thread may grow a shared memory at any time, so its size is read
+// atomically. wasm_rt_grow_memory makes the new pages accessible before it
+// stores the new size.
+#if WASM_RT_SHARED_MEMORY
+#  define MEM_SIZE(mem) __atomic_load_n(&(mem)->size, __ATOMIC_ACQUIRE)
+#  define MEM_PAGES(mem) __atomic_load_n(&(mem)->pages, __ATOMIC_ACQUIRE)
+#else
+#  define MEM_SIZE(mem) ((mem)->size)
+#  define MEM_PAGES(mem) ((mem)->pages)
+#endif
+
+#ifdef WASM_USE_GUARD_PAGES
+#  define MEMCHECK(mem_size, a, t) (void)(mem_size)
+#else
+#  define MEMCHECK(mem_size, a, t) if (UNLIKELY((a) + sizeof(t) > (mem_size))) { (void) TRAP(OOB); }
+#endif
+
+#if defined(WASM_USE_GUARD_PAGES) && UINTPTR_MAX == 0xffffffff
+// on 32-bit platforms we have to mask memory access into range
+#  define MEM_ACCESS_REF(mem, mem_data, addr) &(mem_data)[addr & mem->mem_mask]
+#else
+#  define MEM_ACCESS_REF(mem, mem_data, addr) &(mem_data)[addr]
+#endif
+
+#if defined(WASM_USING_GLOBAL_HEAP)
+#  undef MEM_ACCESS_REF
+#  define MEM_ACCESS_REF(mem, mem_data, addr) (char*) addr
+#endif
+
+// Each load and store has two forms. The plain form reads the base and size of
+// the linear memory through `mem`. The `_cached` form takes them as arguments,
+// so that functions can keep them in locals: the compiler must otherwise
+// assume that any store into linear memory may have modified `mem`, and reload
+// the base pointer on every access.
+//
+// Both forms also have an `_unchecked` variant without the MEMCHECK, which
+// wasm2c uses for the accesses it has proven to be in bounds.
+#if WABT_BIG_ENDIAN
+static inline void load_data(void *dest, const void *src, size_t n) {
+  size_t i = 0;
+  u8 *dest_chars = dest;
+  memcpy(dest, src, n);
+  for (i = 0; i < (n>>1); i++) {
+    u8 cursor = dest_chars[i];
+    dest_chars[i] = dest_chars[n - i - 1];
+    dest_chars[n - i - 1] = cursor;
+  }
+}
+#define LOAD_DATA(m, o, i, s) { load_data(&(m.data[m.size - o - s]), i, s); \
+  WASM2C_SHADOW_MEMORY_RESERVE(&m, m.size - o - s, s);                       \
+  WASM2C_SHADOW_MEMORY_STORE(&m, WASM2C_SHADOW_FUNC_ALWAYS_CHECK,            \
+                             "GlobalDataLoad", m.size - o - s, s);           \
+}
+
+#define DEFINE_LOAD(name, t1, t2, t3)                                                                \
+  static inline t3 name##_unchecked_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size,        \
+                                           u64 addr, u32 shadow_class, const char* func_name) {      \
+    t1 result;                                                                                       \
+    memcpy(&result, MEM_ACCESS_REF(mem, mem_data, mem_size - addr - sizeof(t1)), sizeof(t1));        \
+    WASM2C_SHADOW_MEMORY_LOAD(mem, shadow_class, func_name, mem_size - addr - sizeof(t1),            \
+                              sizeof(t1));                                                           \
+    return (t3)(t2)result;                                                                           \
+  }                                                                                                  \
+  static inline t3 name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,        \
+                                 u32 shadow_class, const char* func_name) {                          \
+    MEMCHECK(mem_size, addr, t1);                                                                    \
+    return name##_unchecked_cached(mem, mem_data, mem_size, addr, shadow_class, func_name);          \
+  }                                                                                                  \
+  static inline t3 name##_unchecked(wasm_rt_memory_t* mem, u64 addr, u32 shadow_class,               \
+                                    const char* func_name) {                                         \
+    return name##_unchecked_cached(mem, mem->data, MEM_SIZE(mem), addr, shadow_class, func_name);     \
+  }                                                                                                  \
+  static inline t3 name(wasm_rt_memory_t* mem, u64 addr, u32 shadow_class, const char* func_name) {  \
+    return name##_cached(mem, mem->data, MEM_SIZE(mem), addr, shadow_class, func_name);               \
+  }
+
+#define DEFINE_STORE(name, t1, t2)                                                                   \
+  static inline void name##_unchecked_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size,      \
+                                             u64 addr, t2 value, u32 shadow_class,                   \
+                                             const char* func_name) {                                \
+    t1 wrapped = (t1)value;                                                                          \
+    memcpy(MEM_ACCESS_REF(mem, mem_data, mem_size - addr - sizeof(t1)), &wrapped, sizeof(t1));       \
+    WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, mem_size - addr - sizeof(t1),           \
+                               sizeof(t1));                                                          \
+  }                                                                                                  \
+  static inline void name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,      \
+                                   t2 value, u32 shadow_class, const char* func_name) {              \
+    MEMCHECK(mem_size, addr, t1);                                                                    \
+    name##_unchecked_cached(mem, mem_data, mem_size, addr, value, shadow_class, func_name);          \
+  }                                                                                                  \
+  static inline void name##_unchecked(wasm_rt_memory_t* mem, u64 addr, t2 value, u32 shadow_class,   \
+                                      const char* func_name) {                                       \
+    name##_unchecked_cached(mem, mem->data, MEM_SIZE(mem), addr, value, shadow_class, func_name);     \
+  }                                                                                                  \
+  static inline void name(wasm_rt_memory_t* mem, u64 addr, t2 value, u32 shadow_class,               \
+                          const char* func_name) {                                                   \
+    name##_cached(mem, mem->data, MEM_SIZE(mem), addr, value, shadow_class, func_name);               \
+  }
+#else
+static inline void load_data(void *dest, const void *src, size_t n) {
+  memcpy(dest, src, n);
+}
+#define LOAD_DATA(m, o, i, s) { load_data(&(m.data[o]), i, s);          \
+  WASM2C_SHADOW_MEMORY_RESERVE(&m, o, s);                                \
+  WASM2C_SHADOW_MEMORY_STORE(&m, WASM2C_SHADOW_FUNC_ALWAYS_CHECK,        \
+                             "GlobalDataLoad", o, s);                    \
+}
+
+#define DEFINE_LOAD(name, t1, t2, t3)                                                                \
+  static inline t3 name##_unchecked_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size,        \
+                                           u64 addr, u32 shadow_class, const char* func_name) {      \
+    t1 result;                                                                                       \
+    (void)mem_size;                                                                                  \
+    memcpy(&result, MEM_ACCESS_REF(mem, mem_data, addr), sizeof(t1));                                \
+    WASM2C_SHADOW_MEMORY_LOAD(mem, shadow_class, func_name, addr, sizeof(t1));                       \
+    return (t3)(t2)result;                                                                           \
+  }                                                                                                  \
+  static inline t3 name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,        \
+                                 u32 shadow_class, const char* func_name) {                          \
+    MEMCHECK(mem_size, addr, t1);                                                                    \
+    return name##_unchecked_cached(mem, mem_data, mem_size, addr, shadow_class, func_name);          \
+  }                                                                                                  \
+  static inline t3 name##_unchecked(wasm_rt_memory_t* mem, u64 addr, u32 shadow_class,               \
+                                    const char* func_name) {                                         \
+    return name##_unchecked_cached(mem, mem->data, MEM_SIZE(mem), addr, shadow_class, func_name);     \
+  }                                                                                                  \
+  static inline t3 name(wasm_rt_memory_t* mem, u64 addr, u32 shadow_class, const char* func_name) {  \
+    return name##_cached(mem, mem->data, MEM_SIZE(mem), addr, shadow_class, func_name);               \
+  }
+
+#define DEFINE_STORE(name, t1, t2)                                                                   \
+  static inline void name##_unchecked_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size,      \
+                                             u64 addr, t2 value, u32 shadow_class,                   \
+                                             const char* func_name) {                                \
+    t1 wrapped = (t1)value;                                                                          \
+    (void)mem_size;                                                                                  \
+    memcpy(MEM_ACCESS_REF(mem, mem_data, addr), &wrapped, sizeof(t1));                               \
+    WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, addr, sizeof(t1));                      \
+  }                                                                                                  \
+  static inline void name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,      \
+                                   t2 value, u32 shadow_class, const char* func_name) {              \
+    MEMCHECK(mem_size, addr, t1);                                                                    \
+    name##_unchecked_cached(mem, mem_data, mem_size, addr, value, shadow_class, func_name);          \
+  }                                                                                                  \
+  static inline void name##_unchecked(wasm_rt_memory_t* mem, u64 addr, t2 value, u32 shadow_class,   \
+                                      const char* func_name) {                                       \
+    name##_unchecked_cached(mem, mem->data, MEM_SIZE(mem), addr, value, shadow_class, func_name);     \
+  }                                                                                                  \
+  static inline void name(wasm_rt_memory_t* mem, u64 addr, t2 value, u32 shadow_class,               \
+                          const char* func_name) {                                                   \
+    name##_cached(mem, mem->data, MEM_SIZE(mem), addr, value, shadow_class, func_name);               \
+  }
+#endif
+
+DEFINE_LOAD(i32_load, u32, u32, u32);
+DEFINE_LOAD(i64_load, u64, u64, u64);
+DEFINE_LOAD(f32_load, f32, f32, f32);
+DEFINE_LOAD(f64_load, f64, f64, f64);
+DEFINE_LOAD(i32_load8_s, s8, s32, u32);
+DEFINE_LOAD(i64_load8_s, s8, s64, u64);
+DEFINE_LOAD(i32_load8_u, u8, u32, u32);
+DEFINE_LOAD(i64_load8_u, u8, u64, u64);
+DEFINE_LOAD(i32_load16_s, s16, s32, u32);
+DEFINE_LOAD(i64_load16_s, s16, s64, u64);
+DEFINE_LOAD(i32_load16_u, u16, u32, u32);
+DEFINE_LOAD(i64_load16_u, u16, u64, u64);
+DEFINE_LOAD(i64_load32_s, s32, s64, u64);
+DEFINE_LOAD(i64_load32_u, u32, u64, u64);
+DEFINE_STORE(i32_store, u32, u32);
+DEFINE_STORE(i64_store, u64, u64);
+DEFINE_STORE(f32_store, f32, f32);
+DEFINE_STORE(f64_store, f64, f64);
+DEFINE_STORE(i32_store8, u8, u32);
+DEFINE_STORE(i32_store16, u16, u32);
+DEFINE_STORE(i64_store8, u8, u64);
+DEFINE_STORE(i64_store16, u16, u64);
+DEFINE_STORE(i64_store32, u32, u64);
+
+// The bulk memory operations are bounds checked and done with memmove/memset
+// by the runtime. The shadow memory is checked once for the whole range.
+static inline void memory_copy(wasm_rt_memory_t* mem, u32 dest, u32 src, u32 n,
+                               u32 shadow_class, const char* func_name) {
+  wasm_rt_memory_copy(mem, dest, src, n);
+  if (n != 0) {
+    WASM2C_SHADOW_MEMORY_LOAD(mem, shadow_class, func_name, src, n);
+    WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, dest, n);
+  }
+}
+
+static inline void memory_fill(wasm_rt_memory_t* mem, u32 dest, u32 value, u32 n,
+                               u32 shadow_class, const char* func_name) {
+  wasm_rt_memory_fill(mem, dest, value, n);
+  if (n != 0) {
+    WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, dest, n);
+  }
+}
+
+static inline void memory_init(wasm_rt_memory_t* mem, u32 dest, u32 src, u32 n,
+                               const u8* data, u32 data_size,
+                               u32 shadow_class, const char* func_name) {
+  wasm_rt_memory_init(mem, dest, data, data_size, src, n);
+  if (n != 0) {
+    WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, dest, n);
+  }
+}
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+
+// Adapted from https://github.com/nemequ/portable-snippets/blob/master/builtin/builtin.h
+
+static inline int I64_CLZ(unsigned long long v) {
+  unsigned long r = 0;
+#if defined(_M_AMD64) || defined(_M_ARM)
+    if (_BitScanReverse64(&r, v)) {
+      return 63 - r;
+    }
+#else
+    if (_BitScanReverse(&r, (unsigned long) (v >> 32))) {
+      return 31 - r;
+    } else if (_BitScanReverse(&r, (unsigned long) v)) {
+      return 63 - r;
+    }
+#endif
+  return 64;
+}
+
+static inline int I32_CLZ(unsigned long v) {
+  unsigned long r = 0;
+  if (_BitScanReverse(&r, v)) {
+    return 31 - r;
+  }
+  return 32;
+}
+
+static inline int I64_CTZ(unsigned long long v) {
+  if (!v) {
+    return 64;
+  }
+  unsigned long r = 0;
+#if defined(_M_AMD64) || defined(_M_ARM)
+    _BitScanForward64(&r, v);
+    return (int) r;
+#else
+    if (_BitScanForward(&r, (unsigned int) (v))) {
+      return (int) (r);
+    }
+
+    _BitScanForward(&r, (unsigned int) (v >> 32));
+    return (int) (r + 32);
+#endif
+}
+
+static inline int I32_CTZ(unsigned long v) {
+  if (!v) {
+    return 32;
+  }
+  unsigned long r = 0;
+  _BitScanForward(&r, v);
+  return (int) r;
+}
+
+#define POPCOUNT_DEFINE_PORTABLE(f_n, T)                    \
+  static inline u32 f_n(T x) {                              \
+    x = x - ((x >> 1) & (T)~(T)0/3);                        \
+    x = (x & (T)~(T)0/15*3) + ((x >> 2) & (T)~(T)0/15*3);   \
+    x = (x + (x >> 4)) & (T)~(T)0/255*15;                   \
+    return (T)(x * ((T)~(T)0/255)) >> (sizeof(T) - 1) * 8;  \
+  }
+
+POPCOUNT_DEFINE_PORTABLE(I32_POPCNT, u32)
+POPCOUNT_DEFINE_PORTABLE(I64_POPCNT, u64)
+
+#undef POPCOUNT_DEFINE_PORTABLE
+
+#else
+#  define I32_CLZ(x) ((x) ? __builtin_clz(x) : 32)
+#  define I64_CLZ(x) ((x) ? __builtin_clzll(x) : 64)
+#  define I32_CTZ(x) ((x) ? __builtin_ctz(x) : 32)
+#  define I64_CTZ(x) ((x) ? __builtin_ctzll(x) : 64)
+#  define I32_POPCNT(x) (__builtin_popcount(x))
+#  define I64_POPCNT(x) (__builtin_popcountll(x))
+#endif
+
+#define DIV_S(ut, min, x, y)                                 \
+   ((UNLIKELY((y) == 0)) ?                TRAP(DIV_BY_ZERO)  \
+  : (UNLIKELY((x) == min && (y) == -1)) ? TRAP(INT_OVERFLOW) \
+  : (ut)((x) / (y)))
+
+#define REM_S(ut, min, x, y)                                \
+   ((UNLIKELY((y) == 0)) ?                TRAP(DIV_BY_ZERO) \
+  : (UNLIKELY((x) == min && (y) == -1)) ? 0                 \
+  : (ut)((x) % (y)))
+
+#define I32_DIV_S(x, y) DIV_S(u32, INT32_MIN, (s32)x, (s32)y)
+#define I64_DIV_S(x, y) DIV_S(u64, INT64_MIN, (s64)x, (s64)y)
+#define I32_REM_S(x, y) REM_S(u32, INT32_MIN, (s32)x, (s32)y)
+#define I64_REM_S(x, y) REM_S(u64, INT64_MIN, (s64)x, (s64)y)
+
+#define DIVREM_U(op, x, y) \
+  ((UNLIKELY((y) == 0)) ? TRAP(DIV_BY_ZERO) : ((x) op (y)))
+
+#define DIV_U(x, y) DIVREM_U(/, x, y)
+#define REM_U(x, y) DIVREM_U(%, x, y)
+
+#define ROTL(x, y, mask) \
+  (((x) << ((y) & (mask))) | ((x) >> (((mask) - (y) + 1) & (mask))))
+#define ROTR(x, y, mask) \
+  (((x) >> ((y) & (mask))) | ((x) << (((mask) - (y) + 1) & (mask))))
+
+#define I32_ROTL(x, y) ROTL(x, y, 31)
+#define I64_ROTL(x, y) ROTL(x, y, 63)
+#define I32_ROTR(x, y) ROTR(x, y, 31)
+#define I64_ROTR(x, y) ROTR(x, y, 63)
+
+#define FMIN(x, y)                                          \
+   ((UNLIKELY((x) != (x))) ? NAN                            \
+  : (UNLIKELY((y) != (y))) ? NAN                            \
+  : (UNLIKELY((x) == 0 && (y) == 0)) ? (signbit(x) ? x : y) \
+  : (x < y) ? x : y)
+
+#define FMAX(x, y)                                          \
+   ((UNLIKELY((x) != (x))) ? NAN                            \
+  : (UNLIKELY((y) != (y))) ? NAN                            \
+  : (UNLIKELY((x) == 0 && (y) == 0)) ? (signbit(x) ? y : x) \
+  : (x > y) ? x : y)
+
+#define TRUNC_S(ut, st, ft, min, minop, max, x)                             \
+  ((UNLIKELY((x) != (x)))                        ? TRAP(INVALID_CONVERSION) \
+   : (UNLIKELY(!((x)minop(min) && (x) < (max)))) ? TRAP(INT_OVERFLOW)       \
+                                                 : (ut)(st)(x))
+
+#define I32_TRUNC_S_F32(x) TRUNC_S(u32, s32, f32, (f32)INT32_MIN, >=, 2147483648.f, x)
+#define I64_TRUNC_S_F32(x) TRUNC_S(u64, s64, f32, (f32)INT64_MIN, >=, (f32)INT64_MAX, x)
+#define I32_TRUNC_S_F64(x) TRUNC_S(u32, s32, f64, -2147483649., >, 2147483648., x)
+#define I64_TRUNC_S_F64(x) TRUNC_S(u64, s64, f64, (f64)INT64_MIN, >=, (f64)INT64_MAX, x)
+
+#define TRUNC_U(ut, ft, max, x)                                            \
+  ((UNLIKELY((x) != (x)))                       ? TRAP(INVALID_CONVERSION) \
+   : (UNLIKELY(!((x) > (ft)-1 && (x) < (max)))) ? TRAP(INT_OVERFLOW)       \
+                                                : (ut)(x))
+
+#define I32_TRUNC_U_F32(x) TRUNC_U(u32, f32, 4294967296.f, x)
+#define I64_TRUNC_U_F32(x) TRUNC_U(u64, f32, (f32)UINT64_MAX, x)
+#define I32_TRUNC_U_F64(x) TRUNC_U(u32, f64, 4294967296.,  x)
+#define I64_TRUNC_U_F64(x) TRUNC_U(u64, f64, (f64)UINT64_MAX, x)
+
+#define TRUNC_SAT_S(ut, st, ft, min, smin, minop, max, smax, x) \
+  ((UNLIKELY((x) != (x)))         ? 0                           \
+   : (UNLIKELY(!((x)minop(min)))) ? smin                        \
+   : (UNLIKELY(!((x) < (max))))   ? smax                        \
+                                  : (ut)(st)(x))
+
+#define I32_TRUNC_SAT_S_F32(x) TRUNC_SAT_S(u32, s32, f32, (f32)INT32_MIN, INT32_MIN, >=, 2147483648.f, INT32_MAX, x)
+#define I64_TRUNC_SAT_S_F32(x) TRUNC_SAT_S(u64, s64, f32, (f32)INT64_MIN, INT64_MIN, >=, (f32)INT64_MAX, INT64_MAX, x)
+#define I32_TRUNC_SAT_S_F64(x) TRUNC_SAT_S(u32, s32, f64, -2147483649., INT32_MIN, >, 2147483648., INT32_MAX, x)
+#define I64_TRUNC_SAT_S_F64(x) TRUNC_SAT_S(u64, s64, f64, (f64)INT64_MIN, INT64_MIN, >=, (f64)INT64_MAX, INT64_MAX, x)
+
+#define TRUNC_SAT_U(ut, ft, max, smax, x) \
+  ((UNLIKELY((x) != (x)))        ? 0      \
+   : (UNLIKELY(!((x) > (ft)-1))) ? 0      \
+   : (UNLIKELY(!((x) < (max))))  ? smax   \
+                                 : (ut)(x))
+
+#define I32_TRUNC_SAT_U_F32(x) TRUNC_SAT_U(u32, f32, 4294967296.f, UINT32_MAX, x)
+#define I64_TRUNC_SAT_U_F32(x) TRUNC_SAT_U(u64, f32, (f32)UINT64_MAX, UINT64_MAX, x)
+#define I32_TRUNC_SAT_U_F64(x) TRUNC_SAT_U(u32, f64, 4294967296., UINT32_MAX,  x)
+#define I64_TRUNC_SAT_U_F64(x) TRUNC_SAT_U(u64, f64, (f64)UINT64_MAX, UINT64_MAX, x)
+
+#define DEFINE_REINTERPRET(name, t1, t2)  \
+  static inline t2 name(t1 x) {           \
+    t2 result;                            \
+    memcpy(&result, &x, sizeof(result));  \
+    return result;                        \
+  }
+
+DEFINE_REINTERPRET(f32_reinterpret_i32, u32, f32)
+DEFINE_REINTERPRET(i32_reinterpret_f32, f32, u32)
+DEFINE_REINTERPRET(f64_reinterpret_i64, u64, f64)
+DEFINE_REINTERPRET(i64_reinterpret_f64, f64, u64)
+struct wasm2c_sandbox_t {
+  wasm_sandbox_wasi_data wasi_data;
+  wasm_rt_memory_t w2c_M0;
+  u32 w2c_T0_current_index;
+  wasm_rt_table_t w2c_T0;
+  u32 func_types[1];
+};
+
+
+FUNC_EXPORT u32 w2c_f0(wasm2c_sandbox_t* const, u32);
+FUNC_EXPORT u32 w2c_alpha(wasm2c_sandbox_t* const, u32);
+FUNC_EXPORT u32 w2c_beta(wasm2c_sandbox_t* const, u32);
+FUNC_EXPORT u32 w2c_gamma(wasm2c_sandbox_t* const, u32);
+FUNC_EXPORT u32 w2c_delta(wasm2c_sandbox_t* const, u32);
+FUNC_EXPORT u32 w2c_epsilon(wasm2c_sandbox_t* const, u32);
+FUNC_EXPORT u32 w2c_zeta(wasm2c_sandbox_t* const, u32);
+
+#endif  /* OUT_TEST_WASM2C_CACHE_DIR_OUT_IMPL_H_GENERATED_ */
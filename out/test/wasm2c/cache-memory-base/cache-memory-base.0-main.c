@@ -0,0 +1,294 @@
+#include "cache-memory-base.0.h"
+#include <assert.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wasm-rt.h"
+
+static int g_tests_run;
+static int g_tests_passed;
+
+static void run_spec_tests(void);
+
+static void error(const char* file, int line, const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  fprintf(stderr, "%s:%d: assertion failed: ", file, line);
+  vfprintf(stderr, format, args);
+  va_end(args);
+}
+
+#define ASSERT_TRAP(f)                                           \
+  do {                                                           \
+    g_tests_run++;                                               \
+    wasm_rt_jmp_buf jb;                                          \
+    wasm_rt_try(jb) {                                            \
+      (void)(f);                                                 \
+      wasm_rt_end_try(jb);                                       \
+      error(__FILE__, __LINE__, "expected " #f " to trap.\n");   \
+    } else {                                                     \
+      g_tests_passed++;                                          \
+    }                                                            \
+  } while (0)
+
+#define ASSERT_EXHAUSTION(f)                                     \
+  do {                                                           \
+    g_tests_run++;                                               \
+    wasm_rt_jmp_buf jb;                                          \
+    wasm_rt_try(jb) {                                            \
+      (void)(f);                                                 \
+      wasm_rt_end_try(jb);                                       \
+      error(__FILE__, __LINE__, "expected " #f " to trap.\n");   \
+    } else if (jb.trap == WASM_RT_TRAP_EXHAUSTION) {             \
+      g_tests_passed++;                                          \
+    } else {                                                     \
+      error(__FILE__, __LINE__,                                  \
+            "expected " #f                                       \
+            " to trap due to exhaustion, got trap code %d.\n",   \
+            jb.trap);                                            \
+    }                                                            \
+  } while (0)
+
+#define ASSERT_RETURN(f)                           \
+  do {                                             \
+    g_tests_run++;                                 \
+    wasm_rt_jmp_buf jb;                            \
+    wasm_rt_try(jb) {                              \
+      f;                                           \
+      wasm_rt_end_try(jb);                         \
+      g_tests_passed++;                            \
+    } else {                                       \
+      error(__FILE__, __LINE__, #f " trapped.\n"); \
+    }                                              \
+  } while (0)
+
+#define ASSERT_RETURN_T(type, fmt, f, expected)                          \
+  do {                                                                   \
+    g_tests_run++;                                                       \
+    wasm_rt_jmp_buf jb;                                                  \
+    wasm_rt_try(jb) {                                                    \
+      type actual = f;                                                   \
+      wasm_rt_end_try(jb);                                               \
+      if (is_equal_##type(actual, expected)) {                           \
+        g_tests_passed++;                                                \
+      } else {                                                           \
+        error(__FILE__, __LINE__,                                        \
+              "in " #f ": expected %" fmt ", got %" fmt ".\n", expected, \
+              actual);                                                   \
+      }                                                                  \
+    } else {                                                             \
+      error(__FILE__, __LINE__, #f " trapped.\n");                       \
+    }                                                                    \
+  } while (0)
+
+#define ASSERT_RETURN_NAN_T(type, itype, fmt, f, kind)                        \
+  do {                                                                        \
+    g_tests_run++;                                                            \
+    wasm_rt_jmp_buf jb;                                                       \
+    wasm_rt_try(jb) {                                                         \
+      type actual = f;                                                        \
+      wasm_rt_end_try(jb);                                                    \
+      itype iactual;                                                          \
+      memcpy(&iactual, &actual, sizeof(iactual));                             \
+      if (is_##kind##_nan_##type(iactual)) {                                  \
+        g_tests_passed++;                                                     \
+      } else {                                                                \
+        error(__FILE__, __LINE__,                                             \
+              "in " #f ": expected result to be a " #kind " nan, got 0x%" fmt \
+              ".\n",                                                          \
+              iactual);                                                       \
+      }                                                                       \
+    } else {                                                                  \
+      error(__FILE__, __LINE__, #f " trapped.\n");                            \
+    }                                                                         \
+  } while (0)
+
+#define ASSERT_RETURN_V128(f, expected)                                   \
+  do {                                                                    \
+    g_tests_run++;                                                        \
+    wasm_rt_jmp_buf jb;                                                   \
+    wasm_rt_try(jb) {                                                     \
+      v128 actual = f;                                                    \
+      wasm_rt_end_try(jb);                                                \
+      v128 expected_ = expected;                                          \
+      if (memcmp(&actual, &expected_, sizeof(actual)) == 0) {             \
+        g_tests_passed++;                                                 \
+      } else {                                                            \
+        u64 a[2], e[2];                                                   \
+        memcpy(a, &actual, sizeof(a));                                    \
+        memcpy(e, &expected_, sizeof(e));                                 \
+        error(__FILE__, __LINE__,                                         \
+              "in " #f ": expected 0x%016" PRIx64 "%016" PRIx64           \
+              ", got 0x%016" PRIx64 "%016" PRIx64 ".\n",                  \
+              e[1], e[0], a[1], a[0]);                                    \
+      }                                                                   \
+    } else {                                                              \
+      error(__FILE__, __LINE__, #f " trapped.\n");                        \
+    }                                                                     \
+  } while (0)
+
+/* For the checks of the --driver files, which don't call into the sandbox. */
+#define ASSERT_TRUE(cond)                                         \
+  do {                                                            \
+    g_tests_run++;                                                \
+    if (cond) {                                                   \
+      g_tests_passed++;                                           \
+    } else {                                                      \
+      error(__FILE__, __LINE__, "expected " #cond " to hold.\n"); \
+    }                                                             \
+  } while (0)
+
+#define ASSERT_RETURN_I32(f, expected) ASSERT_RETURN_T(u32, "u", f, expected)
+#define ASSERT_RETURN_I64(f, expected) ASSERT_RETURN_T(u64, PRIu64, f, expected)
+#define ASSERT_RETURN_F32(f, expected) ASSERT_RETURN_T(f32, ".9g", f, expected)
+#define ASSERT_RETURN_F64(f, expected) ASSERT_RETURN_T(f64, ".17g", f, expected)
+
+#define ASSERT_RETURN_CANONICAL_NAN_F32(f) \
+  ASSERT_RETURN_NAN_T(f32, u32, "08x", f, canonical)
+#define ASSERT_RETURN_CANONICAL_NAN_F64(f) \
+  ASSERT_RETURN_NAN_T(f64, u64, "016x", f, canonical)
+#define ASSERT_RETURN_ARITHMETIC_NAN_F32(f) \
+  ASSERT_RETURN_NAN_T(f32, u32, "08x", f, arithmetic)
+#define ASSERT_RETURN_ARITHMETIC_NAN_F64(f) \
+  ASSERT_RETURN_NAN_T(f64, u64, "016x", f, arithmetic)
+
+static bool is_equal_u32(u32 x, u32 y) {
+  return x == y;
+}
+
+static bool is_equal_u64(u64 x, u64 y) {
+  return x == y;
+}
+
+#define is_equal_i32 is_equal_u32
+#define is_equal_i64 is_equal_u64
+
+static bool is_equal_f32(f32 x, f32 y) {
+  u32 ux, uy;
+  memcpy(&ux, &x, sizeof(ux));
+  memcpy(&uy, &y, sizeof(uy));
+  return ux == uy;
+}
+
+static bool is_equal_f64(f64 x, f64 y) {
+  u64 ux, uy;
+  memcpy(&ux, &x, sizeof(ux));
+  memcpy(&uy, &y, sizeof(uy));
+  return ux == uy;
+}
+
+static f32 make_nan_f32(u32 x) {
+  x |= 0x7f800000;
+  f32 res;
+  memcpy(&res, &x, sizeof(res));
+  return res;
+}
+
+static f64 make_nan_f64(u64 x) {
+  x |= 0x7ff0000000000000;
+  f64 res;
+  memcpy(&res, &x, sizeof(res));
+  return res;
+}
+
+static bool is_canonical_nan_f32(u32 x) {
+  return (x & 0x7fffffff) == 0x7fc00000;
+}
+
+static bool is_canonical_nan_f64(u64 x) {
+  return (x & 0x7fffffffffffffff) == 0x7ff8000000000000;
+}
+
+static bool is_arithmetic_nan_f32(u32 x) {
+  return (x & 0x7fc00000) == 0x7fc00000;
+}
+
+static bool is_arithmetic_nan_f64(u64 x) {
+  return (x & 0x7ff8000000000000) == 0x7ff8000000000000;
+}
+
+
+static v128 make_v128(u64 lo, u64 hi) {
+  u64 halves[2] = {lo, hi};
+  v128 res;
+  memcpy(&res, halves, sizeof(res));
+  return res;
+}
+
+int main(int argc, char** argv) {
+  run_spec_tests();
+  /* run-spec-wasm2c.py adds up the counts of all modules, and fails the test
+   * if they differ. */
+  printf("%u/%u tests passed.\n", g_tests_passed, g_tests_run);
+  return 0;
+}
+
+
+static void run_spec_tests(void) {
+  wasm2c_sandbox_funcs_t funcs = get_wasm2c_sandbox_info();
+  if (!funcs.wasm_rt_sys_init()) {
+    error(__FILE__, __LINE__, "could not install the fault handler.\n");
+    g_tests_run++;
+    return;
+  }
+  wasm2c_sandbox_t* sbx = (wasm2c_sandbox_t*)funcs.create_wasm2c_sandbox(0);
+  if (!sbx) {
+    error(__FILE__, __LINE__, "could not create the sandbox.\n");
+    g_tests_run++;
+    return;
+  }
+
+  // cache-memory-base.txt:44
+  ASSERT_TRAP(w2c_load(sbx, 65536u));
+
+  // cache-memory-base.txt:45
+  ASSERT_RETURN_I32(w2c_grow_then_store(sbx, 65536u), 11u);
+
+  // cache-memory-base.txt:46
+  ASSERT_TRAP(w2c_load(sbx, 131072u));
+
+  // cache-memory-base.txt:47
+  ASSERT_RETURN_I32(w2c_call_grow_then_store(sbx, 131072u), 12u);
+
+  // cache-memory-base.txt:48
+  ASSERT_RETURN_I32(w2c_call_indirect_grow_then_store(sbx, 196608u), 13u);
+
+  // cache-memory-base.txt:49
+  ASSERT_RETURN_I32(w2c_size(sbx), 4u);
+
+  // cache-memory-base.txt:50
+  ASSERT_RETURN(w2c_store(sbx, 0u, 1u));
+
+  // cache-memory-base.txt:51
+  ASSERT_TRAP(w2c_store(sbx, 262144u, 2u));
+
+  // cache-memory-base.txt:52
+  ASSERT_TRAP(w2c_load(sbx, 262144u));
+
+  // cache-memory-base.txt:53
+  ASSERT_RETURN_I32(w2c_load_grow_load(sbx, 262144u), 1u);
+
+  // cache-memory-base.txt:54
+  ASSERT_RETURN_I32(w2c_load(sbx, 65536u), 11u);
+
+  // cache-memory-base.txt:55
+  ASSERT_RETURN(w2c_store(sbx, 4u, 2u));
+
+  // cache-memory-base.txt:56
+  ASSERT_RETURN(w2c_store(sbx, 8u, 3u));
+
+  // cache-memory-base.txt:57
+  ASSERT_RETURN_I32(w2c_sum(sbx, 0u, 3u), 6u);
+
+  // cache-memory-base.txt:58
+  ASSERT_TRAP(w2c_sum(sbx, 327676u, 2u));
+
+  funcs.destroy_wasm2c_sandbox(sbx);
+}
@@ -0,0 +1,341 @@
+#include "call-indirect.0.h"
+#include <assert.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wasm-rt.h"
+
+static int g_tests_run;
+static int g_tests_passed;
+
+static void run_spec_tests(void);
+
+static void error(const char* file, int line, const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  fprintf(stderr, "%s:%d: assertion failed: ", file, line);
+  vfprintf(stderr, format, args);
+  va_end(args);
+}
+
+#define ASSERT_TRAP(f)                                           \
+  do {                                                           \
+    g_tests_run++;                                               \
+    wasm_rt_jmp_buf jb;                                          \
+    wasm_rt_try(jb) {                                            \
+      (void)(f);                                                 \
+      wasm_rt_end_try(jb);                                       \
+      error(__FILE__, __LINE__, "expected " #f " to trap.\n");   \
+    } else {                                                     \
+      g_tests_passed++;                                          \
+    }                                                            \
+  } while (0)
+
+#define ASSERT_EXHAUSTION(f)                                     \
+  do {                                                           \
+    g_tests_run++;                                               \
+    wasm_rt_jmp_buf jb;                                          \
+    wasm_rt_try(jb) {                                            \
+      (void)(f);                                                 \
+      wasm_rt_end_try(jb);                                       \
+      error(__FILE__, __LINE__, "expected " #f " to trap.\n");   \
+    } else if (jb.trap == WASM_RT_TRAP_EXHAUSTION) {             \
+      g_tests_passed++;                                          \
+    } else {                                                     \
+      error(__FILE__, __LINE__,                                  \
+            "expected " #f                                       \
+            " to trap due to exhaustion, got trap code %d.\n",   \
+            jb.trap);                                            \
+    }                                                            \
+  } while (0)
+
+#define ASSERT_RETURN(f)                           \
+  do {                                             \
+    g_tests_run++;                                 \
+    wasm_rt_jmp_buf jb;                            \
+    wasm_rt_try(jb) {                              \
+      f;                                           \
+      wasm_rt_end_try(jb);                         \
+      g_tests_passed++;                            \
+    } else {                                       \
+      error(__FILE__, __LINE__, #f " trapped.\n"); \
+    }                                              \
+  } while (0)
+
+#define ASSERT_RETURN_T(type, fmt, f, expected)                          \
+  do {                                                                   \
+    g_tests_run++;                                                       \
+    wasm_rt_jmp_buf jb;                                                  \
+    wasm_rt_try(jb) {                                                    \
+      type actual = f;                                                   \
+      wasm_rt_end_try(jb);                                               \
+      if (is_equal_##type(actual, expected)) {                           \
+        g_tests_passed++;                                                \
+      } else {                                                           \
+        error(__FILE__, __LINE__,                                        \
+              "in " #f ": expected %" fmt ", got %" fmt ".\n", expected, \
+              actual);                                                   \
+      }                                                                  \
+    } else {                                                             \
+      error(__FILE__, __LINE__, #f " trapped.\n");                       \
+    }                                                                    \
+  } while (0)
+
+#define ASSERT_RETURN_NAN_T(type, itype, fmt, f, kind)                        \
+  do {                                                                        \
+    g_tests_run++;                                                            \
+    wasm_rt_jmp_buf jb;                                                       \
+    wasm_rt_try(jb) {                                                         \
+      type actual = f;                                                        \
+      wasm_rt_end_try(jb);                                                    \
+      itype iactual;                                                          \
+      memcpy(&iactual, &actual, sizeof(iactual));                             \
+      if (is_##kind##_nan_##type(iactual)) {                                  \
+        g_tests_passed++;                                                     \
+      } else {                                                                \
+        error(__FILE__, __LINE__,                                             \
+              "in " #f ": expected result to be a " #kind " nan, got 0x%" fmt \
+              ".\n",                                                          \
+              iactual);                                                       \
+      }                                                                       \
+    } else {                                                                  \
+      error(__FILE__, __LINE__, #f " trapped.\n");                            \
+    }                                                                         \
+  } while (0)
+
+#define ASSERT_RETURN_V128(f, expected)                                   \
+  do {                                                                    \
+    g_tests_run++;                                                        \
+    wasm_rt_jmp_buf jb;                                                   \
+    wasm_rt_try(jb) {                                                     \
+      v128 actual = f;                                                    \
+      wasm_rt_end_try(jb);                                                \
+      v128 expected_ = expected;                                          \
+      if (memcmp(&actual, &expected_, sizeof(actual)) == 0) {             \
+        g_tests_passed++;                                                 \
+      } else {                                                            \
+        u64 a[2], e[2];                                                   \
+        memcpy(a, &actual, sizeof(a));                                    \
+        memcpy(e, &expected_, sizeof(e));                                 \
+        error(__FILE__, __LINE__,                                         \
+              "in " #f ": expected 0x%016" PRIx64 "%016" PRIx64           \
+              ", got 0x%016" PRIx64 "%016" PRIx64 ".\n",                  \
+              e[1], e[0], a[1], a[0]);                                    \
+      }                                                                   \
+    } else {                                                              \
+      error(__FILE__, __LINE__, #f " trapped.\n");                        \
+    }                                                                     \
+  } while (0)
+
+/* For the checks of the --driver files, which don't call into the sandbox. */
+#define ASSERT_TRUE(cond)                                         \
+  do {                                                            \
+    g_tests_run++;                                                \
+    if (cond) {                                                   \
+      g_tests_passed++;                                           \
+    } else {                                                      \
+      error(__FILE__, __LINE__, "expected " #cond " to hold.\n"); \
+    }                                                             \
+  } while (0)
+
+#define ASSERT_RETURN_I32(f, expected) ASSERT_RETURN_T(u32, "u", f, expected)
+#define ASSERT_RETURN_I64(f, expected) ASSERT_RETURN_T(u64, PRIu64, f, expected)
+#define ASSERT_RETURN_F32(f, expected) ASSERT_RETURN_T(f32, ".9g", f, expected)
+#define ASSERT_RETURN_F64(f, expected) ASSERT_RETURN_T(f64, ".17g", f, expected)
+
+#define ASSERT_RETURN_CANONICAL_NAN_F32(f) \
+  ASSERT_RETURN_NAN_T(f32, u32, "08x", f, canonical)
+#define ASSERT_RETURN_CANONICAL_NAN_F64(f) \
+  ASSERT_RETURN_NAN_T(f64, u64, "016x", f, canonical)
+#define ASSERT_RETURN_ARITHMETIC_NAN_F32(f) \
+  ASSERT_RETURN_NAN_T(f32, u32, "08x", f, arithmetic)
+#define ASSERT_RETURN_ARITHMETIC_NAN_F64(f) \
+  ASSERT_RETURN_NAN_T(f64, u64, "016x", f, arithmetic)
+
+static bool is_equal_u32(u32 x, u32 y) {
+  return x == y;
+}
+
+static bool is_equal_u64(u64 x, u64 y) {
+  return x == y;
+}
+
+#define is_equal_i32 is_equal_u32
+#define is_equal_i64 is_equal_u64
+
+static bool is_equal_f32(f32 x, f32 y) {
+  u32 ux, uy;
+  memcpy(&ux, &x, sizeof(ux));
+  memcpy(&uy, &y, sizeof(uy));
+  return ux == uy;
+}
+
+static bool is_equal_f64(f64 x, f64 y) {
+  u64 ux, uy;
+  memcpy(&ux, &x, sizeof(ux));
+  memcpy(&uy, &y, sizeof(uy));
+  return ux == uy;
+}
+
+static f32 make_nan_f32(u32 x) {
+  x |= 0x7f800000;
+  f32 res;
+  memcpy(&res, &x, sizeof(res));
+  return res;
+}
+
+static f64 make_nan_f64(u64 x) {
+  x |= 0x7ff0000000000000;
+  f64 res;
+  memcpy(&res, &x, sizeof(res));
+  return res;
+}
+
+static bool is_canonical_nan_f32(u32 x) {
+  return (x & 0x7fffffff) == 0x7fc00000;
+}
+
+static bool is_canonical_nan_f64(u64 x) {
+  return (x & 0x7fffffffffffffff) == 0x7ff8000000000000;
+}
+
+static bool is_arithmetic_nan_f32(u32 x) {
+  return (x & 0x7fc00000) == 0x7fc00000;
+}
+
+static bool is_arithmetic_nan_f64(u64 x) {
+  return (x & 0x7ff8000000000000) == 0x7ff8000000000000;
+}
+
+
+static v128 make_v128(u64 lo, u64 hi) {
+  u64 halves[2] = {lo, hi};
+  v128 res;
+  memcpy(&res, halves, sizeof(res));
+  return res;
+}
+
+int main(int argc, char** argv) {
+  run_spec_tests();
+  /* run-spec-wasm2c.py adds up the counts of all modules, and fails the test
+   * if they differ. */
+  printf("%u/%u tests passed.\n", g_tests_passed, g_tests_run);
+  return 0;
+}
+
+/* call_indirect compares the type of the element with a constant, which must
+ * be the index the runtime registers for that signature: host callbacks are
+ * added with the registered index. The reason for a failed call is also
+ * reported. */
+
+static wasm_rt_trap_t trap_of_call(wasm2c_sandbox_t* sbx, u32 index) {
+  wasm_rt_jmp_buf jb;
+  wasm_rt_try(jb) {
+    w2c_call_unary(sbx, index, 0);
+    wasm_rt_end_try(jb);
+  }
+  return jb.trap;
+}
+
+static u32 host_triple(wasm2c_sandbox_t* sbx, u32 x) {
+  (void)sbx;
+  return x * 3;
+}
+
+static f64 host_f64(wasm2c_sandbox_t* sbx, f64 x, f32 y) {
+  (void)sbx;
+  return x + y;
+}
+
+static u64 host_many(wasm2c_sandbox_t* sbx, u32 a, u32 b, u32 c, u32 d, u32 e,
+                     u32 f, u32 g, u32 h, u32 i) {
+  (void)sbx;
+  return (u64)a + b + c + d + e + f + g + h + i;
+}
+
+static void run_driver_tests(wasm2c_sandbox_funcs_t* funcs,
+                             wasm2c_sandbox_t* sbx) {
+  ASSERT_TRUE(trap_of_call(sbx, 0) == WASM_RT_TRAP_NONE);
+  ASSERT_TRUE(trap_of_call(sbx, 1) == WASM_RT_TRAP_CALL_INDIRECT_TYPE_MISMATCH);
+  ASSERT_TRUE(trap_of_call(sbx, 3) == WASM_RT_TRAP_CALL_INDIRECT_NULL_PTR);
+  ASSERT_TRUE(trap_of_call(sbx, 100) == WASM_RT_TRAP_CALL_INDIRECT_OOB_INDEX);
+
+  wasm_rt_type_t i32_to_i32[] = {WASM_RT_I32, WASM_RT_I32};
+  wasm_rt_type_t f64_f32_to_f64[] = {WASM_RT_F64, WASM_RT_F32, WASM_RT_F64};
+  wasm_rt_type_t many[] = {WASM_RT_I32, WASM_RT_I32, WASM_RT_I32, WASM_RT_I32,
+                           WASM_RT_I32, WASM_RT_I32, WASM_RT_I32, WASM_RT_I32,
+                           WASM_RT_I32, WASM_RT_I64};
+  u32 triple = funcs->add_wasm2c_callback(
+      sbx, funcs->lookup_wasm2c_func_index(sbx, 1, 1, i32_to_i32),
+      (void*)&host_triple, WASM_RT_EXTERNAL_FUNCTION);
+  u32 add = funcs->add_wasm2c_callback(
+      sbx, funcs->lookup_wasm2c_func_index(sbx, 2, 1, f64_f32_to_f64),
+      (void*)&host_f64, WASM_RT_EXTERNAL_FUNCTION);
+  u32 sum = funcs->add_wasm2c_callback(
+      sbx, funcs->lookup_wasm2c_func_index(sbx, 9, 1, many),
+      (void*)&host_many, WASM_RT_EXTERNAL_FUNCTION);
+  ASSERT_RETURN_I32(w2c_call_unary(sbx, triple, 5), 15u);
+  ASSERT_RETURN_F64(w2c_call_f64(sbx, add, 1.5, 0.25f), 1.75);
+  ASSERT_RETURN_I64(w2c_call_many(sbx, sum), 45ull);
+  ASSERT_TRUE(trap_of_call(sbx, add) == WASM_RT_TRAP_CALL_INDIRECT_TYPE_MISMATCH);
+  ASSERT_TRUE(trap_of_call(sbx, sum) == WASM_RT_TRAP_CALL_INDIRECT_TYPE_MISMATCH);
+}
+
+
+static void run_spec_tests(void) {
+  wasm2c_sandbox_funcs_t funcs = get_wasm2c_sandbox_info();
+  if (!funcs.wasm_rt_sys_init()) {
+    error(__FILE__, __LINE__, "could not install the fault handler.\n");
+    g_tests_run++;
+    return;
+  }
+  wasm2c_sandbox_t* sbx = (wasm2c_sandbox_t*)funcs.create_wasm2c_sandbox(0);
+  if (!sbx) {
+    error(__FILE__, __LINE__, "could not create the sandbox.\n");
+    g_tests_run++;
+    return;
+  }
+
+  // call-indirect.txt:36
+  ASSERT_RETURN_I32(w2c_call_unary(sbx, 0u, 5u), 6u);
+
+  // call-indirect.txt:37
+  ASSERT_RETURN_I32(w2c_call_unary(sbx, 2u, 5u), 7u);
+
+  // call-indirect.txt:38
+  ASSERT_RETURN_I32(w2c_call_unary2(sbx, 0u, 5u), 6u);
+
+  // call-indirect.txt:39
+  ASSERT_RETURN_I32(w2c_call_binary(sbx, 1u), 7u);
+
+  // call-indirect.txt:40
+  ASSERT_TRAP(w2c_call_binary(sbx, 0u));
+
+  // call-indirect.txt:41
+  ASSERT_TRAP(w2c_call_unary(sbx, 1u, 5u));
+
+  // call-indirect.txt:42
+  ASSERT_TRAP(w2c_call_unary(sbx, 3u, 5u));
+
+  // call-indirect.txt:43
+  ASSERT_TRAP(w2c_call_unary(sbx, 6u, 5u));
+
+  // call-indirect.txt:44
+  ASSERT_RETURN_I64(w2c_call_many(sbx, 4u), 15ull);
+
+  // call-indirect.txt:45
+  ASSERT_TRAP(w2c_call_many(sbx, 5u));
+
+  // call-indirect.txt:46
+  ASSERT_TRAP(w2c_call_many(sbx, 0u));
+
+  run_driver_tests(&funcs, sbx);
+  funcs.destroy_wasm2c_sandbox(sbx);
+}
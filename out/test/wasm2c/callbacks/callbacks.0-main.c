@@ -0,0 +1,339 @@
+#include "callbacks.0.h"
+#include <assert.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wasm-rt.h"
+
+static int g_tests_run;
+static int g_tests_passed;
+
+static void run_spec_tests(void);
+
+static void error(const char* file, int line, const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  fprintf(stderr, "%s:%d: assertion failed: ", file, line);
+  vfprintf(stderr, format, args);
+  va_end(args);
+}
+
+#define ASSERT_TRAP(f)                                           \
+  do {                                                           \
+    g_tests_run++;                                               \
+    wasm_rt_jmp_buf jb;                                          \
+    wasm_rt_try(jb) {                                            \
+      (void)(f);                                                 \
+      wasm_rt_end_try(jb);                                       \
+      error(__FILE__, __LINE__, "expected " #f " to trap.\n");   \
+    } else {                                                     \
+      g_tests_passed++;                                          \
+    }                                                            \
+  } while (0)
+
+#define ASSERT_EXHAUSTION(f)                                     \
+  do {                                                           \
+    g_tests_run++;                                               \
+    wasm_rt_jmp_buf jb;                                          \
+    wasm_rt_try(jb) {                                            \
+      (void)(f);                                                 \
+      wasm_rt_end_try(jb);                                       \
+      error(__FILE__, __LINE__, "expected " #f " to trap.\n");   \
+    } else if (jb.trap == WASM_RT_TRAP_EXHAUSTION) {             \
+      g_tests_passed++;                                          \
+    } else {                                                     \
+      error(__FILE__, __LINE__,                                  \
+            "expected " #f                                       \
+            " to trap due to exhaustion, got trap code %d.\n",   \
+            jb.trap);                                            \
+    }                                                            \
+  } while (0)
+
+#define ASSERT_RETURN(f)                           \
+  do {                                             \
+    g_tests_run++;                                 \
+    wasm_rt_jmp_buf jb;                            \
+    wasm_rt_try(jb) {                              \
+      f;                                           \
+      wasm_rt_end_try(jb);                         \
+      g_tests_passed++;                            \
+    } else {                                       \
+      error(__FILE__, __LINE__, #f " trapped.\n"); \
+    }                                              \
+  } while (0)
+
+#define ASSERT_RETURN_T(type, fmt, f, expected)                          \
+  do {                                                                   \
+    g_tests_run++;                                                       \
+    wasm_rt_jmp_buf jb;                                                  \
+    wasm_rt_try(jb) {                                                    \
+      type actual = f;                                                   \
+      wasm_rt_end_try(jb);                                               \
+      if (is_equal_##type(actual, expected)) {                           \
+        g_tests_passed++;                                                \
+      } else {                                                           \
+        error(__FILE__, __LINE__,                                        \
+              "in " #f ": expected %" fmt ", got %" fmt ".\n", expected, \
+              actual);                                                   \
+      }                                                                  \
+    } else {                                                             \
+      error(__FILE__, __LINE__, #f " trapped.\n");                       \
+    }                                                                    \
+  } while (0)
+
+#define ASSERT_RETURN_NAN_T(type, itype, fmt, f, kind)                        \
+  do {                                                                        \
+    g_tests_run++;                                                            \
+    wasm_rt_jmp_buf jb;                                                       \
+    wasm_rt_try(jb) {                                                         \
+      type actual = f;                                                        \
+      wasm_rt_end_try(jb);                                                    \
+      itype iactual;                                                          \
+      memcpy(&iactual, &actual, sizeof(iactual));                             \
+      if (is_##kind##_nan_##type(iactual)) {                                  \
+        g_tests_passed++;                                                     \
+      } else {                                                                \
+        error(__FILE__, __LINE__,                                             \
+              "in " #f ": expected result to be a " #kind " nan, got 0x%" fmt \
+              ".\n",                                                          \
+              iactual);                                                       \
+      }                                                                       \
+    } else {                                                                  \
+      error(__FILE__, __LINE__, #f " trapped.\n");                            \
+    }                                                                         \
+  } while (0)
+
+#define ASSERT_RETURN_V128(f, expected)                                   \
+  do {                                                                    \
+    g_tests_run++;                                                        \
+    wasm_rt_jmp_buf jb;                                                   \
+    wasm_rt_try(jb) {                                                     \
+      v128 actual = f;                                                    \
+      wasm_rt_end_try(jb);                                                \
+      v128 expected_ = expected;                                          \
+      if (memcmp(&actual, &expected_, sizeof(actual)) == 0) {             \
+        g_tests_passed++;                                                 \
+      } else {                                                            \
+        u64 a[2], e[2];                                                   \
+        memcpy(a, &actual, sizeof(a));                                    \
+        memcpy(e, &expected_, sizeof(e));                                 \
+        error(__FILE__, __LINE__,                                         \
+              "in " #f ": expected 0x%016" PRIx64 "%016" PRIx64           \
+              ", got 0x%016" PRIx64 "%016" PRIx64 ".\n",                  \
+              e[1], e[0], a[1], a[0]);                                    \
+      }                                                                   \
+    } else {                                                              \
+      error(__FILE__, __LINE__, #f " trapped.\n");                        \
+    }                                                                     \
+  } while (0)
+
+/* For the checks of the --driver files, which don't call into the sandbox. */
+#define ASSERT_TRUE(cond)                                         \
+  do {                                                            \
+    g_tests_run++;                                                \
+    if (cond) {                                                   \
+      g_tests_passed++;                                           \
+    } else {                                                      \
+      error(__FILE__, __LINE__, "expected " #cond " to hold.\n"); \
+    }                                                             \
+  } while (0)
+
+#define ASSERT_RETURN_I32(f, expected) ASSERT_RETURN_T(u32, "u", f, expected)
+#define ASSERT_RETURN_I64(f, expected) ASSERT_RETURN_T(u64, PRIu64, f, expected)
+#define ASSERT_RETURN_F32(f, expected) ASSERT_RETURN_T(f32, ".9g", f, expected)
+#define ASSERT_RETURN_F64(f, expected) ASSERT_RETURN_T(f64, ".17g", f, expected)
+
+#define ASSERT_RETURN_CANONICAL_NAN_F32(f) \
+  ASSERT_RETURN_NAN_T(f32, u32, "08x", f, canonical)
+#define ASSERT_RETURN_CANONICAL_NAN_F64(f) \
+  ASSERT_RETURN_NAN_T(f64, u64, "016x", f, canonical)
+#define ASSERT_RETURN_ARITHMETIC_NAN_F32(f) \
+  ASSERT_RETURN_NAN_T(f32, u32, "08x", f, arithmetic)
+#define ASSERT_RETURN_ARITHMETIC_NAN_F64(f) \
+  ASSERT_RETURN_NAN_T(f64, u64, "016x", f, arithmetic)
+
+static bool is_equal_u32(u32 x, u32 y) {
+  return x == y;
+}
+
+static bool is_equal_u64(u64 x, u64 y) {
+  return x == y;
+}
+
+#define is_equal_i32 is_equal_u32
+#define is_equal_i64 is_equal_u64
+
+static bool is_equal_f32(f32 x, f32 y) {
+  u32 ux, uy;
+  memcpy(&ux, &x, sizeof(ux));
+  memcpy(&uy, &y, sizeof(uy));
+  return ux == uy;
+}
+
+static bool is_equal_f64(f64 x, f64 y) {
+  u64 ux, uy;
+  memcpy(&ux, &x, sizeof(ux));
+  memcpy(&uy, &y, sizeof(uy));
+  return ux == uy;
+}
+
+static f32 make_nan_f32(u32 x) {
+  x |= 0x7f800000;
+  f32 res;
+  memcpy(&res, &x, sizeof(res));
+  return res;
+}
+
+static f64 make_nan_f64(u64 x) {
+  x |= 0x7ff0000000000000;
+  f64 res;
+  memcpy(&res, &x, sizeof(res));
+  return res;
+}
+
+static bool is_canonical_nan_f32(u32 x) {
+  return (x & 0x7fffffff) == 0x7fc00000;
+}
+
+static bool is_canonical_nan_f64(u64 x) {
+  return (x & 0x7fffffffffffffff) == 0x7ff8000000000000;
+}
+
+static bool is_arithmetic_nan_f32(u32 x) {
+  return (x & 0x7fc00000) == 0x7fc00000;
+}
+
+static bool is_arithmetic_nan_f64(u64 x) {
+  return (x & 0x7ff8000000000000) == 0x7ff8000000000000;
+}
+
+
+static v128 make_v128(u64 lo, u64 hi) {
+  u64 halves[2] = {lo, hi};
+  v128 res;
+  memcpy(&res, halves, sizeof(res));
+  return res;
+}
+
+int main(int argc, char** argv) {
+  run_spec_tests();
+  /* run-spec-wasm2c.py adds up the counts of all modules, and fails the test
+   * if they differ. */
+  printf("%u/%u tests passed.\n", g_tests_passed, g_tests_run);
+  return 0;
+}
+
+/* add_wasm2c_callback hands out slots that are free, never 0, and reuses the
+ * slots of removed callbacks, growing the table when it runs out. */
+
+static u32 host_add(wasm2c_sandbox_t* sbx, u32 x) {
+  (void)sbx;
+  return x + 1000;
+}
+
+static wasm_rt_trap_t trap_of_call(wasm2c_sandbox_t* sbx, u32 index) {
+  wasm_rt_jmp_buf jb;
+  wasm_rt_try(jb) {
+    w2c_call(sbx, index, 0);
+    wasm_rt_end_try(jb);
+  }
+  return jb.trap;
+}
+
+static void run_driver_tests(wasm2c_sandbox_funcs_t* funcs,
+                             wasm2c_sandbox_t* sbx) {
+  wasm_rt_type_t i32_to_i32[] = {WASM_RT_I32, WASM_RT_I32};
+  u32 type = funcs->lookup_wasm2c_func_index(sbx, 1, 1, i32_to_i32);
+  wasm_rt_table_t* table =
+      (wasm_rt_table_t*)funcs->lookup_wasm2c_nonfunc_export(sbx, "w2c_T0");
+
+  /* Slot 0 and the elements of the module are taken. */
+  u32 callbacks[100];
+  bool distinct = true;
+  for (u32 i = 0; i < 100; i++) {
+    callbacks[i] = funcs->add_wasm2c_callback(sbx, type, (void*)&host_add,
+                                              WASM_RT_EXTERNAL_FUNCTION);
+    distinct = distinct && callbacks[i] != 0 && callbacks[i] != 1 &&
+               callbacks[i] != 3 && callbacks[i] < table->size;
+    for (u32 j = 0; j < i; j++) {
+      distinct = distinct && callbacks[j] != callbacks[i];
+    }
+  }
+  ASSERT_TRUE(distinct);
+  ASSERT_RETURN_I32(w2c_call(sbx, 1, 5), 6u);
+  ASSERT_RETURN_I32(w2c_call(sbx, 3, 5), 7u);
+  ASSERT_RETURN_I32(w2c_call(sbx, callbacks[0], 5), 1005u);
+  ASSERT_RETURN_I32(w2c_call(sbx, callbacks[99], 5), 1005u);
+
+  /* Removed callbacks can't be called, and their slots are handed out again,
+   * even when they are removed more than once. */
+  funcs->remove_wasm2c_callback(sbx, callbacks[10]);
+  funcs->remove_wasm2c_callback(sbx, callbacks[50]);
+  funcs->remove_wasm2c_callback(sbx, callbacks[50]);
+  ASSERT_TRUE(trap_of_call(sbx, callbacks[10]) ==
+              WASM_RT_TRAP_CALL_INDIRECT_NULL_PTR);
+  ASSERT_TRUE(trap_of_call(sbx, callbacks[50]) ==
+              WASM_RT_TRAP_CALL_INDIRECT_NULL_PTR);
+  u32 size = table->size;
+  u32 a = funcs->add_wasm2c_callback(sbx, type, (void*)&host_add,
+                                     WASM_RT_EXTERNAL_FUNCTION);
+  u32 b = funcs->add_wasm2c_callback(sbx, type, (void*)&host_add,
+                                     WASM_RT_EXTERNAL_FUNCTION);
+  ASSERT_TRUE(a != b && (a == callbacks[10] || a == callbacks[50]) &&
+              (b == callbacks[10] || b == callbacks[50]));
+  ASSERT_TRUE(table->size == size);
+  ASSERT_RETURN_I32(w2c_call(sbx, a, 1), 1001u);
+
+  /* Removing slot 0, an empty slot or one past the end does nothing. */
+  funcs->remove_wasm2c_callback(sbx, 0);
+  funcs->remove_wasm2c_callback(sbx, table->size);
+  funcs->remove_wasm2c_callback(sbx, table->size + 100);
+  u32 c = funcs->add_wasm2c_callback(sbx, type, (void*)&host_add,
+                                     WASM_RT_EXTERNAL_FUNCTION);
+  bool c_was_free = c != 0 && c != a && c != b;
+  for (u32 i = 0; i < 100; i++) {
+    c_was_free = c_was_free && (c != callbacks[i] || i == 10 || i == 50);
+  }
+  ASSERT_TRUE(c_was_free);
+
+  /* Removing everything and adding as many again reuses the same slots. */
+  funcs->remove_wasm2c_callback(sbx, a);
+  funcs->remove_wasm2c_callback(sbx, b);
+  funcs->remove_wasm2c_callback(sbx, c);
+  for (u32 i = 0; i < 100; i++) {
+    funcs->remove_wasm2c_callback(sbx, callbacks[i]);
+  }
+  size = table->size;
+  for (u32 i = 0; i < 101; i++) {
+    funcs->add_wasm2c_callback(sbx, type, (void*)&host_add,
+                               WASM_RT_EXTERNAL_FUNCTION);
+  }
+  ASSERT_TRUE(table->size == size);
+  ASSERT_RETURN_I32(w2c_call(sbx, 1, 5), 6u);
+}
+
+
+static void run_spec_tests(void) {
+  wasm2c_sandbox_funcs_t funcs = get_wasm2c_sandbox_info();
+  if (!funcs.wasm_rt_sys_init()) {
+    error(__FILE__, __LINE__, "could not install the fault handler.\n");
+    g_tests_run++;
+    return;
+  }
+  wasm2c_sandbox_t* sbx = (wasm2c_sandbox_t*)funcs.create_wasm2c_sandbox(0);
+  if (!sbx) {
+    error(__FILE__, __LINE__, "could not create the sandbox.\n");
+    g_tests_run++;
+    return;
+  }
+
+  run_driver_tests(&funcs, sbx);
+  funcs.destroy_wasm2c_sandbox(sbx);
+}
@@ -0,0 +1,350 @@
+#include "export-lookup.0.h"
+#include <assert.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wasm-rt.h"
+
+static int g_tests_run;
+static int g_tests_passed;
+
+static void run_spec_tests(void);
+
+static void error(const char* file, int line, const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  fprintf(stderr, "%s:%d: assertion failed: ", file, line);
+  vfprintf(stderr, format, args);
+  va_end(args);
+}
+
+#define ASSERT_TRAP(f)                                           \
+  do {                                                           \
+    g_tests_run++;                                               \
+    wasm_rt_jmp_buf jb;                                          \
+    wasm_rt_try(jb) {                                            \
+      (void)(f);                                                 \
+      wasm_rt_end_try(jb);                                       \
+      error(__FILE__, __LINE__, "expected " #f " to trap.\n");   \
+    } else {                                                     \
+      g_tests_passed++;                                          \
+    }                                                            \
+  } while (0)
+
+#define ASSERT_EXHAUSTION(f)                                     \
+  do {                                                           \
+    g_tests_run++;                                               \
+    wasm_rt_jmp_buf jb;                                          \
+    wasm_rt_try(jb) {                                            \
+      (void)(f);                                                 \
+      wasm_rt_end_try(jb);                                       \
+      error(__FILE__, __LINE__, "expected " #f " to trap.\n");   \
+    } else if (jb.trap == WASM_RT_TRAP_EXHAUSTION) {             \
+      g_tests_passed++;                                          \
+    } else {                                                     \
+      error(__FILE__, __LINE__,                                  \
+            "expected " #f                                       \
+            " to trap due to exhaustion, got trap code %d.\n",   \
+            jb.trap);                                            \
+    }                                                            \
+  } while (0)
+
+#define ASSERT_RETURN(f)                           \
+  do {                                             \
+    g_tests_run++;                                 \
+    wasm_rt_jmp_buf jb;                            \
+    wasm_rt_try(jb) {                              \
+      f;                                           \
+      wasm_rt_end_try(jb);                         \
+      g_tests_passed++;                            \
+    } else {                                       \
+      error(__FILE__, __LINE__, #f " trapped.\n"); \
+    }                                              \
+  } while (0)
+
+#define ASSERT_RETURN_T(type, fmt, f, expected)                          \
+  do {                                                                   \
+    g_tests_run++;                                                       \
+    wasm_rt_jmp_buf jb;                                                  \
+    wasm_rt_try(jb) {                                                    \
+      type actual = f;                                                   \
+      wasm_rt_end_try(jb);                                               \
+      if (is_equal_##type(actual, expected)) {                           \
+        g_tests_passed++;                                                \
+      } else {                                                           \
+        error(__FILE__, __LINE__,                                        \
+              "in " #f ": expected %" fmt ", got %" fmt ".\n", expected, \
+              actual);                                                   \
+      }                                                                  \
+    } else {                                                             \
+      error(__FILE__, __LINE__, #f " trapped.\n");                       \
+    }                                                                    \
+  } while (0)
+
+#define ASSERT_RETURN_NAN_T(type, itype, fmt, f, kind)                        \
+  do {                                                                        \
+    g_tests_run++;                                                            \
+    wasm_rt_jmp_buf jb;                                                       \
+    wasm_rt_try(jb) {                                                         \
+      type actual = f;                                                        \
+      wasm_rt_end_try(jb);                                                    \
+      itype iactual;                                                          \
+      memcpy(&iactual, &actual, sizeof(iactual));                             \
+      if (is_##kind##_nan_##type(iactual)) {                                  \
+        g_tests_passed++;                                                     \
+      } else {                                                                \
+        error(__FILE__, __LINE__,                                             \
+              "in " #f ": expected result to be a " #kind " nan, got 0x%" fmt \
+              ".\n",                                                          \
+              iactual);                                                       \
+      }                                                                       \
+    } else {                                                                  \
+      error(__FILE__, __LINE__, #f " trapped.\n");                            \
+    }                                                                         \
+  } while (0)
+
+#define ASSERT_RETURN_V128(f, expected)                                   \
+  do {                                                                    \
+    g_tests_run++;                                                        \
+    wasm_rt_jmp_buf jb;                                                   \
+    wasm_rt_try(jb) {                                                     \
+      v128 actual = f;                                                    \
+      wasm_rt_end_try(jb);                                                \
+      v128 expected_ = expected;                                          \
+      if (memcmp(&actual, &expected_, sizeof(actual)) == 0) {             \
+        g_tests_passed++;                                                 \
+      } else {                                                            \
+        u64 a[2], e[2];                                                   \
+        memcpy(a, &actual, sizeof(a));                                    \
+        memcpy(e, &expected_, sizeof(e));                                 \
+        error(__FILE__, __LINE__,                                         \
+              "in " #f ": expected 0x%016" PRIx64 "%016" PRIx64           \
+              ", got 0x%016" PRIx64 "%016" PRIx64 ".\n",                  \
+              e[1], e[0], a[1], a[0]);                                    \
+      }                                                                   \
+    } else {                                                              \
+      error(__FILE__, __LINE__, #f " trapped.\n");                        \
+    }                                                                     \
+  } while (0)
+
+/* For the checks of the --driver files, which don't call into the sandbox. */
+#define ASSERT_TRUE(cond)                                         \
+  do {                                                            \
+    g_tests_run++;                                                \
+    if (cond) {                                                   \
+      g_tests_passed++;                                           \
+    } else {                                                      \
+      error(__FILE__, __LINE__, "expected " #cond " to hold.\n"); \
+    }                                                             \
+  } while (0)
+
+#define ASSERT_RETURN_I32(f, expected) ASSERT_RETURN_T(u32, "u", f, expected)
+#define ASSERT_RETURN_I64(f, expected) ASSERT_RETURN_T(u64, PRIu64, f, expected)
+#define ASSERT_RETURN_F32(f, expected) ASSERT_RETURN_T(f32, ".9g", f, expected)
+#define ASSERT_RETURN_F64(f, expected) ASSERT_RETURN_T(f64, ".17g", f, expected)
+
+#define ASSERT_RETURN_CANONICAL_NAN_F32(f) \
+  ASSERT_RETURN_NAN_T(f32, u32, "08x", f, canonical)
+#define ASSERT_RETURN_CANONICAL_NAN_F64(f) \
+  ASSERT_RETURN_NAN_T(f64, u64, "016x", f, canonical)
+#define ASSERT_RETURN_ARITHMETIC_NAN_F32(f) \
+  ASSERT_RETURN_NAN_T(f32, u32, "08x", f, arithmetic)
+#define ASSERT_RETURN_ARITHMETIC_NAN_F64(f) \
+  ASSERT_RETURN_NAN_T(f64, u64, "016x", f, arithmetic)
+
+static bool is_equal_u32(u32 x, u32 y) {
+  return x == y;
+}
+
+static bool is_equal_u64(u64 x, u64 y) {
+  return x == y;
+}
+
+#define is_equal_i32 is_equal_u32
+#define is_equal_i64 is_equal_u64
+
+static bool is_equal_f32(f32 x, f32 y) {
+  u32 ux, uy;
+  memcpy(&ux, &x, sizeof(ux));
+  memcpy(&uy, &y, sizeof(uy));
+  return ux == uy;
+}
+
+static bool is_equal_f64(f64 x, f64 y) {
+  u64 ux, uy;
+  memcpy(&ux, &x, sizeof(ux));
+  memcpy(&uy, &y, sizeof(uy));
+  return ux == uy;
+}
+
+static f32 make_nan_f32(u32 x) {
+  x |= 0x7f800000;
+  f32 res;
+  memcpy(&res, &x, sizeof(res));
+  return res;
+}
+
+static f64 make_nan_f64(u64 x) {
+  x |= 0x7ff0000000000000;
+  f64 res;
+  memcpy(&res, &x, sizeof(res));
+  return res;
+}
+
+static bool is_canonical_nan_f32(u32 x) {
+  return (x & 0x7fffffff) == 0x7fc00000;
+}
+
+static bool is_canonical_nan_f64(u64 x) {
+  return (x & 0x7fffffffffffffff) == 0x7ff8000000000000;
+}
+
+static bool is_arithmetic_nan_f32(u32 x) {
+  return (x & 0x7fc00000) == 0x7fc00000;
+}
+
+static bool is_arithmetic_nan_f64(u64 x) {
+  return (x & 0x7ff8000000000000) == 0x7ff8000000000000;
+}
+
+
+static v128 make_v128(u64 lo, u64 hi) {
+  u64 halves[2] = {lo, hi};
+  v128 res;
+  memcpy(&res, halves, sizeof(res));
+  return res;
+}
+
+int main(int argc, char** argv) {
+  run_spec_tests();
+  /* run-spec-wasm2c.py adds up the counts of all modules, and fails the test
+   * if they differ. */
+  printf("%u/%u tests passed.\n", g_tests_passed, g_tests_run);
+  return 0;
+}
+
+/* Looks up every memory, table, global and function of export-lookup.txt, and
+ * names that aren't exports. */
+
+static u32 func_type_of(wasm2c_sandbox_funcs_t* funcs,
+                        wasm2c_sandbox_t* sbx,
+                        const char* name) {
+  u32 func_type = 0;
+  funcs->lookup_wasm2c_func_export(sbx, name, &func_type);
+  return func_type;
+}
+
+static void run_driver_tests(wasm2c_sandbox_funcs_t* funcs,
+                             wasm2c_sandbox_t* sbx) {
+  wasm_rt_memory_t* mem =
+      (wasm_rt_memory_t*)funcs->lookup_wasm2c_nonfunc_export(sbx, "w2c_mem");
+  ASSERT_TRUE(mem && mem->pages == 1);
+  if (mem) {
+    u64 value = 0x0102030405060708ull;
+    w2c_store(sbx, 8, value);
+    ASSERT_TRUE(memcmp(mem->data + 8, &value, sizeof(value)) == 0);
+  }
+
+  wasm_rt_table_t* table =
+      (wasm_rt_table_t*)funcs->lookup_wasm2c_nonfunc_export(sbx, "w2c_T0");
+  ASSERT_TRUE(table && table->size == 2);
+
+  u32* counter = (u32*)funcs->lookup_wasm2c_nonfunc_export(sbx, "w2c_counter");
+  ASSERT_TRUE(counter && *counter == 7);
+  u64* big = (u64*)funcs->lookup_wasm2c_nonfunc_export(sbx, "w2c_big");
+  ASSERT_TRUE(big && *big == 0x123456789ull);
+  f64* half = (f64*)funcs->lookup_wasm2c_nonfunc_export(sbx, "w2c_half");
+  ASSERT_TRUE(half && *half == 0.5);
+
+  /* Globals that aren't exported are found by their C name too, and writing
+   * through the pointer changes what the code reads. */
+  u32* hidden = (u32*)funcs->lookup_wasm2c_nonfunc_export(sbx, "w2c_g3");
+  ASSERT_TRUE(hidden && *hidden == 3);
+  if (hidden) {
+    *hidden = 9;
+    ASSERT_RETURN_I32(w2c_get_hidden(sbx), 9u);
+  }
+
+  wasm_rt_type_t i32_i32_to_i32[] = {WASM_RT_I32, WASM_RT_I32, WASM_RT_I32};
+  wasm_rt_type_t i32_i64[] = {WASM_RT_I32, WASM_RT_I64};
+  wasm_rt_type_t to_i32[] = {WASM_RT_I32};
+  ASSERT_TRUE(funcs->lookup_wasm2c_func_export(sbx, "w2c_add", NULL) ==
+              (wasm_rt_anyfunc_t)&w2c_add);
+  ASSERT_TRUE(func_type_of(funcs, sbx, "w2c_add") ==
+              funcs->lookup_wasm2c_func_index(sbx, 2, 1, i32_i32_to_i32));
+  ASSERT_TRUE(funcs->lookup_wasm2c_func_export(sbx, "w2c_store", NULL) ==
+              (wasm_rt_anyfunc_t)&w2c_store);
+  ASSERT_TRUE(func_type_of(funcs, sbx, "w2c_store") ==
+              funcs->lookup_wasm2c_func_index(sbx, 2, 0, i32_i64));
+  ASSERT_TRUE(funcs->lookup_wasm2c_func_export(sbx, "w2c_nop", NULL) ==
+              (wasm_rt_anyfunc_t)&w2c_nop);
+  ASSERT_TRUE(func_type_of(funcs, sbx, "w2c_nop") ==
+              funcs->lookup_wasm2c_func_index(sbx, 0, 0, NULL));
+  ASSERT_TRUE(funcs->lookup_wasm2c_func_export(sbx, "w2c_get_hidden", NULL) ==
+              (wasm_rt_anyfunc_t)&w2c_get_hidden);
+  ASSERT_TRUE(funcs->lookup_wasm2c_func_export(sbx, "w2c_f0", NULL) ==
+              (wasm_rt_anyfunc_t)&w2c_f0);
+  ASSERT_TRUE(func_type_of(funcs, sbx, "w2c_f0") ==
+              funcs->lookup_wasm2c_func_index(sbx, 0, 1, to_i32));
+
+  /* Each lookup only finds its own kind of export. */
+  ASSERT_TRUE(!funcs->lookup_wasm2c_nonfunc_export(sbx, "w2c_add"));
+  ASSERT_TRUE(!funcs->lookup_wasm2c_func_export(sbx, "w2c_mem", NULL));
+  ASSERT_TRUE(!funcs->lookup_wasm2c_func_export(sbx, "w2c_counter", NULL));
+
+  /* Unknown names, including prefixes and extensions of exports, and enough
+   * others that some of them hash to every slot. */
+  static const char* const unknown[] = {
+      "", "w2c_", "w2c_ad", "w2c_addd", "add", "mem", "w2c_T1", "w2c_g4",
+  };
+  bool none_found = true;
+  for (size_t i = 0; i < sizeof(unknown) / sizeof(unknown[0]); i++) {
+    if (funcs->lookup_wasm2c_nonfunc_export(sbx, unknown[i]) ||
+        funcs->lookup_wasm2c_func_export(sbx, unknown[i], NULL)) {
+      error(__FILE__, __LINE__, "found unknown export \"%s\".\n", unknown[i]);
+      none_found = false;
+    }
+  }
+  for (u32 i = 0; i < 1000; i++) {
+    char name[32];
+    snprintf(name, sizeof(name), "w2c_x%u", i);
+    if (funcs->lookup_wasm2c_nonfunc_export(sbx, name) ||
+        funcs->lookup_wasm2c_func_export(sbx, name, NULL)) {
+      error(__FILE__, __LINE__, "found unknown export \"%s\".\n", name);
+      none_found = false;
+    }
+  }
+  ASSERT_TRUE(none_found);
+}
+
+
+static void run_spec_tests(void) {
+  wasm2c_sandbox_funcs_t funcs = get_wasm2c_sandbox_info();
+  if (!funcs.wasm_rt_sys_init()) {
+    error(__FILE__, __LINE__, "could not install the fault handler.\n");
+    g_tests_run++;
+    return;
+  }
+  wasm2c_sandbox_t* sbx = (wasm2c_sandbox_t*)funcs.create_wasm2c_sandbox(0);
+  if (!sbx) {
+    error(__FILE__, __LINE__, "could not create the sandbox.\n");
+    g_tests_run++;
+    return;
+  }
+
+  // export-lookup.txt:18
+  ASSERT_RETURN_I32(w2c_add(sbx, 1u, 2u), 3u);
+
+  // export-lookup.txt:19
+  ASSERT_RETURN_I32(*(u32*)funcs.lookup_wasm2c_nonfunc_export(sbx, "w2c_counter"), 7u);
+
+  run_driver_tests(&funcs, sbx);
+  funcs.destroy_wasm2c_sandbox(sbx);
+}
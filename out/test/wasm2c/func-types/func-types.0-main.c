@@ -0,0 +1,359 @@
+#include "func-types.0.h"
+#include <assert.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wasm-rt.h"
+
+static int g_tests_run;
+static int g_tests_passed;
+
+static void run_spec_tests(void);
+
+static void error(const char* file, int line, const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  fprintf(stderr, "%s:%d: assertion failed: ", file, line);
+  vfprintf(stderr, format, args);
+  va_end(args);
+}
+
+#define ASSERT_TRAP(f)                                           \
+  do {                                                           \
+    g_tests_run++;                                               \
+    wasm_rt_jmp_buf jb;                                          \
+    wasm_rt_try(jb) {                                            \
+      (void)(f);                                                 \
+      wasm_rt_end_try(jb);                                       \
+      error(__FILE__, __LINE__, "expected " #f " to trap.\n");   \
+    } else {                                                     \
+      g_tests_passed++;                                          \
+    }                                                            \
+  } while (0)
+
+#define ASSERT_EXHAUSTION(f)                                     \
+  do {                                                           \
+    g_tests_run++;                                               \
+    wasm_rt_jmp_buf jb;                                          \
+    wasm_rt_try(jb) {                                            \
+      (void)(f);                                                 \
+      wasm_rt_end_try(jb);                                       \
+      error(__FILE__, __LINE__, "expected " #f " to trap.\n");   \
+    } else if (jb.trap == WASM_RT_TRAP_EXHAUSTION) {             \
+      g_tests_passed++;                                          \
+    } else {                                                     \
+      error(__FILE__, __LINE__,                                  \
+            "expected " #f                                       \
+            " to trap due to exhaustion, got trap code %d.\n",   \
+            jb.trap);                                            \
+    }                                                            \
+  } while (0)
+
+#define ASSERT_RETURN(f)                           \
+  do {                                             \
+    g_tests_run++;                                 \
+    wasm_rt_jmp_buf jb;                            \
+    wasm_rt_try(jb) {                              \
+      f;                                           \
+      wasm_rt_end_try(jb);                         \
+      g_tests_passed++;                            \
+    } else {                                       \
+      error(__FILE__, __LINE__, #f " trapped.\n"); \
+    }                                              \
+  } while (0)
+
+#define ASSERT_RETURN_T(type, fmt, f, expected)                          \
+  do {                                                                   \
+    g_tests_run++;                                                       \
+    wasm_rt_jmp_buf jb;                                                  \
+    wasm_rt_try(jb) {                                                    \
+      type actual = f;                                                   \
+      wasm_rt_end_try(jb);                                               \
+      if (is_equal_##type(actual, expected)) {                           \
+        g_tests_passed++;                                                \
+      } else {                                                           \
+        error(__FILE__, __LINE__,                                        \
+              "in " #f ": expected %" fmt ", got %" fmt ".\n", expected, \
+              actual);                                                   \
+      }                                                                  \
+    } else {                                                             \
+      error(__FILE__, __LINE__, #f " trapped.\n");                       \
+    }                                                                    \
+  } while (0)
+
+#define ASSERT_RETURN_NAN_T(type, itype, fmt, f, kind)                        \
+  do {                                                                        \
+    g_tests_run++;                                                            \
+    wasm_rt_jmp_buf jb;                                                       \
+    wasm_rt_try(jb) {                                                         \
+      type actual = f;                                                        \
+      wasm_rt_end_try(jb);                                                    \
+      itype iactual;                                                          \
+      memcpy(&iactual, &actual, sizeof(iactual));                             \
+      if (is_##kind##_nan_##type(iactual)) {                                  \
+        g_tests_passed++;                                                     \
+      } else {                                                                \
+        error(__FILE__, __LINE__,                                             \
+              "in " #f ": expected result to be a " #kind " nan, got 0x%" fmt \
+              ".\n",                                                          \
+              iactual);                                                       \
+      }                                                                       \
+    } else {                                                                  \
+      error(__FILE__, __LINE__, #f " trapped.\n");                            \
+    }                                                                         \
+  } while (0)
+
+#define ASSERT_RETURN_V128(f, expected)                                   \
+  do {                                                                    \
+    g_tests_run++;                                                        \
+    wasm_rt_jmp_buf jb;                                                   \
+    wasm_rt_try(jb) {                                                     \
+      v128 actual = f;                                                    \
+      wasm_rt_end_try(jb);                                                \
+      v128 expected_ = expected;                                          \
+      if (memcmp(&actual, &expected_, sizeof(actual)) == 0) {             \
+        g_tests_passed++;                                                 \
+      } else {                                                            \
+        u64 a[2], e[2];                                                   \
+        memcpy(a, &actual, sizeof(a));                                    \
+        memcpy(e, &expected_, sizeof(e));                                 \
+        error(__FILE__, __LINE__,                                         \
+              "in " #f ": expected 0x%016" PRIx64 "%016" PRIx64           \
+              ", got 0x%016" PRIx64 "%016" PRIx64 ".\n",                  \
+              e[1], e[0], a[1], a[0]);                                    \
+      }                                                                   \
+    } else {                                                              \
+      error(__FILE__, __LINE__, #f " trapped.\n");                        \
+    }                                                                     \
+  } while (0)
+
+/* For the checks of the --driver files, which don't call into the sandbox. */
+#define ASSERT_TRUE(cond)                                         \
+  do {                                                            \
+    g_tests_run++;                                                \
+    if (cond) {                                                   \
+      g_tests_passed++;                                           \
+    } else {                                                      \
+      error(__FILE__, __LINE__, "expected " #cond " to hold.\n"); \
+    }                                                             \
+  } while (0)
+
+#define ASSERT_RETURN_I32(f, expected) ASSERT_RETURN_T(u32, "u", f, expected)
+#define ASSERT_RETURN_I64(f, expected) ASSERT_RETURN_T(u64, PRIu64, f, expected)
+#define ASSERT_RETURN_F32(f, expected) ASSERT_RETURN_T(f32, ".9g", f, expected)
+#define ASSERT_RETURN_F64(f, expected) ASSERT_RETURN_T(f64, ".17g", f, expected)
+
+#define ASSERT_RETURN_CANONICAL_NAN_F32(f) \
+  ASSERT_RETURN_NAN_T(f32, u32, "08x", f, canonical)
+#define ASSERT_RETURN_CANONICAL_NAN_F64(f) \
+  ASSERT_RETURN_NAN_T(f64, u64, "016x", f, canonical)
+#define ASSERT_RETURN_ARITHMETIC_NAN_F32(f) \
+  ASSERT_RETURN_NAN_T(f32, u32, "08x", f, arithmetic)
+#define ASSERT_RETURN_ARITHMETIC_NAN_F64(f) \
+  ASSERT_RETURN_NAN_T(f64, u64, "016x", f, arithmetic)
+
+static bool is_equal_u32(u32 x, u32 y) {
+  return x == y;
+}
+
+static bool is_equal_u64(u64 x, u64 y) {
+  return x == y;
+}
+
+#define is_equal_i32 is_equal_u32
+#define is_equal_i64 is_equal_u64
+
+static bool is_equal_f32(f32 x, f32 y) {
+  u32 ux, uy;
+  memcpy(&ux, &x, sizeof(ux));
+  memcpy(&uy, &y, sizeof(uy));
+  return ux == uy;
+}
+
+static bool is_equal_f64(f64 x, f64 y) {
+  u64 ux, uy;
+  memcpy(&ux, &x, sizeof(ux));
+  memcpy(&uy, &y, sizeof(uy));
+  return ux == uy;
+}
+
+static f32 make_nan_f32(u32 x) {
+  x |= 0x7f800000;
+  f32 res;
+  memcpy(&res, &x, sizeof(res));
+  return res;
+}
+
+static f64 make_nan_f64(u64 x) {
+  x |= 0x7ff0000000000000;
+  f64 res;
+  memcpy(&res, &x, sizeof(res));
+  return res;
+}
+
+static bool is_canonical_nan_f32(u32 x) {
+  return (x & 0x7fffffff) == 0x7fc00000;
+}
+
+static bool is_canonical_nan_f64(u64 x) {
+  return (x & 0x7fffffffffffffff) == 0x7ff8000000000000;
+}
+
+static bool is_arithmetic_nan_f32(u32 x) {
+  return (x & 0x7fc00000) == 0x7fc00000;
+}
+
+static bool is_arithmetic_nan_f64(u64 x) {
+  return (x & 0x7ff8000000000000) == 0x7ff8000000000000;
+}
+
+
+static v128 make_v128(u64 lo, u64 hi) {
+  u64 halves[2] = {lo, hi};
+  v128 res;
+  memcpy(&res, halves, sizeof(res));
+  return res;
+}
+
+int main(int argc, char** argv) {
+  run_spec_tests();
+  /* run-spec-wasm2c.py adds up the counts of all modules, and fails the test
+   * if they differ. */
+  printf("%u/%u tests passed.\n", g_tests_passed, g_tests_run);
+  return 0;
+}
+
+/* Function types get the same index for the same signature, however and from
+ * whichever thread they are registered. Small signatures are encoded in the
+ * index itself, larger ones are numbered by the registry. */
+
+#include <pthread.h>
+
+#define SIGNATURE_COUNT 200
+#define THREAD_COUNT 8
+
+/* Nine params, which is too many for an inline index, whose types spell out
+ * `n` in base 4. */
+static void make_signature(u32 n, wasm_rt_type_t* types) {
+  for (u32 i = 0; i < 9; i++) {
+    types[i] = (wasm_rt_type_t)(n % 4);
+    n /= 4;
+  }
+  types[9] = WASM_RT_I32;
+}
+
+static u32 g_thread_ids[THREAD_COUNT][SIGNATURE_COUNT];
+
+static void* register_in_thread(void* arg) {
+  u32* ids = g_thread_ids[(size_t)arg];
+  for (u32 i = 0; i < SIGNATURE_COUNT; i++) {
+    /* Threads go through the signatures in different orders. */
+    u32 n = (i * 7 + (u32)(size_t)arg * 31) % SIGNATURE_COUNT;
+    wasm_rt_type_t types[10];
+    make_signature(n, types);
+    ids[n] = wasm_rt_register_func_type(9, 1, types);
+  }
+  return NULL;
+}
+
+static void run_driver_tests(wasm2c_sandbox_funcs_t* funcs,
+                             wasm2c_sandbox_t* sbx) {
+  wasm_rt_type_t i32_f32_to_i64[] = {WASM_RT_I32, WASM_RT_F32, WASM_RT_I64};
+  wasm_rt_type_t to_i64[] = {WASM_RT_I64};
+  ASSERT_TRUE(wasm_rt_register_func_type(2, 1, i32_f32_to_i64) == 0xa4000050u);
+  ASSERT_TRUE(wasm_rt_register_func_type(0, 1, to_i64) == 0x84000001u);
+  ASSERT_TRUE(wasm_rt_register_func_type(0, 0, NULL) == 0x80000000u);
+
+  /* The module's function types are the registered ones. */
+  wasm_rt_type_t many[10];
+  for (u32 i = 0; i < 9; i++) {
+    many[i] = WASM_RT_I32;
+  }
+  many[9] = WASM_RT_I64;
+  u32 many_id = wasm_rt_register_func_type(9, 1, many);
+  ASSERT_TRUE(many_id != 0 && !(many_id & WASM_RT_INLINE_FUNC_TYPE_BIT));
+  ASSERT_TRUE(funcs->lookup_wasm2c_func_index(sbx, 9, 1, many) == many_id);
+  u32 func_type = 0;
+  funcs->lookup_wasm2c_func_export(sbx, "w2c_many", &func_type);
+  ASSERT_TRUE(func_type == many_id);
+  func_type = 0;
+  funcs->lookup_wasm2c_func_export(sbx, "w2c_mixed", &func_type);
+  ASSERT_TRUE(func_type == wasm_rt_register_func_type(2, 1, i32_f32_to_i64));
+  wasm2c_sandbox_t* other = (wasm2c_sandbox_t*)funcs->create_wasm2c_sandbox(0);
+  if (other) {
+    func_type = 0;
+    funcs->lookup_wasm2c_func_export(other, "w2c_many", &func_type);
+    ASSERT_TRUE(func_type == many_id);
+    funcs->destroy_wasm2c_sandbox(other);
+  }
+
+  /* The signature is copied, and a different signature gets a different
+   * index. */
+  many[9] = WASM_RT_F64;
+  u32 other_id = wasm_rt_register_func_type(9, 1, many);
+  ASSERT_TRUE(other_id != 0 && other_id != many_id);
+  many[9] = WASM_RT_I64;
+  ASSERT_TRUE(wasm_rt_register_func_type(9, 1, many) == many_id);
+
+  /* Registering a list fills in the ids once. */
+  wasm_rt_func_sig_t sigs[] = {
+      {2, 1, i32_f32_to_i64},
+      {9, 1, many},
+  };
+  u32 ids[2] = {0, 0};
+  wasm_rt_register_func_types(sigs, 2, ids);
+  ASSERT_TRUE(ids[0] == 0xa4000050u && ids[1] == many_id);
+  wasm_rt_register_func_types(sigs, 2, ids);
+  ASSERT_TRUE(ids[0] == 0xa4000050u && ids[1] == many_id);
+
+  /* Threads that register the same signatures at once agree on their
+   * indices, which are all different. */
+  pthread_t threads[THREAD_COUNT];
+  for (size_t i = 0; i < THREAD_COUNT; i++) {
+    pthread_create(&threads[i], NULL, register_in_thread, (void*)i);
+  }
+  for (size_t i = 0; i < THREAD_COUNT; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  bool agree = true;
+  for (u32 n = 0; n < SIGNATURE_COUNT; n++) {
+    for (size_t i = 1; i < THREAD_COUNT; i++) {
+      agree = agree && g_thread_ids[i][n] == g_thread_ids[0][n];
+    }
+    for (u32 m = 0; m < n; m++) {
+      agree = agree && g_thread_ids[0][m] != g_thread_ids[0][n];
+    }
+    agree = agree && g_thread_ids[0][n] != 0 &&
+            !(g_thread_ids[0][n] & WASM_RT_INLINE_FUNC_TYPE_BIT);
+  }
+  ASSERT_TRUE(agree);
+}
+
+
+static void run_spec_tests(void) {
+  wasm2c_sandbox_funcs_t funcs = get_wasm2c_sandbox_info();
+  if (!funcs.wasm_rt_sys_init()) {
+    error(__FILE__, __LINE__, "could not install the fault handler.\n");
+    g_tests_run++;
+    return;
+  }
+  wasm2c_sandbox_t* sbx = (wasm2c_sandbox_t*)funcs.create_wasm2c_sandbox(0);
+  if (!sbx) {
+    error(__FILE__, __LINE__, "could not create the sandbox.\n");
+    g_tests_run++;
+    return;
+  }
+
+  // func-types.txt:13
+  ASSERT_RETURN_I64(w2c_many(sbx, 1u, 2u, 3u, 4u, 5u, 6u, 7u, 8u, 9u), 9ull);
+
+  run_driver_tests(&funcs, sbx);
+  funcs.destroy_wasm2c_sandbox(sbx);
+}
@@ -0,0 +1,374 @@
+#include "memory-pool.0.h"
+#include <assert.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wasm-rt.h"
+
+static int g_tests_run;
+static int g_tests_passed;
+
+static void run_spec_tests(void);
+
+static void error(const char* file, int line, const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  fprintf(stderr, "%s:%d: assertion failed: ", file, line);
+  vfprintf(stderr, format, args);
+  va_end(args);
+}
+
+#define ASSERT_TRAP(f)                                           \
+  do {                                                           \
+    g_tests_run++;                                               \
+    wasm_rt_jmp_buf jb;                                          \
+    wasm_rt_try(jb) {                                            \
+      (void)(f);                                                 \
+      wasm_rt_end_try(jb);                                       \
+      error(__FILE__, __LINE__, "expected " #f " to trap.\n");   \
+    } else {                                                     \
+      g_tests_passed++;                                          \
+    }                                                            \
+  } while (0)
+
+#define ASSERT_EXHAUSTION(f)                                     \
+  do {                                                           \
+    g_tests_run++;                                               \
+    wasm_rt_jmp_buf jb;                                          \
+    wasm_rt_try(jb) {                                            \
+      (void)(f);                                                 \
+      wasm_rt_end_try(jb);                                       \
+      error(__FILE__, __LINE__, "expected " #f " to trap.\n");   \
+    } else if (jb.trap == WASM_RT_TRAP_EXHAUSTION) {             \
+      g_tests_passed++;                                          \
+    } else {                                                     \
+      error(__FILE__, __LINE__,                                  \
+            "expected " #f                                       \
+            " to trap due to exhaustion, got trap code %d.\n",   \
+            jb.trap);                                            \
+    }                                                            \
+  } while (0)
+
+#define ASSERT_RETURN(f)                           \
+  do {                                             \
+    g_tests_run++;                                 \
+    wasm_rt_jmp_buf jb;                            \
+    wasm_rt_try(jb) {                              \
+      f;                                           \
+      wasm_rt_end_try(jb);                         \
+      g_tests_passed++;                            \
+    } else {                                       \
+      error(__FILE__, __LINE__, #f " trapped.\n"); \
+    }                                              \
+  } while (0)
+
+#define ASSERT_RETURN_T(type, fmt, f, expected)                          \
+  do {                                                                   \
+    g_tests_run++;                                                       \
+    wasm_rt_jmp_buf jb;                                                  \
+    wasm_rt_try(jb) {                                                    \
+      type actual = f;                                                   \
+      wasm_rt_end_try(jb);                                               \
+      if (is_equal_##type(actual, expected)) {                           \
+        g_tests_passed++;                                                \
+      } else {                                                           \
+        error(__FILE__, __LINE__,                                        \
+              "in " #f ": expected %" fmt ", got %" fmt ".\n", expected, \
+              actual);                                                   \
+      }                                                                  \
+    } else {                                                             \
+      error(__FILE__, __LINE__, #f " trapped.\n");                       \
+    }                                                                    \
+  } while (0)
+
+#define ASSERT_RETURN_NAN_T(type, itype, fmt, f, kind)                        \
+  do {                                                                        \
+    g_tests_run++;                                                            \
+    wasm_rt_jmp_buf jb;                                                       \
+    wasm_rt_try(jb) {                                                         \
+      type actual = f;                                                        \
+      wasm_rt_end_try(jb);                                                    \
+      itype iactual;                                                          \
+      memcpy(&iactual, &actual, sizeof(iactual));                             \
+      if (is_##kind##_nan_##type(iactual)) {                                  \
+        g_tests_passed++;                                                     \
+      } else {                                                                \
+        error(__FILE__, __LINE__,                                             \
+              "in " #f ": expected result to be a " #kind " nan, got 0x%" fmt \
+              ".\n",                                                          \
+              iactual);                                                       \
+      }                                                                       \
+    } else {                                                                  \
+      error(__FILE__, __LINE__, #f " trapped.\n");                            \
+    }                                                                         \
+  } while (0)
+
+#define ASSERT_RETURN_V128(f, expected)                                   \
+  do {                                                                    \
+    g_tests_run++;                                                        \
+    wasm_rt_jmp_buf jb;                                                   \
+    wasm_rt_try(jb) {                                                     \
+      v128 actual = f;                                                    \
+      wasm_rt_end_try(jb);                                                \
+      v128 expected_ = expected;                                          \
+      if (memcmp(&actual, &expected_, sizeof(actual)) == 0) {             \
+        g_tests_passed++;                                                 \
+      } else {                                                            \
+        u64 a[2], e[2];                                                   \
+        memcpy(a, &actual, sizeof(a));                                    \
+        memcpy(e, &expected_, sizeof(e));                                 \
+        error(__FILE__, __LINE__,                                         \
+              "in " #f ": expected 0x%016" PRIx64 "%016" PRIx64           \
+              ", got 0x%016" PRIx64 "%016" PRIx64 ".\n",                  \
+              e[1], e[0], a[1], a[0]);                                    \
+      }                                                                   \
+    } else {                                                              \
+      error(__FILE__, __LINE__, #f " trapped.\n");                        \
+    }                                                                     \
+  } while (0)
+
+/* For the checks of the --driver files, which don't call into the sandbox. */
+#define ASSERT_TRUE(cond)                                         \
+  do {                                                            \
+    g_tests_run++;                                                \
+    if (cond) {                                                   \
+      g_tests_passed++;                                           \
+    } else {                                                      \
+      error(__FILE__, __LINE__, "expected " #cond " to hold.\n"); \
+    }                                                             \
+  } while (0)
+
+#define ASSERT_RETURN_I32(f, expected) ASSERT_RETURN_T(u32, "u", f, expected)
+#define ASSERT_RETURN_I64(f, expected) ASSERT_RETURN_T(u64, PRIu64, f, expected)
+#define ASSERT_RETURN_F32(f, expected) ASSERT_RETURN_T(f32, ".9g", f, expected)
+#define ASSERT_RETURN_F64(f, expected) ASSERT_RETURN_T(f64, ".17g", f, expected)
+
+#define ASSERT_RETURN_CANONICAL_NAN_F32(f) \
+  ASSERT_RETURN_NAN_T(f32, u32, "08x", f, canonical)
+#define ASSERT_RETURN_CANONICAL_NAN_F64(f) \
+  ASSERT_RETURN_NAN_T(f64, u64, "016x", f, canonical)
+#define ASSERT_RETURN_ARITHMETIC_NAN_F32(f) \
+  ASSERT_RETURN_NAN_T(f32, u32, "08x", f, arithmetic)
+#define ASSERT_RETURN_ARITHMETIC_NAN_F64(f) \
+  ASSERT_RETURN_NAN_T(f64, u64, "016x", f, arithmetic)
+
+static bool is_equal_u32(u32 x, u32 y) {
+  return x == y;
+}
+
+static bool is_equal_u64(u64 x, u64 y) {
+  return x == y;
+}
+
+#define is_equal_i32 is_equal_u32
+#define is_equal_i64 is_equal_u64
+
+static bool is_equal_f32(f32 x, f32 y) {
+  u32 ux, uy;
+  memcpy(&ux, &x, sizeof(ux));
+  memcpy(&uy, &y, sizeof(uy));
+  return ux == uy;
+}
+
+static bool is_equal_f64(f64 x, f64 y) {
+  u64 ux, uy;
+  memcpy(&ux, &x, sizeof(ux));
+  memcpy(&uy, &y, sizeof(uy));
+  return ux == uy;
+}
+
+static f32 make_nan_f32(u32 x) {
+  x |= 0x7f800000;
+  f32 res;
+  memcpy(&res, &x, sizeof(res));
+  return res;
+}
+
+static f64 make_nan_f64(u64 x) {
+  x |= 0x7ff0000000000000;
+  f64 res;
+  memcpy(&res, &x, sizeof(res));
+  return res;
+}
+
+static bool is_canonical_nan_f32(u32 x) {
+  return (x & 0x7fffffff) == 0x7fc00000;
+}
+
+static bool is_canonical_nan_f64(u64 x) {
+  return (x & 0x7fffffffffffffff) == 0x7ff8000000000000;
+}
+
+static bool is_arithmetic_nan_f32(u32 x) {
+  return (x & 0x7fc00000) == 0x7fc00000;
+}
+
+static bool is_arithmetic_nan_f64(u64 x) {
+  return (x & 0x7ff8000000000000) == 0x7ff8000000000000;
+}
+
+
+static v128 make_v128(u64 lo, u64 hi) {
+  u64 halves[2] = {lo, hi};
+  v128 res;
+  memcpy(&res, halves, sizeof(res));
+  return res;
+}
+
+int main(int argc, char** argv) {
+  run_spec_tests();
+  /* run-spec-wasm2c.py adds up the counts of all modules, and fails the test
+   * if they differ. */
+  printf("%u/%u tests passed.\n", g_tests_passed, g_tests_run);
+  return 0;
+}
+
+/* Sandboxes take their memory from the pool while it has free slots, and
+ * fall back to mapping it when it is exhausted. A slot is cleared when it is
+ * returned, and the pool can be used from several threads at once. */
+
+#include <pthread.h>
+
+static wasm_rt_memory_t* memory_of(wasm2c_sandbox_funcs_t* funcs,
+                                   wasm2c_sandbox_t* sbx) {
+  return (wasm_rt_memory_t*)funcs->lookup_wasm2c_nonfunc_export(sbx, "w2c_mem");
+}
+
+static u32 slots_in_use(void) {
+  wasm_rt_memory_pool_stats_t stats;
+  wasm_rt_get_memory_pool_stats(&stats);
+  return stats.slots_in_use;
+}
+
+static wasm2c_sandbox_funcs_t* g_funcs;
+static bool g_pool_created[8];
+
+static void* init_pool_in_thread(void* arg) {
+  g_pool_created[(size_t)arg] = wasm_rt_init_memory_pool(4);
+  return NULL;
+}
+
+static void* create_sandboxes_in_thread(void* arg) {
+  (void)arg;
+  for (u32 i = 0; i < 50; i++) {
+    wasm2c_sandbox_t* sbx = (wasm2c_sandbox_t*)g_funcs->create_wasm2c_sandbox(0);
+    if (!sbx) {
+      return (void*)1;
+    }
+    /* Every memory starts out cleared, however its slot was used before. */
+    if (w2c_load(sbx, 1024) != 0) {
+      return (void*)1;
+    }
+    w2c_store(sbx, 1024, i + 1);
+    g_funcs->destroy_wasm2c_sandbox(sbx);
+  }
+  return NULL;
+}
+
+static void run_driver_tests(wasm2c_sandbox_funcs_t* funcs,
+                             wasm2c_sandbox_t* sbx) {
+  g_funcs = funcs;
+  ASSERT_TRUE(!memory_of(funcs, sbx)->is_pooled);
+
+  ASSERT_TRUE(wasm_rt_init_memory_pool(2));
+  ASSERT_TRUE(!wasm_rt_init_memory_pool(2));
+  wasm_rt_memory_pool_stats_t stats;
+  wasm_rt_get_memory_pool_stats(&stats);
+  ASSERT_TRUE(stats.slot_count == 2 && stats.slots_in_use == 0);
+
+  wasm2c_sandbox_t* a = (wasm2c_sandbox_t*)funcs->create_wasm2c_sandbox(0);
+  wasm2c_sandbox_t* b = (wasm2c_sandbox_t*)funcs->create_wasm2c_sandbox(0);
+  wasm2c_sandbox_t* c = (wasm2c_sandbox_t*)funcs->create_wasm2c_sandbox(0);
+  if (!a || !b || !c) {
+    error(__FILE__, __LINE__, "could not create the sandboxes.\n");
+    return;
+  }
+  ASSERT_TRUE(memory_of(funcs, a)->is_pooled);
+  ASSERT_TRUE(memory_of(funcs, b)->is_pooled);
+  ASSERT_TRUE(!memory_of(funcs, c)->is_pooled);
+  wasm_rt_get_memory_pool_stats(&stats);
+  ASSERT_TRUE(stats.slots_in_use == 2 && stats.pool_allocations == 2 &&
+              stats.fallback_allocations == 1);
+
+  /* The pool can't be freed while its slots are in use. */
+  ASSERT_TRUE(!wasm_rt_free_memory_pool());
+
+  /* The slot of a is reused, without a's contents. */
+  u8* slot = memory_of(funcs, a)->data;
+  w2c_store(a, 1024, 42);
+  funcs->destroy_wasm2c_sandbox(a);
+  ASSERT_TRUE(slots_in_use() == 1);
+  wasm2c_sandbox_t* d = (wasm2c_sandbox_t*)funcs->create_wasm2c_sandbox(0);
+  ASSERT_TRUE(d && memory_of(funcs, d)->data == slot);
+  if (d) {
+    ASSERT_RETURN_I32(w2c_load(d, 1024), 0u);
+    /* Growing a pooled memory stays within its slot. */
+    ASSERT_RETURN_I32(w2c_grow(d, 3), 1u);
+    ASSERT_TRUE(memory_of(funcs, d)->data == slot);
+    ASSERT_RETURN(w2c_store(d, 4 * 65536 - 4, 7));
+    funcs->destroy_wasm2c_sandbox(d);
+  }
+  funcs->destroy_wasm2c_sandbox(b);
+  funcs->destroy_wasm2c_sandbox(c);
+  ASSERT_TRUE(slots_in_use() == 0);
+  ASSERT_TRUE(wasm_rt_free_memory_pool());
+  wasm_rt_get_memory_pool_stats(&stats);
+  ASSERT_TRUE(stats.slot_count == 0);
+
+  /* Only one of the threads that create the pool at once succeeds. */
+  pthread_t threads[8];
+  for (size_t i = 0; i < 8; i++) {
+    pthread_create(&threads[i], NULL, init_pool_in_thread, (void*)i);
+  }
+  u32 created = 0;
+  for (size_t i = 0; i < 8; i++) {
+    pthread_join(threads[i], NULL);
+    created += g_pool_created[i];
+  }
+  ASSERT_TRUE(created == 1);
+
+  /* More threads than slots create and destroy sandboxes at once. */
+  wasm_rt_get_memory_pool_stats(&stats);
+  u64 allocations = stats.pool_allocations + stats.fallback_allocations;
+  bool all_ok = true;
+  for (size_t i = 0; i < 8; i++) {
+    pthread_create(&threads[i], NULL, create_sandboxes_in_thread, NULL);
+  }
+  for (size_t i = 0; i < 8; i++) {
+    void* result;
+    pthread_join(threads[i], &result);
+    all_ok = all_ok && result == NULL;
+  }
+  ASSERT_TRUE(all_ok);
+  wasm_rt_get_memory_pool_stats(&stats);
+  ASSERT_TRUE(stats.slots_in_use == 0 &&
+              stats.pool_allocations + stats.fallback_allocations ==
+                  allocations + 400);
+  ASSERT_TRUE(wasm_rt_free_memory_pool());
+}
+
+
+static void run_spec_tests(void) {
+  wasm2c_sandbox_funcs_t funcs = get_wasm2c_sandbox_info();
+  if (!funcs.wasm_rt_sys_init()) {
+    error(__FILE__, __LINE__, "could not install the fault handler.\n");
+    g_tests_run++;
+    return;
+  }
+  wasm2c_sandbox_t* sbx = (wasm2c_sandbox_t*)funcs.create_wasm2c_sandbox(0);
+  if (!sbx) {
+    error(__FILE__, __LINE__, "could not create the sandbox.\n");
+    g_tests_run++;
+    return;
+  }
+
+  run_driver_tests(&funcs, sbx);
+  funcs.destroy_wasm2c_sandbox(sbx);
+}
@@ -0,0 +1,31 @@
+/* Automically generated by wasm2c */
+#include "num-outputs.0_impl.h"
+
+FUNC_EXPORT u32 w2c_f2(wasm2c_sandbox_t* const sbx, u32 w2c_p0, u32 w2c_p1) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0, w2c_i1;
+  w2c_i0 = w2c_p0;
+  w2c_i1 = w2c_p1;
+  CALL_INDIRECT_RES(w2c_i0, sbx->w2c_T0, u32 (*)(wasm2c_sandbox_t* const, u32), 0x94000000u, w2c_i1, sbx, w2c_i0);
+  FUNC_EPILOGUE;
+  return w2c_i0;
+}
+
+FUNC_EXPORT u32 w2c_double(wasm2c_sandbox_t* const sbx, u32 w2c_p0) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0;
+  w2c_i0 = w2c_p0;
+  w2c_i0 = w2c_f0(sbx, w2c_i0);
+  FUNC_EPILOGUE;
+  return w2c_i0;
+}
+
+FUNC_EXPORT u32 w2c_square_of_double(wasm2c_sandbox_t* const sbx, u32 w2c_p0) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0;
+  w2c_i0 = w2c_p0;
+  w2c_i0 = w2c_f0(sbx, w2c_i0);
+  w2c_i0 = w2c_f1(sbx, w2c_i0);
+  FUNC_EPILOGUE;
+  return w2c_i0;
+}
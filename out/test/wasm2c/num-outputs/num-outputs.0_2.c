@@ -0,0 +1,48 @@
+/* Automically generated by wasm2c */
+#include "num-outputs.0_impl.h"
+
+FUNC_EXPORT u32 w2c_apply(wasm2c_sandbox_t* const sbx, u32 w2c_p0, u32 w2c_p1) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0, w2c_i1;
+  w2c_i0 = w2c_p0;
+  w2c_i1 = w2c_p1;
+  w2c_i0 = w2c_f2(sbx, w2c_i0, w2c_i1);
+  FUNC_EPILOGUE;
+  return w2c_i0;
+}
+
+FUNC_EXPORT u32 w2c_load_data(wasm2c_sandbox_t* const sbx) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0;
+  w2c_i0 = 16u;
+  w2c_i0 = i32_load_unchecked(&(sbx->w2c_M0), (u64)(w2c_i0), WASM2C_SHADOW_FUNC_PROGRAM, "w2c_load_data");
+  FUNC_EPILOGUE;
+  return w2c_i0;
+}
+
+FUNC_EXPORT void w2c_store(wasm2c_sandbox_t* const sbx, u32 w2c_p0, u32 w2c_p1) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0, w2c_i1;
+  w2c_i0 = w2c_p0;
+  w2c_i1 = w2c_p1;
+  i32_store_cached(&(sbx->w2c_M0), sbx->w2c_M0.data, 65536ull, (u64)(w2c_i0), w2c_i1, WASM2C_SHADOW_FUNC_PROGRAM, "w2c_store");
+  FUNC_EPILOGUE;
+}
+
+FUNC_EXPORT u32 w2c_load(wasm2c_sandbox_t* const sbx, u32 w2c_p0) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0;
+  w2c_i0 = w2c_p0;
+  w2c_i0 = i32_load_cached(&(sbx->w2c_M0), sbx->w2c_M0.data, 65536ull, (u64)(w2c_i0), WASM2C_SHADOW_FUNC_PROGRAM, "w2c_load");
+  FUNC_EPILOGUE;
+  return w2c_i0;
+}
+
+FUNC_EXPORT u32 w2c_calls(wasm2c_sandbox_t* const sbx) {
+  u32 w2c_g0_cache = sbx->w2c_g0;
+  FUNC_PROLOGUE;
+  u32 w2c_i0;
+  w2c_i0 = w2c_g0_cache;
+  FUNC_EPILOGUE;
+  return w2c_i0;
+}
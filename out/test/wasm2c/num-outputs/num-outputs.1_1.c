@@ -0,0 +1,10 @@
+/* Automically generated by wasm2c */
+#include "num-outputs.1_impl.h"
+
+FUNC_EXPORT u32 w2c_answer(wasm2c_sandbox_t* const sbx) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0;
+  w2c_i0 = 42u;
+  FUNC_EPILOGUE;
+  return w2c_i0;
+}
@@ -0,0 +1,2 @@
+/* Automically generated by wasm2c */
+#include "num-outputs.1_impl.h"
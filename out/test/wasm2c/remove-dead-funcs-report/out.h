@@ -0,0 +1,74 @@
+#ifndef OUT_TEST_WASM2C_REMOVE_DEAD_FUNCS_REPORT_OUT_H_GENERATED_
+#define OUT_TEST_WASM2C_REMOVE_DEAD_FUNCS_REPORT_OUT_H_GENERATED_
+
+#define WASM_CURR_MODULE_PREFIX 
+/* Automically generated by wasm2c */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "wasm-rt.h"
+
+#ifndef WASM_RT_MODULE_PREFIX
+#define WASM_RT_MODULE_PREFIX
+#endif
+
+#define WASM_RT_PASTE_(x, y) x ## y
+#define WASM_RT_PASTE(x, y) WASM_RT_PASTE_(x, y)
+#define WASM_RT_ADD_PREFIX(x) WASM_RT_PASTE(WASM_RT_MODULE_PREFIX, x)
+
+#define WASM_CURR_ADD_PREFIX(x) WASM_RT_PASTE(WASM_CURR_MODULE_PREFIX, x)
+
+/* TODO(binji): only use stdint.h types in header */
+typedef uint8_t u8;
+typedef int8_t s8;
+typedef uint16_t u16;
+typedef int16_t s16;
+typedef uint32_t u32;
+typedef int32_t s32;
+typedef uint64_t u64;
+typedef int64_t s64;
+typedef float f32;
+typedef double f64;
+#if defined(__GNUC__) || defined(__clang__)
+/* Same layout as SSE's __m128i, so it can be passed to intrinsics with a cast. */
+typedef long long v128 __attribute__((vector_size(16)));
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+typedef __m128i v128;
+#else
+typedef struct { u64 lanes[2]; } v128;
+#endif
+
+#ifndef WASM_DONT_EXPORT_FUNCS
+# if defined(_WIN32)
+#   define FUNC_EXPORT __declspec(dllexport)
+# else
+#   define FUNC_EXPORT
+# endif
+#else
+# define FUNC_EXPORT
+#endif
+
+FUNC_EXPORT wasm2c_sandbox_funcs_t WASM_CURR_ADD_PREFIX(get_wasm2c_sandbox_info)();
+
+struct wasm2c_sandbox_t;
+typedef struct wasm2c_sandbox_t wasm2c_sandbox_t;
+
+FUNC_EXPORT void w2c_f0(wasm2c_sandbox_t* const);
+FUNC_EXPORT void w2c_f1(wasm2c_sandbox_t* const);
+FUNC_EXPORT u32 w2c_f2(wasm2c_sandbox_t* const);
+FUNC_EXPORT u32 w2c_f3(wasm2c_sandbox_t* const);
+FUNC_EXPORT u32 w2c_f4(wasm2c_sandbox_t* const, u32);
+FUNC_EXPORT u32 w2c_f5(wasm2c_sandbox_t* const);
+FUNC_EXPORT u32 w2c_started(wasm2c_sandbox_t* const);
+FUNC_EXPORT u32 w2c_via_elem(wasm2c_sandbox_t* const);
+FUNC_EXPORT u32 w2c_tail(wasm2c_sandbox_t* const, u32);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* OUT_TEST_WASM2C_REMOVE_DEAD_FUNCS_REPORT_OUT_H_GENERATED_ */
@@ -0,0 +1,357 @@
+#include "simd.0.h"
+#include <assert.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wasm-rt.h"
+
+static int g_tests_run;
+static int g_tests_passed;
+
+static void run_spec_tests(void);
+
+static void error(const char* file, int line, const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  fprintf(stderr, "%s:%d: assertion failed: ", file, line);
+  vfprintf(stderr, format, args);
+  va_end(args);
+}
+
+#define ASSERT_TRAP(f)                                           \
+  do {                                                           \
+    g_tests_run++;                                               \
+    wasm_rt_jmp_buf jb;                                          \
+    wasm_rt_try(jb) {                                            \
+      (void)(f);                                                 \
+      wasm_rt_end_try(jb);                                       \
+      error(__FILE__, __LINE__, "expected " #f " to trap.\n");   \
+    } else {                                                     \
+      g_tests_passed++;                                          \
+    }                                                            \
+  } while (0)
+
+#define ASSERT_EXHAUSTION(f)                                     \
+  do {                                                           \
+    g_tests_run++;                                               \
+    wasm_rt_jmp_buf jb;                                          \
+    wasm_rt_try(jb) {                                            \
+      (void)(f);                                                 \
+      wasm_rt_end_try(jb);                                       \
+      error(__FILE__, __LINE__, "expected " #f " to trap.\n");   \
+    } else if (jb.trap == WASM_RT_TRAP_EXHAUSTION) {             \
+      g_tests_passed++;                                          \
+    } else {                                                     \
+      error(__FILE__, __LINE__,                                  \
+            "expected " #f                                       \
+            " to trap due to exhaustion, got trap code %d.\n",   \
+            jb.trap);                                            \
+    }                                                            \
+  } while (0)
+
+#define ASSERT_RETURN(f)                           \
+  do {                                             \
+    g_tests_run++;                                 \
+    wasm_rt_jmp_buf jb;                            \
+    wasm_rt_try(jb) {                              \
+      f;                                           \
+      wasm_rt_end_try(jb);                         \
+      g_tests_passed++;                            \
+    } else {                                       \
+      error(__FILE__, __LINE__, #f " trapped.\n"); \
+    }                                              \
+  } while (0)
+
+#define ASSERT_RETURN_T(type, fmt, f, expected)                          \
+  do {                                                                   \
+    g_tests_run++;                                                       \
+    wasm_rt_jmp_buf jb;                                                  \
+    wasm_rt_try(jb) {                                                    \
+      type actual = f;                                                   \
+      wasm_rt_end_try(jb);                                               \
+      if (is_equal_##type(actual, expected)) {                           \
+        g_tests_passed++;                                                \
+      } else {                                                           \
+        error(__FILE__, __LINE__,                                        \
+              "in " #f ": expected %" fmt ", got %" fmt ".\n", expected, \
+              actual);                                                   \
+      }                                                                  \
+    } else {                                                             \
+      error(__FILE__, __LINE__, #f " trapped.\n");                       \
+    }                                                                    \
+  } while (0)
+
+#define ASSERT_RETURN_NAN_T(type, itype, fmt, f, kind)                        \
+  do {                                                                        \
+    g_tests_run++;                                                            \
+    wasm_rt_jmp_buf jb;                                                       \
+    wasm_rt_try(jb) {                                                         \
+      type actual = f;                                                        \
+      wasm_rt_end_try(jb);                                                    \
+      itype iactual;                                                          \
+      memcpy(&iactual, &actual, sizeof(iactual));                             \
+      if (is_##kind##_nan_##type(iactual)) {                                  \
+        g_tests_passed++;                                                     \
+      } else {                                                                \
+        error(__FILE__, __LINE__,                                             \
+              "in " #f ": expected result to be a " #kind " nan, got 0x%" fmt \
+              ".\n",                                                          \
+              iactual);                                                       \
+      }                                                                       \
+    } else {                                                                  \
+      error(__FILE__, __LINE__, #f " trapped.\n");                            \
+    }                                                                         \
+  } while (0)
+
+#define ASSERT_RETURN_V128(f, expected)                                   \
+  do {                                                                    \
+    g_tests_run++;                                                        \
+    wasm_rt_jmp_buf jb;                                                   \
+    wasm_rt_try(jb) {                                                     \
+      v128 actual = f;                                                    \
+      wasm_rt_end_try(jb);                                                \
+      v128 expected_ = expected;                                          \
+      if (memcmp(&actual, &expected_, sizeof(actual)) == 0) {             \
+        g_tests_passed++;                                                 \
+      } else {                                                            \
+        u64 a[2], e[2];                                                   \
+        memcpy(a, &actual, sizeof(a));                                    \
+        memcpy(e, &expected_, sizeof(e));                                 \
+        error(__FILE__, __LINE__,                                         \
+              "in " #f ": expected 0x%016" PRIx64 "%016" PRIx64           \
+              ", got 0x%016" PRIx64 "%016" PRIx64 ".\n",                  \
+              e[1], e[0], a[1], a[0]);                                    \
+      }                                                                   \
+    } else {                                                              \
+      error(__FILE__, __LINE__, #f " trapped.\n");                        \
+    }                                                                     \
+  } while (0)
+
+/* For the checks of the --driver files, which don't call into the sandbox. */
+#define ASSERT_TRUE(cond)                                         \
+  do {                                                            \
+    g_tests_run++;                                                \
+    if (cond) {                                                   \
+      g_tests_passed++;                                           \
+    } else {                                                      \
+      error(__FILE__, __LINE__, "expected " #cond " to hold.\n"); \
+    }                                                             \
+  } while (0)
+
+#define ASSERT_RETURN_I32(f, expected) ASSERT_RETURN_T(u32, "u", f, expected)
+#define ASSERT_RETURN_I64(f, expected) ASSERT_RETURN_T(u64, PRIu64, f, expected)
+#define ASSERT_RETURN_F32(f, expected) ASSERT_RETURN_T(f32, ".9g", f, expected)
+#define ASSERT_RETURN_F64(f, expected) ASSERT_RETURN_T(f64, ".17g", f, expected)
+
+#define ASSERT_RETURN_CANONICAL_NAN_F32(f) \
+  ASSERT_RETURN_NAN_T(f32, u32, "08x", f, canonical)
+#define ASSERT_RETURN_CANONICAL_NAN_F64(f) \
+  ASSERT_RETURN_NAN_T(f64, u64, "016x", f, canonical)
+#define ASSERT_RETURN_ARITHMETIC_NAN_F32(f) \
+  ASSERT_RETURN_NAN_T(f32, u32, "08x", f, arithmetic)
+#define ASSERT_RETURN_ARITHMETIC_NAN_F64(f) \
+  ASSERT_RETURN_NAN_T(f64, u64, "016x", f, arithmetic)
+
+static bool is_equal_u32(u32 x, u32 y) {
+  return x == y;
+}
+
+static bool is_equal_u64(u64 x, u64 y) {
+  return x == y;
+}
+
+#define is_equal_i32 is_equal_u32
+#define is_equal_i64 is_equal_u64
+
+static bool is_equal_f32(f32 x, f32 y) {
+  u32 ux, uy;
+  memcpy(&ux, &x, sizeof(ux));
+  memcpy(&uy, &y, sizeof(uy));
+  return ux == uy;
+}
+
+static bool is_equal_f64(f64 x, f64 y) {
+  u64 ux, uy;
+  memcpy(&ux, &x, sizeof(ux));
+  memcpy(&uy, &y, sizeof(uy));
+  return ux == uy;
+}
+
+static f32 make_nan_f32(u32 x) {
+  x |= 0x7f800000;
+  f32 res;
+  memcpy(&res, &x, sizeof(res));
+  return res;
+}
+
+static f64 make_nan_f64(u64 x) {
+  x |= 0x7ff0000000000000;
+  f64 res;
+  memcpy(&res, &x, sizeof(res));
+  return res;
+}
+
+static bool is_canonical_nan_f32(u32 x) {
+  return (x & 0x7fffffff) == 0x7fc00000;
+}
+
+static bool is_canonical_nan_f64(u64 x) {
+  return (x & 0x7fffffffffffffff) == 0x7ff8000000000000;
+}
+
+static bool is_arithmetic_nan_f32(u32 x) {
+  return (x & 0x7fc00000) == 0x7fc00000;
+}
+
+static bool is_arithmetic_nan_f64(u64 x) {
+  return (x & 0x7ff8000000000000) == 0x7ff8000000000000;
+}
+
+
+static v128 make_v128(u64 lo, u64 hi) {
+  u64 halves[2] = {lo, hi};
+  v128 res;
+  memcpy(&res, halves, sizeof(res));
+  return res;
+}
+
+int main(int argc, char** argv) {
+  run_spec_tests();
+  /* run-spec-wasm2c.py adds up the counts of all modules, and fails the test
+   * if they differ. */
+  printf("%u/%u tests passed.\n", g_tests_passed, g_tests_run);
+  return 0;
+}
+
+
+static void run_spec_tests(void) {
+  wasm2c_sandbox_funcs_t funcs = get_wasm2c_sandbox_info();
+  if (!funcs.wasm_rt_sys_init()) {
+    error(__FILE__, __LINE__, "could not install the fault handler.\n");
+    g_tests_run++;
+    return;
+  }
+  wasm2c_sandbox_t* sbx = (wasm2c_sandbox_t*)funcs.create_wasm2c_sandbox(0);
+  if (!sbx) {
+    error(__FILE__, __LINE__, "could not create the sandbox.\n");
+    g_tests_run++;
+    return;
+  }
+
+  // simd.txt:72
+  ASSERT_RETURN_V128(w2c_i32x4_add(sbx, make_v128(0x0000000200000001ull, 0xffffffff00000003ull), make_v128(0x000000140000000aull, 0x000000010000001eull)), make_v128(0x000000160000000bull, 0x0000000000000021ull));
+
+  // simd.txt:74
+  ASSERT_RETURN_V128(w2c_i8x16_add_sat_s(sbx, make_v128(0x00000000ff01807full, 0x6400000000000000ull), make_v128(0x00000000ff01ff01ull, 0x6400000000000000ull)), make_v128(0x00000000fe02807full, 0x7f00000000000000ull));
+
+  // simd.txt:76
+  ASSERT_RETURN_V128(w2c_i16x8_sub_sat_u(sbx, make_v128(0x0064ffff00000005ull, 0x0001000000000000ull), make_v128(0x003200010001000aull, 0x0000000000000000ull)), make_v128(0x0032fffe00000000ull, 0x0001000000000000ull));
+
+  // simd.txt:78
+  ASSERT_RETURN_V128(w2c_i32x4_min_u(sbx, make_v128(0xffffffff00000001ull, 0x8000000000000007ull), make_v128(0x0000000300000002ull, 0x7fffffff00000007ull)), make_v128(0x0000000300000001ull, 0x7fffffff00000007ull));
+
+  // simd.txt:80
+  ASSERT_RETURN_V128(w2c_i8x16_narrow_i16x8_u(sbx, make_v128(0x010000ff0000ffffull, 0x0004000300020001ull), make_v128(0x007f0080fed4012cull, 0x0005000000000000ull)), make_v128(0x04030201ffff0000ull, 0x050000007f8000ffull));
+
+  // simd.txt:82
+  ASSERT_RETURN_V128(w2c_i32x4_extend_high_i16x8_s(sbx, make_v128(0x0000000000000000ull, 0x7fff80000002ffffull)), make_v128(0x00000002ffffffffull, 0x00007fffffff8000ull));
+
+  // simd.txt:84
+  ASSERT_RETURN_V128(w2c_i16x8_extadd_pairwise_i8x16_u(sbx, make_v128(0x000000000201ffffull, 0x8080000000000000ull)), make_v128(0x00000000000301feull, 0x0100000000000000ull));
+
+  // simd.txt:86
+  ASSERT_RETURN_V128(w2c_i32x4_dot_i16x8_s(sbx, make_v128(0x8000800000020001ull, 0x0000000000000003ull), make_v128(0x8000800000040003ull, 0x000000000000ffffull)), make_v128(0x800000000000000bull, 0x00000000fffffffdull));
+
+  // simd.txt:88
+  ASSERT_RETURN_V128(w2c_i16x8_q15mulr_sat_s(sbx, make_v128(0x0000000040008000ull, 0x0000000000000000ull), make_v128(0x0000000040008000ull, 0x0000000000000000ull)), make_v128(0x0000000020007fffull, 0x0000000000000000ull));
+
+  // simd.txt:90
+  ASSERT_RETURN_V128(w2c_i8x16_popcnt(sbx, make_v128(0x7f3f1f0f07030100ull, 0x0000000080aa55ffull)), make_v128(0x0706050403020100ull, 0x0000000001040408ull));
+
+  // simd.txt:92
+  ASSERT_RETURN_I32(w2c_i8x16_bitmask(sbx, make_v128(0x0000000000ff00ffull, 0x8000000000000000ull)), 32773u);
+
+  // simd.txt:93
+  ASSERT_RETURN_I32(w2c_v128_any_true(sbx, make_v128(0x0000000000000000ull, 0x0000000000000000ull)), 0u);
+
+  // simd.txt:94
+  ASSERT_RETURN_I32(w2c_v128_any_true(sbx, make_v128(0x0000000000000000ull, 0x0000000000000100ull)), 1u);
+
+  // simd.txt:95
+  ASSERT_RETURN_I32(w2c_i32x4_all_true(sbx, make_v128(0x0000000200000001ull, 0x0000000400000003ull)), 1u);
+
+  // simd.txt:96
+  ASSERT_RETURN_I32(w2c_i32x4_all_true(sbx, make_v128(0x0000000200000001ull, 0x0000000400000000ull)), 0u);
+
+  // simd.txt:97
+  ASSERT_RETURN_V128(w2c_i64x2_shl(sbx, make_v128(0x0000000000000001ull, 0x0000000000000003ull), 65u), make_v128(0x0000000000000002ull, 0x0000000000000006ull));
+
+  // simd.txt:98
+  ASSERT_RETURN_V128(w2c_i8x16_shr_s(sbx, make_v128(0x0000000000004080ull, 0xff00000000000000ull), 9u), make_v128(0x00000000000020c0ull, 0xff00000000000000ull));
+
+  // simd.txt:100
+  ASSERT_RETURN_V128(w2c_v128_bitselect(sbx, make_v128(0xffffffffffffffffull, 0x0000000000000000ull), make_v128(0x0000000000000000ull, 0xffffffffffffffffull), make_v128(0xff00ff00ff00ff00ull, 0x00000000ffffffffull)), make_v128(0xff00ff00ff00ff00ull, 0xffffffff00000000ull));
+
+  // simd.txt:102
+  ASSERT_RETURN_V128(w2c_f32x4_min(sbx, make_v128(0x800000003f800000ull, 0xc0a0000040000000ull), make_v128(0x0000000040000000ull, 0xc0800000ff800000ull)), make_v128(0x800000003f800000ull, 0xc0a00000ff800000ull));
+
+  // simd.txt:104
+  ASSERT_RETURN_V128(w2c_f64x2_floor(sbx, make_v128(0xbff8000000000000ull, 0x4006000000000000ull)), make_v128(0xc000000000000000ull, 0x4000000000000000ull));
+
+  // simd.txt:105
+  ASSERT_RETURN_V128(w2c_i32x4_trunc_sat_f32x4_s(sbx, make_v128(0xbff333333ff33333ull, 0xff80000050df8476ull)), make_v128(0xffffffff00000001ull, 0x800000007fffffffull));
+
+  // simd.txt:108
+  ASSERT_RETURN_V128(w2c_i8x16_shuffle(sbx, make_v128(0x0706050403020100ull, 0x0f0e0d0c0b0a0908ull), make_v128(0x1716151413121110ull, 0x1f1e1d1c1b1a1918ull)), make_v128(0x031c021d011e001full, 0x07180619051a041bull));
+
+  // simd.txt:110
+  ASSERT_RETURN_V128(w2c_i8x16_swizzle(sbx, make_v128(0x463c32281e140a00ull, 0x968c82786e645a50ull), make_v128(0x020380ff1001000full, 0x0700000000000000ull)), make_v128(0x141e0000000a0096ull, 0x4600000000000000ull));
+
+  // simd.txt:112
+  ASSERT_RETURN_I32(w2c_i16x8_extract_lane_s(sbx, make_v128(0x0000000000000000ull, 0xfffe000000000000ull)), 4294967294u);
+
+  // simd.txt:113
+  ASSERT_RETURN_V128(w2c_f64x2_replace_lane(sbx, make_v128(0x3ff0000000000000ull, 0x4000000000000000ull), 3.5), make_v128(0x3ff0000000000000ull, 0x400c000000000000ull));
+
+  // simd.txt:114
+  ASSERT_RETURN_V128(w2c_i32x4_splat(sbx, 7u), make_v128(0x0000000700000007ull, 0x0000000700000007ull));
+
+  // simd.txt:116
+  ASSERT_RETURN_V128(w2c_v128_load(sbx, 16u), make_v128(0x0706050403020100ull, 0x0f0e0d0c0b0a0908ull));
+
+  // simd.txt:117
+  ASSERT_RETURN_V128(w2c_v128_load8x8_s(sbx, 16u), make_v128(0x0003000200010000ull, 0x0007000600050004ull));
+
+  // simd.txt:118
+  ASSERT_RETURN_V128(w2c_v128_load32_splat(sbx, 20u), make_v128(0x0706050407060504ull, 0x0706050407060504ull));
+
+  // simd.txt:119
+  ASSERT_RETURN_V128(w2c_v128_load64_zero(sbx, 24u), make_v128(0x0f0e0d0c0b0a0908ull, 0x0000000000000000ull));
+
+  // simd.txt:120
+  ASSERT_RETURN_V128(w2c_v128_load16_lane(sbx, 16u, make_v128(0xffffffffffffffffull, 0xffffffffffffffffull)), make_v128(0x0100ffffffffffffull, 0xffffffffffffffffull));
+
+  // simd.txt:122
+  ASSERT_RETURN_V128(w2c_store_lane_and_load(sbx, 64u, make_v128(0x0000000200000001ull, 0x0000000400000003ull)), make_v128(0x0000000000000003ull, 0x0000000000000000ull));
+
+  // simd.txt:124
+  ASSERT_TRAP(w2c_v128_load(sbx, 65521u));
+
+  // simd.txt:125
+  ASSERT_TRAP(w2c_v128_load32_splat(sbx, 65533u));
+
+  // simd.txt:126
+  ASSERT_TRAP(w2c_v128_load16_lane(sbx, 65535u, make_v128(0x0000000000000000ull, 0x0000000000000000ull)));
+
+  // simd.txt:127
+  ASSERT_TRAP(w2c_store_lane_and_load(sbx, 4294967295u, make_v128(0x0000000000000000ull, 0x0000000000000000ull)));
+
+  funcs.destroy_wasm2c_sandbox(sbx);
+}
@@ -0,0 +1,2079 @@
+/* Automically generated by wasm2c */
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "simd.0.h"
+#if defined(_MSC_VER)
+#  define UNLIKELY(x) (x)
+#  define LIKELY(x) (x)
+#else
+#  define UNLIKELY(x) __builtin_expect(!!(x), 0)
+#  define LIKELY(x) __builtin_expect(!!(x), 1)
+#endif
+
+#define TRAP(x) (wasm_rt_trap(WASM_RT_TRAP_##x), 0)
+
+// Large data segments are page aligned, so they can be mapped directly.
+#if defined(_MSC_VER)
+#  define DATA_SEGMENT_ALIGN __declspec(align(4096))
+#else
+#  define DATA_SEGMENT_ALIGN __attribute__((aligned(4096)))
+#endif
+
+// Functions that would be static in a single output file, but are shared
+// between the shards when wasm2c splits its output across several files.
+#if defined(_WIN32)
+#  define FUNC_INTERNAL
+#else
+#  define FUNC_INTERNAL __attribute__((visibility("hidden")))
+#endif
+
+// Functions that the profile given to wasm2c with --profile-use found hot, or
+// never saw called. GCC also moves them to .text.hot and .text.unlikely, which
+// keeps the hot code together.
+#if defined(__has_attribute)
+#  if __has_attribute(hot) && __has_attribute(cold)
+#    define FUNC_HOT __attribute__((hot))
+#    define FUNC_COLD __attribute__((cold))
+#  endif
+#endif
+#ifndef FUNC_HOT
+#  define FUNC_HOT
+#  define FUNC_COLD
+#endif
+
+// Counts whether the condition `c` of an if or br_if holds, with
+// --instrument=branches.
+#define PROFILE_BRANCH(sbx, site, c) \
+  profile_branch(&(sbx)->profile, site, c)
+
+static inline u32 profile_branch(wasm_rt_profile_t* profile, u32 site, u32 c) {
+  ++profile->branches[2 * site + (c != 0)];
+  return c;
+}
+
+// Tail calls skip the FUNC_EPILOGUE of the caller, and the
+// EXTERNAL_CALLBACK_EPILOGUE of callbacks, so they are only made with musttail
+// when the embedder doesn't define those.
+#if !defined(WASM_RT_MUSTTAIL) && !defined(FUNC_EPILOGUE) && \
+    !defined(EXTERNAL_CALLBACK_EPILOGUE) && defined(__has_attribute)
+#  if __has_attribute(musttail)
+#    define WASM_RT_MUSTTAIL __attribute__((musttail))
+#  endif
+#endif
+
+#ifndef FUNC_PROLOGUE
+#define FUNC_PROLOGUE
+#endif
+
+#ifndef FUNC_EPILOGUE
+#define FUNC_EPILOGUE
+#endif
+
+#ifdef EXTERNAL_CALLBACK_PROLOGUE
+#define EXTERNAL_CALLBACK_PROLOGUE_EXEC(table, x)                        \
+  if (UNLIKELY(table.data[x].func_class == WASM_RT_EXTERNAL_FUNCTION)) { \
+    EXTERNAL_CALLBACK_PROLOGUE;                                          \
+  }
+#else
+#define EXTERNAL_CALLBACK_PROLOGUE_EXEC(table, x)
+#endif
+
+#ifdef EXTERNAL_CALLBACK_EPILOGUE
+#define EXTERNAL_CALLBACK_EPILOGUE_EXEC(table, x)                        \
+  if (UNLIKELY(table.data[x].func_class == WASM_RT_EXTERNAL_FUNCTION)) { \
+    EXTERNAL_CALLBACK_EPILOGUE;                                          \
+  }
+#else
+#define EXTERNAL_CALLBACK_EPILOGUE_EXEC(table, x)
+#endif
+
+#define UNREACHABLE (void) TRAP(UNREACHABLE)
+
+// Empty table elements have function type 0, which no function type has, so
+// the type check also rejects them. `type_id` is usually a constant.
+#define CALL_INDIRECT_VOID(table, t, type_id, x, ...)                     \
+  if (LIKELY((x) < table.size && table.data[x].func_type == (type_id))) { \
+    EXTERNAL_CALLBACK_PROLOGUE_EXEC(table, x);                            \
+    ((t)table.data[x].func)(__VA_ARGS__);                                 \
+    EXTERNAL_CALLBACK_EPILOGUE_EXEC(table, x);                            \
+  } else {                                                                \
+    wasm_rt_callback_error_trap(&table, x, type_id);                      \
+  }
+
+#define CALL_INDIRECT_RES(res, table, t, type_id, x, ...)                 \
+  if (LIKELY((x) < table.size && table.data[x].func_type == (type_id))) { \
+    EXTERNAL_CALLBACK_PROLOGUE_EXEC(table, x);                            \
+    res = ((t)table.data[x].func)(__VA_ARGS__);                           \
+    EXTERNAL_CALLBACK_EPILOGUE_EXEC(table, x);                            \
+  } else {                                                                \
+    wasm_rt_callback_error_trap(&table, x, type_id);                      \
+  }
+
+#if defined(WASM2C_MALLOC_FAIL_CALLBACK)
+void WASM2C_MALLOC_FAIL_CALLBACK(u32 ptr_size);
+# define WASM2C_MALLOC_FAIL_CHECK(ptr, ptr_size)  \
+  if (!ptr) {                                     \
+    WASM2C_MALLOC_FAIL_CALLBACK(ptr_size);        \
+  }
+#else
+# define WASM2C_MALLOC_FAIL_CHECK(ptr, ptr_size)
+#endif
+
+#if defined(WASM_CHECK_SHADOW_MEMORY)
+#  if defined(WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE)
+#    if defined(WASM_CHECK_SHADOW_MEMORY_UNINIT_READ)
+#      error "WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE can't be used with WASM_CHECK_SHADOW_MEMORY_UNINIT_READ"
+#    endif
+// Only check about one in WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE loads and
+// stores, plus every access from the functions given to wasm2c with
+// --shadow-check-function. Allocations and frees are always tracked. Each
+// thread counts down to its next checked access, and the runtime picks the
+// length of every countdown at random so the checks don't line up with loops.
+// The rate is stored in the memory when it is allocated, so the runtime
+// doesn't need to be built with the same WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE.
+static WASM_RT_THREAD_LOCAL u32 wasm2c_shadow_sample_countdown = 1;
+#    define WASM2C_SHADOW_MEMORY_SAMPLED(mem, shadow_class)                      \
+  (((shadow_class) & WASM2C_SHADOW_FUNC_ALWAYS_CHECK) ||                       \
+   (UNLIKELY(--wasm2c_shadow_sample_countdown == 0) &&                         \
+    (wasm2c_shadow_sample_countdown = wasm2c_shadow_memory_next_sample(mem), 1)))
+#    define WASM2C_SHADOW_MEMORY_INIT_SAMPLE_RATE(mem)                           \
+  wasm2c_shadow_memory_set_sample_rate(mem, WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE)
+#  else
+#    define WASM2C_SHADOW_MEMORY_SAMPLED(mem, shadow_class) 1
+#    define WASM2C_SHADOW_MEMORY_INIT_SAMPLE_RATE(mem)
+#  endif
+#  define WASM2C_SHADOW_MEMORY_LOAD(mem, shadow_class, func_name, ptr, ptr_size)   \
+  do {                                                                           \
+    if (WASM2C_SHADOW_MEMORY_SAMPLED(mem, shadow_class))                         \
+      wasm2c_shadow_memory_load(mem, shadow_class, func_name, ptr, ptr_size);    \
+  } while (0)
+#  define WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, ptr, ptr_size)  \
+  do {                                                                           \
+    if (WASM2C_SHADOW_MEMORY_SAMPLED(mem, shadow_class))                         \
+      wasm2c_shadow_memory_store(mem, shadow_class, func_name, ptr, ptr_size);   \
+  } while (0)
+#  define WASM2C_SHADOW_MEMORY_RESERVE(mem, ptr, ptr_size)          wasm2c_shadow_memory_reserve(mem, ptr, ptr_size)
+#  define WASM2C_SHADOW_MEMORY_DLMALLOC(mem, ptr, ptr_size)         wasm2c_shadow_memory_dlmalloc(mem, ptr, ptr_size)
+#  define WASM2C_SHADOW_MEMORY_DLFREE(mem, ptr)                     wasm2c_shadow_memory_dlfree(mem, ptr)
+#  define WASM2C_SHADOW_MEMORY_MARK_GLOBALS_HEAP_BOUNDARY(mem, ptr) wasm2c_shadow_memory_mark_globals_heap_boundary(mem, ptr)
+#else
+// Consume the arguments that the load and store helpers only take for shadow
+// memory, so that they don't warn about unused parameters.
+#  define WASM2C_SHADOW_MEMORY_LOAD(mem, shadow_class, func_name, ptr, ptr_size) \
+  ((void)(mem), (void)(shadow_class), (void)(func_name))
+#  define WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, ptr, ptr_size) \
+  ((void)(mem), (void)(shadow_class), (void)(func_name))
+#  define WASM2C_SHADOW_MEMORY_RESERVE(mem, ptr, ptr_size)
+#  define WASM2C_SHADOW_MEMORY_DLMALLOC(mem, ptr, ptr_size)
+#  define WASM2C_SHADOW_MEMORY_DLFREE(mem, ptr)
+#  define WASM2C_SHADOW_MEMORY_MARK_GLOBALS_HEAP_BOUNDARY(mem, ptr)
+#  define WASM2C_SHADOW_MEMORY_INIT_SAMPLE_RATE(mem)
+#endif
+
+// Another thread may grow a shared memory at any time, so its size is read
+// atomically. wasm_rt_grow_memory makes the new pages accessible before it
+// stores the new size.
+#if WASM_RT_SHARED_MEMORY
+#  define MEM_SIZE(mem) __atomic_load_n(&(mem)->size, __ATOMIC_ACQUIRE)
+#  define MEM_PAGES(mem) __atomic_load_n(&(mem)->pages, __ATOMIC_ACQUIRE)
+#else
+#  define MEM_SIZE(mem) ((mem)->size)
+#  define MEM_PAGES(mem) ((mem)->pages)
+#endif
+
+#ifdef WASM_USE_GUARD_PAGES
+#  define MEMCHECK(mem_size, a, t) (void)(mem_size)
+#else
+#  define MEMCHECK(mem_size, a, t) if (UNLIKELY((a) + sizeof(t) > (mem_size))) { (void) TRAP(OOB); }
+#endif
+
+#if defined(WASM_USE_GUARD_PAGES) && UINTPTR_MAX == 0xffffffff
+// on 32-bit platforms we have to mask memory access into range
+#  define MEM_ACCESS_REF(mem, mem_data, addr) &(mem_data)[addr & mem->mem_mask]
+#else
+#  define MEM_ACCESS_REF(mem, mem_data, addr) &(mem_data)[addr]
+#endif
+
+#if defined(WASM_USING_GLOBAL_HEAP)
+#  undef MEM_ACCESS_REF
+#  define MEM_ACCESS_REF(mem, mem_data, addr) (char*) addr
+#endif
+
+// Each load and store has two forms. The plain form reads the base and size of
+// the linear memory through `mem`. The `_cached` form takes them as arguments,
+// so that functions can keep them in locals: the compiler must otherwise
+// assume that any store into linear memory may have modified `mem`, and reload
+// the base pointer on every access.
+//
+// Both forms also have an `_unchecked` variant without the MEMCHECK, which
+// wasm2c uses for the accesses it has proven to be in bounds.
+#if WABT_BIG_ENDIAN
+static inline void load_data(void *dest, const void *src, size_t n) {
+  size_t i = 0;
+  u8 *dest_chars = dest;
+  memcpy(dest, src, n);
+  for (i = 0; i < (n>>1); i++) {
+    u8 cursor = dest_chars[i];
+    dest_chars[i] = dest_chars[n - i - 1];
+    dest_chars[n - i - 1] = cursor;
+  }
+}
+#define LOAD_DATA(m, o, i, s) { load_data(&(m.data[m.size - o - s]), i, s); \
+  WASM2C_SHADOW_MEMORY_RESERVE(&m, m.size - o - s, s);                       \
+  WASM2C_SHADOW_MEMORY_STORE(&m, WASM2C_SHADOW_FUNC_ALWAYS_CHECK,            \
+                             "GlobalDataLoad", m.size - o - s, s);           \
+}
+
+#define DEFINE_LOAD(name, t1, t2, t3)                                                                \
+  static inline t3 name##_unchecked_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size,        \
+                                           u64 addr, u32 shadow_class, const char* func_name) {      \
+    t1 result;                                                                                       \
+    memcpy(&result, MEM_ACCESS_REF(mem, mem_data, mem_size - addr - sizeof(t1)), sizeof(t1));        \
+    WASM2C_SHADOW_MEMORY_LOAD(mem, shadow_class, func_name, mem_size - addr - sizeof(t1),            \
+                              sizeof(t1));                                                           \
+    return (t3)(t2)result;                                                                           \
+  }                                                                                                  \
+  static inline t3 name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,        \
+                                 u32 shadow_class, const char* func_name) {                          \
+    MEMCHECK(mem_size, addr, t1);                                                                    \
+    return name##_unchecked_cached(mem, mem_data, mem_size, addr, shadow_class, func_name);          \
+  }                                                                                                  \
+  static inline t3 name##_unchecked(wasm_rt_memory_t* mem, u64 addr, u32 shadow_class,               \
+                                    const char* func_name) {                                         \
+    return name##_unchecked_cached(mem, mem->data, MEM_SIZE(mem), addr, shadow_class, func_name);     \
+  }                                                                                                  \
+  static inline t3 name(wasm_rt_memory_t* mem, u64 addr, u32 shadow_class, const char* func_name) {  \
+    return name##_cached(mem, mem->data, MEM_SIZE(mem), addr, shadow_class, func_name);               \
+  }
+
+#define DEFINE_STORE(name, t1, t2)                                                                   \
+  static inline void name##_unchecked_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size,      \
+                                             u64 addr, t2 value, u32 shadow_class,                   \
+                                             const char* func_name) {                                \
+    t1 wrapped = (t1)value;                                                                          \
+    memcpy(MEM_ACCESS_REF(mem, mem_data, mem_size - addr - sizeof(t1)), &wrapped, sizeof(t1));       \
+    WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, mem_size - addr - sizeof(t1),           \
+                               sizeof(t1));                                                          \
+  }                                                                                                  \
+  static inline void name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,      \
+                                   t2 value, u32 shadow_class, const char* func_name) {              \
+    MEMCHECK(mem_size, addr, t1);                                                                    \
+    name##_unchecked_cached(mem, mem_data, mem_size, addr, value, shadow_class, func_name);          \
+  }                                                                                                  \
+  static inline void name##_unchecked(wasm_rt_memory_t* mem, u64 addr, t2 value, u32 shadow_class,   \
+                                      const char* func_name) {                                       \
+    name##_unchecked_cached(mem, mem->data, MEM_SIZE(mem), addr, value, shadow_class, func_name);     \
+  }                                                                                                  \
+  static inline void name(wasm_rt_memory_t* mem, u64 addr, t2 value, u32 shadow_class,               \
+                          const char* func_name) {                                                   \
+    name##_cached(mem, mem->data, MEM_SIZE(mem), addr, value, shadow_class, func_name);               \
+  }
+#else
+static inline void load_data(void *dest, const void *src, size_t n) {
+  memcpy(dest, src, n);
+}
+#define LOAD_DATA(m, o, i, s) { load_data(&(m.data[o]), i, s);          \
+  WASM2C_SHADOW_MEMORY_RESERVE(&m, o, s);                                \
+  WASM2C_SHADOW_MEMORY_STORE(&m, WASM2C_SHADOW_FUNC_ALWAYS_CHECK,        \
+                             "GlobalDataLoad", o, s);                    \
+}
+
+#define DEFINE_LOAD(name, t1, t2, t3)                                                                \
+  static inline t3 name##_unchecked_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size,        \
+                                           u64 addr, u32 shadow_class, const char* func_name) {      \
+    t1 result;                                                                                       \
+    (void)mem_size;                                                                                  \
+    memcpy(&result, MEM_ACCESS_REF(mem, mem_data, addr), sizeof(t1));                                \
+    WASM2C_SHADOW_MEMORY_LOAD(mem, shadow_class, func_name, addr, sizeof(t1));                       \
+    return (t3)(t2)result;                                                                           \
+  }                                                                                                  \
+  static inline t3 name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,        \
+                                 u32 shadow_class, const char* func_name) {                          \
+    MEMCHECK(mem_size, addr, t1);                                                                    \
+    return name##_unchecked_cached(mem, mem_data, mem_size, addr, shadow_class, func_name);          \
+  }                                                                                                  \
+  static inline t3 name##_unchecked(wasm_rt_memory_t* mem, u64 addr, u32 shadow_class,               \
+                                    const char* func_name) {                                         \
+    return name##_unchecked_cached(mem, mem->data, MEM_SIZE(mem), addr, shadow_class, func_name);     \
+  }                                                                                                  \
+  static inline t3 name(wasm_rt_memory_t* mem, u64 addr, u32 shadow_class, const char* func_name) {  \
+    return name##_cached(mem, mem->data, MEM_SIZE(mem), addr, shadow_class, func_name);               \
+  }
+
+#define DEFINE_STORE(name, t1, t2)                                                                   \
+  static inline void name##_unchecked_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size,      \
+                                             u64 addr, t2 value, u32 shadow_class,                   \
+                                             const char* func_name) {                                \
+    t1 wrapped = (t1)value;                                                                          \
+    (void)mem_size;                                                                                  \
+    memcpy(MEM_ACCESS_REF(mem, mem_data, addr), &wrapped, sizeof(t1));                               \
+    WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, addr, sizeof(t1));                      \
+  }                                                                                                  \
+  static inline void name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,      \
+                                   t2 value, u32 shadow_class, const char* func_name) {              \
+    MEMCHECK(mem_size, addr, t1);                                                                    \
+    name##_unchecked_cached(mem, mem_data, mem_size, addr, value, shadow_class, func_name);          \
+  }                                                                                                  \
+  static inline void name##_unchecked(wasm_rt_memory_t* mem, u64 addr, t2 value, u32 shadow_class,   \
+                                      const char* func_name) {                                       \
+    name##_unchecked_cached(mem, mem->data, MEM_SIZE(mem), addr, value, shadow_class, func_name);     \
+  }                                                                                                  \
+  static inline void name(wasm_rt_memory_t* mem, u64 addr, t2 value, u32 shadow_class,               \
+                          const char* func_name) {                                                   \
+    name##_cached(mem, mem->data, MEM_SIZE(mem), addr, value, shadow_class, func_name);               \
+  }
+#endif
+
+DEFINE_LOAD(i32_load, u32, u32, u32);
+DEFINE_LOAD(i64_load, u64, u64, u64);
+DEFINE_LOAD(f32_load, f32, f32, f32);
+DEFINE_LOAD(f64_load, f64, f64, f64);
+DEFINE_LOAD(i32_load8_s, s8, s32, u32);
+DEFINE_LOAD(i64_load8_s, s8, s64, u64);
+DEFINE_LOAD(i32_load8_u, u8, u32, u32);
+DEFINE_LOAD(i64_load8_u, u8, u64, u64);
+DEFINE_LOAD(i32_load16_s, s16, s32, u32);
+DEFINE_LOAD(i64_load16_s, s16, s64, u64);
+DEFINE_LOAD(i32_load16_u, u16, u32, u32);
+DEFINE_LOAD(i64_load16_u, u16, u64, u64);
+DEFINE_LOAD(i64_load32_s, s32, s64, u64);
+DEFINE_LOAD(i64_load32_u, u32, u64, u64);
+DEFINE_STORE(i32_store, u32, u32);
+DEFINE_STORE(i64_store, u64, u64);
+DEFINE_STORE(f32_store, f32, f32);
+DEFINE_STORE(f64_store, f64, f64);
+DEFINE_STORE(i32_store8, u8, u32);
+DEFINE_STORE(i32_store16, u16, u32);
+DEFINE_STORE(i64_store8, u8, u64);
+DEFINE_STORE(i64_store16, u16, u64);
+DEFINE_STORE(i64_store32, u32, u64);
+
+// The bulk memory operations are bounds checked and done with memmove/memset
+// by the runtime. The shadow memory is checked once for the whole range.
+static inline void memory_copy(wasm_rt_memory_t* mem, u32 dest, u32 src, u32 n,
+                               u32 shadow_class, const char* func_name) {
+  wasm_rt_memory_copy(mem, dest, src, n);
+  if (n != 0) {
+    WASM2C_SHADOW_MEMORY_LOAD(mem, shadow_class, func_name, src, n);
+    WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, dest, n);
+  }
+}
+
+static inline void memory_fill(wasm_rt_memory_t* mem, u32 dest, u32 value, u32 n,
+                               u32 shadow_class, const char* func_name) {
+  wasm_rt_memory_fill(mem, dest, value, n);
+  if (n != 0) {
+    WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, dest, n);
+  }
+}
+
+static inline void memory_init(wasm_rt_memory_t* mem, u32 dest, u32 src, u32 n,
+                               const u8* data, u32 data_size,
+                               u32 shadow_class, const char* func_name) {
+  wasm_rt_memory_init(mem, dest, data, data_size, src, n);
+  if (n != 0) {
+    WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, dest, n);
+  }
+}
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+
+// Adapted from https://github.com/nemequ/portable-snippets/blob/master/builtin/builtin.h
+
+static inline int I64_CLZ(unsigned long long v) {
+  unsigned long r = 0;
+#if defined(_M_AMD64) || defined(_M_ARM)
+    if (_BitScanReverse64(&r, v)) {
+      return 63 - r;
+    }
+#else
+    if (_BitScanReverse(&r, (unsigned long) (v >> 32))) {
+      return 31 - r;
+    } else if (_BitScanReverse(&r, (unsigned long) v)) {
+      return 63 - r;
+    }
+#endif
+  return 64;
+}
+
+static inline int I32_CLZ(unsigned long v) {
+  unsigned long r = 0;
+  if (_BitScanReverse(&r, v)) {
+    return 31 - r;
+  }
+  return 32;
+}
+
+static inline int I64_CTZ(unsigned long long v) {
+  if (!v) {
+    return 64;
+  }
+  unsigned long r = 0;
+#if defined(_M_AMD64) || defined(_M_ARM)
+    _BitScanForward64(&r, v);
+    return (int) r;
+#else
+    if (_BitScanForward(&r, (unsigned int) (v))) {
+      return (int) (r);
+    }
+
+    _BitScanForward(&r, (unsigned int) (v >> 32));
+    return (int) (r + 32);
+#endif
+}
+
+static inline int I32_CTZ(unsigned long v) {
+  if (!v) {
+    return 32;
+  }
+  unsigned long r = 0;
+  _BitScanForward(&r, v);
+  return (int) r;
+}
+
+#define POPCOUNT_DEFINE_PORTABLE(f_n, T)                    \
+  static inline u32 f_n(T x) {                              \
+    x = x - ((x >> 1) & (T)~(T)0/3);                        \
+    x = (x & (T)~(T)0/15*3) + ((x >> 2) & (T)~(T)0/15*3);   \
+    x = (x + (x >> 4)) & (T)~(T)0/255*15;                   \
+    return (T)(x * ((T)~(T)0/255)) >> (sizeof(T) - 1) * 8;  \
+  }
+
+POPCOUNT_DEFINE_PORTABLE(I32_POPCNT, u32)
+POPCOUNT_DEFINE_PORTABLE(I64_POPCNT, u64)
+
+#undef POPCOUNT_DEFINE_PORTABLE
+
+#else
+#  define I32_CLZ(x) ((x) ? __builtin_clz(x) : 32)
+#  define I64_CLZ(x) ((x) ? __builtin_clzll(x) : 64)
+#  define I32_CTZ(x) ((x) ? __builtin_ctz(x) : 32)
+#  define I64_CTZ(x) ((x) ? __builtin_ctzll(x) : 64)
+#  define I32_POPCNT(x) (__builtin_popcount(x))
+#  define I64_POPCNT(x) (__builtin_popcountll(x))
+#endif
+
+#define DIV_S(ut, min, x, y)                                 \
+   ((UNLIKELY((y) == 0)) ?                TRAP(DIV_BY_ZERO)  \
+  : (UNLIKELY((x) == min && (y) == -1)) ? TRAP(INT_OVERFLOW) \
+  : (ut)((x) / (y)))
+
+#define REM_S(ut, min, x, y)                                \
+   ((UNLIKELY((y) == 0)) ?                TRAP(DIV_BY_ZERO) \
+  : (UNLIKELY((x) == min && (y) == -1)) ? 0                 \
+  : (ut)((x) % (y)))
+
+#define I32_DIV_S(x, y) DIV_S(u32, INT32_MIN, (s32)x, (s32)y)
+#define I64_DIV_S(x, y) DIV_S(u64, INT64_MIN, (s64)x, (s64)y)
+#define I32_REM_S(x, y) REM_S(u32, INT32_MIN, (s32)x, (s32)y)
+#define I64_REM_S(x, y) REM_S(u64, INT64_MIN, (s64)x, (s64)y)
+
+#define DIVREM_U(op, x, y) \
+  ((UNLIKELY((y) == 0)) ? TRAP(DIV_BY_ZERO) : ((x) op (y)))
+
+#define DIV_U(x, y) DIVREM_U(/, x, y)
+#define REM_U(x, y) DIVREM_U(%, x, y)
+
+#define ROTL(x, y, mask) \
+  (((x) << ((y) & (mask))) | ((x) >> (((mask) - (y) + 1) & (mask))))
+#define ROTR(x, y, mask) \
+  (((x) >> ((y) & (mask))) | ((x) << (((mask) - (y) + 1) & (mask))))
+
+#define I32_ROTL(x, y) ROTL(x, y, 31)
+#define I64_ROTL(x, y) ROTL(x, y, 63)
+#define I32_ROTR(x, y) ROTR(x, y, 31)
+#define I64_ROTR(x, y) ROTR(x, y, 63)
+
+#define FMIN(x, y)                                          \
+   ((UNLIKELY((x) != (x))) ? NAN                            \
+  : (UNLIKELY((y) != (y))) ? NAN                            \
+  : (UNLIKELY((x) == 0 && (y) == 0)) ? (signbit(x) ? x : y) \
+  : (x < y) ? x : y)
+
+#define FMAX(x, y)                                          \
+   ((UNLIKELY((x) != (x))) ? NAN                            \
+  : (UNLIKELY((y) != (y))) ? NAN                            \
+  : (UNLIKELY((x) == 0 && (y) == 0)) ? (signbit(x) ? y : x) \
+  : (x > y) ? x : y)
+
+#define TRUNC_S(ut, st, ft, min, minop, max, x)                             \
+  ((UNLIKELY((x) != (x)))                        ? TRAP(INVALID_CONVERSION) \
+   : (UNLIKELY(!((x)minop(min) && (x) < (max)))) ? TRAP(INT_OVERFLOW)       \
+                                                 : (ut)(st)(x))
+
+#define I32_TRUNC_S_F32(x) TRUNC_S(u32, s32, f32, (f32)INT32_MIN, >=, 2147483648.f, x)
+#define I64_TRUNC_S_F32(x) TRUNC_S(u64, s64, f32, (f32)INT64_MIN, >=, (f32)INT64_MAX, x)
+#define I32_TRUNC_S_F64(x) TRUNC_S(u32, s32, f64, -2147483649., >, 2147483648., x)
+#define I64_TRUNC_S_F64(x) TRUNC_S(u64, s64, f64, (f64)INT64_MIN, >=, (f64)INT64_MAX, x)
+
+#define TRUNC_U(ut, ft, max, x)                                            \
+  ((UNLIKELY((x) != (x)))                       ? TRAP(INVALID_CONVERSION) \
+   : (UNLIKELY(!((x) > (ft)-1 && (x) < (max)))) ? TRAP(INT_OVERFLOW)       \
+                                                : (ut)(x))
+
+#define I32_TRUNC_U_F32(x) TRUNC_U(u32, f32, 4294967296.f, x)
+#define I64_TRUNC_U_F32(x) TRUNC_U(u64, f32, (f32)UINT64_MAX, x)
+#define I32_TRUNC_U_F64(x) TRUNC_U(u32, f64, 4294967296.,  x)
+#define I64_TRUNC_U_F64(x) TRUNC_U(u64, f64, (f64)UINT64_MAX, x)
+
+#define TRUNC_SAT_S(ut, st, ft, min, smin, minop, max, smax, x) \
+  ((UNLIKELY((x) != (x)))         ? 0                           \
+   : (UNLIKELY(!((x)minop(min)))) ? smin                        \
+   : (UNLIKELY(!((x) < (max))))   ? smax                        \
+                                  : (ut)(st)(x))
+
+#define I32_TRUNC_SAT_S_F32(x) TRUNC_SAT_S(u32, s32, f32, (f32)INT32_MIN, INT32_MIN, >=, 2147483648.f, INT32_MAX, x)
+#define I64_TRUNC_SAT_S_F32(x) TRUNC_SAT_S(u64, s64, f32, (f32)INT64_MIN, INT64_MIN, >=, (f32)INT64_MAX, INT64_MAX, x)
+#define I32_TRUNC_SAT_S_F64(x) TRUNC_SAT_S(u32, s32, f64, -2147483649., INT32_MIN, >, 2147483648., INT32_MAX, x)
+#define I64_TRUNC_SAT_S_F64(x) TRUNC_SAT_S(u64, s64, f64, (f64)INT64_MIN, INT64_MIN, >=, (f64)INT64_MAX, INT64_MAX, x)
+
+#define TRUNC_SAT_U(ut, ft, max, smax, x) \
+  ((UNLIKELY((x) != (x)))        ? 0      \
+   : (UNLIKELY(!((x) > (ft)-1))) ? 0      \
+   : (UNLIKELY(!((x) < (max))))  ? smax   \
+                                 : (ut)(x))
+
+#define I32_TRUNC_SAT_U_F32(x) TRUNC_SAT_U(u32, f32, 4294967296.f, UINT32_MAX, x)
+#define I64_TRUNC_SAT_U_F32(x) TRUNC_SAT_U(u64, f32, (f32)UINT64_MAX, UINT64_MAX, x)
+#define I32_TRUNC_SAT_U_F64(x) TRUNC_SAT_U(u32, f64, 4294967296., UINT32_MAX,  x)
+#define I64_TRUNC_SAT_U_F64(x) TRUNC_SAT_U(u64, f64, (f64)UINT64_MAX, UINT64_MAX, x)
+
+#define DEFINE_REINTERPRET(name, t1, t2)  \
+  static inline t2 name(t1 x) {           \
+    t2 result;                            \
+    memcpy(&result, &x, sizeof(result));  \
+    return result;                        \
+  }
+
+DEFINE_REINTERPRET(f32_reinterpret_i32, u32, f32)
+DEFINE_REINTERPRET(i32_reinterpret_f32, f32, u32)
+DEFINE_REINTERPRET(f64_reinterpret_i64, u64, f64)
+DEFINE_REINTERPRET(i64_reinterpret_f64, f64, u64)
+
+// v128 support. Every wasm SIMD instruction `xxx.yyy` is lowered to a call to
+// `simd_xxx_yyy`. The operations are written with GCC/Clang vector
+// extensions, so a C compiler for any target can build them; on x86-64 the
+// ones that the compiler cannot reliably pattern-match use SSE4.1 intrinsics
+// instead. Define WASM_SIMD_NO_INTRINSICS to force the portable versions.
+#if defined(__SSE4_1__) && !defined(WASM_SIMD_NO_INTRINSICS)
+#  include <smmintrin.h>
+#  define WASM_SIMD_USE_SSE4_1
+#endif
+
+typedef s8 simd_s8x16 __attribute__((vector_size(16)));
+typedef u8 simd_u8x16 __attribute__((vector_size(16)));
+typedef s16 simd_s16x8 __attribute__((vector_size(16)));
+typedef u16 simd_u16x8 __attribute__((vector_size(16)));
+typedef s32 simd_s32x4 __attribute__((vector_size(16)));
+typedef u32 simd_u32x4 __attribute__((vector_size(16)));
+typedef s64 simd_s64x2 __attribute__((vector_size(16)));
+typedef u64 simd_u64x2 __attribute__((vector_size(16)));
+typedef f32 simd_f32x4 __attribute__((vector_size(16)));
+typedef f64 simd_f64x2 __attribute__((vector_size(16)));
+
+#define SIMD_SAT(x, min, max) ((x) < (min) ? (min) : (x) > (max) ? (max) : (x))
+
+static inline v128 simd_v128_const(u64 lo, u64 hi) {
+  return (v128)(simd_u64x2){lo, hi};
+}
+
+static inline v128 simd_v128_bitselect(v128 a, v128 b, v128 c) {
+  return (a & c) | (b & ~c);
+}
+
+static inline v128 simd_v128_not(v128 a) { return ~a; }
+static inline v128 simd_v128_and(v128 a, v128 b) { return a & b; }
+static inline v128 simd_v128_andnot(v128 a, v128 b) { return a & ~b; }
+static inline v128 simd_v128_or(v128 a, v128 b) { return a | b; }
+static inline v128 simd_v128_xor(v128 a, v128 b) { return a ^ b; }
+
+static inline u32 simd_v128_any_true(v128 a) {
+#ifdef WASM_SIMD_USE_SSE4_1
+  return !_mm_testz_si128((__m128i)a, (__m128i)a);
+#else
+  return (((simd_u64x2)a)[0] | ((simd_u64x2)a)[1]) != 0;
+#endif
+}
+
+#define SIMD_SPLAT(name, vt, lt, t) \
+  static inline v128 simd_##name(t x) { return (v128)((vt){0} + (lt)x); }
+
+SIMD_SPLAT(i8x16_splat, simd_u8x16, u8, u32)
+SIMD_SPLAT(i16x8_splat, simd_u16x8, u16, u32)
+SIMD_SPLAT(i32x4_splat, simd_u32x4, u32, u32)
+SIMD_SPLAT(i64x2_splat, simd_u64x2, u64, u64)
+
+// Not `0 + x`, which would lose the sign of -0 and the payload of NaNs.
+static inline v128 simd_f32x4_splat(f32 x) { return (v128)(simd_f32x4){x, x, x, x}; }
+static inline v128 simd_f64x2_splat(f64 x) { return (v128)(simd_f64x2){x, x}; }
+
+#define SIMD_EXTRACT_LANE(name, vt, t) \
+  static inline t simd_##name(v128 a, int lane) { return (t)((vt)a)[lane]; }
+
+SIMD_EXTRACT_LANE(i8x16_extract_lane_s, simd_s8x16, u32)
+SIMD_EXTRACT_LANE(i8x16_extract_lane_u, simd_u8x16, u32)
+SIMD_EXTRACT_LANE(i16x8_extract_lane_s, simd_s16x8, u32)
+SIMD_EXTRACT_LANE(i16x8_extract_lane_u, simd_u16x8, u32)
+SIMD_EXTRACT_LANE(i32x4_extract_lane, simd_u32x4, u32)
+SIMD_EXTRACT_LANE(i64x2_extract_lane, simd_u64x2, u64)
+SIMD_EXTRACT_LANE(f32x4_extract_lane, simd_f32x4, f32)
+SIMD_EXTRACT_LANE(f64x2_extract_lane, simd_f64x2, f64)
+
+#define SIMD_REPLACE_LANE(name, vt, lt, t)                  \
+  static inline v128 simd_##name(v128 a, int lane, t x) {   \
+    vt result = (vt)a;                                      \
+    result[lane] = (lt)x;                                   \
+    return (v128)result;                                    \
+  }
+
+SIMD_REPLACE_LANE(i8x16_replace_lane, simd_u8x16, u8, u32)
+SIMD_REPLACE_LANE(i16x8_replace_lane, simd_u16x8, u16, u32)
+SIMD_REPLACE_LANE(i32x4_replace_lane, simd_u32x4, u32, u32)
+SIMD_REPLACE_LANE(i64x2_replace_lane, simd_u64x2, u64, u64)
+SIMD_REPLACE_LANE(f32x4_replace_lane, simd_f32x4, f32, f32)
+SIMD_REPLACE_LANE(f64x2_replace_lane, simd_f64x2, f64, f64)
+
+// The shuffle indices must be constants, so this is a macro. It evaluates each
+// operand exactly once.
+#if defined(__clang__) || __GNUC__ >= 12
+#  define SIMD_I8X16_SHUFFLE(a, b, ...) \
+     ((v128)__builtin_shufflevector((simd_u8x16)(a), (simd_u8x16)(b), __VA_ARGS__))
+#else
+#  define SIMD_I8X16_SHUFFLE(a, b, ...) \
+     ((v128)__builtin_shuffle((simd_u8x16)(a), (simd_u8x16)(b), (simd_u8x16){__VA_ARGS__}))
+#endif
+
+#define SIMD_UNOP(name, vt, op) \
+  static inline v128 simd_##name(v128 a) { return (v128)(op(vt)a); }
+
+#define SIMD_BINOP(name, vt, op) \
+  static inline v128 simd_##name(v128 a, v128 b) { return (v128)((vt)a op (vt)b); }
+
+// Vector comparisons yield all-ones or all-zeroes lanes, as wasm requires.
+SIMD_BINOP(i8x16_eq, simd_u8x16, ==)
+SIMD_BINOP(i8x16_ne, simd_u8x16, !=)
+SIMD_BINOP(i8x16_lt_s, simd_s8x16, <)
+SIMD_BINOP(i8x16_lt_u, simd_u8x16, <)
+SIMD_BINOP(i8x16_gt_s, simd_s8x16, >)
+SIMD_BINOP(i8x16_gt_u, simd_u8x16, >)
+SIMD_BINOP(i8x16_le_s, simd_s8x16, <=)
+SIMD_BINOP(i8x16_le_u, simd_u8x16, <=)
+SIMD_BINOP(i8x16_ge_s, simd_s8x16, >=)
+SIMD_BINOP(i8x16_ge_u, simd_u8x16, >=)
+SIMD_BINOP(i16x8_eq, simd_u16x8, ==)
+SIMD_BINOP(i16x8_ne, simd_u16x8, !=)
+SIMD_BINOP(i16x8_lt_s, simd_s16x8, <)
+SIMD_BINOP(i16x8_lt_u, simd_u16x8, <)
+SIMD_BINOP(i16x8_gt_s, simd_s16x8, >)
+SIMD_BINOP(i16x8_gt_u, simd_u16x8, >)
+SIMD_BINOP(i16x8_le_s, simd_s16x8, <=)
+SIMD_BINOP(i16x8_le_u, simd_u16x8, <=)
+SIMD_BINOP(i16x8_ge_s, simd_s16x8, >=)
+SIMD_BINOP(i16x8_ge_u, simd_u16x8, >=)
+SIMD_BINOP(i32x4_eq, simd_u32x4, ==)
+SIMD_BINOP(i32x4_ne, simd_u32x4, !=)
+SIMD_BINOP(i32x4_lt_s, simd_s32x4, <)
+SIMD_BINOP(i32x4_lt_u, simd_u32x4, <)
+SIMD_BINOP(i32x4_gt_s, simd_s32x4, >)
+SIMD_BINOP(i32x4_gt_u, simd_u32x4, >)
+SIMD_BINOP(i32x4_le_s, simd_s32x4, <=)
+SIMD_BINOP(i32x4_le_u, simd_u32x4, <=)
+SIMD_BINOP(i32x4_ge_s, simd_s32x4, >=)
+SIMD_BINOP(i32x4_ge_u, simd_u32x4, >=)
+SIMD_BINOP(i64x2_eq, simd_u64x2, ==)
+SIMD_BINOP(i64x2_ne, simd_u64x2, !=)
+SIMD_BINOP(i64x2_lt_s, simd_s64x2, <)
+SIMD_BINOP(i64x2_gt_s, simd_s64x2, >)
+SIMD_BINOP(i64x2_le_s, simd_s64x2, <=)
+SIMD_BINOP(i64x2_ge_s, simd_s64x2, >=)
+SIMD_BINOP(f32x4_eq, simd_f32x4, ==)
+SIMD_BINOP(f32x4_ne, simd_f32x4, !=)
+SIMD_BINOP(f32x4_lt, simd_f32x4, <)
+SIMD_BINOP(f32x4_gt, simd_f32x4, >)
+SIMD_BINOP(f32x4_le, simd_f32x4, <=)
+SIMD_BINOP(f32x4_ge, simd_f32x4, >=)
+SIMD_BINOP(f64x2_eq, simd_f64x2, ==)
+SIMD_BINOP(f64x2_ne, simd_f64x2, !=)
+SIMD_BINOP(f64x2_lt, simd_f64x2, <)
+SIMD_BINOP(f64x2_gt, simd_f64x2, >)
+SIMD_BINOP(f64x2_le, simd_f64x2, <=)
+SIMD_BINOP(f64x2_ge, simd_f64x2, >=)
+
+// Integer arithmetic is done on unsigned lanes, so that it wraps.
+SIMD_BINOP(i8x16_add, simd_u8x16, +)
+SIMD_BINOP(i8x16_sub, simd_u8x16, -)
+SIMD_BINOP(i16x8_add, simd_u16x8, +)
+SIMD_BINOP(i16x8_sub, simd_u16x8, -)
+SIMD_BINOP(i16x8_mul, simd_u16x8, *)
+SIMD_BINOP(i32x4_add, simd_u32x4, +)
+SIMD_BINOP(i32x4_sub, simd_u32x4, -)
+SIMD_BINOP(i32x4_mul, simd_u32x4, *)
+SIMD_BINOP(i64x2_add, simd_u64x2, +)
+SIMD_BINOP(i64x2_sub, simd_u64x2, -)
+SIMD_BINOP(i64x2_mul, simd_u64x2, *)
+SIMD_UNOP(i8x16_neg, simd_u8x16, -)
+SIMD_UNOP(i16x8_neg, simd_u16x8, -)
+SIMD_UNOP(i32x4_neg, simd_u32x4, -)
+SIMD_UNOP(i64x2_neg, simd_u64x2, -)
+
+SIMD_BINOP(f32x4_add, simd_f32x4, +)
+SIMD_BINOP(f32x4_sub, simd_f32x4, -)
+SIMD_BINOP(f32x4_mul, simd_f32x4, *)
+SIMD_BINOP(f32x4_div, simd_f32x4, /)
+SIMD_BINOP(f64x2_add, simd_f64x2, +)
+SIMD_BINOP(f64x2_sub, simd_f64x2, -)
+SIMD_BINOP(f64x2_mul, simd_f64x2, *)
+SIMD_BINOP(f64x2_div, simd_f64x2, /)
+
+#define SIMD_SIGN_OP(name, vt, op, mask) \
+  static inline v128 simd_##name(v128 a) { return (v128)((vt)a op mask); }
+
+SIMD_SIGN_OP(f32x4_abs, simd_u32x4, &, 0x7fffffffu)
+SIMD_SIGN_OP(f32x4_neg, simd_u32x4, ^, 0x80000000u)
+SIMD_SIGN_OP(f64x2_abs, simd_u64x2, &, 0x7fffffffffffffffull)
+SIMD_SIGN_OP(f64x2_neg, simd_u64x2, ^, 0x8000000000000000ull)
+
+// abs(x) == (x ^ m) - m, where m is all-ones for negative lanes.
+#define SIMD_ABS(name, vt, svt, bits)                              \
+  static inline v128 simd_##name(v128 a) {                         \
+    vt mask = (vt)((svt)a >> (bits - 1));                          \
+    return (v128)(((vt)a ^ mask) - mask);                          \
+  }
+
+SIMD_ABS(i64x2_abs, simd_u64x2, simd_s64x2, 64)
+
+#define SIMD_SHIFT(name, vt, op, bits) \
+  static inline v128 simd_##name(v128 a, u32 count) { return (v128)((vt)a op (int)(count & (bits - 1))); }
+
+SIMD_SHIFT(i8x16_shl, simd_u8x16, <<, 8)
+SIMD_SHIFT(i8x16_shr_s, simd_s8x16, >>, 8)
+SIMD_SHIFT(i8x16_shr_u, simd_u8x16, >>, 8)
+SIMD_SHIFT(i16x8_shl, simd_u16x8, <<, 16)
+SIMD_SHIFT(i16x8_shr_s, simd_s16x8, >>, 16)
+SIMD_SHIFT(i16x8_shr_u, simd_u16x8, >>, 16)
+SIMD_SHIFT(i32x4_shl, simd_u32x4, <<, 32)
+SIMD_SHIFT(i32x4_shr_s, simd_s32x4, >>, 32)
+SIMD_SHIFT(i32x4_shr_u, simd_u32x4, >>, 32)
+SIMD_SHIFT(i64x2_shl, simd_u64x2, <<, 64)
+SIMD_SHIFT(i64x2_shr_s, simd_s64x2, >>, 64)
+SIMD_SHIFT(i64x2_shr_u, simd_u64x2, >>, 64)
+
+#define SIMD_ALL_TRUE(name, vt) \
+  static inline u32 simd_##name(v128 a) { return !simd_v128_any_true((v128)((vt)a == 0)); }
+
+SIMD_ALL_TRUE(i8x16_all_true, simd_u8x16)
+SIMD_ALL_TRUE(i16x8_all_true, simd_u16x8)
+SIMD_ALL_TRUE(i32x4_all_true, simd_u32x4)
+SIMD_ALL_TRUE(i64x2_all_true, simd_u64x2)
+
+#define SIMD_PMIN_PMAX(name, vt, op) \
+  static inline v128 simd_##name(v128 a, v128 b) { return simd_v128_bitselect(b, a, (v128)((vt)b op (vt)a)); }
+
+#define SIMD_LANEWISE_UNOP(name, vt, rvt, n, expr) \
+  static inline v128 simd_##name(v128 a) {         \
+    vt x = (vt)a;                                  \
+    rvt result;                                    \
+    for (int i = 0; i < n; ++i) {                  \
+      result[i] = expr;                            \
+    }                                              \
+    return (v128)result;                           \
+  }
+
+#define SIMD_LANEWISE_BINOP(name, vt, rvt, n, expr) \
+  static inline v128 simd_##name(v128 a, v128 b) {  \
+    vt x = (vt)a, y = (vt)b;                        \
+    rvt result;                                     \
+    for (int i = 0; i < n; ++i) {                   \
+      result[i] = expr;                             \
+    }                                               \
+    return (v128)result;                            \
+  }
+
+SIMD_LANEWISE_UNOP(f32x4_convert_i32x4_u, simd_u32x4, simd_f32x4, 4, (f32)x[i])
+SIMD_LANEWISE_UNOP(i32x4_trunc_sat_f32x4_u, simd_f32x4, simd_u32x4, 4, I32_TRUNC_SAT_U_F32(x[i]))
+SIMD_LANEWISE_UNOP(i32x4_trunc_sat_f64x2_s_zero, simd_f64x2, simd_u32x4, 4,
+                   i < 2 ? I32_TRUNC_SAT_S_F64(x[i]) : 0)
+SIMD_LANEWISE_UNOP(i32x4_trunc_sat_f64x2_u_zero, simd_f64x2, simd_u32x4, 4,
+                   i < 2 ? I32_TRUNC_SAT_U_F64(x[i]) : 0)
+SIMD_LANEWISE_UNOP(f64x2_convert_low_i32x4_u, simd_u32x4, simd_f64x2, 2, (f64)x[i])
+
+#ifdef WASM_SIMD_USE_SSE4_1
+
+#define SIMD_SSE_UNOP(name, f) \
+  static inline v128 simd_##name(v128 a) { return (v128)f((__m128i)a); }
+#define SIMD_SSE_BINOP(name, f) \
+  static inline v128 simd_##name(v128 a, v128 b) { return (v128)f((__m128i)a, (__m128i)b); }
+#define SIMD_SSE_UNOP_PS(name, f) \
+  static inline v128 simd_##name(v128 a) { return (v128)f((__m128)a); }
+#define SIMD_SSE_UNOP_PD(name, f) \
+  static inline v128 simd_##name(v128 a) { return (v128)f((__m128d)a); }
+
+SIMD_SSE_UNOP(i8x16_abs, _mm_abs_epi8)
+SIMD_SSE_UNOP(i16x8_abs, _mm_abs_epi16)
+SIMD_SSE_UNOP(i32x4_abs, _mm_abs_epi32)
+
+SIMD_SSE_BINOP(i8x16_add_sat_s, _mm_adds_epi8)
+SIMD_SSE_BINOP(i8x16_add_sat_u, _mm_adds_epu8)
+SIMD_SSE_BINOP(i8x16_sub_sat_s, _mm_subs_epi8)
+SIMD_SSE_BINOP(i8x16_sub_sat_u, _mm_subs_epu8)
+SIMD_SSE_BINOP(i16x8_add_sat_s, _mm_adds_epi16)
+SIMD_SSE_BINOP(i16x8_add_sat_u, _mm_adds_epu16)
+SIMD_SSE_BINOP(i16x8_sub_sat_s, _mm_subs_epi16)
+SIMD_SSE_BINOP(i16x8_sub_sat_u, _mm_subs_epu16)
+
+SIMD_SSE_BINOP(i8x16_min_s, _mm_min_epi8)
+SIMD_SSE_BINOP(i8x16_min_u, _mm_min_epu8)
+SIMD_SSE_BINOP(i8x16_max_s, _mm_max_epi8)
+SIMD_SSE_BINOP(i8x16_max_u, _mm_max_epu8)
+SIMD_SSE_BINOP(i16x8_min_s, _mm_min_epi16)
+SIMD_SSE_BINOP(i16x8_min_u, _mm_min_epu16)
+SIMD_SSE_BINOP(i16x8_max_s, _mm_max_epi16)
+SIMD_SSE_BINOP(i16x8_max_u, _mm_max_epu16)
+SIMD_SSE_BINOP(i32x4_min_s, _mm_min_epi32)
+SIMD_SSE_BINOP(i32x4_min_u, _mm_min_epu32)
+SIMD_SSE_BINOP(i32x4_max_s, _mm_max_epi32)
+SIMD_SSE_BINOP(i32x4_max_u, _mm_max_epu32)
+
+SIMD_SSE_BINOP(i8x16_avgr_u, _mm_avg_epu8)
+SIMD_SSE_BINOP(i16x8_avgr_u, _mm_avg_epu16)
+
+SIMD_SSE_BINOP(i8x16_narrow_i16x8_s, _mm_packs_epi16)
+SIMD_SSE_BINOP(i8x16_narrow_i16x8_u, _mm_packus_epi16)
+SIMD_SSE_BINOP(i16x8_narrow_i32x4_s, _mm_packs_epi32)
+SIMD_SSE_BINOP(i16x8_narrow_i32x4_u, _mm_packus_epi32)
+
+SIMD_SSE_BINOP(i32x4_dot_i16x8_s, _mm_madd_epi16)
+
+static inline __m128i simd_sse_high_half(__m128i a) {
+  return _mm_unpackhi_epi64(a, a);
+}
+
+#define SIMD_SSE_EXTEND(name_low, name_high, f)                                       \
+  static inline v128 simd_##name_low(v128 a) { return (v128)f((__m128i)a); }          \
+  static inline v128 simd_##name_high(v128 a) { return (v128)f(simd_sse_high_half((__m128i)a)); }
+
+SIMD_SSE_EXTEND(i16x8_extend_low_i8x16_s, i16x8_extend_high_i8x16_s, _mm_cvtepi8_epi16)
+SIMD_SSE_EXTEND(i16x8_extend_low_i8x16_u, i16x8_extend_high_i8x16_u, _mm_cvtepu8_epi16)
+SIMD_SSE_EXTEND(i32x4_extend_low_i16x8_s, i32x4_extend_high_i16x8_s, _mm_cvtepi16_epi32)
+SIMD_SSE_EXTEND(i32x4_extend_low_i16x8_u, i32x4_extend_high_i16x8_u, _mm_cvtepu16_epi32)
+SIMD_SSE_EXTEND(i64x2_extend_low_i32x4_s, i64x2_extend_high_i32x4_s, _mm_cvtepi32_epi64)
+SIMD_SSE_EXTEND(i64x2_extend_low_i32x4_u, i64x2_extend_high_i32x4_u, _mm_cvtepu32_epi64)
+
+static inline v128 simd_i16x8_extadd_pairwise_i8x16_s(v128 a) {
+  return (v128)_mm_maddubs_epi16(_mm_set1_epi8(1), (__m128i)a);
+}
+
+static inline v128 simd_i16x8_extadd_pairwise_i8x16_u(v128 a) {
+  return (v128)_mm_maddubs_epi16((__m128i)a, _mm_set1_epi8(1));
+}
+
+static inline v128 simd_i32x4_extadd_pairwise_i16x8_s(v128 a) {
+  return (v128)_mm_madd_epi16((__m128i)a, _mm_set1_epi16(1));
+}
+
+static inline v128 simd_i32x4_extadd_pairwise_i16x8_u(v128 a) {
+  // Bias the lanes into the signed range, then undo the bias of the pair.
+  __m128i biased = _mm_xor_si128((__m128i)a, _mm_set1_epi16(-0x8000));
+  return (v128)_mm_add_epi32(_mm_madd_epi16(biased, _mm_set1_epi16(1)),
+                             _mm_set1_epi32(0x10000));
+}
+
+static inline v128 simd_i16x8_q15mulr_sat_s(v128 a, v128 b) {
+  // pmulhrsw only differs from wasm for 0x8000 * 0x8000, where it yields
+  // 0x8000 rather than the saturated 0x7fff.
+  __m128i result = _mm_mulhrs_epi16((__m128i)a, (__m128i)b);
+  return (v128)_mm_xor_si128(result, _mm_cmpeq_epi16(result, _mm_set1_epi16(-0x8000)));
+}
+
+static inline v128 simd_i8x16_swizzle(v128 a, v128 s) {
+  // Indices above 15 get their top bit set, which makes pshufb write a zero.
+  return (v128)_mm_shuffle_epi8((__m128i)a, _mm_adds_epu8((__m128i)s, _mm_set1_epi8(0x70)));
+}
+
+static inline v128 simd_i8x16_popcnt(v128 a) {
+  const __m128i table = _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m128i mask = _mm_set1_epi8(0x0f);
+  __m128i low = _mm_and_si128((__m128i)a, mask);
+  __m128i high = _mm_and_si128(_mm_srli_epi16((__m128i)a, 4), mask);
+  return (v128)_mm_add_epi8(_mm_shuffle_epi8(table, low), _mm_shuffle_epi8(table, high));
+}
+
+static inline u32 simd_i8x16_bitmask(v128 a) {
+  return _mm_movemask_epi8((__m128i)a);
+}
+
+static inline u32 simd_i16x8_bitmask(v128 a) {
+  return _mm_movemask_epi8(_mm_packs_epi16((__m128i)a, _mm_setzero_si128()));
+}
+
+static inline u32 simd_i32x4_bitmask(v128 a) {
+  return _mm_movemask_ps((__m128)a);
+}
+
+static inline u32 simd_i64x2_bitmask(v128 a) {
+  return _mm_movemask_pd((__m128d)a);
+}
+
+#define SIMD_SSE_ROUND(name_ps, name_pd, mode)                                              \
+  static inline v128 simd_##name_ps(v128 a) {                                               \
+    return (v128)_mm_round_ps((__m128)a, mode | _MM_FROUND_NO_EXC);                         \
+  }                                                                                         \
+  static inline v128 simd_##name_pd(v128 a) {                                               \
+    return (v128)_mm_round_pd((__m128d)a, mode | _MM_FROUND_NO_EXC);                        \
+  }
+
+SIMD_SSE_ROUND(f32x4_ceil, f64x2_ceil, _MM_FROUND_TO_POS_INF)
+SIMD_SSE_ROUND(f32x4_floor, f64x2_floor, _MM_FROUND_TO_NEG_INF)
+SIMD_SSE_ROUND(f32x4_trunc, f64x2_trunc, _MM_FROUND_TO_ZERO)
+SIMD_SSE_ROUND(f32x4_nearest, f64x2_nearest, _MM_FROUND_TO_NEAREST_INT)
+SIMD_SSE_UNOP_PS(f32x4_sqrt, _mm_sqrt_ps)
+SIMD_SSE_UNOP_PD(f64x2_sqrt, _mm_sqrt_pd)
+
+// minps/maxps return their second operand when either is a NaN, and do not
+// order -0 and +0. Evaluate both operand orders and merge the results; any NaN
+// lane is then replaced by a canonical NaN.
+#define SIMD_SSE_FMIN(name, t, sfx, nan_shift)                                            \
+  static inline v128 simd_##name(v128 a, v128 b) {                                        \
+    t x = (t)a, y = (t)b;                                                                 \
+    t result = _mm_or_##sfx(_mm_min_##sfx(y, x), _mm_min_##sfx(x, y));                    \
+    t nan = _mm_cmpunord_##sfx(result, result);                                           \
+    result = _mm_or_##sfx(result, nan);                                                   \
+    return (v128)_mm_andnot_##sfx((t)nan_shift((__m128i)nan), result);                    \
+  }
+
+#define SIMD_SSE_FMAX(name, t, sfx, nan_shift)                                            \
+  static inline v128 simd_##name(v128 a, v128 b) {                                        \
+    t x = (t)a, y = (t)b;                                                                 \
+    t r1 = _mm_max_##sfx(y, x), r2 = _mm_max_##sfx(x, y);                                 \
+    t diff = _mm_xor_##sfx(r1, r2);                                                       \
+    t result = _mm_sub_##sfx(_mm_or_##sfx(r1, diff), diff);                               \
+    t nan = _mm_cmpunord_##sfx(result, result);                                           \
+    return (v128)_mm_andnot_##sfx((t)nan_shift((__m128i)nan), _mm_or_##sfx(result, nan)); \
+  }
+
+#define SIMD_SSE_NAN_SHIFT_PS(x) _mm_srli_epi32(x, 10)
+#define SIMD_SSE_NAN_SHIFT_PD(x) _mm_srli_epi64(x, 13)
+
+SIMD_SSE_FMIN(f32x4_min, __m128, ps, SIMD_SSE_NAN_SHIFT_PS)
+SIMD_SSE_FMAX(f32x4_max, __m128, ps, SIMD_SSE_NAN_SHIFT_PS)
+SIMD_SSE_FMIN(f64x2_min, __m128d, pd, SIMD_SSE_NAN_SHIFT_PD)
+SIMD_SSE_FMAX(f64x2_max, __m128d, pd, SIMD_SSE_NAN_SHIFT_PD)
+
+// minps(b, a) is `b < a ? b : a`, which is exactly pmin.
+static inline v128 simd_f32x4_pmin(v128 a, v128 b) { return (v128)_mm_min_ps((__m128)b, (__m128)a); }
+static inline v128 simd_f32x4_pmax(v128 a, v128 b) { return (v128)_mm_max_ps((__m128)b, (__m128)a); }
+static inline v128 simd_f64x2_pmin(v128 a, v128 b) { return (v128)_mm_min_pd((__m128d)b, (__m128d)a); }
+static inline v128 simd_f64x2_pmax(v128 a, v128 b) { return (v128)_mm_max_pd((__m128d)b, (__m128d)a); }
+
+SIMD_SSE_UNOP(f32x4_convert_i32x4_s, _mm_cvtepi32_ps)
+SIMD_SSE_UNOP(f64x2_convert_low_i32x4_s, _mm_cvtepi32_pd)
+SIMD_SSE_UNOP_PD(f32x4_demote_f64x2_zero, _mm_cvtpd_ps)
+SIMD_SSE_UNOP_PS(f64x2_promote_low_f32x4, _mm_cvtps_pd)
+
+static inline v128 simd_i32x4_trunc_sat_f32x4_s(v128 a) {
+  // cvttps2dq yields 0x80000000 for NaN and out-of-range lanes. Zero the NaN
+  // lanes first, then flip the result of lanes that overflowed upwards.
+  __m128 x = _mm_and_ps((__m128)a, _mm_cmpeq_ps((__m128)a, (__m128)a));
+  __m128i overflow = (__m128i)_mm_cmpge_ps(x, _mm_set1_ps(2147483648.f));
+  return (v128)_mm_xor_si128(_mm_cvttps_epi32(x), overflow);
+}
+
+#else
+
+SIMD_ABS(i8x16_abs, simd_u8x16, simd_s8x16, 8)
+SIMD_ABS(i16x8_abs, simd_u16x8, simd_s16x8, 16)
+SIMD_ABS(i32x4_abs, simd_u32x4, simd_s32x4, 32)
+
+SIMD_LANEWISE_BINOP(i8x16_add_sat_s, simd_s8x16, simd_s8x16, 16, SIMD_SAT(x[i] + y[i], -128, 127))
+SIMD_LANEWISE_BINOP(i8x16_add_sat_u, simd_u8x16, simd_u8x16, 16, SIMD_SAT(x[i] + y[i], 0, 255))
+SIMD_LANEWISE_BINOP(i8x16_sub_sat_s, simd_s8x16, simd_s8x16, 16, SIMD_SAT(x[i] - y[i], -128, 127))
+SIMD_LANEWISE_BINOP(i8x16_sub_sat_u, simd_u8x16, simd_u8x16, 16, SIMD_SAT(x[i] - y[i], 0, 255))
+SIMD_LANEWISE_BINOP(i16x8_add_sat_s, simd_s16x8, simd_s16x8, 8, SIMD_SAT(x[i] + y[i], -32768, 32767))
+SIMD_LANEWISE_BINOP(i16x8_add_sat_u, simd_u16x8, simd_u16x8, 8, SIMD_SAT(x[i] + y[i], 0, 65535))
+SIMD_LANEWISE_BINOP(i16x8_sub_sat_s, simd_s16x8, simd_s16x8, 8, SIMD_SAT(x[i] - y[i], -32768, 32767))
+SIMD_LANEWISE_BINOP(i16x8_sub_sat_u, simd_u16x8, simd_u16x8, 8, SIMD_SAT(x[i] - y[i], 0, 65535))
+
+#define SIMD_MIN_MAX(name, vt, op) \
+  static inline v128 simd_##name(v128 a, v128 b) { return simd_v128_bitselect(a, b, (v128)((vt)a op (vt)b)); }
+
+SIMD_MIN_MAX(i8x16_min_s, simd_s8x16, <)
+SIMD_MIN_MAX(i8x16_min_u, simd_u8x16, <)
+SIMD_MIN_MAX(i8x16_max_s, simd_s8x16, >)
+SIMD_MIN_MAX(i8x16_max_u, simd_u8x16, >)
+SIMD_MIN_MAX(i16x8_min_s, simd_s16x8, <)
+SIMD_MIN_MAX(i16x8_min_u, simd_u16x8, <)
+SIMD_MIN_MAX(i16x8_max_s, simd_s16x8, >)
+SIMD_MIN_MAX(i16x8_max_u, simd_u16x8, >)
+SIMD_MIN_MAX(i32x4_min_s, simd_s32x4, <)
+SIMD_MIN_MAX(i32x4_min_u, simd_u32x4, <)
+SIMD_MIN_MAX(i32x4_max_s, simd_s32x4, >)
+SIMD_MIN_MAX(i32x4_max_u, simd_u32x4, >)
+
+// (a + b + 1) / 2 without overflowing the lane.
+#define SIMD_AVGR(name, vt) \
+  static inline v128 simd_##name(v128 a, v128 b) { return (v128)(((vt)a | (vt)b) - (((vt)a ^ (vt)b) >> 1)); }
+
+SIMD_AVGR(i8x16_avgr_u, simd_u8x16)
+SIMD_AVGR(i16x8_avgr_u, simd_u16x8)
+
+#define SIMD_NARROW(name, vt, rvt, n, min, max)       \
+  static inline v128 simd_##name(v128 a, v128 b) {    \
+    vt x = (vt)a, y = (vt)b;                          \
+    rvt result;                                       \
+    for (int i = 0; i < n; ++i) {                     \
+      result[i] = SIMD_SAT(x[i], min, max);           \
+      result[i + n] = SIMD_SAT(y[i], min, max);       \
+    }                                                 \
+    return (v128)result;                              \
+  }
+
+SIMD_NARROW(i8x16_narrow_i16x8_s, simd_s16x8, simd_s8x16, 8, -128, 127)
+SIMD_NARROW(i8x16_narrow_i16x8_u, simd_s16x8, simd_u8x16, 8, 0, 255)
+SIMD_NARROW(i16x8_narrow_i32x4_s, simd_s32x4, simd_s16x8, 4, -32768, 32767)
+SIMD_NARROW(i16x8_narrow_i32x4_u, simd_s32x4, simd_u16x8, 4, 0, 65535)
+
+SIMD_LANEWISE_BINOP(i32x4_dot_i16x8_s, simd_s16x8, simd_u32x4, 4,
+                    (u32)(x[2 * i] * y[2 * i]) + (u32)(x[2 * i + 1] * y[2 * i + 1]))
+
+SIMD_LANEWISE_UNOP(i16x8_extend_low_i8x16_s, simd_s8x16, simd_s16x8, 8, x[i])
+SIMD_LANEWISE_UNOP(i16x8_extend_high_i8x16_s, simd_s8x16, simd_s16x8, 8, x[i + 8])
+SIMD_LANEWISE_UNOP(i16x8_extend_low_i8x16_u, simd_u8x16, simd_u16x8, 8, x[i])
+SIMD_LANEWISE_UNOP(i16x8_extend_high_i8x16_u, simd_u8x16, simd_u16x8, 8, x[i + 8])
+SIMD_LANEWISE_UNOP(i32x4_extend_low_i16x8_s, simd_s16x8, simd_s32x4, 4, x[i])
+SIMD_LANEWISE_UNOP(i32x4_extend_high_i16x8_s, simd_s16x8, simd_s32x4, 4, x[i + 4])
+SIMD_LANEWISE_UNOP(i32x4_extend_low_i16x8_u, simd_u16x8, simd_u32x4, 4, x[i])
+SIMD_LANEWISE_UNOP(i32x4_extend_high_i16x8_u, simd_u16x8, simd_u32x4, 4, x[i + 4])
+SIMD_LANEWISE_UNOP(i64x2_extend_low_i32x4_s, simd_s32x4, simd_s64x2, 2, x[i])
+SIMD_LANEWISE_UNOP(i64x2_extend_high_i32x4_s, simd_s32x4, simd_s64x2, 2, x[i + 2])
+SIMD_LANEWISE_UNOP(i64x2_extend_low_i32x4_u, simd_u32x4, simd_u64x2, 2, x[i])
+SIMD_LANEWISE_UNOP(i64x2_extend_high_i32x4_u, simd_u32x4, simd_u64x2, 2, x[i + 2])
+
+SIMD_LANEWISE_UNOP(i16x8_extadd_pairwise_i8x16_s, simd_s8x16, simd_s16x8, 8, x[2 * i] + x[2 * i + 1])
+SIMD_LANEWISE_UNOP(i16x8_extadd_pairwise_i8x16_u, simd_u8x16, simd_u16x8, 8, x[2 * i] + x[2 * i + 1])
+SIMD_LANEWISE_UNOP(i32x4_extadd_pairwise_i16x8_s, simd_s16x8, simd_s32x4, 4, x[2 * i] + x[2 * i + 1])
+SIMD_LANEWISE_UNOP(i32x4_extadd_pairwise_i16x8_u, simd_u16x8, simd_u32x4, 4, x[2 * i] + x[2 * i + 1])
+
+SIMD_LANEWISE_BINOP(i16x8_q15mulr_sat_s, simd_s16x8, simd_s16x8, 8,
+                    SIMD_SAT((x[i] * y[i] + 0x4000) >> 15, -32768, 32767))
+
+SIMD_LANEWISE_BINOP(i8x16_swizzle, simd_u8x16, simd_u8x16, 16, y[i] < 16 ? x[y[i]] : 0)
+
+static inline v128 simd_i8x16_popcnt(v128 a) {
+  simd_u8x16 x = (simd_u8x16)a;
+  x = x - ((x >> 1) & 0x55);
+  x = (x & 0x33) + ((x >> 2) & 0x33);
+  return (v128)((x + (x >> 4)) & 0x0f);
+}
+
+#define SIMD_BITMASK(name, vt, n, bits)                         \
+  static inline u32 simd_##name(v128 a) {                       \
+    vt x = (vt)a;                                               \
+    u32 result = 0;                                             \
+    for (int i = 0; i < n; ++i) {                               \
+      result |= (u32)(x[i] >> (bits - 1)) << i;                 \
+    }                                                           \
+    return result;                                              \
+  }
+
+SIMD_BITMASK(i8x16_bitmask, simd_u8x16, 16, 8)
+SIMD_BITMASK(i16x8_bitmask, simd_u16x8, 8, 16)
+SIMD_BITMASK(i32x4_bitmask, simd_u32x4, 4, 32)
+SIMD_BITMASK(i64x2_bitmask, simd_u64x2, 2, 64)
+
+SIMD_LANEWISE_UNOP(f32x4_ceil, simd_f32x4, simd_f32x4, 4, ceilf(x[i]))
+SIMD_LANEWISE_UNOP(f32x4_floor, simd_f32x4, simd_f32x4, 4, floorf(x[i]))
+SIMD_LANEWISE_UNOP(f32x4_trunc, simd_f32x4, simd_f32x4, 4, truncf(x[i]))
+SIMD_LANEWISE_UNOP(f32x4_nearest, simd_f32x4, simd_f32x4, 4, nearbyintf(x[i]))
+SIMD_LANEWISE_UNOP(f32x4_sqrt, simd_f32x4, simd_f32x4, 4, sqrtf(x[i]))
+SIMD_LANEWISE_UNOP(f64x2_ceil, simd_f64x2, simd_f64x2, 2, ceil(x[i]))
+SIMD_LANEWISE_UNOP(f64x2_floor, simd_f64x2, simd_f64x2, 2, floor(x[i]))
+SIMD_LANEWISE_UNOP(f64x2_trunc, simd_f64x2, simd_f64x2, 2, trunc(x[i]))
+SIMD_LANEWISE_UNOP(f64x2_nearest, simd_f64x2, simd_f64x2, 2, nearbyint(x[i]))
+SIMD_LANEWISE_UNOP(f64x2_sqrt, simd_f64x2, simd_f64x2, 2, sqrt(x[i]))
+
+SIMD_LANEWISE_BINOP(f32x4_min, simd_f32x4, simd_f32x4, 4, FMIN(x[i], y[i]))
+SIMD_LANEWISE_BINOP(f32x4_max, simd_f32x4, simd_f32x4, 4, FMAX(x[i], y[i]))
+SIMD_LANEWISE_BINOP(f64x2_min, simd_f64x2, simd_f64x2, 2, FMIN(x[i], y[i]))
+SIMD_LANEWISE_BINOP(f64x2_max, simd_f64x2, simd_f64x2, 2, FMAX(x[i], y[i]))
+
+SIMD_PMIN_PMAX(f32x4_pmin, simd_f32x4, <)
+SIMD_PMIN_PMAX(f32x4_pmax, simd_f32x4, >)
+SIMD_PMIN_PMAX(f64x2_pmin, simd_f64x2, <)
+SIMD_PMIN_PMAX(f64x2_pmax, simd_f64x2, >)
+
+SIMD_LANEWISE_UNOP(f32x4_convert_i32x4_s, simd_s32x4, simd_f32x4, 4, (f32)x[i])
+SIMD_LANEWISE_UNOP(f64x2_convert_low_i32x4_s, simd_s32x4, simd_f64x2, 2, (f64)x[i])
+SIMD_LANEWISE_UNOP(f32x4_demote_f64x2_zero, simd_f64x2, simd_f32x4, 4, i < 2 ? (f32)x[i] : 0)
+SIMD_LANEWISE_UNOP(f64x2_promote_low_f32x4, simd_f32x4, simd_f64x2, 2, (f64)x[i])
+SIMD_LANEWISE_UNOP(i32x4_trunc_sat_f32x4_s, simd_f32x4, simd_u32x4, 4, I32_TRUNC_SAT_S_F32(x[i]))
+
+#endif
+
+#define SIMD_EXTMUL(name, mul, extend) \
+  static inline v128 simd_##name(v128 a, v128 b) { return simd_##mul(simd_##extend(a), simd_##extend(b)); }
+
+SIMD_EXTMUL(i16x8_extmul_low_i8x16_s, i16x8_mul, i16x8_extend_low_i8x16_s)
+SIMD_EXTMUL(i16x8_extmul_high_i8x16_s, i16x8_mul, i16x8_extend_high_i8x16_s)
+SIMD_EXTMUL(i16x8_extmul_low_i8x16_u, i16x8_mul, i16x8_extend_low_i8x16_u)
+SIMD_EXTMUL(i16x8_extmul_high_i8x16_u, i16x8_mul, i16x8_extend_high_i8x16_u)
+SIMD_EXTMUL(i32x4_extmul_low_i16x8_s, i32x4_mul, i32x4_extend_low_i16x8_s)
+SIMD_EXTMUL(i32x4_extmul_high_i16x8_s, i32x4_mul, i32x4_extend_high_i16x8_s)
+SIMD_EXTMUL(i32x4_extmul_low_i16x8_u, i32x4_mul, i32x4_extend_low_i16x8_u)
+SIMD_EXTMUL(i32x4_extmul_high_i16x8_u, i32x4_mul, i32x4_extend_high_i16x8_u)
+SIMD_EXTMUL(i64x2_extmul_low_i32x4_s, i64x2_mul, i64x2_extend_low_i32x4_s)
+SIMD_EXTMUL(i64x2_extmul_high_i32x4_s, i64x2_mul, i64x2_extend_high_i32x4_s)
+SIMD_EXTMUL(i64x2_extmul_low_i32x4_u, i64x2_mul, i64x2_extend_low_i32x4_u)
+SIMD_EXTMUL(i64x2_extmul_high_i32x4_u, i64x2_mul, i64x2_extend_high_i32x4_u)
+
+DEFINE_LOAD(v128_load, v128, v128, v128);
+DEFINE_STORE(v128_store, v128, v128);
+
+#define DEFINE_SIMD_LOAD(name, load, expr)                                                          \
+  static inline v128 name##_unchecked_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size,     \
+                                             u64 addr, u32 shadow_class, const char* func_name) {   \
+    u64 x = load##_unchecked_cached(mem, mem_data, mem_size, addr, shadow_class, func_name);        \
+    return expr;                                                                                    \
+  }                                                                                                 \
+  static inline v128 name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,     \
+                                   u32 shadow_class, const char* func_name) {                       \
+    u64 x = load##_cached(mem, mem_data, mem_size, addr, shadow_class, func_name);                  \
+    return expr;                                                                                    \
+  }                                                                                                 \
+  static inline v128 name##_unchecked(wasm_rt_memory_t* mem, u64 addr, u32 shadow_class,            \
+                                      const char* func_name) {                                      \
+    return name##_unchecked_cached(mem, mem->data, MEM_SIZE(mem), addr, shadow_class, func_name);    \
+  }                                                                                                 \
+  static inline v128 name(wasm_rt_memory_t* mem, u64 addr, u32 shadow_class,                        \
+                          const char* func_name) {                                                  \
+    return name##_cached(mem, mem->data, MEM_SIZE(mem), addr, shadow_class, func_name);              \
+  }
+
+DEFINE_SIMD_LOAD(v128_load8x8_s, i64_load, simd_i16x8_extend_low_i8x16_s(simd_v128_const(x, 0)))
+DEFINE_SIMD_LOAD(v128_load8x8_u, i64_load, simd_i16x8_extend_low_i8x16_u(simd_v128_const(x, 0)))
+DEFINE_SIMD_LOAD(v128_load16x4_s, i64_load, simd_i32x4_extend_low_i16x8_s(simd_v128_const(x, 0)))
+DEFINE_SIMD_LOAD(v128_load16x4_u, i64_load, simd_i32x4_extend_low_i16x8_u(simd_v128_const(x, 0)))
+DEFINE_SIMD_LOAD(v128_load32x2_s, i64_load, simd_i64x2_extend_low_i32x4_s(simd_v128_const(x, 0)))
+DEFINE_SIMD_LOAD(v128_load32x2_u, i64_load, simd_i64x2_extend_low_i32x4_u(simd_v128_const(x, 0)))
+DEFINE_SIMD_LOAD(v128_load8_splat, i32_load8_u, simd_i8x16_splat((u32)x))
+DEFINE_SIMD_LOAD(v128_load16_splat, i32_load16_u, simd_i16x8_splat((u32)x))
+DEFINE_SIMD_LOAD(v128_load32_splat, i32_load, simd_i32x4_splat((u32)x))
+DEFINE_SIMD_LOAD(v128_load64_splat, i64_load, simd_i64x2_splat(x))
+DEFINE_SIMD_LOAD(v128_load32_zero, i32_load, simd_v128_const(x, 0))
+DEFINE_SIMD_LOAD(v128_load64_zero, i64_load, simd_v128_const(x, 0))
+
+#define DEFINE_SIMD_LOAD_LANE(name, load, replace)                                                  \
+  static inline v128 name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,     \
+                                   v128 vec, int lane, u32 shadow_class, const char* func_name) {   \
+    return replace(vec, lane, load##_cached(mem, mem_data, mem_size, addr, shadow_class,            \
+                                            func_name));                                            \
+  }                                                                                                 \
+  static inline v128 name(wasm_rt_memory_t* mem, u64 addr, v128 vec, int lane,                      \
+                          u32 shadow_class, const char* func_name) {                                \
+    return name##_cached(mem, mem->data, MEM_SIZE(mem), addr, vec, lane, shadow_class, func_name);   \
+  }
+
+DEFINE_SIMD_LOAD_LANE(v128_load8_lane, i32_load8_u, simd_i8x16_replace_lane)
+DEFINE_SIMD_LOAD_LANE(v128_load16_lane, i32_load16_u, simd_i16x8_replace_lane)
+DEFINE_SIMD_LOAD_LANE(v128_load32_lane, i32_load, simd_i32x4_replace_lane)
+DEFINE_SIMD_LOAD_LANE(v128_load64_lane, i64_load, simd_i64x2_replace_lane)
+
+#define DEFINE_SIMD_STORE_LANE(name, store, extract)                                                \
+  static inline void name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,     \
+                                   v128 vec, int lane, u32 shadow_class, const char* func_name) {   \
+    store##_cached(mem, mem_data, mem_size, addr, extract(vec, lane), shadow_class, func_name);     \
+  }                                                                                                 \
+  static inline void name(wasm_rt_memory_t* mem, u64 addr, v128 vec, int lane,                      \
+                          u32 shadow_class, const char* func_name) {                                \
+    name##_cached(mem, mem->data, MEM_SIZE(mem), addr, vec, lane, shadow_class, func_name);          \
+  }
+
+DEFINE_SIMD_STORE_LANE(v128_store8_lane, i32_store8, simd_i8x16_extract_lane_u)
+DEFINE_SIMD_STORE_LANE(v128_store16_lane, i32_store16, simd_i16x8_extract_lane_u)
+DEFINE_SIMD_STORE_LANE(v128_store32_lane, i32_store, simd_i32x4_extract_lane)
+DEFINE_SIMD_STORE_LANE(v128_store64_lane, i64_store, simd_i64x2_extract_lane)
+struct wasm2c_sandbox_t {
+  wasm_sandbox_wasi_data wasi_data;
+  wasm_rt_memory_t w2c_M0;
+  u32 w2c_T0_current_index;
+  wasm_rt_table_t w2c_T0;
+  u32 func_types[8];
+};
+
+
+static void init_func_types(wasm2c_sandbox_t* const sbx) {
+  sbx->func_types[0] = 0xa4000124u;
+  sbx->func_types[1] = 0x94000024u;
+  sbx->func_types[2] = 0x94000004u;
+  sbx->func_types[3] = 0xa4000104u;
+  sbx->func_types[4] = 0xb4000924u;
+  sbx->func_types[5] = 0xa400011cu;
+  sbx->func_types[6] = 0x94000020u;
+  sbx->func_types[7] = 0xa4000120u;
+}
+
+FUNC_EXPORT v128 w2c_i32x4_add(wasm2c_sandbox_t* const, v128, v128);
+FUNC_EXPORT v128 w2c_i8x16_add_sat_s(wasm2c_sandbox_t* const, v128, v128);
+FUNC_EXPORT v128 w2c_i16x8_sub_sat_u(wasm2c_sandbox_t* const, v128, v128);
+FUNC_EXPORT v128 w2c_i32x4_min_u(wasm2c_sandbox_t* const, v128, v128);
+FUNC_EXPORT v128 w2c_i8x16_narrow_i16x8_u(wasm2c_sandbox_t* const, v128, v128);
+FUNC_EXPORT v128 w2c_i32x4_extend_high_i16x8_s(wasm2c_sandbox_t* const, v128);
+FUNC_EXPORT v128 w2c_i16x8_extadd_pairwise_i8x16_u(wasm2c_sandbox_t* const, v128);
+FUNC_EXPORT v128 w2c_i32x4_dot_i16x8_s(wasm2c_sandbox_t* const, v128, v128);
+FUNC_EXPORT v128 w2c_i16x8_q15mulr_sat_s(wasm2c_sandbox_t* const, v128, v128);
+FUNC_EXPORT v128 w2c_i8x16_popcnt(wasm2c_sandbox_t* const, v128);
+FUNC_EXPORT u32 w2c_i8x16_bitmask(wasm2c_sandbox_t* const, v128);
+FUNC_EXPORT u32 w2c_v128_any_true(wasm2c_sandbox_t* const, v128);
+FUNC_EXPORT u32 w2c_i32x4_all_true(wasm2c_sandbox_t* const, v128);
+FUNC_EXPORT v128 w2c_i64x2_shl(wasm2c_sandbox_t* const, v128, u32);
+FUNC_EXPORT v128 w2c_i8x16_shr_s(wasm2c_sandbox_t* const, v128, u32);
+FUNC_EXPORT v128 w2c_v128_bitselect(wasm2c_sandbox_t* const, v128, v128, v128);
+FUNC_EXPORT v128 w2c_f32x4_min(wasm2c_sandbox_t* const, v128, v128);
+FUNC_EXPORT v128 w2c_f64x2_floor(wasm2c_sandbox_t* const, v128);
+FUNC_EXPORT v128 w2c_i32x4_trunc_sat_f32x4_s(wasm2c_sandbox_t* const, v128);
+FUNC_EXPORT v128 w2c_i8x16_shuffle(wasm2c_sandbox_t* const, v128, v128);
+FUNC_EXPORT v128 w2c_i8x16_swizzle(wasm2c_sandbox_t* const, v128, v128);
+FUNC_EXPORT u32 w2c_i16x8_extract_lane_s(wasm2c_sandbox_t* const, v128);
+FUNC_EXPORT v128 w2c_f64x2_replace_lane(wasm2c_sandbox_t* const, v128, f64);
+FUNC_EXPORT v128 w2c_i32x4_splat(wasm2c_sandbox_t* const, u32);
+FUNC_EXPORT v128 w2c_v128_load(wasm2c_sandbox_t* const, u32);
+FUNC_EXPORT v128 w2c_v128_load8x8_s(wasm2c_sandbox_t* const, u32);
+FUNC_EXPORT v128 w2c_v128_load32_splat(wasm2c_sandbox_t* const, u32);
+FUNC_EXPORT v128 w2c_v128_load64_zero(wasm2c_sandbox_t* const, u32);
+FUNC_EXPORT v128 w2c_v128_load16_lane(wasm2c_sandbox_t* const, u32, v128);
+FUNC_EXPORT v128 w2c_store_lane_and_load(wasm2c_sandbox_t* const, u32, v128);
+
+#if defined(ENTRY_PROLOGUE) || defined(ENTRY_EPILOGUE)
+FUNC_EXPORT v128 w2centry_w2c_i32x4_add(wasm2c_sandbox_t* const sbx, v128 p0, v128 p1) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_i32x4_add(sbx, p0, p1);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT v128 w2centry_w2c_i8x16_add_sat_s(wasm2c_sandbox_t* const sbx, v128 p0, v128 p1) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_i8x16_add_sat_s(sbx, p0, p1);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT v128 w2centry_w2c_i16x8_sub_sat_u(wasm2c_sandbox_t* const sbx, v128 p0, v128 p1) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_i16x8_sub_sat_u(sbx, p0, p1);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT v128 w2centry_w2c_i32x4_min_u(wasm2c_sandbox_t* const sbx, v128 p0, v128 p1) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_i32x4_min_u(sbx, p0, p1);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT v128 w2centry_w2c_i8x16_narrow_i16x8_u(wasm2c_sandbox_t* const sbx, v128 p0, v128 p1) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_i8x16_narrow_i16x8_u(sbx, p0, p1);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT v128 w2centry_w2c_i32x4_extend_high_i16x8_s(wasm2c_sandbox_t* const sbx, v128 p0) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_i32x4_extend_high_i16x8_s(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT v128 w2centry_w2c_i16x8_extadd_pairwise_i8x16_u(wasm2c_sandbox_t* const sbx, v128 p0) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_i16x8_extadd_pairwise_i8x16_u(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT v128 w2centry_w2c_i32x4_dot_i16x8_s(wasm2c_sandbox_t* const sbx, v128 p0, v128 p1) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_i32x4_dot_i16x8_s(sbx, p0, p1);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT v128 w2centry_w2c_i16x8_q15mulr_sat_s(wasm2c_sandbox_t* const sbx, v128 p0, v128 p1) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_i16x8_q15mulr_sat_s(sbx, p0, p1);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT v128 w2centry_w2c_i8x16_popcnt(wasm2c_sandbox_t* const sbx, v128 p0) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_i8x16_popcnt(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT u32 w2centry_w2c_i8x16_bitmask(wasm2c_sandbox_t* const sbx, v128 p0) {
+  ENTRY_PROLOGUE;
+  u32 ret = w2c_i8x16_bitmask(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT u32 w2centry_w2c_v128_any_true(wasm2c_sandbox_t* const sbx, v128 p0) {
+  ENTRY_PROLOGUE;
+  u32 ret = w2c_v128_any_true(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT u32 w2centry_w2c_i32x4_all_true(wasm2c_sandbox_t* const sbx, v128 p0) {
+  ENTRY_PROLOGUE;
+  u32 ret = w2c_i32x4_all_true(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT v128 w2centry_w2c_i64x2_shl(wasm2c_sandbox_t* const sbx, v128 p0, u32 p1) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_i64x2_shl(sbx, p0, p1);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT v128 w2centry_w2c_i8x16_shr_s(wasm2c_sandbox_t* const sbx, v128 p0, u32 p1) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_i8x16_shr_s(sbx, p0, p1);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT v128 w2centry_w2c_v128_bitselect(wasm2c_sandbox_t* const sbx, v128 p0, v128 p1, v128 p2) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_v128_bitselect(sbx, p0, p1, p2);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT v128 w2centry_w2c_f32x4_min(wasm2c_sandbox_t* const sbx, v128 p0, v128 p1) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_f32x4_min(sbx, p0, p1);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT v128 w2centry_w2c_f64x2_floor(wasm2c_sandbox_t* const sbx, v128 p0) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_f64x2_floor(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT v128 w2centry_w2c_i32x4_trunc_sat_f32x4_s(wasm2c_sandbox_t* const sbx, v128 p0) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_i32x4_trunc_sat_f32x4_s(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT v128 w2centry_w2c_i8x16_shuffle(wasm2c_sandbox_t* const sbx, v128 p0, v128 p1) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_i8x16_shuffle(sbx, p0, p1);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT v128 w2centry_w2c_i8x16_swizzle(wasm2c_sandbox_t* const sbx, v128 p0, v128 p1) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_i8x16_swizzle(sbx, p0, p1);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT u32 w2centry_w2c_i16x8_extract_lane_s(wasm2c_sandbox_t* const sbx, v128 p0) {
+  ENTRY_PROLOGUE;
+  u32 ret = w2c_i16x8_extract_lane_s(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT v128 w2centry_w2c_f64x2_replace_lane(wasm2c_sandbox_t* const sbx, v128 p0, f64 p1) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_f64x2_replace_lane(sbx, p0, p1);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT v128 w2centry_w2c_i32x4_splat(wasm2c_sandbox_t* const sbx, u32 p0) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_i32x4_splat(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT v128 w2centry_w2c_v128_load(wasm2c_sandbox_t* const sbx, u32 p0) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_v128_load(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT v128 w2centry_w2c_v128_load8x8_s(wasm2c_sandbox_t* const sbx, u32 p0) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_v128_load8x8_s(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT v128 w2centry_w2c_v128_load32_splat(wasm2c_sandbox_t* const sbx, u32 p0) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_v128_load32_splat(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT v128 w2centry_w2c_v128_load64_zero(wasm2c_sandbox_t* const sbx, u32 p0) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_v128_load64_zero(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT v128 w2centry_w2c_v128_load16_lane(wasm2c_sandbox_t* const sbx, u32 p0, v128 p1) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_v128_load16_lane(sbx, p0, p1);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT v128 w2centry_w2c_store_lane_and_load(wasm2c_sandbox_t* const sbx, u32 p0, v128 p1) {
+  ENTRY_PROLOGUE;
+  v128 ret = w2c_store_lane_and_load(sbx, p0, p1);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+#endif
+
+static void init_globals(wasm2c_sandbox_t* const sbx) {
+  (void)sbx;
+}
+
+FUNC_EXPORT v128 w2c_i32x4_add(wasm2c_sandbox_t* const sbx, v128 w2c_p0, v128 w2c_p1) {
+  FUNC_PROLOGUE;
+  v128 w2c_o0, w2c_o1;
+  w2c_o0 = w2c_p0;
+  w2c_o1 = w2c_p1;
+  w2c_o0 = simd_i32x4_add(w2c_o0, w2c_o1);
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+FUNC_EXPORT v128 w2c_i8x16_add_sat_s(wasm2c_sandbox_t* const sbx, v128 w2c_p0, v128 w2c_p1) {
+  FUNC_PROLOGUE;
+  v128 w2c_o0, w2c_o1;
+  w2c_o0 = w2c_p0;
+  w2c_o1 = w2c_p1;
+  w2c_o0 = simd_i8x16_add_sat_s(w2c_o0, w2c_o1);
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+FUNC_EXPORT v128 w2c_i16x8_sub_sat_u(wasm2c_sandbox_t* const sbx, v128 w2c_p0, v128 w2c_p1) {
+  FUNC_PROLOGUE;
+  v128 w2c_o0, w2c_o1;
+  w2c_o0 = w2c_p0;
+  w2c_o1 = w2c_p1;
+  w2c_o0 = simd_i16x8_sub_sat_u(w2c_o0, w2c_o1);
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+FUNC_EXPORT v128 w2c_i32x4_min_u(wasm2c_sandbox_t* const sbx, v128 w2c_p0, v128 w2c_p1) {
+  FUNC_PROLOGUE;
+  v128 w2c_o0, w2c_o1;
+  w2c_o0 = w2c_p0;
+  w2c_o1 = w2c_p1;
+  w2c_o0 = simd_i32x4_min_u(w2c_o0, w2c_o1);
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+FUNC_EXPORT v128 w2c_i8x16_narrow_i16x8_u(wasm2c_sandbox_t* const sbx, v128 w2c_p0, v128 w2c_p1) {
+  FUNC_PROLOGUE;
+  v128 w2c_o0, w2c_o1;
+  w2c_o0 = w2c_p0;
+  w2c_o1 = w2c_p1;
+  w2c_o0 = simd_i8x16_narrow_i16x8_u(w2c_o0, w2c_o1);
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+FUNC_EXPORT v128 w2c_i32x4_extend_high_i16x8_s(wasm2c_sandbox_t* const sbx, v128 w2c_p0) {
+  FUNC_PROLOGUE;
+  v128 w2c_o0;
+  w2c_o0 = w2c_p0;
+  w2c_o0 = simd_i32x4_extend_high_i16x8_s(w2c_o0);
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+FUNC_EXPORT v128 w2c_i16x8_extadd_pairwise_i8x16_u(wasm2c_sandbox_t* const sbx, v128 w2c_p0) {
+  FUNC_PROLOGUE;
+  v128 w2c_o0;
+  w2c_o0 = w2c_p0;
+  w2c_o0 = simd_i16x8_extadd_pairwise_i8x16_u(w2c_o0);
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+FUNC_EXPORT v128 w2c_i32x4_dot_i16x8_s(wasm2c_sandbox_t* const sbx, v128 w2c_p0, v128 w2c_p1) {
+  FUNC_PROLOGUE;
+  v128 w2c_o0, w2c_o1;
+  w2c_o0 = w2c_p0;
+  w2c_o1 = w2c_p1;
+  w2c_o0 = simd_i32x4_dot_i16x8_s(w2c_o0, w2c_o1);
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+FUNC_EXPORT v128 w2c_i16x8_q15mulr_sat_s(wasm2c_sandbox_t* const sbx, v128 w2c_p0, v128 w2c_p1) {
+  FUNC_PROLOGUE;
+  v128 w2c_o0, w2c_o1;
+  w2c_o0 = w2c_p0;
+  w2c_o1 = w2c_p1;
+  w2c_o0 = simd_i16x8_q15mulr_sat_s(w2c_o0, w2c_o1);
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+FUNC_EXPORT v128 w2c_i8x16_popcnt(wasm2c_sandbox_t* const sbx, v128 w2c_p0) {
+  FUNC_PROLOGUE;
+  v128 w2c_o0;
+  w2c_o0 = w2c_p0;
+  w2c_o0 = simd_i8x16_popcnt(w2c_o0);
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+FUNC_EXPORT u32 w2c_i8x16_bitmask(wasm2c_sandbox_t* const sbx, v128 w2c_p0) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0;
+  v128 w2c_o0;
+  w2c_o0 = w2c_p0;
+  w2c_i0 = simd_i8x16_bitmask(w2c_o0);
+  FUNC_EPILOGUE;
+  return w2c_i0;
+}
+
+FUNC_EXPORT u32 w2c_v128_any_true(wasm2c_sandbox_t* const sbx, v128 w2c_p0) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0;
+  v128 w2c_o0;
+  w2c_o0 = w2c_p0;
+  w2c_i0 = simd_v128_any_true(w2c_o0);
+  FUNC_EPILOGUE;
+  return w2c_i0;
+}
+
+FUNC_EXPORT u32 w2c_i32x4_all_true(wasm2c_sandbox_t* const sbx, v128 w2c_p0) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0;
+  v128 w2c_o0;
+  w2c_o0 = w2c_p0;
+  w2c_i0 = simd_i32x4_all_true(w2c_o0);
+  FUNC_EPILOGUE;
+  return w2c_i0;
+}
+
+FUNC_EXPORT v128 w2c_i64x2_shl(wasm2c_sandbox_t* const sbx, v128 w2c_p0, u32 w2c_p1) {
+  FUNC_PROLOGUE;
+  u32 w2c_i1;
+  v128 w2c_o0;
+  w2c_o0 = w2c_p0;
+  w2c_i1 = w2c_p1;
+  w2c_o0 = simd_i64x2_shl(w2c_o0, w2c_i1);
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+FUNC_EXPORT v128 w2c_i8x16_shr_s(wasm2c_sandbox_t* const sbx, v128 w2c_p0, u32 w2c_p1) {
+  FUNC_PROLOGUE;
+  u32 w2c_i1;
+  v128 w2c_o0;
+  w2c_o0 = w2c_p0;
+  w2c_i1 = w2c_p1;
+  w2c_o0 = simd_i8x16_shr_s(w2c_o0, w2c_i1);
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+FUNC_EXPORT v128 w2c_v128_bitselect(wasm2c_sandbox_t* const sbx, v128 w2c_p0, v128 w2c_p1, v128 w2c_p2) {
+  FUNC_PROLOGUE;
+  v128 w2c_o0, w2c_o1, w2c_o2;
+  w2c_o0 = w2c_p0;
+  w2c_o1 = w2c_p1;
+  w2c_o2 = w2c_p2;
+  w2c_o0 = simd_v128_bitselect(w2c_o0, w2c_o1, w2c_o2);
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+FUNC_EXPORT v128 w2c_f32x4_min(wasm2c_sandbox_t* const sbx, v128 w2c_p0, v128 w2c_p1) {
+  FUNC_PROLOGUE;
+  v128 w2c_o0, w2c_o1;
+  w2c_o0 = w2c_p0;
+  w2c_o1 = w2c_p1;
+  w2c_o0 = simd_f32x4_min(w2c_o0, w2c_o1);
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+FUNC_EXPORT v128 w2c_f64x2_floor(wasm2c_sandbox_t* const sbx, v128 w2c_p0) {
+  FUNC_PROLOGUE;
+  v128 w2c_o0;
+  w2c_o0 = w2c_p0;
+  w2c_o0 = simd_f64x2_floor(w2c_o0);
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+FUNC_EXPORT v128 w2c_i32x4_trunc_sat_f32x4_s(wasm2c_sandbox_t* const sbx, v128 w2c_p0) {
+  FUNC_PROLOGUE;
+  v128 w2c_o0;
+  w2c_o0 = w2c_p0;
+  w2c_o0 = simd_i32x4_trunc_sat_f32x4_s(w2c_o0);
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+FUNC_EXPORT v128 w2c_i8x16_shuffle(wasm2c_sandbox_t* const sbx, v128 w2c_p0, v128 w2c_p1) {
+  FUNC_PROLOGUE;
+  v128 w2c_o0, w2c_o1;
+  w2c_o0 = w2c_p0;
+  w2c_o1 = w2c_p1;
+  w2c_o0 = SIMD_I8X16_SHUFFLE(w2c_o0, w2c_o1, 31, 0, 30, 1, 29, 2, 28, 3, 27, 4, 26, 5, 25, 6, 24, 7);
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+FUNC_EXPORT v128 w2c_i8x16_swizzle(wasm2c_sandbox_t* const sbx, v128 w2c_p0, v128 w2c_p1) {
+  FUNC_PROLOGUE;
+  v128 w2c_o0, w2c_o1;
+  w2c_o0 = w2c_p0;
+  w2c_o1 = w2c_p1;
+  w2c_o0 = simd_i8x16_swizzle(w2c_o0, w2c_o1);
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+FUNC_EXPORT u32 w2c_i16x8_extract_lane_s(wasm2c_sandbox_t* const sbx, v128 w2c_p0) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0;
+  v128 w2c_o0;
+  w2c_o0 = w2c_p0;
+  w2c_i0 = simd_i16x8_extract_lane_s(w2c_o0, 7);
+  FUNC_EPILOGUE;
+  return w2c_i0;
+}
+
+FUNC_EXPORT v128 w2c_f64x2_replace_lane(wasm2c_sandbox_t* const sbx, v128 w2c_p0, f64 w2c_p1) {
+  FUNC_PROLOGUE;
+  f64 w2c_d1;
+  v128 w2c_o0;
+  w2c_o0 = w2c_p0;
+  w2c_d1 = w2c_p1;
+  w2c_o0 = simd_f64x2_replace_lane(w2c_o0, 1, w2c_d1);
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+FUNC_EXPORT v128 w2c_i32x4_splat(wasm2c_sandbox_t* const sbx, u32 w2c_p0) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0;
+  v128 w2c_o0;
+  w2c_i0 = w2c_p0;
+  w2c_o0 = simd_i32x4_splat(w2c_i0);
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+FUNC_EXPORT v128 w2c_v128_load(wasm2c_sandbox_t* const sbx, u32 w2c_p0) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0;
+  v128 w2c_o0;
+  w2c_i0 = w2c_p0;
+  w2c_o0 = v128_load_cached(&(sbx->w2c_M0), sbx->w2c_M0.data, 65536ull, (u64)(w2c_i0), WASM2C_SHADOW_FUNC_PROGRAM, "w2c_v128_load");
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+FUNC_EXPORT v128 w2c_v128_load8x8_s(wasm2c_sandbox_t* const sbx, u32 w2c_p0) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0;
+  v128 w2c_o0;
+  w2c_i0 = w2c_p0;
+  w2c_o0 = v128_load8x8_s_cached(&(sbx->w2c_M0), sbx->w2c_M0.data, 65536ull, (u64)(w2c_i0), WASM2C_SHADOW_FUNC_PROGRAM, "w2c_v128_load8x8_s");
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+FUNC_EXPORT v128 w2c_v128_load32_splat(wasm2c_sandbox_t* const sbx, u32 w2c_p0) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0;
+  v128 w2c_o0;
+  w2c_i0 = w2c_p0;
+  w2c_o0 = v128_load32_splat_cached(&(sbx->w2c_M0), sbx->w2c_M0.data, 65536ull, (u64)(w2c_i0), WASM2C_SHADOW_FUNC_PROGRAM, "w2c_v128_load32_splat");
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+FUNC_EXPORT v128 w2c_v128_load64_zero(wasm2c_sandbox_t* const sbx, u32 w2c_p0) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0;
+  v128 w2c_o0;
+  w2c_i0 = w2c_p0;
+  w2c_o0 = v128_load64_zero_cached(&(sbx->w2c_M0), sbx->w2c_M0.data, 65536ull, (u64)(w2c_i0), WASM2C_SHADOW_FUNC_PROGRAM, "w2c_v128_load64_zero");
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+FUNC_EXPORT v128 w2c_v128_load16_lane(wasm2c_sandbox_t* const sbx, u32 w2c_p0, v128 w2c_p1) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0;
+  v128 w2c_o0, w2c_o1;
+  w2c_i0 = w2c_p0;
+  w2c_o1 = w2c_p1;
+  w2c_o0 = v128_load16_lane_cached(&(sbx->w2c_M0), sbx->w2c_M0.data, 65536ull, (u64)(w2c_i0), w2c_o1, 3, WASM2C_SHADOW_FUNC_PROGRAM, "w2c_v128_load16_lane");
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+FUNC_EXPORT v128 w2c_store_lane_and_load(wasm2c_sandbox_t* const sbx, u32 w2c_p0, v128 w2c_p1) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0;
+  v128 w2c_o0, w2c_o1;
+  w2c_i0 = w2c_p0;
+  w2c_o1 = w2c_p1;
+  v128_store32_lane_cached(&(sbx->w2c_M0), sbx->w2c_M0.data, 65536ull, (u64)(w2c_i0), w2c_o1, 2, WASM2C_SHADOW_FUNC_PROGRAM, "w2c_store_lane_and_load");
+  w2c_i0 = w2c_p0;
+  w2c_o0 = v128_load_cached(&(sbx->w2c_M0), sbx->w2c_M0.data, 65536ull, (u64)(w2c_i0), WASM2C_SHADOW_FUNC_PROGRAM, "w2c_store_lane_and_load");
+  FUNC_EPILOGUE;
+  return w2c_o0;
+}
+
+static const u8 data_segment_data_0[] = {
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 
+  0x0c, 0x0d, 0x0e, 0x0f, 
+};
+
+static bool init_memory(wasm2c_sandbox_t* const sbx, uint32_t max_wasm_pages_from_rt) {
+  const uint32_t max_pages_specified_in_module = 0;
+  const uint32_t max_pages = max_wasm_pages_from_rt == 0? max_pages_specified_in_module : max_wasm_pages_from_rt;
+  const bool success = wasm_rt_allocate_memory(&(sbx->w2c_M0), 1, max_pages);
+  if (!success) { return false; }
+  WASM2C_SHADOW_MEMORY_INIT_SAMPLE_RATE(&(sbx->w2c_M0));
+  
+  LOAD_DATA(sbx->w2c_M0, 16u, data_segment_data_0, 16);
+  sbx->wasi_data.heap_memory = &(sbx->w2c_M0);
+  return true;
+}
+
+static bool init_thread_memory(wasm2c_sandbox_t* const sbx, wasm2c_sandbox_t* const parent) {
+  (void)sbx;
+  (void)parent;
+  return false;
+}
+
+static void cleanup_memory(wasm2c_sandbox_t* const sbx) {
+  wasm_rt_deallocate_memory(&(sbx->w2c_M0));
+}
+
+static void init_table(wasm2c_sandbox_t* const sbx) {
+  uint32_t offset = 0;
+  wasm_rt_allocate_table(&(sbx->w2c_T0), 0, 4294967295);
+  sbx->w2c_T0_current_index = offset + 0;
+}
+
+static void cleanup_table(wasm2c_sandbox_t* const sbx) {
+  wasm_rt_deallocate_table(&(sbx->w2c_T0));
+}
+
+typedef struct {
+  const char* name;
+  /* The function, with the index of its type, or 0 for other exports. */
+  wasm_rt_anyfunc_t func;
+  u32 func_type;
+  /* The offset of other exports in the sandbox. */
+  u32 offset;
+  /* Whether the sandbox holds a pointer to the export instead. */
+  u32 is_pointer;
+} wasm2c_export_t;
+
+static const u32 wasm2c_export_seeds[16] = {
+  2, 0, 4, 4, 2, 2, 7, 7, 26, 0, 6, 3, 3, 39, 10, 6,
+};
+
+static const wasm2c_export_t wasm2c_exports[32] = {
+  { "w2c_v128_load32_splat", (wasm_rt_anyfunc_t)&w2c_v128_load32_splat, 6, 0, 0 },
+  { "w2c_i64x2_shl", (wasm_rt_anyfunc_t)&w2c_i64x2_shl, 3, 0, 0 },
+  { "w2c_T0", 0, 0, offsetof(wasm2c_sandbox_t, w2c_T0), 0 },
+  { "w2c_f64x2_replace_lane", (wasm_rt_anyfunc_t)&w2c_f64x2_replace_lane, 5, 0, 0 },
+  { "w2c_v128_load", (wasm_rt_anyfunc_t)&w2c_v128_load, 6, 0, 0 },
+  { "w2c_i16x8_sub_sat_u", (wasm_rt_anyfunc_t)&w2c_i16x8_sub_sat_u, 0, 0, 0 },
+  { "w2c_i32x4_dot_i16x8_s", (wasm_rt_anyfunc_t)&w2c_i32x4_dot_i16x8_s, 0, 0, 0 },
+  { "w2c_v128_load8x8_s", (wasm_rt_anyfunc_t)&w2c_v128_load8x8_s, 6, 0, 0 },
+  { "w2c_store_lane_and_load", (wasm_rt_anyfunc_t)&w2c_store_lane_and_load, 7, 0, 0 },
+  { "w2c_i8x16_swizzle", (wasm_rt_anyfunc_t)&w2c_i8x16_swizzle, 0, 0, 0 },
+  { "w2c_i16x8_q15mulr_sat_s", (wasm_rt_anyfunc_t)&w2c_i16x8_q15mulr_sat_s, 0, 0, 0 },
+  { "w2c_v128_load64_zero", (wasm_rt_anyfunc_t)&w2c_v128_load64_zero, 6, 0, 0 },
+  { "w2c_i8x16_shr_s", (wasm_rt_anyfunc_t)&w2c_i8x16_shr_s, 3, 0, 0 },
+  { "w2c_i16x8_extract_lane_s", (wasm_rt_anyfunc_t)&w2c_i16x8_extract_lane_s, 2, 0, 0 },
+  { "w2c_v128_bitselect", (wasm_rt_anyfunc_t)&w2c_v128_bitselect, 4, 0, 0 },
+  { "w2c_i8x16_bitmask", (wasm_rt_anyfunc_t)&w2c_i8x16_bitmask, 2, 0, 0 },
+  { "w2c_i16x8_extadd_pairwise_i8x16_u", (wasm_rt_anyfunc_t)&w2c_i16x8_extadd_pairwise_i8x16_u, 1, 0, 0 },
+  { "w2c_f64x2_floor", (wasm_rt_anyfunc_t)&w2c_f64x2_floor, 1, 0, 0 },
+  { "w2c_f32x4_min", (wasm_rt_anyfunc_t)&w2c_f32x4_min, 0, 0, 0 },
+  { "w2c_M0", 0, 0, offsetof(wasm2c_sandbox_t, w2c_M0), 0 },
+  { "w2c_i32x4_extend_high_i16x8_s", (wasm_rt_anyfunc_t)&w2c_i32x4_extend_high_i16x8_s, 1, 0, 0 },
+  { "w2c_i32x4_min_u", (wasm_rt_anyfunc_t)&w2c_i32x4_min_u, 0, 0, 0 },
+  { "w2c_i8x16_popcnt", (wasm_rt_anyfunc_t)&w2c_i8x16_popcnt, 1, 0, 0 },
+  { "w2c_i32x4_add", (wasm_rt_anyfunc_t)&w2c_i32x4_add, 0, 0, 0 },
+  { "w2c_i8x16_add_sat_s", (wasm_rt_anyfunc_t)&w2c_i8x16_add_sat_s, 0, 0, 0 },
+  { "w2c_i8x16_narrow_i16x8_u", (wasm_rt_anyfunc_t)&w2c_i8x16_narrow_i16x8_u, 0, 0, 0 },
+  { "w2c_i32x4_all_true", (wasm_rt_anyfunc_t)&w2c_i32x4_all_true, 2, 0, 0 },
+  { "w2c_v128_load16_lane", (wasm_rt_anyfunc_t)&w2c_v128_load16_lane, 7, 0, 0 },
+  { "w2c_i32x4_splat", (wasm_rt_anyfunc_t)&w2c_i32x4_splat, 6, 0, 0 },
+  { "w2c_i8x16_shuffle", (wasm_rt_anyfunc_t)&w2c_i8x16_shuffle, 0, 0, 0 },
+  { "w2c_i32x4_trunc_sat_f32x4_s", (wasm_rt_anyfunc_t)&w2c_i32x4_trunc_sat_f32x4_s, 1, 0, 0 },
+  { "w2c_v128_any_true", (wasm_rt_anyfunc_t)&w2c_v128_any_true, 2, 0, 0 },
+};
+
+static u32 hash_wasm2c_export_name(const char* name, u32 seed) {
+  u32 hash = (2166136261u ^ seed) * 16777619u;
+  for (; *name; name++) {
+    hash = (hash ^ (u8)*name) * 16777619u;
+  }
+  hash = (hash ^ (hash >> 16)) * 0x85ebca6bu;
+  hash = (hash ^ (hash >> 13)) * 0xc2b2ae35u;
+  return hash ^ (hash >> 16);
+}
+
+static const wasm2c_export_t* find_wasm2c_export(const char* name) {
+  u32 seed = wasm2c_export_seeds[hash_wasm2c_export_name(name, 0) % 16];
+  const wasm2c_export_t* entry = &wasm2c_exports[hash_wasm2c_export_name(name, seed) % 32];
+  return entry->name && strcmp(entry->name, name) == 0 ? entry : 0;
+}
+
+static void* lookup_wasm2c_nonfunc_export(void* sbx_ptr, const char* name) {
+  const wasm2c_export_t* entry = find_wasm2c_export(name);
+  if (!entry || entry->func) {
+    return 0;
+  }
+  void* field = (char*) sbx_ptr + entry->offset;
+  return entry->is_pointer ? *(void**) field : field;
+}
+
+static wasm_rt_anyfunc_t lookup_wasm2c_func_export(void* sbx_ptr, const char* name, u32* func_type) {
+  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) sbx_ptr;
+  const wasm2c_export_t* entry = find_wasm2c_export(name);
+  if (!entry || !entry->func) {
+    return 0;
+  }
+  if (func_type) {
+    *func_type = sbx->func_types[entry->func_type];
+  }
+  return entry->func;
+}
+
+static wasm_rt_table_t* get_wasm2c_callback_table(void* sbx_ptr){
+  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) sbx_ptr;
+  return &(sbx->w2c_T0);
+}
+
+static wasm_rt_memory_t* get_wasm2c_memory(wasm2c_sandbox_t* const sbx){
+  return &(sbx->w2c_M0);
+}
+
+static void init_profile(wasm2c_sandbox_t* const sbx) {
+  (void)sbx;
+}
+
+static void cleanup_profile(wasm2c_sandbox_t* const sbx) {
+  (void)sbx;
+}
+
+static wasm_rt_profile_t* get_wasm2c_profile(wasm2c_sandbox_t* const sbx) {
+  (void)sbx;
+  return 0;
+}
+
+static void init_module_starts(wasm2c_sandbox_t* const sbx) {
+  (void)sbx;
+}
+//test
+
+static u32 add_wasm2c_callback(void* sbx_ptr, u32 func_type_idx, void* func_ptr, wasm_rt_elem_target_class_t func_class) {
+  wasm_rt_table_t* table = get_wasm2c_callback_table(sbx_ptr);
+  u32 i = wasm_rt_table_alloc_slot(table);
+  table->data[i] = (wasm_rt_elem_t){ func_class, func_type_idx, (wasm_rt_anyfunc_t) func_ptr };
+  return i;
+}
+
+static void remove_wasm2c_callback(void* sbx_ptr, u32 callback_idx) {
+  wasm_rt_table_t* table = get_wasm2c_callback_table(sbx_ptr);
+  wasm_rt_table_free_slot(table, callback_idx);
+}
+
+static u32 lookup_wasm2c_func_index(void* sbx_ptr, u32 param_count, u32 result_count, wasm_rt_type_t* types) {
+  // Function type indices are shared by all sandboxes.
+  (void) sbx_ptr;
+  return wasm_rt_register_func_type(param_count, result_count, types);
+}
+
+static void* create_wasm2c_sandbox(uint32_t max_wasm_pages) {
+  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) calloc(sizeof(wasm2c_sandbox_t), 1);
+  if (!init_memory(sbx, max_wasm_pages)) {
+    free(sbx);
+    return 0;
+  }
+  init_func_types(sbx);
+  init_globals(sbx);
+  init_table(sbx);
+  init_profile(sbx);
+  wasm_rt_init_wasi(&(sbx->wasi_data));
+  init_module_starts(sbx);
+  return sbx;
+}
+
+// Creates another instance of the module for a new thread. It has its own
+// globals and table, but shares the (shared) linear memory of `parent_ptr`,
+// which must stay alive until every thread sandbox created from it has been
+// destroyed. Returns 0 if the module has no shared memory, or if out of memory.
+static void* create_wasm2c_sandbox_thread(void* parent_ptr) {
+  wasm2c_sandbox_t* const parent = (wasm2c_sandbox_t* const) parent_ptr;
+  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) calloc(sizeof(wasm2c_sandbox_t), 1);
+  if (!sbx) {
+    return 0;
+  }
+  if (!init_thread_memory(sbx, parent)) {
+    free(sbx);
+    return 0;
+  }
+  init_func_types(sbx);
+  init_globals(sbx);
+  init_table(sbx);
+  init_profile(sbx);
+  wasm_rt_init_wasi(&(sbx->wasi_data));
+  return sbx;
+}
+
+static void destroy_wasm2c_sandbox(void* aSbx) {
+  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) aSbx;
+  cleanup_memory(sbx);
+  cleanup_table(sbx);
+  cleanup_profile(sbx);
+  wasm_rt_cleanup_wasi(&(sbx->wasi_data));
+  free(sbx);
+}
+
+// A copy of the linear memory, globals and table of an initialized sandbox.
+// The copy of the sandbox struct holds the globals, the table's size and the
+// function type indices; everything it points to is copied separately.
+typedef struct wasm2c_sandbox_snapshot_t {
+  wasm2c_sandbox_t sbx;
+  wasm_rt_memory_image_t memory_image;
+  wasm_rt_elem_t* table_data;
+} wasm2c_sandbox_snapshot_t;
+
+// Returns 0 if the module's memory is shared, or if memory images are not
+// supported.
+static void* create_wasm2c_sandbox_snapshot(void* sbx_ptr) {
+  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) sbx_ptr;
+  wasm_rt_memory_t* memory = get_wasm2c_memory(sbx);
+  if (!memory || memory->is_shared) {
+    return 0;
+  }
+  wasm2c_sandbox_snapshot_t* const snapshot = (wasm2c_sandbox_snapshot_t*) calloc(sizeof(wasm2c_sandbox_snapshot_t), 1);
+  if (!snapshot) {
+    return 0;
+  }
+  if (!wasm_rt_create_memory_image(&snapshot->memory_image, memory)) {
+    free(snapshot);
+    return 0;
+  }
+  memcpy(&snapshot->sbx, sbx, sizeof(wasm2c_sandbox_t));
+  wasm_rt_table_t* table = get_wasm2c_callback_table(sbx);
+  snapshot->table_data = (wasm_rt_elem_t*) malloc((table->size ? table->size : 1) * sizeof(wasm_rt_elem_t));
+  if (!snapshot->table_data) {
+    wasm_rt_free_memory_image(&snapshot->memory_image);
+    free(snapshot);
+    return 0;
+  }
+  memcpy(snapshot->table_data, table->data, table->size * sizeof(wasm_rt_elem_t));
+  return snapshot;
+}
+
+// Creates a sandbox in the state the snapshot was taken in, without running
+// any of the module's initialization. Its memory is mapped copy-on-write from
+// the snapshot. The WASI state and the profile are not part of the snapshot,
+// and start out fresh as in create_wasm2c_sandbox.
+static void* create_wasm2c_sandbox_from_snapshot(void* snapshot_ptr, uint32_t max_wasm_pages) {
+  wasm2c_sandbox_snapshot_t* const snapshot = (wasm2c_sandbox_snapshot_t* const) snapshot_ptr;
+  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) malloc(sizeof(wasm2c_sandbox_t));
+  if (!sbx) {
+    return 0;
+  }
+  memcpy(sbx, &snapshot->sbx, sizeof(wasm2c_sandbox_t));
+  wasm_rt_memory_t* memory = get_wasm2c_memory(sbx);
+  const uint32_t max_pages = max_wasm_pages == 0 ? memory->max_pages : max_wasm_pages;
+  if (!wasm_rt_allocate_memory_from_image(memory, &snapshot->memory_image, max_pages)) {
+    free(sbx);
+    return 0;
+  }
+  WASM2C_SHADOW_MEMORY_INIT_SAMPLE_RATE(memory);
+  wasm_rt_table_t* table = get_wasm2c_callback_table(sbx);
+  wasm_rt_allocate_table(table, table->size, table->max_size);
+  memcpy(table->data, snapshot->table_data, table->size * sizeof(wasm_rt_elem_t));
+  init_profile(sbx);
+  memset(&(sbx->wasi_data), 0, sizeof(sbx->wasi_data));
+  sbx->wasi_data.heap_memory = memory;
+  wasm_rt_init_wasi(&(sbx->wasi_data));
+  return sbx;
+}
+
+static void destroy_wasm2c_sandbox_snapshot(void* snapshot_ptr) {
+  wasm2c_sandbox_snapshot_t* const snapshot = (wasm2c_sandbox_snapshot_t* const) snapshot_ptr;
+  wasm_rt_free_memory_image(&snapshot->memory_image);
+  free(snapshot->table_data);
+  free(snapshot);
+}
+
+// Returns false if the module was compiled without --instrument, or without
+// --instrument=cycles for the folded format.
+static bool dump_wasm2c_profile(void* sbx_ptr, FILE* out, wasm_rt_profile_format_t format) {
+  wasm_rt_profile_t* profile = get_wasm2c_profile((wasm2c_sandbox_t*) sbx_ptr);
+  return profile && wasm_rt_profile_dump(profile, out, format);
+}
+
+FUNC_EXPORT wasm2c_sandbox_funcs_t WASM_CURR_ADD_PREFIX(get_wasm2c_sandbox_info)() {
+  wasm2c_sandbox_funcs_t ret;
+  ret.wasm_rt_sys_init = &wasm_rt_sys_init;
+  ret.create_wasm2c_sandbox = &create_wasm2c_sandbox;
+  ret.destroy_wasm2c_sandbox = &destroy_wasm2c_sandbox;
+  ret.lookup_wasm2c_nonfunc_export = &lookup_wasm2c_nonfunc_export;
+  ret.lookup_wasm2c_func_index = &lookup_wasm2c_func_index;
+  ret.add_wasm2c_callback = &add_wasm2c_callback;
+  ret.remove_wasm2c_callback = &remove_wasm2c_callback;
+  ret.create_wasm2c_sandbox_thread = &create_wasm2c_sandbox_thread;
+  ret.create_wasm2c_sandbox_snapshot = &create_wasm2c_sandbox_snapshot;
+  ret.create_wasm2c_sandbox_from_snapshot = &create_wasm2c_sandbox_from_snapshot;
+  ret.destroy_wasm2c_sandbox_snapshot = &destroy_wasm2c_sandbox_snapshot;
+  ret.lookup_wasm2c_func_export = &lookup_wasm2c_func_export;
+  ret.dump_wasm2c_profile = &dump_wasm2c_profile;
+  return ret;
+}
@@ -0,0 +1,95 @@
+#ifndef SIMD_0_H_GENERATED_
+#define SIMD_0_H_GENERATED_
+
+#define WASM_CURR_MODULE_PREFIX 
+/* Automically generated by wasm2c */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "wasm-rt.h"
+
+#ifndef WASM_RT_MODULE_PREFIX
+#define WASM_RT_MODULE_PREFIX
+#endif
+
+#define WASM_RT_PASTE_(x, y) x ## y
+#define WASM_RT_PASTE(x, y) WASM_RT_PASTE_(x, y)
+#define WASM_RT_ADD_PREFIX(x) WASM_RT_PASTE(WASM_RT_MODULE_PREFIX, x)
+
+#define WASM_CURR_ADD_PREFIX(x) WASM_RT_PASTE(WASM_CURR_MODULE_PREFIX, x)
+
+/* TODO(binji): only use stdint.h types in header */
+typedef uint8_t u8;
+typedef int8_t s8;
+typedef uint16_t u16;
+typedef int16_t s16;
+typedef uint32_t u32;
+typedef int32_t s32;
+typedef uint64_t u64;
+typedef int64_t s64;
+typedef float f32;
+typedef double f64;
+#if defined(__GNUC__) || defined(__clang__)
+/* Same layout as SSE's __m128i, so it can be passed to intrinsics with a cast. */
+typedef long long v128 __attribute__((vector_size(16)));
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+typedef __m128i v128;
+#else
+typedef struct { u64 lanes[2]; } v128;
+#endif
+
+#ifndef WASM_DONT_EXPORT_FUNCS
+# if defined(_WIN32)
+#   define FUNC_EXPORT __declspec(dllexport)
+# else
+#   define FUNC_EXPORT
+# endif
+#else
+# define FUNC_EXPORT
+#endif
+
+FUNC_EXPORT wasm2c_sandbox_funcs_t WASM_CURR_ADD_PREFIX(get_wasm2c_sandbox_info)();
+
+struct wasm2c_sandbox_t;
+typedef struct wasm2c_sandbox_t wasm2c_sandbox_t;
+
+FUNC_EXPORT v128 w2c_i32x4_add(wasm2c_sandbox_t* const, v128, v128);
+FUNC_EXPORT v128 w2c_i8x16_add_sat_s(wasm2c_sandbox_t* const, v128, v128);
+FUNC_EXPORT v128 w2c_i16x8_sub_sat_u(wasm2c_sandbox_t* const, v128, v128);
+FUNC_EXPORT v128 w2c_i32x4_min_u(wasm2c_sandbox_t* const, v128, v128);
+FUNC_EXPORT v128 w2c_i8x16_narrow_i16x8_u(wasm2c_sandbox_t* const, v128, v128);
+FUNC_EXPORT v128 w2c_i32x4_extend_high_i16x8_s(wasm2c_sandbox_t* const, v128);
+FUNC_EXPORT v128 w2c_i16x8_extadd_pairwise_i8x16_u(wasm2c_sandbox_t* const, v128);
+FUNC_EXPORT v128 w2c_i32x4_dot_i16x8_s(wasm2c_sandbox_t* const, v128, v128);
+FUNC_EXPORT v128 w2c_i16x8_q15mulr_sat_s(wasm2c_sandbox_t* const, v128, v128);
+FUNC_EXPORT v128 w2c_i8x16_popcnt(wasm2c_sandbox_t* const, v128);
+FUNC_EXPORT u32 w2c_i8x16_bitmask(wasm2c_sandbox_t* const, v128);
+FUNC_EXPORT u32 w2c_v128_any_true(wasm2c_sandbox_t* const, v128);
+FUNC_EXPORT u32 w2c_i32x4_all_true(wasm2c_sandbox_t* const, v128);
+FUNC_EXPORT v128 w2c_i64x2_shl(wasm2c_sandbox_t* const, v128, u32);
+FUNC_EXPORT v128 w2c_i8x16_shr_s(wasm2c_sandbox_t* const, v128, u32);
+FUNC_EXPORT v128 w2c_v128_bitselect(wasm2c_sandbox_t* const, v128, v128, v128);
+FUNC_EXPORT v128 w2c_f32x4_min(wasm2c_sandbox_t* const, v128, v128);
+FUNC_EXPORT v128 w2c_f64x2_floor(wasm2c_sandbox_t* const, v128);
+FUNC_EXPORT v128 w2c_i32x4_trunc_sat_f32x4_s(wasm2c_sandbox_t* const, v128);
+FUNC_EXPORT v128 w2c_i8x16_shuffle(wasm2c_sandbox_t* const, v128, v128);
+FUNC_EXPORT v128 w2c_i8x16_swizzle(wasm2c_sandbox_t* const, v128, v128);
+FUNC_EXPORT u32 w2c_i16x8_extract_lane_s(wasm2c_sandbox_t* const, v128);
+FUNC_EXPORT v128 w2c_f64x2_replace_lane(wasm2c_sandbox_t* const, v128, f64);
+FUNC_EXPORT v128 w2c_i32x4_splat(wasm2c_sandbox_t* const, u32);
+FUNC_EXPORT v128 w2c_v128_load(wasm2c_sandbox_t* const, u32);
+FUNC_EXPORT v128 w2c_v128_load8x8_s(wasm2c_sandbox_t* const, u32);
+FUNC_EXPORT v128 w2c_v128_load32_splat(wasm2c_sandbox_t* const, u32);
+FUNC_EXPORT v128 w2c_v128_load64_zero(wasm2c_sandbox_t* const, u32);
+FUNC_EXPORT v128 w2c_v128_load16_lane(wasm2c_sandbox_t* const, u32, v128);
+FUNC_EXPORT v128 w2c_store_lane_and_load(wasm2c_sandbox_t* const, u32, v128);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* SIMD_0_H_GENERATED_ */
@@ -0,0 +1,1490 @@
+/* Automically generated by wasm2c */
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "tail-call-musttail.0.h"
+#if defined(_MSC_VER)
+#  define UNLIKELY(x) (x)
+#  define LIKELY(x) (x)
+#else
+#  define UNLIKELY(x) __builtin_expect(!!(x), 0)
+#  define LIKELY(x) __builtin_expect(!!(x), 1)
+#endif
+
+#define TRAP(x) (wasm_rt_trap(WASM_RT_TRAP_##x), 0)
+
+// Large data segments are page aligned, so they can be mapped directly.
+#if defined(_MSC_VER)
+#  define DATA_SEGMENT_ALIGN __declspec(align(4096))
+#else
+#  define DATA_SEGMENT_ALIGN __attribute__((aligned(4096)))
+#endif
+
+// Functions that would be static in a single output file, but are shared
+// between the shards when wasm2c splits its output across several files.
+#if defined(_WIN32)
+#  define FUNC_INTERNAL
+#else
+#  define FUNC_INTERNAL __attribute__((visibility("hidden")))
+#endif
+
+// Functions that the profile given to wasm2c with --profile-use found hot, or
+// never saw called. GCC also moves them to .text.hot and .text.unlikely, which
+// keeps the hot code together.
+#if defined(__has_attribute)
+#  if __has_attribute(hot) && __has_attribute(cold)
+#    define FUNC_HOT __attribute__((hot))
+#    define FUNC_COLD __attribute__((cold))
+#  endif
+#endif
+#ifndef FUNC_HOT
+#  define FUNC_HOT
+#  define FUNC_COLD
+#endif
+
+// Counts whether the condition `c` of an if or br_if holds, with
+// --instrument=branches.
+#define PROFILE_BRANCH(sbx, site, c) \
+  profile_branch(&(sbx)->profile, site, c)
+
+static inline u32 profile_branch(wasm_rt_profile_t* profile, u32 site, u32 c) {
+  ++profile->branches[2 * site + (c != 0)];
+  return c;
+}
+
+// Tail calls skip the FUNC_EPILOGUE of the caller, and the
+// EXTERNAL_CALLBACK_EPILOGUE of callbacks, so they are only made with musttail
+// when the embedder doesn't define those.
+#if !defined(WASM_RT_MUSTTAIL) && !defined(FUNC_EPILOGUE) && \
+    !defined(EXTERNAL_CALLBACK_EPILOGUE) && defined(__has_attribute)
+#  if __has_attribute(musttail)
+#    define WASM_RT_MUSTTAIL __attribute__((musttail))
+#  endif
+#endif
+
+#ifndef FUNC_PROLOGUE
+#define FUNC_PROLOGUE
+#endif
+
+#ifndef FUNC_EPILOGUE
+#define FUNC_EPILOGUE
+#endif
+
+#ifdef EXTERNAL_CALLBACK_PROLOGUE
+#define EXTERNAL_CALLBACK_PROLOGUE_EXEC(table, x)                        \
+  if (UNLIKELY(table.data[x].func_class == WASM_RT_EXTERNAL_FUNCTION)) { \
+    EXTERNAL_CALLBACK_PROLOGUE;                                          \
+  }
+#else
+#define EXTERNAL_CALLBACK_PROLOGUE_EXEC(table, x)
+#endif
+
+#ifdef EXTERNAL_CALLBACK_EPILOGUE
+#define EXTERNAL_CALLBACK_EPILOGUE_EXEC(table, x)                        \
+  if (UNLIKELY(table.data[x].func_class == WASM_RT_EXTERNAL_FUNCTION)) { \
+    EXTERNAL_CALLBACK_EPILOGUE;                                          \
+  }
+#else
+#define EXTERNAL_CALLBACK_EPILOGUE_EXEC(table, x)
+#endif
+
+#define UNREACHABLE (void) TRAP(UNREACHABLE)
+
+// Empty table elements have function type 0, which no function type has, so
+// the type check also rejects them. `type_id` is usually a constant.
+#define CALL_INDIRECT_VOID(table, t, type_id, x, ...)                     \
+  if (LIKELY((x) < table.size && table.data[x].func_type == (type_id))) { \
+    EXTERNAL_CALLBACK_PROLOGUE_EXEC(table, x);                            \
+    ((t)table.data[x].func)(__VA_ARGS__);                                 \
+    EXTERNAL_CALLBACK_EPILOGUE_EXEC(table, x);                            \
+  } else {                                                                \
+    wasm_rt_callback_error_trap(&table, x, type_id);                      \
+  }
+
+#define CALL_INDIRECT_RES(res, table, t, type_id, x, ...)                 \
+  if (LIKELY((x) < table.size && table.data[x].func_type == (type_id))) { \
+    EXTERNAL_CALLBACK_PROLOGUE_EXEC(table, x);                            \
+    res = ((t)table.data[x].func)(__VA_ARGS__);                           \
+    EXTERNAL_CALLBACK_EPILOGUE_EXEC(table, x);                            \
+  } else {                                                                \
+    wasm_rt_callback_error_trap(&table, x, type_id);                      \
+  }
+
+#if defined(WASM2C_MALLOC_FAIL_CALLBACK)
+void WASM2C_MALLOC_FAIL_CALLBACK(u32 ptr_size);
+# define WASM2C_MALLOC_FAIL_CHECK(ptr, ptr_size)  \
+  if (!ptr) {                                     \
+    WASM2C_MALLOC_FAIL_CALLBACK(ptr_size);        \
+  }
+#else
+# define WASM2C_MALLOC_FAIL_CHECK(ptr, ptr_size)
+#endif
+
+#if defined(WASM_CHECK_SHADOW_MEMORY)
+#  if defined(WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE)
+#    if defined(WASM_CHECK_SHADOW_MEMORY_UNINIT_READ)
+#      error "WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE can't be used with WASM_CHECK_SHADOW_MEMORY_UNINIT_READ"
+#    endif
+// Only check about one in WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE loads and
+// stores, plus every access from the functions given to wasm2c with
+// --shadow-check-function. Allocations and frees are always tracked. Each
+// thread counts down to its next checked access, and the runtime picks the
+// length of every countdown at random so the checks don't line up with loops.
+// The rate is stored in the memory when it is allocated, so the runtime
+// doesn't need to be built with the same WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE.
+static WASM_RT_THREAD_LOCAL u32 wasm2c_shadow_sample_countdown = 1;
+#    define WASM2C_SHADOW_MEMORY_SAMPLED(mem, shadow_class)                      \
+  (((shadow_class) & WASM2C_SHADOW_FUNC_ALWAYS_CHECK) ||                       \
+   (UNLIKELY(--wasm2c_shadow_sample_countdown == 0) &&                         \
+    (wasm2c_shadow_sample_countdown = wasm2c_shadow_memory_next_sample(mem), 1)))
+#    define WASM2C_SHADOW_MEMORY_INIT_SAMPLE_RATE(mem)                           \
+  wasm2c_shadow_memory_set_sample_rate(mem, WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE)
+#  else
+#    define WASM2C_SHADOW_MEMORY_SAMPLED(mem, shadow_class) 1
+#    define WASM2C_SHADOW_MEMORY_INIT_SAMPLE_RATE(mem)
+#  endif
+#  define WASM2C_SHADOW_MEMORY_LOAD(mem, shadow_class, func_name, ptr, ptr_size)   \
+  do {                                                                           \
+    if (WASM2C_SHADOW_MEMORY_SAMPLED(mem, shadow_class))                         \
+      wasm2c_shadow_memory_load(mem, shadow_class, func_name, ptr, ptr_size);    \
+  } while (0)
+#  define WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, ptr, ptr_size)  \
+  do {                                                                           \
+    if (WASM2C_SHADOW_MEMORY_SAMPLED(mem, shadow_class))                         \
+      wasm2c_shadow_memory_store(mem, shadow_class, func_name, ptr, ptr_size);   \
+  } while (0)
+#  define WASM2C_SHADOW_MEMORY_RESERVE(mem, ptr, ptr_size)          wasm2c_shadow_memory_reserve(mem, ptr, ptr_size)
+#  define WASM2C_SHADOW_MEMORY_DLMALLOC(mem, ptr, ptr_size)         wasm2c_shadow_memory_dlmalloc(mem, ptr, ptr_size)
+#  define WASM2C_SHADOW_MEMORY_DLFREE(mem, ptr)                     wasm2c_shadow_memory_dlfree(mem, ptr)
+#  define WASM2C_SHADOW_MEMORY_MARK_GLOBALS_HEAP_BOUNDARY(mem, ptr) wasm2c_shadow_memory_mark_globals_heap_boundary(mem, ptr)
+#else
+// Consume the arguments that the load and store helpers only take for shadow
+// memory, so that they don't warn about unused parameters.
+#  define WASM2C_SHADOW_MEMORY_LOAD(mem, shadow_class, func_name, ptr, ptr_size) \
+  ((void)(mem), (void)(shadow_class), (void)(func_name))
+#  define WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, ptr, ptr_size) \
+  ((void)(mem), (void)(shadow_class), (void)(func_name))
+#  define WASM2C_SHADOW_MEMORY_RESERVE(mem, ptr, ptr_size)
+#  define WASM2C_SHADOW_MEMORY_DLMALLOC(mem, ptr, ptr_size)
+#  define WASM2C_SHADOW_MEMORY_DLFREE(mem, ptr)
+#  define WASM2C_SHADOW_MEMORY_MARK_GLOBALS_HEAP_BOUNDARY(mem, ptr)
+#  define WASM2C_SHADOW_MEMORY_INIT_SAMPLE_RATE(mem)
+#endif
+
+// Another thread may grow a shared memory at any time, so its size is read
+// atomically. wasm_rt_grow_memory makes the new pages accessible before it
+// stores the new size.
+#if WASM_RT_SHARED_MEMORY
+#  define MEM_SIZE(mem) __atomic_load_n(&(mem)->size, __ATOMIC_ACQUIRE)
+#  define MEM_PAGES(mem) __atomic_load_n(&(mem)->pages, __ATOMIC_ACQUIRE)
+#else
+#  define MEM_SIZE(mem) ((mem)->size)
+#  define MEM_PAGES(mem) ((mem)->pages)
+#endif
+
+#ifdef WASM_USE_GUARD_PAGES
+#  define MEMCHECK(mem_size, a, t) (void)(mem_size)
+#else
+#  define MEMCHECK(mem_size, a, t) if (UNLIKELY((a) + sizeof(t) > (mem_size))) { (void) TRAP(OOB); }
+#endif
+
+#if defined(WASM_USE_GUARD_PAGES) && UINTPTR_MAX == 0xffffffff
+// on 32-bit platforms we have to mask memory access into range
+#  define MEM_ACCESS_REF(mem, mem_data, addr) &(mem_data)[addr & mem->mem_mask]
+#else
+#  define MEM_ACCESS_REF(mem, mem_data, addr) &(mem_data)[addr]
+#endif
+
+#if defined(WASM_USING_GLOBAL_HEAP)
+#  undef MEM_ACCESS_REF
+#  define MEM_ACCESS_REF(mem, mem_data, addr) (char*) addr
+#endif
+
+// Each load and store has two forms. The plain form reads the base and size of
+// the linear memory through `mem`. The `_cached` form takes them as arguments,
+// so that functions can keep them in locals: the compiler must otherwise
+// assume that any store into linear memory may have modified `mem`, and reload
+// the base pointer on every access.
+//
+// Both forms also have an `_unchecked` variant without the MEMCHECK, which
+// wasm2c uses for the accesses it has proven to be in bounds.
+#if WABT_BIG_ENDIAN
+static inline void load_data(void *dest, const void *src, size_t n) {
+  size_t i = 0;
+  u8 *dest_chars = dest;
+  memcpy(dest, src, n);
+  for (i = 0; i < (n>>1); i++) {
+    u8 cursor = dest_chars[i];
+    dest_chars[i] = dest_chars[n - i - 1];
+    dest_chars[n - i - 1] = cursor;
+  }
+}
+#define LOAD_DATA(m, o, i, s) { load_data(&(m.data[m.size - o - s]), i, s); \
+  WASM2C_SHADOW_MEMORY_RESERVE(&m, m.size - o - s, s);                       \
+  WASM2C_SHADOW_MEMORY_STORE(&m, WASM2C_SHADOW_FUNC_ALWAYS_CHECK,            \
+                             "GlobalDataLoad", m.size - o - s, s);           \
+}
+
+#define DEFINE_LOAD(name, t1, t2, t3)                                                                \
+  static inline t3 name##_unchecked_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size,        \
+                                           u64 addr, u32 shadow_class, const char* func_name) {      \
+    t1 result;                                                                                       \
+    memcpy(&result, MEM_ACCESS_REF(mem, mem_data, mem_size - addr - sizeof(t1)), sizeof(t1));        \
+    WASM2C_SHADOW_MEMORY_LOAD(mem, shadow_class, func_name, mem_size - addr - sizeof(t1),            \
+                              sizeof(t1));                                                           \
+    return (t3)(t2)result;                                                                           \
+  }                                                                                                  \
+  static inline t3 name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,        \
+                                 u32 shadow_class, const char* func_name) {                          \
+    MEMCHECK(mem_size, addr, t1);                                                                    \
+    return name##_unchecked_cached(mem, mem_data, mem_size, addr, shadow_class, func_name);          \
+  }                                                                                                  \
+  static inline t3 name##_unchecked(wasm_rt_memory_t* mem, u64 addr, u32 shadow_class,               \
+                                    const char* func_name) {                                         \
+    return name##_unchecked_cached(mem, mem->data, MEM_SIZE(mem), addr, shadow_class, func_name);     \
+  }                                                                                                  \
+  static inline t3 name(wasm_rt_memory_t* mem, u64 addr, u32 shadow_class, const char* func_name) {  \
+    return name##_cached(mem, mem->data, MEM_SIZE(mem), addr, shadow_class, func_name);               \
+  }
+
+#define DEFINE_STORE(name, t1, t2)                                                                   \
+  static inline void name##_unchecked_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size,      \
+                                             u64 addr, t2 value, u32 shadow_class,                   \
+                                             const char* func_name) {                                \
+    t1 wrapped = (t1)value;                                                                          \
+    memcpy(MEM_ACCESS_REF(mem, mem_data, mem_size - addr - sizeof(t1)), &wrapped, sizeof(t1));       \
+    WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, mem_size - addr - sizeof(t1),           \
+                               sizeof(t1));                                                          \
+  }                                                                                                  \
+  static inline void name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,      \
+                                   t2 value, u32 shadow_class, const char* func_name) {              \
+    MEMCHECK(mem_size, addr, t1);                                                                    \
+    name##_unchecked_cached(mem, mem_data, mem_size, addr, value, shadow_class, func_name);          \
+  }                                                                                                  \
+  static inline void name##_unchecked(wasm_rt_memory_t* mem, u64 addr, t2 value, u32 shadow_class,   \
+                                      const char* func_name) {                                       \
+    name##_unchecked_cached(mem, mem->data, MEM_SIZE(mem), addr, value, shadow_class, func_name);     \
+  }                                                                                                  \
+  static inline void name(wasm_rt_memory_t* mem, u64 addr, t2 value, u32 shadow_class,               \
+                          const char* func_name) {                                                   \
+    name##_cached(mem, mem->data, MEM_SIZE(mem), addr, value, shadow_class, func_name);               \
+  }
+#else
+static inline void load_data(void *dest, const void *src, size_t n) {
+  memcpy(dest, src, n);
+}
+#define LOAD_DATA(m, o, i, s) { load_data(&(m.data[o]), i, s);          \
+  WASM2C_SHADOW_MEMORY_RESERVE(&m, o, s);                                \
+  WASM2C_SHADOW_MEMORY_STORE(&m, WASM2C_SHADOW_FUNC_ALWAYS_CHECK,        \
+                             "GlobalDataLoad", o, s);                    \
+}
+
+#define DEFINE_LOAD(name, t1, t2, t3)                                                                \
+  static inline t3 name##_unchecked_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size,        \
+                                           u64 addr, u32 shadow_class, const char* func_name) {      \
+    t1 result;                                                                                       \
+    (void)mem_size;                                                                                  \
+    memcpy(&result, MEM_ACCESS_REF(mem, mem_data, addr), sizeof(t1));                                \
+    WASM2C_SHADOW_MEMORY_LOAD(mem, shadow_class, func_name, addr, sizeof(t1));                       \
+    return (t3)(t2)result;                                                                           \
+  }                                                                                                  \
+  static inline t3 name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,        \
+                                 u32 shadow_class, const char* func_name) {                          \
+    MEMCHECK(mem_size, addr, t1);                                                                    \
+    return name##_unchecked_cached(mem, mem_data, mem_size, addr, shadow_class, func_name);          \
+  }                                                                                                  \
+  static inline t3 name##_unchecked(wasm_rt_memory_t* mem, u64 addr, u32 shadow_class,               \
+                                    const char* func_name) {                                         \
+    return name##_unchecked_cached(mem, mem->data, MEM_SIZE(mem), addr, shadow_class, func_name);     \
+  }                                                                                                  \
+  static inline t3 name(wasm_rt_memory_t* mem, u64 addr, u32 shadow_class, const char* func_name) {  \
+    return name##_cached(mem, mem->data, MEM_SIZE(mem), addr, shadow_class, func_name);               \
+  }
+
+#define DEFINE_STORE(name, t1, t2)                                                                   \
+  static inline void name##_unchecked_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size,      \
+                                             u64 addr, t2 value, u32 shadow_class,                   \
+                                             const char* func_name) {                                \
+    t1 wrapped = (t1)value;                                                                          \
+    (void)mem_size;                                                                                  \
+    memcpy(MEM_ACCESS_REF(mem, mem_data, addr), &wrapped, sizeof(t1));                               \
+    WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, addr, sizeof(t1));                      \
+  }                                                                                                  \
+  static inline void name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,      \
+                                   t2 value, u32 shadow_class, const char* func_name) {              \
+    MEMCHECK(mem_size, addr, t1);                                                                    \
+    name##_unchecked_cached(mem, mem_data, mem_size, addr, value, shadow_class, func_name);          \
+  }                                                                                                  \
+  static inline void name##_unchecked(wasm_rt_memory_t* mem, u64 addr, t2 value, u32 shadow_class,   \
+                                      const char* func_name) {                                       \
+    name##_unchecked_cached(mem, mem->data, MEM_SIZE(mem), addr, value, shadow_class, func_name);     \
+  }                                                                                                  \
+  static inline void name(wasm_rt_memory_t* mem, u64 addr, t2 value, u32 shadow_class,               \
+                          const char* func_name) {                                                   \
+    name##_cached(mem, mem->data, MEM_SIZE(mem), addr, value, shadow_class, func_name);               \
+  }
+#endif
+
+DEFINE_LOAD(i32_load, u32, u32, u32);
+DEFINE_LOAD(i64_load, u64, u64, u64);
+DEFINE_LOAD(f32_load, f32, f32, f32);
+DEFINE_LOAD(f64_load, f64, f64, f64);
+DEFINE_LOAD(i32_load8_s, s8, s32, u32);
+DEFINE_LOAD(i64_load8_s, s8, s64, u64);
+DEFINE_LOAD(i32_load8_u, u8, u32, u32);
+DEFINE_LOAD(i64_load8_u, u8, u64, u64);
+DEFINE_LOAD(i32_load16_s, s16, s32, u32);
+DEFINE_LOAD(i64_load16_s, s16, s64, u64);
+DEFINE_LOAD(i32_load16_u, u16, u32, u32);
+DEFINE_LOAD(i64_load16_u, u16, u64, u64);
+DEFINE_LOAD(i64_load32_s, s32, s64, u64);
+DEFINE_LOAD(i64_load32_u, u32, u64, u64);
+DEFINE_STORE(i32_store, u32, u32);
+DEFINE_STORE(i64_store, u64, u64);
+DEFINE_STORE(f32_store, f32, f32);
+DEFINE_STORE(f64_store, f64, f64);
+DEFINE_STORE(i32_store8, u8, u32);
+DEFINE_STORE(i32_store16, u16, u32);
+DEFINE_STORE(i64_store8, u8, u64);
+DEFINE_STORE(i64_store16, u16, u64);
+DEFINE_STORE(i64_store32, u32, u64);
+
+// The bulk memory operations are bounds checked and done with memmove/memset
+// by the runtime. The shadow memory is checked once for the whole range.
+static inline void memory_copy(wasm_rt_memory_t* mem, u32 dest, u32 src, u32 n,
+                               u32 shadow_class, const char* func_name) {
+  wasm_rt_memory_copy(mem, dest, src, n);
+  if (n != 0) {
+    WASM2C_SHADOW_MEMORY_LOAD(mem, shadow_class, func_name, src, n);
+    WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, dest, n);
+  }
+}
+
+static inline void memory_fill(wasm_rt_memory_t* mem, u32 dest, u32 value, u32 n,
+                               u32 shadow_class, const char* func_name) {
+  wasm_rt_memory_fill(mem, dest, value, n);
+  if (n != 0) {
+    WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, dest, n);
+  }
+}
+
+static inline void memory_init(wasm_rt_memory_t* mem, u32 dest, u32 src, u32 n,
+                               const u8* data, u32 data_size,
+                               u32 shadow_class, const char* func_name) {
+  wasm_rt_memory_init(mem, dest, data, data_size, src, n);
+  if (n != 0) {
+    WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, dest, n);
+  }
+}
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+
+// Adapted from https://github.com/nemequ/portable-snippets/blob/master/builtin/builtin.h
+
+static inline int I64_CLZ(unsigned long long v) {
+  unsigned long r = 0;
+#if defined(_M_AMD64) || defined(_M_ARM)
+    if (_BitScanReverse64(&r, v)) {
+      return 63 - r;
+    }
+#else
+    if (_BitScanReverse(&r, (unsigned long) (v >> 32))) {
+      return 31 - r;
+    } else if (_BitScanReverse(&r, (unsigned long) v)) {
+      return 63 - r;
+    }
+#endif
+  return 64;
+}
+
+static inline int I32_CLZ(unsigned long v) {
+  unsigned long r = 0;
+  if (_BitScanReverse(&r, v)) {
+    return 31 - r;
+  }
+  return 32;
+}
+
+static inline int I64_CTZ(unsigned long long v) {
+  if (!v) {
+    return 64;
+  }
+  unsigned long r = 0;
+#if defined(_M_AMD64) || defined(_M_ARM)
+    _BitScanForward64(&r, v);
+    return (int) r;
+#else
+    if (_BitScanForward(&r, (unsigned int) (v))) {
+      return (int) (r);
+    }
+
+    _BitScanForward(&r, (unsigned int) (v >> 32));
+    return (int) (r + 32);
+#endif
+}
+
+static inline int I32_CTZ(unsigned long v) {
+  if (!v) {
+    return 32;
+  }
+  unsigned long r = 0;
+  _BitScanForward(&r, v);
+  return (int) r;
+}
+
+#define POPCOUNT_DEFINE_PORTABLE(f_n, T)                    \
+  static inline u32 f_n(T x) {                              \
+    x = x - ((x >> 1) & (T)~(T)0/3);                        \
+    x = (x & (T)~(T)0/15*3) + ((x >> 2) & (T)~(T)0/15*3);   \
+    x = (x + (x >> 4)) & (T)~(T)0/255*15;                   \
+    return (T)(x * ((T)~(T)0/255)) >> (sizeof(T) - 1) * 8;  \
+  }
+
+POPCOUNT_DEFINE_PORTABLE(I32_POPCNT, u32)
+POPCOUNT_DEFINE_PORTABLE(I64_POPCNT, u64)
+
+#undef POPCOUNT_DEFINE_PORTABLE
+
+#else
+#  define I32_CLZ(x) ((x) ? __builtin_clz(x) : 32)
+#  define I64_CLZ(x) ((x) ? __builtin_clzll(x) : 64)
+#  define I32_CTZ(x) ((x) ? __builtin_ctz(x) : 32)
+#  define I64_CTZ(x) ((x) ? __builtin_ctzll(x) : 64)
+#  define I32_POPCNT(x) (__builtin_popcount(x))
+#  define I64_POPCNT(x) (__builtin_popcountll(x))
+#endif
+
+#define DIV_S(ut, min, x, y)                                 \
+   ((UNLIKELY((y) == 0)) ?                TRAP(DIV_BY_ZERO)  \
+  : (UNLIKELY((x) == min && (y) == -1)) ? TRAP(INT_OVERFLOW) \
+  : (ut)((x) / (y)))
+
+#define REM_S(ut, min, x, y)                                \
+   ((UNLIKELY((y) == 0)) ?                TRAP(DIV_BY_ZERO) \
+  : (UNLIKELY((x) == min && (y) == -1)) ? 0                 \
+  : (ut)((x) % (y)))
+
+#define I32_DIV_S(x, y) DIV_S(u32, INT32_MIN, (s32)x, (s32)y)
+#define I64_DIV_S(x, y) DIV_S(u64, INT64_MIN, (s64)x, (s64)y)
+#define I32_REM_S(x, y) REM_S(u32, INT32_MIN, (s32)x, (s32)y)
+#define I64_REM_S(x, y) REM_S(u64, INT64_MIN, (s64)x, (s64)y)
+
+#define DIVREM_U(op, x, y) \
+  ((UNLIKELY((y) == 0)) ? TRAP(DIV_BY_ZERO) : ((x) op (y)))
+
+#define DIV_U(x, y) DIVREM_U(/, x, y)
+#define REM_U(x, y) DIVREM_U(%, x, y)
+
+#define ROTL(x, y, mask) \
+  (((x) << ((y) & (mask))) | ((x) >> (((mask) - (y) + 1) & (mask))))
+#define ROTR(x, y, mask) \
+  (((x) >> ((y) & (mask))) | ((x) << (((mask) - (y) + 1) & (mask))))
+
+#define I32_ROTL(x, y) ROTL(x, y, 31)
+#define I64_ROTL(x, y) ROTL(x, y, 63)
+#define I32_ROTR(x, y) ROTR(x, y, 31)
+#define I64_ROTR(x, y) ROTR(x, y, 63)
+
+#define FMIN(x, y)                                          \
+   ((UNLIKELY((x) != (x))) ? NAN                            \
+  : (UNLIKELY((y) != (y))) ? NAN                            \
+  : (UNLIKELY((x) == 0 && (y) == 0)) ? (signbit(x) ? x : y) \
+  : (x < y) ? x : y)
+
+#define FMAX(x, y)                                          \
+   ((UNLIKELY((x) != (x))) ? NAN                            \
+  : (UNLIKELY((y) != (y))) ? NAN                            \
+  : (UNLIKELY((x) == 0 && (y) == 0)) ? (signbit(x) ? y : x) \
+  : (x > y) ? x : y)
+
+#define TRUNC_S(ut, st, ft, min, minop, max, x)                             \
+  ((UNLIKELY((x) != (x)))                        ? TRAP(INVALID_CONVERSION) \
+   : (UNLIKELY(!((x)minop(min) && (x) < (max)))) ? TRAP(INT_OVERFLOW)       \
+                                                 : (ut)(st)(x))
+
+#define I32_TRUNC_S_F32(x) TRUNC_S(u32, s32, f32, (f32)INT32_MIN, >=, 2147483648.f, x)
+#define I64_TRUNC_S_F32(x) TRUNC_S(u64, s64, f32, (f32)INT64_MIN, >=, (f32)INT64_MAX, x)
+#define I32_TRUNC_S_F64(x) TRUNC_S(u32, s32, f64, -2147483649., >, 2147483648., x)
+#define I64_TRUNC_S_F64(x) TRUNC_S(u64, s64, f64, (f64)INT64_MIN, >=, (f64)INT64_MAX, x)
+
+#define TRUNC_U(ut, ft, max, x)                                            \
+  ((UNLIKELY((x) != (x)))                       ? TRAP(INVALID_CONVERSION) \
+   : (UNLIKELY(!((x) > (ft)-1 && (x) < (max)))) ? TRAP(INT_OVERFLOW)       \
+                                                : (ut)(x))
+
+#define I32_TRUNC_U_F32(x) TRUNC_U(u32, f32, 4294967296.f, x)
+#define I64_TRUNC_U_F32(x) TRUNC_U(u64, f32, (f32)UINT64_MAX, x)
+#define I32_TRUNC_U_F64(x) TRUNC_U(u32, f64, 4294967296.,  x)
+#define I64_TRUNC_U_F64(x) TRUNC_U(u64, f64, (f64)UINT64_MAX, x)
+
+#define TRUNC_SAT_S(ut, st, ft, min, smin, minop, max, smax, x) \
+  ((UNLIKELY((x) != (x)))         ? 0                           \
+   : (UNLIKELY(!((x)minop(min)))) ? smin                        \
+   : (UNLIKELY(!((x) < (max))))   ? smax                        \
+                                  : (ut)(st)(x))
+
+#define I32_TRUNC_SAT_S_F32(x) TRUNC_SAT_S(u32, s32, f32, (f32)INT32_MIN, INT32_MIN, >=, 2147483648.f, INT32_MAX, x)
+#define I64_TRUNC_SAT_S_F32(x) TRUNC_SAT_S(u64, s64, f32, (f32)INT64_MIN, INT64_MIN, >=, (f32)INT64_MAX, INT64_MAX, x)
+#define I32_TRUNC_SAT_S_F64(x) TRUNC_SAT_S(u32, s32, f64, -2147483649., INT32_MIN, >, 2147483648., INT32_MAX, x)
+#define I64_TRUNC_SAT_S_F64(x) TRUNC_SAT_S(u64, s64, f64, (f64)INT64_MIN, INT64_MIN, >=, (f64)INT64_MAX, INT64_MAX, x)
+
+#define TRUNC_SAT_U(ut, ft, max, smax, x) \
+  ((UNLIKELY((x) != (x)))        ? 0      \
+   : (UNLIKELY(!((x) > (ft)-1))) ? 0      \
+   : (UNLIKELY(!((x) < (max))))  ? smax   \
+                                 : (ut)(x))
+
+#define I32_TRUNC_SAT_U_F32(x) TRUNC_SAT_U(u32, f32, 4294967296.f, UINT32_MAX, x)
+#define I64_TRUNC_SAT_U_F32(x) TRUNC_SAT_U(u64, f32, (f32)UINT64_MAX, UINT64_MAX, x)
+#define I32_TRUNC_SAT_U_F64(x) TRUNC_SAT_U(u32, f64, 4294967296., UINT32_MAX,  x)
+#define I64_TRUNC_SAT_U_F64(x) TRUNC_SAT_U(u64, f64, (f64)UINT64_MAX, UINT64_MAX, x)
+
+#define DEFINE_REINTERPRET(name, t1, t2)  \
+  static inline t2 name(t1 x) {           \
+    t2 result;                            \
+    memcpy(&result, &x, sizeof(result));  \
+    return result;                        \
+  }
+
+DEFINE_REINTERPRET(f32_reinterpret_i32, u32, f32)
+DEFINE_REINTERPRET(i32_reinterpret_f32, f32, u32)
+DEFINE_REINTERPRET(f64_reinterpret_i64, u64, f64)
+DEFINE_REINTERPRET(i64_reinterpret_f64, f64, u64)
+
+// return_call and return_call_indirect use WASM_RT_MUSTTAIL when the caller and
+// callee have the same signature. Otherwise, the caller stores the callee and
+// its arguments in the sandbox and returns, and the wrapper of the function
+// that started the chain of tail calls runs them one after the other. Each
+// argument and result takes one slot of the sandbox's buffers.
+#define TAIL_CALL_SLOT_SIZE 16
+
+#define TAIL_CALL_ARG(sbx, i, x) \
+  memcpy((sbx)->tail_call_args + (i) * TAIL_CALL_SLOT_SIZE, &(x), sizeof(x))
+
+#define TAIL_CALL_GET_ARG(sbx, i, x) \
+  memcpy(&(x), (sbx)->tail_call_args + (i) * TAIL_CALL_SLOT_SIZE, sizeof(x))
+
+#define RUN_TAIL_CALLS(sbx)                                         \
+  while ((sbx)->tail_call_next) {                                   \
+    void (*next)(wasm2c_sandbox_t* const) = (sbx)->tail_call_next;  \
+    (sbx)->tail_call_next = 0;                                      \
+    next(sbx);                                                      \
+  }
+
+#define RETURN_CALL_INDIRECT(table, t, type_id, x, ...)                   \
+  if (LIKELY((x) < table.size && table.data[x].func_type == (type_id))) { \
+    EXTERNAL_CALLBACK_PROLOGUE_EXEC(table, x);                            \
+    WASM_RT_MUSTTAIL return ((t)table.data[x].func)(__VA_ARGS__);         \
+  } else {                                                                \
+    wasm_rt_callback_error_trap(&table, x, type_id);                      \
+  }
+
+struct wasm2c_sandbox_t {
+  wasm_sandbox_wasi_data wasi_data;
+  wasm_rt_memory_t w2c_M0;
+  u32 w2c_T0_current_index;
+  wasm_rt_table_t w2c_T0;
+  u32 func_types[8];
+  void (*tail_call_next)(wasm2c_sandbox_t* const);
+  u8 tail_call_args[3 * TAIL_CALL_SLOT_SIZE];
+  u8 tail_call_results[1 * TAIL_CALL_SLOT_SIZE];
+};
+
+
+static void init_func_types(wasm2c_sandbox_t* const sbx) {
+  sbx->func_types[0] = 0x94000000u;
+  sbx->func_types[1] = 0xa4000048u;
+  sbx->func_types[2] = 0x84000000u;
+  sbx->func_types[3] = 0xb4000208u;
+  sbx->func_types[4] = 0x94000008u;
+  sbx->func_types[5] = 0xa4000000u;
+  sbx->func_types[6] = 0x90000000u;
+  sbx->func_types[7] = 0xa0000000u;
+}
+
+FUNC_EXPORT u32 w2c_no_args(wasm2c_sandbox_t* const);
+static u32 w2c_no_args_tail_body(wasm2c_sandbox_t* const);
+FUNC_EXPORT u32 w2c_f1(wasm2c_sandbox_t* const);
+FUNC_EXPORT u32 w2c_even(wasm2c_sandbox_t* const, u32);
+static u32 w2c_even_tail_body(wasm2c_sandbox_t* const, u32);
+FUNC_EXPORT u32 w2c_odd(wasm2c_sandbox_t* const, u32);
+static u32 w2c_odd_tail_body(wasm2c_sandbox_t* const, u32);
+FUNC_EXPORT u64 w2c_f4(wasm2c_sandbox_t* const, u32, u64);
+static u64 w2c_f4_tail_body(wasm2c_sandbox_t* const, u32, u64);
+FUNC_EXPORT u64 w2c_f5(wasm2c_sandbox_t* const, u32, u64, u32);
+static u64 w2c_f5_tail_body(wasm2c_sandbox_t* const, u32, u64, u32);
+FUNC_EXPORT u64 w2c_f(wasm2c_sandbox_t* const, u32, u64);
+static u64 w2c_f_tail_body(wasm2c_sandbox_t* const, u32, u64);
+FUNC_EXPORT u64 w2c_f_indirect(wasm2c_sandbox_t* const, u32);
+static u64 w2c_f_indirect_tail_body(wasm2c_sandbox_t* const, u32);
+FUNC_EXPORT u32 w2c_chain(wasm2c_sandbox_t* const, u32);
+static u32 w2c_chain_tail_body(wasm2c_sandbox_t* const, u32);
+FUNC_EXPORT u32 w2c_f9(wasm2c_sandbox_t* const, u32);
+static u32 w2c_f9_tail_body(wasm2c_sandbox_t* const, u32);
+FUNC_EXPORT u32 w2c_f10(wasm2c_sandbox_t* const, u32, u32);
+FUNC_EXPORT void w2c_no_results(wasm2c_sandbox_t* const, u32);
+static void w2c_no_results_tail_body(wasm2c_sandbox_t* const, u32);
+FUNC_EXPORT void w2c_f12(wasm2c_sandbox_t* const, u32, u32);
+FUNC_EXPORT u32 w2c_load(wasm2c_sandbox_t* const);
+FUNC_EXPORT u32 w2c_trap(wasm2c_sandbox_t* const);
+static u32 w2c_trap_tail_body(wasm2c_sandbox_t* const);
+static void tail_call_w2c_f1(wasm2c_sandbox_t* const);
+static void tail_call_w2c_odd(wasm2c_sandbox_t* const);
+static void tail_call_w2c_f4(wasm2c_sandbox_t* const);
+static void tail_call_w2c_f5(wasm2c_sandbox_t* const);
+static void tail_call_w2c_f9(wasm2c_sandbox_t* const);
+static void tail_call_w2c_f10(wasm2c_sandbox_t* const);
+static void tail_call_w2c_f12(wasm2c_sandbox_t* const);
+static void tail_call_indirect_0(wasm2c_sandbox_t* const);
+static void tail_call_indirect_1(wasm2c_sandbox_t* const);
+
+#if defined(ENTRY_PROLOGUE) || defined(ENTRY_EPILOGUE)
+FUNC_EXPORT u32 w2centry_w2c_no_args(wasm2c_sandbox_t* const sbx) {
+  ENTRY_PROLOGUE;
+  u32 ret = w2c_no_args(sbx);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT u32 w2centry_w2c_f1(wasm2c_sandbox_t* const sbx) {
+  ENTRY_PROLOGUE;
+  u32 ret = w2c_f1(sbx);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT u32 w2centry_w2c_even(wasm2c_sandbox_t* const sbx, u32 p0) {
+  ENTRY_PROLOGUE;
+  u32 ret = w2c_even(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT u32 w2centry_w2c_odd(wasm2c_sandbox_t* const sbx, u32 p0) {
+  ENTRY_PROLOGUE;
+  u32 ret = w2c_odd(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT u64 w2centry_w2c_f4(wasm2c_sandbox_t* const sbx, u32 p0, u64 p1) {
+  ENTRY_PROLOGUE;
+  u64 ret = w2c_f4(sbx, p0, p1);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT u64 w2centry_w2c_f5(wasm2c_sandbox_t* const sbx, u32 p0, u64 p1, u32 p2) {
+  ENTRY_PROLOGUE;
+  u64 ret = w2c_f5(sbx, p0, p1, p2);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT u64 w2centry_w2c_f(wasm2c_sandbox_t* const sbx, u32 p0, u64 p1) {
+  ENTRY_PROLOGUE;
+  u64 ret = w2c_f(sbx, p0, p1);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT u64 w2centry_w2c_f_indirect(wasm2c_sandbox_t* const sbx, u32 p0) {
+  ENTRY_PROLOGUE;
+  u64 ret = w2c_f_indirect(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT u32 w2centry_w2c_chain(wasm2c_sandbox_t* const sbx, u32 p0) {
+  ENTRY_PROLOGUE;
+  u32 ret = w2c_chain(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT u32 w2centry_w2c_f9(wasm2c_sandbox_t* const sbx, u32 p0) {
+  ENTRY_PROLOGUE;
+  u32 ret = w2c_f9(sbx, p0);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT u32 w2centry_w2c_f10(wasm2c_sandbox_t* const sbx, u32 p0, u32 p1) {
+  ENTRY_PROLOGUE;
+  u32 ret = w2c_f10(sbx, p0, p1);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT void w2centry_w2c_no_results(wasm2c_sandbox_t* const sbx, u32 p0) {
+  ENTRY_PROLOGUE;
+  w2c_no_results(sbx, p0);
+  ENTRY_EPILOGUE;
+}
+
+FUNC_EXPORT void w2centry_w2c_f12(wasm2c_sandbox_t* const sbx, u32 p0, u32 p1) {
+  ENTRY_PROLOGUE;
+  w2c_f12(sbx, p0, p1);
+  ENTRY_EPILOGUE;
+}
+
+FUNC_EXPORT u32 w2centry_w2c_load(wasm2c_sandbox_t* const sbx) {
+  ENTRY_PROLOGUE;
+  u32 ret = w2c_load(sbx);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+FUNC_EXPORT u32 w2centry_w2c_trap(wasm2c_sandbox_t* const sbx) {
+  ENTRY_PROLOGUE;
+  u32 ret = w2c_trap(sbx);
+  ENTRY_EPILOGUE;
+  return ret;
+}
+
+#endif
+
+static void init_globals(wasm2c_sandbox_t* const sbx) {
+  (void)sbx;
+}
+
+static u32 w2c_no_args_tail_body(wasm2c_sandbox_t* const sbx) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0;
+  #ifdef WASM_RT_MUSTTAIL
+  WASM_RT_MUSTTAIL return w2c_f1(sbx);
+  #else
+  sbx->tail_call_next = &tail_call_w2c_f1;
+  goto w2c_Bfunc;
+  #endif
+  w2c_Bfunc:;
+  FUNC_EPILOGUE;
+  return w2c_i0;
+}
+
+FUNC_EXPORT u32 w2c_no_args(wasm2c_sandbox_t* const sbx) {
+  u32 ret = w2c_no_args_tail_body(sbx);
+  if (UNLIKELY(sbx->tail_call_next)) {
+    RUN_TAIL_CALLS(sbx);
+    memcpy(&ret, sbx->tail_call_results, sizeof(ret));
+  }
+  return ret;
+}
+
+FUNC_EXPORT u32 w2c_f1(wasm2c_sandbox_t* const sbx) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0;
+  w2c_i0 = 7u;
+  FUNC_EPILOGUE;
+  return w2c_i0;
+}
+
+static u32 w2c_even_tail_body(wasm2c_sandbox_t* const sbx, u32 w2c_p0) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0, w2c_i1;
+  w2c_i0 = w2c_p0;
+  w2c_i0 = !(w2c_i0);
+  if (w2c_i0) {
+    w2c_i0 = 1u;
+  } else {
+    w2c_i0 = w2c_p0;
+    w2c_i1 = 1u;
+    w2c_i0 -= w2c_i1;
+    #ifdef WASM_RT_MUSTTAIL
+    WASM_RT_MUSTTAIL return w2c_odd_tail_body(sbx, w2c_i0);
+    #else
+    TAIL_CALL_ARG(sbx, 0, w2c_i0);
+    sbx->tail_call_next = &tail_call_w2c_odd;
+    goto w2c_Bfunc;
+    #endif
+  }
+  w2c_Bfunc:;
+  FUNC_EPILOGUE;
+  return w2c_i0;
+}
+
+FUNC_EXPORT u32 w2c_even(wasm2c_sandbox_t* const sbx, u32 p0) {
+  u32 ret = w2c_even_tail_body(sbx, p0);
+  if (UNLIKELY(sbx->tail_call_next)) {
+    RUN_TAIL_CALLS(sbx);
+    memcpy(&ret, sbx->tail_call_results, sizeof(ret));
+  }
+  return ret;
+}
+
+static u32 w2c_odd_tail_body(wasm2c_sandbox_t* const sbx, u32 w2c_p0) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0, w2c_i1;
+  w2c_i0 = w2c_p0;
+  w2c_i0 = !(w2c_i0);
+  if (w2c_i0) {
+    w2c_i0 = 0u;
+  } else {
+    w2c_i0 = w2c_p0;
+    w2c_i1 = 1u;
+    w2c_i0 -= w2c_i1;
+    w2c_i1 = 0u;
+    #ifdef WASM_RT_MUSTTAIL
+    RETURN_CALL_INDIRECT(sbx->w2c_T0, u32 (*)(wasm2c_sandbox_t* const, u32), 0x94000000u, w2c_i1, sbx, w2c_i0);
+    #else
+    TAIL_CALL_ARG(sbx, 0, w2c_i0);
+    TAIL_CALL_ARG(sbx, 1, w2c_i1);
+    sbx->tail_call_next = &tail_call_indirect_0;
+    goto w2c_Bfunc;
+    #endif
+  }
+  w2c_Bfunc:;
+  FUNC_EPILOGUE;
+  return w2c_i0;
+}
+
+FUNC_EXPORT u32 w2c_odd(wasm2c_sandbox_t* const sbx, u32 p0) {
+  u32 ret = w2c_odd_tail_body(sbx, p0);
+  if (UNLIKELY(sbx->tail_call_next)) {
+    RUN_TAIL_CALLS(sbx);
+    memcpy(&ret, sbx->tail_call_results, sizeof(ret));
+  }
+  return ret;
+}
+
+static u64 w2c_f4_tail_body(wasm2c_sandbox_t* const sbx, u32 w2c_p0, u64 w2c_p1) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0, w2c_i1, w2c_i2;
+  u64 w2c_j0, w2c_j1, w2c_j2;
+  w2c_i0 = w2c_p0;
+  w2c_i0 = !(w2c_i0);
+  if (w2c_i0) {
+    w2c_j0 = w2c_p1;
+  } else {
+    w2c_i0 = w2c_p0;
+    w2c_i1 = 1u;
+    w2c_i0 -= w2c_i1;
+    w2c_j1 = w2c_p1;
+    w2c_j2 = 3ull;
+    w2c_j1 += w2c_j2;
+    w2c_i2 = 7u;
+    TAIL_CALL_ARG(sbx, 0, w2c_i0);
+    TAIL_CALL_ARG(sbx, 1, w2c_j1);
+    TAIL_CALL_ARG(sbx, 2, w2c_i2);
+    sbx->tail_call_next = &tail_call_w2c_f5;
+    goto w2c_Bfunc;
+  }
+  w2c_Bfunc:;
+  FUNC_EPILOGUE;
+  return w2c_j0;
+}
+
+FUNC_EXPORT u64 w2c_f4(wasm2c_sandbox_t* const sbx, u32 p0, u64 p1) {
+  u64 ret = w2c_f4_tail_body(sbx, p0, p1);
+  if (UNLIKELY(sbx->tail_call_next)) {
+    RUN_TAIL_CALLS(sbx);
+    memcpy(&ret, sbx->tail_call_results, sizeof(ret));
+  }
+  return ret;
+}
+
+static u64 w2c_f5_tail_body(wasm2c_sandbox_t* const sbx, u32 w2c_p0, u64 w2c_p1, u32 w2c_p2) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0, w2c_i2;
+  u64 w2c_j0, w2c_j1, w2c_j2;
+  w2c_i0 = w2c_p0;
+  w2c_j1 = w2c_p1;
+  w2c_i2 = w2c_p2;
+  w2c_j2 = (u64)(w2c_i2);
+  w2c_j1 += w2c_j2;
+  TAIL_CALL_ARG(sbx, 0, w2c_i0);
+  TAIL_CALL_ARG(sbx, 1, w2c_j1);
+  sbx->tail_call_next = &tail_call_w2c_f4;
+  goto w2c_Bfunc;
+  w2c_Bfunc:;
+  FUNC_EPILOGUE;
+  return w2c_j0;
+}
+
+FUNC_EXPORT u64 w2c_f5(wasm2c_sandbox_t* const sbx, u32 p0, u64 p1, u32 p2) {
+  u64 ret = w2c_f5_tail_body(sbx, p0, p1, p2);
+  if (UNLIKELY(sbx->tail_call_next)) {
+    RUN_TAIL_CALLS(sbx);
+    memcpy(&ret, sbx->tail_call_results, sizeof(ret));
+  }
+  return ret;
+}
+
+static u64 w2c_f_tail_body(wasm2c_sandbox_t* const sbx, u32 w2c_p0, u64 w2c_p1) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0;
+  u64 w2c_j0, w2c_j1;
+  w2c_i0 = w2c_p0;
+  w2c_j1 = w2c_p1;
+  #ifdef WASM_RT_MUSTTAIL
+  WASM_RT_MUSTTAIL return w2c_f4_tail_body(sbx, w2c_i0, w2c_j1);
+  #else
+  TAIL_CALL_ARG(sbx, 0, w2c_i0);
+  TAIL_CALL_ARG(sbx, 1, w2c_j1);
+  sbx->tail_call_next = &tail_call_w2c_f4;
+  goto w2c_Bfunc;
+  #endif
+  w2c_Bfunc:;
+  FUNC_EPILOGUE;
+  return w2c_j0;
+}
+
+FUNC_EXPORT u64 w2c_f(wasm2c_sandbox_t* const sbx, u32 p0, u64 p1) {
+  u64 ret = w2c_f_tail_body(sbx, p0, p1);
+  if (UNLIKELY(sbx->tail_call_next)) {
+    RUN_TAIL_CALLS(sbx);
+    memcpy(&ret, sbx->tail_call_results, sizeof(ret));
+  }
+  return ret;
+}
+
+static u64 w2c_f_indirect_tail_body(wasm2c_sandbox_t* const sbx, u32 w2c_p0) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0, w2c_i2;
+  u64 w2c_j0, w2c_j1;
+  w2c_i0 = w2c_p0;
+  w2c_j1 = 100ull;
+  w2c_i2 = 2u;
+  TAIL_CALL_ARG(sbx, 0, w2c_i0);
+  TAIL_CALL_ARG(sbx, 1, w2c_j1);
+  TAIL_CALL_ARG(sbx, 2, w2c_i2);
+  sbx->tail_call_next = &tail_call_indirect_1;
+  goto w2c_Bfunc;
+  w2c_Bfunc:;
+  FUNC_EPILOGUE;
+  return w2c_j0;
+}
+
+FUNC_EXPORT u64 w2c_f_indirect(wasm2c_sandbox_t* const sbx, u32 p0) {
+  u64 ret = w2c_f_indirect_tail_body(sbx, p0);
+  if (UNLIKELY(sbx->tail_call_next)) {
+    RUN_TAIL_CALLS(sbx);
+    memcpy(&ret, sbx->tail_call_results, sizeof(ret));
+  }
+  return ret;
+}
+
+static u32 w2c_chain_tail_body(wasm2c_sandbox_t* const sbx, u32 w2c_p0) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0;
+  w2c_i0 = w2c_p0;
+  #ifdef WASM_RT_MUSTTAIL
+  WASM_RT_MUSTTAIL return w2c_f9_tail_body(sbx, w2c_i0);
+  #else
+  TAIL_CALL_ARG(sbx, 0, w2c_i0);
+  sbx->tail_call_next = &tail_call_w2c_f9;
+  goto w2c_Bfunc;
+  #endif
+  w2c_Bfunc:;
+  FUNC_EPILOGUE;
+  return w2c_i0;
+}
+
+FUNC_EXPORT u32 w2c_chain(wasm2c_sandbox_t* const sbx, u32 p0) {
+  u32 ret = w2c_chain_tail_body(sbx, p0);
+  if (UNLIKELY(sbx->tail_call_next)) {
+    RUN_TAIL_CALLS(sbx);
+    memcpy(&ret, sbx->tail_call_results, sizeof(ret));
+  }
+  return ret;
+}
+
+static u32 w2c_f9_tail_body(wasm2c_sandbox_t* const sbx, u32 w2c_p0) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0, w2c_i1;
+  w2c_i0 = w2c_p0;
+  w2c_i1 = 10u;
+  TAIL_CALL_ARG(sbx, 0, w2c_i0);
+  TAIL_CALL_ARG(sbx, 1, w2c_i1);
+  sbx->tail_call_next = &tail_call_w2c_f10;
+  goto w2c_Bfunc;
+  w2c_Bfunc:;
+  FUNC_EPILOGUE;
+  return w2c_i0;
+}
+
+FUNC_EXPORT u32 w2c_f9(wasm2c_sandbox_t* const sbx, u32 p0) {
+  u32 ret = w2c_f9_tail_body(sbx, p0);
+  if (UNLIKELY(sbx->tail_call_next)) {
+    RUN_TAIL_CALLS(sbx);
+    memcpy(&ret, sbx->tail_call_results, sizeof(ret));
+  }
+  return ret;
+}
+
+FUNC_EXPORT u32 w2c_f10(wasm2c_sandbox_t* const sbx, u32 w2c_p0, u32 w2c_p1) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0, w2c_i1;
+  w2c_i0 = w2c_p0;
+  w2c_i1 = w2c_p1;
+  w2c_i0 *= w2c_i1;
+  FUNC_EPILOGUE;
+  return w2c_i0;
+}
+
+static void w2c_no_results_tail_body(wasm2c_sandbox_t* const sbx, u32 w2c_p0) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0, w2c_i1;
+  w2c_i0 = 0u;
+  w2c_i1 = w2c_p0;
+  TAIL_CALL_ARG(sbx, 0, w2c_i0);
+  TAIL_CALL_ARG(sbx, 1, w2c_i1);
+  sbx->tail_call_next = &tail_call_w2c_f12;
+  goto w2c_Bfunc;
+  w2c_Bfunc:;
+  FUNC_EPILOGUE;
+}
+
+FUNC_EXPORT void w2c_no_results(wasm2c_sandbox_t* const sbx, u32 p0) {
+  w2c_no_results_tail_body(sbx, p0);
+  RUN_TAIL_CALLS(sbx);
+}
+
+FUNC_EXPORT void w2c_f12(wasm2c_sandbox_t* const sbx, u32 w2c_p0, u32 w2c_p1) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0, w2c_i1;
+  w2c_i0 = w2c_p0;
+  w2c_i1 = w2c_p1;
+  i32_store_cached(&(sbx->w2c_M0), sbx->w2c_M0.data, 65536ull, (u64)(w2c_i0), w2c_i1, WASM2C_SHADOW_FUNC_PROGRAM, "w2c_f12");
+  FUNC_EPILOGUE;
+}
+
+FUNC_EXPORT u32 w2c_load(wasm2c_sandbox_t* const sbx) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0;
+  w2c_i0 = 0u;
+  w2c_i0 = i32_load_unchecked(&(sbx->w2c_M0), (u64)(w2c_i0), WASM2C_SHADOW_FUNC_PROGRAM, "w2c_load");
+  FUNC_EPILOGUE;
+  return w2c_i0;
+}
+
+static u32 w2c_trap_tail_body(wasm2c_sandbox_t* const sbx) {
+  FUNC_PROLOGUE;
+  u32 w2c_i0, w2c_i1;
+  w2c_i0 = 0u;
+  w2c_i1 = 3u;
+  TAIL_CALL_ARG(sbx, 0, w2c_i0);
+  TAIL_CALL_ARG(sbx, 1, w2c_i1);
+  sbx->tail_call_next = &tail_call_indirect_0;
+  goto w2c_Bfunc;
+  w2c_Bfunc:;
+  FUNC_EPILOGUE;
+  return w2c_i0;
+}
+
+FUNC_EXPORT u32 w2c_trap(wasm2c_sandbox_t* const sbx) {
+  u32 ret = w2c_trap_tail_body(sbx);
+  if (UNLIKELY(sbx->tail_call_next)) {
+    RUN_TAIL_CALLS(sbx);
+    memcpy(&ret, sbx->tail_call_results, sizeof(ret));
+  }
+  return ret;
+}
+
+static void tail_call_w2c_f1(wasm2c_sandbox_t* const sbx) {
+  u32 ret = w2c_f1(sbx);
+  memcpy(sbx->tail_call_results, &ret, sizeof(ret));
+}
+
+static void tail_call_w2c_odd(wasm2c_sandbox_t* const sbx) {
+  u32 p0;
+  TAIL_CALL_GET_ARG(sbx, 0, p0);
+  u32 ret = w2c_odd_tail_body(sbx, p0);
+  memcpy(sbx->tail_call_results, &ret, sizeof(ret));
+}
+
+static void tail_call_w2c_f4(wasm2c_sandbox_t* const sbx) {
+  u32 p0;
+  TAIL_CALL_GET_ARG(sbx, 0, p0);
+  u64 p1;
+  TAIL_CALL_GET_ARG(sbx, 1, p1);
+  u64 ret = w2c_f4_tail_body(sbx, p0, p1);
+  memcpy(sbx->tail_call_results, &ret, sizeof(ret));
+}
+
+static void tail_call_w2c_f5(wasm2c_sandbox_t* const sbx) {
+  u32 p0;
+  TAIL_CALL_GET_ARG(sbx, 0, p0);
+  u64 p1;
+  TAIL_CALL_GET_ARG(sbx, 1, p1);
+  u32 p2;
+  TAIL_CALL_GET_ARG(sbx, 2, p2);
+  u64 ret = w2c_f5_tail_body(sbx, p0, p1, p2);
+  memcpy(sbx->tail_call_results, &ret, sizeof(ret));
+}
+
+static void tail_call_w2c_f9(wasm2c_sandbox_t* const sbx) {
+  u32 p0;
+  TAIL_CALL_GET_ARG(sbx, 0, p0);
+  u32 ret = w2c_f9_tail_body(sbx, p0);
+  memcpy(sbx->tail_call_results, &ret, sizeof(ret));
+}
+
+static void tail_call_w2c_f10(wasm2c_sandbox_t* const sbx) {
+  u32 p0;
+  TAIL_CALL_GET_ARG(sbx, 0, p0);
+  u32 p1;
+  TAIL_CALL_GET_ARG(sbx, 1, p1);
+  u32 ret = w2c_f10(sbx, p0, p1);
+  memcpy(sbx->tail_call_results, &ret, sizeof(ret));
+}
+
+static void tail_call_w2c_f12(wasm2c_sandbox_t* const sbx) {
+  u32 p0;
+  TAIL_CALL_GET_ARG(sbx, 0, p0);
+  u32 p1;
+  TAIL_CALL_GET_ARG(sbx, 1, p1);
+  w2c_f12(sbx, p0, p1);
+}
+
+static void tail_call_indirect_0(wasm2c_sandbox_t* const sbx) {
+  u32 p0;
+  TAIL_CALL_GET_ARG(sbx, 0, p0);
+  u32 index;
+  TAIL_CALL_GET_ARG(sbx, 1, index);
+  u32 ret;
+  if (index < sbx->w2c_T0.size && sbx->w2c_T0.data[index].func == (wasm_rt_anyfunc_t)&w2c_even) {
+    ret = w2c_even_tail_body(sbx, p0);
+    memcpy(sbx->tail_call_results, &ret, sizeof(ret));
+    return;
+  }
+  if (index < sbx->w2c_T0.size && sbx->w2c_T0.data[index].func == (wasm_rt_anyfunc_t)&w2c_odd) {
+    ret = w2c_odd_tail_body(sbx, p0);
+    memcpy(sbx->tail_call_results, &ret, sizeof(ret));
+    return;
+  }
+  if (index < sbx->w2c_T0.size && sbx->w2c_T0.data[index].func == (wasm_rt_anyfunc_t)&w2c_chain) {
+    ret = w2c_chain_tail_body(sbx, p0);
+    memcpy(sbx->tail_call_results, &ret, sizeof(ret));
+    return;
+  }
+  if (index < sbx->w2c_T0.size && sbx->w2c_T0.data[index].func == (wasm_rt_anyfunc_t)&w2c_f9) {
+    ret = w2c_f9_tail_body(sbx, p0);
+    memcpy(sbx->tail_call_results, &ret, sizeof(ret));
+    return;
+  }
+  CALL_INDIRECT_RES(ret, sbx->w2c_T0, u32 (*)(wasm2c_sandbox_t* const, u32), 0x94000000u, index, sbx, p0);
+  memcpy(sbx->tail_call_results, &ret, sizeof(ret));
+}
+
+static void tail_call_indirect_1(wasm2c_sandbox_t* const sbx) {
+  u32 p0;
+  TAIL_CALL_GET_ARG(sbx, 0, p0);
+  u64 p1;
+  TAIL_CALL_GET_ARG(sbx, 1, p1);
+  u32 index;
+  TAIL_CALL_GET_ARG(sbx, 2, index);
+  u64 ret;
+  if (index < sbx->w2c_T0.size && sbx->w2c_T0.data[index].func == (wasm_rt_anyfunc_t)&w2c_f4) {
+    ret = w2c_f4_tail_body(sbx, p0, p1);
+    memcpy(sbx->tail_call_results, &ret, sizeof(ret));
+    return;
+  }
+  if (index < sbx->w2c_T0.size && sbx->w2c_T0.data[index].func == (wasm_rt_anyfunc_t)&w2c_f) {
+    ret = w2c_f_tail_body(sbx, p0, p1);
+    memcpy(sbx->tail_call_results, &ret, sizeof(ret));
+    return;
+  }
+  CALL_INDIRECT_RES(ret, sbx->w2c_T0, u64 (*)(wasm2c_sandbox_t* const, u32, u64), 0xa4000048u, index, sbx, p0, p1);
+  memcpy(sbx->tail_call_results, &ret, sizeof(ret));
+}
+
+
+static bool init_memory(wasm2c_sandbox_t* const sbx, uint32_t max_wasm_pages_from_rt) {
+  const uint32_t max_pages_specified_in_module = 0;
+  const uint32_t max_pages = max_wasm_pages_from_rt == 0? max_pages_specified_in_module : max_wasm_pages_from_rt;
+  const bool success = wasm_rt_allocate_memory(&(sbx->w2c_M0), 1, max_pages);
+  if (!success) { return false; }
+  WASM2C_SHADOW_MEMORY_INIT_SAMPLE_RATE(&(sbx->w2c_M0));
+  
+  sbx->wasi_data.heap_memory = &(sbx->w2c_M0);
+  return true;
+}
+
+static bool init_thread_memory(wasm2c_sandbox_t* const sbx, wasm2c_sandbox_t* const parent) {
+  (void)sbx;
+  (void)parent;
+  return false;
+}
+
+static void cleanup_memory(wasm2c_sandbox_t* const sbx) {
+  wasm_rt_deallocate_memory(&(sbx->w2c_M0));
+}
+
+static void init_table(wasm2c_sandbox_t* const sbx) {
+  uint32_t offset = 0;
+  wasm_rt_allocate_table(&(sbx->w2c_T0), 4, 4294967295);
+  offset = 0u;
+  sbx->w2c_T0.data[offset + 0] = (wasm_rt_elem_t){ WASM_RT_INTERNAL_FUNCTION, 0x94000000u, (wasm_rt_anyfunc_t)(&w2c_even) };
+  sbx->w2c_T0.data[offset + 1] = (wasm_rt_elem_t){ WASM_RT_INTERNAL_FUNCTION, 0x94000000u, (wasm_rt_anyfunc_t)(&w2c_odd) };
+  sbx->w2c_T0.data[offset + 2] = (wasm_rt_elem_t){ WASM_RT_INTERNAL_FUNCTION, 0xa4000048u, (wasm_rt_anyfunc_t)(&w2c_f4) };
+  sbx->w2c_T0.data[offset + 3] = (wasm_rt_elem_t){ WASM_RT_INTERNAL_FUNCTION, 0x84000000u, (wasm_rt_anyfunc_t)(&w2c_f1) };
+  sbx->w2c_T0_current_index = offset + 4;
+}
+
+static void cleanup_table(wasm2c_sandbox_t* const sbx) {
+  wasm_rt_deallocate_table(&(sbx->w2c_T0));
+}
+
+typedef struct {
+  const char* name;
+  /* The function, with the index of its type, or 0 for other exports. */
+  wasm_rt_anyfunc_t func;
+  u32 func_type;
+  /* The offset of other exports in the sandbox. */
+  u32 offset;
+  /* Whether the sandbox holds a pointer to the export instead. */
+  u32 is_pointer;
+} wasm2c_export_t;
+
+static const u32 wasm2c_export_seeds[8] = {
+  1, 2, 0, 1, 17, 6, 16, 1,
+};
+
+static const wasm2c_export_t wasm2c_exports[17] = {
+  { "w2c_no_results", (wasm_rt_anyfunc_t)&w2c_no_results, 6, 0, 0 },
+  { "w2c_M0", 0, 0, offsetof(wasm2c_sandbox_t, w2c_M0), 0 },
+  { "w2c_T0", 0, 0, offsetof(wasm2c_sandbox_t, w2c_T0), 0 },
+  { "w2c_f9", (wasm_rt_anyfunc_t)&w2c_f9, 0, 0, 0 },
+  { "w2c_trap", (wasm_rt_anyfunc_t)&w2c_trap, 2, 0, 0 },
+  { "w2c_f5", (wasm_rt_anyfunc_t)&w2c_f5, 3, 0, 0 },
+  { "w2c_load", (wasm_rt_anyfunc_t)&w2c_load, 2, 0, 0 },
+  { "w2c_f1", (wasm_rt_anyfunc_t)&w2c_f1, 2, 0, 0 },
+  { "w2c_f", (wasm_rt_anyfunc_t)&w2c_f, 1, 0, 0 },
+  { "w2c_chain", (wasm_rt_anyfunc_t)&w2c_chain, 0, 0, 0 },
+  { "w2c_no_args", (wasm_rt_anyfunc_t)&w2c_no_args, 2, 0, 0 },
+  { "w2c_f10", (wasm_rt_anyfunc_t)&w2c_f10, 5, 0, 0 },
+  { "w2c_f4", (wasm_rt_anyfunc_t)&w2c_f4, 1, 0, 0 },
+  { "w2c_odd", (wasm_rt_anyfunc_t)&w2c_odd, 0, 0, 0 },
+  { "w2c_f12", (wasm_rt_anyfunc_t)&w2c_f12, 7, 0, 0 },
+  { "w2c_even", (wasm_rt_anyfunc_t)&w2c_even, 0, 0, 0 },
+  { "w2c_f_indirect", (wasm_rt_anyfunc_t)&w2c_f_indirect, 4, 0, 0 },
+};
+
+static u32 hash_wasm2c_export_name(const char* name, u32 seed) {
+  u32 hash = (2166136261u ^ seed) * 16777619u;
+  for (; *name; name++) {
+    hash = (hash ^ (u8)*name) * 16777619u;
+  }
+  hash = (hash ^ (hash >> 16)) * 0x85ebca6bu;
+  hash = (hash ^ (hash >> 13)) * 0xc2b2ae35u;
+  return hash ^ (hash >> 16);
+}
+
+static const wasm2c_export_t* find_wasm2c_export(const char* name) {
+  u32 seed = wasm2c_export_seeds[hash_wasm2c_export_name(name, 0) % 8];
+  const wasm2c_export_t* entry = &wasm2c_exports[hash_wasm2c_export_name(name, seed) % 17];
+  return entry->name && strcmp(entry->name, name) == 0 ? entry : 0;
+}
+
+static void* lookup_wasm2c_nonfunc_export(void* sbx_ptr, const char* name) {
+  const wasm2c_export_t* entry = find_wasm2c_export(name);
+  if (!entry || entry->func) {
+    return 0;
+  }
+  void* field = (char*) sbx_ptr + entry->offset;
+  return entry->is_pointer ? *(void**) field : field;
+}
+
+static wasm_rt_anyfunc_t lookup_wasm2c_func_export(void* sbx_ptr, const char* name, u32* func_type) {
+  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) sbx_ptr;
+  const wasm2c_export_t* entry = find_wasm2c_export(name);
+  if (!entry || !entry->func) {
+    return 0;
+  }
+  if (func_type) {
+    *func_type = sbx->func_types[entry->func_type];
+  }
+  return entry->func;
+}
+
+static wasm_rt_table_t* get_wasm2c_callback_table(void* sbx_ptr){
+  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) sbx_ptr;
+  return &(sbx->w2c_T0);
+}
+
+static wasm_rt_memory_t* get_wasm2c_memory(wasm2c_sandbox_t* const sbx){
+  return &(sbx->w2c_M0);
+}
+
+static void init_profile(wasm2c_sandbox_t* const sbx) {
+  (void)sbx;
+}
+
+static void cleanup_profile(wasm2c_sandbox_t* const sbx) {
+  (void)sbx;
+}
+
+static wasm_rt_profile_t* get_wasm2c_profile(wasm2c_sandbox_t* const sbx) {
+  (void)sbx;
+  return 0;
+}
+
+static void init_module_starts(wasm2c_sandbox_t* const sbx) {
+  (void)sbx;
+}
+//test
+
+static u32 add_wasm2c_callback(void* sbx_ptr, u32 func_type_idx, void* func_ptr, wasm_rt_elem_target_class_t func_class) {
+  wasm_rt_table_t* table = get_wasm2c_callback_table(sbx_ptr);
+  u32 i = wasm_rt_table_alloc_slot(table);
+  table->data[i] = (wasm_rt_elem_t){ func_class, func_type_idx, (wasm_rt_anyfunc_t) func_ptr };
+  return i;
+}
+
+static void remove_wasm2c_callback(void* sbx_ptr, u32 callback_idx) {
+  wasm_rt_table_t* table = get_wasm2c_callback_table(sbx_ptr);
+  wasm_rt_table_free_slot(table, callback_idx);
+}
+
+static u32 lookup_wasm2c_func_index(void* sbx_ptr, u32 param_count, u32 result_count, wasm_rt_type_t* types) {
+  // Function type indices are shared by all sandboxes.
+  (void) sbx_ptr;
+  return wasm_rt_register_func_type(param_count, result_count, types);
+}
+
+static void* create_wasm2c_sandbox(uint32_t max_wasm_pages) {
+  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) calloc(sizeof(wasm2c_sandbox_t), 1);
+  if (!init_memory(sbx, max_wasm_pages)) {
+    free(sbx);
+    return 0;
+  }
+  init_func_types(sbx);
+  init_globals(sbx);
+  init_table(sbx);
+  init_profile(sbx);
+  wasm_rt_init_wasi(&(sbx->wasi_data));
+  init_module_starts(sbx);
+  return sbx;
+}
+
+// Creates another instance of the module for a new thread. It has its own
+// globals and table, but shares the (shared) linear memory of `parent_ptr`,
+// which must stay alive until every thread sandbox created from it has been
+// destroyed. Returns 0 if the module has no shared memory, or if out of memory.
+static void* create_wasm2c_sandbox_thread(void* parent_ptr) {
+  wasm2c_sandbox_t* const parent = (wasm2c_sandbox_t* const) parent_ptr;
+  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) calloc(sizeof(wasm2c_sandbox_t), 1);
+  if (!sbx) {
+    return 0;
+  }
+  if (!init_thread_memory(sbx, parent)) {
+    free(sbx);
+    return 0;
+  }
+  init_func_types(sbx);
+  init_globals(sbx);
+  init_table(sbx);
+  init_profile(sbx);
+  wasm_rt_init_wasi(&(sbx->wasi_data));
+  return sbx;
+}
+
+static void destroy_wasm2c_sandbox(void* aSbx) {
+  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) aSbx;
+  cleanup_memory(sbx);
+  cleanup_table(sbx);
+  cleanup_profile(sbx);
+  wasm_rt_cleanup_wasi(&(sbx->wasi_data));
+  free(sbx);
+}
+
+// A copy of the linear memory, globals and table of an initialized sandbox.
+// The copy of the sandbox struct holds the globals, the table's size and the
+// function type indices; everything it points to is copied separately.
+typedef struct wasm2c_sandbox_snapshot_t {
+  wasm2c_sandbox_t sbx;
+  wasm_rt_memory_image_t memory_image;
+  wasm_rt_elem_t* table_data;
+} wasm2c_sandbox_snapshot_t;
+
+// Returns 0 if the module's memory is shared, or if memory images are not
+// supported.
+static void* create_wasm2c_sandbox_snapshot(void* sbx_ptr) {
+  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) sbx_ptr;
+  wasm_rt_memory_t* memory = get_wasm2c_memory(sbx);
+  if (!memory || memory->is_shared) {
+    return 0;
+  }
+  wasm2c_sandbox_snapshot_t* const snapshot = (wasm2c_sandbox_snapshot_t*) calloc(sizeof(wasm2c_sandbox_snapshot_t), 1);
+  if (!snapshot) {
+    return 0;
+  }
+  if (!wasm_rt_create_memory_image(&snapshot->memory_image, memory)) {
+    free(snapshot);
+    return 0;
+  }
+  memcpy(&snapshot->sbx, sbx, sizeof(wasm2c_sandbox_t));
+  wasm_rt_table_t* table = get_wasm2c_callback_table(sbx);
+  snapshot->table_data = (wasm_rt_elem_t*) malloc((table->size ? table->size : 1) * sizeof(wasm_rt_elem_t));
+  if (!snapshot->table_data) {
+    wasm_rt_free_memory_image(&snapshot->memory_image);
+    free(snapshot);
+    return 0;
+  }
+  memcpy(snapshot->table_data, table->data, table->size * sizeof(wasm_rt_elem_t));
+  return snapshot;
+}
+
+// Creates a sandbox in the state the snapshot was taken in, without running
+// any of the module's initialization. Its memory is mapped copy-on-write from
+// the snapshot. The WASI state and the profile are not part of the snapshot,
+// and start out fresh as in create_wasm2c_sandbox.
+static void* create_wasm2c_sandbox_from_snapshot(void* snapshot_ptr, uint32_t max_wasm_pages) {
+  wasm2c_sandbox_snapshot_t* const snapshot = (wasm2c_sandbox_snapshot_t* const) snapshot_ptr;
+  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) malloc(sizeof(wasm2c_sandbox_t));
+  if (!sbx) {
+    return 0;
+  }
+  memcpy(sbx, &snapshot->sbx, sizeof(wasm2c_sandbox_t));
+  wasm_rt_memory_t* memory = get_wasm2c_memory(sbx);
+  const uint32_t max_pages = max_wasm_pages == 0 ? memory->max_pages : max_wasm_pages;
+  if (!wasm_rt_allocate_memory_from_image(memory, &snapshot->memory_image, max_pages)) {
+    free(sbx);
+    return 0;
+  }
+  WASM2C_SHADOW_MEMORY_INIT_SAMPLE_RATE(memory);
+  wasm_rt_table_t* table = get_wasm2c_callback_table(sbx);
+  wasm_rt_allocate_table(table, table->size, table->max_size);
+  memcpy(table->data, snapshot->table_data, table->size * sizeof(wasm_rt_elem_t));
+  init_profile(sbx);
+  memset(&(sbx->wasi_data), 0, sizeof(sbx->wasi_data));
+  sbx->wasi_data.heap_memory = memory;
+  wasm_rt_init_wasi(&(sbx->wasi_data));
+  return sbx;
+}
+
+static void destroy_wasm2c_sandbox_snapshot(void* snapshot_ptr) {
+  wasm2c_sandbox_snapshot_t* const snapshot = (wasm2c_sandbox_snapshot_t* const) snapshot_ptr;
+  wasm_rt_free_memory_image(&snapshot->memory_image);
+  free(snapshot->table_data);
+  free(snapshot);
+}
+
+// Returns false if the module was compiled without --instrument, or without
+// --instrument=cycles for the folded format.
+static bool dump_wasm2c_profile(void* sbx_ptr, FILE* out, wasm_rt_profile_format_t format) {
+  wasm_rt_profile_t* profile = get_wasm2c_profile((wasm2c_sandbox_t*) sbx_ptr);
+  return profile && wasm_rt_profile_dump(profile, out, format);
+}
+
+FUNC_EXPORT wasm2c_sandbox_funcs_t WASM_CURR_ADD_PREFIX(get_wasm2c_sandbox_info)() {
+  wasm2c_sandbox_funcs_t ret;
+  ret.wasm_rt_sys_init = &wasm_rt_sys_init;
+  ret.create_wasm2c_sandbox = &create_wasm2c_sandbox;
+  ret.destroy_wasm2c_sandbox = &destroy_wasm2c_sandbox;
+  ret.lookup_wasm2c_nonfunc_export = &lookup_wasm2c_nonfunc_export;
+  ret.lookup_wasm2c_func_index = &lookup_wasm2c_func_index;
+  ret.add_wasm2c_callback = &add_wasm2c_callback;
+  ret.remove_wasm2c_callback = &remove_wasm2c_callback;
+  ret.create_wasm2c_sandbox_thread = &create_wasm2c_sandbox_thread;
+  ret.create_wasm2c_sandbox_snapshot = &create_wasm2c_sandbox_snapshot;
+  ret.create_wasm2c_sandbox_from_snapshot = &create_wasm2c_sandbox_from_snapshot;
+  ret.destroy_wasm2c_sandbox_snapshot = &destroy_wasm2c_sandbox_snapshot;
+  ret.lookup_wasm2c_func_export = &lookup_wasm2c_func_export;
+  ret.dump_wasm2c_profile = &dump_wasm2c_profile;
+  return ret;
+}
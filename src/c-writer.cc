@@ -16,10 +16,12 @@
 
 #include "src/c-writer.h"
 
+#include <algorithm>
 #include <cctype>
 #include <cinttypes>
 #include <map>
 #include <set>
+#include <vector>
 
 #include "src/cast.h"
 #include "src/common.h"
@@ -92,6 +94,55 @@ struct StackVar {
   Type type;
 };
 
+struct StackValue {
+  explicit StackValue(Index index, bool parenthesize = false)
+      : index(index), parenthesize(parenthesize) {}
+  Index index;
+  bool parenthesize;
+};
+
+// The result of a pure instruction that hasn't been assigned to its stack
+// variable yet. It only refers to locals, globals and, if |reads_stack_var|,
+// the stack variable of its own slot, so it stays valid until one of the
+// |reads| is assigned.
+struct FoldedExpr {
+  std::string text;
+  std::set<std::string> reads;
+  bool reads_stack_var = false;
+  int depth = 0;
+};
+
+// What is known about a stack slot that may be used as an address: it holds
+// the current value of |local|, or the constant |value|.
+struct AddressBase {
+  std::string local;
+  bool is_const = false;
+  uint64_t value = 0;
+};
+
+// The accesses that passed their bounds check on every path to the current
+// instruction: `(u64)local + end <= memory size` for each entry of
+// |local_ends|, and `address + size <= const_end` for constant addresses.
+// Linear memory never shrinks, so these hold until the local is assigned.
+struct CheckedRanges {
+  std::map<std::string, uint64_t> local_ends;
+  uint64_t const_end = 0;
+};
+
+// Deeper expressions are assigned to their stack variable instead, so the C
+// compiler isn't handed arbitrarily nested expressions.
+static const int kMaxFoldedExprDepth = 16;
+
+// With --string-data-segments, segments at least this large are page aligned.
+static const size_t kDataSegmentAlignThreshold = 4096;
+
+// An entry of the generated export lookup table: the C name of a function,
+// memory, table or global, and the initializer of its wasm2c_export_t.
+struct ExportLookupEntry {
+  std::string name;
+  std::string value;
+};
+
 struct TypeEnum {
   explicit TypeEnum(Type type) : type(type) {}
   Type type;
@@ -119,16 +170,495 @@ int GetShiftMask(Type type) {
   }
 }
 
+size_t CountExprs(const ExprList& exprs) {
+  size_t count = 0;
+  for (const Expr& expr : exprs) {
+    ++count;
+    switch (expr.type()) {
+      case ExprType::Block:
+        count += CountExprs(cast<BlockExpr>(&expr)->block.exprs);
+        break;
+
+      case ExprType::Loop:
+        count += CountExprs(cast<LoopExpr>(&expr)->block.exprs);
+        break;
+
+      case ExprType::If: {
+        const IfExpr* if_ = cast<IfExpr>(&expr);
+        count += CountExprs(if_->true_.exprs) + CountExprs(if_->false_);
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+  return count;
+}
+
+// Upper-case operators are macros from the source template, which may evaluate
+// their arguments more than once and don't parenthesize them.
+bool IsMacro(const char* op) {
+  return isupper(static_cast<unsigned char>(op[0]));
+}
+
+bool IsSimpleExpr(const std::string& text) {
+  if (text.empty() || text[0] == '-')
+    return false;
+  for (char c : text) {
+    if (!isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '.' &&
+        c != '-' && c != '>') {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool UsesMemory(const ExprList& exprs) {
+  for (const Expr& expr : exprs) {
+    switch (expr.type()) {
+      case ExprType::Load:
+      case ExprType::Store:
+      case ExprType::LoadSplat:
+      case ExprType::LoadZero:
+      case ExprType::SimdLoadLane:
+      case ExprType::SimdStoreLane:
+      case ExprType::AtomicLoad:
+      case ExprType::AtomicStore:
+      case ExprType::AtomicRmw:
+      case ExprType::AtomicRmwCmpxchg:
+      case ExprType::AtomicWait:
+      case ExprType::AtomicNotify:
+        return true;
+
+      case ExprType::Block:
+        if (UsesMemory(cast<BlockExpr>(&expr)->block.exprs))
+          return true;
+        break;
+
+      case ExprType::Loop:
+        if (UsesMemory(cast<LoopExpr>(&expr)->block.exprs))
+          return true;
+        break;
+
+      case ExprType::If: {
+        const IfExpr* if_ = cast<IfExpr>(&expr);
+        if (UsesMemory(if_->true_.exprs) || UsesMemory(if_->false_))
+          return true;
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+  return false;
+}
+
+bool UsesMemoryGrow(const ExprList& exprs) {
+  for (const Expr& expr : exprs) {
+    switch (expr.type()) {
+      case ExprType::MemoryGrow:
+        return true;
+
+      case ExprType::Block:
+        if (UsesMemoryGrow(cast<BlockExpr>(&expr)->block.exprs))
+          return true;
+        break;
+
+      case ExprType::Loop:
+        if (UsesMemoryGrow(cast<LoopExpr>(&expr)->block.exprs))
+          return true;
+        break;
+
+      case ExprType::If: {
+        const IfExpr* if_ = cast<IfExpr>(&expr);
+        if (UsesMemoryGrow(if_->true_.exprs) || UsesMemoryGrow(if_->false_))
+          return true;
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+  return false;
+}
+
+void CollectSetLocals(const ExprList& exprs, std::set<std::string>* locals) {
+  for (const Expr& expr : exprs) {
+    switch (expr.type()) {
+      case ExprType::LocalSet:
+        locals->insert(cast<LocalSetExpr>(&expr)->var.name());
+        break;
+
+      case ExprType::LocalTee:
+        locals->insert(cast<LocalTeeExpr>(&expr)->var.name());
+        break;
+
+      case ExprType::Block:
+        CollectSetLocals(cast<BlockExpr>(&expr)->block.exprs, locals);
+        break;
+
+      case ExprType::Loop:
+        CollectSetLocals(cast<LoopExpr>(&expr)->block.exprs, locals);
+        break;
+
+      case ExprType::If: {
+        const IfExpr* if_ = cast<IfExpr>(&expr);
+        CollectSetLocals(if_->true_.exprs, locals);
+        CollectSetLocals(if_->false_, locals);
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+}
+
+bool UsesAtomics(const ExprList& exprs) {
+  for (const Expr& expr : exprs) {
+    switch (expr.type()) {
+      case ExprType::AtomicLoad:
+      case ExprType::AtomicStore:
+      case ExprType::AtomicRmw:
+      case ExprType::AtomicRmwCmpxchg:
+      case ExprType::AtomicWait:
+      case ExprType::AtomicNotify:
+      case ExprType::AtomicFence:
+        return true;
+
+      case ExprType::Block:
+        if (UsesAtomics(cast<BlockExpr>(&expr)->block.exprs))
+          return true;
+        break;
+
+      case ExprType::Loop:
+        if (UsesAtomics(cast<LoopExpr>(&expr)->block.exprs))
+          return true;
+        break;
+
+      case ExprType::If: {
+        const IfExpr* if_ = cast<IfExpr>(&expr);
+        if (UsesAtomics(if_->true_.exprs) || UsesAtomics(if_->false_))
+          return true;
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+  return false;
+}
+
+bool UsesDataSegments(const ExprList& exprs) {
+  for (const Expr& expr : exprs) {
+    switch (expr.type()) {
+      case ExprType::MemoryInit:
+      case ExprType::DataDrop:
+        return true;
+
+      case ExprType::Block:
+        if (UsesDataSegments(cast<BlockExpr>(&expr)->block.exprs))
+          return true;
+        break;
+
+      case ExprType::Loop:
+        if (UsesDataSegments(cast<LoopExpr>(&expr)->block.exprs))
+          return true;
+        break;
+
+      case ExprType::If: {
+        const IfExpr* if_ = cast<IfExpr>(&expr);
+        if (UsesDataSegments(if_->true_.exprs) || UsesDataSegments(if_->false_))
+          return true;
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+  return false;
+}
+
+void CollectGlobalGets(const Module& module,
+                       const ExprList& exprs,
+                       std::set<Index>* globals) {
+  for (const Expr& expr : exprs) {
+    switch (expr.type()) {
+      case ExprType::GlobalGet:
+        globals->insert(
+            module.GetGlobalIndex(cast<GlobalGetExpr>(&expr)->var));
+        break;
+
+      case ExprType::Block:
+        CollectGlobalGets(module, cast<BlockExpr>(&expr)->block.exprs, globals);
+        break;
+
+      case ExprType::Loop:
+        CollectGlobalGets(module, cast<LoopExpr>(&expr)->block.exprs, globals);
+        break;
+
+      case ExprType::If: {
+        const IfExpr* if_ = cast<IfExpr>(&expr);
+        CollectGlobalGets(module, if_->true_.exprs, globals);
+        CollectGlobalGets(module, if_->false_, globals);
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+}
+
+// Adds |weight| to the uses of a global for every global.get and global.set of
+// it in |exprs|.
+void CountGlobalUses(const Module& module,
+                     const ExprList& exprs,
+                     uint64_t weight,
+                     std::vector<uint64_t>* uses) {
+  for (const Expr& expr : exprs) {
+    switch (expr.type()) {
+      case ExprType::GlobalGet:
+        (*uses)[module.GetGlobalIndex(cast<GlobalGetExpr>(&expr)->var)] +=
+            weight;
+        break;
+
+      case ExprType::GlobalSet:
+        (*uses)[module.GetGlobalIndex(cast<GlobalSetExpr>(&expr)->var)] +=
+            weight;
+        break;
+
+      case ExprType::Block:
+        CountGlobalUses(module, cast<BlockExpr>(&expr)->block.exprs, weight,
+                        uses);
+        break;
+
+      case ExprType::Loop:
+        CountGlobalUses(module, cast<LoopExpr>(&expr)->block.exprs, weight,
+                        uses);
+        break;
+
+      case ExprType::If: {
+        const IfExpr* if_ = cast<IfExpr>(&expr);
+        CountGlobalUses(module, if_->true_.exprs, weight, uses);
+        CountGlobalUses(module, if_->false_, weight, uses);
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+}
+
+// The name of a function in profiles, without the "$" of the text format.
+string_view ProfileName(const Func& func) {
+  string_view name = func.name;
+  if (!name.empty() && name[0] == '$')
+    name.remove_prefix(1);
+  return name;
+}
+
+void FindTailCalls(const ExprList& exprs, std::vector<const Expr*>* out) {
+  for (const Expr& expr : exprs) {
+    switch (expr.type()) {
+      case ExprType::ReturnCall:
+      case ExprType::ReturnCallIndirect:
+        out->push_back(&expr);
+        break;
+
+      case ExprType::Block:
+        FindTailCalls(cast<BlockExpr>(&expr)->block.exprs, out);
+        break;
+
+      case ExprType::Loop:
+        FindTailCalls(cast<LoopExpr>(&expr)->block.exprs, out);
+        break;
+
+      case ExprType::If: {
+        const IfExpr* if_ = cast<IfExpr>(&expr);
+        FindTailCalls(if_->true_.exprs, out);
+        FindTailCalls(if_->false_, out);
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+}
+
+// Adds the functions that |exprs| calls directly or takes a reference to.
+void CollectFuncRefs(const Module& module,
+                     const ExprList& exprs,
+                     std::vector<const Func*>* funcs) {
+  for (const Expr& expr : exprs) {
+    switch (expr.type()) {
+      case ExprType::Call:
+        funcs->push_back(module.GetFunc(cast<CallExpr>(&expr)->var));
+        break;
+
+      case ExprType::ReturnCall:
+        funcs->push_back(module.GetFunc(cast<ReturnCallExpr>(&expr)->var));
+        break;
+
+      case ExprType::RefFunc:
+        funcs->push_back(module.GetFunc(cast<RefFuncExpr>(&expr)->var));
+        break;
+
+      case ExprType::Block:
+        CollectFuncRefs(module, cast<BlockExpr>(&expr)->block.exprs, funcs);
+        break;
+
+      case ExprType::Loop:
+        CollectFuncRefs(module, cast<LoopExpr>(&expr)->block.exprs, funcs);
+        break;
+
+      case ExprType::If: {
+        const IfExpr* if_ = cast<IfExpr>(&expr);
+        CollectFuncRefs(module, if_->true_.exprs, funcs);
+        CollectFuncRefs(module, if_->false_, funcs);
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+}
+
+// The offset in the binary of the last instruction of |exprs|, nested ones
+// included, or 0 if there are none.
+size_t LastExprOffset(const ExprList& exprs) {
+  if (exprs.empty())
+    return 0;
+  const Expr& expr = exprs.back();
+  size_t nested = 0;
+  switch (expr.type()) {
+    case ExprType::Block:
+      nested = LastExprOffset(cast<BlockExpr>(&expr)->block.exprs);
+      break;
+
+    case ExprType::Loop:
+      nested = LastExprOffset(cast<LoopExpr>(&expr)->block.exprs);
+      break;
+
+    case ExprType::If: {
+      const IfExpr* if_ = cast<IfExpr>(&expr);
+      nested = if_->false_.empty() ? LastExprOffset(if_->true_.exprs)
+                                   : LastExprOffset(if_->false_);
+      break;
+    }
+
+    default:
+      break;
+  }
+  return std::max(nested, expr.loc.offset);
+}
+
+bool IsSimdOpcode(Opcode opcode) {
+  return opcode.HasPrefix() && opcode.GetPrefix() == 0xfd;
+}
+
+bool UsesSimd(const ExprList& exprs) {
+  for (const Expr& expr : exprs) {
+    switch (expr.type()) {
+      case ExprType::Const:
+        if (cast<ConstExpr>(&expr)->const_.type() == Type::V128)
+          return true;
+        break;
+
+      case ExprType::Load:
+        if (IsSimdOpcode(cast<LoadExpr>(&expr)->opcode))
+          return true;
+        break;
+
+      case ExprType::Store:
+        if (IsSimdOpcode(cast<StoreExpr>(&expr)->opcode))
+          return true;
+        break;
+
+      case ExprType::Binary:
+        if (IsSimdOpcode(cast<BinaryExpr>(&expr)->opcode))
+          return true;
+        break;
+
+      case ExprType::Compare:
+        if (IsSimdOpcode(cast<CompareExpr>(&expr)->opcode))
+          return true;
+        break;
+
+      case ExprType::Convert:
+        if (IsSimdOpcode(cast<ConvertExpr>(&expr)->opcode))
+          return true;
+        break;
+
+      case ExprType::Unary:
+        if (IsSimdOpcode(cast<UnaryExpr>(&expr)->opcode))
+          return true;
+        break;
+
+      case ExprType::Ternary:
+      case ExprType::SimdLaneOp:
+      case ExprType::SimdLoadLane:
+      case ExprType::SimdStoreLane:
+      case ExprType::SimdShuffleOp:
+      case ExprType::LoadSplat:
+      case ExprType::LoadZero:
+        return true;
+
+      case ExprType::Block:
+        if (UsesSimd(cast<BlockExpr>(&expr)->block.exprs))
+          return true;
+        break;
+
+      case ExprType::Loop:
+        if (UsesSimd(cast<LoopExpr>(&expr)->block.exprs))
+          return true;
+        break;
+
+      case ExprType::If: {
+        const IfExpr* if_ = cast<IfExpr>(&expr);
+        if (UsesSimd(if_->true_.exprs) || UsesSimd(if_->false_))
+          return true;
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+  return false;
+}
+
+// "i8x16.add" -> "i8x16_add"
+std::string MangleOpcodeName(Opcode opcode) {
+  std::string result = opcode.GetName();
+  std::replace(result.begin(), result.end(), '.', '_');
+  return result;
+}
+
 class CWriter {
  public:
-  CWriter(Stream* c_stream,
+  CWriter(const std::vector<Stream*>& c_streams,
           Stream* h_stream,
+          Stream* h_impl_stream,
           const char* header_name,
-          const WriteCOptions& options)
+          const char* header_impl_name,
+          const WriteCOptions& options,
+          WriteCStats* stats)
       : options_(options),
-        c_stream_(c_stream),
+        stats_(stats),
+        c_streams_(c_streams),
         h_stream_(h_stream),
-        header_name_(header_name) {}
+        h_impl_stream_(h_impl_stream),
+        header_name_(header_name),
+        header_impl_name_(header_impl_name ? header_impl_name : "") {}
 
   Result WriteModule(const Module&);
 
@@ -141,8 +671,14 @@ class CWriter {
   void UseStream(Stream*);
 
   void WriteCHeader();
+  void WriteCImplHeader();
   void WriteCSource();
 
+  bool IsMultiOutput() const;
+  void UseOutputShard(Index);
+  std::vector<std::string> StableFuncKeys() const;
+  std::vector<Index> PartitionFuncs() const;
+
   size_t MarkTypeStack() const;
   void ResetTypeStack(size_t mark);
   Type StackType(Index) const;
@@ -150,6 +686,23 @@ class CWriter {
   void PushTypes(const TypeVector&);
   void DropTypes(size_t count);
 
+  bool IsFolded(Index) const;
+  bool CanFoldExpr(Index num_operands) const;
+  template <typename... Args>
+  FoldedExpr& WriteFoldedExpr(Type result_type,
+                              Index num_operands,
+                              Args&&... args);
+  void MaterializeFoldedExpr(Index);
+  void FlushFoldedExprs(Index keep = 0);
+  void InvalidateFoldedExprs(const std::string& read, Index keep);
+  void InvalidateFoldedGlobalReads(Index keep);
+
+  void SetAddressBase(AddressBase);
+  bool NeedsBoundsCheck(Index addr_index, Address offset, Address size);
+  void InvalidateCheckedRanges(const std::string& local);
+  void PushCheckedRanges();
+  void PopCheckedRanges();
+
   void PushLabel(LabelType,
                  const std::string& name,
                  const FuncSignature&,
@@ -190,6 +743,20 @@ class CWriter {
     Write(std::forward<Args>(args)...);
   }
 
+  template <typename... Args>
+  std::string WriteToString(Args&&... args) {
+    MemoryStream mem_stream;
+    Stream* prev_stream = stream_;
+    bool prev_should_write_indent_next = should_write_indent_next_;
+    stream_ = &mem_stream;
+    should_write_indent_next_ = false;
+    Write(std::forward<Args>(args)...);
+    stream_ = prev_stream;
+    should_write_indent_next_ = prev_should_write_indent_next;
+    const std::vector<uint8_t>& data = mem_stream.output_buffer().data;
+    return std::string(data.begin(), data.end());
+  }
+
   std::string GetGlobalName(const std::string&) const;
 
   void Write() {}
@@ -210,44 +777,81 @@ class CWriter {
   void Write(const LabelDecl&);
   void Write(const GlobalVar&);
   void Write(const StackVar&);
+  void Write(const StackValue&);
   void Write(const ResultType&);
   void Write(const Const&);
   void WriteInitExpr(const ExprList&);
-  std::string GenerateHeaderGuard() const;
+  std::string GenerateHeaderGuard(const std::string& header_name) const;
+  bool ModuleUsesSimd() const;
+  bool ModuleUsesAtomics() const;
+  bool ModuleUsesDataSegments() const;
+  void FindDeadFuncs();
+  bool IsDeadFunc(const Func&) const;
+  void CollectTailCalls();
+  bool HasTailCalls(const Func&) const;
+  bool CanUseMusttail(const Func& caller, const FuncSignature& callee_sig) const;
+  std::string TailCallBodyName(const Func&);
+  std::string TailCallTargetName(const Func&);
+  std::string InternalLinkage() const;
+  std::string FuncTypeId(Index type_index) const;
   void WriteSourceTop();
+  void WriteShardTop();
   void WriteMultivalueTypes();
   void WriteSandboxStruct();
   void WriteFuncTypes();
   void WriteImports();
   bool IsFuncStatic(std::string name);
+  static const char* ShadowFuncClass(const std::string& name);
+  bool IsShadowCheckFunc(const Func&) const;
   std::string GetFuncStaticOrExport(std::string);
   void WriteFuncDeclarations(bool for_header);
   void WriteFuncDeclaration(const FuncDeclaration&, const std::string&, bool add_storage_class);
   void WriteEntryFuncs();
   void WriteEntryFunc(const FuncDeclaration&, const std::string&, bool add_storage_class);
   void WriteImportFuncDeclaration(const FuncDeclaration&, const std::string&);
-  std::string GetMainMemoryName();
+  const Memory* GetMainMemory();
+  std::string MemoryPtr(const Memory*);
+  std::string MemoryField(const Memory*, const char* field);
   void WriteGlobalInitializers();
   void WriteGlobals();
-  void WriteGlobalsExport();
+  void CollectGlobalsExport(std::vector<ExportLookupEntry>*);
   void WriteGlobal(const Global&, const std::string&);
   void WriteMemories();
-  void WriteMemoriesExport();
+  void CollectMemoriesExport(std::vector<ExportLookupEntry>*);
   void WriteMemory(const std::string&);
   void WriteTables();
-  void WriteTablesExport();
+  void CollectTablesExport(std::vector<ExportLookupEntry>*);
   void WriteTable(const std::string&);
   void WriteDataInitializers();
+  void WriteDataSegmentString(const std::vector<uint8_t>& data);
+  void WriteDataSegmentsInit();
   void WriteElemInitializers();
+  void CollectFuncsExport(std::vector<ExportLookupEntry>*);
   void WriteExportLookup();
   void WriteCallbackAddRemove();
+  bool IsInstrumented() const;
+  void WriteProfileFuncs();
+  void ClassifyProfiledFuncs();
+  void FindFixedMemorySize();
+  const WriteCProfile::Func* GetFuncProfile(const Func&) const;
+  const char* FuncProfileAttribute(const Func&) const;
+  void WriteBranchCondition();
   void WriteInit();
   void WriteFuncs();
+  void WriteTailCallWrapper(const Func&, const std::string& name);
+  void WriteTailCallExit();
+  void WriteTailCallThunks();
+  void WriteTailCallResult(const TypeVector& result_types);
   void Write(const Func&);
   void WriteParamsAndLocals();
   void WriteParams(const std::vector<std::string>& index_to_name);
   void WriteLocals(const std::vector<std::string>& index_to_name);
   void WriteStackVarDeclarations();
+  void WriteMemoryCacheDeclarations();
+  void WriteMemoryCacheRefresh();
+  void WriteGlobalCacheDeclarations();
+  void WriteGlobalCacheRefresh();
+  void WriteMemoryAccessArgs(bool check = true);
   void Write(const ExprList&);
 
   enum class AssignOp {
@@ -261,6 +865,16 @@ class CWriter {
                             AssignOp = AssignOp::Allowed);
   void WritePrefixBinaryExpr(Opcode, const char* op);
   void WriteSignedBinaryExpr(Opcode, const char* op);
+  void WriteShiftExpr(Opcode, const char* op);
+  void WriteSimdExpr(Opcode);
+  void WriteLoad(const char* func,
+                 Type result_type,
+                 Address offset,
+                 bool check = true);
+  void WriteMemoryOp(const std::string& func,
+                     Index num_operands,
+                     Type result_type,
+                     Address offset);
   void Write(const BinaryExpr&);
   void Write(const CompareExpr&);
   void Write(const ConvertExpr&);
@@ -274,16 +888,59 @@ class CWriter {
   void Write(const SimdShuffleOpExpr&);
   void Write(const LoadSplatExpr&);
   void Write(const LoadZeroExpr&);
+  void Write(const AtomicLoadExpr&);
+  void Write(const AtomicStoreExpr&);
+  void Write(const AtomicRmwExpr&);
+  void Write(const AtomicRmwCmpxchgExpr&);
+  void Write(const AtomicWaitExpr&);
+  void Write(const AtomicNotifyExpr&);
+  void Write(const ReturnCallExpr&);
+  void Write(const ReturnCallIndirectExpr&);
 
   const WriteCOptions& options_;
+  WriteCStats* stats_ = nullptr;
   const Module* module_ = nullptr;
   const Func* func_ = nullptr;
   Stream* stream_ = nullptr;
   MemoryStream func_stream_;
+  std::vector<Stream*> c_streams_;
   Stream* c_stream_ = nullptr;
   Stream* h_stream_ = nullptr;
+  Stream* h_impl_stream_ = nullptr;
   std::string header_name_;
+  std::string header_impl_name_;
   Result result_ = Result::Ok;
+  bool func_caches_memory_ = false;
+  // The locals holding the globals the current function reads, by global
+  // index.
+  std::map<Index, std::string> cached_globals_;
+  // The size of the linear memory when nothing can grow it, or 0.
+  uint64_t fixed_memory_size_ = 0;
+  // The defined functions left out by --remove-dead-functions.
+  std::set<const Func*> dead_funcs_;
+  // The trailing `, <class>, "<name>"` arguments passed to memory accessors
+  // from the current function, used by the shadow memory checker.
+  std::string shadow_func_args_;
+  // Functions containing return_call or return_call_indirect, the direct
+  // targets of those calls, and the type indices of the indirect ones.
+  std::set<const Func*> tail_calling_funcs_;
+  std::set<const Func*> tail_call_targets_;
+  std::set<Index> tail_call_indirect_types_;
+  Index tail_call_arg_slots_ = 0;
+  Index tail_call_result_slots_ = 0;
+  // With a profile, the functions that take most of the time and the ones
+  // that were never called.
+  std::set<const Func*> hot_funcs_;
+  std::set<const Func*> cold_funcs_;
+  // The counts of the current function in the profile, if any, the index of
+  // the current function among the defined ones, and the number of its ifs
+  // and br_ifs written so far.
+  const WriteCProfile::Func* func_profile_ = nullptr;
+  Index func_profile_index_ = 0;
+  Index func_branch_count_ = 0;
+  // The defined function of every if and br_if, in the order they are
+  // written, for --instrument=branches.
+  std::vector<Index> branch_funcs_;
   int indent_ = 0;
   bool should_write_indent_next_ = false;
 
@@ -294,6 +951,11 @@ class CWriter {
   SymbolSet local_syms_;
   SymbolSet import_syms_;
   TypeVector type_stack_;
+  std::vector<FoldedExpr> folded_exprs_;
+  std::vector<AddressBase> address_bases_;
+  CheckedRanges checked_ranges_;
+  std::vector<CheckedRanges> saved_checked_ranges_;
+  FoldedExpr* fold_target_ = nullptr;
   std::vector<Label> label_stack_;
 };
 
@@ -314,6 +976,8 @@ size_t CWriter::MarkTypeStack() const {
 void CWriter::ResetTypeStack(size_t mark) {
   assert(mark <= type_stack_.size());
   type_stack_.erase(type_stack_.begin() + mark, type_stack_.end());
+  folded_exprs_.resize(mark);
+  address_bases_.resize(mark);
 }
 
 Type CWriter::StackType(Index index) const {
@@ -323,15 +987,156 @@ Type CWriter::StackType(Index index) const {
 
 void CWriter::PushType(Type type) {
   type_stack_.push_back(type);
+  folded_exprs_.emplace_back();
+  address_bases_.emplace_back();
 }
 
 void CWriter::PushTypes(const TypeVector& types) {
   type_stack_.insert(type_stack_.end(), types.begin(), types.end());
+  folded_exprs_.resize(type_stack_.size());
+  address_bases_.resize(type_stack_.size());
 }
 
 void CWriter::DropTypes(size_t count) {
   assert(count <= type_stack_.size());
   type_stack_.erase(type_stack_.end() - count, type_stack_.end());
+  folded_exprs_.resize(type_stack_.size());
+  address_bases_.resize(type_stack_.size());
+}
+
+bool CWriter::IsFolded(Index index) const {
+  assert(index < folded_exprs_.size());
+  return !(folded_exprs_.rbegin() + index)->text.empty();
+}
+
+bool CWriter::CanFoldExpr(Index num_operands) const {
+  if (!options_.fold_exprs)
+    return false;
+
+  // The result takes the slot of the deepest operand, so that is the only
+  // operand that may already live in its stack variable, or be folded from
+  // an expression that reads it. The stack variables of the slots above it
+  // are assigned again by the next values pushed there.
+  int depth = 0;
+  for (Index i = 0; i < num_operands; ++i) {
+    const FoldedExpr& folded = *(folded_exprs_.rbegin() + i);
+    bool deepest = i + 1 == num_operands;
+    if (folded.text.empty()) {
+      if (!deepest)
+        return false;
+    } else {
+      if (folded.reads_stack_var && !deepest)
+        return false;
+      depth = std::max(depth, folded.depth);
+    }
+  }
+  return depth < kMaxFoldedExprDepth;
+}
+
+template <typename... Args>
+FoldedExpr& CWriter::WriteFoldedExpr(Type result_type,
+                                     Index num_operands,
+                                     Args&&... args) {
+  FoldedExpr folded;
+  if (num_operands > 0) {
+    const FoldedExpr& deepest = *(folded_exprs_.rbegin() + (num_operands - 1));
+    folded.reads_stack_var = deepest.text.empty() || deepest.reads_stack_var;
+  }
+  fold_target_ = &folded;
+  std::string text = WriteToString(std::forward<Args>(args)...);
+  fold_target_ = nullptr;
+  DropTypes(num_operands);
+  PushType(result_type);
+  folded.text = std::move(text);
+  folded.depth++;
+  folded_exprs_.back() = std::move(folded);
+  return folded_exprs_.back();
+}
+
+void CWriter::MaterializeFoldedExpr(Index index) {
+  if (IsFolded(index))
+    Write(StackVar(index), " = ", StackValue(index), ";", Newline());
+}
+
+void CWriter::FlushFoldedExprs(Index keep) {
+  for (Index i = type_stack_.size(); i > keep; --i)
+    MaterializeFoldedExpr(i - 1);
+}
+
+void CWriter::InvalidateFoldedExprs(const std::string& read, Index keep) {
+  for (Index i = type_stack_.size(); i > keep; --i) {
+    const FoldedExpr& folded = *(folded_exprs_.rbegin() + (i - 1));
+    if (folded.reads.count(read))
+      MaterializeFoldedExpr(i - 1);
+  }
+}
+
+void CWriter::InvalidateFoldedGlobalReads(Index keep) {
+  for (Index i = type_stack_.size(); i > keep; --i) {
+    const FoldedExpr& folded = *(folded_exprs_.rbegin() + (i - 1));
+    for (const std::string& read : folded.reads) {
+      if (read.compare(0, 5, "sbx->") == 0) {
+        MaterializeFoldedExpr(i - 1);
+        break;
+      }
+    }
+  }
+}
+
+void CWriter::SetAddressBase(AddressBase base) {
+  address_bases_.back() = std::move(base);
+}
+
+// Returns false if an access of |size| bytes at the address in stack slot
+// |addr_index| plus |offset| is known to be in bounds. Otherwise the access
+// will be checked, and later accesses may rely on it having passed.
+bool CWriter::NeedsBoundsCheck(Index addr_index,
+                               Address offset,
+                               Address size) {
+  const AddressBase& base = *(address_bases_.rbegin() + addr_index);
+  if (base.is_const) {
+    uint64_t end = base.value + offset + size;
+    if (end <= checked_ranges_.const_end)
+      return false;
+    checked_ranges_.const_end = end;
+    return true;
+  }
+  if (base.local.empty())
+    return true;
+
+  uint64_t end = uint64_t(offset) + size;
+  auto iter = checked_ranges_.local_ends.find(base.local);
+  if (iter == checked_ranges_.local_ends.end()) {
+    checked_ranges_.local_ends.emplace(base.local, end);
+    return true;
+  }
+  if (end <= iter->second)
+    return false;
+  iter->second = end;
+  return true;
+}
+
+// Forgets the checks of |local|, in the enclosing blocks too, since it is
+// about to be assigned.
+void CWriter::InvalidateCheckedRanges(const std::string& local) {
+  checked_ranges_.local_ends.erase(local);
+  for (CheckedRanges& ranges : saved_checked_ranges_)
+    ranges.local_ends.erase(local);
+  for (AddressBase& base : address_bases_) {
+    if (base.local == local)
+      base = AddressBase();
+  }
+}
+
+// The checks made inside a block don't hold after it, since a branch may have
+// skipped them.
+void CWriter::PushCheckedRanges() {
+  saved_checked_ranges_.push_back(checked_ranges_);
+}
+
+void CWriter::PopCheckedRanges() {
+  checked_ranges_ = std::move(saved_checked_ranges_.back());
+  saved_checked_ranges_.pop_back();
 }
 
 void CWriter::PushLabel(LabelType label_type,
@@ -390,6 +1195,7 @@ char CWriter::MangleType(Type type) {
     case Type::I64: return 'j';
     case Type::F32: return 'f';
     case Type::F64: return 'd';
+    case Type::V128: return 'o';
     default: WABT_UNREACHABLE;
   }
 }
@@ -667,12 +1473,33 @@ void CWriter::Write(const StackVar& sv) {
   }
 }
 
+void CWriter::Write(const StackValue& sv) {
+  // The instruction consuming the value will put its own result in the slot.
+  *(address_bases_.rbegin() + sv.index) = AddressBase();
+  if (!IsFolded(sv.index)) {
+    Write(StackVar(sv.index));
+    return;
+  }
+
+  FoldedExpr folded;
+  std::swap(folded, *(folded_exprs_.rbegin() + sv.index));
+  if (fold_target_) {
+    fold_target_->reads.insert(folded.reads.begin(), folded.reads.end());
+    fold_target_->depth = std::max(fold_target_->depth, folded.depth);
+  }
+  if (sv.parenthesize && !IsSimpleExpr(folded.text))
+    Write("(", folded.text, ")");
+  else
+    Write(folded.text);
+}
+
 void CWriter::Write(Type type) {
   switch (type) {
     case Type::I32: Write("u32"); break;
     case Type::I64: Write("u64"); break;
     case Type::F32: Write("f32"); break;
     case Type::F64: Write("f64"); break;
+    case Type::V128: Write("v128"); break;
     default:
       WABT_UNREACHABLE;
   }
@@ -684,6 +1511,7 @@ void CWriter::Write(TypeEnum type) {
     case Type::I64: Write("WASM_RT_I64"); break;
     case Type::F32: Write("WASM_RT_F32"); break;
     case Type::F64: Write("WASM_RT_F64"); break;
+    case Type::V128: Write("WASM_RT_V128"); break;
     default:
       WABT_UNREACHABLE;
   }
@@ -765,6 +1593,13 @@ void CWriter::Write(const Const& const_) {
       break;
     }
 
+    case Type::V128: {
+      v128 value = const_.vec128();
+      Writef("simd_v128_const(0x%016" PRIx64 "ull, 0x%016" PRIx64 "ull)",
+             value.u64(0), value.u64(1));
+      break;
+    }
+
     default:
       WABT_UNREACHABLE;
   }
@@ -790,23 +1625,255 @@ void CWriter::WriteInitExpr(const ExprList& expr_list) {
   }
 }
 
-std::string CWriter::GenerateHeaderGuard() const {
+std::string CWriter::GenerateHeaderGuard(const std::string& header_name) const {
   std::string result;
-  for (char c : header_name_) {
+  for (char c : header_name) {
     if (isalnum(c) || c == '_') {
       result += toupper(c);
     } else {
       result += '_';
     }
   }
-  result += "_GENERATED_";
-  return result;
+  result += "_GENERATED_";
+  return result;
+}
+
+bool CWriter::ModuleUsesSimd() const {
+  for (const TypeEntry* type : module_->types) {
+    if (const FuncType* func_type = dyn_cast<FuncType>(type)) {
+      for (Type param_type : func_type->sig.param_types) {
+        if (param_type == Type::V128)
+          return true;
+      }
+      for (Type result_type : func_type->sig.result_types) {
+        if (result_type == Type::V128)
+          return true;
+      }
+    }
+  }
+  for (const Global* global : module_->globals) {
+    if (global->type == Type::V128)
+      return true;
+  }
+  for (const Func* func : module_->funcs) {
+    for (Type local_type : func->local_types) {
+      if (local_type == Type::V128)
+        return true;
+    }
+    if (UsesSimd(func->exprs))
+      return true;
+  }
+  return false;
+}
+
+bool CWriter::ModuleUsesAtomics() const {
+  for (const Func* func : module_->funcs) {
+    if (UsesAtomics(func->exprs))
+      return true;
+  }
+  return false;
+}
+
+// Marks the functions that no export, start function, element segment or
+// global initializer leads to, through calls and ref.func, as dead. Their size
+// is the span of their instructions in the binary.
+void CWriter::FindDeadFuncs() {
+  if (!options_.remove_dead_funcs)
+    return;
+
+  std::vector<const Func*> work;
+  for (const Export* export_ : module_->exports) {
+    if (export_->kind == ExternalKind::Func)
+      work.push_back(module_->GetFunc(export_->var));
+  }
+  for (const Var* var : module_->starts)
+    work.push_back(module_->GetFunc(*var));
+  for (const ElemSegment* elem_segment : module_->elem_segments) {
+    for (const ElemExpr& elem_expr : elem_segment->elem_exprs) {
+      if (elem_expr.kind == ElemExprKind::RefFunc)
+        work.push_back(module_->GetFunc(elem_expr.var));
+    }
+  }
+  for (const Global* global : module_->globals)
+    CollectFuncRefs(*module_, global->init_expr, &work);
+
+  std::set<const Func*> live;
+  while (!work.empty()) {
+    const Func* func = work.back();
+    work.pop_back();
+    if (live.insert(func).second)
+      CollectFuncRefs(*module_, func->exprs, &work);
+  }
+
+  size_t removed_bytes = 0;
+  for (Index i = module_->num_func_imports; i < module_->funcs.size(); ++i) {
+    const Func* func = module_->funcs[i];
+    if (live.count(func))
+      continue;
+    dead_funcs_.insert(func);
+    if (func->exprs.empty())
+      continue;
+    // Bodies are laid out in order, so a function ends where the next one
+    // with instructions starts.
+    size_t start = func->exprs.front().loc.offset;
+    size_t end = LastExprOffset(func->exprs) + 1;
+    for (Index j = i + 1; j < module_->funcs.size(); ++j) {
+      if (!module_->funcs[j]->exprs.empty()) {
+        end = module_->funcs[j]->exprs.front().loc.offset;
+        break;
+      }
+    }
+    removed_bytes += end - start;
+  }
+
+  if (stats_) {
+    stats_->removed_funcs = dead_funcs_.size();
+    stats_->removed_code_bytes = removed_bytes;
+  }
+}
+
+bool CWriter::IsDeadFunc(const Func& func) const {
+  return dead_funcs_.count(&func) != 0;
+}
+
+void CWriter::CollectTailCalls() {
+  for (const Func* func : module_->funcs) {
+    if (IsDeadFunc(*func))
+      continue;
+    std::vector<const Expr*> tail_calls;
+    FindTailCalls(func->exprs, &tail_calls);
+    if (tail_calls.empty())
+      continue;
+
+    tail_calling_funcs_.insert(func);
+    tail_call_result_slots_ =
+        std::max(tail_call_result_slots_, func->GetNumResults());
+    for (const Expr* expr : tail_calls) {
+      if (auto* call = dyn_cast<ReturnCallExpr>(expr)) {
+        const Func* target = module_->GetFunc(call->var);
+        tail_call_targets_.insert(target);
+        tail_call_arg_slots_ =
+            std::max(tail_call_arg_slots_, target->GetNumParams());
+      } else {
+        const FuncDeclaration& decl = cast<ReturnCallIndirectExpr>(expr)->decl;
+        tail_call_indirect_types_.insert(
+            module_->GetFuncTypeIndex(decl.type_var));
+        // The table index takes the slot after the arguments.
+        tail_call_arg_slots_ =
+            std::max(tail_call_arg_slots_, decl.GetNumParams() + 1);
+      }
+    }
+  }
+}
+
+bool CWriter::HasTailCalls(const Func& func) const {
+  return tail_calling_funcs_.count(&func) != 0;
+}
+
+// musttail needs the caller and callee to have the same C signature. Imported
+// functions take a void* instead of the sandbox, so they never qualify.
+bool CWriter::CanUseMusttail(const Func& caller,
+                             const FuncSignature& callee_sig) const {
+  // A musttail call would skip the end of the caller's timing.
+  if (options_.instrument_cycles)
+    return false;
+  return caller.decl.sig == callee_sig;
+}
+
+// A function that makes tail calls is written as a "_tail_body" function,
+// which may return with a tail call pending in the sandbox, and a wrapper of
+// the usual name that runs the pending calls.
+std::string CWriter::TailCallBodyName(const Func& func) {
+  std::string name = GetGlobalName(func.name);
+  if (name == "w2c_dlmalloc" || name == "w2c_dlfree")
+    name += "_wrapped";
+  return name + "_tail_body";
+}
+
+// Tail calls go straight to the body of functions that have one, so that a
+// chain of tail calls never nests wrappers.
+std::string CWriter::TailCallTargetName(const Func& func) {
+  if (HasTailCalls(func))
+    return TailCallBodyName(func);
+  return GetGlobalName(func.name);
+}
+
+std::string CWriter::InternalLinkage() const {
+  return IsMultiOutput() ? "FUNC_INTERNAL " : "static ";
+}
+
+// Computes the index of a function type the way wasm_rt_register_func_type
+// does for signatures that fit in WASM_RT_INLINE_FUNC_TYPE_BIT's encoding.
+static bool GetInlineFuncTypeId(const FuncSignature& sig, uint32_t* id) {
+  const Index kMaxParams = 7;
+  const Index kMaxResults = 3;
+  const Index kMaxTypes = 8;
+  Index num_params = sig.GetNumParams();
+  Index num_results = sig.GetNumResults();
+  if (num_params > kMaxParams || num_results > kMaxResults ||
+      num_params + num_results > kMaxTypes) {
+    return false;
+  }
+  uint32_t result = 0x80000000u | (num_params << 28) | (num_results << 26);
+  Index shift = 0;
+  for (const TypeVector* types : {&sig.param_types, &sig.result_types}) {
+    for (Type type : *types) {
+      uint32_t value;
+      switch (type) {
+        case Type::I32: value = 0; break;
+        case Type::I64: value = 1; break;
+        case Type::F32: value = 2; break;
+        case Type::F64: value = 3; break;
+        case Type::V128: value = 4; break;
+        default:
+          WABT_UNREACHABLE;
+      }
+      result |= value << shift;
+      shift += 3;
+    }
+  }
+  *id = result;
+  return true;
+}
+
+// The expression for the index of a function type: a constant if it has an
+// inline index, or else the index registered when the sandbox was created.
+std::string CWriter::FuncTypeId(Index type_index) const {
+  const FuncType* func_type = cast<FuncType>(module_->types[type_index]);
+  uint32_t id;
+  if (GetInlineFuncTypeId(func_type->sig, &id)) {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "0x%08xu", id);
+    return buffer;
+  }
+  return "sbx->func_types[" + std::to_string(type_index) + "]";
+}
+
+bool CWriter::ModuleUsesDataSegments() const {
+  for (const Func* func : module_->funcs) {
+    if (UsesDataSegments(func->exprs))
+      return true;
+  }
+  return false;
 }
 
 void CWriter::WriteSourceTop() {
   Write(s_source_includes);
   Write(Newline(), "#include \"", header_name_, "\"", Newline());
+  if (!module_->memories.empty() && module_->memories[0]->page_limits.is_shared)
+    Write("#define WASM_RT_SHARED_MEMORY 1", Newline());
   Write(s_source_declarations);
+  if (ModuleUsesSimd())
+    Write(s_source_simd);
+  if (ModuleUsesAtomics())
+    Write(s_source_atomics);
+  if (!tail_calling_funcs_.empty())
+    Write(s_source_tailcall);
+}
+
+void CWriter::WriteShardTop() {
+  Write("/* Automically generated by wasm2c */", Newline());
+  Write("#include \"", header_impl_name_, "\"", Newline());
 }
 
 void CWriter::WriteMultivalueTypes() {
@@ -839,65 +1906,132 @@ void CWriter::WriteSandboxStruct() {
   Write("wasm_sandbox_wasi_data wasi_data;", Newline());
 
   WriteMemories();
-  WriteTables();
+  // With a profile, the most used globals come right after the memory, which
+  // every load and store reads, so that they share its cache line. The tables
+  // are named first all the same.
+  bool globals_first = !options_.profile.funcs.empty();
+  if (globals_first) {
+    Stream* stream = stream_;
+    MemoryStream tables_stream;
+    stream_ = &tables_stream;
+    WriteTables();
+    stream_ = stream;
+    WriteGlobals();
+    std::unique_ptr<OutputBuffer> buf = tables_stream.ReleaseOutputBuffer();
+    stream_->WriteData(buf->data.data(), buf->data.size());
+  } else {
+    WriteTables();
+  }
 
   {
-    Write("wasm_func_type_t* func_type_structs;");
+    Writef("u32 func_types[%" PRIzd "];", module_->types.size());
     Write(Newline());
-    Write("u32 func_type_count;");
+  }
+
+  if (!tail_calling_funcs_.empty()) {
+    Write("void (*tail_call_next)(wasm2c_sandbox_t* const);", Newline());
+    Write("u8 tail_call_args[", std::max<Index>(tail_call_arg_slots_, 1),
+          " * TAIL_CALL_SLOT_SIZE];", Newline());
+    Write("u8 tail_call_results[", std::max<Index>(tail_call_result_slots_, 1),
+          " * TAIL_CALL_SLOT_SIZE];", Newline());
+  }
+
+  if (ModuleUsesDataSegments()) {
+    // Dropped segments (including the active ones, once applied) have size 0.
+    Writef("const u8* data_segments[%" PRIzd "];", module_->data_segments.size());
     Write(Newline());
-    Writef("u32 func_types[%" PRIzd "];", module_->types.size());
+    Writef("u32 data_segment_sizes[%" PRIzd "];", module_->data_segments.size());
     Write(Newline());
   }
 
-  WriteGlobals();
+  if (IsInstrumented()) {
+    Write("wasm_rt_profile_t profile;", Newline());
+  }
+
+  if (!globals_first)
+    WriteGlobals();
 
   Dedent(2);
   Write("};", Newline(), Newline());
 }
 
 void CWriter::WriteFuncTypes() {
-  Write(Newline());
-  Write("static void init_func_types(wasm2c_sandbox_t* const sbx) ", OpenBrace());
-  Index func_type_index = 0;
+  // Types with an inline index need no registration. Of the others, those with
+  // the same signature are given the same canonical index here, so that the
+  // signatures can be written out as static data and registered once per
+  // process; creating a sandbox then only copies the registered indices.
+  std::vector<const FuncType*> canonical_types;
+  std::vector<Index> canonical_index;
   for (TypeEntry* type : module_->types) {
-    FuncType* func_type = cast<FuncType>(type);
-    Index num_params = func_type->GetNumParams();
-    Index num_results = func_type->GetNumResults();
-    Write(OpenBrace());
-    Write("wasm_rt_type_t param_ret_types[] = { ");
-    bool first = true;
-    if (num_results == 0 && num_params == 0) {
-      // Make sure array has at least one element
-      Write("/* void(*)(void) */ WASM_RT_I32 ");
-    } else {
-      for (Index i = 0; i < num_params; ++i) {
-        if (!first) {
-          Write(", ");
-        }
-        Write(TypeEnum(func_type->GetParamType(i)));
+    const FuncType* func_type = cast<FuncType>(type);
+    uint32_t id;
+    if (GetInlineFuncTypeId(func_type->sig, &id)) {
+      canonical_index.push_back(kInvalidIndex);
+      continue;
+    }
+    Index index = 0;
+    while (index < canonical_types.size() &&
+           !(canonical_types[index]->sig == func_type->sig)) {
+      ++index;
+    }
+    if (index == canonical_types.size()) {
+      canonical_types.push_back(func_type);
+    }
+    canonical_index.push_back(index);
+  }
+
+  Write(Newline());
+  if (!canonical_types.empty()) {
+    // Types without an inline index have too many params or results for the
+    // encoding, so none of them has an empty signature.
+    Write("static const wasm_rt_type_t func_type_sig_types[] = {", Newline());
+    Indent(2);
+    for (const FuncType* func_type : canonical_types) {
+      bool first = true;
+      for (Type type : func_type->sig.param_types) {
+        Write(first ? "" : " ", TypeEnum(type), ",");
         first = false;
       }
-      for (Index i = 0; i < num_results; ++i) {
-        if (!first) {
-          Write(", ");
-        }
-        Write(TypeEnum(func_type->GetResultType(i)));
+      for (Type type : func_type->sig.result_types) {
+        Write(first ? "" : " ", TypeEnum(type), ",");
         first = false;
       }
+      Write(Newline());
     }
-    Write(" };", Newline());
-    Write("sbx->func_types[", func_type_index, "] = wasm_rt_register_func_type(&sbx->func_type_structs, &sbx->func_type_count, ",
-          num_params, ", ", num_results, ", param_ret_types");
-    Write(");", Newline());
-    Write(CloseBrace(), Newline());
-    ++func_type_index;
+    Dedent(2);
+    Write("};", Newline(), Newline());
+
+    Write("static const wasm_rt_func_sig_t func_type_sigs[", canonical_types.size(),
+          "] = {", Newline());
+    Indent(2);
+    Index offset = 0;
+    for (const FuncType* func_type : canonical_types) {
+      Index num_params = func_type->GetNumParams();
+      Index num_results = func_type->GetNumResults();
+      Write("{ ", num_params, ", ", num_results, ", func_type_sig_types + ",
+            offset, " },", Newline());
+      offset += num_params + num_results;
+    }
+    Dedent(2);
+    Write("};", Newline(), Newline());
+
+    Write("static u32 func_type_ids[", canonical_types.size(), "];",
+          Newline(), Newline());
   }
-  Write(CloseBrace(), Newline());
 
-  Write("static void cleanup_func_types(wasm2c_sandbox_t* const sbx) ", OpenBrace());
-  {
-    Write("wasm_rt_cleanup_func_types(&sbx->func_type_structs, &sbx->func_type_count);", Newline());
+  Write("static void init_func_types(wasm2c_sandbox_t* const sbx) ", OpenBrace());
+  if (!canonical_types.empty()) {
+    Write("wasm_rt_register_func_types(func_type_sigs, ",
+          canonical_types.size(), ", func_type_ids);", Newline());
+  }
+  for (Index i = 0; i < canonical_index.size(); ++i) {
+    Write("sbx->func_types[", i, "] = ");
+    if (canonical_index[i] == kInvalidIndex) {
+      Write(FuncTypeId(i));
+    } else {
+      Write("func_type_ids[", canonical_index[i], "]");
+    }
+    Write(";", Newline());
   }
   Write(CloseBrace(), Newline());
 }
@@ -966,6 +2100,10 @@ void CWriter::WriteFuncDeclarations(bool for_header) {
 
   Index func_index = 0;
   for (const Func* func : module_->funcs) {
+    if (IsDeadFunc(*func)) {
+      ++func_index;
+      continue;
+    }
     std::string global_func_name;
     if (for_header) {
       global_func_name = DefineGlobalScopeName(func->name);
@@ -978,8 +2116,24 @@ void CWriter::WriteFuncDeclarations(bool for_header) {
       WriteFuncDeclaration(func->decl, global_func_name, true /* add_storage_class */);
       Write(";", Newline());
     }
+    if (!for_header && HasTailCalls(*func)) {
+      Write(InternalLinkage());
+      WriteFuncDeclaration(func->decl, TailCallBodyName(*func), false /* add_storage_class */);
+      Write(";", Newline());
+    }
     ++func_index;
   }
+
+  if (!for_header) {
+    for (const Func* func : tail_call_targets_) {
+      Write(InternalLinkage(), "void tail_call_", GetGlobalName(func->name),
+            "(wasm2c_sandbox_t* const);", Newline());
+    }
+    for (Index type_index : tail_call_indirect_types_) {
+      Write(InternalLinkage(), "void tail_call_indirect_", type_index,
+            "(wasm2c_sandbox_t* const);", Newline());
+    }
+  }
 }
 
 
@@ -993,7 +2147,7 @@ void CWriter::WriteEntryFuncs() {
   Index func_index = 0;
   for (const Func* func : module_->funcs) {
     bool is_import = func_index < module_->num_func_imports;
-    if (!is_import) {
+    if (!is_import && !IsDeadFunc(*func)) {
       WriteEntryFunc(func->decl, GetGlobalName(func->name), true /* add_storage_class */);
       Write(Newline());
     }
@@ -1010,8 +2164,12 @@ bool CWriter::IsFuncStatic(std::string name) {
 }
 
 std::string CWriter::GetFuncStaticOrExport(std::string name) {
-  std::string static_export_string = IsFuncStatic(name)? "static " : "FUNC_EXPORT ";
-  return static_export_string;
+  if (!IsFuncStatic(name)) {
+    return "FUNC_EXPORT ";
+  }
+  // Functions may be called from other shards, so they can't be static when
+  // the output is split across several files.
+  return IsMultiOutput() ? "FUNC_INTERNAL " : "static ";
 }
 
 void CWriter::WriteFuncDeclaration(const FuncDeclaration& decl,
@@ -1071,50 +2229,76 @@ void CWriter::WriteImportFuncDeclaration(const FuncDeclaration& decl,
   Write(")");
 }
 
+// With a profile, the globals are written in the order of how often they are
+// used, estimated from the static uses in each function times its calls. They
+// are still named in the order of the module, so names don't depend on the
+// profile.
 void CWriter::WriteGlobals() {
-  Index global_index = 0;
-  if (module_->globals.size() != module_->num_global_imports) {
+  // The index and name of every defined global.
+  std::vector<std::pair<Index, std::string>> globals;
+  for (Index i = module_->num_global_imports; i < module_->globals.size();
+       ++i) {
+    globals.emplace_back(i, DefineGlobalScopeName(module_->globals[i]->name));
+  }
 
-    for (const Global* global : module_->globals) {
-      bool is_import = global_index < module_->num_global_imports;
-      if (!is_import) {
-        WriteGlobal(*global, DefineGlobalScopeName(global->name));
-        Write(";", Newline());
-      }
-      ++global_index;
+  if (!options_.profile.funcs.empty()) {
+    std::vector<uint64_t> uses(module_->globals.size());
+    for (Index i = module_->num_func_imports; i < module_->funcs.size(); ++i) {
+      const Func* func = module_->funcs[i];
+      const WriteCProfile::Func* profile = GetFuncProfile(*func);
+      if (profile && profile->calls)
+        CountGlobalUses(*module_, func->exprs, profile->calls, &uses);
     }
+    std::stable_sort(globals.begin(), globals.end(),
+                     [&](const std::pair<Index, std::string>& a,
+                         const std::pair<Index, std::string>& b) {
+                       return uses[a.first] > uses[b.first];
+                     });
+  }
+
+  for (const auto& pair : globals) {
+    WriteGlobal(*module_->globals[pair.first], pair.second);
+    Write(";", Newline());
   }
 }
 
-void CWriter::WriteGlobalsExport() {
+void CWriter::CollectGlobalsExport(std::vector<ExportLookupEntry>* entries) {
   Index global_index = 0;
-  if (module_->globals.size() != module_->num_global_imports) {
-
-    for (const Global* global : module_->globals) {
-      bool is_import = global_index < module_->num_global_imports;
-      if (!is_import) {
-        std::string curr_global_name = GetGlobalName(global->name);
-        Writef("if (strcmp(\"%s\", name) == 0)", curr_global_name.c_str());
-        Write(OpenBrace());
-        Write("return &(sbx->", curr_global_name, ");", Newline());
-        Write(CloseBrace(), Newline());
-      }
-      ++global_index;
+  for (const Global* global : module_->globals) {
+    bool is_import = global_index++ < module_->num_global_imports;
+    if (!is_import) {
+      std::string name = GetGlobalName(global->name);
+      entries->push_back(
+          {name, "0, 0, offsetof(wasm2c_sandbox_t, " + name + "), 0"});
     }
   }
 }
 
-std::string CWriter::GetMainMemoryName() {
+const Memory* CWriter::GetMainMemory() {
   assert (!(module_->memories.size() == module_->num_memory_imports));
   assert(module_->memories.size() <= 1);
 
-  std::string ret = GetGlobalName(module_->memories[0]->name);
-  return ret;
+  return module_->memories[0];
+}
+
+// A shared memory is held through a pointer, so that the sandboxes created by
+// create_wasm2c_sandbox_thread can all use the memory of their parent.
+std::string CWriter::MemoryPtr(const Memory* memory) {
+  std::string name = GetGlobalName(memory->name);
+  if (memory->page_limits.is_shared)
+    return "sbx->" + name;
+  return "&(sbx->" + name + ")";
+}
+
+std::string CWriter::MemoryField(const Memory* memory, const char* field) {
+  std::string name = GetGlobalName(memory->name);
+  return "sbx->" + name + (memory->page_limits.is_shared ? "->" : ".") + field;
 }
 
 void CWriter::WriteGlobalInitializers() {
 
   Write(Newline(), "static void init_globals(wasm2c_sandbox_t* const sbx) ", OpenBrace());
+  Write("(void)sbx;", Newline());
 
   {
     Index global_index = 0;
@@ -1132,15 +2316,15 @@ void CWriter::WriteGlobalInitializers() {
 
   {
     Index global_index = 0;
-    std::string memory_name = GetMainMemoryName();
+    std::string memory_ptr = MemoryPtr(GetMainMemory());
     for (const Global* global : module_->globals) {
       bool is_import = global_index < module_->num_global_imports;
       if (!is_import) {
         std::string global_name = GetGlobalName(global->name);
         std::string global_name_expr = "sbx->" + global_name;
-        Write("WASM2C_SHADOW_MEMORY_RESERVE(&(sbx->", memory_name ,"), ", global_name_expr,  ", sizeof(", global_name_expr, "));", Newline());
+        Write("WASM2C_SHADOW_MEMORY_RESERVE(", memory_ptr ,", ", global_name_expr,  ", sizeof(", global_name_expr, "));", Newline());
         if (global_name == "w2c___heap_base") {
-          Write("WASM2C_SHADOW_MEMORY_MARK_GLOBALS_HEAP_BOUNDARY(&(sbx->", memory_name, "), ", global_name_expr, ");", Newline());
+          Write("WASM2C_SHADOW_MEMORY_MARK_GLOBALS_HEAP_BOUNDARY(", memory_ptr, ", ", global_name_expr, ");", Newline());
         }
       }
 
@@ -1164,29 +2348,30 @@ void CWriter::WriteMemories() {
   for (const Memory* memory : module_->memories) {
     bool is_import = memory_index < module_->num_memory_imports;
     if (!is_import) {
-      WriteMemory(DefineGlobalScopeName(memory->name));
+      std::string name = DefineGlobalScopeName(memory->name);
+      if (memory->page_limits.is_shared) {
+        Write("wasm_rt_memory_t* ", name, ";", Newline());
+        WriteMemory(name + "_storage");
+      } else {
+        WriteMemory(name);
+      }
       Write(Newline());
     }
     ++memory_index;
   }
 }
 
-void CWriter::WriteMemoriesExport() {
-  if (module_->memories.size() == module_->num_memory_imports)
-    return;
-
-  assert(module_->memories.size() <= 1);
+void CWriter::CollectMemoriesExport(std::vector<ExportLookupEntry>* entries) {
   Index memory_index = 0;
   for (const Memory* memory : module_->memories) {
-    bool is_import = memory_index < module_->num_memory_imports;
+    bool is_import = memory_index++ < module_->num_memory_imports;
     if (!is_import) {
-      std::string curr_memory_name = GetGlobalName(memory->name);
-      Writef("if (strcmp(\"%s\", name) == 0)", curr_memory_name.c_str());
-      Write(OpenBrace());
-      Write("return &(sbx->", curr_memory_name, ");", Newline());
-      Write(CloseBrace(), Newline());
+      // A shared memory is held through a pointer in the sandbox.
+      std::string name = GetGlobalName(memory->name);
+      entries->push_back({name, "0, 0, offsetof(wasm2c_sandbox_t, " + name +
+                                    "), " +
+                                    (memory->page_limits.is_shared ? "1" : "0")});
     }
-    ++memory_index;
   }
 }
 
@@ -1213,22 +2398,15 @@ void CWriter::WriteTables() {
   }
 }
 
-void CWriter::WriteTablesExport() {
-  if (module_->tables.size() == module_->num_table_imports)
-    return;
-
-  assert(module_->tables.size() <= 1);
+void CWriter::CollectTablesExport(std::vector<ExportLookupEntry>* entries) {
   Index table_index = 0;
   for (const Table* table : module_->tables) {
-    bool is_import = table_index < module_->num_table_imports;
+    bool is_import = table_index++ < module_->num_table_imports;
     if (!is_import) {
-      std::string curr_table_name = GetGlobalName(table->name);
-      Writef("if (strcmp(\"%s\", name) == 0)", curr_table_name.c_str());
-      Write(OpenBrace());
-      Write("return &(sbx->", curr_table_name, ");", Newline());
-      Write(CloseBrace(), Newline());
+      std::string name = GetGlobalName(table->name);
+      entries->push_back(
+          {name, "0, 0, offsetof(wasm2c_sandbox_t, " + name + "), 0"});
     }
-    ++table_index;
   }
 }
 
@@ -1236,6 +2414,35 @@ void CWriter::WriteTable(const std::string& name) {
   Write("wasm_rt_table_t ", name, ";");
 }
 
+// Writes |data| as a sequence of string literals, one per line. Printable
+// characters are written as they are, and everything else as a three digit
+// octal escape, which can't run into the characters that follow it.
+void CWriter::WriteDataSegmentString(const std::vector<uint8_t>& data) {
+  const size_t kMaxLineLength = 120;
+  std::string line;
+  line.reserve(kMaxLineLength + 8);
+  for (uint8_t x : data) {
+    if (line.empty())
+      line += '"';
+    if (x >= 0x20 && x < 0x7f && x != '"' && x != '\\' && x != '?') {
+      line += static_cast<char>(x);
+    } else {
+      char escape[5];
+      snprintf(escape, sizeof(escape), "\\%03o", x);
+      line += escape;
+    }
+    if (line.size() >= kMaxLineLength) {
+      line += '"';
+      Write(line, Newline());
+      line.clear();
+    }
+  }
+  if (!line.empty()) {
+    line += '"';
+    Write(line, Newline());
+  }
+}
+
 void CWriter::WriteDataInitializers() {
   const Memory* memory = nullptr;
   Index data_segment_index = 0;
@@ -1245,10 +2452,23 @@ void CWriter::WriteDataInitializers() {
       Write(Newline());
     } else {
       for (const DataSegment* data_segment : module_->data_segments) {
+        const std::vector<uint8_t>& data = data_segment->data;
+        if (options_.string_data_segments && !data.empty()) {
+          // The array is given its exact size, so the string's terminating
+          // NUL is dropped.
+          Write(Newline(), "static const u8 ",
+                data.size() >= kDataSegmentAlignThreshold ? "DATA_SEGMENT_ALIGN " : "",
+                "data_segment_data_", data_segment_index, "[", data.size(),
+                "] =", Newline());
+          WriteDataSegmentString(data);
+          Write(";", Newline());
+          ++data_segment_index;
+          continue;
+        }
         Write(Newline(), "static const u8 data_segment_data_",
               data_segment_index, "[] = ", OpenBrace());
         size_t i = 0;
-        for (uint8_t x : data_segment->data) {
+        for (uint8_t x : data) {
           Writef("0x%02x, ", x);
           if ((++i % 12) == 0)
             Write(Newline());
@@ -1263,32 +2483,83 @@ void CWriter::WriteDataInitializers() {
     memory = module_->memories[0];
   }
 
+  bool is_shared = memory && memory->page_limits.is_shared;
   Write(Newline(), "static bool init_memory(wasm2c_sandbox_t* const sbx, uint32_t max_wasm_pages_from_rt) ", OpenBrace());
   if (memory && module_->num_memory_imports == 0) {
     Write("const uint32_t max_pages_specified_in_module = ", memory->page_limits.has_max ? memory->page_limits.max : 0, ";", Newline());
     Write("const uint32_t max_pages = max_wasm_pages_from_rt == 0? max_pages_specified_in_module : max_wasm_pages_from_rt;", Newline());
-    Write("const bool success = wasm_rt_allocate_memory(&(sbx->", ExternalRef(memory->name), "), ",
-          memory->page_limits.initial, ", max_pages);", Newline());
-    Write("if (!success) { return false; }", Newline(), Newline());
+    if (is_shared) {
+      Write("sbx->", ExternalRef(memory->name), " = &(sbx->", ExternalRef(memory->name), "_storage);", Newline());
+      Write("const bool success = wasm_rt_allocate_shared_memory(", MemoryPtr(memory), ", ",
+            memory->page_limits.initial, ", max_pages);", Newline());
+    } else {
+      Write("const bool success = wasm_rt_allocate_memory(&(sbx->", ExternalRef(memory->name), "), ",
+            memory->page_limits.initial, ", max_pages);", Newline());
+    }
+    Write("if (!success) { return false; }", Newline());
+    Write("WASM2C_SHADOW_MEMORY_INIT_SAMPLE_RATE(", MemoryPtr(memory), ");", Newline(), Newline());
   }
+  std::string memory_ref = is_shared ? "(*sbx->" + GetGlobalName(memory->name) + ")"
+                                     : "sbx->" + GetGlobalName(memory->name);
   data_segment_index = 0;
   for (const DataSegment* data_segment : module_->data_segments) {
-    Write("LOAD_DATA(sbx->", ExternalRef(memory->name), ", ");
-    WriteInitExpr(data_segment->offset);
-    Write(", data_segment_data_", data_segment_index, ", ",
-          data_segment->data.size(), ");", Newline());
+    if (data_segment->kind == SegmentKind::Active) {
+      Write("LOAD_DATA(", memory_ref, ", ");
+      WriteInitExpr(data_segment->offset);
+      Write(", data_segment_data_", data_segment_index, ", ",
+            data_segment->data.size(), ");", Newline());
+    }
     ++data_segment_index;
   }
+  WriteDataSegmentsInit();
 
-  Write("sbx->wasi_data.heap_memory = &(sbx->", ExternalRef(memory->name), ");", Newline());
+  Write("sbx->wasi_data.heap_memory = ", MemoryPtr(memory), ";", Newline());
   Write("return true;", Newline());
   Write(CloseBrace(), Newline());
 
+  // A thread sandbox uses the memory of its parent as it is: the data
+  // segments were already applied when the parent was created.
+  Write(Newline(), "static bool init_thread_memory(wasm2c_sandbox_t* const sbx, wasm2c_sandbox_t* const parent) ", OpenBrace());
+  Write("(void)sbx;", Newline());
+  Write("(void)parent;", Newline());
+  if (is_shared) {
+    Write("sbx->", ExternalRef(memory->name), " = parent->", ExternalRef(memory->name), ";", Newline());
+    WriteDataSegmentsInit();
+    Write("sbx->wasi_data.heap_memory = ", MemoryPtr(memory), ";", Newline());
+    Write("return true;", Newline());
+  } else {
+    Write("return false;", Newline());
+  }
+  Write(CloseBrace(), Newline());
+
   Write(Newline(), "static void cleanup_memory(wasm2c_sandbox_t* const sbx) ", OpenBrace());
-  Write("wasm_rt_deallocate_memory(&(sbx->", ExternalRef(memory->name), "));", Newline());
+  if (is_shared) {
+    Write("if (sbx->", ExternalRef(memory->name), " == &(sbx->", ExternalRef(memory->name), "_storage)) ", OpenBrace());
+    Write("wasm_rt_deallocate_memory(", MemoryPtr(memory), ");", Newline());
+    Write(CloseBrace(), Newline());
+  } else {
+    Write("wasm_rt_deallocate_memory(&(sbx->", ExternalRef(memory->name), "));", Newline());
+  }
   Write(CloseBrace(), Newline());
 }
 
+// Each sandbox starts with all of its passive segments available to
+// memory.init.
+void CWriter::WriteDataSegmentsInit() {
+  if (!ModuleUsesDataSegments())
+    return;
+
+  Index data_segment_index = 0;
+  for (const DataSegment* data_segment : module_->data_segments) {
+    Write("sbx->data_segments[", data_segment_index, "] = data_segment_data_",
+          data_segment_index, ";", Newline());
+    Write("sbx->data_segment_sizes[", data_segment_index, "] = ",
+          data_segment->kind == SegmentKind::Passive ? data_segment->data.size() : 0,
+          ";", Newline());
+    ++data_segment_index;
+  }
+}
+
 void CWriter::WriteElemInitializers() {
   const Table* table = module_->tables.empty() ? nullptr : module_->tables[0];
 
@@ -1316,8 +2587,8 @@ void CWriter::WriteElemInitializers() {
       Index func_type_index = module_->GetFuncTypeIndex(func->decl.type_var);
 
       Write("sbx->",ExternalRef(table->name), ".data[offset + ", i,
-            "] = (wasm_rt_elem_t){ WASM_RT_INTERNAL_FUNCTION, sbx->func_types[", func_type_index,
-            "], (wasm_rt_anyfunc_t)", ExternalPtr(func->name), " };", Newline());
+            "] = (wasm_rt_elem_t){ WASM_RT_INTERNAL_FUNCTION, ", FuncTypeId(func_type_index),
+            ", (wasm_rt_anyfunc_t)", ExternalPtr(func->name), " };", Newline());
       if (i >= first_unused_elem) {
         first_unused_elem = i+1;
       }
@@ -1335,16 +2606,198 @@ void CWriter::WriteElemInitializers() {
   Write(CloseBrace(), Newline());
 }
 
+// The functions that are not static, so the ones an embedder could also find
+// with dlsym.
+void CWriter::CollectFuncsExport(std::vector<ExportLookupEntry>* entries) {
+  Index func_index = 0;
+  for (const Func* func : module_->funcs) {
+    bool is_import = func_index++ < module_->num_func_imports;
+    if (is_import || IsDeadFunc(*func))
+      continue;
+    std::string name = GetGlobalName(func->name);
+    if (!IsFuncStatic(name)) {
+      Index type_index = module_->GetFuncTypeIndex(func->decl);
+      entries->push_back({name, "(wasm_rt_anyfunc_t)&" + name + ", " +
+                                    std::to_string(type_index) + ", 0, 0"});
+    }
+  }
+}
+
+// Seeded FNV-1a, followed by the murmur3 finalizer so that the low bits depend
+// on the whole seed. The generated hash_wasm2c_export_name must match it.
+static uint32_t HashExportName(const std::string& name, uint32_t seed) {
+  uint32_t hash = (2166136261u ^ seed) * 16777619u;
+  for (unsigned char c : name) {
+    hash = (hash ^ c) * 16777619u;
+  }
+  hash = (hash ^ (hash >> 16)) * 0x85ebca6bu;
+  hash = (hash ^ (hash >> 13)) * 0xc2b2ae35u;
+  return hash ^ (hash >> 16);
+}
+
+// Builds a perfect hash of |names| with hash-and-displace: the names are put
+// into buckets by their hash with seed 0, and then each bucket, largest first,
+// is given the first seed that hashes all of its names into free slots. The
+// result maps each slot to an index into |names|, or kInvalidIndex.
+static void BuildExportPerfectHash(const std::vector<std::string>& names,
+                                   std::vector<uint32_t>* bucket_seeds,
+                                   std::vector<Index>* slots) {
+  const uint32_t kMaxSeed = 1 << 16;
+  Index num_buckets = std::max<Index>(1, names.size() / 2);
+  Index num_slots = std::max<Index>(1, names.size());
+  std::vector<std::vector<Index>> buckets(num_buckets);
+  for (Index i = 0; i < names.size(); ++i) {
+    buckets[HashExportName(names[i], 0) % num_buckets].push_back(i);
+  }
+  std::vector<Index> order(num_buckets);
+  for (Index i = 0; i < num_buckets; ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&](Index a, Index b) {
+    return buckets[a].size() > buckets[b].size();
+  });
+
+  // Having as many slots as names almost always works; if it doesn't, retry
+  // with a few more.
+  for (;; num_slots += num_slots / 16 + 1) {
+    bucket_seeds->assign(num_buckets, 0);
+    slots->assign(num_slots, kInvalidIndex);
+    bool placed_all = true;
+    for (Index bucket : order) {
+      if (buckets[bucket].empty()) {
+        break;
+      }
+      std::vector<Index> bucket_slots;
+      uint32_t seed = 1;
+      for (; seed < kMaxSeed; ++seed) {
+        bucket_slots.clear();
+        for (Index name_index : buckets[bucket]) {
+          Index slot = HashExportName(names[name_index], seed) % num_slots;
+          if ((*slots)[slot] != kInvalidIndex ||
+              std::find(bucket_slots.begin(), bucket_slots.end(), slot) !=
+                  bucket_slots.end()) {
+            break;
+          }
+          bucket_slots.push_back(slot);
+        }
+        if (bucket_slots.size() == buckets[bucket].size()) {
+          break;
+        }
+      }
+      if (seed == kMaxSeed) {
+        placed_all = false;
+        break;
+      }
+      (*bucket_seeds)[bucket] = seed;
+      for (Index i = 0; i < bucket_slots.size(); ++i) {
+        (*slots)[bucket_slots[i]] = buckets[bucket][i];
+      }
+    }
+    if (placed_all) {
+      return;
+    }
+  }
+}
+
 void CWriter::WriteExportLookup() {
-  Write(Newline(), "static void* lookup_wasm2c_nonfunc_export(void* sbx_ptr, const char* name) ", OpenBrace());
-  Write("wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) sbx_ptr;", Newline());
+  std::vector<ExportLookupEntry> entries;
+  CollectMemoriesExport(&entries);
+  CollectTablesExport(&entries);
+  CollectGlobalsExport(&entries);
+  CollectFuncsExport(&entries);
+
+  std::vector<std::string> names;
+  for (const ExportLookupEntry& entry : entries) {
+    names.push_back(entry.name);
+  }
+  std::vector<uint32_t> bucket_seeds;
+  std::vector<Index> slots;
+  BuildExportPerfectHash(names, &bucket_seeds, &slots);
+
+  Write(Newline(), "typedef struct {", Newline());
+  Indent(2);
+  Write("const char* name;", Newline());
+  Write("/* The function, with the index of its type, or 0 for other exports. */",
+        Newline());
+  Write("wasm_rt_anyfunc_t func;", Newline());
+  Write("u32 func_type;", Newline());
+  Write("/* The offset of other exports in the sandbox. */", Newline());
+  Write("u32 offset;", Newline());
+  Write("/* Whether the sandbox holds a pointer to the export instead. */",
+        Newline());
+  Write("u32 is_pointer;", Newline());
+  Dedent(2);
+  Write("} wasm2c_export_t;", Newline(), Newline());
+
+  Write("static const u32 wasm2c_export_seeds[", bucket_seeds.size(), "] = {",
+        Newline());
+  Indent(2);
+  for (Index i = 0; i < bucket_seeds.size(); ++i) {
+    Write(bucket_seeds[i], ",");
+    if (i % 16 == 15 || i + 1 == bucket_seeds.size()) {
+      Write(Newline());
+    } else {
+      Write(" ");
+    }
+  }
+  Dedent(2);
+  Write("};", Newline(), Newline());
 
-  WriteMemoriesExport();
-  WriteTablesExport();
-  WriteGlobalsExport();
+  Write("static const wasm2c_export_t wasm2c_exports[", slots.size(), "] = {",
+        Newline());
+  Indent(2);
+  for (Index slot : slots) {
+    if (slot == kInvalidIndex) {
+      Write("{ 0, 0, 0, 0, 0 },", Newline());
+    } else {
+      Write("{ \"", entries[slot].name, "\", ", entries[slot].value, " },",
+            Newline());
+    }
+  }
+  Dedent(2);
+  Write("};", Newline(), Newline());
+
+  Write("static u32 hash_wasm2c_export_name(const char* name, u32 seed) ",
+        OpenBrace());
+  Write("u32 hash = (2166136261u ^ seed) * 16777619u;", Newline());
+  Write("for (; *name; name++) ", OpenBrace());
+  Write("hash = (hash ^ (u8)*name) * 16777619u;", Newline());
+  Write(CloseBrace(), Newline());
+  Write("hash = (hash ^ (hash >> 16)) * 0x85ebca6bu;", Newline());
+  Write("hash = (hash ^ (hash >> 13)) * 0xc2b2ae35u;", Newline());
+  Write("return hash ^ (hash >> 16);", Newline());
+  Write(CloseBrace(), Newline(), Newline());
+
+  Write("static const wasm2c_export_t* find_wasm2c_export(const char* name) ",
+        OpenBrace());
+  Write("u32 seed = wasm2c_export_seeds[hash_wasm2c_export_name(name, 0) % ",
+        bucket_seeds.size(), "];", Newline());
+  Write("const wasm2c_export_t* entry = &wasm2c_exports[hash_wasm2c_export_name(name, seed) % ",
+        slots.size(), "];", Newline());
+  Write("return entry->name && strcmp(entry->name, name) == 0 ? entry : 0;",
+        Newline());
+  Write(CloseBrace(), Newline());
+
+  Write(Newline(), "static void* lookup_wasm2c_nonfunc_export(void* sbx_ptr, const char* name) ", OpenBrace());
+  Write("const wasm2c_export_t* entry = find_wasm2c_export(name);", Newline());
+  Write("if (!entry || entry->func) ", OpenBrace());
+  Write("return 0;", Newline());
+  Write(CloseBrace(), Newline());
+  Write("void* field = (char*) sbx_ptr + entry->offset;", Newline());
+  Write("return entry->is_pointer ? *(void**) field : field;", Newline());
+  Write(CloseBrace(), Newline());
 
+  Write(Newline(), "static wasm_rt_anyfunc_t lookup_wasm2c_func_export(void* sbx_ptr, const char* name, u32* func_type) ", OpenBrace());
+  Write("wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) sbx_ptr;", Newline());
+  Write("const wasm2c_export_t* entry = find_wasm2c_export(name);", Newline());
+  Write("if (!entry || !entry->func) ", OpenBrace());
   Write("return 0;", Newline());
   Write(CloseBrace(), Newline());
+  Write("if (func_type) ", OpenBrace());
+  Write("*func_type = sbx->func_types[entry->func_type];", Newline());
+  Write(CloseBrace(), Newline());
+  Write("return entry->func;", Newline());
+  Write(CloseBrace(), Newline());
 }
 
 void CWriter::WriteCallbackAddRemove() {
@@ -1354,26 +2807,357 @@ void CWriter::WriteCallbackAddRemove() {
   Write("wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) sbx_ptr;", Newline());
   Write("return &(sbx->", ExternalRef(table->name), ");", Newline());
   Write(CloseBrace(), Newline());
+
+  const Memory* memory = module_->memories.empty() ? nullptr : module_->memories[0];
+  Write(Newline(), "static wasm_rt_memory_t* get_wasm2c_memory(wasm2c_sandbox_t* const sbx)", OpenBrace());
+  Write("return ", memory ? MemoryPtr(memory) : "0", ";", Newline());
+  Write(CloseBrace(), Newline());
+}
+
+bool CWriter::IsInstrumented() const {
+  return options_.instrument_calls || options_.instrument_cycles ||
+         options_.instrument_branches;
+}
+
+// The profile is named after the functions of the module, without the "$" of
+// the text format, so that stacks read the same as in the source.
+void CWriter::WriteProfileFuncs() {
+  Index num_funcs = module_->funcs.size() - module_->num_func_imports;
+  if (IsInstrumented()) {
+    Write(Newline(), "static const char* const profile_func_names[",
+          std::max<Index>(num_funcs, 1), "] = ", OpenBrace());
+    for (Index i = module_->num_func_imports; i < module_->funcs.size(); ++i) {
+      string_view name = ProfileName(*module_->funcs[i]);
+      std::string literal = "\"";
+      for (char c : name) {
+        if (c >= 0x20 && c < 0x7f && c != '"' && c != '\\' && c != '?') {
+          literal += c;
+        } else {
+          literal += StringPrintf("\\%03o", static_cast<uint8_t>(c));
+        }
+      }
+      Write(literal, "\",", Newline());
+    }
+    Write(CloseBrace(), ";", Newline());
+  }
+  if (options_.instrument_branches) {
+    Write(Newline(), "static const u32 profile_branch_funcs[",
+          std::max<size_t>(branch_funcs_.size(), 1), "] = ", OpenBrace());
+    std::string line;
+    for (size_t i = 0; i < branch_funcs_.size(); ++i) {
+      line += std::to_string(branch_funcs_[i]) + ", ";
+      if (i % 16 == 15 || i + 1 == branch_funcs_.size()) {
+        line.pop_back();
+        Write(line, Newline());
+        line.clear();
+      }
+    }
+    Write(CloseBrace(), ";", Newline());
+  }
+
+  Write(Newline(), "static void init_profile(wasm2c_sandbox_t* const sbx) ",
+        OpenBrace());
+  Write("(void)sbx;", Newline());
+  if (IsInstrumented()) {
+    // Timing counts the calls as well, so the counters are only needed
+    // without it.
+    bool count_calls =
+        options_.instrument_calls && !options_.instrument_cycles;
+    Write("wasm_rt_profile_init(&sbx->profile, ", num_funcs,
+          ", profile_func_names, ", count_calls ? "true" : "false", ", ",
+          options_.instrument_cycles ? "true" : "false", ", ",
+          static_cast<Index>(branch_funcs_.size()), ", ",
+          options_.instrument_branches ? "profile_branch_funcs" : "NULL",
+          ");", Newline());
+  }
+  Write(CloseBrace(), Newline());
+
+  Write(Newline(), "static void cleanup_profile(wasm2c_sandbox_t* const sbx) ",
+        OpenBrace());
+  Write("(void)sbx;", Newline());
+  if (IsInstrumented()) {
+    Write("wasm_rt_profile_cleanup(&sbx->profile);", Newline());
+  }
+  Write(CloseBrace(), Newline());
+
+  Write(Newline(),
+        "static wasm_rt_profile_t* get_wasm2c_profile(wasm2c_sandbox_t* const "
+        "sbx) ",
+        OpenBrace());
+  Write("(void)sbx;", Newline());
+  Write("return ", IsInstrumented() ? "&sbx->profile" : "0", ";", Newline());
+  Write(CloseBrace(), Newline());
+}
+
+const WriteCProfile::Func* CWriter::GetFuncProfile(const Func& func) const {
+  auto iter = options_.profile.funcs.find(ProfileName(func).to_string());
+  return iter == options_.profile.funcs.end() ? nullptr : &iter->second;
+}
+
+// A memory that is defined by the module, not exported and never grown keeps
+// its initial size, so bounds checks can compare against a constant.
+void CWriter::FindFixedMemorySize() {
+  fixed_memory_size_ = 0;
+  if (module_->memories.size() != 1 || module_->num_memory_imports != 0)
+    return;
+
+  const Memory* memory = module_->memories[0];
+  if (memory->page_limits.is_shared || memory->page_limits.is_64)
+    return;
+  for (const Export* export_ : module_->exports) {
+    if (export_->kind == ExternalKind::Memory)
+      return;
+  }
+  for (const Func* func : module_->funcs) {
+    if (UsesMemoryGrow(func->exprs))
+      return;
+  }
+  fixed_memory_size_ = memory->page_limits.initial * WABT_PAGE_SIZE;
+}
+
+// The functions that take 90% of the self time in the profile, or of the calls
+// if the profile wasn't timed, are hot. The ones it never saw called are cold.
+// A profile lists every function of the module it was taken from, so when most
+// functions are missing it is for another module, and nothing is classified.
+void CWriter::ClassifyProfiledFuncs() {
+  if (options_.profile.funcs.empty())
+    return;
+
+  bool timed = false;
+  uint64_t total_calls = 0;
+  for (const auto& pair : options_.profile.funcs) {
+    timed |= pair.second.self_ticks != 0;
+    total_calls += pair.second.calls;
+  }
+  // A profile of branches only says nothing about the functions.
+  if (total_calls == 0)
+    return;
+
+  Index num_defined = module_->funcs.size() - module_->num_func_imports;
+  Index num_missing = 0;
+  for (Index i = module_->num_func_imports; i < module_->funcs.size(); ++i) {
+    if (!GetFuncProfile(*module_->funcs[i]))
+      ++num_missing;
+  }
+  if (num_missing > num_defined / 2) {
+    if (stats_)
+      stats_->unprofiled_funcs = num_missing;
+    return;
+  }
+
+  std::vector<std::pair<uint64_t, const Func*>> weights;
+  uint64_t total_weight = 0;
+  for (Index i = module_->num_func_imports; i < module_->funcs.size(); ++i) {
+    const Func* func = module_->funcs[i];
+    const WriteCProfile::Func* profile = GetFuncProfile(*func);
+    if (!profile || profile->calls == 0) {
+      cold_funcs_.insert(func);
+      continue;
+    }
+    uint64_t weight = timed ? profile->self_ticks : profile->calls;
+    weights.emplace_back(weight, func);
+    total_weight += weight;
+  }
+  std::stable_sort(weights.begin(), weights.end(),
+                   [](const std::pair<uint64_t, const Func*>& a,
+                      const std::pair<uint64_t, const Func*>& b) {
+                     return a.first > b.first;
+                   });
+  uint64_t hot_weight = 0;
+  for (const auto& pair : weights) {
+    if (pair.first == 0 || hot_weight >= total_weight / 10 * 9)
+      break;
+    hot_funcs_.insert(pair.second);
+    hot_weight += pair.first;
+  }
+}
+
+const char* CWriter::FuncProfileAttribute(const Func& func) const {
+  if (hot_funcs_.count(&func))
+    return "FUNC_HOT ";
+  if (cold_funcs_.count(&func))
+    return "FUNC_COLD ";
+  return "";
+}
+
+// Writes the condition of an if or br_if, from the top of the stack. The
+// branches of a function are numbered in the order they are written, with or
+// without --instrument, so the counts of an instrumented build line up with
+// the branches of a build that uses them. Branches that were seen at least
+// 100 times, and went the same way at least 9 times in 10, are hinted.
+void CWriter::WriteBranchCondition() {
+  Index index = func_branch_count_++;
+  const char* hint = nullptr;
+  if (func_profile_ && index < func_profile_->branches.size()) {
+    uint64_t not_taken = func_profile_->branches[index].first;
+    uint64_t taken = func_profile_->branches[index].second;
+    uint64_t count = not_taken + taken;
+    if (count >= 100) {
+      if (taken >= count / 10 * 9) {
+        hint = "LIKELY";
+      } else if (not_taken >= count / 10 * 9) {
+        hint = "UNLIKELY";
+      }
+    }
+  }
+  if (hint)
+    Write(hint, "(");
+  if (options_.instrument_branches) {
+    Write("PROFILE_BRANCH(sbx, ", static_cast<Index>(branch_funcs_.size()),
+          ", ");
+    branch_funcs_.push_back(func_profile_index_);
+  }
+  Write(StackValue(0));
+  if (options_.instrument_branches)
+    Write(")");
+  if (hint)
+    Write(")");
 }
 
 void CWriter::WriteInit() {
-  Write(Newline(), "static void init_module_starts(void) ", OpenBrace());
+  Write(Newline(), "static void init_module_starts(wasm2c_sandbox_t* const sbx) ", OpenBrace());
+  Write("(void)sbx;", Newline());
   for (Var* var : module_->starts) {
-    Write(ExternalRef(module_->GetFunc(*var)->name), "();", Newline());
+    Write(ExternalRef(module_->GetFunc(*var)->name), "(sbx);", Newline());
+  }
+  Write(CloseBrace(), Newline());
+
+  Write(s_source_sandboxapis);
+}
+
+bool CWriter::IsMultiOutput() const {
+  return c_streams_.size() > 1;
+}
+
+void CWriter::UseOutputShard(Index shard) {
+  assert(shard < c_streams_.size());
+  c_stream_ = c_streams_[shard];
+  stream_ = c_stream_;
+}
+
+// Returns a key for each defined function that doesn't change when functions
+// are added or removed elsewhere in the module: the name of its first export,
+// or else its debug name. Functions with neither are named after their index
+// by GenerateNames, so their keys still shift when a function is inserted
+// before them.
+std::vector<std::string> CWriter::StableFuncKeys() const {
+  std::vector<std::string> keys;
+  for (Index i = module_->num_func_imports; i < module_->funcs.size(); ++i)
+    keys.push_back(ProfileName(*module_->funcs[i]).to_string());
+  std::vector<bool> exported(keys.size());
+  for (const Export* export_ : module_->exports) {
+    if (export_->kind != ExternalKind::Func)
+      continue;
+    Index index = module_->GetFuncIndex(export_->var);
+    if (index < module_->num_func_imports)
+      continue;
+    index -= module_->num_func_imports;
+    if (!exported[index]) {
+      exported[index] = true;
+      keys[index] = "export " + export_->name;
+    }
+  }
+  return keys;
+}
+
+// Splits the defined functions into contiguous runs, one per output shard, so
+// that each shard gets roughly the same number of expressions to compile.
+// Dead functions count for nothing. With stable_shards, the functions are
+// instead spread over the shards after the first by a hash of their
+// StableFuncKeys, so that no function moves when another one changes size.
+// Returns the shard index of each defined function.
+std::vector<Index> CWriter::PartitionFuncs() const {
+  const Index num_shards = c_streams_.size();
+  if (options_.stable_shards && num_shards > 1) {
+    std::vector<Index> shards;
+    for (const std::string& key : StableFuncKeys()) {
+      uint64_t hash = HashCOutput(key);
+      shards.push_back(1 + static_cast<Index>(hash % (num_shards - 1)));
+    }
+    return shards;
+  }
+
+  std::vector<size_t> sizes;
+  size_t total_size = 0;
+  for (Index i = module_->num_func_imports; i < module_->funcs.size(); ++i) {
+    const Func* func = module_->funcs[i];
+    size_t size = IsDeadFunc(*func) ? 0 : CountExprs(func->exprs) + 1;
+    sizes.push_back(size);
+    total_size += size;
   }
-  Write(CloseBrace(), Newline());
 
-  Write(s_source_sandboxapis);
+  std::vector<Index> shards;
+  size_t size_before = 0;
+  for (size_t size : sizes) {
+    uint64_t midpoint = size_before + size / 2;
+    shards.push_back(static_cast<Index>(midpoint * num_shards /
+                                        std::max<size_t>(total_size, 1)));
+    size_before += size;
+  }
+  return shards;
 }
 
 void CWriter::WriteFuncs() {
+  std::vector<Index> shards = PartitionFuncs();
+  std::vector<std::string> keys;
+  if (stats_ && options_.stable_shards)
+    keys = StableFuncKeys();
   Index func_index = 0;
   for (const Func* func : module_->funcs) {
     bool is_import = func_index < module_->num_func_imports;
-    if (!is_import)
-      Write(Newline(), *func, Newline());
+    if (!is_import && !IsDeadFunc(*func)) {
+      UseOutputShard(shards[func_index - module_->num_func_imports]);
+      if (stats_ && options_.stable_shards) {
+        // Write the function aside first to record the hash of its code.
+        MemoryStream func_code;
+        Stream* shard_stream = c_stream_;
+        c_stream_ = stream_ = &func_code;
+        Write(Newline(), *func, Newline());
+        const std::vector<uint8_t>& data = func_code.output_buffer().data;
+        string_view code(reinterpret_cast<const char*>(data.data()),
+                         data.size());
+        stats_->func_hashes.emplace_back(
+            keys[func_index - module_->num_func_imports], HashCOutput(code));
+        c_stream_ = stream_ = shard_stream;
+        stream_->WriteData(data.data(), data.size());
+      } else {
+        Write(Newline(), *func, Newline());
+      }
+    }
     ++func_index;
   }
+  UseOutputShard(0);
+}
+
+// The shadow memory checker exempts some accesses made by the allocator and by
+// string functions that deliberately read past the end of a buffer. Classify
+// the function here so the checker doesn't have to compare names on every
+// access.
+const char* CWriter::ShadowFuncClass(const std::string& name) {
+  if (name == "w2c_dlmalloc" || name == "w2c_dlfree" || name == "w2c_sbrk") {
+    return "WASM2C_SHADOW_FUNC_MALLOC_CORE";
+  } else if (name == "w2c_calloc") {
+    return "WASM2C_SHADOW_FUNC_CALLOC";
+  } else if (name == "w2c_realloc") {
+    return "WASM2C_SHADOW_FUNC_REALLOC";
+  } else if (name == "w2c_strlen") {
+    return "WASM2C_SHADOW_FUNC_OVERREAD";
+  }
+  return "WASM2C_SHADOW_FUNC_PROGRAM";
+}
+
+bool CWriter::IsShadowCheckFunc(const Func& func) const {
+  // Accept the name with or without the leading '$' of the text format.
+  string_view name = func.name;
+  if (!name.empty() && name[0] == '$') {
+    name.remove_prefix(1);
+  }
+  for (const std::string& check_name : options_.shadow_check_funcs) {
+    if (name == check_name || func.name == check_name) {
+      return true;
+    }
+  }
+  return false;
 }
 
 void CWriter::Write(const Func& func) {
@@ -1390,23 +3174,61 @@ void CWriter::Write(const Func& func) {
   {
     func_name_suffix = "_wrapped";
   }
-
-  Write(GetFuncStaticOrExport(out_func_name), ResultType(func.decl.sig.result_types), " ",
-        out_func_name + func_name_suffix, "(");
+  std::string shadow_class = ShadowFuncClass(out_func_name);
+  if (IsShadowCheckFunc(func)) {
+    shadow_class += " | WASM2C_SHADOW_FUNC_ALWAYS_CHECK";
+  }
+  shadow_func_args_ = ", " + shadow_class + ", \"" + out_func_name + "\"";
+  func_profile_ = GetFuncProfile(func);
+  func_profile_index_ =
+      module_->func_bindings.FindIndex(func.name) - module_->num_func_imports;
+  func_branch_count_ = 0;
+
+  Write(FuncProfileAttribute(func));
+  if (HasTailCalls(func)) {
+    Write(InternalLinkage(), ResultType(func.decl.sig.result_types), " ",
+          TailCallBodyName(func), "(");
+  } else {
+    Write(GetFuncStaticOrExport(out_func_name), ResultType(func.decl.sig.result_types), " ",
+          out_func_name + func_name_suffix, "(");
+  }
   WriteParamsAndLocals();
+  // Other threads may grow a shared memory at any time, so its size can't be
+  // kept in a local.
+  func_caches_memory_ = options_.cache_memory_base && UsesMemory(func.exprs) &&
+                        !GetMainMemory()->page_limits.is_shared;
+  WriteMemoryCacheDeclarations();
+  WriteGlobalCacheDeclarations();
   Write("FUNC_PROLOGUE;", Newline());
+  if (options_.instrument_cycles) {
+    Write("u32 profile_depth = wasm_rt_profile_enter(&sbx->profile, ",
+          func_profile_index_, ");", Newline());
+  } else if (options_.instrument_calls) {
+    Write("++sbx->profile.calls[", func_profile_index_, "];", Newline());
+  }
 
   stream_ = &func_stream_;
   stream_->ClearOffset();
 
   std::string label = DefineLocalScopeName(kImplicitFuncLabel);
   ResetTypeStack(0);
+  // Memory is never smaller than its initial size.
+  checked_ranges_ = CheckedRanges();
+  if (!module_->memories.empty()) {
+    checked_ranges_.const_end =
+        module_->memories[0]->page_limits.initial * WABT_PAGE_SIZE;
+  }
   std::string empty;  // Must not be temporary, since address is taken by Label.
   PushLabel(LabelType::Func, empty, func.decl.sig);
-  Write(func.exprs, LabelDecl(label));
+  Write(func.exprs);
+  FlushFoldedExprs();
+  Write(LabelDecl(label));
   PopLabel();
   ResetTypeStack(0);
   PushTypes(func.decl.sig.result_types);
+  if (options_.instrument_cycles) {
+    Write("wasm_rt_profile_exit(&sbx->profile, profile_depth);", Newline());
+  }
   Write("FUNC_EPILOGUE;", Newline());
 
   // Return the top of the stack implicitly.
@@ -1434,27 +3256,210 @@ void CWriter::Write(const Func& func) {
 
   Write(CloseBrace());
 
-  std::string memory_name = GetMainMemoryName();
+  if (HasTailCalls(func))
+    WriteTailCallWrapper(func, out_func_name + func_name_suffix);
+
+  std::string memory_ptr = MemoryPtr(GetMainMemory());
   if (out_func_name == "w2c_dlmalloc") {
     Write(Newline(), Newline());
     Write(GetFuncStaticOrExport(out_func_name), "u32 w2c_dlmalloc(wasm2c_sandbox_t* const sbx, u32 ptr_size) ", OpenBrace());
     Write("u32 ret = w2c_dlmalloc_wrapped(sbx, ptr_size);", Newline());
-    Write("WASM2C_SHADOW_MEMORY_DLMALLOC(&(sbx->", memory_name, "), ret, ptr_size);", Newline());
+    Write("WASM2C_SHADOW_MEMORY_DLMALLOC(", memory_ptr, ", ret, ptr_size);", Newline());
     Write("WASM2C_MALLOC_FAIL_CHECK(ret, ptr_size);", Newline());
     Write("return ret;", Newline());
     Write(CloseBrace());
   } else if (out_func_name == "w2c_dlfree") {
     Write(Newline(), Newline());
     Write(GetFuncStaticOrExport(out_func_name), "void w2c_dlfree(wasm2c_sandbox_t* const sbx, u32 ptr) ", OpenBrace());
-    Write("WASM2C_SHADOW_MEMORY_DLFREE(&(sbx->", memory_name, "), ptr);", Newline());
+    Write("WASM2C_SHADOW_MEMORY_DLFREE(", memory_ptr, ", ptr);", Newline());
     Write("w2c_dlfree_wrapped(sbx, ptr);", Newline());
     Write(CloseBrace());
   }
 
   func_stream_.Clear();
+  func_caches_memory_ = false;
+  func_profile_ = nullptr;
   func_ = nullptr;
 }
 
+void CWriter::WriteTailCallWrapper(const Func& func, const std::string& name) {
+  const FuncDeclaration& decl = func.decl;
+  std::string body_call = TailCallBodyName(func) + "(sbx";
+  for (Index i = 0; i < decl.GetNumParams(); ++i)
+    body_call += ", p" + std::to_string(i);
+  body_call += ")";
+
+  Write(Newline(), Newline());
+  Write(GetFuncStaticOrExport(GetGlobalName(func.name)),
+        ResultType(decl.sig.result_types), " ", name,
+        "(wasm2c_sandbox_t* const sbx");
+  for (Index i = 0; i < decl.GetNumParams(); ++i)
+    Write(", ", decl.GetParamType(i), " p", std::to_string(i));
+  Write(") ", OpenBrace());
+
+  // The pending calls are run even if all of the body's own tail calls are
+  // musttail calls, since a function they reach may leave one pending.
+  if (decl.sig.result_types.empty()) {
+    Write(body_call, ";", Newline());
+    Write("RUN_TAIL_CALLS(sbx);", Newline());
+  } else {
+    Write(ResultType(decl.sig.result_types), " ret = ", body_call, ";", Newline());
+    Write("if (UNLIKELY(sbx->tail_call_next)) ", OpenBrace());
+    Write("RUN_TAIL_CALLS(sbx);", Newline());
+    Write("memcpy(&ret, sbx->tail_call_results, sizeof(ret));", Newline());
+    Write(CloseBrace(), Newline());
+    Write("return ret;", Newline());
+  }
+  Write(CloseBrace());
+}
+
+// Stores the result of a call made by a tail call thunk, for the wrapper that
+// runs the trampoline.
+void CWriter::WriteTailCallResult(const TypeVector& result_types) {
+  if (!result_types.empty())
+    Write("memcpy(sbx->tail_call_results, &ret, sizeof(ret));", Newline());
+}
+
+// Each thunk makes one pending tail call, reading its arguments from the
+// sandbox.
+void CWriter::WriteTailCallThunks() {
+  for (const Func* func : tail_call_targets_) {
+    const FuncDeclaration& decl = func->decl;
+    Write(Newline(), InternalLinkage(), "void tail_call_", GetGlobalName(func->name),
+          "(wasm2c_sandbox_t* const sbx) ", OpenBrace());
+    for (Index i = 0; i < decl.GetNumParams(); ++i) {
+      Write(decl.GetParamType(i), " p", i, ";", Newline());
+      Write("TAIL_CALL_GET_ARG(sbx, ", i, ", p", i, ");", Newline());
+    }
+    if (!decl.sig.result_types.empty())
+      Write(ResultType(decl.sig.result_types), " ret = ");
+    Write(TailCallTargetName(*func), "(sbx");
+    for (Index i = 0; i < decl.GetNumParams(); ++i)
+      Write(", p", i);
+    Write(");", Newline());
+    WriteTailCallResult(decl.sig.result_types);
+    Write(CloseBrace(), Newline());
+  }
+
+  for (Index type_index : tail_call_indirect_types_) {
+    const FuncType* func_type = cast<FuncType>(module_->types[type_index]);
+    const FuncSignature& sig = func_type->sig;
+    assert(module_->tables.size() == 1);
+    std::string table = "sbx->" + GetGlobalName(module_->tables[0]->name);
+
+    Write(Newline(), InternalLinkage(), "void tail_call_indirect_", type_index,
+          "(wasm2c_sandbox_t* const sbx) ", OpenBrace());
+    std::string args = "sbx";
+    for (Index i = 0; i < sig.GetNumParams(); ++i) {
+      Write(sig.GetParamType(i), " p", i, ";", Newline());
+      Write("TAIL_CALL_GET_ARG(sbx, ", i, ", p", i, ");", Newline());
+      args += ", p" + std::to_string(i);
+    }
+    Write("u32 index;", Newline());
+    Write("TAIL_CALL_GET_ARG(sbx, ", sig.GetNumParams(), ", index);", Newline());
+    if (!sig.result_types.empty())
+      Write(ResultType(sig.result_types), " ret;", Newline());
+    std::string assign = sig.result_types.empty() ? "" : "ret = ";
+
+    // Functions with tail calls of their own run their body here, so that
+    // their pending calls go to this trampoline instead of a nested one.
+    Index func_index = 0;
+    for (const Func* func : module_->funcs) {
+      bool is_import = func_index++ < module_->num_func_imports;
+      if (is_import || !HasTailCalls(*func) || !(func->decl.sig == sig))
+        continue;
+      Write("if (index < ", table, ".size && ", table,
+            ".data[index].func == (wasm_rt_anyfunc_t)&", GetGlobalName(func->name),
+            ") ", OpenBrace());
+      Write(assign, TailCallBodyName(*func), "(", args, ");", Newline());
+      WriteTailCallResult(sig.result_types);
+      Write("return;", Newline());
+      Write(CloseBrace(), Newline());
+    }
+
+    if (sig.result_types.empty()) {
+      Write("CALL_INDIRECT_VOID(");
+    } else {
+      Write("CALL_INDIRECT_RES(ret, ");
+    }
+    FuncDeclaration decl;
+    decl.sig = sig;
+    Write(table, ", ");
+    WriteFuncDeclaration(decl, "(*)", false /* add_storage_class */);
+    Write(", ", FuncTypeId(type_index), ", index, ", args, ");", Newline());
+    WriteTailCallResult(sig.result_types);
+    Write(CloseBrace(), Newline());
+  }
+}
+
+// Leaves the body with a tail call pending. The wrapper takes the results from
+// the pending call, so unlike a return, none are moved to the result
+// variables, and the stack may not even hold them.
+void CWriter::WriteTailCallExit() {
+  FindLabel(Var(label_stack_.size() - 1));
+  Write("goto ", Var(kImplicitFuncLabel), ";", Newline());
+}
+
+void CWriter::Write(const ReturnCallExpr& expr) {
+  const Func& callee = *module_->GetFunc(expr.var);
+  Index num_params = callee.GetNumParams();
+  bool is_import = module_->GetFuncIndex(expr.var) < module_->num_func_imports;
+  assert(type_stack_.size() >= num_params);
+  FlushFoldedExprs();
+
+  bool can_use_musttail = !is_import && CanUseMusttail(*func_, callee.decl.sig);
+  if (can_use_musttail) {
+    Write("#ifdef WASM_RT_MUSTTAIL", Newline());
+    Write("WASM_RT_MUSTTAIL return ", TailCallTargetName(callee), "(sbx");
+    for (Index i = 0; i < num_params; ++i)
+      Write(", ", StackVar(num_params - i - 1));
+    Write(");", Newline());
+    Write("#else", Newline());
+  }
+  for (Index i = 0; i < num_params; ++i) {
+    Write("TAIL_CALL_ARG(sbx, ", i, ", ", StackVar(num_params - i - 1), ");",
+          Newline());
+  }
+  Write("sbx->tail_call_next = &tail_call_", GetGlobalName(callee.name), ";",
+        Newline());
+  WriteTailCallExit();
+  if (can_use_musttail)
+    Write("#endif", Newline());
+}
+
+void CWriter::Write(const ReturnCallIndirectExpr& expr) {
+  const FuncDeclaration& decl = expr.decl;
+  Index num_params = decl.GetNumParams();
+  assert(type_stack_.size() > num_params);
+  assert(decl.has_func_type);
+  assert(module_->tables.size() == 1);
+  const Table* table = module_->tables[0];
+  Index func_type_index = module_->GetFuncTypeIndex(decl.type_var);
+  FlushFoldedExprs();
+
+  bool can_use_musttail = CanUseMusttail(*func_, decl.sig);
+  if (can_use_musttail) {
+    Write("#ifdef WASM_RT_MUSTTAIL", Newline());
+    Write("RETURN_CALL_INDIRECT(sbx->", ExternalRef(table->name), ", ");
+    WriteFuncDeclaration(decl, "(*)", false /* add_storage_class*/);
+    Write(", ", FuncTypeId(func_type_index), ", ", StackVar(0), ", sbx");
+    for (Index i = 0; i < num_params; ++i)
+      Write(", ", StackVar(num_params - i));
+    Write(");", Newline());
+    Write("#else", Newline());
+  }
+  for (Index i = 0; i < num_params; ++i) {
+    Write("TAIL_CALL_ARG(sbx, ", i, ", ", StackVar(num_params - i), ");",
+          Newline());
+  }
+  Write("TAIL_CALL_ARG(sbx, ", num_params, ", ", StackVar(0), ");", Newline());
+  Write("sbx->tail_call_next = &tail_call_indirect_", func_type_index, ";",
+        Newline());
+  WriteTailCallExit();
+  if (can_use_musttail)
+    Write("#endif", Newline());
+}
+
 void CWriter::WriteParamsAndLocals() {
   std::vector<std::string> index_to_name;
   MakeTypeBindingReverseMapping(func_->GetNumParamsAndLocals(), func_->bindings,
@@ -1481,7 +3486,7 @@ void CWriter::WriteParams(const std::vector<std::string>& index_to_name) {
 
 void CWriter::WriteLocals(const std::vector<std::string>& index_to_name) {
   Index num_params = func_->GetNumParams();
-  for (Type type : {Type::I32, Type::I64, Type::F32, Type::F64}) {
+  for (Type type : {Type::I32, Type::I64, Type::F32, Type::F64, Type::V128}) {
     Index local_index = 0;
     size_t count = 0;
     for (Type local_type : func_->local_types) {
@@ -1496,7 +3501,7 @@ void CWriter::WriteLocals(const std::vector<std::string>& index_to_name) {
         }
 
         Write(DefineLocalScopeName(index_to_name[num_params + local_index]),
-              " = 0");
+              type == Type::V128 ? " = {0}" : " = 0");
         ++count;
       }
       ++local_index;
@@ -1509,7 +3514,7 @@ void CWriter::WriteLocals(const std::vector<std::string>& index_to_name) {
 }
 
 void CWriter::WriteStackVarDeclarations() {
-  for (Type type : {Type::I32, Type::I64, Type::F32, Type::F64}) {
+  for (Type type : {Type::I32, Type::I64, Type::F32, Type::F64, Type::V128}) {
     size_t count = 0;
     for (const auto& pair : stack_var_sym_map_) {
       Type stp_type = pair.first.second;
@@ -1536,6 +3541,76 @@ void CWriter::WriteStackVarDeclarations() {
   }
 }
 
+void CWriter::WriteMemoryCacheDeclarations() {
+  if (!func_caches_memory_)
+    return;
+
+  Memory* memory = module_->memories[0];
+  Write("u8* mem_data = ", MemoryField(memory, "data"), ";", Newline());
+  if (fixed_memory_size_ != 0) {
+    Write("const u64 mem_size = ", std::to_string(fixed_memory_size_), "ull;",
+          Newline());
+  } else {
+    Write("u64 mem_size = MEM_SIZE(", MemoryPtr(memory), ");", Newline());
+  }
+}
+
+void CWriter::WriteMemoryCacheRefresh() {
+  if (!func_caches_memory_)
+    return;
+
+  // The callee may have grown (and, without guard pages, moved) the memory.
+  Memory* memory = module_->memories[0];
+  Write("mem_data = ", MemoryField(memory, "data"), ";");
+  if (fixed_memory_size_ == 0)
+    Write(" mem_size = MEM_SIZE(", MemoryPtr(memory), ");");
+  Write(Newline());
+}
+
+void CWriter::WriteGlobalCacheDeclarations() {
+  cached_globals_.clear();
+  if (!options_.cache_globals)
+    return;
+
+  std::set<Index> globals;
+  CollectGlobalGets(*module_, func_->exprs, &globals);
+  for (Index index : globals) {
+    const Global* global = module_->globals[index];
+    std::string name = DefineName(
+        &local_syms_, StripLeadingDollar(global->name).to_string() + "_cache");
+    Write(global->type, " ", name, " = sbx->", ExternalRef(global->name), ";",
+          Newline());
+    cached_globals_.emplace(index, std::move(name));
+  }
+}
+
+void CWriter::WriteGlobalCacheRefresh() {
+  // Only calls can run code that sets globals.
+  for (const auto& pair : cached_globals_) {
+    const Global* global = module_->globals[pair.first];
+    if (global->mutable_) {
+      Write(pair.second, " = sbx->", ExternalRef(global->name), ";",
+            Newline());
+    }
+  }
+}
+
+void CWriter::WriteMemoryAccessArgs(bool check) {
+  assert(module_->memories.size() == 1);
+  Memory* memory = module_->memories[0];
+
+  if (!check)
+    Write("_unchecked");
+  if (func_caches_memory_) {
+    Write("_cached(", MemoryPtr(memory), ", mem_data, mem_size, ");
+  } else if (check && fixed_memory_size_ != 0) {
+    Write("_cached(", MemoryPtr(memory), ", ", MemoryField(memory, "data"),
+          ", ", std::to_string(fixed_memory_size_), "ull, ");
+  } else {
+    Write("(", MemoryPtr(memory), ", ");
+  }
+}
+
 void CWriter::Write(const ExprList& exprs) {
   for (const Expr& expr : exprs) {
     switch (expr.type()) {
@@ -1546,11 +3621,16 @@ void CWriter::Write(const ExprList& exprs) {
       case ExprType::Block: {
         const Block& block = cast<BlockExpr>(&expr)->block;
         std::string label = DefineLocalScopeName(block.label);
+        FlushFoldedExprs();
         DropTypes(block.decl.GetNumParams());
         size_t mark = MarkTypeStack();
         PushLabel(LabelType::Block, block.label, block.decl.sig);
         PushTypes(block.decl.sig.param_types);
-        Write(block.exprs, LabelDecl(label));
+        PushCheckedRanges();
+        Write(block.exprs);
+        FlushFoldedExprs();
+        PopCheckedRanges();
+        Write(LabelDecl(label));
         ResetTypeStack(mark);
         PopLabel();
         PushTypes(block.decl.sig.result_types);
@@ -1558,19 +3638,24 @@ void CWriter::Write(const ExprList& exprs) {
       }
 
       case ExprType::Br:
+        FlushFoldedExprs();
         Write(GotoLabel(cast<BrExpr>(&expr)->var), Newline());
         // Stop processing this ExprList, since the following are unreachable.
         return;
 
       case ExprType::BrIf:
-        Write("if (", StackVar(0), ") {");
+        FlushFoldedExprs(1);
+        Write("if (");
+        WriteBranchCondition();
+        Write(") {");
         DropTypes(1);
         Write(GotoLabel(cast<BrIfExpr>(&expr)->var), "}", Newline());
         break;
 
       case ExprType::BrTable: {
         const auto* bt_expr = cast<BrTableExpr>(&expr);
-        Write("switch (", StackVar(0), ") ", OpenBrace());
+        FlushFoldedExprs(1);
+        Write("switch (", StackValue(0), ") ", OpenBrace());
         DropTypes(1);
         Index i = 0;
         for (const Var& var : bt_expr->targets) {
@@ -1589,6 +3674,7 @@ void CWriter::Write(const ExprList& exprs) {
         Index num_params = func.GetNumParams();
         Index num_results = func.GetNumResults();
         assert(type_stack_.size() >= num_params);
+        InvalidateFoldedGlobalReads(num_params);
         if (num_results > 1) {
           Write(OpenBrace());
           Write("struct ", MangleMultivalueTypes(func.decl.sig.result_types));
@@ -1599,9 +3685,11 @@ void CWriter::Write(const ExprList& exprs) {
 
         Write(GlobalVar(var), "(sbx");
         for (Index i = 0; i < num_params; ++i) {
-          Write(", ", StackVar(num_params - i - 1));
+          Write(", ", StackValue(num_params - i - 1));
         }
         Write(");", Newline());
+        WriteMemoryCacheRefresh();
+        WriteGlobalCacheRefresh();
         DropTypes(num_params);
         if (num_results > 1) {
           for (Index i = 0; i < num_results; ++i) {
@@ -1623,6 +3711,9 @@ void CWriter::Write(const ExprList& exprs) {
         Index num_params = decl.GetNumParams();
         Index num_results = decl.GetNumResults();
         assert(type_stack_.size() > num_params);
+        // The table index is used several times by the CALL_INDIRECT macros.
+        MaterializeFoldedExpr(0);
+        InvalidateFoldedGlobalReads(num_params + 1);
         if (num_results > 1) {
           Write(OpenBrace());
           Write("struct ", MangleMultivalueTypes(decl.sig.result_types)," tmp;");
@@ -1648,12 +3739,14 @@ void CWriter::Write(const ExprList& exprs) {
 
         Write("sbx->", ExternalRef(table->name), ", ");
         WriteFuncDeclaration(decl, "(*)", false /* add_storage_class*/);
-        Write(", ", func_type_index, ", ", StackVar(0));
-        Write(", sbx->func_types, sbx");
+        Write(", ", FuncTypeId(func_type_index), ", ", StackVar(0));
+        Write(", sbx");
         for (Index i = 0; i < num_params; ++i) {
-          Write(", ", StackVar(num_params - i));
+          Write(", ", StackValue(num_params - i));
         }
         Write(");", Newline());
+        WriteMemoryCacheRefresh();
+        WriteGlobalCacheRefresh();
         DropTypes(num_params + 1);
         if (num_results > 1) {
           for (Index i = 0; i < num_results; ++i) {
@@ -1676,8 +3769,23 @@ void CWriter::Write(const ExprList& exprs) {
 
       case ExprType::Const: {
         const Const& const_ = cast<ConstExpr>(&expr)->const_;
+        AddressBase base;
+        if (const_.type() == Type::I32) {
+          base.is_const = true;
+          base.value = const_.u32();
+        }
+        if (CanFoldExpr(0)) {
+          // Float literals are doubles or integers in C; keep the wasm type.
+          if (const_.type() == Type::F32 || const_.type() == Type::F64)
+            WriteFoldedExpr(const_.type(), 0, "(", const_.type(), ")", const_);
+          else
+            WriteFoldedExpr(const_.type(), 0, const_);
+          SetAddressBase(std::move(base));
+          break;
+        }
         PushType(const_.type());
         Write(StackVar(0), " = ", const_, ";", Newline());
+        SetAddressBase(std::move(base));
         break;
       }
 
@@ -1686,38 +3794,67 @@ void CWriter::Write(const ExprList& exprs) {
         break;
 
       case ExprType::Drop:
+        // A folded value is pure, so it can be discarded without writing it.
         DropTypes(1);
         break;
 
       case ExprType::GlobalGet: {
         const Var& var = cast<GlobalGetExpr>(&expr)->var;
+        auto cached = cached_globals_.find(module_->GetGlobalIndex(var));
+        std::string global = cached != cached_globals_.end()
+                                 ? cached->second
+                                 : "sbx->" + GetGlobalName(var.name());
+        // The cache is reloaded after calls, so a folded read of it must be
+        // written out before a call just like a read of the sandbox struct.
+        if (CanFoldExpr(0)) {
+          WriteFoldedExpr(module_->GetGlobal(var)->type, 0, global)
+              .reads.insert("sbx->" + var.name());
+          break;
+        }
         PushType(module_->GetGlobal(var)->type);
-        Write(StackVar(0), " = ", "sbx->", GlobalVar(var), ";", Newline());
+        Write(StackVar(0), " = ", global, ";", Newline());
         break;
       }
 
       case ExprType::GlobalSet: {
         const Var& var = cast<GlobalSetExpr>(&expr)->var;
-        Write("sbx->", GlobalVar(var), " = ", StackVar(0), ";", Newline());
+        InvalidateFoldedExprs("sbx->" + var.name(), 1);
+        // The sandbox struct is always written, so that it is up to date if
+        // a later instruction traps.
+        Write("sbx->", GlobalVar(var), " = ");
+        auto cached = cached_globals_.find(module_->GetGlobalIndex(var));
+        if (cached != cached_globals_.end())
+          Write(cached->second, " = ");
+        Write(StackValue(0), ";", Newline());
         DropTypes(1);
         break;
       }
 
       case ExprType::If: {
         const IfExpr& if_ = *cast<IfExpr>(&expr);
-        Write("if (", StackVar(0), ") ", OpenBrace());
+        FlushFoldedExprs(1);
+        Write("if (");
+        WriteBranchCondition();
+        Write(") ", OpenBrace());
         DropTypes(1);
         std::string label = DefineLocalScopeName(if_.true_.label);
         DropTypes(if_.true_.decl.GetNumParams());
         size_t mark = MarkTypeStack();
         PushLabel(LabelType::If, if_.true_.label, if_.true_.decl.sig);
         PushTypes(if_.true_.decl.sig.param_types);
-        Write(if_.true_.exprs, CloseBrace());
+        PushCheckedRanges();
+        Write(if_.true_.exprs);
+        FlushFoldedExprs();
+        Write(CloseBrace());
         if (!if_.false_.empty()) {
           ResetTypeStack(mark);
           PushTypes(if_.true_.decl.sig.param_types);
-          Write(" else ", OpenBrace(), if_.false_, CloseBrace());
+          checked_ranges_ = saved_checked_ranges_.back();
+          Write(" else ", OpenBrace(), if_.false_);
+          FlushFoldedExprs();
+          Write(CloseBrace());
         }
+        PopCheckedRanges();
         ResetTypeStack(mark);
         Write(Newline(), LabelDecl(label));
         PopLabel();
@@ -1731,34 +3868,70 @@ void CWriter::Write(const ExprList& exprs) {
 
       case ExprType::LocalGet: {
         const Var& var = cast<LocalGetExpr>(&expr)->var;
+        AddressBase base;
+        base.local = var.name();
+        if (CanFoldExpr(0)) {
+          WriteFoldedExpr(func_->GetLocalType(var), 0, var)
+              .reads.insert(var.name());
+          SetAddressBase(std::move(base));
+          break;
+        }
         PushType(func_->GetLocalType(var));
         Write(StackVar(0), " = ", var, ";", Newline());
+        SetAddressBase(std::move(base));
         break;
       }
 
       case ExprType::LocalSet: {
         const Var& var = cast<LocalSetExpr>(&expr)->var;
-        Write(var, " = ", StackVar(0), ";", Newline());
+        InvalidateFoldedExprs(var.name(), 1);
+        InvalidateCheckedRanges(var.name());
+        Write(var, " = ", StackValue(0), ";", Newline());
         DropTypes(1);
         break;
       }
 
       case ExprType::LocalTee: {
         const Var& var = cast<LocalTeeExpr>(&expr)->var;
+        AddressBase base;
+        base.local = var.name();
+        if (IsFolded(0)) {
+          // Read the value back from the local rather than keeping a copy.
+          InvalidateFoldedExprs(var.name(), 1);
+          InvalidateCheckedRanges(var.name());
+          Write(var, " = ", StackValue(0), ";", Newline());
+          Type type = StackType(0);
+          DropTypes(1);
+          WriteFoldedExpr(type, 0, var).reads.insert(var.name());
+          SetAddressBase(std::move(base));
+          break;
+        }
+        InvalidateCheckedRanges(var.name());
         Write(var, " = ", StackVar(0), ";", Newline());
+        SetAddressBase(std::move(base));
         break;
       }
 
       case ExprType::Loop: {
         const Block& block = cast<LoopExpr>(&expr)->block;
         if (!block.exprs.empty()) {
+          FlushFoldedExprs();
           Write(DefineLocalScopeName(block.label), ": ");
           Indent();
           DropTypes(block.decl.GetNumParams());
           size_t mark = MarkTypeStack();
           PushLabel(LabelType::Loop, block.label, block.decl.sig);
           PushTypes(block.decl.sig.param_types);
+          // A check before the loop still holds on the next iteration unless
+          // the body assigns the local.
+          std::set<std::string> set_locals;
+          CollectSetLocals(block.exprs, &set_locals);
+          for (const std::string& local : set_locals)
+            InvalidateCheckedRanges(local);
+          PushCheckedRanges();
           Write(Newline(), block.exprs);
+          FlushFoldedExprs();
+          PopCheckedRanges();
           ResetTypeStack(mark);
           PopLabel();
           PushTypes(block.decl.sig.result_types);
@@ -1767,10 +3940,44 @@ void CWriter::Write(const ExprList& exprs) {
         break;
       }
 
-      case ExprType::MemoryCopy:
-      case ExprType::DataDrop:
-      case ExprType::MemoryInit:
-      case ExprType::MemoryFill:
+      case ExprType::MemoryCopy: {
+        assert(module_->memories.size() == 1);
+        Write("memory_copy(", MemoryPtr(module_->memories[0]), ", ",
+              StackValue(2), ", ", StackValue(1), ", ", StackValue(0),
+              shadow_func_args_, ");", Newline());
+        DropTypes(3);
+        break;
+      }
+
+      case ExprType::MemoryFill: {
+        assert(module_->memories.size() == 1);
+        Write("memory_fill(", MemoryPtr(module_->memories[0]), ", ",
+              StackValue(2), ", ", StackValue(1), ", ", StackValue(0),
+              shadow_func_args_, ");", Newline());
+        DropTypes(3);
+        break;
+      }
+
+      case ExprType::MemoryInit: {
+        assert(module_->memories.size() == 1);
+        Index segment_index =
+            module_->GetDataSegmentIndex(cast<MemoryInitExpr>(&expr)->var);
+        Write("memory_init(", MemoryPtr(module_->memories[0]), ", ",
+              StackValue(2), ", ", StackValue(1), ", ", StackValue(0),
+              ", sbx->data_segments[", segment_index,
+              "], sbx->data_segment_sizes[", segment_index, "]",
+              shadow_func_args_, ");", Newline());
+        DropTypes(3);
+        break;
+      }
+
+      case ExprType::DataDrop: {
+        Index segment_index =
+            module_->GetDataSegmentIndex(cast<DataDropExpr>(&expr)->var);
+        Write("sbx->data_segment_sizes[", segment_index, "] = 0;", Newline());
+        break;
+      }
+
       case ExprType::TableCopy:
       case ExprType::ElemDrop:
       case ExprType::TableInit:
@@ -1789,8 +3996,9 @@ void CWriter::Write(const ExprList& exprs) {
         assert(module_->memories.size() == 1);
         Memory* memory = module_->memories[0];
 
-        Write(StackVar(0), " = wasm_rt_grow_memory((&sbx->", ExternalRef(memory->name),
-              "), ", StackVar(0), ");", Newline());
+        Write(StackVar(0), " = wasm_rt_grow_memory(", MemoryPtr(memory), ", ",
+              StackValue(0), ");", Newline());
+        WriteMemoryCacheRefresh();
         break;
       }
 
@@ -1799,8 +4007,7 @@ void CWriter::Write(const ExprList& exprs) {
         Memory* memory = module_->memories[0];
 
         PushType(Type::I32);
-        Write(StackVar(0), " = sbx->", ExternalRef(memory->name), ".pages;",
-              Newline());
+        Write(StackVar(0), " = MEM_PAGES(", MemoryPtr(memory), ");", Newline());
         break;
       }
 
@@ -1810,14 +4017,20 @@ void CWriter::Write(const ExprList& exprs) {
       case ExprType::Return:
         // Goto the function label instead; this way we can do shared function
         // cleanup code in one place.
+        FlushFoldedExprs();
         Write(GotoLabel(Var(label_stack_.size() - 1)), Newline());
         // Stop processing this ExprList, since the following are unreachable.
         return;
 
       case ExprType::Select: {
         Type type = StackType(1);
-        Write(StackVar(2), " = ", StackVar(0), " ? ", StackVar(2), " : ",
-              StackVar(1), ";", Newline());
+        if (CanFoldExpr(3)) {
+          WriteFoldedExpr(type, 3, StackValue(0, true), " ? ",
+                          StackValue(2, true), " : ", StackValue(1, true));
+          break;
+        }
+        Write(StackVar(2), " = ", StackValue(0), " ? ", StackValue(2, true),
+              " : ", StackValue(1, true), ";", Newline());
         DropTypes(3);
         PushType(type);
         break;
@@ -1868,27 +4081,78 @@ void CWriter::Write(const ExprList& exprs) {
         return;
 
       case ExprType::AtomicLoad:
+        Write(*cast<AtomicLoadExpr>(&expr));
+        break;
+
+      case ExprType::AtomicStore:
+        Write(*cast<AtomicStoreExpr>(&expr));
+        break;
+
       case ExprType::AtomicRmw:
+        Write(*cast<AtomicRmwExpr>(&expr));
+        break;
+
       case ExprType::AtomicRmwCmpxchg:
-      case ExprType::AtomicStore:
+        Write(*cast<AtomicRmwCmpxchgExpr>(&expr));
+        break;
+
       case ExprType::AtomicWait:
-      case ExprType::AtomicFence:
+        Write(*cast<AtomicWaitExpr>(&expr));
+        break;
+
       case ExprType::AtomicNotify:
-      case ExprType::Rethrow:
+        Write(*cast<AtomicNotifyExpr>(&expr));
+        break;
+
+      case ExprType::AtomicFence:
+        Write("atomic_fence();", Newline());
+        break;
+
       case ExprType::ReturnCall:
+        Write(*cast<ReturnCallExpr>(&expr));
+        // Stop processing this ExprList, since the following are unreachable.
+        return;
+
       case ExprType::ReturnCallIndirect:
+        Write(*cast<ReturnCallIndirectExpr>(&expr));
+        return;
+
+      case ExprType::Rethrow:
       case ExprType::Throw:
       case ExprType::Try:
       case ExprType::CallRef:
         UNIMPLEMENTED("...");
         break;
     }
+
+    // Only local.get, local.tee and constants give their result an address
+    // base. Other instructions may compute their result in the slot of an
+    // operand, which must not keep the base of that operand.
+    if (expr.type() != ExprType::LocalGet &&
+        expr.type() != ExprType::LocalTee && expr.type() != ExprType::Const &&
+        !address_bases_.empty()) {
+      address_bases_.back() = AddressBase();
+    }
   }
 }
 
 void CWriter::WriteSimpleUnaryExpr(Opcode opcode, const char* op) {
   Type result_type = opcode.GetResultType();
-  Write(StackVar(0, result_type), " = ", op, "(", StackVar(0), ");", Newline());
+  if (IsMacro(op)) {
+    // Macros may trap, so they are never folded, and they get a plain
+    // stack variable as their argument.
+    MaterializeFoldedExpr(0);
+  } else if (CanFoldExpr(1)) {
+    if (opcode == Opcode::I32Eqz || opcode == Opcode::I64Eqz) {
+      // '!' yields an int; keep the result unsigned like a stack variable.
+      WriteFoldedExpr(result_type, 1, "(u32)", op, "(", StackValue(0), ")");
+    } else {
+      WriteFoldedExpr(result_type, 1, op, "(", StackValue(0), ")");
+    }
+    return;
+  }
+  Write(StackVar(0, result_type), " = ", op, "(", StackValue(0), ");",
+        Newline());
   DropTypes(1);
   PushType(opcode.GetResultType());
 }
@@ -1897,11 +4161,23 @@ void CWriter::WriteInfixBinaryExpr(Opcode opcode,
                                    const char* op,
                                    AssignOp assign_op) {
   Type result_type = opcode.GetResultType();
+  if (CanFoldExpr(2)) {
+    if (assign_op == AssignOp::Disallowed) {
+      // Comparisons yield an int; keep the result unsigned like a stack
+      // variable.
+      WriteFoldedExpr(result_type, 2, "(u32)(", StackValue(1, true), " ", op,
+                      " ", StackValue(0, true), ")");
+    } else {
+      WriteFoldedExpr(result_type, 2, StackValue(1, true), " ", op, " ",
+                      StackValue(0, true));
+    }
+    return;
+  }
   Write(StackVar(1, result_type));
-  if (assign_op == AssignOp::Allowed) {
-    Write(" ", op, "= ", StackVar(0));
+  if (assign_op == AssignOp::Allowed && !IsFolded(1)) {
+    Write(" ", op, "= ", StackValue(0));
   } else {
-    Write(" = ", StackVar(1), " ", op, " ", StackVar(0));
+    Write(" = ", StackValue(1, true), " ", op, " ", StackValue(0, true));
   }
   Write(";", Newline());
   DropTypes(2);
@@ -1910,8 +4186,18 @@ void CWriter::WriteInfixBinaryExpr(Opcode opcode,
 
 void CWriter::WritePrefixBinaryExpr(Opcode opcode, const char* op) {
   Type result_type = opcode.GetResultType();
-  Write(StackVar(1, result_type), " = ", op, "(", StackVar(1), ", ",
-        StackVar(0), ");", Newline());
+  if (IsMacro(op)) {
+    // Macros may trap, so they are never folded, and they get plain stack
+    // variables as their arguments.
+    MaterializeFoldedExpr(1);
+    MaterializeFoldedExpr(0);
+  } else if (CanFoldExpr(2)) {
+    WriteFoldedExpr(result_type, 2, op, "(", StackValue(1), ", ",
+                    StackValue(0), ")");
+    return;
+  }
+  Write(StackVar(1, result_type), " = ", op, "(", StackValue(1), ", ",
+        StackValue(0), ");", Newline());
   DropTypes(2);
   PushType(result_type);
 }
@@ -1920,13 +4206,47 @@ void CWriter::WriteSignedBinaryExpr(Opcode opcode, const char* op) {
   Type result_type = opcode.GetResultType();
   Type type = opcode.GetParamType1();
   assert(opcode.GetParamType2() == type);
+  if (CanFoldExpr(2)) {
+    WriteFoldedExpr(result_type, 2, "(", type, ")((", SignedType(type), ")",
+                    StackValue(1, true), " ", op, " (", SignedType(type), ")",
+                    StackValue(0, true), ")");
+    return;
+  }
   Write(StackVar(1, result_type), " = (", type, ")((", SignedType(type), ")",
-        StackVar(1), " ", op, " (", SignedType(type), ")", StackVar(0), ");",
-        Newline());
+        StackValue(1, true), " ", op, " (", SignedType(type), ")",
+        StackValue(0, true), ");", Newline());
   DropTypes(2);
   PushType(result_type);
 }
 
+void CWriter::WriteShiftExpr(Opcode opcode, const char* op) {
+  Type type = opcode.GetResultType();
+  if (CanFoldExpr(2)) {
+    WriteFoldedExpr(type, 2, StackValue(1, true), " ", op, " (",
+                    StackValue(0, true), " & ", GetShiftMask(type), ")");
+    return;
+  }
+  if (IsFolded(1)) {
+    Write(StackVar(1), " = ", StackValue(1, true), " ", op, " (",
+          StackValue(0, true), " & ", GetShiftMask(type), ");", Newline());
+  } else {
+    // The slot no longer holds the value it was given.
+    *(address_bases_.rbegin() + 1) = AddressBase();
+    Write(StackVar(1), " ", op, "= (", StackValue(0, true), " & ",
+          GetShiftMask(type), ");", Newline());
+  }
+  DropTypes(1);
+}
+
+void CWriter::WriteSimdExpr(Opcode opcode) {
+  assert(IsSimdOpcode(opcode));
+  std::string func = "simd_" + MangleOpcodeName(opcode);
+  if (opcode.GetParamType2() == Type::Void)
+    WriteSimpleUnaryExpr(opcode, func.c_str());
+  else
+    WritePrefixBinaryExpr(opcode, func.c_str());
+}
+
 void CWriter::Write(const BinaryExpr& expr) {
   switch (expr.opcode) {
     case Opcode::I32Add:
@@ -1998,26 +4318,28 @@ void CWriter::Write(const BinaryExpr& expr) {
 
     case Opcode::I32Shl:
     case Opcode::I64Shl:
-      Write(StackVar(1), " <<= (", StackVar(0), " & ",
-            GetShiftMask(expr.opcode.GetResultType()), ");", Newline());
-      DropTypes(1);
+      WriteShiftExpr(expr.opcode, "<<");
       break;
 
     case Opcode::I32ShrS:
     case Opcode::I64ShrS: {
       Type type = expr.opcode.GetResultType();
+      if (CanFoldExpr(2)) {
+        WriteFoldedExpr(type, 2, "(", type, ")((", SignedType(type), ")",
+                        StackValue(1, true), " >> (", StackValue(0, true),
+                        " & ", GetShiftMask(type), "))");
+        break;
+      }
       Write(StackVar(1), " = (", type, ")((", SignedType(type), ")",
-            StackVar(1), " >> (", StackVar(0), " & ", GetShiftMask(type), "));",
-            Newline());
+            StackValue(1, true), " >> (", StackValue(0, true), " & ",
+            GetShiftMask(type), "));", Newline());
       DropTypes(1);
       break;
     }
 
     case Opcode::I32ShrU:
     case Opcode::I64ShrU:
-      Write(StackVar(1), " >>= (", StackVar(0), " & ",
-            GetShiftMask(expr.opcode.GetResultType()), ");", Newline());
-      DropTypes(1);
+      WriteShiftExpr(expr.opcode, ">>");
       break;
 
     case Opcode::I32Rotl:
@@ -2055,7 +4377,8 @@ void CWriter::Write(const BinaryExpr& expr) {
       break;
 
     default:
-      WABT_UNREACHABLE;
+      WriteSimdExpr(expr.opcode);
+      break;
   }
 }
 
@@ -2124,7 +4447,8 @@ void CWriter::Write(const CompareExpr& expr) {
       break;
 
     default:
-      WABT_UNREACHABLE;
+      WriteSimdExpr(expr.opcode);
+      break;
   }
 }
 
@@ -2266,7 +4590,8 @@ void CWriter::Write(const ConvertExpr& expr) {
       break;
 
     default:
-      WABT_UNREACHABLE;
+      WriteSimdExpr(expr.opcode);
+      break;
   }
 }
 
@@ -2287,20 +4612,32 @@ void CWriter::Write(const LoadExpr& expr) {
     case Opcode::I64Load16U: func = "i64_load16_u"; break;
     case Opcode::I64Load32S: func = "i64_load32_s"; break;
     case Opcode::I64Load32U: func = "i64_load32_u"; break;
+    case Opcode::V128Load: func = "v128_load"; break;
+    case Opcode::V128Load8X8S: func = "v128_load8x8_s"; break;
+    case Opcode::V128Load8X8U: func = "v128_load8x8_u"; break;
+    case Opcode::V128Load16X4S: func = "v128_load16x4_s"; break;
+    case Opcode::V128Load16X4U: func = "v128_load16x4_u"; break;
+    case Opcode::V128Load32X2S: func = "v128_load32x2_s"; break;
+    case Opcode::V128Load32X2U: func = "v128_load32x2_u"; break;
 
     default:
       WABT_UNREACHABLE;
   }
 
-  assert(module_->memories.size() == 1);
-  Memory* memory = module_->memories[0];
+  bool check = NeedsBoundsCheck(0, expr.offset, expr.opcode.GetMemorySize());
+  WriteLoad(func, expr.opcode.GetResultType(), expr.offset, check);
+}
 
-  Type result_type = expr.opcode.GetResultType();
-  Write(StackVar(0, result_type), " = ", func, "(&(sbx->", ExternalRef(memory->name),
-        "), (u64)(", StackVar(0), ")");
-  if (expr.offset != 0)
-    Write(" + ", expr.offset, "u");
-  Write(", \"", GetGlobalName(func_->name), "\"");
+void CWriter::WriteLoad(const char* func,
+                        Type result_type,
+                        Address offset,
+                        bool check) {
+  Write(StackVar(0, result_type), " = ", func);
+  WriteMemoryAccessArgs(check);
+  Write("(u64)(", StackValue(0), ")");
+  if (offset != 0)
+    Write(" + ", offset, "u");
+  Write(shadow_func_args_);
   Write(");", Newline());
   DropTypes(1);
   PushType(result_type);
@@ -2318,19 +4655,20 @@ void CWriter::Write(const StoreExpr& expr) {
     case Opcode::I32Store16: func = "i32_store16"; break;
     case Opcode::I64Store16: func = "i64_store16"; break;
     case Opcode::I64Store32: func = "i64_store32"; break;
+    case Opcode::V128Store: func = "v128_store"; break;
 
     default:
       WABT_UNREACHABLE;
   }
 
-  assert(module_->memories.size() == 1);
-  Memory* memory = module_->memories[0];
-
-  Write(func, "(&(sbx->", ExternalRef(memory->name), "), (u64)(", StackVar(1), ")");
+  Write(func);
+  WriteMemoryAccessArgs(
+      NeedsBoundsCheck(1, expr.offset, expr.opcode.GetMemorySize()));
+  Write("(u64)(", StackValue(1), ")");
   if (expr.offset != 0)
     Write(" + ", expr.offset);
-  Write(", ", StackVar(0));
-  Write(", \"", GetGlobalName(func_->name), "\"");
+  Write(", ", StackValue(0));
+  Write(shadow_func_args_);
   Write(");", Newline());
   DropTypes(2);
 }
@@ -2435,7 +4773,8 @@ void CWriter::Write(const UnaryExpr& expr) {
       break;
 
     default:
-      WABT_UNREACHABLE;
+      WriteSimdExpr(expr.opcode);
+      break;
   }
 }
 
@@ -2443,8 +4782,13 @@ void CWriter::Write(const TernaryExpr& expr) {
   switch (expr.opcode) {
     case Opcode::V128BitSelect: {
       Type result_type = expr.opcode.GetResultType();
-      Write(StackVar(2, result_type), " = ", "v128.bitselect", "(", StackVar(0),
-            ", ", StackVar(1), ", ", StackVar(2), ");", Newline());
+      if (CanFoldExpr(3)) {
+        WriteFoldedExpr(result_type, 3, "simd_v128_bitselect(", StackValue(2),
+                        ", ", StackValue(1), ", ", StackValue(0), ")");
+        break;
+      }
+      Write(StackVar(2, result_type), " = simd_v128_bitselect(", StackValue(2),
+            ", ", StackValue(1), ", ", StackValue(0), ");", Newline());
       DropTypes(3);
       PushType(result_type);
       break;
@@ -2456,6 +4800,8 @@ void CWriter::Write(const TernaryExpr& expr) {
 
 void CWriter::Write(const SimdLaneOpExpr& expr) {
   Type result_type = expr.opcode.GetResultType();
+  std::string func = "simd_" + MangleOpcodeName(expr.opcode);
+  Index lane = static_cast<Index>(expr.val);
 
   switch (expr.opcode) {
     case Opcode::I8X16ExtractLaneS:
@@ -2466,8 +4812,13 @@ void CWriter::Write(const SimdLaneOpExpr& expr) {
     case Opcode::I64X2ExtractLane:
     case Opcode::F32X4ExtractLane:
     case Opcode::F64X2ExtractLane: {
-      Write(StackVar(0, result_type), " = ", expr.opcode.GetName(), "(",
-            StackVar(0), ", lane Imm: ", expr.val, ");", Newline());
+      if (CanFoldExpr(1)) {
+        WriteFoldedExpr(result_type, 1, func, "(", StackValue(0), ", ", lane,
+                        ")");
+        return;
+      }
+      Write(StackVar(0, result_type), " = ", func, "(", StackValue(0), ", ",
+            lane, ");", Newline());
       DropTypes(1);
       break;
     }
@@ -2477,9 +4828,13 @@ void CWriter::Write(const SimdLaneOpExpr& expr) {
     case Opcode::I64X2ReplaceLane:
     case Opcode::F32X4ReplaceLane:
     case Opcode::F64X2ReplaceLane: {
-      Write(StackVar(1, result_type), " = ", expr.opcode.GetName(), "(",
-            StackVar(0), ", ", StackVar(1), ", lane Imm: ", expr.val, ");",
-            Newline());
+      if (CanFoldExpr(2)) {
+        WriteFoldedExpr(result_type, 2, func, "(", StackValue(1), ", ", lane,
+                        ", ", StackValue(0), ")");
+        return;
+      }
+      Write(StackVar(1, result_type), " = ", func, "(", StackValue(1), ", ",
+            lane, ", ", StackValue(0), ");", Newline());
       DropTypes(2);
       break;
     }
@@ -2491,44 +4846,115 @@ void CWriter::Write(const SimdLaneOpExpr& expr) {
 }
 
 void CWriter::Write(const SimdLoadLaneExpr& expr) {
-  UNIMPLEMENTED("SIMD support");
+  std::string func = MangleOpcodeName(expr.opcode);
+  Type result_type = expr.opcode.GetResultType();
+  Write(StackVar(1, result_type), " = ", func);
+  WriteMemoryAccessArgs();
+  Write("(u64)(", StackValue(1), ")");
+  if (expr.offset != 0)
+    Write(" + ", expr.offset, "u");
+  Write(", ", StackValue(0), ", ", static_cast<Index>(expr.val),
+        shadow_func_args_, ");", Newline());
+  DropTypes(2);
+  PushType(result_type);
 }
 
 void CWriter::Write(const SimdStoreLaneExpr& expr) {
-  UNIMPLEMENTED("SIMD support");
+  std::string func = MangleOpcodeName(expr.opcode);
+  Write(func);
+  WriteMemoryAccessArgs();
+  Write("(u64)(", StackValue(1), ")");
+  if (expr.offset != 0)
+    Write(" + ", expr.offset, "u");
+  Write(", ", StackValue(0), ", ", static_cast<Index>(expr.val),
+        shadow_func_args_, ");", Newline());
+  DropTypes(2);
 }
 
 void CWriter::Write(const SimdShuffleOpExpr& expr) {
   Type result_type = expr.opcode.GetResultType();
-  Write(StackVar(1, result_type), " = ", expr.opcode.GetName(), "(",
-        StackVar(1), " ", StackVar(0), ", lane Imm: $0x%08x %08x %08x %08x",
-        expr.val.u32(0), expr.val.u32(1), expr.val.u32(2), expr.val.u32(3), ")",
-        Newline());
+  std::string lanes;
+  for (int i = 0; i < 16; ++i)
+    lanes += ", " + std::to_string(expr.val.u8(i));
+
+  // SIMD_I8X16_SHUFFLE evaluates each operand once, so it can be folded.
+  if (CanFoldExpr(2)) {
+    WriteFoldedExpr(result_type, 2, "SIMD_I8X16_SHUFFLE(", StackValue(1), ", ",
+                    StackValue(0), lanes, ")");
+    return;
+  }
+  Write(StackVar(1, result_type), " = SIMD_I8X16_SHUFFLE(", StackValue(1),
+        ", ", StackValue(0), lanes, ");", Newline());
   DropTypes(2);
   PushType(result_type);
 }
 
 void CWriter::Write(const LoadSplatExpr& expr) {
-  assert(module_->memories.size() == 1);
-  Memory* memory = module_->memories[0];
-
-  Type result_type = expr.opcode.GetResultType();
-  Write(StackVar(0, result_type), " = ", expr.opcode.GetName(), "(",
-        ExternalPtr(memory->name), ", (u64)(", StackVar(0));
-  if (expr.offset != 0)
-    Write(" + ", expr.offset);
-  Write("));", Newline());
-  DropTypes(1);
-  PushType(result_type);
+  std::string func = MangleOpcodeName(expr.opcode);
+  bool check = NeedsBoundsCheck(0, expr.offset, expr.opcode.GetMemorySize());
+  WriteLoad(func.c_str(), expr.opcode.GetResultType(), expr.offset, check);
 }
 
 void CWriter::Write(const LoadZeroExpr& expr) {
-  UNIMPLEMENTED("SIMD support");
+  std::string func = MangleOpcodeName(expr.opcode);
+  bool check = NeedsBoundsCheck(0, expr.offset, expr.opcode.GetMemorySize());
+  WriteLoad(func.c_str(), expr.opcode.GetResultType(), expr.offset, check);
+}
+
+// Writes `func(<memory>, addr + offset, operands..., func_name)`, where the
+// address is the deepest of the `num_operands` values on the stack.
+void CWriter::WriteMemoryOp(const std::string& func,
+                            Index num_operands,
+                            Type result_type,
+                            Address offset) {
+  Index addr = num_operands - 1;
+  if (result_type != Type::Void)
+    Write(StackVar(addr, result_type), " = ");
+  Write(func);
+  WriteMemoryAccessArgs();
+  Write("(u64)(", StackValue(addr), ")");
+  if (offset != 0)
+    Write(" + ", offset, "u");
+  for (Index i = addr; i-- > 0;)
+    Write(", ", StackValue(i));
+  Write(shadow_func_args_, ");", Newline());
+  DropTypes(num_operands);
+  if (result_type != Type::Void)
+    PushType(result_type);
+}
+
+void CWriter::Write(const AtomicLoadExpr& expr) {
+  WriteMemoryOp(MangleOpcodeName(expr.opcode), 1,
+                expr.opcode.GetResultType(), expr.offset);
+}
+
+void CWriter::Write(const AtomicStoreExpr& expr) {
+  WriteMemoryOp(MangleOpcodeName(expr.opcode), 2, Type::Void, expr.offset);
+}
+
+void CWriter::Write(const AtomicRmwExpr& expr) {
+  WriteMemoryOp(MangleOpcodeName(expr.opcode), 2,
+                expr.opcode.GetResultType(), expr.offset);
+}
+
+void CWriter::Write(const AtomicRmwCmpxchgExpr& expr) {
+  WriteMemoryOp(MangleOpcodeName(expr.opcode), 3,
+                expr.opcode.GetResultType(), expr.offset);
+}
+
+void CWriter::Write(const AtomicWaitExpr& expr) {
+  WriteMemoryOp(MangleOpcodeName(expr.opcode), 3,
+                expr.opcode.GetResultType(), expr.offset);
+}
+
+void CWriter::Write(const AtomicNotifyExpr& expr) {
+  WriteMemoryOp(MangleOpcodeName(expr.opcode), 2,
+                expr.opcode.GetResultType(), expr.offset);
 }
 
 void CWriter::WriteCHeader() {
   stream_ = h_stream_;
-  std::string guard = GenerateHeaderGuard();
+  std::string guard = GenerateHeaderGuard(header_name_);
   Write("#ifndef ", guard, Newline());
   Write("#define ", guard, Newline(), Newline());
   Write("#define WASM_CURR_MODULE_PREFIX ", options_.mod_name, Newline());
@@ -2540,38 +4966,84 @@ void CWriter::WriteCHeader() {
   Write("#endif  /* ", guard, " */", Newline());
 }
 
-void CWriter::WriteCSource() {
-  stream_ = c_stream_;
+void CWriter::WriteCImplHeader() {
+  stream_ = h_impl_stream_;
+  std::string guard = GenerateHeaderGuard(header_impl_name_);
+  Write("#ifndef ", guard, Newline());
+  Write("#define ", guard, Newline(), Newline());
   WriteSourceTop();
   WriteSandboxStruct();
-  WriteFuncTypes();
   WriteFuncDeclarations(false /* for_header */);
+  Write(Newline(), "#endif  /* ", guard, " */", Newline());
+}
+
+void CWriter::WriteCSource() {
+  if (IsMultiOutput()) {
+    for (Index i = c_streams_.size(); i > 0; --i) {
+      UseOutputShard(i - 1);
+      WriteShardTop();
+    }
+  } else {
+    UseOutputShard(0);
+    WriteSourceTop();
+    WriteSandboxStruct();
+  }
+  WriteFuncTypes();
+  if (!IsMultiOutput()) {
+    WriteFuncDeclarations(false /* for_header */);
+  }
   WriteEntryFuncs();
   WriteGlobalInitializers();
   WriteFuncs();
+  WriteTailCallThunks();
   WriteDataInitializers();
   WriteElemInitializers();
   WriteExportLookup();
   WriteCallbackAddRemove();
+  WriteProfileFuncs();
   WriteInit();
 }
 
 Result CWriter::WriteModule(const Module& module) {
   WABT_USE(options_);
   module_ = &module;
+  if (stats_)
+    stats_->funcs = module_->funcs.size() - module_->num_func_imports;
+  FindDeadFuncs();
+  CollectTailCalls();
+  ClassifyProfiledFuncs();
+  FindFixedMemorySize();
   WriteCHeader();
+  if (IsMultiOutput()) {
+    WriteCImplHeader();
+  }
   WriteCSource();
   return result_;
 }
 
 }  // end anonymous namespace
 
-Result WriteC(Stream* c_stream,
+uint64_t HashCOutput(string_view data) {
+  // 64-bit FNV-1a.
+  uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : data) {
+    hash = (hash ^ c) * 1099511628211ull;
+  }
+  return hash;
+}
+
+Result WriteC(const std::vector<Stream*>& c_streams,
               Stream* h_stream,
+              Stream* h_impl_stream,
               const char* header_name,
+              const char* header_impl_name,
               const Module* module,
-              const WriteCOptions& options) {
-  CWriter c_writer(c_stream, h_stream, header_name, options);
+              const WriteCOptions& options,
+              WriteCStats* stats) {
+  assert(!c_streams.empty());
+  assert(c_streams.size() == 1 || h_impl_stream);
+  CWriter c_writer(c_streams, h_stream, h_impl_stream, header_name,
+                   header_impl_name, options, stats);
   return c_writer.WriteModule(*module);
 }
 
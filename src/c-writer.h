@@ -18,23 +18,109 @@
 #define WABT_C_WRITER_H_
 
 #include "src/common.h"
+#include "src/string-view.h"
 
+#include <map>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace wabt {
 
 struct Module;
 class Stream;
 
+// The counts that a module compiled with --instrument wrote with
+// WASM_RT_PROFILE_COUNTS, used to lay out the code for the paths that were
+// taken.
+struct WriteCProfile {
+  struct Func {
+    uint64_t calls = 0;
+    uint64_t self_ticks = 0;
+    // How often each if and br_if of the function was not taken and taken, in
+    // the order they appear in the function.
+    std::vector<std::pair<uint64_t, uint64_t>> branches;
+  };
+  // By function name, without the "$" of the text format.
+  std::map<std::string, Func> funcs;
+};
+
 struct WriteCOptions {
     std::string mod_name;
+    // Keep the linear memory base and size in function locals, reloading them
+    // only after calls and memory.grow, instead of reading them through the
+    // sandbox struct on every load and store.
+    bool cache_memory_base = false;
+    // Keep the results of pure instructions as C expressions and substitute
+    // them into the instruction that consumes them, instead of assigning every
+    // value to its own stack variable.
+    bool fold_exprs = false;
+    // Keep the globals a function reads in function locals, reloading the
+    // mutable ones only after calls, instead of reading them through the
+    // sandbox struct every time. Writes still go to the sandbox struct.
+    bool cache_globals = true;
+    // Leave out the defined functions that can't be reached from the exports,
+    // the start function, the element segments or the global initializers.
+    // They are also dropped from the header, so embedders can no longer call
+    // them by their C name.
+    bool remove_dead_funcs = false;
+    // When the output is split across several files, keep the first one for
+    // the module-level code and spread the functions over the others by a
+    // hash of their names, instead of in contiguous runs of similar size. An
+    // edit to one function then leaves the files of the other functions
+    // byte-identical.
+    bool stable_shards = false;
+    // Write the contents of data segments as string literals instead of
+    // arrays of hex bytes, which are several times larger and much slower to
+    // compile.
+    bool string_data_segments = false;
+    // Functions whose loads and stores are always checked when the shadow
+    // memory checker samples accesses (WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE).
+    std::vector<std::string> shadow_check_funcs;
+    // Count the calls of every defined function, and time them along with the
+    // call stacks they were made from, into the profile of the sandbox.
+    bool instrument_calls = false;
+    bool instrument_cycles = false;
+    // Count how often every if and br_if is taken.
+    bool instrument_branches = false;
+    // Mark the hot and cold functions, hint the direction of biased branches,
+    // and put the most used globals next to the linear memory.
+    WriteCProfile profile;
 };
 
-Result WriteC(Stream* c_stream,
+// What WriteC left out of the output.
+struct WriteCStats {
+  // The number of defined functions, and of the ones that were dead.
+  Index funcs = 0;
+  Index removed_funcs = 0;
+  // The size of the code of the dead functions in the binary.
+  uint64_t removed_code_bytes = 0;
+  // The number of defined functions missing from the profile, if there were
+  // so many that the functions were not classified as hot or cold.
+  Index unprofiled_funcs = 0;
+  // A hash of the C code written for each function, by the key it is sharded
+  // by, when stable_shards is set. The code depends on the function's body, its type
+  // and the names of what it refers to, and on a few module-wide properties,
+  // such as whether the memory can grow.
+  std::vector<std::pair<std::string, uint64_t>> func_hashes;
+};
+
+// A hash of generated C code that is the same on every host, for comparing
+// the output with an earlier run.
+uint64_t HashCOutput(string_view data);
+
+// Writes the module as C source into |c_streams|. When more than one source
+// stream is given, the defined functions are sharded across the streams, and
+// the declarations they share are written to |h_impl_stream|, which is
+// included by every shard. |stats| may be null.
+Result WriteC(const std::vector<Stream*>& c_streams,
               Stream* h_stream,
+              Stream* h_impl_stream,
               const char* header_name,
+              const char* header_impl_name,
               const Module*,
-              const WriteCOptions&);
+              const WriteCOptions&,
+              WriteCStats* stats = nullptr);
 
 }  // namespace wabt
 
@@ -2,6 +2,7 @@
 const char SECTION_NAME(includes)[] =
 "/* Automically generated by wasm2c */\n"
 "#include <math.h>\n"
+"#include <stddef.h>\n"
 "#include <string.h>\n"
 "#include <stdlib.h>\n"
 ;
@@ -17,6 +18,55 @@ const char SECTION_NAME(declarations)[] =
 "\n"
 "#define TRAP(x) (wasm_rt_trap(WASM_RT_TRAP_##x), 0)\n"
 "\n"
+"// Large data segments are page aligned, so they can be mapped directly.\n"
+"#if defined(_MSC_VER)\n"
+"#  define DATA_SEGMENT_ALIGN __declspec(align(4096))\n"
+"#else\n"
+"#  define DATA_SEGMENT_ALIGN __attribute__((aligned(4096)))\n"
+"#endif\n"
+"\n"
+"// Functions that would be static in a single output file, but are shared\n"
+"// between the shards when wasm2c splits its output across several files.\n"
+"#if defined(_WIN32)\n"
+"#  define FUNC_INTERNAL\n"
+"#else\n"
+"#  define FUNC_INTERNAL __attribute__((visibility(\"hidden\")))\n"
+"#endif\n"
+"\n"
+"// Functions that the profile given to wasm2c with --profile-use found hot, or\n"
+"// never saw called. GCC also moves them to .text.hot and .text.unlikely, which\n"
+"// keeps the hot code together.\n"
+"#if defined(__has_attribute)\n"
+"#  if __has_attribute(hot) && __has_attribute(cold)\n"
+"#    define FUNC_HOT __attribute__((hot))\n"
+"#    define FUNC_COLD __attribute__((cold))\n"
+"#  endif\n"
+"#endif\n"
+"#ifndef FUNC_HOT\n"
+"#  define FUNC_HOT\n"
+"#  define FUNC_COLD\n"
+"#endif\n"
+"\n"
+"// Counts whether the condition `c` of an if or br_if holds, with\n"
+"// --instrument=branches.\n"
+"#define PROFILE_BRANCH(sbx, site, c) \\\n"
+"  profile_branch(&(sbx)->profile, site, c)\n"
+"\n"
+"static inline u32 profile_branch(wasm_rt_profile_t* profile, u32 site, u32 c) {\n"
+"  ++profile->branches[2 * site + (c != 0)];\n"
+"  return c;\n"
+"}\n"
+"\n"
+"// Tail calls skip the FUNC_EPILOGUE of the caller, and the\n"
+"// EXTERNAL_CALLBACK_EPILOGUE of callbacks, so they are only made with musttail\n"
+"// when the embedder doesn't define those.\n"
+"#if !defined(WASM_RT_MUSTTAIL) && !defined(FUNC_EPILOGUE) && \\\n"
+"    !defined(EXTERNAL_CALLBACK_EPILOGUE) && defined(__has_attribute)\n"
+"#  if __has_attribute(musttail)\n"
+"#    define WASM_RT_MUSTTAIL __attribute__((musttail))\n"
+"#  endif\n"
+"#endif\n"
+"\n"
 "#ifndef FUNC_PROLOGUE\n"
 "#define FUNC_PROLOGUE\n"
 "#endif\n"
@@ -45,22 +95,24 @@ const char SECTION_NAME(declarations)[] =
 "\n"
 "#define UNREACHABLE (void) TRAP(UNREACHABLE)\n"
 "\n"
-"#define CALL_INDIRECT_VOID(table, t, ft, x, func_types, ...)                                         \\\n"
-"  if (LIKELY((x) < table.size && table.data[x].func && table.data[x].func_type == func_types[ft])) { \\\n"
-"    EXTERNAL_CALLBACK_PROLOGUE_EXEC(table, x);                                                       \\\n"
-"    ((t)table.data[x].func)(__VA_ARGS__);                                                            \\\n"
-"    EXTERNAL_CALLBACK_EPILOGUE_EXEC(table, x);                                                       \\\n"
-"  } else {                                                                                           \\\n"
-"    wasm_rt_callback_error_trap(&table, x, func_types[ft]);                                          \\\n"
+"// Empty table elements have function type 0, which no function type has, so\n"
+"// the type check also rejects them. `type_id` is usually a constant.\n"
+"#define CALL_INDIRECT_VOID(table, t, type_id, x, ...)                     \\\n"
+"  if (LIKELY((x) < table.size && table.data[x].func_type == (type_id))) { \\\n"
+"    EXTERNAL_CALLBACK_PROLOGUE_EXEC(table, x);                            \\\n"
+"    ((t)table.data[x].func)(__VA_ARGS__);                                 \\\n"
+"    EXTERNAL_CALLBACK_EPILOGUE_EXEC(table, x);                            \\\n"
+"  } else {                                                                \\\n"
+"    wasm_rt_callback_error_trap(&table, x, type_id);                      \\\n"
 "  }\n"
 "\n"
-"#define CALL_INDIRECT_RES(res, table, t, ft, x, func_types, ...)                                     \\\n"
-"  if (LIKELY((x) < table.size && table.data[x].func && table.data[x].func_type == func_types[ft])) { \\\n"
-"    EXTERNAL_CALLBACK_PROLOGUE_EXEC(table, x);                                                       \\\n"
-"    res = ((t)table.data[x].func)(__VA_ARGS__);                                                      \\\n"
-"    EXTERNAL_CALLBACK_EPILOGUE_EXEC(table, x);                                                       \\\n"
-"  } else {                                                                                           \\\n"
-"    wasm_rt_callback_error_trap(&table, x, func_types[ft]);                                          \\\n"
+"#define CALL_INDIRECT_RES(res, table, t, type_id, x, ...)                 \\\n"
+"  if (LIKELY((x) < table.size && table.data[x].func_type == (type_id))) { \\\n"
+"    EXTERNAL_CALLBACK_PROLOGUE_EXEC(table, x);                            \\\n"
+"    res = ((t)table.data[x].func)(__VA_ARGS__);                           \\\n"
+"    EXTERNAL_CALLBACK_EPILOGUE_EXEC(table, x);                            \\\n"
+"  } else {                                                                \\\n"
+"    wasm_rt_callback_error_trap(&table, x, type_id);                      \\\n"
 "  }\n"
 "\n"
 "#if defined(WASM2C_MALLOC_FAIL_CALLBACK)\n"
@@ -74,39 +126,93 @@ const char SECTION_NAME(declarations)[] =
 "#endif\n"
 "\n"
 "#if defined(WASM_CHECK_SHADOW_MEMORY)\n"
-"#  define WASM2C_SHADOW_MEMORY_LOAD(mem, func_name, ptr, ptr_size)  wasm2c_shadow_memory_load(mem, func_name, ptr, ptr_size)\n"
-"#  define WASM2C_SHADOW_MEMORY_STORE(mem, func_name, ptr, ptr_size) wasm2c_shadow_memory_store(mem, func_name, ptr, ptr_size)\n"
+"#  if defined(WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE)\n"
+"#    if defined(WASM_CHECK_SHADOW_MEMORY_UNINIT_READ)\n"
+"#      error \"WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE can't be used with WASM_CHECK_SHADOW_MEMORY_UNINIT_READ\"\n"
+"#    endif\n"
+"// Only check about one in WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE loads and\n"
+"// stores, plus every access from the functions given to wasm2c with\n"
+"// --shadow-check-function. Allocations and frees are always tracked. Each\n"
+"// thread counts down to its next checked access, and the runtime picks the\n"
+"// length of every countdown at random so the checks don't line up with loops.\n"
+"// The rate is stored in the memory when it is allocated, so the runtime\n"
+"// doesn't need to be built with the same WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE.\n"
+"static WASM_RT_THREAD_LOCAL u32 wasm2c_shadow_sample_countdown = 1;\n"
+"#    define WASM2C_SHADOW_MEMORY_SAMPLED(mem, shadow_class)                      \\\n"
+"  (((shadow_class) & WASM2C_SHADOW_FUNC_ALWAYS_CHECK) ||                       \\\n"
+"   (UNLIKELY(--wasm2c_shadow_sample_countdown == 0) &&                         \\\n"
+"    (wasm2c_shadow_sample_countdown = wasm2c_shadow_memory_next_sample(mem), 1)))\n"
+"#    define WASM2C_SHADOW_MEMORY_INIT_SAMPLE_RATE(mem)                           \\\n"
+"  wasm2c_shadow_memory_set_sample_rate(mem, WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE)\n"
+"#  else\n"
+"#    define WASM2C_SHADOW_MEMORY_SAMPLED(mem, shadow_class) 1\n"
+"#    define WASM2C_SHADOW_MEMORY_INIT_SAMPLE_RATE(mem)\n"
+"#  endif\n"
+"#  define WASM2C_SHADOW_MEMORY_LOAD(mem, shadow_class, func_name, ptr, ptr_size)   \\\n"
+"  do {                                                                           \\\n"
+"    if (WASM2C_SHADOW_MEMORY_SAMPLED(mem, shadow_class))                         \\\n"
+"      wasm2c_shadow_memory_load(mem, shadow_class, func_name, ptr, ptr_size);    \\\n"
+"  } while (0)\n"
+"#  define WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, ptr, ptr_size)  \\\n"
+"  do {                                                                           \\\n"
+"    if (WASM2C_SHADOW_MEMORY_SAMPLED(mem, shadow_class))                         \\\n"
+"      wasm2c_shadow_memory_store(mem, shadow_class, func_name, ptr, ptr_size);   \\\n"
+"  } while (0)\n"
 "#  define WASM2C_SHADOW_MEMORY_RESERVE(mem, ptr, ptr_size)          wasm2c_shadow_memory_reserve(mem, ptr, ptr_size)\n"
 "#  define WASM2C_SHADOW_MEMORY_DLMALLOC(mem, ptr, ptr_size)         wasm2c_shadow_memory_dlmalloc(mem, ptr, ptr_size)\n"
 "#  define WASM2C_SHADOW_MEMORY_DLFREE(mem, ptr)                     wasm2c_shadow_memory_dlfree(mem, ptr)\n"
 "#  define WASM2C_SHADOW_MEMORY_MARK_GLOBALS_HEAP_BOUNDARY(mem, ptr) wasm2c_shadow_memory_mark_globals_heap_boundary(mem, ptr)\n"
 "#else\n"
-"#  define WASM2C_SHADOW_MEMORY_LOAD(mem, func_name, ptr, ptr_size)\n"
-"#  define WASM2C_SHADOW_MEMORY_STORE(mem, func_name, ptr, ptr_size)\n"
+"// Consume the arguments that the load and store helpers only take for shadow\n"
+"// memory, so that they don't warn about unused parameters.\n"
+"#  define WASM2C_SHADOW_MEMORY_LOAD(mem, shadow_class, func_name, ptr, ptr_size) \\\n"
+"  ((void)(mem), (void)(shadow_class), (void)(func_name))\n"
+"#  define WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, ptr, ptr_size) \\\n"
+"  ((void)(mem), (void)(shadow_class), (void)(func_name))\n"
 "#  define WASM2C_SHADOW_MEMORY_RESERVE(mem, ptr, ptr_size)\n"
 "#  define WASM2C_SHADOW_MEMORY_DLMALLOC(mem, ptr, ptr_size)\n"
 "#  define WASM2C_SHADOW_MEMORY_DLFREE(mem, ptr)\n"
 "#  define WASM2C_SHADOW_MEMORY_MARK_GLOBALS_HEAP_BOUNDARY(mem, ptr)\n"
+"#  define WASM2C_SHADOW_MEMORY_INIT_SAMPLE_RATE(mem)\n"
+"#endif\n"
+"\n"
+"// Another thread may grow a shared memory at any time, so its size is read\n"
+"// atomically. wasm_rt_grow_memory makes the new pages accessible before it\n"
+"// stores the new size.\n"
+"#if WASM_RT_SHARED_MEMORY\n"
+"#  define MEM_SIZE(mem) __atomic_load_n(&(mem)->size, __ATOMIC_ACQUIRE)\n"
+"#  define MEM_PAGES(mem) __atomic_load_n(&(mem)->pages, __ATOMIC_ACQUIRE)\n"
+"#else\n"
+"#  define MEM_SIZE(mem) ((mem)->size)\n"
+"#  define MEM_PAGES(mem) ((mem)->pages)\n"
 "#endif\n"
 "\n"
 "#ifdef WASM_USE_GUARD_PAGES\n"
-"#  define MEMCHECK(mem, a, t)\n"
+"#  define MEMCHECK(mem_size, a, t) (void)(mem_size)\n"
 "#else\n"
-"#  define MEMCHECK(mem, a, t) if (UNLIKELY((a) + sizeof(t) > mem->size)) { (void) TRAP(OOB); }\n"
+"#  define MEMCHECK(mem_size, a, t) if (UNLIKELY((a) + sizeof(t) > (mem_size))) { (void) TRAP(OOB); }\n"
 "#endif\n"
 "\n"
 "#if defined(WASM_USE_GUARD_PAGES) && UINTPTR_MAX == 0xffffffff\n"
 "// on 32-bit platforms we have to mask memory access into range\n"
-"#  define MEM_ACCESS_REF(mem, addr) &mem->data[addr & mem->mem_mask]\n"
+"#  define MEM_ACCESS_REF(mem, mem_data, addr) &(mem_data)[addr & mem->mem_mask]\n"
 "#else\n"
-"#  define MEM_ACCESS_REF(mem, addr) &mem->data[addr]\n"
+"#  define MEM_ACCESS_REF(mem, mem_data, addr) &(mem_data)[addr]\n"
 "#endif\n"
 "\n"
 "#if defined(WASM_USING_GLOBAL_HEAP)\n"
 "#  undef MEM_ACCESS_REF\n"
-"#  define MEM_ACCESS_REF(mem, addr) (char*) addr\n"
+"#  define MEM_ACCESS_REF(mem, mem_data, addr) (char*) addr\n"
 "#endif\n"
 "\n"
+"// Each load and store has two forms. The plain form reads the base and size of\n"
+"// the linear memory through `mem`. The `_cached` form takes them as arguments,\n"
+"// so that functions can keep them in locals: the compiler must otherwise\n"
+"// assume that any store into linear memory may have modified `mem`, and reload\n"
+"// the base pointer on every access.\n"
+"//\n"
+"// Both forms also have an `_unchecked` variant without the MEMCHECK, which\n"
+"// wasm2c uses for the accesses it has proven to be in bounds.\n"
 "#if WABT_BIG_ENDIAN\n"
 "static inline void load_data(void *dest, const void *src, size_t n) {\n"
 "  size_t i = 0;\n"
@@ -120,49 +226,107 @@ const char SECTION_NAME(declarations)[] =
 "}\n"
 "#define LOAD_DATA(m, o, i, s) { load_data(&(m.data[m.size - o - s]), i, s); \\\n"
 "  WASM2C_SHADOW_MEMORY_RESERVE(&m, m.size - o - s, s);                       \\\n"
-"  WASM2C_SHADOW_MEMORY_STORE(&m, \"GlobalDataLoad\", m.size - o - s, s);       \\\n"
+"  WASM2C_SHADOW_MEMORY_STORE(&m, WASM2C_SHADOW_FUNC_ALWAYS_CHECK,            \\\n"
+"                             \"GlobalDataLoad\", m.size - o - s, s);           \\\n"
 "}\n"
 "\n"
-"#define DEFINE_LOAD(name, t1, t2, t3)                                                      \\\n"
-"  static inline t3 name(wasm_rt_memory_t* mem, u64 addr, const char* func_name) {          \\\n"
-"    MEMCHECK(mem, addr, t1);                                                               \\\n"
-"    t1 result;                                                                             \\\n"
-"    memcpy(&result, MEM_ACCESS_REF(mem, mem->size - addr - sizeof(t1)), sizeof(t1));       \\\n"
-"    WASM2C_SHADOW_MEMORY_LOAD(mem, func_name, mem->size - addr - sizeof(t1), sizeof(t1));  \\\n"
-"    return (t3)(t2)result;                                                                 \\\n"
+"#define DEFINE_LOAD(name, t1, t2, t3)                                                                \\\n"
+"  static inline t3 name##_unchecked_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size,        \\\n"
+"                                           u64 addr, u32 shadow_class, const char* func_name) {      \\\n"
+"    t1 result;                                                                                       \\\n"
+"    memcpy(&result, MEM_ACCESS_REF(mem, mem_data, mem_size - addr - sizeof(t1)), sizeof(t1));        \\\n"
+"    WASM2C_SHADOW_MEMORY_LOAD(mem, shadow_class, func_name, mem_size - addr - sizeof(t1),            \\\n"
+"                              sizeof(t1));                                                           \\\n"
+"    return (t3)(t2)result;                                                                           \\\n"
+"  }                                                                                                  \\\n"
+"  static inline t3 name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,        \\\n"
+"                                 u32 shadow_class, const char* func_name) {                          \\\n"
+"    MEMCHECK(mem_size, addr, t1);                                                                    \\\n"
+"    return name##_unchecked_cached(mem, mem_data, mem_size, addr, shadow_class, func_name);          \\\n"
+"  }                                                                                                  \\\n"
+"  static inline t3 name##_unchecked(wasm_rt_memory_t* mem, u64 addr, u32 shadow_class,               \\\n"
+"                                    const char* func_name) {                                         \\\n"
+"    return name##_unchecked_cached(mem, mem->data, MEM_SIZE(mem), addr, shadow_class, func_name);    \\\n"
+"  }                                                                                                  \\\n"
+"  static inline t3 name(wasm_rt_memory_t* mem, u64 addr, u32 shadow_class, const char* func_name) {  \\\n"
+"    return name##_cached(mem, mem->data, MEM_SIZE(mem), addr, shadow_class, func_name);              \\\n"
 "  }\n"
 "\n"
-"#define DEFINE_STORE(name, t1, t2)                                                            \\\n"
-"  static inline void name(wasm_rt_memory_t* mem, u64 addr, t2 value, const char* func_name) { \\\n"
-"    MEMCHECK(mem, addr, t1);                                                                  \\\n"
-"    t1 wrapped = (t1)value;                                                                   \\\n"
-"    memcpy(MEM_ACCESS_REF(mem, mem->size - addr - sizeof(t1), &wrapped, sizeof(t1));          \\\n"
-"    WASM2C_SHADOW_MEMORY_STORE(mem, func_name, mem->size - addr - sizeof(t1)), sizeof(t1));   \\\n"
+"#define DEFINE_STORE(name, t1, t2)                                                                   \\\n"
+"  static inline void name##_unchecked_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size,      \\\n"
+"                                             u64 addr, t2 value, u32 shadow_class,                   \\\n"
+"                                             const char* func_name) {                                \\\n"
+"    t1 wrapped = (t1)value;                                                                          \\\n"
+"    memcpy(MEM_ACCESS_REF(mem, mem_data, mem_size - addr - sizeof(t1)), &wrapped, sizeof(t1));       \\\n"
+"    WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, mem_size - addr - sizeof(t1),           \\\n"
+"                               sizeof(t1));                                                          \\\n"
+"  }                                                                                                  \\\n"
+"  static inline void name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,      \\\n"
+"                                   t2 value, u32 shadow_class, const char* func_name) {              \\\n"
+"    MEMCHECK(mem_size, addr, t1);                                                                    \\\n"
+"    name##_unchecked_cached(mem, mem_data, mem_size, addr, value, shadow_class, func_name);          \\\n"
+"  }                                                                                                  \\\n"
+"  static inline void name##_unchecked(wasm_rt_memory_t* mem, u64 addr, t2 value, u32 shadow_class,   \\\n"
+"                                      const char* func_name) {                                       \\\n"
+"    name##_unchecked_cached(mem, mem->data, MEM_SIZE(mem), addr, value, shadow_class, func_name);    \\\n"
+"  }                                                                                                  \\\n"
+"  static inline void name(wasm_rt_memory_t* mem, u64 addr, t2 value, u32 shadow_class,               \\\n"
+"                          const char* func_name) {                                                   \\\n"
+"    name##_cached(mem, mem->data, MEM_SIZE(mem), addr, value, shadow_class, func_name);              \\\n"
 "  }\n"
 "#else\n"
 "static inline void load_data(void *dest, const void *src, size_t n) {\n"
 "  memcpy(dest, src, n);\n"
 "}\n"
-"#define LOAD_DATA(m, o, i, s) { load_data(&(m.data[o]), i, s); \\\n"
-"  WASM2C_SHADOW_MEMORY_RESERVE(&m, o, s);                       \\\n"
-"  WASM2C_SHADOW_MEMORY_STORE(&m, \"GlobalDataLoad\", o, s);       \\\n"
+"#define LOAD_DATA(m, o, i, s) { load_data(&(m.data[o]), i, s);          \\\n"
+"  WASM2C_SHADOW_MEMORY_RESERVE(&m, o, s);                                \\\n"
+"  WASM2C_SHADOW_MEMORY_STORE(&m, WASM2C_SHADOW_FUNC_ALWAYS_CHECK,        \\\n"
+"                             \"GlobalDataLoad\", o, s);                    \\\n"
 "}\n"
 "\n"
-"#define DEFINE_LOAD(name, t1, t2, t3)                                               \\\n"
-"  static inline t3 name(wasm_rt_memory_t* mem, u64 addr, const char* func_name) {   \\\n"
-"    MEMCHECK(mem, addr, t1);                                                        \\\n"
-"    t1 result;                                                                      \\\n"
-"    memcpy(&result, MEM_ACCESS_REF(mem, addr), sizeof(t1));                         \\\n"
-"    WASM2C_SHADOW_MEMORY_LOAD(mem, func_name, addr, sizeof(t1));                    \\\n"
-"    return (t3)(t2)result;                                                          \\\n"
+"#define DEFINE_LOAD(name, t1, t2, t3)                                                                \\\n"
+"  static inline t3 name##_unchecked_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size,        \\\n"
+"                                           u64 addr, u32 shadow_class, const char* func_name) {      \\\n"
+"    t1 result;                                                                                       \\\n"
+"    (void)mem_size;                                                                                  \\\n"
+"    memcpy(&result, MEM_ACCESS_REF(mem, mem_data, addr), sizeof(t1));                                \\\n"
+"    WASM2C_SHADOW_MEMORY_LOAD(mem, shadow_class, func_name, addr, sizeof(t1));                       \\\n"
+"    return (t3)(t2)result;                                                                           \\\n"
+"  }                                                                                                  \\\n"
+"  static inline t3 name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,        \\\n"
+"                                 u32 shadow_class, const char* func_name) {                          \\\n"
+"    MEMCHECK(mem_size, addr, t1);                                                                    \\\n"
+"    return name##_unchecked_cached(mem, mem_data, mem_size, addr, shadow_class, func_name);          \\\n"
+"  }                                                                                                  \\\n"
+"  static inline t3 name##_unchecked(wasm_rt_memory_t* mem, u64 addr, u32 shadow_class,               \\\n"
+"                                    const char* func_name) {                                         \\\n"
+"    return name##_unchecked_cached(mem, mem->data, MEM_SIZE(mem), addr, shadow_class, func_name);    \\\n"
+"  }                                                                                                  \\\n"
+"  static inline t3 name(wasm_rt_memory_t* mem, u64 addr, u32 shadow_class, const char* func_name) {  \\\n"
+"    return name##_cached(mem, mem->data, MEM_SIZE(mem), addr, shadow_class, func_name);              \\\n"
 "  }\n"
 "\n"
-"#define DEFINE_STORE(name, t1, t2)                                                            \\\n"
-"  static inline void name(wasm_rt_memory_t* mem, u64 addr, t2 value, const char* func_name) { \\\n"
-"    MEMCHECK(mem, addr, t1);                                                                  \\\n"
-"    t1 wrapped = (t1)value;                                                                   \\\n"
-"    memcpy(MEM_ACCESS_REF(mem, addr), &wrapped, sizeof(t1));                                  \\\n"
-"    WASM2C_SHADOW_MEMORY_STORE(mem, func_name, addr, sizeof(t1));                             \\\n"
+"#define DEFINE_STORE(name, t1, t2)                                                                   \\\n"
+"  static inline void name##_unchecked_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size,      \\\n"
+"                                             u64 addr, t2 value, u32 shadow_class,                   \\\n"
+"                                             const char* func_name) {                                \\\n"
+"    t1 wrapped = (t1)value;                                                                          \\\n"
+"    (void)mem_size;                                                                                  \\\n"
+"    memcpy(MEM_ACCESS_REF(mem, mem_data, addr), &wrapped, sizeof(t1));                               \\\n"
+"    WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, addr, sizeof(t1));                      \\\n"
+"  }                                                                                                  \\\n"
+"  static inline void name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,      \\\n"
+"                                   t2 value, u32 shadow_class, const char* func_name) {              \\\n"
+"    MEMCHECK(mem_size, addr, t1);                                                                    \\\n"
+"    name##_unchecked_cached(mem, mem_data, mem_size, addr, value, shadow_class, func_name);          \\\n"
+"  }                                                                                                  \\\n"
+"  static inline void name##_unchecked(wasm_rt_memory_t* mem, u64 addr, t2 value, u32 shadow_class,   \\\n"
+"                                      const char* func_name) {                                       \\\n"
+"    name##_unchecked_cached(mem, mem->data, MEM_SIZE(mem), addr, value, shadow_class, func_name);    \\\n"
+"  }                                                                                                  \\\n"
+"  static inline void name(wasm_rt_memory_t* mem, u64 addr, t2 value, u32 shadow_class,               \\\n"
+"                          const char* func_name) {                                                   \\\n"
+"    name##_cached(mem, mem->data, MEM_SIZE(mem), addr, value, shadow_class, func_name);              \\\n"
 "  }\n"
 "#endif\n"
 "\n"
@@ -190,6 +354,34 @@ const char SECTION_NAME(declarations)[] =
 "DEFINE_STORE(i64_store16, u16, u64);\n"
 "DEFINE_STORE(i64_store32, u32, u64);\n"
 "\n"
+"// The bulk memory operations are bounds checked and done with memmove/memset\n"
+"// by the runtime. The shadow memory is checked once for the whole range.\n"
+"static inline void memory_copy(wasm_rt_memory_t* mem, u32 dest, u32 src, u32 n,\n"
+"                               u32 shadow_class, const char* func_name) {\n"
+"  wasm_rt_memory_copy(mem, dest, src, n);\n"
+"  if (n != 0) {\n"
+"    WASM2C_SHADOW_MEMORY_LOAD(mem, shadow_class, func_name, src, n);\n"
+"    WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, dest, n);\n"
+"  }\n"
+"}\n"
+"\n"
+"static inline void memory_fill(wasm_rt_memory_t* mem, u32 dest, u32 value, u32 n,\n"
+"                               u32 shadow_class, const char* func_name) {\n"
+"  wasm_rt_memory_fill(mem, dest, value, n);\n"
+"  if (n != 0) {\n"
+"    WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, dest, n);\n"
+"  }\n"
+"}\n"
+"\n"
+"static inline void memory_init(wasm_rt_memory_t* mem, u32 dest, u32 src, u32 n,\n"
+"                               const u8* data, u32 data_size,\n"
+"                               u32 shadow_class, const char* func_name) {\n"
+"  wasm_rt_memory_init(mem, dest, data, data_size, src, n);\n"
+"  if (n != 0) {\n"
+"    WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, dest, n);\n"
+"  }\n"
+"}\n"
+"\n"
 "#if defined(_MSC_VER)\n"
 "#include <intrin.h>\n"
 "\n"
@@ -366,31 +558,853 @@ const char SECTION_NAME(declarations)[] =
 "DEFINE_REINTERPRET(i64_reinterpret_f64, f64, u64)\n"
 ;
 
+const char SECTION_NAME(simd)[] =
+"\n"
+"// v128 support. Every wasm SIMD instruction `xxx.yyy` is lowered to a call to\n"
+"// `simd_xxx_yyy`. The operations are written with GCC/Clang vector\n"
+"// extensions, so a C compiler for any target can build them; on x86-64 the\n"
+"// ones that the compiler cannot reliably pattern-match use SSE4.1 intrinsics\n"
+"// instead. Define WASM_SIMD_NO_INTRINSICS to force the portable versions.\n"
+"#if defined(__SSE4_1__) && !defined(WASM_SIMD_NO_INTRINSICS)\n"
+"#  include <smmintrin.h>\n"
+"#  define WASM_SIMD_USE_SSE4_1\n"
+"#endif\n"
+"\n"
+"typedef s8 simd_s8x16 __attribute__((vector_size(16)));\n"
+"typedef u8 simd_u8x16 __attribute__((vector_size(16)));\n"
+"typedef s16 simd_s16x8 __attribute__((vector_size(16)));\n"
+"typedef u16 simd_u16x8 __attribute__((vector_size(16)));\n"
+"typedef s32 simd_s32x4 __attribute__((vector_size(16)));\n"
+"typedef u32 simd_u32x4 __attribute__((vector_size(16)));\n"
+"typedef s64 simd_s64x2 __attribute__((vector_size(16)));\n"
+"typedef u64 simd_u64x2 __attribute__((vector_size(16)));\n"
+"typedef f32 simd_f32x4 __attribute__((vector_size(16)));\n"
+"typedef f64 simd_f64x2 __attribute__((vector_size(16)));\n"
+"\n"
+"#define SIMD_SAT(x, min, max) ((x) < (min) ? (min) : (x) > (max) ? (max) : (x))\n"
+"\n"
+"static inline v128 simd_v128_const(u64 lo, u64 hi) {\n"
+"  return (v128)(simd_u64x2){lo, hi};\n"
+"}\n"
+"\n"
+"static inline v128 simd_v128_bitselect(v128 a, v128 b, v128 c) {\n"
+"  return (a & c) | (b & ~c);\n"
+"}\n"
+"\n"
+"static inline v128 simd_v128_not(v128 a) { return ~a; }\n"
+"static inline v128 simd_v128_and(v128 a, v128 b) { return a & b; }\n"
+"static inline v128 simd_v128_andnot(v128 a, v128 b) { return a & ~b; }\n"
+"static inline v128 simd_v128_or(v128 a, v128 b) { return a | b; }\n"
+"static inline v128 simd_v128_xor(v128 a, v128 b) { return a ^ b; }\n"
+"\n"
+"static inline u32 simd_v128_any_true(v128 a) {\n"
+"#ifdef WASM_SIMD_USE_SSE4_1\n"
+"  return !_mm_testz_si128((__m128i)a, (__m128i)a);\n"
+"#else\n"
+"  return (((simd_u64x2)a)[0] | ((simd_u64x2)a)[1]) != 0;\n"
+"#endif\n"
+"}\n"
+"\n"
+"#define SIMD_SPLAT(name, vt, lt, t) \\\n"
+"  static inline v128 simd_##name(t x) { return (v128)((vt){0} + (lt)x); }\n"
+"\n"
+"SIMD_SPLAT(i8x16_splat, simd_u8x16, u8, u32)\n"
+"SIMD_SPLAT(i16x8_splat, simd_u16x8, u16, u32)\n"
+"SIMD_SPLAT(i32x4_splat, simd_u32x4, u32, u32)\n"
+"SIMD_SPLAT(i64x2_splat, simd_u64x2, u64, u64)\n"
+"\n"
+"// Not `0 + x`, which would lose the sign of -0 and the payload of NaNs.\n"
+"static inline v128 simd_f32x4_splat(f32 x) { return (v128)(simd_f32x4){x, x, x, x}; }\n"
+"static inline v128 simd_f64x2_splat(f64 x) { return (v128)(simd_f64x2){x, x}; }\n"
+"\n"
+"#define SIMD_EXTRACT_LANE(name, vt, t) \\\n"
+"  static inline t simd_##name(v128 a, int lane) { return (t)((vt)a)[lane]; }\n"
+"\n"
+"SIMD_EXTRACT_LANE(i8x16_extract_lane_s, simd_s8x16, u32)\n"
+"SIMD_EXTRACT_LANE(i8x16_extract_lane_u, simd_u8x16, u32)\n"
+"SIMD_EXTRACT_LANE(i16x8_extract_lane_s, simd_s16x8, u32)\n"
+"SIMD_EXTRACT_LANE(i16x8_extract_lane_u, simd_u16x8, u32)\n"
+"SIMD_EXTRACT_LANE(i32x4_extract_lane, simd_u32x4, u32)\n"
+"SIMD_EXTRACT_LANE(i64x2_extract_lane, simd_u64x2, u64)\n"
+"SIMD_EXTRACT_LANE(f32x4_extract_lane, simd_f32x4, f32)\n"
+"SIMD_EXTRACT_LANE(f64x2_extract_lane, simd_f64x2, f64)\n"
+"\n"
+"#define SIMD_REPLACE_LANE(name, vt, lt, t)                  \\\n"
+"  static inline v128 simd_##name(v128 a, int lane, t x) {   \\\n"
+"    vt result = (vt)a;                                      \\\n"
+"    result[lane] = (lt)x;                                   \\\n"
+"    return (v128)result;                                    \\\n"
+"  }\n"
+"\n"
+"SIMD_REPLACE_LANE(i8x16_replace_lane, simd_u8x16, u8, u32)\n"
+"SIMD_REPLACE_LANE(i16x8_replace_lane, simd_u16x8, u16, u32)\n"
+"SIMD_REPLACE_LANE(i32x4_replace_lane, simd_u32x4, u32, u32)\n"
+"SIMD_REPLACE_LANE(i64x2_replace_lane, simd_u64x2, u64, u64)\n"
+"SIMD_REPLACE_LANE(f32x4_replace_lane, simd_f32x4, f32, f32)\n"
+"SIMD_REPLACE_LANE(f64x2_replace_lane, simd_f64x2, f64, f64)\n"
+"\n"
+"// The shuffle indices must be constants, so this is a macro. It evaluates each\n"
+"// operand exactly once.\n"
+"#if defined(__clang__) || __GNUC__ >= 12\n"
+"#  define SIMD_I8X16_SHUFFLE(a, b, ...) \\\n"
+"     ((v128)__builtin_shufflevector((simd_u8x16)(a), (simd_u8x16)(b), __VA_ARGS__))\n"
+"#else\n"
+"#  define SIMD_I8X16_SHUFFLE(a, b, ...) \\\n"
+"     ((v128)__builtin_shuffle((simd_u8x16)(a), (simd_u8x16)(b), (simd_u8x16){__VA_ARGS__}))\n"
+"#endif\n"
+"\n"
+"#define SIMD_UNOP(name, vt, op) \\\n"
+"  static inline v128 simd_##name(v128 a) { return (v128)(op(vt)a); }\n"
+"\n"
+"#define SIMD_BINOP(name, vt, op) \\\n"
+"  static inline v128 simd_##name(v128 a, v128 b) { return (v128)((vt)a op (vt)b); }\n"
+"\n"
+"// Vector comparisons yield all-ones or all-zeroes lanes, as wasm requires.\n"
+"SIMD_BINOP(i8x16_eq, simd_u8x16, ==)\n"
+"SIMD_BINOP(i8x16_ne, simd_u8x16, !=)\n"
+"SIMD_BINOP(i8x16_lt_s, simd_s8x16, <)\n"
+"SIMD_BINOP(i8x16_lt_u, simd_u8x16, <)\n"
+"SIMD_BINOP(i8x16_gt_s, simd_s8x16, >)\n"
+"SIMD_BINOP(i8x16_gt_u, simd_u8x16, >)\n"
+"SIMD_BINOP(i8x16_le_s, simd_s8x16, <=)\n"
+"SIMD_BINOP(i8x16_le_u, simd_u8x16, <=)\n"
+"SIMD_BINOP(i8x16_ge_s, simd_s8x16, >=)\n"
+"SIMD_BINOP(i8x16_ge_u, simd_u8x16, >=)\n"
+"SIMD_BINOP(i16x8_eq, simd_u16x8, ==)\n"
+"SIMD_BINOP(i16x8_ne, simd_u16x8, !=)\n"
+"SIMD_BINOP(i16x8_lt_s, simd_s16x8, <)\n"
+"SIMD_BINOP(i16x8_lt_u, simd_u16x8, <)\n"
+"SIMD_BINOP(i16x8_gt_s, simd_s16x8, >)\n"
+"SIMD_BINOP(i16x8_gt_u, simd_u16x8, >)\n"
+"SIMD_BINOP(i16x8_le_s, simd_s16x8, <=)\n"
+"SIMD_BINOP(i16x8_le_u, simd_u16x8, <=)\n"
+"SIMD_BINOP(i16x8_ge_s, simd_s16x8, >=)\n"
+"SIMD_BINOP(i16x8_ge_u, simd_u16x8, >=)\n"
+"SIMD_BINOP(i32x4_eq, simd_u32x4, ==)\n"
+"SIMD_BINOP(i32x4_ne, simd_u32x4, !=)\n"
+"SIMD_BINOP(i32x4_lt_s, simd_s32x4, <)\n"
+"SIMD_BINOP(i32x4_lt_u, simd_u32x4, <)\n"
+"SIMD_BINOP(i32x4_gt_s, simd_s32x4, >)\n"
+"SIMD_BINOP(i32x4_gt_u, simd_u32x4, >)\n"
+"SIMD_BINOP(i32x4_le_s, simd_s32x4, <=)\n"
+"SIMD_BINOP(i32x4_le_u, simd_u32x4, <=)\n"
+"SIMD_BINOP(i32x4_ge_s, simd_s32x4, >=)\n"
+"SIMD_BINOP(i32x4_ge_u, simd_u32x4, >=)\n"
+"SIMD_BINOP(i64x2_eq, simd_u64x2, ==)\n"
+"SIMD_BINOP(i64x2_ne, simd_u64x2, !=)\n"
+"SIMD_BINOP(i64x2_lt_s, simd_s64x2, <)\n"
+"SIMD_BINOP(i64x2_gt_s, simd_s64x2, >)\n"
+"SIMD_BINOP(i64x2_le_s, simd_s64x2, <=)\n"
+"SIMD_BINOP(i64x2_ge_s, simd_s64x2, >=)\n"
+"SIMD_BINOP(f32x4_eq, simd_f32x4, ==)\n"
+"SIMD_BINOP(f32x4_ne, simd_f32x4, !=)\n"
+"SIMD_BINOP(f32x4_lt, simd_f32x4, <)\n"
+"SIMD_BINOP(f32x4_gt, simd_f32x4, >)\n"
+"SIMD_BINOP(f32x4_le, simd_f32x4, <=)\n"
+"SIMD_BINOP(f32x4_ge, simd_f32x4, >=)\n"
+"SIMD_BINOP(f64x2_eq, simd_f64x2, ==)\n"
+"SIMD_BINOP(f64x2_ne, simd_f64x2, !=)\n"
+"SIMD_BINOP(f64x2_lt, simd_f64x2, <)\n"
+"SIMD_BINOP(f64x2_gt, simd_f64x2, >)\n"
+"SIMD_BINOP(f64x2_le, simd_f64x2, <=)\n"
+"SIMD_BINOP(f64x2_ge, simd_f64x2, >=)\n"
+"\n"
+"// Integer arithmetic is done on unsigned lanes, so that it wraps.\n"
+"SIMD_BINOP(i8x16_add, simd_u8x16, +)\n"
+"SIMD_BINOP(i8x16_sub, simd_u8x16, -)\n"
+"SIMD_BINOP(i16x8_add, simd_u16x8, +)\n"
+"SIMD_BINOP(i16x8_sub, simd_u16x8, -)\n"
+"SIMD_BINOP(i16x8_mul, simd_u16x8, *)\n"
+"SIMD_BINOP(i32x4_add, simd_u32x4, +)\n"
+"SIMD_BINOP(i32x4_sub, simd_u32x4, -)\n"
+"SIMD_BINOP(i32x4_mul, simd_u32x4, *)\n"
+"SIMD_BINOP(i64x2_add, simd_u64x2, +)\n"
+"SIMD_BINOP(i64x2_sub, simd_u64x2, -)\n"
+"SIMD_BINOP(i64x2_mul, simd_u64x2, *)\n"
+"SIMD_UNOP(i8x16_neg, simd_u8x16, -)\n"
+"SIMD_UNOP(i16x8_neg, simd_u16x8, -)\n"
+"SIMD_UNOP(i32x4_neg, simd_u32x4, -)\n"
+"SIMD_UNOP(i64x2_neg, simd_u64x2, -)\n"
+"\n"
+"SIMD_BINOP(f32x4_add, simd_f32x4, +)\n"
+"SIMD_BINOP(f32x4_sub, simd_f32x4, -)\n"
+"SIMD_BINOP(f32x4_mul, simd_f32x4, *)\n"
+"SIMD_BINOP(f32x4_div, simd_f32x4, /)\n"
+"SIMD_BINOP(f64x2_add, simd_f64x2, +)\n"
+"SIMD_BINOP(f64x2_sub, simd_f64x2, -)\n"
+"SIMD_BINOP(f64x2_mul, simd_f64x2, *)\n"
+"SIMD_BINOP(f64x2_div, simd_f64x2, /)\n"
+"\n"
+"#define SIMD_SIGN_OP(name, vt, op, mask) \\\n"
+"  static inline v128 simd_##name(v128 a) { return (v128)((vt)a op mask); }\n"
+"\n"
+"SIMD_SIGN_OP(f32x4_abs, simd_u32x4, &, 0x7fffffffu)\n"
+"SIMD_SIGN_OP(f32x4_neg, simd_u32x4, ^, 0x80000000u)\n"
+"SIMD_SIGN_OP(f64x2_abs, simd_u64x2, &, 0x7fffffffffffffffull)\n"
+"SIMD_SIGN_OP(f64x2_neg, simd_u64x2, ^, 0x8000000000000000ull)\n"
+"\n"
+"// abs(x) == (x ^ m) - m, where m is all-ones for negative lanes.\n"
+"#define SIMD_ABS(name, vt, svt, bits)                              \\\n"
+"  static inline v128 simd_##name(v128 a) {                         \\\n"
+"    vt mask = (vt)((svt)a >> (bits - 1));                          \\\n"
+"    return (v128)(((vt)a ^ mask) - mask);                          \\\n"
+"  }\n"
+"\n"
+"SIMD_ABS(i64x2_abs, simd_u64x2, simd_s64x2, 64)\n"
+"\n"
+"#define SIMD_SHIFT(name, vt, op, bits) \\\n"
+"  static inline v128 simd_##name(v128 a, u32 count) { return (v128)((vt)a op (int)(count & (bits - 1))); }\n"
+"\n"
+"SIMD_SHIFT(i8x16_shl, simd_u8x16, <<, 8)\n"
+"SIMD_SHIFT(i8x16_shr_s, simd_s8x16, >>, 8)\n"
+"SIMD_SHIFT(i8x16_shr_u, simd_u8x16, >>, 8)\n"
+"SIMD_SHIFT(i16x8_shl, simd_u16x8, <<, 16)\n"
+"SIMD_SHIFT(i16x8_shr_s, simd_s16x8, >>, 16)\n"
+"SIMD_SHIFT(i16x8_shr_u, simd_u16x8, >>, 16)\n"
+"SIMD_SHIFT(i32x4_shl, simd_u32x4, <<, 32)\n"
+"SIMD_SHIFT(i32x4_shr_s, simd_s32x4, >>, 32)\n"
+"SIMD_SHIFT(i32x4_shr_u, simd_u32x4, >>, 32)\n"
+"SIMD_SHIFT(i64x2_shl, simd_u64x2, <<, 64)\n"
+"SIMD_SHIFT(i64x2_shr_s, simd_s64x2, >>, 64)\n"
+"SIMD_SHIFT(i64x2_shr_u, simd_u64x2, >>, 64)\n"
+"\n"
+"#define SIMD_ALL_TRUE(name, vt) \\\n"
+"  static inline u32 simd_##name(v128 a) { return !simd_v128_any_true((v128)((vt)a == 0)); }\n"
+"\n"
+"SIMD_ALL_TRUE(i8x16_all_true, simd_u8x16)\n"
+"SIMD_ALL_TRUE(i16x8_all_true, simd_u16x8)\n"
+"SIMD_ALL_TRUE(i32x4_all_true, simd_u32x4)\n"
+"SIMD_ALL_TRUE(i64x2_all_true, simd_u64x2)\n"
+"\n"
+"#define SIMD_PMIN_PMAX(name, vt, op) \\\n"
+"  static inline v128 simd_##name(v128 a, v128 b) { return simd_v128_bitselect(b, a, (v128)((vt)b op (vt)a)); }\n"
+"\n"
+"#define SIMD_LANEWISE_UNOP(name, vt, rvt, n, expr) \\\n"
+"  static inline v128 simd_##name(v128 a) {         \\\n"
+"    vt x = (vt)a;                                  \\\n"
+"    rvt result;                                    \\\n"
+"    for (int i = 0; i < n; ++i) {                  \\\n"
+"      result[i] = expr;                            \\\n"
+"    }                                              \\\n"
+"    return (v128)result;                           \\\n"
+"  }\n"
+"\n"
+"#define SIMD_LANEWISE_BINOP(name, vt, rvt, n, expr) \\\n"
+"  static inline v128 simd_##name(v128 a, v128 b) {  \\\n"
+"    vt x = (vt)a, y = (vt)b;                        \\\n"
+"    rvt result;                                     \\\n"
+"    for (int i = 0; i < n; ++i) {                   \\\n"
+"      result[i] = expr;                             \\\n"
+"    }                                               \\\n"
+"    return (v128)result;                            \\\n"
+"  }\n"
+"\n"
+"SIMD_LANEWISE_UNOP(f32x4_convert_i32x4_u, simd_u32x4, simd_f32x4, 4, (f32)x[i])\n"
+"SIMD_LANEWISE_UNOP(i32x4_trunc_sat_f32x4_u, simd_f32x4, simd_u32x4, 4, I32_TRUNC_SAT_U_F32(x[i]))\n"
+"SIMD_LANEWISE_UNOP(i32x4_trunc_sat_f64x2_s_zero, simd_f64x2, simd_u32x4, 4,\n"
+"                   i < 2 ? I32_TRUNC_SAT_S_F64(x[i]) : 0)\n"
+"SIMD_LANEWISE_UNOP(i32x4_trunc_sat_f64x2_u_zero, simd_f64x2, simd_u32x4, 4,\n"
+"                   i < 2 ? I32_TRUNC_SAT_U_F64(x[i]) : 0)\n"
+"SIMD_LANEWISE_UNOP(f64x2_convert_low_i32x4_u, simd_u32x4, simd_f64x2, 2, (f64)x[i])\n"
+"\n"
+"#ifdef WASM_SIMD_USE_SSE4_1\n"
+"\n"
+"#define SIMD_SSE_UNOP(name, f) \\\n"
+"  static inline v128 simd_##name(v128 a) { return (v128)f((__m128i)a); }\n"
+"#define SIMD_SSE_BINOP(name, f) \\\n"
+"  static inline v128 simd_##name(v128 a, v128 b) { return (v128)f((__m128i)a, (__m128i)b); }\n"
+"#define SIMD_SSE_UNOP_PS(name, f) \\\n"
+"  static inline v128 simd_##name(v128 a) { return (v128)f((__m128)a); }\n"
+"#define SIMD_SSE_UNOP_PD(name, f) \\\n"
+"  static inline v128 simd_##name(v128 a) { return (v128)f((__m128d)a); }\n"
+"\n"
+"SIMD_SSE_UNOP(i8x16_abs, _mm_abs_epi8)\n"
+"SIMD_SSE_UNOP(i16x8_abs, _mm_abs_epi16)\n"
+"SIMD_SSE_UNOP(i32x4_abs, _mm_abs_epi32)\n"
+"\n"
+"SIMD_SSE_BINOP(i8x16_add_sat_s, _mm_adds_epi8)\n"
+"SIMD_SSE_BINOP(i8x16_add_sat_u, _mm_adds_epu8)\n"
+"SIMD_SSE_BINOP(i8x16_sub_sat_s, _mm_subs_epi8)\n"
+"SIMD_SSE_BINOP(i8x16_sub_sat_u, _mm_subs_epu8)\n"
+"SIMD_SSE_BINOP(i16x8_add_sat_s, _mm_adds_epi16)\n"
+"SIMD_SSE_BINOP(i16x8_add_sat_u, _mm_adds_epu16)\n"
+"SIMD_SSE_BINOP(i16x8_sub_sat_s, _mm_subs_epi16)\n"
+"SIMD_SSE_BINOP(i16x8_sub_sat_u, _mm_subs_epu16)\n"
+"\n"
+"SIMD_SSE_BINOP(i8x16_min_s, _mm_min_epi8)\n"
+"SIMD_SSE_BINOP(i8x16_min_u, _mm_min_epu8)\n"
+"SIMD_SSE_BINOP(i8x16_max_s, _mm_max_epi8)\n"
+"SIMD_SSE_BINOP(i8x16_max_u, _mm_max_epu8)\n"
+"SIMD_SSE_BINOP(i16x8_min_s, _mm_min_epi16)\n"
+"SIMD_SSE_BINOP(i16x8_min_u, _mm_min_epu16)\n"
+"SIMD_SSE_BINOP(i16x8_max_s, _mm_max_epi16)\n"
+"SIMD_SSE_BINOP(i16x8_max_u, _mm_max_epu16)\n"
+"SIMD_SSE_BINOP(i32x4_min_s, _mm_min_epi32)\n"
+"SIMD_SSE_BINOP(i32x4_min_u, _mm_min_epu32)\n"
+"SIMD_SSE_BINOP(i32x4_max_s, _mm_max_epi32)\n"
+"SIMD_SSE_BINOP(i32x4_max_u, _mm_max_epu32)\n"
+"\n"
+"SIMD_SSE_BINOP(i8x16_avgr_u, _mm_avg_epu8)\n"
+"SIMD_SSE_BINOP(i16x8_avgr_u, _mm_avg_epu16)\n"
+"\n"
+"SIMD_SSE_BINOP(i8x16_narrow_i16x8_s, _mm_packs_epi16)\n"
+"SIMD_SSE_BINOP(i8x16_narrow_i16x8_u, _mm_packus_epi16)\n"
+"SIMD_SSE_BINOP(i16x8_narrow_i32x4_s, _mm_packs_epi32)\n"
+"SIMD_SSE_BINOP(i16x8_narrow_i32x4_u, _mm_packus_epi32)\n"
+"\n"
+"SIMD_SSE_BINOP(i32x4_dot_i16x8_s, _mm_madd_epi16)\n"
+"\n"
+"static inline __m128i simd_sse_high_half(__m128i a) {\n"
+"  return _mm_unpackhi_epi64(a, a);\n"
+"}\n"
+"\n"
+"#define SIMD_SSE_EXTEND(name_low, name_high, f)                                       \\\n"
+"  static inline v128 simd_##name_low(v128 a) { return (v128)f((__m128i)a); }          \\\n"
+"  static inline v128 simd_##name_high(v128 a) { return (v128)f(simd_sse_high_half((__m128i)a)); }\n"
+"\n"
+"SIMD_SSE_EXTEND(i16x8_extend_low_i8x16_s, i16x8_extend_high_i8x16_s, _mm_cvtepi8_epi16)\n"
+"SIMD_SSE_EXTEND(i16x8_extend_low_i8x16_u, i16x8_extend_high_i8x16_u, _mm_cvtepu8_epi16)\n"
+"SIMD_SSE_EXTEND(i32x4_extend_low_i16x8_s, i32x4_extend_high_i16x8_s, _mm_cvtepi16_epi32)\n"
+"SIMD_SSE_EXTEND(i32x4_extend_low_i16x8_u, i32x4_extend_high_i16x8_u, _mm_cvtepu16_epi32)\n"
+"SIMD_SSE_EXTEND(i64x2_extend_low_i32x4_s, i64x2_extend_high_i32x4_s, _mm_cvtepi32_epi64)\n"
+"SIMD_SSE_EXTEND(i64x2_extend_low_i32x4_u, i64x2_extend_high_i32x4_u, _mm_cvtepu32_epi64)\n"
+"\n"
+"static inline v128 simd_i16x8_extadd_pairwise_i8x16_s(v128 a) {\n"
+"  return (v128)_mm_maddubs_epi16(_mm_set1_epi8(1), (__m128i)a);\n"
+"}\n"
+"\n"
+"static inline v128 simd_i16x8_extadd_pairwise_i8x16_u(v128 a) {\n"
+"  return (v128)_mm_maddubs_epi16((__m128i)a, _mm_set1_epi8(1));\n"
+"}\n"
+"\n"
+"static inline v128 simd_i32x4_extadd_pairwise_i16x8_s(v128 a) {\n"
+"  return (v128)_mm_madd_epi16((__m128i)a, _mm_set1_epi16(1));\n"
+"}\n"
+"\n"
+"static inline v128 simd_i32x4_extadd_pairwise_i16x8_u(v128 a) {\n"
+"  // Bias the lanes into the signed range, then undo the bias of the pair.\n"
+"  __m128i biased = _mm_xor_si128((__m128i)a, _mm_set1_epi16(-0x8000));\n"
+"  return (v128)_mm_add_epi32(_mm_madd_epi16(biased, _mm_set1_epi16(1)),\n"
+"                             _mm_set1_epi32(0x10000));\n"
+"}\n"
+"\n"
+"static inline v128 simd_i16x8_q15mulr_sat_s(v128 a, v128 b) {\n"
+"  // pmulhrsw only differs from wasm for 0x8000 * 0x8000, where it yields\n"
+"  // 0x8000 rather than the saturated 0x7fff.\n"
+"  __m128i result = _mm_mulhrs_epi16((__m128i)a, (__m128i)b);\n"
+"  return (v128)_mm_xor_si128(result, _mm_cmpeq_epi16(result, _mm_set1_epi16(-0x8000)));\n"
+"}\n"
+"\n"
+"static inline v128 simd_i8x16_swizzle(v128 a, v128 s) {\n"
+"  // Indices above 15 get their top bit set, which makes pshufb write a zero.\n"
+"  return (v128)_mm_shuffle_epi8((__m128i)a, _mm_adds_epu8((__m128i)s, _mm_set1_epi8(0x70)));\n"
+"}\n"
+"\n"
+"static inline v128 simd_i8x16_popcnt(v128 a) {\n"
+"  const __m128i table = _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);\n"
+"  const __m128i mask = _mm_set1_epi8(0x0f);\n"
+"  __m128i low = _mm_and_si128((__m128i)a, mask);\n"
+"  __m128i high = _mm_and_si128(_mm_srli_epi16((__m128i)a, 4), mask);\n"
+"  return (v128)_mm_add_epi8(_mm_shuffle_epi8(table, low), _mm_shuffle_epi8(table, high));\n"
+"}\n"
+"\n"
+"static inline u32 simd_i8x16_bitmask(v128 a) {\n"
+"  return _mm_movemask_epi8((__m128i)a);\n"
+"}\n"
+"\n"
+"static inline u32 simd_i16x8_bitmask(v128 a) {\n"
+"  return _mm_movemask_epi8(_mm_packs_epi16((__m128i)a, _mm_setzero_si128()));\n"
+"}\n"
+"\n"
+"static inline u32 simd_i32x4_bitmask(v128 a) {\n"
+"  return _mm_movemask_ps((__m128)a);\n"
+"}\n"
+"\n"
+"static inline u32 simd_i64x2_bitmask(v128 a) {\n"
+"  return _mm_movemask_pd((__m128d)a);\n"
+"}\n"
+"\n"
+"#define SIMD_SSE_ROUND(name_ps, name_pd, mode)                                              \\\n"
+"  static inline v128 simd_##name_ps(v128 a) {                                               \\\n"
+"    return (v128)_mm_round_ps((__m128)a, mode | _MM_FROUND_NO_EXC);                         \\\n"
+"  }                                                                                         \\\n"
+"  static inline v128 simd_##name_pd(v128 a) {                                               \\\n"
+"    return (v128)_mm_round_pd((__m128d)a, mode | _MM_FROUND_NO_EXC);                        \\\n"
+"  }\n"
+"\n"
+"SIMD_SSE_ROUND(f32x4_ceil, f64x2_ceil, _MM_FROUND_TO_POS_INF)\n"
+"SIMD_SSE_ROUND(f32x4_floor, f64x2_floor, _MM_FROUND_TO_NEG_INF)\n"
+"SIMD_SSE_ROUND(f32x4_trunc, f64x2_trunc, _MM_FROUND_TO_ZERO)\n"
+"SIMD_SSE_ROUND(f32x4_nearest, f64x2_nearest, _MM_FROUND_TO_NEAREST_INT)\n"
+"SIMD_SSE_UNOP_PS(f32x4_sqrt, _mm_sqrt_ps)\n"
+"SIMD_SSE_UNOP_PD(f64x2_sqrt, _mm_sqrt_pd)\n"
+"\n"
+"// minps/maxps return their second operand when either is a NaN, and do not\n"
+"// order -0 and +0. Evaluate both operand orders and merge the results; any NaN\n"
+"// lane is then replaced by a canonical NaN.\n"
+"#define SIMD_SSE_FMIN(name, t, sfx, nan_shift)                                            \\\n"
+"  static inline v128 simd_##name(v128 a, v128 b) {                                        \\\n"
+"    t x = (t)a, y = (t)b;                                                                 \\\n"
+"    t result = _mm_or_##sfx(_mm_min_##sfx(y, x), _mm_min_##sfx(x, y));                    \\\n"
+"    t nan = _mm_cmpunord_##sfx(result, result);                                           \\\n"
+"    result = _mm_or_##sfx(result, nan);                                                   \\\n"
+"    return (v128)_mm_andnot_##sfx((t)nan_shift((__m128i)nan), result);                    \\\n"
+"  }\n"
+"\n"
+"#define SIMD_SSE_FMAX(name, t, sfx, nan_shift)                                            \\\n"
+"  static inline v128 simd_##name(v128 a, v128 b) {                                        \\\n"
+"    t x = (t)a, y = (t)b;                                                                 \\\n"
+"    t r1 = _mm_max_##sfx(y, x), r2 = _mm_max_##sfx(x, y);                                 \\\n"
+"    t diff = _mm_xor_##sfx(r1, r2);                                                       \\\n"
+"    t result = _mm_sub_##sfx(_mm_or_##sfx(r1, diff), diff);                               \\\n"
+"    t nan = _mm_cmpunord_##sfx(result, result);                                           \\\n"
+"    return (v128)_mm_andnot_##sfx((t)nan_shift((__m128i)nan), _mm_or_##sfx(result, nan)); \\\n"
+"  }\n"
+"\n"
+"#define SIMD_SSE_NAN_SHIFT_PS(x) _mm_srli_epi32(x, 10)\n"
+"#define SIMD_SSE_NAN_SHIFT_PD(x) _mm_srli_epi64(x, 13)\n"
+"\n"
+"SIMD_SSE_FMIN(f32x4_min, __m128, ps, SIMD_SSE_NAN_SHIFT_PS)\n"
+"SIMD_SSE_FMAX(f32x4_max, __m128, ps, SIMD_SSE_NAN_SHIFT_PS)\n"
+"SIMD_SSE_FMIN(f64x2_min, __m128d, pd, SIMD_SSE_NAN_SHIFT_PD)\n"
+"SIMD_SSE_FMAX(f64x2_max, __m128d, pd, SIMD_SSE_NAN_SHIFT_PD)\n"
+"\n"
+"// minps(b, a) is `b < a ? b : a`, which is exactly pmin.\n"
+"static inline v128 simd_f32x4_pmin(v128 a, v128 b) { return (v128)_mm_min_ps((__m128)b, (__m128)a); }\n"
+"static inline v128 simd_f32x4_pmax(v128 a, v128 b) { return (v128)_mm_max_ps((__m128)b, (__m128)a); }\n"
+"static inline v128 simd_f64x2_pmin(v128 a, v128 b) { return (v128)_mm_min_pd((__m128d)b, (__m128d)a); }\n"
+"static inline v128 simd_f64x2_pmax(v128 a, v128 b) { return (v128)_mm_max_pd((__m128d)b, (__m128d)a); }\n"
+"\n"
+"SIMD_SSE_UNOP(f32x4_convert_i32x4_s, _mm_cvtepi32_ps)\n"
+"SIMD_SSE_UNOP(f64x2_convert_low_i32x4_s, _mm_cvtepi32_pd)\n"
+"SIMD_SSE_UNOP_PD(f32x4_demote_f64x2_zero, _mm_cvtpd_ps)\n"
+"SIMD_SSE_UNOP_PS(f64x2_promote_low_f32x4, _mm_cvtps_pd)\n"
+"\n"
+"static inline v128 simd_i32x4_trunc_sat_f32x4_s(v128 a) {\n"
+"  // cvttps2dq yields 0x80000000 for NaN and out-of-range lanes. Zero the NaN\n"
+"  // lanes first, then flip the result of lanes that overflowed upwards.\n"
+"  __m128 x = _mm_and_ps((__m128)a, _mm_cmpeq_ps((__m128)a, (__m128)a));\n"
+"  __m128i overflow = (__m128i)_mm_cmpge_ps(x, _mm_set1_ps(2147483648.f));\n"
+"  return (v128)_mm_xor_si128(_mm_cvttps_epi32(x), overflow);\n"
+"}\n"
+"\n"
+"#else\n"
+"\n"
+"SIMD_ABS(i8x16_abs, simd_u8x16, simd_s8x16, 8)\n"
+"SIMD_ABS(i16x8_abs, simd_u16x8, simd_s16x8, 16)\n"
+"SIMD_ABS(i32x4_abs, simd_u32x4, simd_s32x4, 32)\n"
+"\n"
+"SIMD_LANEWISE_BINOP(i8x16_add_sat_s, simd_s8x16, simd_s8x16, 16, SIMD_SAT(x[i] + y[i], -128, 127))\n"
+"SIMD_LANEWISE_BINOP(i8x16_add_sat_u, simd_u8x16, simd_u8x16, 16, SIMD_SAT(x[i] + y[i], 0, 255))\n"
+"SIMD_LANEWISE_BINOP(i8x16_sub_sat_s, simd_s8x16, simd_s8x16, 16, SIMD_SAT(x[i] - y[i], -128, 127))\n"
+"SIMD_LANEWISE_BINOP(i8x16_sub_sat_u, simd_u8x16, simd_u8x16, 16, SIMD_SAT(x[i] - y[i], 0, 255))\n"
+"SIMD_LANEWISE_BINOP(i16x8_add_sat_s, simd_s16x8, simd_s16x8, 8, SIMD_SAT(x[i] + y[i], -32768, 32767))\n"
+"SIMD_LANEWISE_BINOP(i16x8_add_sat_u, simd_u16x8, simd_u16x8, 8, SIMD_SAT(x[i] + y[i], 0, 65535))\n"
+"SIMD_LANEWISE_BINOP(i16x8_sub_sat_s, simd_s16x8, simd_s16x8, 8, SIMD_SAT(x[i] - y[i], -32768, 32767))\n"
+"SIMD_LANEWISE_BINOP(i16x8_sub_sat_u, simd_u16x8, simd_u16x8, 8, SIMD_SAT(x[i] - y[i], 0, 65535))\n"
+"\n"
+"#define SIMD_MIN_MAX(name, vt, op) \\\n"
+"  static inline v128 simd_##name(v128 a, v128 b) { return simd_v128_bitselect(a, b, (v128)((vt)a op (vt)b)); }\n"
+"\n"
+"SIMD_MIN_MAX(i8x16_min_s, simd_s8x16, <)\n"
+"SIMD_MIN_MAX(i8x16_min_u, simd_u8x16, <)\n"
+"SIMD_MIN_MAX(i8x16_max_s, simd_s8x16, >)\n"
+"SIMD_MIN_MAX(i8x16_max_u, simd_u8x16, >)\n"
+"SIMD_MIN_MAX(i16x8_min_s, simd_s16x8, <)\n"
+"SIMD_MIN_MAX(i16x8_min_u, simd_u16x8, <)\n"
+"SIMD_MIN_MAX(i16x8_max_s, simd_s16x8, >)\n"
+"SIMD_MIN_MAX(i16x8_max_u, simd_u16x8, >)\n"
+"SIMD_MIN_MAX(i32x4_min_s, simd_s32x4, <)\n"
+"SIMD_MIN_MAX(i32x4_min_u, simd_u32x4, <)\n"
+"SIMD_MIN_MAX(i32x4_max_s, simd_s32x4, >)\n"
+"SIMD_MIN_MAX(i32x4_max_u, simd_u32x4, >)\n"
+"\n"
+"// (a + b + 1) / 2 without overflowing the lane.\n"
+"#define SIMD_AVGR(name, vt) \\\n"
+"  static inline v128 simd_##name(v128 a, v128 b) { return (v128)(((vt)a | (vt)b) - (((vt)a ^ (vt)b) >> 1)); }\n"
+"\n"
+"SIMD_AVGR(i8x16_avgr_u, simd_u8x16)\n"
+"SIMD_AVGR(i16x8_avgr_u, simd_u16x8)\n"
+"\n"
+"#define SIMD_NARROW(name, vt, rvt, n, min, max)       \\\n"
+"  static inline v128 simd_##name(v128 a, v128 b) {    \\\n"
+"    vt x = (vt)a, y = (vt)b;                          \\\n"
+"    rvt result;                                       \\\n"
+"    for (int i = 0; i < n; ++i) {                     \\\n"
+"      result[i] = SIMD_SAT(x[i], min, max);           \\\n"
+"      result[i + n] = SIMD_SAT(y[i], min, max);       \\\n"
+"    }                                                 \\\n"
+"    return (v128)result;                              \\\n"
+"  }\n"
+"\n"
+"SIMD_NARROW(i8x16_narrow_i16x8_s, simd_s16x8, simd_s8x16, 8, -128, 127)\n"
+"SIMD_NARROW(i8x16_narrow_i16x8_u, simd_s16x8, simd_u8x16, 8, 0, 255)\n"
+"SIMD_NARROW(i16x8_narrow_i32x4_s, simd_s32x4, simd_s16x8, 4, -32768, 32767)\n"
+"SIMD_NARROW(i16x8_narrow_i32x4_u, simd_s32x4, simd_u16x8, 4, 0, 65535)\n"
+"\n"
+"SIMD_LANEWISE_BINOP(i32x4_dot_i16x8_s, simd_s16x8, simd_u32x4, 4,\n"
+"                    (u32)(x[2 * i] * y[2 * i]) + (u32)(x[2 * i + 1] * y[2 * i + 1]))\n"
+"\n"
+"SIMD_LANEWISE_UNOP(i16x8_extend_low_i8x16_s, simd_s8x16, simd_s16x8, 8, x[i])\n"
+"SIMD_LANEWISE_UNOP(i16x8_extend_high_i8x16_s, simd_s8x16, simd_s16x8, 8, x[i + 8])\n"
+"SIMD_LANEWISE_UNOP(i16x8_extend_low_i8x16_u, simd_u8x16, simd_u16x8, 8, x[i])\n"
+"SIMD_LANEWISE_UNOP(i16x8_extend_high_i8x16_u, simd_u8x16, simd_u16x8, 8, x[i + 8])\n"
+"SIMD_LANEWISE_UNOP(i32x4_extend_low_i16x8_s, simd_s16x8, simd_s32x4, 4, x[i])\n"
+"SIMD_LANEWISE_UNOP(i32x4_extend_high_i16x8_s, simd_s16x8, simd_s32x4, 4, x[i + 4])\n"
+"SIMD_LANEWISE_UNOP(i32x4_extend_low_i16x8_u, simd_u16x8, simd_u32x4, 4, x[i])\n"
+"SIMD_LANEWISE_UNOP(i32x4_extend_high_i16x8_u, simd_u16x8, simd_u32x4, 4, x[i + 4])\n"
+"SIMD_LANEWISE_UNOP(i64x2_extend_low_i32x4_s, simd_s32x4, simd_s64x2, 2, x[i])\n"
+"SIMD_LANEWISE_UNOP(i64x2_extend_high_i32x4_s, simd_s32x4, simd_s64x2, 2, x[i + 2])\n"
+"SIMD_LANEWISE_UNOP(i64x2_extend_low_i32x4_u, simd_u32x4, simd_u64x2, 2, x[i])\n"
+"SIMD_LANEWISE_UNOP(i64x2_extend_high_i32x4_u, simd_u32x4, simd_u64x2, 2, x[i + 2])\n"
+"\n"
+"SIMD_LANEWISE_UNOP(i16x8_extadd_pairwise_i8x16_s, simd_s8x16, simd_s16x8, 8, x[2 * i] + x[2 * i + 1])\n"
+"SIMD_LANEWISE_UNOP(i16x8_extadd_pairwise_i8x16_u, simd_u8x16, simd_u16x8, 8, x[2 * i] + x[2 * i + 1])\n"
+"SIMD_LANEWISE_UNOP(i32x4_extadd_pairwise_i16x8_s, simd_s16x8, simd_s32x4, 4, x[2 * i] + x[2 * i + 1])\n"
+"SIMD_LANEWISE_UNOP(i32x4_extadd_pairwise_i16x8_u, simd_u16x8, simd_u32x4, 4, x[2 * i] + x[2 * i + 1])\n"
+"\n"
+"SIMD_LANEWISE_BINOP(i16x8_q15mulr_sat_s, simd_s16x8, simd_s16x8, 8,\n"
+"                    SIMD_SAT((x[i] * y[i] + 0x4000) >> 15, -32768, 32767))\n"
+"\n"
+"SIMD_LANEWISE_BINOP(i8x16_swizzle, simd_u8x16, simd_u8x16, 16, y[i] < 16 ? x[y[i]] : 0)\n"
+"\n"
+"static inline v128 simd_i8x16_popcnt(v128 a) {\n"
+"  simd_u8x16 x = (simd_u8x16)a;\n"
+"  x = x - ((x >> 1) & 0x55);\n"
+"  x = (x & 0x33) + ((x >> 2) & 0x33);\n"
+"  return (v128)((x + (x >> 4)) & 0x0f);\n"
+"}\n"
+"\n"
+"#define SIMD_BITMASK(name, vt, n, bits)                         \\\n"
+"  static inline u32 simd_##name(v128 a) {                       \\\n"
+"    vt x = (vt)a;                                               \\\n"
+"    u32 result = 0;                                             \\\n"
+"    for (int i = 0; i < n; ++i) {                               \\\n"
+"      result |= (u32)(x[i] >> (bits - 1)) << i;                 \\\n"
+"    }                                                           \\\n"
+"    return result;                                              \\\n"
+"  }\n"
+"\n"
+"SIMD_BITMASK(i8x16_bitmask, simd_u8x16, 16, 8)\n"
+"SIMD_BITMASK(i16x8_bitmask, simd_u16x8, 8, 16)\n"
+"SIMD_BITMASK(i32x4_bitmask, simd_u32x4, 4, 32)\n"
+"SIMD_BITMASK(i64x2_bitmask, simd_u64x2, 2, 64)\n"
+"\n"
+"SIMD_LANEWISE_UNOP(f32x4_ceil, simd_f32x4, simd_f32x4, 4, ceilf(x[i]))\n"
+"SIMD_LANEWISE_UNOP(f32x4_floor, simd_f32x4, simd_f32x4, 4, floorf(x[i]))\n"
+"SIMD_LANEWISE_UNOP(f32x4_trunc, simd_f32x4, simd_f32x4, 4, truncf(x[i]))\n"
+"SIMD_LANEWISE_UNOP(f32x4_nearest, simd_f32x4, simd_f32x4, 4, nearbyintf(x[i]))\n"
+"SIMD_LANEWISE_UNOP(f32x4_sqrt, simd_f32x4, simd_f32x4, 4, sqrtf(x[i]))\n"
+"SIMD_LANEWISE_UNOP(f64x2_ceil, simd_f64x2, simd_f64x2, 2, ceil(x[i]))\n"
+"SIMD_LANEWISE_UNOP(f64x2_floor, simd_f64x2, simd_f64x2, 2, floor(x[i]))\n"
+"SIMD_LANEWISE_UNOP(f64x2_trunc, simd_f64x2, simd_f64x2, 2, trunc(x[i]))\n"
+"SIMD_LANEWISE_UNOP(f64x2_nearest, simd_f64x2, simd_f64x2, 2, nearbyint(x[i]))\n"
+"SIMD_LANEWISE_UNOP(f64x2_sqrt, simd_f64x2, simd_f64x2, 2, sqrt(x[i]))\n"
+"\n"
+"SIMD_LANEWISE_BINOP(f32x4_min, simd_f32x4, simd_f32x4, 4, FMIN(x[i], y[i]))\n"
+"SIMD_LANEWISE_BINOP(f32x4_max, simd_f32x4, simd_f32x4, 4, FMAX(x[i], y[i]))\n"
+"SIMD_LANEWISE_BINOP(f64x2_min, simd_f64x2, simd_f64x2, 2, FMIN(x[i], y[i]))\n"
+"SIMD_LANEWISE_BINOP(f64x2_max, simd_f64x2, simd_f64x2, 2, FMAX(x[i], y[i]))\n"
+"\n"
+"SIMD_PMIN_PMAX(f32x4_pmin, simd_f32x4, <)\n"
+"SIMD_PMIN_PMAX(f32x4_pmax, simd_f32x4, >)\n"
+"SIMD_PMIN_PMAX(f64x2_pmin, simd_f64x2, <)\n"
+"SIMD_PMIN_PMAX(f64x2_pmax, simd_f64x2, >)\n"
+"\n"
+"SIMD_LANEWISE_UNOP(f32x4_convert_i32x4_s, simd_s32x4, simd_f32x4, 4, (f32)x[i])\n"
+"SIMD_LANEWISE_UNOP(f64x2_convert_low_i32x4_s, simd_s32x4, simd_f64x2, 2, (f64)x[i])\n"
+"SIMD_LANEWISE_UNOP(f32x4_demote_f64x2_zero, simd_f64x2, simd_f32x4, 4, i < 2 ? (f32)x[i] : 0)\n"
+"SIMD_LANEWISE_UNOP(f64x2_promote_low_f32x4, simd_f32x4, simd_f64x2, 2, (f64)x[i])\n"
+"SIMD_LANEWISE_UNOP(i32x4_trunc_sat_f32x4_s, simd_f32x4, simd_u32x4, 4, I32_TRUNC_SAT_S_F32(x[i]))\n"
+"\n"
+"#endif\n"
+"\n"
+"#define SIMD_EXTMUL(name, mul, extend) \\\n"
+"  static inline v128 simd_##name(v128 a, v128 b) { return simd_##mul(simd_##extend(a), simd_##extend(b)); }\n"
+"\n"
+"SIMD_EXTMUL(i16x8_extmul_low_i8x16_s, i16x8_mul, i16x8_extend_low_i8x16_s)\n"
+"SIMD_EXTMUL(i16x8_extmul_high_i8x16_s, i16x8_mul, i16x8_extend_high_i8x16_s)\n"
+"SIMD_EXTMUL(i16x8_extmul_low_i8x16_u, i16x8_mul, i16x8_extend_low_i8x16_u)\n"
+"SIMD_EXTMUL(i16x8_extmul_high_i8x16_u, i16x8_mul, i16x8_extend_high_i8x16_u)\n"
+"SIMD_EXTMUL(i32x4_extmul_low_i16x8_s, i32x4_mul, i32x4_extend_low_i16x8_s)\n"
+"SIMD_EXTMUL(i32x4_extmul_high_i16x8_s, i32x4_mul, i32x4_extend_high_i16x8_s)\n"
+"SIMD_EXTMUL(i32x4_extmul_low_i16x8_u, i32x4_mul, i32x4_extend_low_i16x8_u)\n"
+"SIMD_EXTMUL(i32x4_extmul_high_i16x8_u, i32x4_mul, i32x4_extend_high_i16x8_u)\n"
+"SIMD_EXTMUL(i64x2_extmul_low_i32x4_s, i64x2_mul, i64x2_extend_low_i32x4_s)\n"
+"SIMD_EXTMUL(i64x2_extmul_high_i32x4_s, i64x2_mul, i64x2_extend_high_i32x4_s)\n"
+"SIMD_EXTMUL(i64x2_extmul_low_i32x4_u, i64x2_mul, i64x2_extend_low_i32x4_u)\n"
+"SIMD_EXTMUL(i64x2_extmul_high_i32x4_u, i64x2_mul, i64x2_extend_high_i32x4_u)\n"
+"\n"
+"DEFINE_LOAD(v128_load, v128, v128, v128);\n"
+"DEFINE_STORE(v128_store, v128, v128);\n"
+"\n"
+"#define DEFINE_SIMD_LOAD(name, load, expr)                                                          \\\n"
+"  static inline v128 name##_unchecked_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size,     \\\n"
+"                                             u64 addr, u32 shadow_class, const char* func_name) {   \\\n"
+"    u64 x = load##_unchecked_cached(mem, mem_data, mem_size, addr, shadow_class, func_name);        \\\n"
+"    return expr;                                                                                    \\\n"
+"  }                                                                                                 \\\n"
+"  static inline v128 name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,     \\\n"
+"                                   u32 shadow_class, const char* func_name) {                       \\\n"
+"    u64 x = load##_cached(mem, mem_data, mem_size, addr, shadow_class, func_name);                  \\\n"
+"    return expr;                                                                                    \\\n"
+"  }                                                                                                 \\\n"
+"  static inline v128 name##_unchecked(wasm_rt_memory_t* mem, u64 addr, u32 shadow_class,            \\\n"
+"                                      const char* func_name) {                                      \\\n"
+"    return name##_unchecked_cached(mem, mem->data, MEM_SIZE(mem), addr, shadow_class, func_name);   \\\n"
+"  }                                                                                                 \\\n"
+"  static inline v128 name(wasm_rt_memory_t* mem, u64 addr, u32 shadow_class,                        \\\n"
+"                          const char* func_name) {                                                  \\\n"
+"    return name##_cached(mem, mem->data, MEM_SIZE(mem), addr, shadow_class, func_name);             \\\n"
+"  }\n"
+"\n"
+"DEFINE_SIMD_LOAD(v128_load8x8_s, i64_load, simd_i16x8_extend_low_i8x16_s(simd_v128_const(x, 0)))\n"
+"DEFINE_SIMD_LOAD(v128_load8x8_u, i64_load, simd_i16x8_extend_low_i8x16_u(simd_v128_const(x, 0)))\n"
+"DEFINE_SIMD_LOAD(v128_load16x4_s, i64_load, simd_i32x4_extend_low_i16x8_s(simd_v128_const(x, 0)))\n"
+"DEFINE_SIMD_LOAD(v128_load16x4_u, i64_load, simd_i32x4_extend_low_i16x8_u(simd_v128_const(x, 0)))\n"
+"DEFINE_SIMD_LOAD(v128_load32x2_s, i64_load, simd_i64x2_extend_low_i32x4_s(simd_v128_const(x, 0)))\n"
+"DEFINE_SIMD_LOAD(v128_load32x2_u, i64_load, simd_i64x2_extend_low_i32x4_u(simd_v128_const(x, 0)))\n"
+"DEFINE_SIMD_LOAD(v128_load8_splat, i32_load8_u, simd_i8x16_splat((u32)x))\n"
+"DEFINE_SIMD_LOAD(v128_load16_splat, i32_load16_u, simd_i16x8_splat((u32)x))\n"
+"DEFINE_SIMD_LOAD(v128_load32_splat, i32_load, simd_i32x4_splat((u32)x))\n"
+"DEFINE_SIMD_LOAD(v128_load64_splat, i64_load, simd_i64x2_splat(x))\n"
+"DEFINE_SIMD_LOAD(v128_load32_zero, i32_load, simd_v128_const(x, 0))\n"
+"DEFINE_SIMD_LOAD(v128_load64_zero, i64_load, simd_v128_const(x, 0))\n"
+"\n"
+"#define DEFINE_SIMD_LOAD_LANE(name, load, replace)                                                  \\\n"
+"  static inline v128 name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,     \\\n"
+"                                   v128 vec, int lane, u32 shadow_class, const char* func_name) {   \\\n"
+"    return replace(vec, lane, load##_cached(mem, mem_data, mem_size, addr, shadow_class,            \\\n"
+"                                            func_name));                                            \\\n"
+"  }                                                                                                 \\\n"
+"  static inline v128 name(wasm_rt_memory_t* mem, u64 addr, v128 vec, int lane,                      \\\n"
+"                          u32 shadow_class, const char* func_name) {                                \\\n"
+"    return name##_cached(mem, mem->data, MEM_SIZE(mem), addr, vec, lane, shadow_class, func_name);  \\\n"
+"  }\n"
+"\n"
+"DEFINE_SIMD_LOAD_LANE(v128_load8_lane, i32_load8_u, simd_i8x16_replace_lane)\n"
+"DEFINE_SIMD_LOAD_LANE(v128_load16_lane, i32_load16_u, simd_i16x8_replace_lane)\n"
+"DEFINE_SIMD_LOAD_LANE(v128_load32_lane, i32_load, simd_i32x4_replace_lane)\n"
+"DEFINE_SIMD_LOAD_LANE(v128_load64_lane, i64_load, simd_i64x2_replace_lane)\n"
+"\n"
+"#define DEFINE_SIMD_STORE_LANE(name, store, extract)                                                \\\n"
+"  static inline void name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,     \\\n"
+"                                   v128 vec, int lane, u32 shadow_class, const char* func_name) {   \\\n"
+"    store##_cached(mem, mem_data, mem_size, addr, extract(vec, lane), shadow_class, func_name);     \\\n"
+"  }                                                                                                 \\\n"
+"  static inline void name(wasm_rt_memory_t* mem, u64 addr, v128 vec, int lane,                      \\\n"
+"                          u32 shadow_class, const char* func_name) {                                \\\n"
+"    name##_cached(mem, mem->data, MEM_SIZE(mem), addr, vec, lane, shadow_class, func_name);         \\\n"
+"  }\n"
+"\n"
+"DEFINE_SIMD_STORE_LANE(v128_store8_lane, i32_store8, simd_i8x16_extract_lane_u)\n"
+"DEFINE_SIMD_STORE_LANE(v128_store16_lane, i32_store16, simd_i16x8_extract_lane_u)\n"
+"DEFINE_SIMD_STORE_LANE(v128_store32_lane, i32_store, simd_i32x4_extract_lane)\n"
+"DEFINE_SIMD_STORE_LANE(v128_store64_lane, i64_store, simd_i64x2_extract_lane)\n"
+;
+
+const char SECTION_NAME(atomics)[] =
+"\n"
+"// Atomic accesses from the threads proposal. They must be naturally aligned,\n"
+"// and are done with the GCC/Clang __atomic builtins directly on linear memory.\n"
+"// All of them are sequentially consistent, as wasm requires.\n"
+"#if WABT_BIG_ENDIAN\n"
+"#  error \"wasm2c does not support atomics on big-endian hosts\"\n"
+"#endif\n"
+"\n"
+"#define ATOMIC_ALIGNMENT_CHECK(addr, t) \\\n"
+"  if (UNLIKELY((addr) & (sizeof(t) - 1))) { (void) TRAP(UNALIGNED); }\n"
+"\n"
+"#define atomic_fence() __atomic_thread_fence(__ATOMIC_SEQ_CST)\n"
+"\n"
+"#define DEFINE_ATOMIC_LOAD(name, t1, t3)                                                            \\\n"
+"  static inline t3 name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,       \\\n"
+"                                 u32 shadow_class, const char* func_name) {                         \\\n"
+"    MEMCHECK(mem_size, addr, t1);                                                                  \\\n"
+"    ATOMIC_ALIGNMENT_CHECK(addr, t1);                                                              \\\n"
+"    t1 result = __atomic_load_n((t1*)MEM_ACCESS_REF(mem, mem_data, addr), __ATOMIC_SEQ_CST);       \\\n"
+"    WASM2C_SHADOW_MEMORY_LOAD(mem, shadow_class, func_name, addr, sizeof(t1));                     \\\n"
+"    return (t3)result;                                                                             \\\n"
+"  }                                                                                                \\\n"
+"  static inline t3 name(wasm_rt_memory_t* mem, u64 addr, u32 shadow_class,                         \\\n"
+"                        const char* func_name) {                                                   \\\n"
+"    return name##_cached(mem, mem->data, MEM_SIZE(mem), addr, shadow_class, func_name);            \\\n"
+"  }\n"
+"\n"
+"#define DEFINE_ATOMIC_STORE(name, t1, t2)                                                           \\\n"
+"  static inline void name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,     \\\n"
+"                                   t2 value, u32 shadow_class, const char* func_name) {             \\\n"
+"    MEMCHECK(mem_size, addr, t1);                                                                  \\\n"
+"    ATOMIC_ALIGNMENT_CHECK(addr, t1);                                                              \\\n"
+"    __atomic_store_n((t1*)MEM_ACCESS_REF(mem, mem_data, addr), (t1)value, __ATOMIC_SEQ_CST);       \\\n"
+"    WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, addr, sizeof(t1));                    \\\n"
+"  }                                                                                                \\\n"
+"  static inline void name(wasm_rt_memory_t* mem, u64 addr, t2 value, u32 shadow_class,             \\\n"
+"                          const char* func_name) {                                                 \\\n"
+"    name##_cached(mem, mem->data, MEM_SIZE(mem), addr, value, shadow_class, func_name);            \\\n"
+"  }\n"
+"\n"
+"// Read-modify-write operations return the old value, zero-extended.\n"
+"#define DEFINE_ATOMIC_RMW(name, op, t1, t2)                                                         \\\n"
+"  static inline t2 name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,       \\\n"
+"                                 t2 value, u32 shadow_class, const char* func_name) {               \\\n"
+"    MEMCHECK(mem_size, addr, t1);                                                                  \\\n"
+"    ATOMIC_ALIGNMENT_CHECK(addr, t1);                                                              \\\n"
+"    t1 result = op((t1*)MEM_ACCESS_REF(mem, mem_data, addr), (t1)value, __ATOMIC_SEQ_CST);         \\\n"
+"    WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, addr, sizeof(t1));                    \\\n"
+"    return (t2)result;                                                                             \\\n"
+"  }                                                                                                \\\n"
+"  static inline t2 name(wasm_rt_memory_t* mem, u64 addr, t2 value, u32 shadow_class,               \\\n"
+"                        const char* func_name) {                                                   \\\n"
+"    return name##_cached(mem, mem->data, MEM_SIZE(mem), addr, value, shadow_class, func_name);     \\\n"
+"  }\n"
+"\n"
+"// On failure, __atomic_compare_exchange_n stores the current value into\n"
+"// `expected`, so it holds the old value either way.\n"
+"#define DEFINE_ATOMIC_CMPXCHG(name, t1, t2)                                                         \\\n"
+"  static inline t2 name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,       \\\n"
+"                                 t2 expected, t2 replacement, u32 shadow_class,                     \\\n"
+"                                 const char* func_name) {                                           \\\n"
+"    MEMCHECK(mem_size, addr, t1);                                                                  \\\n"
+"    ATOMIC_ALIGNMENT_CHECK(addr, t1);                                                              \\\n"
+"    t1 old = (t1)expected;                                                                         \\\n"
+"    __atomic_compare_exchange_n((t1*)MEM_ACCESS_REF(mem, mem_data, addr), &old, (t1)replacement,   \\\n"
+"                                false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);                        \\\n"
+"    WASM2C_SHADOW_MEMORY_STORE(mem, shadow_class, func_name, addr, sizeof(t1));                    \\\n"
+"    return (t2)old;                                                                                \\\n"
+"  }                                                                                                \\\n"
+"  static inline t2 name(wasm_rt_memory_t* mem, u64 addr, t2 expected, t2 replacement,              \\\n"
+"                        u32 shadow_class, const char* func_name) {                                 \\\n"
+"    return name##_cached(mem, mem->data, MEM_SIZE(mem), addr, expected, replacement, shadow_class, \\\n"
+"                         func_name);                                                               \\\n"
+"  }\n"
+"\n"
+"DEFINE_ATOMIC_LOAD(i32_atomic_load, u32, u32)\n"
+"DEFINE_ATOMIC_LOAD(i64_atomic_load, u64, u64)\n"
+"DEFINE_ATOMIC_LOAD(i32_atomic_load8_u, u8, u32)\n"
+"DEFINE_ATOMIC_LOAD(i32_atomic_load16_u, u16, u32)\n"
+"DEFINE_ATOMIC_LOAD(i64_atomic_load8_u, u8, u64)\n"
+"DEFINE_ATOMIC_LOAD(i64_atomic_load16_u, u16, u64)\n"
+"DEFINE_ATOMIC_LOAD(i64_atomic_load32_u, u32, u64)\n"
+"DEFINE_ATOMIC_STORE(i32_atomic_store, u32, u32)\n"
+"DEFINE_ATOMIC_STORE(i64_atomic_store, u64, u64)\n"
+"DEFINE_ATOMIC_STORE(i32_atomic_store8, u8, u32)\n"
+"DEFINE_ATOMIC_STORE(i32_atomic_store16, u16, u32)\n"
+"DEFINE_ATOMIC_STORE(i64_atomic_store8, u8, u64)\n"
+"DEFINE_ATOMIC_STORE(i64_atomic_store16, u16, u64)\n"
+"DEFINE_ATOMIC_STORE(i64_atomic_store32, u32, u64)\n"
+"\n"
+"#define DEFINE_ATOMIC_RMW_OP(op, builtin)                                   \\\n"
+"  DEFINE_ATOMIC_RMW(i32_atomic_rmw_##op, builtin, u32, u32)                 \\\n"
+"  DEFINE_ATOMIC_RMW(i64_atomic_rmw_##op, builtin, u64, u64)                 \\\n"
+"  DEFINE_ATOMIC_RMW(i32_atomic_rmw8_##op##_u, builtin, u8, u32)             \\\n"
+"  DEFINE_ATOMIC_RMW(i32_atomic_rmw16_##op##_u, builtin, u16, u32)           \\\n"
+"  DEFINE_ATOMIC_RMW(i64_atomic_rmw8_##op##_u, builtin, u8, u64)             \\\n"
+"  DEFINE_ATOMIC_RMW(i64_atomic_rmw16_##op##_u, builtin, u16, u64)           \\\n"
+"  DEFINE_ATOMIC_RMW(i64_atomic_rmw32_##op##_u, builtin, u32, u64)\n"
+"\n"
+"DEFINE_ATOMIC_RMW_OP(add, __atomic_fetch_add)\n"
+"DEFINE_ATOMIC_RMW_OP(sub, __atomic_fetch_sub)\n"
+"DEFINE_ATOMIC_RMW_OP(and, __atomic_fetch_and)\n"
+"DEFINE_ATOMIC_RMW_OP(or, __atomic_fetch_or)\n"
+"DEFINE_ATOMIC_RMW_OP(xor, __atomic_fetch_xor)\n"
+"DEFINE_ATOMIC_RMW_OP(xchg, __atomic_exchange_n)\n"
+"\n"
+"DEFINE_ATOMIC_CMPXCHG(i32_atomic_rmw_cmpxchg, u32, u32)\n"
+"DEFINE_ATOMIC_CMPXCHG(i64_atomic_rmw_cmpxchg, u64, u64)\n"
+"DEFINE_ATOMIC_CMPXCHG(i32_atomic_rmw8_cmpxchg_u, u8, u32)\n"
+"DEFINE_ATOMIC_CMPXCHG(i32_atomic_rmw16_cmpxchg_u, u16, u32)\n"
+"DEFINE_ATOMIC_CMPXCHG(i64_atomic_rmw8_cmpxchg_u, u8, u64)\n"
+"DEFINE_ATOMIC_CMPXCHG(i64_atomic_rmw16_cmpxchg_u, u16, u64)\n"
+"DEFINE_ATOMIC_CMPXCHG(i64_atomic_rmw32_cmpxchg_u, u32, u64)\n"
+"\n"
+"#define DEFINE_ATOMIC_WAIT(name, t, wait)                                                           \\\n"
+"  static inline u32 name##_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size, u64 addr,      \\\n"
+"                                  t expected, u64 timeout, u32 shadow_class,                        \\\n"
+"                                  const char* func_name) {                                          \\\n"
+"    (void)shadow_class;                                                                            \\\n"
+"    (void)func_name;                                                                               \\\n"
+"    MEMCHECK(mem_size, addr, t);                                                                   \\\n"
+"    ATOMIC_ALIGNMENT_CHECK(addr, t);                                                               \\\n"
+"    return wait(mem, (t*)MEM_ACCESS_REF(mem, mem_data, addr), expected, (s64)timeout);             \\\n"
+"  }                                                                                                \\\n"
+"  static inline u32 name(wasm_rt_memory_t* mem, u64 addr, t expected, u64 timeout,                 \\\n"
+"                         u32 shadow_class, const char* func_name) {                                \\\n"
+"    return name##_cached(mem, mem->data, MEM_SIZE(mem), addr, expected, timeout, shadow_class,     \\\n"
+"                         func_name);                                                               \\\n"
+"  }\n"
+"\n"
+"DEFINE_ATOMIC_WAIT(memory_atomic_wait32, u32, wasm_rt_atomic_wait32)\n"
+"DEFINE_ATOMIC_WAIT(memory_atomic_wait64, u64, wasm_rt_atomic_wait64)\n"
+"\n"
+"static inline u32 memory_atomic_notify_cached(wasm_rt_memory_t* mem, u8* mem_data, u64 mem_size,\n"
+"                                              u64 addr, u32 count, u32 shadow_class,\n"
+"                                              const char* func_name) {\n"
+"  (void)shadow_class;\n"
+"  (void)func_name;\n"
+"  MEMCHECK(mem_size, addr, u32);\n"
+"  ATOMIC_ALIGNMENT_CHECK(addr, u32);\n"
+"  return wasm_rt_atomic_notify(mem, MEM_ACCESS_REF(mem, mem_data, addr), count);\n"
+"}\n"
+"\n"
+"static inline u32 memory_atomic_notify(wasm_rt_memory_t* mem, u64 addr, u32 count,\n"
+"                                       u32 shadow_class, const char* func_name) {\n"
+"  return memory_atomic_notify_cached(mem, mem->data, MEM_SIZE(mem), addr, count, shadow_class,\n"
+"                                     func_name);\n"
+"}\n"
+;
+
+const char SECTION_NAME(tailcall)[] =
+"\n"
+"// return_call and return_call_indirect use WASM_RT_MUSTTAIL when the caller and\n"
+"// callee have the same signature. Otherwise, the caller stores the callee and\n"
+"// its arguments in the sandbox and returns, and the wrapper of the function\n"
+"// that started the chain of tail calls runs them one after the other. Each\n"
+"// argument and result takes one slot of the sandbox's buffers.\n"
+"#define TAIL_CALL_SLOT_SIZE 16\n"
+"\n"
+"#define TAIL_CALL_ARG(sbx, i, x) \\\n"
+"  memcpy((sbx)->tail_call_args + (i) * TAIL_CALL_SLOT_SIZE, &(x), sizeof(x))\n"
+"\n"
+"#define TAIL_CALL_GET_ARG(sbx, i, x) \\\n"
+"  memcpy(&(x), (sbx)->tail_call_args + (i) * TAIL_CALL_SLOT_SIZE, sizeof(x))\n"
+"\n"
+"#define RUN_TAIL_CALLS(sbx)                                         \\\n"
+"  while ((sbx)->tail_call_next) {                                   \\\n"
+"    void (*next)(wasm2c_sandbox_t* const) = (sbx)->tail_call_next;  \\\n"
+"    (sbx)->tail_call_next = 0;                                      \\\n"
+"    next(sbx);                                                      \\\n"
+"  }\n"
+"\n"
+"#define RETURN_CALL_INDIRECT(table, t, type_id, x, ...)                   \\\n"
+"  if (LIKELY((x) < table.size && table.data[x].func_type == (type_id))) { \\\n"
+"    EXTERNAL_CALLBACK_PROLOGUE_EXEC(table, x);                            \\\n"
+"    WASM_RT_MUSTTAIL return ((t)table.data[x].func)(__VA_ARGS__);         \\\n"
+"  } else {                                                                \\\n"
+"    wasm_rt_callback_error_trap(&table, x, type_id);                      \\\n"
+"  }\n"
+"\n"
+;
+
 const char SECTION_NAME(sandboxapis)[] =
 "//test\n"
 "\n"
 "static u32 add_wasm2c_callback(void* sbx_ptr, u32 func_type_idx, void* func_ptr, wasm_rt_elem_target_class_t func_class) {\n"
 "  wasm_rt_table_t* table = get_wasm2c_callback_table(sbx_ptr);\n"
-"  for (u32 i = 1; i < table->max_size; i++) {\n"
-"    if (i >= table->size) {\n"
-"      wasm_rt_expand_table(table);\n"
-"    }\n"
-"    if (table->data[i].func == 0) {\n"
-"      table->data[i] = (wasm_rt_elem_t){ func_class, func_type_idx, (wasm_rt_anyfunc_t) func_ptr };\n"
-"      return i;\n"
-"    }\n"
-"  }\n"
-"  (void) TRAP(CALL_INDIRECT_TABLE_EXPANSION);\n"
+"  u32 i = wasm_rt_table_alloc_slot(table);\n"
+"  table->data[i] = (wasm_rt_elem_t){ func_class, func_type_idx, (wasm_rt_anyfunc_t) func_ptr };\n"
+"  return i;\n"
 "}\n"
 "\n"
 "static void remove_wasm2c_callback(void* sbx_ptr, u32 callback_idx) {\n"
 "  wasm_rt_table_t* table = get_wasm2c_callback_table(sbx_ptr);\n"
-"  table->data[callback_idx].func = 0;\n"
+"  wasm_rt_table_free_slot(table, callback_idx);\n"
 "}\n"
 "\n"
 "static u32 lookup_wasm2c_func_index(void* sbx_ptr, u32 param_count, u32 result_count, wasm_rt_type_t* types) {\n"
-"  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) sbx_ptr;\n"
-"  return wasm_rt_register_func_type(&sbx->func_type_structs, &sbx->func_type_count, param_count, result_count, types);\n"
+"  // Function type indices are shared by all sandboxes.\n"
+"  (void) sbx_ptr;\n"
+"  return wasm_rt_register_func_type(param_count, result_count, types);\n"
 "}\n"
 "\n"
 "static void* create_wasm2c_sandbox(uint32_t max_wasm_pages) {\n"
@@ -402,20 +1416,122 @@ const char SECTION_NAME(sandboxapis)[] =
 "  init_func_types(sbx);\n"
 "  init_globals(sbx);\n"
 "  init_table(sbx);\n"
+"  init_profile(sbx);\n"
+"  wasm_rt_init_wasi(&(sbx->wasi_data));\n"
+"  init_module_starts(sbx);\n"
+"  return sbx;\n"
+"}\n"
+"\n"
+"// Creates another instance of the module for a new thread. It has its own\n"
+"// globals and table, but shares the (shared) linear memory of `parent_ptr`,\n"
+"// which must stay alive until every thread sandbox created from it has been\n"
+"// destroyed. Returns 0 if the module has no shared memory, or if out of memory.\n"
+"static void* create_wasm2c_sandbox_thread(void* parent_ptr) {\n"
+"  wasm2c_sandbox_t* const parent = (wasm2c_sandbox_t* const) parent_ptr;\n"
+"  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) calloc(sizeof(wasm2c_sandbox_t), 1);\n"
+"  if (!sbx) {\n"
+"    return 0;\n"
+"  }\n"
+"  if (!init_thread_memory(sbx, parent)) {\n"
+"    free(sbx);\n"
+"    return 0;\n"
+"  }\n"
+"  init_func_types(sbx);\n"
+"  init_globals(sbx);\n"
+"  init_table(sbx);\n"
+"  init_profile(sbx);\n"
 "  wasm_rt_init_wasi(&(sbx->wasi_data));\n"
-"  init_module_starts();\n"
 "  return sbx;\n"
 "}\n"
 "\n"
 "static void destroy_wasm2c_sandbox(void* aSbx) {\n"
 "  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) aSbx;\n"
 "  cleanup_memory(sbx);\n"
-"  cleanup_func_types(sbx);\n"
 "  cleanup_table(sbx);\n"
+"  cleanup_profile(sbx);\n"
 "  wasm_rt_cleanup_wasi(&(sbx->wasi_data));\n"
 "  free(sbx);\n"
 "}\n"
 "\n"
+"// A copy of the linear memory, globals and table of an initialized sandbox.\n"
+"// The copy of the sandbox struct holds the globals, the table's size and the\n"
+"// function type indices; everything it points to is copied separately.\n"
+"typedef struct wasm2c_sandbox_snapshot_t {\n"
+"  wasm2c_sandbox_t sbx;\n"
+"  wasm_rt_memory_image_t memory_image;\n"
+"  wasm_rt_elem_t* table_data;\n"
+"} wasm2c_sandbox_snapshot_t;\n"
+"\n"
+"// Returns 0 if the module's memory is shared, or if memory images are not\n"
+"// supported.\n"
+"static void* create_wasm2c_sandbox_snapshot(void* sbx_ptr) {\n"
+"  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) sbx_ptr;\n"
+"  wasm_rt_memory_t* memory = get_wasm2c_memory(sbx);\n"
+"  if (!memory || memory->is_shared) {\n"
+"    return 0;\n"
+"  }\n"
+"  wasm2c_sandbox_snapshot_t* const snapshot = (wasm2c_sandbox_snapshot_t*) calloc(sizeof(wasm2c_sandbox_snapshot_t), 1);\n"
+"  if (!snapshot) {\n"
+"    return 0;\n"
+"  }\n"
+"  if (!wasm_rt_create_memory_image(&snapshot->memory_image, memory)) {\n"
+"    free(snapshot);\n"
+"    return 0;\n"
+"  }\n"
+"  memcpy(&snapshot->sbx, sbx, sizeof(wasm2c_sandbox_t));\n"
+"  wasm_rt_table_t* table = get_wasm2c_callback_table(sbx);\n"
+"  snapshot->table_data = (wasm_rt_elem_t*) malloc((table->size ? table->size : 1) * sizeof(wasm_rt_elem_t));\n"
+"  if (!snapshot->table_data) {\n"
+"    wasm_rt_free_memory_image(&snapshot->memory_image);\n"
+"    free(snapshot);\n"
+"    return 0;\n"
+"  }\n"
+"  memcpy(snapshot->table_data, table->data, table->size * sizeof(wasm_rt_elem_t));\n"
+"  return snapshot;\n"
+"}\n"
+"\n"
+"// Creates a sandbox in the state the snapshot was taken in, without running\n"
+"// any of the module's initialization. Its memory is mapped copy-on-write from\n"
+"// the snapshot. The WASI state and the profile are not part of the snapshot,\n"
+"// and start out fresh as in create_wasm2c_sandbox.\n"
+"static void* create_wasm2c_sandbox_from_snapshot(void* snapshot_ptr, uint32_t max_wasm_pages) {\n"
+"  wasm2c_sandbox_snapshot_t* const snapshot = (wasm2c_sandbox_snapshot_t* const) snapshot_ptr;\n"
+"  wasm2c_sandbox_t* const sbx = (wasm2c_sandbox_t* const) malloc(sizeof(wasm2c_sandbox_t));\n"
+"  if (!sbx) {\n"
+"    return 0;\n"
+"  }\n"
+"  memcpy(sbx, &snapshot->sbx, sizeof(wasm2c_sandbox_t));\n"
+"  wasm_rt_memory_t* memory = get_wasm2c_memory(sbx);\n"
+"  const uint32_t max_pages = max_wasm_pages == 0 ? memory->max_pages : max_wasm_pages;\n"
+"  if (!wasm_rt_allocate_memory_from_image(memory, &snapshot->memory_image, max_pages)) {\n"
+"    free(sbx);\n"
+"    return 0;\n"
+"  }\n"
+"  WASM2C_SHADOW_MEMORY_INIT_SAMPLE_RATE(memory);\n"
+"  wasm_rt_table_t* table = get_wasm2c_callback_table(sbx);\n"
+"  wasm_rt_allocate_table(table, table->size, table->max_size);\n"
+"  memcpy(table->data, snapshot->table_data, table->size * sizeof(wasm_rt_elem_t));\n"
+"  init_profile(sbx);\n"
+"  memset(&(sbx->wasi_data), 0, sizeof(sbx->wasi_data));\n"
+"  sbx->wasi_data.heap_memory = memory;\n"
+"  wasm_rt_init_wasi(&(sbx->wasi_data));\n"
+"  return sbx;\n"
+"}\n"
+"\n"
+"static void destroy_wasm2c_sandbox_snapshot(void* snapshot_ptr) {\n"
+"  wasm2c_sandbox_snapshot_t* const snapshot = (wasm2c_sandbox_snapshot_t* const) snapshot_ptr;\n"
+"  wasm_rt_free_memory_image(&snapshot->memory_image);\n"
+"  free(snapshot->table_data);\n"
+"  free(snapshot);\n"
+"}\n"
+"\n"
+"// Returns false if the module was compiled without --instrument, or without\n"
+"// --instrument=cycles for the folded format.\n"
+"static bool dump_wasm2c_profile(void* sbx_ptr, FILE* out, wasm_rt_profile_format_t format) {\n"
+"  wasm_rt_profile_t* profile = get_wasm2c_profile((wasm2c_sandbox_t*) sbx_ptr);\n"
+"  return profile && wasm_rt_profile_dump(profile, out, format);\n"
+"}\n"
+"\n"
 "FUNC_EXPORT wasm2c_sandbox_funcs_t WASM_CURR_ADD_PREFIX(get_wasm2c_sandbox_info)() {\n"
 "  wasm2c_sandbox_funcs_t ret;\n"
 "  ret.wasm_rt_sys_init = &wasm_rt_sys_init;\n"
@@ -425,6 +1541,12 @@ const char SECTION_NAME(sandboxapis)[] =
 "  ret.lookup_wasm2c_func_index = &lookup_wasm2c_func_index;\n"
 "  ret.add_wasm2c_callback = &add_wasm2c_callback;\n"
 "  ret.remove_wasm2c_callback = &remove_wasm2c_callback;\n"
+"  ret.create_wasm2c_sandbox_thread = &create_wasm2c_sandbox_thread;\n"
+"  ret.create_wasm2c_sandbox_snapshot = &create_wasm2c_sandbox_snapshot;\n"
+"  ret.create_wasm2c_sandbox_from_snapshot = &create_wasm2c_sandbox_from_snapshot;\n"
+"  ret.destroy_wasm2c_sandbox_snapshot = &destroy_wasm2c_sandbox_snapshot;\n"
+"  ret.lookup_wasm2c_func_export = &lookup_wasm2c_func_export;\n"
+"  ret.dump_wasm2c_profile = &dump_wasm2c_profile;\n"
 "  return ret;\n"
 "}\n"
 ;
@@ -30,6 +30,15 @@ const char SECTION_NAME(top)[] =
 "typedef int64_t s64;\n"
 "typedef float f32;\n"
 "typedef double f64;\n"
+"#if defined(__GNUC__) || defined(__clang__)\n"
+"/* Same layout as SSE's __m128i, so it can be passed to intrinsics with a cast. */\n"
+"typedef long long v128 __attribute__((vector_size(16)));\n"
+"#elif defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)\n"
+"#include <emmintrin.h>\n"
+"typedef __m128i v128;\n"
+"#else\n"
+"typedef struct { u64 lanes[2]; } v128;\n"
+"#endif\n"
 "\n"
 "#ifndef WASM_DONT_EXPORT_FUNCS\n"
 "# if defined(_WIN32)\n"
@@ -15,17 +15,31 @@
  */
 
 #include <cassert>
+#include <cctype>
+#include <cerrno>
 #include <cinttypes>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <map>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#if _WIN32
+#include <direct.h>
+#endif
 
 #include "src/apply-names.h"
 #include "src/binary-reader.h"
 #include "src/binary-reader-ir.h"
 #include "src/error-formatter.h"
+#include "src/expr-visitor.h"
 #include "src/feature.h"
+#include "src/filenames.h"
 #include "src/generate-names.h"
 #include "src/ir.h"
+#include "src/make-unique.h"
 #include "src/option-parser.h"
 #include "src/stream.h"
 #include "src/validator.h"
@@ -38,9 +52,14 @@ using namespace wabt;
 static int s_verbose;
 static std::string s_infile;
 static std::string s_outfile;
+static Index s_num_outputs = 1;
+// Far more files than any build can compile in parallel.
+static const Index kMaxNumOutputs = 4096;
 static Features s_features;
 static WriteCOptions s_write_c_options;
 static bool s_read_debug_names = true;
+static std::string s_profile_file;
+static std::string s_cache_dir;
 static std::unique_ptr<FileStream> s_log_stream;
 
 static const char s_description[] =
@@ -53,6 +72,12 @@ examples:
 
   # parse test.wasm, write test.c and test.h, but ignore the debug names, if any
   $ wasm2c test.wasm --no-debug-names -o test.c
+
+  # parse test.wasm, write test_0.c .. test_3.c, test.h and test_impl.h
+  $ wasm2c test.wasm --num-outputs=4 -o test.c
+
+  # as above, but only rewrite the files that changed since the last run
+  $ wasm2c test.wasm --num-outputs=16 --cache-dir=wasm2c-cache -o test.c
 )";
 
 static void ParseOptions(int argc, char** argv) {
@@ -75,6 +100,106 @@ static void ParseOptions(int argc, char** argv) {
       [](const char* argument) {
         s_write_c_options.mod_name = argument;
       });
+  parser.AddOption(
+      0, "num-outputs", "NUM",
+      "Split the generated functions across NUM C source files, so they can "
+      "be compiled in parallel. Requires -o",
+      [](const char* argument) {
+        char* end;
+        errno = 0;
+        unsigned long num_outputs = strtoul(argument, &end, 10);
+        if (!isdigit(static_cast<unsigned char>(argument[0])) || *end != '\0' ||
+            errno == ERANGE || num_outputs == 0 ||
+            num_outputs > kMaxNumOutputs) {
+          fprintf(stderr,
+                  "--num-outputs must be a number from 1 to %u, got \"%s\".\n",
+                  kMaxNumOutputs, argument);
+          exit(1);
+        }
+        s_num_outputs = num_outputs;
+      });
+  parser.AddOption(
+      0, "cache-dir", "DIR",
+      "Keep the hashes of the output files and functions in DIR, and leave "
+      "the output files that haven't changed since the last run untouched. "
+      "Functions are spread over the files by a hash of their export or "
+      "debug names, so that an edit to one function only changes its own "
+      "file. Functions with neither are named after their index, so adding a "
+      "function moves the ones after it. Requires -o",
+      [](const char* argument) {
+        s_cache_dir = argument;
+        ConvertBackslashToSlash(&s_cache_dir);
+        s_write_c_options.stable_shards = true;
+      });
+  parser.AddOption(
+      "cache-memory-base",
+      "Keep the linear memory base and size in locals, reloading them only "
+      "after calls and memory.grow",
+      []() { s_write_c_options.cache_memory_base = true; });
+  parser.AddOption(
+      "fold-exprs",
+      "Fold the results of pure instructions into the C expression that "
+      "consumes them, instead of assigning each one to a stack variable",
+      []() { s_write_c_options.fold_exprs = true; });
+  parser.AddOption(
+      "no-cache-globals",
+      "Read globals through the sandbox struct every time, instead of "
+      "keeping the ones a function reads in locals between calls",
+      []() { s_write_c_options.cache_globals = false; });
+  parser.AddOption(
+      "remove-dead-functions",
+      "Leave out the functions that can't be reached from the exports, the "
+      "start function or the table, and report how many were removed",
+      []() { s_write_c_options.remove_dead_funcs = true; });
+  parser.AddOption(
+      "string-data-segments",
+      "Write the contents of data segments as string literals instead of "
+      "arrays of bytes, to reduce the size and compile time of the C source",
+      []() { s_write_c_options.string_data_segments = true; });
+  parser.AddOption(
+      0, "shadow-check-function", "FUNCTION",
+      "Check every load and store of FUNCTION when the shadow memory checker "
+      "is built to sample accesses. May be given more than once",
+      [](const char* argument) {
+        s_write_c_options.shadow_check_funcs.push_back(argument);
+      });
+  parser.AddOption(
+      0, "instrument", "KINDS",
+      "Profile the defined functions. KINDS is a comma separated list of "
+      "\"calls\", to count the calls of each function, \"cycles\", to also "
+      "time them along with the call stacks they were made from, and "
+      "\"branches\", to count how often each if and br_if is taken",
+      [](const char* argument) {
+        std::string kinds = argument;
+        size_t start = 0;
+        while (start <= kinds.size()) {
+          size_t end = kinds.find(',', start);
+          if (end == std::string::npos)
+            end = kinds.size();
+          std::string kind = kinds.substr(start, end - start);
+          if (kind == "calls") {
+            s_write_c_options.instrument_calls = true;
+          } else if (kind == "cycles") {
+            s_write_c_options.instrument_cycles = true;
+          } else if (kind == "branches") {
+            s_write_c_options.instrument_branches = true;
+          } else {
+            fprintf(stderr, "Unknown --instrument kind: \"%s\".\n",
+                    kind.c_str());
+            exit(1);
+          }
+          start = end + 1;
+        }
+      });
+  parser.AddOption(
+      0, "profile-use", "FILENAME",
+      "Use the counts that a build made with --instrument wrote with "
+      "WASM_RT_PROFILE_COUNTS to mark hot and cold functions, hint the "
+      "direction of biased branches and order the globals",
+      [](const char* argument) {
+        s_profile_file = argument;
+        ConvertBackslashToSlash(&s_profile_file);
+      });
   s_features.AddOptions(&parser);
   parser.AddOption("no-debug-names", "Ignore debug names in the binary file",
                    []() { s_read_debug_names = false; });
@@ -86,15 +211,30 @@ static void ParseOptions(int argc, char** argv) {
   parser.Parse(argc, argv);
 
   // TODO(binji): currently wasm2c doesn't support any non-default feature
-  // flags.
+  // flags, other than threads, bulk-memory and tail-call.
   bool any_non_default_feature = false;
-#define WABT_FEATURE(variable, flag, default_, help) \
-  any_non_default_feature |= (s_features.variable##_enabled() != default_);
+#define WABT_FEATURE(variable, flag, default_, help)                          \
+  if (strcmp(flag, "threads") != 0 && strcmp(flag, "bulk-memory") != 0 &&    \
+      strcmp(flag, "tail-call") != 0) {                                       \
+    any_non_default_feature |= (s_features.variable##_enabled() != default_); \
+  }
 #include "src/feature.def"
 #undef WABT_FEATURE
 
   if (any_non_default_feature) {
-    fprintf(stderr, "wasm2c currently support only default feature flags.\n");
+    fprintf(stderr,
+            "wasm2c currently supports only default feature flags, "
+            "--enable-threads, --enable-bulk-memory and --enable-tail-call.\n");
+    exit(1);
+  }
+
+  if (s_num_outputs > 1 && s_outfile.empty()) {
+    fprintf(stderr, "--num-outputs requires an output file (-o).\n");
+    exit(1);
+  }
+
+  if (!s_cache_dir.empty() && s_outfile.empty()) {
+    fprintf(stderr, "--cache-dir requires an output file (-o).\n");
     exit(1);
   }
 }
@@ -109,12 +249,214 @@ static string_view strip_extension(string_view s) {
   return result;
 }
 
+// Reads the lines written by wasm_rt_profile_dump with
+// WASM_RT_PROFILE_COUNTS:
+//
+//   func <calls> <self ticks> <name>
+//   branch <index> <not taken> <taken> <name>
+static Result ReadProfile(const std::string& filename, WriteCProfile* profile) {
+  std::vector<uint8_t> data;
+  CHECK_RESULT(ReadFile(filename, &data));
+  std::string text(data.begin(), data.end());
+  size_t line_start = 0;
+  int line_number = 0;
+  while (line_start < text.size()) {
+    size_t line_end = text.find('\n', line_start);
+    if (line_end == std::string::npos)
+      line_end = text.size();
+    std::string line = text.substr(line_start, line_end - line_start);
+    line_start = line_end + 1;
+    ++line_number;
+    // Profiles that went through a Windows text mode stream end in "\r\n".
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    if (line.empty() || line[0] == '#')
+      continue;
+
+    uint64_t calls, ticks, not_taken, taken;
+    unsigned index;
+    int name_pos = 0;
+    if (sscanf(line.c_str(), "func %" SCNu64 " %" SCNu64 " %n", &calls,
+               &ticks, &name_pos) == 2 &&
+        name_pos > 0) {
+      WriteCProfile::Func& func = profile->funcs[line.substr(name_pos)];
+      func.calls = calls;
+      func.self_ticks = ticks;
+    } else if (sscanf(line.c_str(),
+                      "branch %u %" SCNu64 " %" SCNu64 " %n", &index,
+                      &not_taken, &taken, &name_pos) == 3 &&
+               name_pos > 0) {
+      // The branches of a function are written in order, so an index past
+      // the next one means the line is corrupt, and would make the list
+      // arbitrarily large.
+      WriteCProfile::Func& func = profile->funcs[line.substr(name_pos)];
+      if (index > func.branches.size()) {
+        fprintf(stderr, "%s:%d: branch index %u is out of order\n",
+                filename.c_str(), line_number, index);
+        return Result::Error;
+      }
+      if (index == func.branches.size())
+        func.branches.emplace_back();
+      func.branches[index] = {not_taken, taken};
+    } else {
+      fprintf(stderr, "%s:%d: invalid profile line\n", filename.c_str(),
+              line_number);
+      return Result::Error;
+    }
+  }
+  return Result::Ok;
+}
+
+// The table instructions of the bulk memory proposal aren't implemented by the
+// C writer yet, so they are rejected here instead of reaching it.
+class UnsupportedExprChecker : public ExprVisitor::DelegateNop {
+ public:
+  explicit UnsupportedExprChecker(Errors* errors) : errors_(errors) {}
+
+  Result OnTableCopyExpr(TableCopyExpr* expr) override {
+    return Unsupported(expr, "table.copy");
+  }
+  Result OnElemDropExpr(ElemDropExpr* expr) override {
+    return Unsupported(expr, "elem.drop");
+  }
+  Result OnTableInitExpr(TableInitExpr* expr) override {
+    return Unsupported(expr, "table.init");
+  }
+
+ private:
+  Result Unsupported(Expr* expr, const char* name) {
+    errors_->emplace_back(ErrorLevel::Error, expr->loc,
+                          std::string("wasm2c doesn't support ") + name);
+    return Result::Error;
+  }
+
+  Errors* errors_;
+};
+
+static Result CheckUnsupportedExprs(Module* module, Errors* errors) {
+  UnsupportedExprChecker checker(errors);
+  ExprVisitor visitor(&checker);
+  for (Func* func : module->funcs) {
+    CHECK_RESULT(visitor.VisitFunc(func));
+  }
+  return Result::Ok;
+}
+
+// The output is written to memory first when there is a cache, so that the
+// files that haven't changed can be left alone.
+static std::unique_ptr<Stream> OpenOutput(const std::string& filename) {
+  if (!s_cache_dir.empty())
+    return MakeUnique<MemoryStream>();
+  return MakeUnique<FileStream>(filename);
+}
+
+static bool MakeDirectory(const std::string& path) {
+#if _WIN32
+  return _mkdir(path.c_str()) == 0 || errno == EEXIST;
+#else
+  return mkdir(path.c_str(), 0777) == 0 || errno == EEXIST;
+#endif
+}
+
+static bool FileHasSize(const std::string& filename, size_t size) {
+  struct stat statbuf;
+  return stat(filename.c_str(), &statbuf) == 0 &&
+         static_cast<size_t>(statbuf.st_size) == size;
+}
+
+// The cache holds one manifest per output, with the hash of every file and
+// function written by the last run:
+//
+//   file <hash> <filename>
+//   func <hash> <export or debug name>
+//
+// A file whose hash is unchanged, and that is still there with the same size,
+// isn't rewritten, so that build tools don't compile it again.
+static Result WriteCachedOutputs(
+    const std::string& base_name,
+    const std::vector<std::pair<std::string, MemoryStream*>>& outputs,
+    const WriteCStats& stats) {
+  if (!MakeDirectory(s_cache_dir)) {
+    fprintf(stderr, "%s: %s\n", s_cache_dir.c_str(), strerror(errno));
+    return Result::Error;
+  }
+  std::string manifest_name =
+      s_cache_dir + "/" + GetBasename(base_name).to_string() + ".manifest";
+
+  std::map<std::string, uint64_t> old_files;
+  std::map<std::string, uint64_t> old_funcs;
+  std::vector<uint8_t> data;
+  struct stat statbuf;
+  if (stat(manifest_name.c_str(), &statbuf) == 0 &&
+      Succeeded(ReadFile(manifest_name, &data))) {
+    std::string text(data.begin(), data.end());
+    size_t line_start = 0;
+    while (line_start < text.size()) {
+      size_t line_end = text.find('\n', line_start);
+      if (line_end == std::string::npos)
+        line_end = text.size();
+      std::string line = text.substr(line_start, line_end - line_start);
+      line_start = line_end + 1;
+
+      uint64_t hash;
+      int name_pos = 0;
+      if (sscanf(line.c_str(), "file %" SCNx64 " %n", &hash, &name_pos) == 1 &&
+          name_pos > 0) {
+        old_files[line.substr(name_pos)] = hash;
+      } else if (sscanf(line.c_str(), "func %" SCNx64 " %n", &hash,
+                        &name_pos) == 1 &&
+                 name_pos > 0) {
+        old_funcs[line.substr(name_pos)] = hash;
+      }
+    }
+  }
+
+  MemoryStream manifest;
+  Index num_written = 0;
+  for (const auto& output : outputs) {
+    const std::vector<uint8_t>& contents =
+        output.second->output_buffer().data;
+    uint64_t hash = HashCOutput(string_view(
+        reinterpret_cast<const char*>(contents.data()), contents.size()));
+    auto old = old_files.find(output.first);
+    if (old == old_files.end() || old->second != hash ||
+        !FileHasSize(output.first, contents.size())) {
+      CHECK_RESULT(output.second->WriteToFile(output.first));
+      ++num_written;
+    }
+    manifest.Writef("file %016" PRIx64 " %s\n", hash, output.first.c_str());
+  }
+
+  Index num_changed = 0;
+  for (const auto& func : stats.func_hashes) {
+    // The manifest is line based, and names can hold anything.
+    if (func.first.find('\n') != std::string::npos)
+      continue;
+    auto old = old_funcs.find(func.first);
+    if (old == old_funcs.end() || old->second != func.second)
+      ++num_changed;
+    manifest.Writef("func %016" PRIx64 " %s\n", func.second,
+                    func.first.c_str());
+  }
+  CHECK_RESULT(manifest.WriteToFile(manifest_name));
+
+  fprintf(stderr, "wasm2c: %u of %u functions changed, wrote %u of %u files\n",
+          num_changed, static_cast<Index>(stats.func_hashes.size()),
+          num_written, static_cast<Index>(outputs.size()));
+  return Result::Ok;
+}
+
 int ProgramMain(int argc, char** argv) {
   Result result;
 
   InitStdio();
   ParseOptions(argc, argv);
 
+  if (!s_profile_file.empty() &&
+      Failed(ReadProfile(s_profile_file, &s_write_c_options.profile))) {
+    return 1;
+  }
+
   std::vector<uint8_t> file_data;
   result = ReadFile(s_infile.c_str(), &file_data);
   if (Succeeded(result)) {
@@ -134,6 +476,10 @@ int ProgramMain(int argc, char** argv) {
         result |= GenerateNames(&module);
       }
 
+      if (Succeeded(result)) {
+        result = CheckUnsupportedExprs(&module, &errors);
+      }
+
       if (Succeeded(result)) {
         /* TODO(binji): This shouldn't fail; if a name can't be applied
          * (because the index is invalid, say) it should just be skipped. */
@@ -141,20 +487,73 @@ int ProgramMain(int argc, char** argv) {
         WABT_USE(dummy_result);
       }
 
+      WriteCStats stats;
       if (Succeeded(result)) {
         if (!s_outfile.empty()) {
-          std::string header_name =
-              strip_extension(s_outfile).to_string() + ".h";
-          FileStream c_stream(s_outfile.c_str());
-          FileStream h_stream(header_name);
-          result = WriteC(&c_stream, &h_stream, header_name.c_str(), &module,
-                          s_write_c_options);
+          std::string base_name = strip_extension(s_outfile).to_string();
+          std::string header_name = base_name + ".h";
+          std::string header_impl_name = base_name + "_impl.h";
+          std::vector<std::string> c_file_names;
+          if (s_num_outputs == 1) {
+            c_file_names.push_back(s_outfile);
+          } else {
+            for (Index i = 0; i < s_num_outputs; ++i) {
+              c_file_names.push_back(base_name + "_" + std::to_string(i) +
+                                     ".c");
+            }
+          }
+          std::vector<std::unique_ptr<Stream>> c_file_streams;
+          std::vector<Stream*> c_streams;
+          for (const std::string& c_file_name : c_file_names) {
+            c_file_streams.push_back(OpenOutput(c_file_name));
+            c_streams.push_back(c_file_streams.back().get());
+          }
+          std::unique_ptr<Stream> h_stream = OpenOutput(header_name);
+          std::unique_ptr<Stream> h_impl_stream;
+          if (s_num_outputs > 1) {
+            h_impl_stream = OpenOutput(header_impl_name);
+          }
+          result = WriteC(c_streams, h_stream.get(), h_impl_stream.get(),
+                          header_name.c_str(), header_impl_name.c_str(),
+                          &module, s_write_c_options, &stats);
+
+          if (Succeeded(result) && !s_cache_dir.empty()) {
+            std::vector<std::pair<std::string, MemoryStream*>> outputs;
+            for (Index i = 0; i < c_file_names.size(); ++i) {
+              outputs.emplace_back(
+                  c_file_names[i],
+                  static_cast<MemoryStream*>(c_file_streams[i].get()));
+            }
+            outputs.emplace_back(header_name,
+                                 static_cast<MemoryStream*>(h_stream.get()));
+            if (h_impl_stream) {
+              outputs.emplace_back(
+                  header_impl_name,
+                  static_cast<MemoryStream*>(h_impl_stream.get()));
+            }
+            result = WriteCachedOutputs(base_name, outputs, stats);
+          }
         } else {
           FileStream stream(stdout);
-          result =
-              WriteC(&stream, &stream, "wasm.h", &module, s_write_c_options);
+          result = WriteC({&stream}, &stream, nullptr, "wasm.h", nullptr,
+                          &module, s_write_c_options, &stats);
         }
       }
+
+      if (Succeeded(result) && stats.unprofiled_funcs > 0) {
+        fprintf(stderr,
+                "wasm2c: warning: %u of %u functions are missing from the "
+                "profile, so it is probably for another module; not marking "
+                "hot and cold functions\n",
+                stats.unprofiled_funcs, stats.funcs);
+      }
+
+      if (Succeeded(result) && s_write_c_options.remove_dead_funcs) {
+        fprintf(stderr,
+                "wasm2c: removed %u of %u functions (%" PRIu64
+                " bytes of code)\n",
+                stats.removed_funcs, stats.funcs, stats.removed_code_bytes);
+      }
     }
     FormatErrorsToFile(errors, Location::Type::Binary);
   }
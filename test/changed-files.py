@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+#
+# Copyright 2022 WebAssembly Community Group participants
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+"""Print the files that were written since the last call.
+
+Compares the modification time and contents of the files in a directory whose
+names start with a prefix against those recorded in a snapshot file, prints
+the names of those that are new or differ, and updates the snapshot. Used to
+check which outputs a tool rewrote.
+"""
+
+import argparse
+import hashlib
+import json
+import os
+import sys
+
+
+def Snapshot(directory, prefix):
+    result = {}
+    for name in sorted(os.listdir(directory)):
+        path = os.path.join(directory, name)
+        if not name.startswith(prefix) or not os.path.isfile(path):
+            continue
+        with open(path, 'rb') as f:
+            digest = hashlib.sha256(f.read()).hexdigest()
+        result[name] = [os.stat(path).st_mtime_ns, digest]
+    return result
+
+
+def main(args):
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('snapshot', help='file holding the last snapshot.')
+    parser.add_argument('directory', help='directory to look at.')
+    parser.add_argument('--prefix', default='',
+                        help='only look at files whose names start with '
+                        'PREFIX.')
+    options = parser.parse_args(args)
+
+    old = {}
+    if os.path.exists(options.snapshot):
+        with open(options.snapshot) as f:
+            old = json.load(f)
+    new = Snapshot(options.directory, options.prefix)
+    changed = [name for name in new if old.get(name) != new[name]]
+    print('changed: %s' % (' '.join(changed) if changed else '(none)'))
+    with open(options.snapshot, 'w') as f:
+        json.dump(new, f)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
@@ -90,15 +90,14 @@ def MangleTypes(types):
     return ''.join(MangleType(t) for t in types)
 
 
-def MangleName(s):
-    def Mangle(match):
-        s = match.group(0)
-        return b'Z%02X' % s[0]
-
-    # NOTE(binji): Z is not allowed.
-    pattern = b'([^_a-zA-Y0-9])'
-    result = 'Z_' + re.sub(pattern, Mangle, s.encode('utf-8')).decode('utf-8')
-    return result
+def LegalizeName(s):
+    # Matches CWriter::LegalizeName: exported functions and globals are named
+    # after their export when the binary has no debug names.
+    if not s:
+        return 'w2c__'
+    result = s[0] if s[0].isalpha() else '_'
+    result += re.sub(r'[^a-zA-Z0-9]', '_', s[1:])
+    return 'w2c_' + result
 
 
 def IsModuleCommand(command):
@@ -107,88 +106,54 @@ def IsModuleCommand(command):
 
 
 class CWriter(object):
+    """Writes the main .c file that runs the commands of one module.
+
+    The functions of every module are all named w2c_<name>, so each module is
+    linked into its own executable, which runs the commands that follow it in
+    the .wast file."""
 
-    def __init__(self, spec_json, prefix, out_file, out_dir):
-        self.source_filename = os.path.basename(spec_json['source_filename'])
-        self.commands = spec_json['commands']
+    def __init__(self, source_filename, module_command, commands, prefix,
+                 driver, out_file):
+        self.source_filename = source_filename
+        self.module_command = module_command
+        self.commands = commands
         self.out_file = out_file
-        self.out_dir = out_dir
         self.prefix = prefix
-        self.module_idx = 0
-        self.module_name_to_idx = {}
-        self.module_prefix_map = {}
+        self.driver = driver
 
     def Write(self):
-        self._MaybeWriteDummyModule()
-        self._CacheModulePrefixes()
         self._WriteIncludes()
         self.out_file.write(self.prefix)
-        self.out_file.write("\nvoid run_spec_tests(void) {\n\n")
+        self.out_file.write(self.driver)
+        self.out_file.write('\nstatic void run_spec_tests(void) {\n')
+        self.out_file.write('  wasm2c_sandbox_funcs_t funcs = get_wasm2c_sandbox_info();\n')
+        self.out_file.write('  if (!funcs.wasm_rt_sys_init()) {\n')
+        self.out_file.write('    error(__FILE__, __LINE__, "could not install the fault handler.\\n");\n')
+        self.out_file.write('    g_tests_run++;\n')
+        self.out_file.write('    return;\n')
+        self.out_file.write('  }\n')
+        self.out_file.write('  wasm2c_sandbox_t* sbx = (wasm2c_sandbox_t*)funcs.create_wasm2c_sandbox(0);\n')
+        self.out_file.write('  if (!sbx) {\n')
+        self.out_file.write('    error(__FILE__, __LINE__, "could not create the sandbox.\\n");\n')
+        self.out_file.write('    g_tests_run++;\n')
+        self.out_file.write('    return;\n')
+        self.out_file.write('  }\n\n')
         for command in self.commands:
             self._WriteCommand(command)
-        self.out_file.write("\n}\n")
-
-    def GetModuleFilenames(self):
-        return [c['filename'] for c in self.commands if IsModuleCommand(c)]
-
-    def GetModulePrefix(self, idx_or_name=None):
-        if idx_or_name is not None:
-            return self.module_prefix_map[idx_or_name]
-        return self.module_prefix_map[self.module_idx - 1]
-
-    def _CacheModulePrefixes(self):
-        idx = 0
-        for command in self.commands:
-            if IsModuleCommand(command):
-                name = os.path.basename(command['filename'])
-                name = os.path.splitext(name)[0]
-                name = re.sub(r'[^a-zA-Z0-9_]', '_', name)
-                name = MangleName(name)
-
-                self.module_prefix_map[idx] = name
-
-                if 'name' in command:
-                    self.module_name_to_idx[command['name']] = idx
-                    self.module_prefix_map[command['name']] = name
-
-                idx += 1
-            elif command['type'] == 'register':
-                name = MangleName(command['as'])
-                if 'name' in command:
-                    self.module_prefix_map[command['name']] = name
-                    name_idx = self.module_name_to_idx[command['name']]
-                else:
-                    name_idx = idx - 1
-
-                self.module_prefix_map[name_idx] = name
-
-    def _MaybeWriteDummyModule(self):
-        if len(self.GetModuleFilenames()) == 0:
-            # This test doesn't have any valid modules, so just use a dummy instead.
-            filename = utils.ChangeExt(self.source_filename, '-dummy.wasm')
-            with open(os.path.join(self.out_dir, filename), 'wb') as wasm_file:
-                wasm_file.write(b'\x00\x61\x73\x6d\x01\x00\x00\x00')
-
-            dummy_command = {'type': 'module', 'line': 0, 'filename': filename}
-            self.commands.insert(0, dummy_command)
+        if self.driver:
+            self.out_file.write('  run_driver_tests(&funcs, sbx);\n')
+        self.out_file.write('  funcs.destroy_wasm2c_sandbox(sbx);\n')
+        self.out_file.write('}\n')
 
     def _WriteFileAndLine(self, command):
-        self.out_file.write('// %s:%d\n' % (self.source_filename, command['line']))
+        self.out_file.write('  // %s:%d\n' % (self.source_filename, command['line']))
 
     def _WriteIncludes(self):
-        idx = 0
-        for filename in self.GetModuleFilenames():
-            header = os.path.splitext(filename)[0] + '.h'
-            self.out_file.write(
-                '#define WASM_RT_MODULE_PREFIX %s\n' % self.GetModulePrefix(idx))
-            self.out_file.write("#include \"%s\"\n" % header)
-            self.out_file.write('#undef WASM_RT_MODULE_PREFIX\n\n')
-            idx += 1
+        header = os.path.splitext(self.module_command['filename'])[0] + '.h'
+        self.out_file.write('#include "%s"\n' % header)
 
     def _WriteCommand(self, command):
         command_funcs = {
-            'module': self._WriteModuleCommand,
-            'assert_uninstantiable': self._WriteAssertUninstantiableCommand,
             'action': self._WriteActionCommand,
             'assert_return': self._WriteAssertReturnCommand,
             'assert_trap': self._WriteAssertActionCommand,
@@ -200,17 +165,12 @@ class CWriter(object):
             self._WriteFileAndLine(command)
             func(command)
             self.out_file.write('\n')
-
-    def _WriteModuleCommand(self, command):
-        self.module_idx += 1
-        self.out_file.write('%sinit();\n' % self.GetModulePrefix())
-
-    def _WriteAssertUninstantiableCommand(self, command):
-        self.module_idx += 1
-        self.out_file.write('ASSERT_TRAP(%sinit());\n' % self.GetModulePrefix())
+        elif command['type'] == 'register':
+            raise Error('%s:%d: register is not supported' %
+                        (self.source_filename, command['line']))
 
     def _WriteActionCommand(self, command):
-        self.out_file.write('%s;\n' % self._Action(command))
+        self.out_file.write('  ASSERT_RETURN(%s);\n' % self._Action(command))
 
     def _WriteAssertReturnCommand(self, command):
         expected = command['expected']
@@ -223,39 +183,33 @@ class CWriter(object):
                     'f64': 'ASSERT_RETURN_CANONICAL_NAN_F64',
                 }
                 assert_macro = assert_map[(type_)]
-                self.out_file.write('%s(%s);\n' % (assert_macro, self._Action(command)))
+                self.out_file.write('  %s(%s);\n' % (assert_macro, self._Action(command)))
             elif value == 'nan:arithmetic':
                 assert_map = {
                     'f32': 'ASSERT_RETURN_ARITHMETIC_NAN_F32',
                     'f64': 'ASSERT_RETURN_ARITHMETIC_NAN_F64',
                 }
                 assert_macro = assert_map[(type_)]
-                self.out_file.write('%s(%s);\n' % (assert_macro, self._Action(command)))
+                self.out_file.write('  %s(%s);\n' % (assert_macro, self._Action(command)))
             else:
                 assert_map = {
                     'i32': 'ASSERT_RETURN_I32',
                     'f32': 'ASSERT_RETURN_F32',
                     'i64': 'ASSERT_RETURN_I64',
                     'f64': 'ASSERT_RETURN_F64',
+                    'v128': 'ASSERT_RETURN_V128',
                 }
 
                 assert_macro = assert_map[type_]
-                self.out_file.write('%s(%s, %s);\n' %
+                self.out_file.write('  %s(%s, %s);\n' %
                                     (assert_macro,
                                      self._Action(command),
                                      self._ConstantList(expected)))
         elif len(expected) == 0:
             self._WriteAssertActionCommand(command)
         else:
-            result_types = [result['type'] for result in expected]
-            # type, fmt, f, compare, expected, found
-            self.out_file.write('ASSERT_RETURN_MULTI_T(%s, %s, %s, %s, (%s), (%s));\n' %
-                                ("struct wasm_multi_" + MangleTypes(result_types),
-                                 " ".join("MULTI_" + ty for ty in result_types),
-                                 self._Action(command),
-                                 self._CompareList(expected),
-                                 self._ConstantList(expected),
-                                 self._FoundList(result_types)))
+            raise Error('%s:%d: multiple results are not supported' %
+                        (self.source_filename, command['line']))
 
     def _WriteAssertActionCommand(self, command):
         assert_map = {
@@ -265,7 +219,7 @@ class CWriter(object):
         }
 
         assert_macro = assert_map[command['type']]
-        self.out_file.write('%s(%s);\n' % (assert_macro, self._Action(command)))
+        self.out_file.write('  %s(%s);\n' % (assert_macro, self._Action(command)))
 
     def _Constant(self, const):
         type_ = const['type']
@@ -280,52 +234,52 @@ class CWriter(object):
             return F32ToC(int(value))
         elif type_ == 'f64':
             return F64ToC(int(value))
+        elif type_ == 'v128':
+            return V128ToC(const)
         else:
             assert False
 
     def _ConstantList(self, consts):
         return ', '.join(self._Constant(const) for const in consts)
 
-    def _Found(self, num, type_):
-        return "actual.%s%s" % (MangleType(type_), num)
-
-    def _FoundList(self, types):
-        return ', '.join(self._Found(num, type_) for num, type_ in enumerate(types))
-
-    def _Compare(self, num, const):
-        return "is_equal_%s(%s, %s)" % (const['type'],
-                                        self._Constant(const),
-                                        self._Found(num, const['type']))
-
-    def _CompareList(self, consts):
-        return ' && '.join(self._Compare(num, const) for num, const in enumerate(consts))
-
-    def _ActionSig(self, action, expected):
-        type_ = action['type']
-        result_types = [result['type'] for result in expected]
-        arg_types = [arg['type'] for arg in action.get('args', [])]
-        if type_ == 'invoke':
-            return MangleTypes(result_types) + MangleTypes(arg_types)
-        elif type_ == 'get':
-            return MangleType(result_types[0])
-        else:
-            raise Error('Unexpected action type: %s' % type_)
-
     def _Action(self, command):
         action = command['action']
-        expected = command['expected']
         type_ = action['type']
-        mangled_module_name = self.GetModulePrefix(action.get('module'))
-        field = (mangled_module_name + MangleName(action['field']) +
-                 MangleName(self._ActionSig(action, expected)))
+        module_name = action.get('module')
+        if module_name is not None and module_name != self.module_command.get('name'):
+            raise Error('%s:%d: only the last module can be used' %
+                        (self.source_filename, command['line']))
+        name = LegalizeName(action['field'])
         if type_ == 'invoke':
-            return '%s(%s)' % (field, self._ConstantList(action.get('args', [])))
+            args = ['sbx'] + [self._Constant(arg) for arg in action.get('args', [])]
+            return '%s(%s)' % (name, ', '.join(args))
         elif type_ == 'get':
-            return '*%s' % field
+            c_type = command['expected'][0]['type']
+            return ('*(%s*)funcs.lookup_wasm2c_nonfunc_export(sbx, "%s")' %
+                    ({'i32': 'u32', 'i64': 'u64'}.get(c_type, c_type), name))
         else:
             raise Error('Unexpected action type: %s' % type_)
 
 
+def V128ToC(const):
+    lane_type = const['lane_type']
+    lanes = const['value']
+    lane_bits = {'i8': 8, 'i16': 16, 'i32': 32, 'i64': 64, 'f32': 32, 'f64': 64}[lane_type]
+    value = 0
+    for i, lane in enumerate(lanes):
+        value |= (int(lane) & ((1 << lane_bits) - 1)) << (i * lane_bits)
+    return 'make_v128(0x%016xull, 0x%016xull)' % (value & 0xffffffffffffffff, value >> 64)
+
+
+def NumOutputs(wasm2c_flags):
+    num_outputs = 1
+    for i, flag in enumerate(wasm2c_flags):
+        match = re.match(r'--num-outputs(?:=(\d+))?$', flag)
+        if match:
+            num_outputs = int(match.group(1) or wasm2c_flags[i + 1])
+    return num_outputs
+
+
 def Compile(cc, c_filename, out_dir, *args):
     out_dir = os.path.abspath(out_dir)
     o_filename = utils.ChangeDir(utils.ChangeExt(c_filename, '.o'), out_dir)
@@ -338,6 +292,20 @@ def Link(cc, o_filenames, main_exe, out_dir, *args):
     cc.RunWithArgs(*args, cwd=out_dir)
 
 
+def SplitByModule(commands):
+    """Returns a list of (module command, commands that follow it)."""
+    groups = []
+    for command in commands:
+        if IsModuleCommand(command):
+            groups.append((command, []))
+        elif groups:
+            groups[-1][1].append(command)
+        elif command['type'] not in ('assert_invalid', 'assert_malformed',
+                                     'assert_unlinkable'):
+            raise Error('%d: command before the first module' % command['line'])
+    return groups
+
+
 def main(args):
     parser = argparse.ArgumentParser()
     parser.add_argument('-o', '--out-dir', metavar='PATH',
@@ -351,9 +319,14 @@ def main(args):
                         help='directory with wasm-rt files', default=WASM2C_DIR)
     parser.add_argument('--cc', metavar='PATH',
                         help='the path to the C compiler', default='cc')
+    parser.add_argument('--cxx', metavar='PATH',
+                        help='the path to the C++ compiler', default='c++')
     parser.add_argument('--cflags', metavar='FLAGS',
                         help='additional flags for C compiler.',
                         action='append', default=[])
+    parser.add_argument('--wasm2c-flags', metavar='FLAGS',
+                        help='additional flags for wasm2c.',
+                        action='append', default=[])
     parser.add_argument('--compile', help='compile the C code (default)',
                         dest='compile', action='store_true')
     parser.add_argument('--no-compile', help='don\'t compile the C code',
@@ -370,15 +343,41 @@ def main(args):
     parser.add_argument('-p', '--print-cmd',
                         help='print the commands that are run.',
                         action='store_true')
+    parser.add_argument('--driver', metavar='PATH',
+                        help='C file appended to the main .c file. It must '
+                        'define run_driver_tests(), which is called with the '
+                        'sandbox after the commands of each module.')
+    parser.add_argument('--profile-use', metavar='PATH',
+                        help='profile to pass to wasm2c --profile-use. '
+                        'Unlike --wasm2c-flags, the path is relative to the '
+                        'current directory rather than the output directory.')
+    parser.add_argument('--shadow-memory',
+                        help='build with the shadow memory checker.',
+                        action='store_true')
+    parser.add_argument('--debug-names',
+                        help='keep the names of the text format, so wasm2c '
+                        'names functions after them.',
+                        action='store_true')
+    parser.add_argument('--enable-threads', action='store_true')
+    parser.add_argument('--enable-bulk-memory', action='store_true')
+    parser.add_argument('--enable-tail-call', action='store_true')
     parser.add_argument('file', help='wast file.')
     options = parser.parse_args(args)
 
+    features = {
+        '--enable-threads': options.enable_threads,
+        '--enable-bulk-memory': options.enable_bulk_memory,
+        '--enable-tail-call': options.enable_tail_call,
+    }
+
     with utils.TempDirectory(options.out_dir, 'run-spec-wasm2c-') as out_dir:
         # Parse JSON file and generate main .c file with calls to test functions.
         wast2json = utils.Executable(
             find_exe.GetWast2JsonExecutable(options.bindir),
             error_cmdline=options.error_cmdline)
         wast2json.AppendOptionalArgs({'-v': options.verbose})
+        wast2json.AppendOptionalArgs(features)
+        wast2json.AppendOptionalArgs({'--debug-names': options.debug_names})
 
         json_file_path = utils.ChangeDir(
             utils.ChangeExt(options.file, '.json'), out_dir)
@@ -386,9 +385,21 @@ def main(args):
 
         wasm2c = utils.Executable(
             find_exe.GetWasm2CExecutable(options.bindir),
+            *options.wasm2c_flags,
             error_cmdline=options.error_cmdline)
-
-        cc = utils.Executable(options.cc, *options.cflags)
+        if options.profile_use:
+            wasm2c.AppendArg(
+                '--profile-use=' + os.path.abspath(options.profile_use))
+        wasm2c.AppendOptionalArgs(features)
+
+        cflags = list(options.cflags)
+        if options.shadow_memory:
+            cflags.append('-DWASM_CHECK_SHADOW_MEMORY')
+        cc = utils.Executable(options.cc, *cflags)
+        # The shadow memory checker is written in C++, so it must also be
+        # linked as C++.
+        cxx = utils.Executable(options.cxx, *cflags)
+        linker = cxx if options.shadow_memory else cc
 
         with open(json_file_path) as json_file:
             spec_json = json.load(json_file)
@@ -398,37 +409,74 @@ def main(args):
             with open(options.prefix) as prefix_file:
                 prefix = prefix_file.read() + '\n'
 
-        output = io.StringIO()
-        cwriter = CWriter(spec_json, prefix, output, out_dir)
-        cwriter.Write()
-
-        main_filename = utils.ChangeExt(json_file_path, '-main.c')
-        with open(main_filename, 'w') as out_main_file:
-            out_main_file.write(output.getvalue())
+        driver = ''
+        if options.driver:
+            with open(options.driver) as driver_file:
+                driver = driver_file.read() + '\n'
 
-        o_filenames = []
+        source_filename = os.path.basename(spec_json['source_filename'])
         includes = '-I%s' % options.wasmrt_dir
 
-        # Compile wasm-rt-impl.
-        wasm_rt_impl_c = os.path.join(options.wasmrt_dir, 'wasm-rt-impl.c')
-        o_filenames.append(Compile(cc, wasm_rt_impl_c, out_dir, includes))
+        # Compile the runtime.
+        rt_o_filenames = []
+        os_c = 'wasm-rt-os-win.c' if sys.platform == 'win32' else 'wasm-rt-os-unix.c'
+        for rt_c in ('wasm-rt-impl.c', os_c, 'wasm-rt-wasi.c'):
+            rt_c = os.path.join(options.wasmrt_dir, rt_c)
+            if options.compile:
+                rt_o_filenames.append(Compile(cc, rt_c, out_dir, includes))
+        if options.shadow_memory and options.compile:
+            rt_c = os.path.join(options.wasmrt_dir, 'wasm-rt-shadow.cpp')
+            rt_o_filenames.append(Compile(cxx, rt_c, out_dir, includes))
+
+        num_outputs = NumOutputs(options.wasm2c_flags)
+
+        tests_passed = 0
+        tests_run = 0
+        for module_command, commands in SplitByModule(spec_json['commands']):
+            output = io.StringIO()
+            cwriter = CWriter(source_filename, module_command, commands, prefix,
+                              driver, output)
+            cwriter.Write()
+
+            wasm_filename = module_command['filename']
+            main_filename = utils.ChangeExt(wasm_filename, '-main.c')
+            with open(os.path.join(out_dir, main_filename), 'w') as out_main_file:
+                out_main_file.write(output.getvalue())
 
-        for i, wasm_filename in enumerate(cwriter.GetModuleFilenames()):
             c_filename = utils.ChangeExt(wasm_filename, '.c')
             wasm2c.RunWithArgs(wasm_filename, '-o', c_filename, cwd=out_dir)
-            if options.compile:
-                defines = '-DWASM_RT_MODULE_PREFIX=%s' % cwriter.GetModulePrefix(i)
-                o_filenames.append(Compile(cc, c_filename, out_dir, includes, defines))
-
-        if options.compile:
-            main_c = os.path.basename(main_filename)
-            o_filenames.append(Compile(cc, main_c, out_dir, includes, defines))
-            main_exe = os.path.basename(utils.ChangeExt(json_file_path, ''))
-            Link(cc, o_filenames, main_exe, out_dir, '-lm')
+            if not options.compile:
+                continue
+
+            # With --num-outputs=N, wasm2c writes <name>_0.c .. <name>_N-1.c
+            # instead of <name>.c.
+            if num_outputs > 1:
+                c_filenames = ['%s_%d.c' % (os.path.splitext(c_filename)[0], i)
+                               for i in range(num_outputs)]
+            else:
+                c_filenames = [c_filename]
+
+            o_filenames = list(rt_o_filenames)
+            for filename in c_filenames:
+                o_filenames.append(Compile(cc, filename, out_dir, includes))
+            o_filenames.append(Compile(cc, main_filename, out_dir, includes))
+            main_exe = utils.ChangeExt(wasm_filename, '')
+            Link(linker, o_filenames, main_exe, out_dir, '-lm', '-lpthread')
+
+            if options.run:
+                exe = utils.Executable(os.path.join(out_dir, main_exe),
+                                       forward_stderr=True,
+                                       error_cmdline=options.error_cmdline)
+                stdout = exe.RunWithArgsForStdout()
+                match = re.search(r'(\d+)/(\d+) tests passed', stdout)
+                if not match:
+                    raise Error('unexpected output from %s:\n%s' % (main_exe, stdout))
+                tests_passed += int(match.group(1))
+                tests_run += int(match.group(2))
 
         if options.compile and options.run:
-            utils.Executable(os.path.join(out_dir, main_exe),
-                             forward_stdout=True).RunWithArgs()
+            print('%d/%d tests passed.' % (tests_passed, tests_run))
+            return tests_passed != tests_run
 
     return 0
 
@@ -944,6 +944,7 @@ def main(args):
     variables['bindir'] = options.bindir
     variables['gen_wasm_py'] = os.path.join(TEST_DIR, 'gen-wasm.py')
     variables['gen_spec_js_py'] = os.path.join(TEST_DIR, 'gen-spec-js.py')
+    variables['changed_files_py'] = os.path.join(TEST_DIR, 'changed-files.py')
     for exe_basename in find_exe.EXECUTABLES:
         exe_override = os.path.join(options.bindir, exe_basename)
         variables[exe_basename] = find_exe.FindExecutable(exe_basename,
@@ -0,0 +1,57 @@
+/* call_indirect compares the type of the element with a constant, which must
+ * be the index the runtime registers for that signature: host callbacks are
+ * added with the registered index. The reason for a failed call is also
+ * reported. */
+
+static wasm_rt_trap_t trap_of_call(wasm2c_sandbox_t* sbx, u32 index) {
+  wasm_rt_jmp_buf jb;
+  wasm_rt_try(jb) {
+    w2c_call_unary(sbx, index, 0);
+    wasm_rt_end_try(jb);
+  }
+  return jb.trap;
+}
+
+static u32 host_triple(wasm2c_sandbox_t* sbx, u32 x) {
+  (void)sbx;
+  return x * 3;
+}
+
+static f64 host_f64(wasm2c_sandbox_t* sbx, f64 x, f32 y) {
+  (void)sbx;
+  return x + y;
+}
+
+static u64 host_many(wasm2c_sandbox_t* sbx, u32 a, u32 b, u32 c, u32 d, u32 e,
+                     u32 f, u32 g, u32 h, u32 i) {
+  (void)sbx;
+  return (u64)a + b + c + d + e + f + g + h + i;
+}
+
+static void run_driver_tests(wasm2c_sandbox_funcs_t* funcs,
+                             wasm2c_sandbox_t* sbx) {
+  ASSERT_TRUE(trap_of_call(sbx, 0) == WASM_RT_TRAP_NONE);
+  ASSERT_TRUE(trap_of_call(sbx, 1) == WASM_RT_TRAP_CALL_INDIRECT_TYPE_MISMATCH);
+  ASSERT_TRUE(trap_of_call(sbx, 3) == WASM_RT_TRAP_CALL_INDIRECT_NULL_PTR);
+  ASSERT_TRUE(trap_of_call(sbx, 100) == WASM_RT_TRAP_CALL_INDIRECT_OOB_INDEX);
+
+  wasm_rt_type_t i32_to_i32[] = {WASM_RT_I32, WASM_RT_I32};
+  wasm_rt_type_t f64_f32_to_f64[] = {WASM_RT_F64, WASM_RT_F32, WASM_RT_F64};
+  wasm_rt_type_t many[] = {WASM_RT_I32, WASM_RT_I32, WASM_RT_I32, WASM_RT_I32,
+                           WASM_RT_I32, WASM_RT_I32, WASM_RT_I32, WASM_RT_I32,
+                           WASM_RT_I32, WASM_RT_I64};
+  u32 triple = funcs->add_wasm2c_callback(
+      sbx, funcs->lookup_wasm2c_func_index(sbx, 1, 1, i32_to_i32),
+      (void*)&host_triple, WASM_RT_EXTERNAL_FUNCTION);
+  u32 add = funcs->add_wasm2c_callback(
+      sbx, funcs->lookup_wasm2c_func_index(sbx, 2, 1, f64_f32_to_f64),
+      (void*)&host_f64, WASM_RT_EXTERNAL_FUNCTION);
+  u32 sum = funcs->add_wasm2c_callback(
+      sbx, funcs->lookup_wasm2c_func_index(sbx, 9, 1, many),
+      (void*)&host_many, WASM_RT_EXTERNAL_FUNCTION);
+  ASSERT_RETURN_I32(w2c_call_unary(sbx, triple, 5), 15u);
+  ASSERT_RETURN_F64(w2c_call_f64(sbx, add, 1.5, 0.25f), 1.75);
+  ASSERT_RETURN_I64(w2c_call_many(sbx, sum), 45ull);
+  ASSERT_TRUE(trap_of_call(sbx, add) == WASM_RT_TRAP_CALL_INDIRECT_TYPE_MISMATCH);
+  ASSERT_TRUE(trap_of_call(sbx, sum) == WASM_RT_TRAP_CALL_INDIRECT_TYPE_MISMATCH);
+}
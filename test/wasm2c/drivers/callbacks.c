@@ -0,0 +1,88 @@
+/* add_wasm2c_callback hands out slots that are free, never 0, and reuses the
+ * slots of removed callbacks, growing the table when it runs out. */
+
+static u32 host_add(wasm2c_sandbox_t* sbx, u32 x) {
+  (void)sbx;
+  return x + 1000;
+}
+
+static wasm_rt_trap_t trap_of_call(wasm2c_sandbox_t* sbx, u32 index) {
+  wasm_rt_jmp_buf jb;
+  wasm_rt_try(jb) {
+    w2c_call(sbx, index, 0);
+    wasm_rt_end_try(jb);
+  }
+  return jb.trap;
+}
+
+static void run_driver_tests(wasm2c_sandbox_funcs_t* funcs,
+                             wasm2c_sandbox_t* sbx) {
+  wasm_rt_type_t i32_to_i32[] = {WASM_RT_I32, WASM_RT_I32};
+  u32 type = funcs->lookup_wasm2c_func_index(sbx, 1, 1, i32_to_i32);
+  wasm_rt_table_t* table =
+      (wasm_rt_table_t*)funcs->lookup_wasm2c_nonfunc_export(sbx, "w2c_T0");
+
+  /* Slot 0 and the elements of the module are taken. */
+  u32 callbacks[100];
+  bool distinct = true;
+  for (u32 i = 0; i < 100; i++) {
+    callbacks[i] = funcs->add_wasm2c_callback(sbx, type, (void*)&host_add,
+                                              WASM_RT_EXTERNAL_FUNCTION);
+    distinct = distinct && callbacks[i] != 0 && callbacks[i] != 1 &&
+               callbacks[i] != 3 && callbacks[i] < table->size;
+    for (u32 j = 0; j < i; j++) {
+      distinct = distinct && callbacks[j] != callbacks[i];
+    }
+  }
+  ASSERT_TRUE(distinct);
+  ASSERT_RETURN_I32(w2c_call(sbx, 1, 5), 6u);
+  ASSERT_RETURN_I32(w2c_call(sbx, 3, 5), 7u);
+  ASSERT_RETURN_I32(w2c_call(sbx, callbacks[0], 5), 1005u);
+  ASSERT_RETURN_I32(w2c_call(sbx, callbacks[99], 5), 1005u);
+
+  /* Removed callbacks can't be called, and their slots are handed out again,
+   * even when they are removed more than once. */
+  funcs->remove_wasm2c_callback(sbx, callbacks[10]);
+  funcs->remove_wasm2c_callback(sbx, callbacks[50]);
+  funcs->remove_wasm2c_callback(sbx, callbacks[50]);
+  ASSERT_TRUE(trap_of_call(sbx, callbacks[10]) ==
+              WASM_RT_TRAP_CALL_INDIRECT_NULL_PTR);
+  ASSERT_TRUE(trap_of_call(sbx, callbacks[50]) ==
+              WASM_RT_TRAP_CALL_INDIRECT_NULL_PTR);
+  u32 size = table->size;
+  u32 a = funcs->add_wasm2c_callback(sbx, type, (void*)&host_add,
+                                     WASM_RT_EXTERNAL_FUNCTION);
+  u32 b = funcs->add_wasm2c_callback(sbx, type, (void*)&host_add,
+                                     WASM_RT_EXTERNAL_FUNCTION);
+  ASSERT_TRUE(a != b && (a == callbacks[10] || a == callbacks[50]) &&
+              (b == callbacks[10] || b == callbacks[50]));
+  ASSERT_TRUE(table->size == size);
+  ASSERT_RETURN_I32(w2c_call(sbx, a, 1), 1001u);
+
+  /* Removing slot 0, an empty slot or one past the end does nothing. */
+  funcs->remove_wasm2c_callback(sbx, 0);
+  funcs->remove_wasm2c_callback(sbx, table->size);
+  funcs->remove_wasm2c_callback(sbx, table->size + 100);
+  u32 c = funcs->add_wasm2c_callback(sbx, type, (void*)&host_add,
+                                     WASM_RT_EXTERNAL_FUNCTION);
+  bool c_was_free = c != 0 && c != a && c != b;
+  for (u32 i = 0; i < 100; i++) {
+    c_was_free = c_was_free && (c != callbacks[i] || i == 10 || i == 50);
+  }
+  ASSERT_TRUE(c_was_free);
+
+  /* Removing everything and adding as many again reuses the same slots. */
+  funcs->remove_wasm2c_callback(sbx, a);
+  funcs->remove_wasm2c_callback(sbx, b);
+  funcs->remove_wasm2c_callback(sbx, c);
+  for (u32 i = 0; i < 100; i++) {
+    funcs->remove_wasm2c_callback(sbx, callbacks[i]);
+  }
+  size = table->size;
+  for (u32 i = 0; i < 101; i++) {
+    funcs->add_wasm2c_callback(sbx, type, (void*)&host_add,
+                               WASM_RT_EXTERNAL_FUNCTION);
+  }
+  ASSERT_TRUE(table->size == size);
+  ASSERT_RETURN_I32(w2c_call(sbx, 1, 5), 6u);
+}
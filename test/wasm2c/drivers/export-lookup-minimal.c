@@ -0,0 +1,25 @@
+/* export-lookup-minimal.txt has no exports, so only its memory and table can
+ * be looked up. */
+
+static void run_driver_tests(wasm2c_sandbox_funcs_t* funcs,
+                             wasm2c_sandbox_t* sbx) {
+  wasm_rt_memory_t* mem =
+      (wasm_rt_memory_t*)funcs->lookup_wasm2c_nonfunc_export(sbx, "w2c_M0");
+  ASSERT_TRUE(mem && mem->pages == 1 && !mem->is_shared);
+  wasm_rt_table_t* table =
+      (wasm_rt_table_t*)funcs->lookup_wasm2c_nonfunc_export(sbx, "w2c_T0");
+  ASSERT_TRUE(table && table->size == 0);
+
+  bool none_found = true;
+  for (u32 i = 0; i < 1000; i++) {
+    char name[32];
+    snprintf(name, sizeof(name), "w2c_f%u", i);
+    if (funcs->lookup_wasm2c_nonfunc_export(sbx, name) ||
+        funcs->lookup_wasm2c_func_export(sbx, name, NULL)) {
+      error(__FILE__, __LINE__, "found unknown export \"%s\".\n", name);
+      none_found = false;
+    }
+  }
+  ASSERT_TRUE(none_found);
+  ASSERT_TRUE(!funcs->lookup_wasm2c_func_export(sbx, "w2c_M0", NULL));
+}
@@ -0,0 +1,24 @@
+/* A shared memory is held through a pointer in the sandbox, which the lookup
+ * follows, so that a thread sandbox finds the memory of its parent. */
+
+static void run_driver_tests(wasm2c_sandbox_funcs_t* funcs,
+                             wasm2c_sandbox_t* sbx) {
+  wasm_rt_memory_t* mem =
+      (wasm_rt_memory_t*)funcs->lookup_wasm2c_nonfunc_export(sbx, "w2c_mem");
+  ASSERT_TRUE(mem && mem->is_shared && mem->pages == 1 && mem->max_pages == 2);
+  if (!mem) {
+    return;
+  }
+
+  u32 value = 0xdeadbeef;
+  w2c_store(sbx, 4, value);
+  ASSERT_TRUE(memcmp(mem->data + 4, &value, sizeof(value)) == 0);
+
+  wasm2c_sandbox_t* thread =
+      (wasm2c_sandbox_t*)funcs->create_wasm2c_sandbox_thread(sbx);
+  ASSERT_TRUE(thread != NULL);
+  if (thread) {
+    ASSERT_TRUE(funcs->lookup_wasm2c_nonfunc_export(thread, "w2c_mem") == mem);
+    funcs->destroy_wasm2c_sandbox(thread);
+  }
+}
@@ -0,0 +1,93 @@
+/* Looks up every memory, table, global and function of export-lookup.txt, and
+ * names that aren't exports. */
+
+static u32 func_type_of(wasm2c_sandbox_funcs_t* funcs,
+                        wasm2c_sandbox_t* sbx,
+                        const char* name) {
+  u32 func_type = 0;
+  funcs->lookup_wasm2c_func_export(sbx, name, &func_type);
+  return func_type;
+}
+
+static void run_driver_tests(wasm2c_sandbox_funcs_t* funcs,
+                             wasm2c_sandbox_t* sbx) {
+  wasm_rt_memory_t* mem =
+      (wasm_rt_memory_t*)funcs->lookup_wasm2c_nonfunc_export(sbx, "w2c_mem");
+  ASSERT_TRUE(mem && mem->pages == 1);
+  if (mem) {
+    u64 value = 0x0102030405060708ull;
+    w2c_store(sbx, 8, value);
+    ASSERT_TRUE(memcmp(mem->data + 8, &value, sizeof(value)) == 0);
+  }
+
+  wasm_rt_table_t* table =
+      (wasm_rt_table_t*)funcs->lookup_wasm2c_nonfunc_export(sbx, "w2c_T0");
+  ASSERT_TRUE(table && table->size == 2);
+
+  u32* counter = (u32*)funcs->lookup_wasm2c_nonfunc_export(sbx, "w2c_counter");
+  ASSERT_TRUE(counter && *counter == 7);
+  u64* big = (u64*)funcs->lookup_wasm2c_nonfunc_export(sbx, "w2c_big");
+  ASSERT_TRUE(big && *big == 0x123456789ull);
+  f64* half = (f64*)funcs->lookup_wasm2c_nonfunc_export(sbx, "w2c_half");
+  ASSERT_TRUE(half && *half == 0.5);
+
+  /* Globals that aren't exported are found by their C name too, and writing
+   * through the pointer changes what the code reads. */
+  u32* hidden = (u32*)funcs->lookup_wasm2c_nonfunc_export(sbx, "w2c_g3");
+  ASSERT_TRUE(hidden && *hidden == 3);
+  if (hidden) {
+    *hidden = 9;
+    ASSERT_RETURN_I32(w2c_get_hidden(sbx), 9u);
+  }
+
+  wasm_rt_type_t i32_i32_to_i32[] = {WASM_RT_I32, WASM_RT_I32, WASM_RT_I32};
+  wasm_rt_type_t i32_i64[] = {WASM_RT_I32, WASM_RT_I64};
+  wasm_rt_type_t to_i32[] = {WASM_RT_I32};
+  ASSERT_TRUE(funcs->lookup_wasm2c_func_export(sbx, "w2c_add", NULL) ==
+              (wasm_rt_anyfunc_t)&w2c_add);
+  ASSERT_TRUE(func_type_of(funcs, sbx, "w2c_add") ==
+              funcs->lookup_wasm2c_func_index(sbx, 2, 1, i32_i32_to_i32));
+  ASSERT_TRUE(funcs->lookup_wasm2c_func_export(sbx, "w2c_store", NULL) ==
+              (wasm_rt_anyfunc_t)&w2c_store);
+  ASSERT_TRUE(func_type_of(funcs, sbx, "w2c_store") ==
+              funcs->lookup_wasm2c_func_index(sbx, 2, 0, i32_i64));
+  ASSERT_TRUE(funcs->lookup_wasm2c_func_export(sbx, "w2c_nop", NULL) ==
+              (wasm_rt_anyfunc_t)&w2c_nop);
+  ASSERT_TRUE(func_type_of(funcs, sbx, "w2c_nop") ==
+              funcs->lookup_wasm2c_func_index(sbx, 0, 0, NULL));
+  ASSERT_TRUE(funcs->lookup_wasm2c_func_export(sbx, "w2c_get_hidden", NULL) ==
+              (wasm_rt_anyfunc_t)&w2c_get_hidden);
+  ASSERT_TRUE(funcs->lookup_wasm2c_func_export(sbx, "w2c_f0", NULL) ==
+              (wasm_rt_anyfunc_t)&w2c_f0);
+  ASSERT_TRUE(func_type_of(funcs, sbx, "w2c_f0") ==
+              funcs->lookup_wasm2c_func_index(sbx, 0, 1, to_i32));
+
+  /* Each lookup only finds its own kind of export. */
+  ASSERT_TRUE(!funcs->lookup_wasm2c_nonfunc_export(sbx, "w2c_add"));
+  ASSERT_TRUE(!funcs->lookup_wasm2c_func_export(sbx, "w2c_mem", NULL));
+  ASSERT_TRUE(!funcs->lookup_wasm2c_func_export(sbx, "w2c_counter", NULL));
+
+  /* Unknown names, including prefixes and extensions of exports, and enough
+   * others that some of them hash to every slot. */
+  static const char* const unknown[] = {
+      "", "w2c_", "w2c_ad", "w2c_addd", "add", "mem", "w2c_T1", "w2c_g4",
+  };
+  bool none_found = true;
+  for (size_t i = 0; i < sizeof(unknown) / sizeof(unknown[0]); i++) {
+    if (funcs->lookup_wasm2c_nonfunc_export(sbx, unknown[i]) ||
+        funcs->lookup_wasm2c_func_export(sbx, unknown[i], NULL)) {
+      error(__FILE__, __LINE__, "found unknown export \"%s\".\n", unknown[i]);
+      none_found = false;
+    }
+  }
+  for (u32 i = 0; i < 1000; i++) {
+    char name[32];
+    snprintf(name, sizeof(name), "w2c_x%u", i);
+    if (funcs->lookup_wasm2c_nonfunc_export(sbx, name) ||
+        funcs->lookup_wasm2c_func_export(sbx, name, NULL)) {
+      error(__FILE__, __LINE__, "found unknown export \"%s\".\n", name);
+      none_found = false;
+    }
+  }
+  ASSERT_TRUE(none_found);
+}
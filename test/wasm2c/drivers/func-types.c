@@ -0,0 +1,105 @@
+/* Function types get the same index for the same signature, however and from
+ * whichever thread they are registered. Small signatures are encoded in the
+ * index itself, larger ones are numbered by the registry. */
+
+#include <pthread.h>
+
+#define SIGNATURE_COUNT 200
+#define THREAD_COUNT 8
+
+/* Nine params, which is too many for an inline index, whose types spell out
+ * `n` in base 4. */
+static void make_signature(u32 n, wasm_rt_type_t* types) {
+  for (u32 i = 0; i < 9; i++) {
+    types[i] = (wasm_rt_type_t)(n % 4);
+    n /= 4;
+  }
+  types[9] = WASM_RT_I32;
+}
+
+static u32 g_thread_ids[THREAD_COUNT][SIGNATURE_COUNT];
+
+static void* register_in_thread(void* arg) {
+  u32* ids = g_thread_ids[(size_t)arg];
+  for (u32 i = 0; i < SIGNATURE_COUNT; i++) {
+    /* Threads go through the signatures in different orders. */
+    u32 n = (i * 7 + (u32)(size_t)arg * 31) % SIGNATURE_COUNT;
+    wasm_rt_type_t types[10];
+    make_signature(n, types);
+    ids[n] = wasm_rt_register_func_type(9, 1, types);
+  }
+  return NULL;
+}
+
+static void run_driver_tests(wasm2c_sandbox_funcs_t* funcs,
+                             wasm2c_sandbox_t* sbx) {
+  wasm_rt_type_t i32_f32_to_i64[] = {WASM_RT_I32, WASM_RT_F32, WASM_RT_I64};
+  wasm_rt_type_t to_i64[] = {WASM_RT_I64};
+  ASSERT_TRUE(wasm_rt_register_func_type(2, 1, i32_f32_to_i64) == 0xa4000050u);
+  ASSERT_TRUE(wasm_rt_register_func_type(0, 1, to_i64) == 0x84000001u);
+  ASSERT_TRUE(wasm_rt_register_func_type(0, 0, NULL) == 0x80000000u);
+
+  /* The module's function types are the registered ones. */
+  wasm_rt_type_t many[10];
+  for (u32 i = 0; i < 9; i++) {
+    many[i] = WASM_RT_I32;
+  }
+  many[9] = WASM_RT_I64;
+  u32 many_id = wasm_rt_register_func_type(9, 1, many);
+  ASSERT_TRUE(many_id != 0 && !(many_id & WASM_RT_INLINE_FUNC_TYPE_BIT));
+  ASSERT_TRUE(funcs->lookup_wasm2c_func_index(sbx, 9, 1, many) == many_id);
+  u32 func_type = 0;
+  funcs->lookup_wasm2c_func_export(sbx, "w2c_many", &func_type);
+  ASSERT_TRUE(func_type == many_id);
+  func_type = 0;
+  funcs->lookup_wasm2c_func_export(sbx, "w2c_mixed", &func_type);
+  ASSERT_TRUE(func_type == wasm_rt_register_func_type(2, 1, i32_f32_to_i64));
+  wasm2c_sandbox_t* other = (wasm2c_sandbox_t*)funcs->create_wasm2c_sandbox(0);
+  if (other) {
+    func_type = 0;
+    funcs->lookup_wasm2c_func_export(other, "w2c_many", &func_type);
+    ASSERT_TRUE(func_type == many_id);
+    funcs->destroy_wasm2c_sandbox(other);
+  }
+
+  /* The signature is copied, and a different signature gets a different
+   * index. */
+  many[9] = WASM_RT_F64;
+  u32 other_id = wasm_rt_register_func_type(9, 1, many);
+  ASSERT_TRUE(other_id != 0 && other_id != many_id);
+  many[9] = WASM_RT_I64;
+  ASSERT_TRUE(wasm_rt_register_func_type(9, 1, many) == many_id);
+
+  /* Registering a list fills in the ids once. */
+  wasm_rt_func_sig_t sigs[] = {
+      {2, 1, i32_f32_to_i64},
+      {9, 1, many},
+  };
+  u32 ids[2] = {0, 0};
+  wasm_rt_register_func_types(sigs, 2, ids);
+  ASSERT_TRUE(ids[0] == 0xa4000050u && ids[1] == many_id);
+  wasm_rt_register_func_types(sigs, 2, ids);
+  ASSERT_TRUE(ids[0] == 0xa4000050u && ids[1] == many_id);
+
+  /* Threads that register the same signatures at once agree on their
+   * indices, which are all different. */
+  pthread_t threads[THREAD_COUNT];
+  for (size_t i = 0; i < THREAD_COUNT; i++) {
+    pthread_create(&threads[i], NULL, register_in_thread, (void*)i);
+  }
+  for (size_t i = 0; i < THREAD_COUNT; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  bool agree = true;
+  for (u32 n = 0; n < SIGNATURE_COUNT; n++) {
+    for (size_t i = 1; i < THREAD_COUNT; i++) {
+      agree = agree && g_thread_ids[i][n] == g_thread_ids[0][n];
+    }
+    for (u32 m = 0; m < n; m++) {
+      agree = agree && g_thread_ids[0][m] != g_thread_ids[0][n];
+    }
+    agree = agree && g_thread_ids[0][n] != 0 &&
+            !(g_thread_ids[0][n] & WASM_RT_INLINE_FUNC_TYPE_BIT);
+  }
+  ASSERT_TRUE(agree);
+}
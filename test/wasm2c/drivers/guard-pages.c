@@ -0,0 +1,54 @@
+/* Out-of-bounds accesses fault in the guard pages, and overflows of the
+ * native stack in the stack guard, which the fault handler turns into traps,
+ * in any thread and as often as they happen. */
+
+#include <pthread.h>
+
+static wasm_rt_trap_t trap_of_load(wasm2c_sandbox_t* sbx, u32 addr) {
+  wasm_rt_jmp_buf jb;
+  wasm_rt_try(jb) {
+    w2c_load(sbx, addr);
+    wasm_rt_end_try(jb);
+  }
+  return jb.trap;
+}
+
+static wasm_rt_trap_t trap_of_recursion(wasm2c_sandbox_t* sbx) {
+  wasm_rt_jmp_buf jb;
+  wasm_rt_try(jb) {
+    w2c_recurse(sbx, 0);
+    wasm_rt_end_try(jb);
+  }
+  return jb.trap;
+}
+
+static void* overflow_in_thread(void* sbx) {
+  static wasm_rt_trap_t traps[2];
+  traps[0] = trap_of_recursion((wasm2c_sandbox_t*)sbx);
+  traps[1] = trap_of_recursion((wasm2c_sandbox_t*)sbx);
+  wasm_rt_free_thread();
+  return traps;
+}
+
+static void run_driver_tests(wasm2c_sandbox_funcs_t* funcs,
+                             wasm2c_sandbox_t* sbx) {
+  (void)funcs;
+  ASSERT_TRUE(trap_of_load(sbx, 65536) == WASM_RT_TRAP_OOB);
+  ASSERT_TRUE(trap_of_load(sbx, 0x80000000u) == WASM_RT_TRAP_OOB);
+  ASSERT_TRUE(trap_of_load(sbx, 0xffffffffu) == WASM_RT_TRAP_OOB);
+  ASSERT_TRUE(trap_of_load(sbx, 65532) == WASM_RT_TRAP_NONE);
+
+  ASSERT_TRUE(trap_of_recursion(sbx) == WASM_RT_TRAP_EXHAUSTION);
+  ASSERT_TRUE(trap_of_recursion(sbx) == WASM_RT_TRAP_EXHAUSTION);
+  ASSERT_RETURN_I32(w2c_load(sbx, 0), 0u);
+
+  pthread_t thread;
+  void* result = NULL;
+  ASSERT_TRUE(pthread_create(&thread, NULL, overflow_in_thread, sbx) == 0 &&
+              pthread_join(thread, &result) == 0);
+  if (result) {
+    wasm_rt_trap_t* traps = (wasm_rt_trap_t*)result;
+    ASSERT_TRUE(traps[0] == WASM_RT_TRAP_EXHAUSTION);
+    ASSERT_TRUE(traps[1] == WASM_RT_TRAP_EXHAUSTION);
+  }
+}
@@ -0,0 +1,57 @@
+/* Checks the call stacks timed by --instrument=cycles in
+ * instrument-cycles.txt. The second call of top trapped in leaf, which must
+ * not leave its frames on the stack of the third call. */
+
+static bool dump_profile(wasm2c_sandbox_funcs_t* funcs,
+                         wasm2c_sandbox_t* sbx,
+                         wasm_rt_profile_format_t format,
+                         char* buf,
+                         size_t size) {
+  FILE* file = tmpfile();
+  if (!file) {
+    error(__FILE__, __LINE__, "could not create a temporary file.\n");
+    return false;
+  }
+  bool dumped = funcs->dump_wasm2c_profile(sbx, file, format);
+  rewind(file);
+  size_t length = fread(buf, 1, size - 1, file);
+  buf[length] = '\0';
+  fclose(file);
+  return dumped;
+}
+
+static void run_driver_tests(wasm2c_sandbox_funcs_t* funcs,
+                             wasm2c_sandbox_t* sbx) {
+  /* The calls are counted from the tree of call stacks. */
+  char buf[4096];
+  ASSERT_TRUE(dump_profile(funcs, sbx, WASM_RT_PROFILE_COUNTS, buf,
+                           sizeof(buf)));
+  unsigned long long calls[3] = {0, 0, 0};
+  char names[3][16] = {"", "", ""};
+  ASSERT_TRUE(sscanf(buf, "func %llu %*u %15s func %llu %*u %15s "
+                          "func %llu %*u %15s",
+                     &calls[0], names[0], &calls[1], names[1], &calls[2],
+                     names[2]) == 6);
+  ASSERT_TRUE(calls[0] == 3 && strcmp(names[0], "leaf") == 0);
+  ASSERT_TRUE(calls[1] == 3 && strcmp(names[1], "middle") == 0);
+  ASSERT_TRUE(calls[2] == 3 && strcmp(names[2], "top") == 0);
+
+  ASSERT_TRUE(dump_profile(funcs, sbx, WASM_RT_PROFILE_FLAT, buf,
+                           sizeof(buf)));
+  ASSERT_TRUE(strncmp(buf, "         calls   self%", 22) == 0);
+
+  /* Every stack starts at top, and top is only called from the outside. */
+  ASSERT_TRUE(dump_profile(funcs, sbx, WASM_RT_PROFILE_FOLDED, buf,
+                           sizeof(buf)));
+  bool found_leaf = false;
+  for (char* line = strtok(buf, "\n"); line; line = strtok(NULL, "\n")) {
+    if (strncmp(line, "top", 3) != 0 || strstr(line + 3, "top")) {
+      error(__FILE__, __LINE__, "unexpected stack \"%s\".\n", line);
+      g_tests_run++;
+    }
+    if (strncmp(line, "top;middle;leaf ", 16) == 0) {
+      found_leaf = true;
+    }
+  }
+  ASSERT_TRUE(found_leaf);
+}
@@ -0,0 +1,52 @@
+/* Checks the calls and branches counted by --instrument=calls,branches in
+ * instrument.txt, including those of a call that trapped. */
+
+/* Writes the profile of the sandbox in `format` to `buf`, returning false if
+ * dump_wasm2c_profile did. */
+static bool dump_profile(wasm2c_sandbox_funcs_t* funcs,
+                         wasm2c_sandbox_t* sbx,
+                         wasm_rt_profile_format_t format,
+                         char* buf,
+                         size_t size) {
+  FILE* file = tmpfile();
+  if (!file) {
+    error(__FILE__, __LINE__, "could not create a temporary file.\n");
+    return false;
+  }
+  bool dumped = funcs->dump_wasm2c_profile(sbx, file, format);
+  rewind(file);
+  size_t length = fread(buf, 1, size - 1, file);
+  buf[length] = '\0';
+  fclose(file);
+  return dumped;
+}
+
+static void run_driver_tests(wasm2c_sandbox_funcs_t* funcs,
+                             wasm2c_sandbox_t* sbx) {
+  /* parity is called five times by count_odd and once by trap_after. Its if
+   * saw three odd and three even numbers, and the br_if of count_odd left
+   * the loop once in six tries. */
+  char buf[4096];
+  ASSERT_TRUE(dump_profile(funcs, sbx, WASM_RT_PROFILE_COUNTS, buf,
+                           sizeof(buf)));
+  ASSERT_TRUE(strcmp(buf,
+                     "func 6 0 parity\n"
+                     "func 1 0 count_odd\n"
+                     "func 1 0 trap_after\n"
+                     "func 0 0 unused\n"
+                     "branch 0 3 3 parity\n"
+                     "branch 0 5 1 count_odd\n") == 0);
+
+  /* Functions that were never called are left out. */
+  ASSERT_TRUE(dump_profile(funcs, sbx, WASM_RT_PROFILE_FLAT, buf,
+                           sizeof(buf)));
+  ASSERT_TRUE(strcmp(buf,
+                     "         calls  function\n"
+                     "             6  parity\n"
+                     "             1  count_odd\n"
+                     "             1  trap_after\n") == 0);
+
+  /* Call stacks are only kept with --instrument=cycles. */
+  ASSERT_TRUE(!dump_profile(funcs, sbx, WASM_RT_PROFILE_FOLDED, buf,
+                            sizeof(buf)));
+}
@@ -0,0 +1,123 @@
+/* Sandboxes take their memory from the pool while it has free slots, and
+ * fall back to mapping it when it is exhausted. A slot is cleared when it is
+ * returned, and the pool can be used from several threads at once. */
+
+#include <pthread.h>
+
+static wasm_rt_memory_t* memory_of(wasm2c_sandbox_funcs_t* funcs,
+                                   wasm2c_sandbox_t* sbx) {
+  return (wasm_rt_memory_t*)funcs->lookup_wasm2c_nonfunc_export(sbx, "w2c_mem");
+}
+
+static u32 slots_in_use(void) {
+  wasm_rt_memory_pool_stats_t stats;
+  wasm_rt_get_memory_pool_stats(&stats);
+  return stats.slots_in_use;
+}
+
+static wasm2c_sandbox_funcs_t* g_funcs;
+static bool g_pool_created[8];
+
+static void* init_pool_in_thread(void* arg) {
+  g_pool_created[(size_t)arg] = wasm_rt_init_memory_pool(4);
+  return NULL;
+}
+
+static void* create_sandboxes_in_thread(void* arg) {
+  (void)arg;
+  for (u32 i = 0; i < 50; i++) {
+    wasm2c_sandbox_t* sbx = (wasm2c_sandbox_t*)g_funcs->create_wasm2c_sandbox(0);
+    if (!sbx) {
+      return (void*)1;
+    }
+    /* Every memory starts out cleared, however its slot was used before. */
+    if (w2c_load(sbx, 1024) != 0) {
+      return (void*)1;
+    }
+    w2c_store(sbx, 1024, i + 1);
+    g_funcs->destroy_wasm2c_sandbox(sbx);
+  }
+  return NULL;
+}
+
+static void run_driver_tests(wasm2c_sandbox_funcs_t* funcs,
+                             wasm2c_sandbox_t* sbx) {
+  g_funcs = funcs;
+  ASSERT_TRUE(!memory_of(funcs, sbx)->is_pooled);
+
+  ASSERT_TRUE(wasm_rt_init_memory_pool(2));
+  ASSERT_TRUE(!wasm_rt_init_memory_pool(2));
+  wasm_rt_memory_pool_stats_t stats;
+  wasm_rt_get_memory_pool_stats(&stats);
+  ASSERT_TRUE(stats.slot_count == 2 && stats.slots_in_use == 0);
+
+  wasm2c_sandbox_t* a = (wasm2c_sandbox_t*)funcs->create_wasm2c_sandbox(0);
+  wasm2c_sandbox_t* b = (wasm2c_sandbox_t*)funcs->create_wasm2c_sandbox(0);
+  wasm2c_sandbox_t* c = (wasm2c_sandbox_t*)funcs->create_wasm2c_sandbox(0);
+  if (!a || !b || !c) {
+    error(__FILE__, __LINE__, "could not create the sandboxes.\n");
+    return;
+  }
+  ASSERT_TRUE(memory_of(funcs, a)->is_pooled);
+  ASSERT_TRUE(memory_of(funcs, b)->is_pooled);
+  ASSERT_TRUE(!memory_of(funcs, c)->is_pooled);
+  wasm_rt_get_memory_pool_stats(&stats);
+  ASSERT_TRUE(stats.slots_in_use == 2 && stats.pool_allocations == 2 &&
+              stats.fallback_allocations == 1);
+
+  /* The pool can't be freed while its slots are in use. */
+  ASSERT_TRUE(!wasm_rt_free_memory_pool());
+
+  /* The slot of a is reused, without a's contents. */
+  u8* slot = memory_of(funcs, a)->data;
+  w2c_store(a, 1024, 42);
+  funcs->destroy_wasm2c_sandbox(a);
+  ASSERT_TRUE(slots_in_use() == 1);
+  wasm2c_sandbox_t* d = (wasm2c_sandbox_t*)funcs->create_wasm2c_sandbox(0);
+  ASSERT_TRUE(d && memory_of(funcs, d)->data == slot);
+  if (d) {
+    ASSERT_RETURN_I32(w2c_load(d, 1024), 0u);
+    /* Growing a pooled memory stays within its slot. */
+    ASSERT_RETURN_I32(w2c_grow(d, 3), 1u);
+    ASSERT_TRUE(memory_of(funcs, d)->data == slot);
+    ASSERT_RETURN(w2c_store(d, 4 * 65536 - 4, 7));
+    funcs->destroy_wasm2c_sandbox(d);
+  }
+  funcs->destroy_wasm2c_sandbox(b);
+  funcs->destroy_wasm2c_sandbox(c);
+  ASSERT_TRUE(slots_in_use() == 0);
+  ASSERT_TRUE(wasm_rt_free_memory_pool());
+  wasm_rt_get_memory_pool_stats(&stats);
+  ASSERT_TRUE(stats.slot_count == 0);
+
+  /* Only one of the threads that create the pool at once succeeds. */
+  pthread_t threads[8];
+  for (size_t i = 0; i < 8; i++) {
+    pthread_create(&threads[i], NULL, init_pool_in_thread, (void*)i);
+  }
+  u32 created = 0;
+  for (size_t i = 0; i < 8; i++) {
+    pthread_join(threads[i], NULL);
+    created += g_pool_created[i];
+  }
+  ASSERT_TRUE(created == 1);
+
+  /* More threads than slots create and destroy sandboxes at once. */
+  wasm_rt_get_memory_pool_stats(&stats);
+  u64 allocations = stats.pool_allocations + stats.fallback_allocations;
+  bool all_ok = true;
+  for (size_t i = 0; i < 8; i++) {
+    pthread_create(&threads[i], NULL, create_sandboxes_in_thread, NULL);
+  }
+  for (size_t i = 0; i < 8; i++) {
+    void* result;
+    pthread_join(threads[i], &result);
+    all_ok = all_ok && result == NULL;
+  }
+  ASSERT_TRUE(all_ok);
+  wasm_rt_get_memory_pool_stats(&stats);
+  ASSERT_TRUE(stats.slots_in_use == 0 &&
+              stats.pool_allocations + stats.fallback_allocations ==
+                  allocations + 400);
+  ASSERT_TRUE(wasm_rt_free_memory_pool());
+}
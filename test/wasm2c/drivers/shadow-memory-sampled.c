@@ -0,0 +1,54 @@
+/* With WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE, a bad access that is repeated
+ * is caught, allocations and frees are tracked on every call, and the
+ * functions given to --shadow-check-function are checked on every access. */
+
+#define ASSERT_SHADOW_MEM_TRAP(f)                                 \
+  do {                                                            \
+    g_tests_run++;                                                \
+    wasm_rt_jmp_buf jb;                                           \
+    wasm_rt_try(jb) {                                             \
+      (void)(f);                                                  \
+      wasm_rt_end_try(jb);                                        \
+      error(__FILE__, __LINE__, "expected " #f " to trap.\n");    \
+    } else if (jb.trap == WASM_RT_TRAP_SHADOW_MEM) {              \
+      g_tests_passed++;                                           \
+    } else {                                                      \
+      error(__FILE__, __LINE__,                                   \
+            "expected " #f                                        \
+            " to fail the shadow memory check, got trap code %d.\n", \
+            jb.trap);                                             \
+    }                                                             \
+  } while (0)
+
+static void run_driver_tests(wasm2c_sandbox_funcs_t* funcs,
+                             wasm2c_sandbox_t* sbx) {
+  wasm_rt_memory_t* mem =
+      (wasm_rt_memory_t*)funcs->lookup_wasm2c_nonfunc_export(sbx, "w2c_mem");
+  ASSERT_TRUE(mem != NULL);
+  if (!mem) {
+    return;
+  }
+  ASSERT_TRUE(mem->shadow_memory.sample_rate == 16);
+
+  u32 ptr = w2c_malloc(sbx, 16);
+  u32 other = w2c_malloc(sbx, 16);
+  ASSERT_RETURN(w2c_store(sbx, ptr, 5));
+  ASSERT_RETURN(w2c_store(sbx, other, 7));
+  ASSERT_RETURN_I32(w2c_load(sbx, ptr), 5u);
+  ASSERT_RETURN_I32(w2c_load_loop(sbx, other, 1000), 7000u);
+
+  /* Each countdown is at most 2 * 16 - 1 accesses long, so a read of freed
+   * memory that is repeated this often is always checked. */
+  w2c_free(sbx, ptr);
+  ASSERT_SHADOW_MEM_TRAP(w2c_load_loop(sbx, ptr, 1000));
+
+  /* Frees aren't sampled. */
+  ASSERT_SHADOW_MEM_TRAP(w2c_free(sbx, ptr));
+
+  /* Once the current countdown has run out, a rate this high leaves a
+   * single bad read unchecked, except in load_checked. */
+  wasm2c_shadow_memory_set_sample_rate(mem, 1u << 30);
+  ASSERT_RETURN_I32(w2c_load_loop(sbx, other, 64), 7u * 64);
+  ASSERT_RETURN_I32(w2c_load(sbx, ptr), 5u);
+  ASSERT_SHADOW_MEM_TRAP(w2c_load_checked(sbx, ptr));
+}
@@ -0,0 +1,72 @@
+/* A sandbox created from a snapshot starts out with the memory, globals and
+ * table the sandbox had when the snapshot was taken. The sandboxes created
+ * from one snapshot don't see each other's changes. */
+
+static u32 add_seven(wasm2c_sandbox_t* sbx, u32 x) {
+  (void)sbx;
+  return x + 7;
+}
+
+static void run_driver_tests(wasm2c_sandbox_funcs_t* funcs,
+                             wasm2c_sandbox_t* sbx) {
+  w2c_store(sbx, 100, 11);
+  ASSERT_RETURN_I32(w2c_grow(sbx, 1), 1u);
+  w2c_store(sbx, 65536 + 8, 12);
+  w2c_set_global(sbx, 13);
+  wasm_rt_type_t i32_to_i32[] = {WASM_RT_I32, WASM_RT_I32};
+  u32 callback = funcs->add_wasm2c_callback(
+      sbx, funcs->lookup_wasm2c_func_index(sbx, 1, 1, i32_to_i32),
+      (void*)&add_seven, WASM_RT_INTERNAL_FUNCTION);
+
+  void* snapshot = funcs->create_wasm2c_sandbox_snapshot(sbx);
+  ASSERT_TRUE(snapshot != NULL);
+  if (!snapshot) {
+    return;
+  }
+
+  /* Changes after the snapshot don't end up in the sandboxes created from
+   * it. */
+  w2c_store(sbx, 100, 21);
+  w2c_set_global(sbx, 23);
+  funcs->remove_wasm2c_callback(sbx, callback);
+
+  wasm2c_sandbox_t* first =
+      (wasm2c_sandbox_t*)funcs->create_wasm2c_sandbox_from_snapshot(snapshot, 0);
+  wasm2c_sandbox_t* second =
+      (wasm2c_sandbox_t*)funcs->create_wasm2c_sandbox_from_snapshot(snapshot, 0);
+  if (!first || !second) {
+    error(__FILE__, __LINE__, "could not create sandboxes from the snapshot.\n");
+    return;
+  }
+  ASSERT_RETURN_I32(w2c_load(first, 100), 11u);
+  ASSERT_RETURN_I32(w2c_load(first, 65536 + 8), 12u);
+  ASSERT_RETURN_I32(w2c_size(first), 2u);
+  ASSERT_RETURN_I32(w2c_get_global(first), 13u);
+  ASSERT_RETURN_I32(w2c_call(first, 0, 5), 6u);
+  ASSERT_RETURN_I32(w2c_call(first, callback, 5), 12u);
+  ASSERT_TRAP(w2c_load(first, 2 * 65536));
+
+  /* Each sandbox gets its own copy of the memory, globals and table. */
+  w2c_store(first, 100, 31);
+  w2c_store(first, 200, 32);
+  w2c_set_global(first, 33);
+  funcs->remove_wasm2c_callback(first, callback);
+  ASSERT_RETURN_I32(w2c_load(second, 100), 11u);
+  ASSERT_RETURN_I32(w2c_load(second, 200), 0u);
+  ASSERT_RETURN_I32(w2c_get_global(second), 13u);
+  ASSERT_RETURN_I32(w2c_call(second, callback, 5), 12u);
+  ASSERT_RETURN_I32(w2c_load(sbx, 100), 21u);
+  ASSERT_RETURN_I32(w2c_load(sbx, 200), 0u);
+  ASSERT_RETURN_I32(w2c_get_global(sbx), 23u);
+  ASSERT_TRAP(w2c_call(first, callback, 5));
+
+  /* The sandboxes outlive the snapshot, and can grow past its size. */
+  funcs->destroy_wasm2c_sandbox_snapshot(snapshot);
+  ASSERT_RETURN_I32(w2c_load(first, 100), 31u);
+  ASSERT_RETURN_I32(w2c_grow(second, 1), 2u);
+  ASSERT_RETURN(w2c_store(second, 2 * 65536 + 4, 41));
+  ASSERT_RETURN_I32(w2c_load(second, 2 * 65536 + 4), 41u);
+  ASSERT_RETURN_I32(w2c_load(second, 100), 11u);
+  funcs->destroy_wasm2c_sandbox(first);
+  funcs->destroy_wasm2c_sandbox(second);
+}
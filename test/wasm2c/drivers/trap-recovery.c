@@ -0,0 +1,67 @@
+/* A sandbox that trapped keeps working, and wasm_rt_try can be nested and
+ * used again after a trap. */
+
+static void run_driver_tests(wasm2c_sandbox_funcs_t* funcs,
+                             wasm2c_sandbox_t* sbx) {
+  (void)funcs;
+  wasm_rt_jmp_buf jb;
+
+  wasm_rt_try(jb) {
+    w2c_div(sbx, 1, 0);
+    wasm_rt_end_try(jb);
+    error(__FILE__, __LINE__, "expected w2c_div(sbx, 1, 0) to trap.\n");
+  }
+  ASSERT_TRUE(jb.trap == WASM_RT_TRAP_DIV_BY_ZERO);
+  ASSERT_RETURN_I32(w2c_div(sbx, 6, 3), 2u);
+
+  /* What the trapping call did before it trapped stays done. */
+  wasm_rt_try(jb) {
+    w2c_set_then_trap(sbx, 5);
+    wasm_rt_end_try(jb);
+    error(__FILE__, __LINE__, "expected w2c_set_then_trap to trap.\n");
+  }
+  ASSERT_TRUE(jb.trap == WASM_RT_TRAP_UNREACHABLE);
+  ASSERT_RETURN_I32(w2c_get(sbx), 5u);
+
+  /* A trap unwinds to the innermost wasm_rt_try only. */
+  bool inner_trapped = false;
+  bool outer_trapped = false;
+  wasm_rt_jmp_buf outer;
+  wasm_rt_try(outer) {
+    wasm_rt_jmp_buf inner;
+    wasm_rt_try(inner) {
+      w2c_div(sbx, 1, 0);
+      wasm_rt_end_try(inner);
+    } else {
+      inner_trapped = inner.trap == WASM_RT_TRAP_DIV_BY_ZERO;
+    }
+    w2c_div(sbx, 4, 2);
+    wasm_rt_end_try(outer);
+  } else {
+    outer_trapped = true;
+  }
+  ASSERT_TRUE(inner_trapped && !outer_trapped);
+
+  /* The call depth is restored to its value at wasm_rt_try. */
+  wasm_rt_call_stack_depth = 3;
+  wasm_rt_try(jb) {
+    wasm_rt_call_stack_depth = 100;
+    w2c_set_then_trap(sbx, 6);
+    wasm_rt_end_try(jb);
+  }
+  ASSERT_TRUE(wasm_rt_call_stack_depth == 3);
+  wasm_rt_call_stack_depth = 0;
+
+  /* Trapping over and over doesn't use up anything. */
+  u32 traps = 0;
+  for (u32 i = 0; i < 10000; i++) {
+    wasm_rt_try(jb) {
+      w2c_div(sbx, i, 0);
+      wasm_rt_end_try(jb);
+    } else {
+      traps++;
+    }
+  }
+  ASSERT_TRUE(traps == 10000);
+  ASSERT_RETURN_I32(w2c_div(sbx, 9, 3), 3u);
+}
@@ -0,0 +1,4 @@
+func 1000 0 parity
+func 1 0 count_odd
+branch 0 990 10 parity
+branch 2 1000 1 parity
@@ -0,0 +1,5 @@
+# Counts of a module that has nothing in common with profile-use.txt.
+func 500 0 main
+func 20 0 helper
+func 0 0 parser
+branch 0 5 15 helper
@@ -0,0 +1,6 @@
+# Counts of profile-use.txt, as written with WASM_RT_PROFILE_COUNTS.
+func 1000 0 parity
+func 1 0 count_odd
+func 0 0 unused
+branch 0 990 10 parity
+branch 0 1000 1 count_odd
@@ -0,0 +1,27 @@
+;; Indirect calls through a table of eight functions of the same type.
+(module
+  (type $i_i (func (param i32) (result i32)))
+  (table 8 funcref)
+  (memory 1)
+  (func $f0 (type $i_i) (i32.add (local.get 0) (i32.const 1)))
+  (func $f1 (type $i_i) (i32.xor (local.get 0) (i32.const 3)))
+  (func $f2 (type $i_i) (i32.sub (local.get 0) (i32.const 5)))
+  (func $f3 (type $i_i) (i32.add (local.get 0) (i32.const 7)))
+  (func $f4 (type $i_i) (i32.rotl (local.get 0) (i32.const 1)))
+  (func $f5 (type $i_i) (i32.add (local.get 0) (i32.const 11)))
+  (func $f6 (type $i_i) (i32.or (local.get 0) (i32.const 1)))
+  (func $f7 (type $i_i) (i32.mul (local.get 0) (i32.const 3)))
+  (elem (i32.const 0) $f0 $f1 $f2 $f3 $f4 $f5 $f6 $f7)
+
+  ;; Calls element `mask & i` on iteration i, so a mask of 0 always calls the
+  ;; same function and a mask of 7 cycles through all of them.
+  (func (export "run") (param $n i32) (param $mask i32) (result i32)
+    (local $i i32) (local $acc i32)
+    (loop $l
+      (local.set $acc
+        (call_indirect (type $i_i)
+          (local.get $acc)
+          (i32.and (local.get $i) (local.get $mask))))
+      (local.set $i (i32.add (local.get $i) (i32.const 1)))
+      (br_if $l (i32.lt_u (local.get $i) (local.get $n))))
+    (local.get $acc)))
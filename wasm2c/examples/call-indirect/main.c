@@ -0,0 +1,52 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "call-indirect.h"
+
+/* Measures the throughput of call_indirect, calling either the same function
+ * every time or each of eight functions in turn.
+ *
+ * Usage: call-indirect [iterations] */
+
+static double now_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void measure(void* sbx, const char* name, u32 iterations, u32 mask) {
+  double best = 0;
+  u32 result = 0;
+  for (int run = 0; run < 5; run++) {
+    double start = now_seconds();
+    result = w2c_run(sbx, iterations, mask);
+    double elapsed = now_seconds() - start;
+    if (run == 0 || elapsed < best) {
+      best = elapsed;
+    }
+  }
+  printf("%-12s %.3f ns per call (result %u)\n", name, best * 1e9 / iterations,
+         result);
+}
+
+int main(int argc, char** argv) {
+  u32 iterations = argc > 1 ? (u32)atoi(argv[1]) : 100000000;
+
+  wasm2c_sandbox_funcs_t funcs = get_wasm2c_sandbox_info();
+  if (!funcs.wasm_rt_sys_init()) {
+    fprintf(stderr, "wasm_rt_sys_init failed\n");
+    return 1;
+  }
+  void* sbx = funcs.create_wasm2c_sandbox(0);
+  if (!sbx) {
+    fprintf(stderr, "create_wasm2c_sandbox failed\n");
+    return 1;
+  }
+
+  measure(sbx, "same target", iterations, 0);
+  measure(sbx, "8 targets", iterations, 7);
+
+  funcs.destroy_wasm2c_sandbox(sbx);
+  return 0;
+}
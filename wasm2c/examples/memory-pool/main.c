@@ -0,0 +1,95 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "wasm-rt.h"
+
+/* Compares creating and destroying linear memories with and without the
+ * memory pool. Each thread repeatedly allocates a memory, writes to each of its
+ * initial pages like a freshly instantiated module would, and frees it.
+ *
+ * Usage: memory-pool [iterations] [threads] [initial pages] */
+
+static int s_iterations = 10000;
+static int s_threads = 4;
+static uint32_t s_initial_pages = 16;
+
+static double now_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void* run_thread(void* arg) {
+  (void)arg;
+  for (int i = 0; i < s_iterations; i++) {
+    wasm_rt_memory_t memory;
+    memset(&memory, 0, sizeof(memory));
+    if (!wasm_rt_allocate_memory(&memory, s_initial_pages, 0)) {
+      fprintf(stderr, "wasm_rt_allocate_memory failed\n");
+      exit(1);
+    }
+    for (uint32_t offset = 0; offset < memory.size; offset += 65536) {
+      if (memory.data[offset] != 0) {
+        fprintf(stderr, "memory was not cleared\n");
+        exit(1);
+      }
+      memory.data[offset] = 1;
+    }
+    wasm_rt_deallocate_memory(&memory);
+  }
+  return NULL;
+}
+
+static double run(const char* name) {
+  pthread_t* threads = calloc(s_threads, sizeof(pthread_t));
+  double start = now_seconds();
+  for (int i = 0; i < s_threads; i++) {
+    pthread_create(&threads[i], NULL, run_thread, NULL);
+  }
+  for (int i = 0; i < s_threads; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  double elapsed = now_seconds() - start;
+  free(threads);
+  double rate = s_iterations * (double)s_threads / elapsed;
+  printf("%-8s %10.0f memories/s\n", name, rate);
+  return rate;
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1) {
+    s_iterations = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    s_threads = atoi(argv[2]);
+  }
+  if (argc > 3) {
+    s_initial_pages = atoi(argv[3]);
+  }
+  printf("%d threads, %d iterations each, %u initial pages\n", s_threads,
+         s_iterations, s_initial_pages);
+
+  double mmap_rate = run("mmap");
+
+  if (!wasm_rt_init_memory_pool(s_threads)) {
+    fprintf(stderr, "wasm_rt_init_memory_pool failed\n");
+    return 1;
+  }
+  double pool_rate = run("pool");
+
+  wasm_rt_memory_pool_stats_t stats;
+  wasm_rt_get_memory_pool_stats(&stats);
+  printf("speedup  %10.2fx\n", pool_rate / mmap_rate);
+  printf("pool: %u slots, %u in use, %llu allocations, %llu fallbacks\n",
+         stats.slot_count, stats.slots_in_use,
+         (unsigned long long)stats.pool_allocations,
+         (unsigned long long)stats.fallback_allocations);
+  if (!wasm_rt_free_memory_pool()) {
+    fprintf(stderr, "wasm_rt_free_memory_pool failed\n");
+    return 1;
+  }
+  return 0;
+}
@@ -18,6 +18,7 @@
 #include "wasm-rt.h"
 
 #include <assert.h>
+#include <inttypes.h>
 #include <limits.h>
 #include <stdarg.h>
 #include <stdbool.h>
@@ -25,12 +26,51 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 
 #ifdef WASM_RT_CUSTOM_TRAP_HANDLER
 // forward declare the signature of any custom trap handler
 void WASM_RT_CUSTOM_TRAP_HANDLER(const char*);
 #endif
 
+WASM_RT_THREAD_LOCAL uint32_t wasm_rt_call_stack_depth = 0;
+
+// The native stack grows down, so the frames of the calls that are still
+// running have higher addresses than the frames of the calls they make.
+#ifdef _MSC_VER
+#define FRAME_ADDRESS() ((uintptr_t)_AddressOfReturnAddress())
+#else
+#define FRAME_ADDRESS() ((uintptr_t)__builtin_frame_address(0))
+#endif
+
+// The innermost wasm_rt_try of this thread.
+static WASM_RT_THREAD_LOCAL wasm_rt_jmp_buf* g_unwind_target = NULL;
+
+// The number of traps this thread has unwound from, and the frame address of
+// the wasm_rt_try the last one unwound to, for the profiler.
+static WASM_RT_THREAD_LOCAL uint32_t g_trap_count = 0;
+static WASM_RT_THREAD_LOCAL uintptr_t g_trap_frame_address = 0;
+
+void wasm_rt_push_unwind_target(wasm_rt_jmp_buf* target) {
+  wasm_rt_init_thread();
+  target->prev = g_unwind_target;
+  target->saved_call_stack_depth = wasm_rt_call_stack_depth;
+  target->frame_address = FRAME_ADDRESS();
+  target->trap = WASM_RT_TRAP_NONE;
+  g_unwind_target = target;
+}
+
+void wasm_rt_pop_unwind_target(wasm_rt_jmp_buf* target) {
+  assert(g_unwind_target == target);
+  g_unwind_target = target->prev;
+}
+
 void wasm_rt_trap(wasm_rt_trap_t code) {
   const char* error_message = "wasm2c: unknown trap";
   switch (code) {
@@ -91,7 +131,24 @@ void wasm_rt_trap(wasm_rt_trap_t code) {
       error_message = "wasm2c: WASM_RT_TRAP_WASI";
       break;
     }
+    case WASM_RT_TRAP_UNALIGNED: {
+      error_message = "wasm2c: WASM_RT_TRAP_UNALIGNED";
+      break;
+    }
+    case WASM_RT_TRAP_UNSHARED_MEMORY: {
+      error_message = "wasm2c: WASM_RT_TRAP_UNSHARED_MEMORY";
+      break;
+    }
   };
+  wasm_rt_jmp_buf* target = g_unwind_target;
+  if (target) {
+    g_unwind_target = target->prev;
+    wasm_rt_call_stack_depth = target->saved_call_stack_depth;
+    ++g_trap_count;
+    g_trap_frame_address = target->frame_address;
+    target->trap = code;
+    longjmp(target->buffer, 1);
+  }
 #ifdef WASM_RT_CUSTOM_TRAP_HANDLER
   WASM_RT_CUSTOM_TRAP_HANDLER(error_message);
 #else
@@ -113,85 +170,193 @@ void wasm_rt_callback_error_trap(wasm_rt_table_t* table,
   wasm_rt_trap(WASM_RT_TRAP_CALL_INDIRECT_UNKNOWN_ERR);
 }
 
-static bool func_types_are_equal(wasm_func_type_t* a, wasm_func_type_t* b) {
-  if (a->param_count != b->param_count || a->result_count != b->result_count)
-    return 0;
-  uint32_t i;
-  for (i = 0; i < a->param_count; ++i)
-    if (a->params[i] != b->params[i])
-      return 0;
-  for (i = 0; i < a->result_count; ++i)
-    if (a->results[i] != b->results[i])
-      return 0;
-  return 1;
-}
-
-uint32_t wasm_rt_register_func_type(wasm_func_type_t** p_func_type_structs,
-                                    uint32_t* p_func_type_count,
-                                    uint32_t param_count,
-                                    uint32_t result_count,
-                                    wasm_rt_type_t* types) {
-  wasm_func_type_t func_type;
+// The function types of all modules are registered in one process-wide
+// table, hash-consed on their signature, so that a type gets the same index in
+// every sandbox and the registration of a known type allocates nothing. Types
+// are never removed; a process only ever sees a handful of distinct ones.
+#define FUNC_TYPE_REGISTRY_INITIAL_BUCKETS 64
 
-  func_type.param_count = param_count;
-  if (func_type.param_count != 0) {
-    func_type.params = malloc(param_count * sizeof(wasm_rt_type_t));
-    assert(func_type.params != 0);
-  } else {
-    func_type.params = 0;
+static wasm_func_type_t* g_func_types = NULL;
+static uint32_t g_func_type_count = 0;
+static uint32_t g_func_type_capacity = 0;
+// Open addressing table of function type indices (0 for an empty bucket).
+static uint32_t* g_func_type_buckets = NULL;
+static uint32_t g_func_type_bucket_count = 0;
+
+#ifdef _MSC_VER
+static volatile long g_func_type_lock = 0;
+
+static void func_type_registry_lock() {
+  while (_InterlockedExchange(&g_func_type_lock, 1)) {
   }
+}
 
-  func_type.result_count = result_count;
-  if (func_type.result_count != 0) {
-    func_type.results = malloc(result_count * sizeof(wasm_rt_type_t));
-    assert(func_type.results != 0);
-  } else {
-    func_type.results = 0;
+static void func_type_registry_unlock() {
+  _InterlockedExchange(&g_func_type_lock, 0);
+}
+#else
+static bool g_func_type_lock = false;
+
+static void func_type_registry_lock() {
+  while (__atomic_test_and_set(&g_func_type_lock, __ATOMIC_ACQUIRE)) {
   }
+}
 
-  uint32_t i;
-  for (i = 0; i < param_count; ++i)
-    func_type.params[i] = types[i];
-  for (i = 0; i < result_count; ++i)
-    func_type.results[i] = types[(uint64_t)(param_count) + i];
+static void func_type_registry_unlock() {
+  __atomic_clear(&g_func_type_lock, __ATOMIC_RELEASE);
+}
+#endif
 
-  for (i = 0; i < *p_func_type_count; ++i) {
-    wasm_func_type_t* func_types = *p_func_type_structs;
-    if (func_types_are_equal(&func_types[i], &func_type)) {
-      if (func_type.params) {
-        free(func_type.params);
-      }
-      if (func_type.results) {
-        free(func_type.results);
-      }
-      return i + 1;
+static uint32_t hash_func_type(uint32_t param_count,
+                               uint32_t result_count,
+                               const wasm_rt_type_t* types) {
+  // FNV-1a
+  uint32_t hash = 2166136261u;
+  hash = (hash ^ param_count) * 16777619u;
+  hash = (hash ^ result_count) * 16777619u;
+  for (uint64_t i = 0; i < (uint64_t)param_count + result_count; ++i) {
+    hash = (hash ^ (uint32_t)types[i]) * 16777619u;
+  }
+  return hash;
+}
+
+static bool func_type_matches(const wasm_func_type_t* func_type,
+                              uint32_t param_count,
+                              uint32_t result_count,
+                              const wasm_rt_type_t* types) {
+  if (func_type->param_count != param_count ||
+      func_type->result_count != result_count) {
+    return false;
+  }
+  return (param_count == 0 || memcmp(func_type->params, types,
+                                     param_count * sizeof(wasm_rt_type_t)) ==
+                                  0) &&
+         (result_count == 0 ||
+          memcmp(func_type->results, types + param_count,
+                 result_count * sizeof(wasm_rt_type_t)) == 0);
+}
+
+static void func_type_registry_insert_bucket(uint32_t hash, uint32_t index) {
+  uint32_t mask = g_func_type_bucket_count - 1;
+  uint32_t bucket = hash & mask;
+  while (g_func_type_buckets[bucket] != 0) {
+    bucket = (bucket + 1) & mask;
+  }
+  g_func_type_buckets[bucket] = index;
+}
+
+static void func_type_registry_grow() {
+  if (g_func_type_count == g_func_type_capacity) {
+    g_func_type_capacity =
+        g_func_type_capacity ? g_func_type_capacity * 2
+                             : FUNC_TYPE_REGISTRY_INITIAL_BUCKETS / 2;
+    g_func_types = realloc(g_func_types,
+                           g_func_type_capacity * sizeof(wasm_func_type_t));
+    assert(g_func_types != 0);
+  }
+  // Keep the load factor of the buckets at most 1/2.
+  if ((g_func_type_count + 1) * 2 > g_func_type_bucket_count) {
+    free(g_func_type_buckets);
+    g_func_type_bucket_count = g_func_type_bucket_count
+                                   ? g_func_type_bucket_count * 2
+                                   : FUNC_TYPE_REGISTRY_INITIAL_BUCKETS;
+    g_func_type_buckets = calloc(g_func_type_bucket_count, sizeof(uint32_t));
+    assert(g_func_type_buckets != 0);
+    for (uint32_t i = 0; i < g_func_type_count; ++i) {
+      const wasm_func_type_t* func_type = &g_func_types[i];
+      uint32_t hash = hash_func_type(func_type->param_count,
+                                     func_type->result_count,
+                                     func_type->params);
+      func_type_registry_insert_bucket(hash, i + 1);
     }
   }
+}
 
-  uint32_t idx = (*p_func_type_count)++;
-  // realloc works fine even if *p_func_type_structs is null
-  *p_func_type_structs = realloc(*p_func_type_structs,
-                                 *p_func_type_count * sizeof(wasm_func_type_t));
-  (*p_func_type_structs)[idx] = func_type;
-  return idx + 1;
+static bool get_inline_func_type(uint32_t param_count,
+                                 uint32_t result_count,
+                                 const wasm_rt_type_t* types,
+                                 uint32_t* index) {
+  if (param_count > WASM_RT_INLINE_FUNC_TYPE_MAX_PARAMS ||
+      result_count > WASM_RT_INLINE_FUNC_TYPE_MAX_RESULTS ||
+      param_count + result_count > WASM_RT_INLINE_FUNC_TYPE_MAX_TYPES) {
+    return false;
+  }
+  uint32_t result =
+      WASM_RT_INLINE_FUNC_TYPE_BIT | (param_count << 28) | (result_count << 26);
+  for (uint32_t i = 0; i < param_count + result_count; ++i) {
+    result |= (uint32_t)types[i] << (3 * i);
+  }
+  *index = result;
+  return true;
 }
 
-void wasm_rt_cleanup_func_types(wasm_func_type_t** p_func_type_structs,
-                                uint32_t* p_func_type_count) {
-  // Use a u64 to iterate over u32 arrays to prevent infinite loops
-  const uint32_t func_count = *p_func_type_count;
-  for (uint64_t idx = 0; idx < func_count; idx++) {
-    wasm_func_type_t* func_type = &((*p_func_type_structs)[idx]);
-    if (func_type->params != 0) {
-      free(func_type->params);
-      func_type->params = 0;
+// Must be called with the registry lock held.
+static uint32_t register_func_type_locked(uint32_t param_count,
+                                          uint32_t result_count,
+                                          const wasm_rt_type_t* types) {
+  uint32_t inline_index;
+  if (get_inline_func_type(param_count, result_count, types, &inline_index)) {
+    return inline_index;
+  }
+  uint32_t hash = hash_func_type(param_count, result_count, types);
+  if (g_func_type_bucket_count != 0) {
+    uint32_t mask = g_func_type_bucket_count - 1;
+    for (uint32_t bucket = hash & mask; g_func_type_buckets[bucket] != 0;
+         bucket = (bucket + 1) & mask) {
+      uint32_t index = g_func_type_buckets[bucket];
+      if (func_type_matches(&g_func_types[index - 1], param_count,
+                            result_count, types)) {
+        return index;
+      }
     }
-    if (func_type->results != 0) {
-      free(func_type->results);
-      func_type->results = 0;
+  }
+
+  func_type_registry_grow();
+
+  // The params and results share one allocation, so that the params pointer
+  // can be hashed as the whole signature when the buckets are rebuilt.
+  uint64_t type_count = (uint64_t)param_count + result_count;
+  wasm_rt_type_t* copy =
+      malloc((type_count ? type_count : 1) * sizeof(wasm_rt_type_t));
+  assert(copy != 0);
+  if (type_count) {
+    memcpy(copy, types, type_count * sizeof(wasm_rt_type_t));
+  }
+  wasm_func_type_t* func_type = &g_func_types[g_func_type_count];
+  func_type->params = copy;
+  func_type->results = copy + param_count;
+  func_type->param_count = param_count;
+  func_type->result_count = result_count;
+  uint32_t index = ++g_func_type_count;
+  func_type_registry_insert_bucket(hash, index);
+  return index;
+}
+
+uint32_t wasm_rt_register_func_type(uint32_t param_count,
+                                    uint32_t result_count,
+                                    const wasm_rt_type_t* types) {
+  uint32_t index;
+  if (get_inline_func_type(param_count, result_count, types, &index)) {
+    return index;
+  }
+  func_type_registry_lock();
+  index = register_func_type_locked(param_count, result_count, types);
+  func_type_registry_unlock();
+  return index;
+}
+
+void wasm_rt_register_func_types(const wasm_rt_func_sig_t* sigs,
+                                 uint32_t count,
+                                 uint32_t* ids) {
+  func_type_registry_lock();
+  // Registered indices are never 0, and the ids are filled in all at once.
+  if (count != 0 && ids[0] == 0) {
+    for (uint32_t i = 0; i < count; ++i) {
+      ids[i] = register_func_type_locked(sigs[i].param_count,
+                                         sigs[i].result_count, sigs[i].types);
     }
   }
-  free(*p_func_type_structs);
+  func_type_registry_unlock();
 }
 
 #if UINTPTR_MAX == 0xffffffff
@@ -239,6 +404,306 @@ static uint64_t compute_heap_reserve_space(uint32_t chosen_max_pages) {
   return heap_reserve_size;
 }
 
+#if defined(WASM_USE_GUARD_PAGES) && !defined(_MSC_VER)
+#define WASM_RT_TRACK_GUARDED_MEMORIES
+#endif
+
+#ifdef WASM_RT_TRACK_GUARDED_MEMORIES
+// The address ranges reserved for linear memories, including their guard
+// pages. The fault handler reads these without locking, so each slot's start is
+// stored last when it is added, and cleared first when it is removed.
+#ifndef WASM_RT_MAX_GUARDED_MEMORIES
+#define WASM_RT_MAX_GUARDED_MEMORIES 4096
+#endif
+
+typedef struct {
+  uintptr_t start;
+  uintptr_t end;
+} guarded_memory_t;
+
+static guarded_memory_t g_guarded_memories[WASM_RT_MAX_GUARDED_MEMORIES];
+static bool g_guarded_memories_lock = false;
+
+static void add_guarded_memory(uint8_t* data, uint64_t reserve_size) {
+  while (__atomic_test_and_set(&g_guarded_memories_lock, __ATOMIC_ACQUIRE)) {
+  }
+  for (uint32_t i = 0; i < WASM_RT_MAX_GUARDED_MEMORIES; i++) {
+    guarded_memory_t* slot = &g_guarded_memories[i];
+    if (!__atomic_load_n(&slot->start, __ATOMIC_RELAXED)) {
+      __atomic_store_n(&slot->end, (uintptr_t)data + reserve_size,
+                       __ATOMIC_RELAXED);
+      __atomic_store_n(&slot->start, (uintptr_t)data, __ATOMIC_RELEASE);
+      break;
+    }
+  }
+  // If all slots are used, faults in this memory are not turned into traps.
+  __atomic_clear(&g_guarded_memories_lock, __ATOMIC_RELEASE);
+}
+
+static void remove_guarded_memory(uint8_t* data) {
+  while (__atomic_test_and_set(&g_guarded_memories_lock, __ATOMIC_ACQUIRE)) {
+  }
+  for (uint32_t i = 0; i < WASM_RT_MAX_GUARDED_MEMORIES; i++) {
+    guarded_memory_t* slot = &g_guarded_memories[i];
+    if (__atomic_load_n(&slot->start, __ATOMIC_RELAXED) == (uintptr_t)data) {
+      __atomic_store_n(&slot->start, 0, __ATOMIC_RELEASE);
+      break;
+    }
+  }
+  __atomic_clear(&g_guarded_memories_lock, __ATOMIC_RELEASE);
+}
+
+static bool is_guarded_memory_address(uintptr_t addr) {
+  for (uint32_t i = 0; i < WASM_RT_MAX_GUARDED_MEMORIES; i++) {
+    guarded_memory_t* slot = &g_guarded_memories[i];
+    uintptr_t start = __atomic_load_n(&slot->start, __ATOMIC_ACQUIRE);
+    if (start && addr >= start &&
+        addr < __atomic_load_n(&slot->end, __ATOMIC_RELAXED)) {
+      return true;
+    }
+  }
+  return false;
+}
+#endif
+
+// Faults at most this far below the lowest address of a thread's stack are
+// taken to be stack overflows.
+#ifndef WASM_RT_STACK_GUARD_SIZE
+#define WASM_RT_STACK_GUARD_SIZE (1024 * 1024)
+#endif
+
+#if defined(WASM_RT_TRACK_GUARDED_MEMORIES) && \
+    UINTPTR_MAX == 0xffffffffffffffff
+#define WASM_RT_USE_MEMORY_POOL
+#endif
+
+#ifdef WASM_RT_USE_MEMORY_POOL
+// Slots of the memory pool, each reserved for WASM_HEAP_MAX_ALLOWED_PAGES.
+// g_memory_pool_free holds the free slots as a stack.
+static uint8_t** g_memory_pool_slots = NULL;
+static uint8_t** g_memory_pool_free = NULL;
+static uint32_t g_memory_pool_slot_count = 0;
+static uint32_t g_memory_pool_free_count = 0;
+static uint64_t g_memory_pool_allocations = 0;
+static uint64_t g_memory_pool_fallback_allocations = 0;
+static bool g_memory_pool_lock = false;
+
+static uint64_t memory_pool_slot_size() {
+  return compute_heap_reserve_space(WASM_HEAP_MAX_ALLOWED_PAGES);
+}
+
+static uint8_t* memory_pool_take_slot() {
+  uint8_t* slot = NULL;
+  while (__atomic_test_and_set(&g_memory_pool_lock, __ATOMIC_ACQUIRE)) {
+  }
+  if (g_memory_pool_free_count > 0) {
+    slot = g_memory_pool_free[--g_memory_pool_free_count];
+    g_memory_pool_allocations++;
+  } else if (g_memory_pool_slot_count > 0) {
+    g_memory_pool_fallback_allocations++;
+  }
+  __atomic_clear(&g_memory_pool_lock, __ATOMIC_RELEASE);
+  return slot;
+}
+
+static void memory_pool_return_slot(uint8_t* slot,
+                                    uint32_t committed_size,
+                                    uint32_t image_size) {
+  // Only the committed part of the slot needs to be cleared, the rest has not
+  // been touched. Discarding the pages of a memory image would bring back the
+  // image's contents, so those are replaced instead.
+  if (image_size > 0 && os_mmap_reset(slot, image_size) != 0) {
+    os_print_last_error("os_mmap_reset failed.");
+    return;
+  }
+  if (committed_size > 0 && os_mmap_decommit(slot, committed_size) != 0) {
+    // The slot may still hold this memory's data, so don't reuse it.
+    os_print_last_error("os_mmap_decommit failed.");
+    return;
+  }
+  while (__atomic_test_and_set(&g_memory_pool_lock, __ATOMIC_ACQUIRE)) {
+  }
+  g_memory_pool_free[g_memory_pool_free_count++] = slot;
+  __atomic_clear(&g_memory_pool_lock, __ATOMIC_RELEASE);
+}
+#endif
+
+#ifdef WASM_RT_USE_MEMORY_POOL
+static void memory_pool_release_slots(uint8_t** slots, uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) {
+    remove_guarded_memory(slots[i]);
+    os_munmap(slots[i], memory_pool_slot_size());
+  }
+}
+
+static bool memory_pool_exists() {
+  while (__atomic_test_and_set(&g_memory_pool_lock, __ATOMIC_ACQUIRE)) {
+  }
+  bool exists = g_memory_pool_slots != NULL;
+  __atomic_clear(&g_memory_pool_lock, __ATOMIC_RELEASE);
+  return exists;
+}
+#endif
+
+bool wasm_rt_init_memory_pool(uint32_t slot_count) {
+#ifdef WASM_RT_USE_MEMORY_POOL
+  if (slot_count == 0 || memory_pool_exists()) {
+    return false;
+  }
+  // The slots are reserved without holding the lock, which would otherwise
+  // stall every allocation for as long as the mmap calls take, and published
+  // at the end.
+  uint8_t** slots = (uint8_t**)calloc(slot_count, sizeof(uint8_t*));
+  uint8_t** free_slots = (uint8_t**)calloc(slot_count, sizeof(uint8_t*));
+  if (!slots || !free_slots) {
+    free(slots);
+    free(free_slots);
+    return false;
+  }
+  const uint64_t slot_size = memory_pool_slot_size();
+  uint32_t reserved = 0;
+  for (; reserved < slot_count; reserved++) {
+    uint8_t* slot = (uint8_t*)os_mmap_aligned(
+        NULL, slot_size, MMAP_PROT_NONE, MMAP_MAP_NONE, WASM_HEAP_ALIGNMENT,
+        0 /* alignment_offset */);
+    if (!slot) {
+      break;
+    }
+    add_guarded_memory(slot, slot_size);
+    slots[reserved] = slot;
+    // Hand out the slots in address order.
+    free_slots[slot_count - reserved - 1] = slot;
+  }
+  if (reserved < slot_count) {
+    memmove(free_slots, free_slots + slot_count - reserved,
+            reserved * sizeof(uint8_t*));
+  }
+
+  bool created = false;
+  while (__atomic_test_and_set(&g_memory_pool_lock, __ATOMIC_ACQUIRE)) {
+  }
+  // Another thread may have created the pool in the meantime.
+  if (reserved > 0 && !g_memory_pool_slots) {
+    g_memory_pool_slots = slots;
+    g_memory_pool_free = free_slots;
+    g_memory_pool_slot_count = reserved;
+    g_memory_pool_free_count = reserved;
+    created = true;
+  }
+  __atomic_clear(&g_memory_pool_lock, __ATOMIC_RELEASE);
+
+  if (!created) {
+    memory_pool_release_slots(slots, reserved);
+    free(slots);
+    free(free_slots);
+  }
+  return created;
+#else
+  return false;
+#endif
+}
+
+bool wasm_rt_free_memory_pool() {
+#ifdef WASM_RT_USE_MEMORY_POOL
+  while (__atomic_test_and_set(&g_memory_pool_lock, __ATOMIC_ACQUIRE)) {
+  }
+  if (g_memory_pool_free_count != g_memory_pool_slot_count) {
+    __atomic_clear(&g_memory_pool_lock, __ATOMIC_RELEASE);
+    return false;
+  }
+  uint8_t** slots = g_memory_pool_slots;
+  uint8_t** free_slots = g_memory_pool_free;
+  uint32_t slot_count = g_memory_pool_slot_count;
+  g_memory_pool_slots = NULL;
+  g_memory_pool_free = NULL;
+  g_memory_pool_slot_count = 0;
+  g_memory_pool_free_count = 0;
+  __atomic_clear(&g_memory_pool_lock, __ATOMIC_RELEASE);
+
+  memory_pool_release_slots(slots, slot_count);
+  free(slots);
+  free(free_slots);
+#endif
+  return true;
+}
+
+void wasm_rt_get_memory_pool_stats(wasm_rt_memory_pool_stats_t* stats) {
+  memset(stats, 0, sizeof(*stats));
+#ifdef WASM_RT_USE_MEMORY_POOL
+  while (__atomic_test_and_set(&g_memory_pool_lock, __ATOMIC_ACQUIRE)) {
+  }
+  stats->slot_count = g_memory_pool_slot_count;
+  stats->slots_in_use = g_memory_pool_slot_count - g_memory_pool_free_count;
+  stats->pool_allocations = g_memory_pool_allocations;
+  stats->fallback_allocations = g_memory_pool_fallback_allocations;
+  __atomic_clear(&g_memory_pool_lock, __ATOMIC_RELEASE);
+#endif
+}
+
+static WASM_RT_THREAD_LOCAL bool g_thread_initialized = false;
+static WASM_RT_THREAD_LOCAL uintptr_t g_stack_low = 0;
+
+static void handle_fault(void* fault_addr) {
+  uintptr_t addr = (uintptr_t)fault_addr;
+#ifdef WASM_RT_TRACK_GUARDED_MEMORIES
+  if (is_guarded_memory_address(addr)) {
+    wasm_rt_trap(WASM_RT_TRAP_OOB);
+  }
+#endif
+  if (g_stack_low && addr < g_stack_low &&
+      addr >= g_stack_low - WASM_RT_STACK_GUARD_SIZE) {
+    wasm_rt_trap(WASM_RT_TRAP_EXHAUSTION);
+  }
+}
+
+static bool g_fault_handler_installed = false;
+#ifndef _MSC_VER
+// Several threads may call wasm_rt_sys_init at once, but the handlers must
+// only be installed once, or the previous handlers they chain to would be
+// their own. The Windows version of os_install_fault_handler always fails, so
+// nothing is installed there.
+static bool g_fault_handler_lock = false;
+#endif
+
+bool wasm_rt_install_fault_handler() {
+#ifndef _MSC_VER
+  while (__atomic_test_and_set(&g_fault_handler_lock, __ATOMIC_ACQUIRE)) {
+  }
+#endif
+  bool installed = g_fault_handler_installed ||
+                   os_install_fault_handler(handle_fault) == 0;
+  g_fault_handler_installed = installed;
+#ifndef _MSC_VER
+  __atomic_clear(&g_fault_handler_lock, __ATOMIC_RELEASE);
+#endif
+  if (!installed) {
+    return false;
+  }
+  return wasm_rt_init_thread();
+}
+
+bool wasm_rt_init_thread() {
+  if (g_thread_initialized) {
+    return true;
+  }
+  if (os_alloc_signal_stack() != 0) {
+    return false;
+  }
+  if (os_get_stack_low(&g_stack_low) != 0) {
+    g_stack_low = 0;
+  }
+  g_thread_initialized = true;
+  return true;
+}
+
+void wasm_rt_free_thread() {
+  if (g_thread_initialized) {
+    os_free_signal_stack();
+    g_stack_low = 0;
+    g_thread_initialized = false;
+  }
+}
+
 bool wasm_rt_allocate_memory(wasm_rt_memory_t* memory,
                              uint32_t initial_pages,
                              uint32_t max_pages) {
@@ -255,6 +720,8 @@ bool wasm_rt_allocate_memory(wasm_rt_memory_t* memory,
     return false;
   }
 
+  memory->is_pooled = false;
+  memory->image_size = 0;
 #ifdef WASM_USE_GUARD_PAGES
   // mmap based heaps with guard pages
   // Guard pages already allocates memory incrementally thus we don't need to
@@ -272,22 +739,41 @@ bool wasm_rt_allocate_memory(wasm_rt_memory_t* memory,
   }
 #endif
 
-  for (uint64_t i = 0; i < retries; i++) {
-    addr =
-        os_mmap_aligned(NULL, heap_reserve_size, MMAP_PROT_NONE, MMAP_MAP_NONE,
-                        WASM_HEAP_ALIGNMENT, 0 /* alignment_offset */);
-    if (addr) {
-      break;
+#ifdef WASM_RT_USE_MEMORY_POOL
+  // Every slot is large enough for chosen_max_pages.
+  addr = memory_pool_take_slot();
+  if (addr) {
+    if (os_mmap_commit(addr, byte_length, MMAP_PROT_READ | MMAP_PROT_WRITE) !=
+        0) {
+      memory_pool_return_slot(addr, 0, 0);
+      return false;
     }
+    memory->is_pooled = true;
   }
+#endif
 
-  if (!addr) {
-    os_print_last_error("os_mmap failed.");
-    return false;
-  }
-  int ret = os_mmap_commit(addr, byte_length, MMAP_PROT_READ | MMAP_PROT_WRITE);
-  if (ret != 0) {
-    return false;
+  if (!memory->is_pooled) {
+    for (uint64_t i = 0; i < retries; i++) {
+      addr = os_mmap_aligned(NULL, heap_reserve_size, MMAP_PROT_NONE,
+                             MMAP_MAP_NONE, WASM_HEAP_ALIGNMENT,
+                             0 /* alignment_offset */);
+      if (addr) {
+        break;
+      }
+    }
+
+    if (!addr) {
+      os_print_last_error("os_mmap failed.");
+      return false;
+    }
+    int ret =
+        os_mmap_commit(addr, byte_length, MMAP_PROT_READ | MMAP_PROT_WRITE);
+    if (ret != 0) {
+      return false;
+    }
+#ifdef WASM_RT_TRACK_GUARDED_MEMORIES
+    add_guarded_memory(addr, heap_reserve_size);
+#endif
   }
   // This is a valid way to initialize a constant field that is not undefined
   // behavior
@@ -309,6 +795,7 @@ bool wasm_rt_allocate_memory(wasm_rt_memory_t* memory,
   memory->size = byte_length;
   memory->pages = initial_pages;
   memory->max_pages = chosen_max_pages;
+  memory->is_shared = false;
 
   // 32-bit platforms use masking for sandboxing. Compute the mask
 #if UINTPTR_MAX == 0xffffffff
@@ -323,9 +810,19 @@ bool wasm_rt_allocate_memory(wasm_rt_memory_t* memory,
 
 void wasm_rt_deallocate_memory(wasm_rt_memory_t* memory) {
 #ifdef WASM_USE_GUARD_PAGES
-  const uint64_t heap_reserve_size =
-      compute_heap_reserve_space(memory->max_pages);
-  os_munmap(memory->data, heap_reserve_size);
+#ifdef WASM_RT_USE_MEMORY_POOL
+  if (memory->is_pooled) {
+    memory_pool_return_slot(memory->data, memory->size, memory->image_size);
+  } else
+#endif
+  {
+    const uint64_t heap_reserve_size =
+        compute_heap_reserve_space(memory->max_pages);
+#ifdef WASM_RT_TRACK_GUARDED_MEMORIES
+    remove_guarded_memory(memory->data);
+#endif
+    os_munmap(memory->data, heap_reserve_size);
+  }
 #else
   free(memory->data);
 #endif
@@ -335,7 +832,67 @@ void wasm_rt_deallocate_memory(wasm_rt_memory_t* memory) {
 #endif
 }
 
-uint32_t wasm_rt_grow_memory(wasm_rt_memory_t* memory, uint32_t delta) {
+bool wasm_rt_create_memory_image(wasm_rt_memory_image_t* image,
+                                 const wasm_rt_memory_t* memory) {
+#if defined(WASM_USE_GUARD_PAGES) && !defined(WASM_CHECK_SHADOW_MEMORY)
+  image->fd = os_memfd_create("wasm2c-memory-image", memory->data, memory->size);
+  if (image->fd < 0) {
+    return false;
+  }
+  image->pages = memory->pages;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void wasm_rt_free_memory_image(wasm_rt_memory_image_t* image) {
+  // Existing mappings of the file keep it alive.
+  os_memfd_close(image->fd);
+  image->fd = -1;
+}
+
+bool wasm_rt_allocate_memory_from_image(wasm_rt_memory_t* memory,
+                                        const wasm_rt_memory_image_t* image,
+                                        uint32_t max_pages) {
+#if defined(WASM_USE_GUARD_PAGES) && !defined(WASM_CHECK_SHADOW_MEMORY)
+  if (!wasm_rt_allocate_memory(memory, 0, max_pages)) {
+    return false;
+  }
+  const uint32_t byte_length = image->pages * WASM_PAGE_SIZE;
+  if (image->pages > memory->max_pages ||
+      (byte_length > 0 &&
+       os_mmap_file_private(memory->data, byte_length, image->fd) != 0)) {
+    wasm_rt_deallocate_memory(memory);
+    return false;
+  }
+  memory->pages = image->pages;
+  memory->size = byte_length;
+  memory->image_size = byte_length;
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool wasm_rt_allocate_shared_memory(wasm_rt_memory_t* memory,
+                                    uint32_t initial_pages,
+                                    uint32_t max_pages) {
+#if defined(_MSC_VER) || (defined(WASM_USE_INCREMENTAL_MOVEABLE_MEMORY_ALLOC) && \
+                          !defined(WASM_USE_GUARD_PAGES))
+  // Other threads hold on to the memory's data pointer, so it must not move
+  // on grow. The atomics also need the GCC/Clang __atomic builtins.
+  return false;
+#else
+  if (!wasm_rt_allocate_memory(memory, initial_pages, max_pages)) {
+    return false;
+  }
+  memory->is_shared = true;
+  return true;
+#endif
+}
+
+static uint32_t grow_memory_unlocked(wasm_rt_memory_t* memory, uint32_t delta) {
   uint32_t old_pages = memory->pages;
   uint32_t new_pages = memory->pages + delta;
   if (new_pages == 0) {
@@ -374,14 +931,131 @@ uint32_t wasm_rt_grow_memory(wasm_rt_memory_t* memory, uint32_t delta) {
   memmove(memory->data + new_size - old_size, memory->data, old_size);
   memset(memory->data, 0, delta_size);
 #endif
+#ifndef _MSC_VER
+  // Other threads read the size of a shared memory without taking the lock.
+  __atomic_store_n(&memory->pages, new_pages, __ATOMIC_RELEASE);
+  __atomic_store_n(&memory->size, new_size, __ATOMIC_RELEASE);
+#else
   memory->pages = new_pages;
   memory->size = new_size;
+#endif
 #if defined(WASM_CHECK_SHADOW_MEMORY)
   wasm2c_shadow_memory_expand(memory);
 #endif
   return old_pages;
 }
 
+#ifndef _MSC_VER
+// Serializes memory.grow on shared memories. Growing is rare, so a single
+// spinlock for all of them is enough.
+static bool g_shared_memory_grow_lock = false;
+#endif
+
+uint32_t wasm_rt_grow_memory(wasm_rt_memory_t* memory, uint32_t delta) {
+#ifndef _MSC_VER
+  if (memory->is_shared) {
+    while (__atomic_test_and_set(&g_shared_memory_grow_lock, __ATOMIC_ACQUIRE)) {
+    }
+    uint32_t ret = grow_memory_unlocked(memory, delta);
+    __atomic_clear(&g_shared_memory_grow_lock, __ATOMIC_RELEASE);
+    return ret;
+  }
+#endif
+  return grow_memory_unlocked(memory, delta);
+}
+
+uint32_t wasm_rt_atomic_wait32(wasm_rt_memory_t* memory,
+                               uint32_t* addr,
+                               uint32_t expected,
+                               int64_t timeout) {
+  if (!memory->is_shared) {
+    wasm_rt_trap(WASM_RT_TRAP_UNSHARED_MEMORY);
+  }
+  return os_atomic_wait(addr, expected, sizeof(*addr), timeout);
+}
+
+uint32_t wasm_rt_atomic_wait64(wasm_rt_memory_t* memory,
+                               uint64_t* addr,
+                               uint64_t expected,
+                               int64_t timeout) {
+  if (!memory->is_shared) {
+    wasm_rt_trap(WASM_RT_TRAP_UNSHARED_MEMORY);
+  }
+  return os_atomic_wait(addr, expected, sizeof(*addr), timeout);
+}
+
+uint32_t wasm_rt_atomic_notify(wasm_rt_memory_t* memory,
+                               void* addr,
+                               uint32_t count) {
+  // Nothing can wait on an unshared memory.
+  if (!memory->is_shared || count == 0) {
+    return 0;
+  }
+  return os_atomic_notify(addr, count);
+}
+
+// The bulk memory operations check the whole range before touching memory, so
+// they also trap with guard pages instead of faulting partway through.
+static bool range_out_of_bounds(wasm_rt_memory_t* memory,
+                                uint32_t addr,
+                                uint32_t n) {
+#ifndef _MSC_VER
+  if (memory->is_shared) {
+    return (uint64_t)addr + n > __atomic_load_n(&memory->size, __ATOMIC_ACQUIRE);
+  }
+#endif
+  return (uint64_t)addr + n > memory->size;
+}
+
+void wasm_rt_memory_copy(wasm_rt_memory_t* memory,
+                         uint32_t dest,
+                         uint32_t src,
+                         uint32_t n) {
+  if (range_out_of_bounds(memory, dest, n) ||
+      range_out_of_bounds(memory, src, n)) {
+    wasm_rt_trap(WASM_RT_TRAP_OOB);
+  }
+#if WABT_BIG_ENDIAN
+  memmove(memory->data + memory->size - dest - n,
+          memory->data + memory->size - src - n, n);
+#else
+  memmove(memory->data + dest, memory->data + src, n);
+#endif
+}
+
+void wasm_rt_memory_fill(wasm_rt_memory_t* memory,
+                         uint32_t dest,
+                         uint32_t value,
+                         uint32_t n) {
+  if (range_out_of_bounds(memory, dest, n)) {
+    wasm_rt_trap(WASM_RT_TRAP_OOB);
+  }
+#if WABT_BIG_ENDIAN
+  memset(memory->data + memory->size - dest - n, (uint8_t)value, n);
+#else
+  memset(memory->data + dest, (uint8_t)value, n);
+#endif
+}
+
+void wasm_rt_memory_init(wasm_rt_memory_t* memory,
+                         uint32_t dest,
+                         const uint8_t* data,
+                         uint32_t data_size,
+                         uint32_t src,
+                         uint32_t n) {
+  if (range_out_of_bounds(memory, dest, n) || (uint64_t)src + n > data_size) {
+    wasm_rt_trap(WASM_RT_TRAP_OOB);
+  }
+#if WABT_BIG_ENDIAN
+  uint8_t* out = memory->data + memory->size - dest - 1;
+  for (uint32_t i = 0; i < n; i++) {
+    out[-(ptrdiff_t)i] = data[src + i];
+  }
+#else
+  memcpy(memory->data + dest, data + src, n);
+#endif
+}
+
 void wasm_rt_allocate_table(wasm_rt_table_t* table,
                             uint32_t elements,
                             uint32_t max_elements) {
@@ -390,10 +1064,15 @@ void wasm_rt_allocate_table(wasm_rt_table_t* table,
   table->max_size = max_elements;
   table->data = calloc(table->size, sizeof(wasm_rt_elem_t));
   assert(table->data != 0);
+  table->free_slots = NULL;
+  table->free_slot_count = 0;
+  table->free_slot_capacity = 0;
+  table->next_unscanned_slot = 1;
 }
 
 void wasm_rt_deallocate_table(wasm_rt_table_t* table) {
   free(table->data);
+  free(table->free_slots);
 }
 
 #define WASM_SATURATING_U32_ADD(ret_ptr, a, b) \
@@ -420,7 +1099,8 @@ void wasm_rt_deallocate_table(wasm_rt_table_t* table) {
 
 void wasm_rt_expand_table(wasm_rt_table_t* table) {
   uint32_t new_size = 0;
-  WASM_SATURATING_U32_ADD(&new_size, table->size, 32);
+  WASM_SATURATING_U32_ADD(&new_size, table->size,
+                          table->size < 32 ? 32 : table->size);
 
   if (new_size > table->max_size) {
     new_size = table->max_size;
@@ -442,11 +1122,449 @@ void wasm_rt_expand_table(wasm_rt_table_t* table) {
   table->size = new_size;
 }
 
+uint32_t wasm_rt_table_alloc_slot(wasm_rt_table_t* table) {
+  if (table->free_slot_count != 0) {
+    return table->free_slots[--table->free_slot_count];
+  }
+  // Element 0 is never handed out, so that 0 can stand for no callback.
+  if (table->next_unscanned_slot == 0) {
+    table->next_unscanned_slot = 1;
+  }
+  for (;;) {
+    while (table->next_unscanned_slot < table->size) {
+      uint32_t index = table->next_unscanned_slot++;
+      if (table->data[index].func == 0) {
+        return index;
+      }
+    }
+    wasm_rt_expand_table(table);
+  }
+}
+
+void wasm_rt_table_free_slot(wasm_rt_table_t* table, uint32_t index) {
+  if (index >= table->size || table->data[index].func == 0) {
+    return;
+  }
+  memset(&table->data[index], 0, sizeof(wasm_rt_elem_t));
+  // Elements that have not been searched yet will be found empty anyway.
+  if (index == 0 || index >= table->next_unscanned_slot) {
+    return;
+  }
+  if (table->free_slot_count == table->free_slot_capacity) {
+    table->free_slot_capacity =
+        table->free_slot_capacity ? table->free_slot_capacity * 2 : 16;
+    table->free_slots = realloc(table->free_slots,
+                                table->free_slot_capacity * sizeof(uint32_t));
+    assert(table->free_slots != 0);
+  }
+  table->free_slots[table->free_slot_count++] = index;
+}
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+    defined(_M_IX86)
+static uint64_t profile_now() {
+  return __rdtsc();
+}
+#else
+static uint64_t profile_now() {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+#define PROFILE_ROOT_NODE 0
+#define PROFILE_NO_FUNC UINT32_MAX
+#define PROFILE_INITIAL_BUCKETS 64
+
+// A node of the calling context tree: one call stack, identified by its
+// innermost function and the node of its caller.
+typedef struct {
+  uint32_t parent;
+  uint32_t func;
+  // The child entered last, which is checked before the hash table.
+  uint32_t last_child;
+  uint64_t calls;
+  uint64_t self_ticks;
+  uint64_t total_ticks;
+} profile_node_t;
+
+typedef struct {
+  uint32_t node;
+  uint32_t trap_count;
+  uintptr_t frame_address;
+  uint64_t start;
+  uint64_t child_ticks;
+} profile_frame_t;
+
+struct wasm_rt_profile_tree_t {
+  profile_node_t* nodes;
+  uint32_t node_count;
+  uint32_t node_capacity;
+  // Open addressing from (parent, func) to the node index + 1, or 0 if empty.
+  uint32_t* buckets;
+  uint32_t bucket_count;
+  // The calls that are running, innermost last.
+  profile_frame_t* frames;
+  uint32_t frame_count;
+  uint32_t frame_capacity;
+};
+
+static uint32_t hash_profile_node(uint32_t parent, uint32_t func) {
+  uint32_t h = parent * 0x9e3779b1u ^ func;
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+  return h;
+}
+
+static void profile_insert_bucket(wasm_rt_profile_tree_t* tree,
+                                  uint32_t node) {
+  const profile_node_t* n = &tree->nodes[node];
+  uint32_t mask = tree->bucket_count - 1;
+  uint32_t bucket = hash_profile_node(n->parent, n->func) & mask;
+  while (tree->buckets[bucket] != 0) {
+    bucket = (bucket + 1) & mask;
+  }
+  tree->buckets[bucket] = node + 1;
+}
+
+static uint32_t profile_add_node(wasm_rt_profile_tree_t* tree,
+                                 uint32_t parent,
+                                 uint32_t func) {
+  if (tree->node_count == tree->node_capacity) {
+    tree->node_capacity = tree->node_capacity * 2;
+    tree->nodes =
+        realloc(tree->nodes, tree->node_capacity * sizeof(profile_node_t));
+    assert(tree->nodes != 0);
+  }
+  uint32_t node = tree->node_count++;
+  tree->nodes[node] = (profile_node_t){parent, func, 0, 0, 0, 0};
+  // Keep the load factor of the buckets at most 1/2.
+  if (tree->node_count * 2 > tree->bucket_count) {
+    free(tree->buckets);
+    tree->bucket_count *= 2;
+    tree->buckets = calloc(tree->bucket_count, sizeof(uint32_t));
+    assert(tree->buckets != 0);
+    for (uint32_t i = 1; i < tree->node_count; ++i) {
+      profile_insert_bucket(tree, i);
+    }
+  } else {
+    profile_insert_bucket(tree, node);
+  }
+  return node;
+}
+
+static uint32_t profile_child(wasm_rt_profile_tree_t* tree,
+                              uint32_t parent,
+                              uint32_t func) {
+  uint32_t last_child = tree->nodes[parent].last_child;
+  if (last_child != PROFILE_ROOT_NODE && tree->nodes[last_child].func == func) {
+    return last_child;
+  }
+  uint32_t mask = tree->bucket_count - 1;
+  uint32_t bucket = hash_profile_node(parent, func) & mask;
+  uint32_t node;
+  for (;;) {
+    uint32_t entry = tree->buckets[bucket];
+    if (entry == 0) {
+      node = profile_add_node(tree, parent, func);
+      break;
+    }
+    const profile_node_t* n = &tree->nodes[entry - 1];
+    if (n->parent == parent && n->func == func) {
+      node = entry - 1;
+      break;
+    }
+    bucket = (bucket + 1) & mask;
+  }
+  tree->nodes[parent].last_child = node;
+  return node;
+}
+
+void wasm_rt_profile_init(wasm_rt_profile_t* profile,
+                          uint32_t func_count,
+                          const char* const* func_names,
+                          bool count_calls,
+                          bool time_calls,
+                          uint32_t branch_count,
+                          const uint32_t* branch_funcs) {
+  memset(profile, 0, sizeof(*profile));
+  profile->func_count = func_count;
+  profile->func_names = func_names;
+  if (count_calls) {
+    profile->calls = calloc(func_count ? func_count : 1, sizeof(uint64_t));
+    assert(profile->calls != 0);
+  }
+  if (branch_funcs) {
+    profile->branch_count = branch_count;
+    profile->branch_funcs = branch_funcs;
+    profile->branches =
+        calloc(branch_count ? 2 * branch_count : 1, sizeof(uint64_t));
+    assert(profile->branches != 0);
+  }
+  if (time_calls) {
+    wasm_rt_profile_tree_t* tree = calloc(1, sizeof(wasm_rt_profile_tree_t));
+    assert(tree != 0);
+    tree->node_capacity = PROFILE_INITIAL_BUCKETS / 2;
+    tree->nodes = malloc(tree->node_capacity * sizeof(profile_node_t));
+    tree->bucket_count = PROFILE_INITIAL_BUCKETS;
+    tree->buckets = calloc(tree->bucket_count, sizeof(uint32_t));
+    tree->frame_capacity = 64;
+    tree->frames = malloc(tree->frame_capacity * sizeof(profile_frame_t));
+    assert(tree->nodes != 0 && tree->buckets != 0 && tree->frames != 0);
+    tree->nodes[PROFILE_ROOT_NODE] =
+        (profile_node_t){PROFILE_ROOT_NODE, PROFILE_NO_FUNC, 0, 0, 0, 0};
+    tree->node_count = 1;
+    profile->tree = tree;
+  }
+}
+
+void wasm_rt_profile_cleanup(wasm_rt_profile_t* profile) {
+  free(profile->calls);
+  free(profile->branches);
+  if (profile->tree) {
+    free(profile->tree->nodes);
+    free(profile->tree->buckets);
+    free(profile->tree->frames);
+    free(profile->tree);
+  }
+  memset(profile, 0, sizeof(*profile));
+}
+
+// Drops the calls that a trap unwound without returning: the ones that
+// started before the last trap of this thread, below the wasm_rt_try it
+// unwound to.
+static void profile_drop_unwound_frames(wasm_rt_profile_tree_t* tree) {
+  while (tree->frame_count > 0) {
+    const profile_frame_t* frame = &tree->frames[tree->frame_count - 1];
+    if (frame->trap_count == g_trap_count ||
+        frame->frame_address >= g_trap_frame_address) {
+      break;
+    }
+    --tree->frame_count;
+  }
+}
+
+uint32_t wasm_rt_profile_enter(wasm_rt_profile_t* profile,
+                               uint32_t func_index) {
+  wasm_rt_profile_tree_t* tree = profile->tree;
+  profile_drop_unwound_frames(tree);
+  uint32_t depth = tree->frame_count;
+  uint32_t parent =
+      depth > 0 ? tree->frames[depth - 1].node : PROFILE_ROOT_NODE;
+  uint32_t node = profile_child(tree, parent, func_index);
+  ++tree->nodes[node].calls;
+  if (tree->frame_count == tree->frame_capacity) {
+    tree->frame_capacity *= 2;
+    tree->frames = realloc(tree->frames,
+                           tree->frame_capacity * sizeof(profile_frame_t));
+    assert(tree->frames != 0);
+  }
+  tree->frame_count = depth + 1;
+  profile_frame_t* frame = &tree->frames[depth];
+  frame->node = node;
+  frame->trap_count = g_trap_count;
+  frame->frame_address = FRAME_ADDRESS();
+  frame->child_ticks = 0;
+  frame->start = profile_now();
+  return depth;
+}
+
+void wasm_rt_profile_exit(wasm_rt_profile_t* profile, uint32_t depth) {
+  uint64_t now = profile_now();
+  wasm_rt_profile_tree_t* tree = profile->tree;
+  profile_drop_unwound_frames(tree);
+  while (tree->frame_count > depth) {
+    const profile_frame_t* frame = &tree->frames[--tree->frame_count];
+    uint64_t total = now - frame->start;
+    profile_node_t* node = &tree->nodes[frame->node];
+    node->total_ticks += total;
+    node->self_ticks += total - frame->child_ticks;
+    if (tree->frame_count > 0) {
+      tree->frames[tree->frame_count - 1].child_ticks += total;
+    }
+  }
+}
+
+typedef struct {
+  uint32_t func;
+  uint64_t calls;
+  uint64_t self_ticks;
+  uint64_t total_ticks;
+} profile_func_stats_t;
+
+static int compare_profile_func_stats(const void* a, const void* b) {
+  const profile_func_stats_t* x = (const profile_func_stats_t*)a;
+  const profile_func_stats_t* y = (const profile_func_stats_t*)b;
+  if (x->self_ticks != y->self_ticks) {
+    return x->self_ticks < y->self_ticks ? 1 : -1;
+  }
+  if (x->calls != y->calls) {
+    return x->calls < y->calls ? 1 : -1;
+  }
+  return x->func < y->func ? -1 : x->func > y->func;
+}
+
+// Whether a caller of `node` is also a call of its function, in which case
+// the time of `node` is already part of the total time of that caller.
+static bool profile_node_is_recursive(const wasm_rt_profile_tree_t* tree,
+                                      uint32_t node) {
+  uint32_t func = tree->nodes[node].func;
+  for (uint32_t i = tree->nodes[node].parent; i != PROFILE_ROOT_NODE;
+       i = tree->nodes[i].parent) {
+    if (tree->nodes[i].func == func) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Sums up the calls and times of every function over the call stacks it was
+// called from.
+static profile_func_stats_t* profile_func_stats(
+    const wasm_rt_profile_t* profile) {
+  const wasm_rt_profile_tree_t* tree = profile->tree;
+  profile_func_stats_t* stats =
+      calloc(profile->func_count ? profile->func_count : 1,
+             sizeof(profile_func_stats_t));
+  assert(stats != 0);
+  for (uint32_t i = 0; i < profile->func_count; ++i) {
+    stats[i].func = i;
+    if (profile->calls) {
+      stats[i].calls = profile->calls[i];
+    }
+  }
+  if (tree) {
+    for (uint32_t i = 1; i < tree->node_count; ++i) {
+      const profile_node_t* node = &tree->nodes[i];
+      profile_func_stats_t* s = &stats[node->func];
+      if (!profile->calls) {
+        s->calls += node->calls;
+      }
+      s->self_ticks += node->self_ticks;
+      if (!profile_node_is_recursive(tree, i)) {
+        s->total_ticks += node->total_ticks;
+      }
+    }
+  }
+  return stats;
+}
+
+static void profile_dump_flat(const wasm_rt_profile_t* profile, FILE* out) {
+  const wasm_rt_profile_tree_t* tree = profile->tree;
+  profile_func_stats_t* stats = profile_func_stats(profile);
+  uint64_t ticks = 0;
+  for (uint32_t i = 0; i < profile->func_count; ++i) {
+    ticks += stats[i].self_ticks;
+  }
+  qsort(stats, profile->func_count, sizeof(profile_func_stats_t),
+        compare_profile_func_stats);
+
+  if (tree) {
+    fprintf(out, "%14s %7s %16s %16s  %s\n", "calls", "self%", "self ticks",
+            "total ticks", "function");
+  } else {
+    fprintf(out, "%14s  %s\n", "calls", "function");
+  }
+  for (uint32_t i = 0; i < profile->func_count; ++i) {
+    const profile_func_stats_t* s = &stats[i];
+    if (s->calls == 0) {
+      continue;
+    }
+    const char* name = profile->func_names[s->func];
+    if (tree) {
+      double percent = ticks ? 100.0 * (double)s->self_ticks / (double)ticks : 0;
+      fprintf(out, "%14" PRIu64 " %6.2f%% %16" PRIu64 " %16" PRIu64 "  %s\n",
+              s->calls, percent, s->self_ticks, s->total_ticks, name);
+    } else {
+      fprintf(out, "%14" PRIu64 "  %s\n", s->calls, name);
+    }
+  }
+  free(stats);
+}
+
+static void profile_dump_folded(const wasm_rt_profile_t* profile, FILE* out) {
+  const wasm_rt_profile_tree_t* tree = profile->tree;
+  uint32_t* stack = NULL;
+  uint32_t stack_capacity = 0;
+  for (uint32_t i = 1; i < tree->node_count; ++i) {
+    if (tree->nodes[i].self_ticks == 0) {
+      continue;
+    }
+    uint32_t depth = 0;
+    for (uint32_t n = i; n != PROFILE_ROOT_NODE; n = tree->nodes[n].parent) {
+      if (depth == stack_capacity) {
+        stack_capacity = stack_capacity ? stack_capacity * 2 : 64;
+        stack = realloc(stack, stack_capacity * sizeof(uint32_t));
+        assert(stack != 0);
+      }
+      stack[depth++] = tree->nodes[n].func;
+    }
+    while (depth > 0) {
+      fputs(profile->func_names[stack[--depth]], out);
+      fputc(depth > 0 ? ';' : ' ', out);
+    }
+    fprintf(out, "%" PRIu64 "\n", tree->nodes[i].self_ticks);
+  }
+  free(stack);
+}
+
+// Each branch is numbered within its function, in the order the branches
+// appear in the function.
+static void profile_dump_counts(const wasm_rt_profile_t* profile, FILE* out) {
+  if (profile->calls || profile->tree) {
+    profile_func_stats_t* stats = profile_func_stats(profile);
+    for (uint32_t i = 0; i < profile->func_count; ++i) {
+      fprintf(out, "func %" PRIu64 " %" PRIu64 " %s\n", stats[i].calls,
+              stats[i].self_ticks, profile->func_names[i]);
+    }
+    free(stats);
+  }
+  uint32_t index = 0;
+  for (uint32_t i = 0; i < profile->branch_count; ++i) {
+    uint32_t func = profile->branch_funcs[i];
+    if (i > 0 && profile->branch_funcs[i - 1] != func) {
+      index = 0;
+    }
+    fprintf(out, "branch %u %" PRIu64 " %" PRIu64 " %s\n", index++,
+            profile->branches[2 * i], profile->branches[2 * i + 1],
+            profile->func_names[func]);
+  }
+}
+
+bool wasm_rt_profile_dump(const wasm_rt_profile_t* profile,
+                          FILE* out,
+                          wasm_rt_profile_format_t format) {
+  switch (format) {
+    case WASM_RT_PROFILE_FLAT:
+      if (!profile->calls && !profile->tree) {
+        return false;
+      }
+      profile_dump_flat(profile, out);
+      return true;
+    case WASM_RT_PROFILE_FOLDED:
+      if (!profile->tree) {
+        return false;
+      }
+      profile_dump_folded(profile, out);
+      return true;
+    case WASM_RT_PROFILE_COUNTS:
+      if (!profile->calls && !profile->tree && !profile->branches) {
+        return false;
+      }
+      profile_dump_counts(profile, out);
+      return true;
+  }
+  return false;
+}
+
 void wasm2c_ensure_linked() {
   // We use this to ensure the dynamic library with the wasi symbols is loaded
   // for the host application
 }
 
+#undef FRAME_ADDRESS
 #undef WASM_PAGE_SIZE
 #undef WASM_HEAP_GUARD_PAGE_SIZE
 #undef WASM_HEAP_ALIGNMENT
@@ -4,11 +4,19 @@
 #if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || \
                          (defined(__APPLE__) && defined(__MACH__)))
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+// For pthread_getattr_np
+#define _GNU_SOURCE
+#endif
+
 #include "wasm-rt-os.h"
 #include "wasm-rt.h"
 
 #include <errno.h>
 #include <inttypes.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -19,6 +27,7 @@
 #include <mach/mach_time.h>
 #include <sys/time.h>
 #endif
+#include <fcntl.h>
 #include <sys/mman.h>
 #include <unistd.h>
 
@@ -178,6 +187,76 @@ int os_mmap_commit(void* curr_heap_end_pointer,
   return os_mprotect(curr_heap_end_pointer, expanded_size, prot);
 }
 
+int os_mmap_decommit(void* addr, size_t size) {
+#if defined(__linux__)
+  // On Linux, private anonymous pages read as zero again after MADV_DONTNEED.
+  if (madvise(addr, size, MADV_DONTNEED) != 0) {
+    return -1;
+  }
+  return os_mprotect(addr, size, MMAP_PROT_NONE);
+#else
+  // Elsewhere MADV_DONTNEED may keep the contents, so map fresh pages instead.
+  return os_mmap_reset(addr, size);
+#endif
+}
+
+int os_mmap_reset(void* addr, size_t size) {
+  void* ret = mmap(addr, size, PROT_NONE, MAP_ANONYMOUS | MAP_PRIVATE | MAP_FIXED,
+                   -1, 0);
+  return ret == MAP_FAILED ? -1 : 0;
+}
+
+int os_mmap_file_private(void* addr, size_t size, int fd) {
+  void* ret = mmap(addr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+                   fd, 0);
+  return ret == MAP_FAILED ? -1 : 0;
+}
+
+#if defined(__linux__)
+int os_memfd_create(const char* name, const uint8_t* data, size_t size) {
+  int fd = memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd < 0) {
+    return -1;
+  }
+  if (ftruncate(fd, size) != 0) {
+    close(fd);
+    return -1;
+  }
+  // The file starts out as zero, so only pages with data need to be written.
+  // Zero pages then don't take up any memory in the file.
+  const size_t page_size = os_getpagesize();
+  for (size_t offset = 0; offset < size; offset += page_size) {
+    size_t length = size - offset < page_size ? size - offset : page_size;
+    const uint8_t* page = data + offset;
+    size_t i = 0;
+    while (i < length && page[i] == 0) {
+      i++;
+    }
+    if (i == length) {
+      continue;
+    }
+    if (pwrite(fd, page, length, offset) != (ssize_t)length) {
+      close(fd);
+      return -1;
+    }
+  }
+  if (fcntl(fd, F_ADD_SEALS,
+            F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+#else
+int os_memfd_create(const char* name, const uint8_t* data, size_t size) {
+  return -1;
+}
+#endif
+
+void os_memfd_close(int fd) {
+  close(fd);
+}
+
 #if defined(__APPLE__) && defined(__MACH__)
 typedef struct {
   mach_timebase_info_data_t timebase; /* numer = 0, denom = 0 */
@@ -282,6 +361,232 @@ int os_clock_getres(void* clock_data,
   return ret;
 }
 
+// Threads waiting in os_atomic_wait are kept in lists hashed by address. A
+// waiter compares the value with the lock of its list held, and a notifier
+// takes the same lock after the store it notifies about, so no wakeup can be
+// lost between the comparison and the wait. Futexes would avoid the lock, but
+// only compare 32 bits.
+typedef struct wait_node_t {
+  void* addr;
+  pthread_cond_t cond;
+  bool woken;
+  struct wait_node_t* next;
+} wait_node_t;
+
+typedef struct {
+  pthread_mutex_t lock;
+  wait_node_t* waiters;
+} wait_list_t;
+
+#define WAIT_LIST_COUNT 64
+static wait_list_t g_wait_lists[WAIT_LIST_COUNT];
+static pthread_once_t g_wait_lists_once = PTHREAD_ONCE_INIT;
+
+static void init_wait_lists(void) {
+  for (int i = 0; i < WAIT_LIST_COUNT; i++) {
+    pthread_mutex_init(&g_wait_lists[i].lock, NULL);
+    g_wait_lists[i].waiters = NULL;
+  }
+}
+
+static wait_list_t* get_wait_list(void* addr) {
+  pthread_once(&g_wait_lists_once, init_wait_lists);
+  return &g_wait_lists[((uintptr_t)addr >> 2) % WAIT_LIST_COUNT];
+}
+
+// macOS has no pthread_condattr_setclock, so timeouts there follow the wall
+// clock.
+#if defined(__APPLE__)
+#define WAIT_CLOCK CLOCK_REALTIME
+#else
+#define WAIT_CLOCK CLOCK_MONOTONIC
+#endif
+
+#define BILLION 1000000000LL
+
+int os_atomic_wait(void* addr,
+                   uint64_t expected,
+                   uint32_t size,
+                   int64_t timeout_ns) {
+  wait_list_t* list = get_wait_list(addr);
+  pthread_mutex_lock(&list->lock);
+  uint64_t value = size == 8
+                       ? __atomic_load_n((uint64_t*)addr, __ATOMIC_SEQ_CST)
+                       : __atomic_load_n((uint32_t*)addr, __ATOMIC_SEQ_CST);
+  if (value != expected) {
+    pthread_mutex_unlock(&list->lock);
+    return 1;
+  }
+
+  wait_node_t node;
+  node.addr = addr;
+  node.woken = false;
+  node.next = NULL;
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+#if !defined(__APPLE__)
+  pthread_condattr_setclock(&attr, WAIT_CLOCK);
+#endif
+  pthread_cond_init(&node.cond, &attr);
+  pthread_condattr_destroy(&attr);
+
+  // Waiters are woken in the order they started waiting.
+  wait_node_t** link = &list->waiters;
+  while (*link) {
+    link = &(*link)->next;
+  }
+  *link = &node;
+
+  struct timespec deadline;
+  if (timeout_ns >= 0) {
+    clock_gettime(WAIT_CLOCK, &deadline);
+    int64_t ns = deadline.tv_nsec + timeout_ns % BILLION;
+    deadline.tv_sec += timeout_ns / BILLION + ns / BILLION;
+    deadline.tv_nsec = ns % BILLION;
+  }
+
+  int result = 0;
+  while (!node.woken) {
+    if (timeout_ns < 0) {
+      pthread_cond_wait(&node.cond, &list->lock);
+    } else if (pthread_cond_timedwait(&node.cond, &list->lock, &deadline) ==
+                   ETIMEDOUT &&
+               !node.woken) {
+      for (link = &list->waiters; *link != &node; link = &(*link)->next) {
+      }
+      *link = node.next;
+      result = 2;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&list->lock);
+  pthread_cond_destroy(&node.cond);
+  return result;
+}
+
+#undef BILLION
+
+uint32_t os_atomic_notify(void* addr, uint32_t count) {
+  wait_list_t* list = get_wait_list(addr);
+  uint32_t woken = 0;
+  pthread_mutex_lock(&list->lock);
+  wait_node_t** link = &list->waiters;
+  while (*link && woken < count) {
+    wait_node_t* node = *link;
+    if (node->addr == addr) {
+      *link = node->next;
+      node->woken = true;
+      pthread_cond_signal(&node->cond);
+      woken++;
+    } else {
+      link = &node->next;
+    }
+  }
+  pthread_mutex_unlock(&list->lock);
+  return woken;
+}
+
+static void (*g_fault_handler)(void* fault_addr) = NULL;
+static struct sigaction g_prev_sigsegv_action;
+static struct sigaction g_prev_sigbus_action;
+
+static void os_fault_signal_handler(int sig, siginfo_t* info, void* context) {
+  g_fault_handler(info->si_addr);
+
+  // The fault wasn't caused by a sandbox, so pass it on.
+  struct sigaction* prev =
+      sig == SIGSEGV ? &g_prev_sigsegv_action : &g_prev_sigbus_action;
+  if (prev->sa_flags & SA_SIGINFO) {
+    prev->sa_sigaction(sig, info, context);
+  } else if (prev->sa_handler == SIG_DFL || prev->sa_handler == SIG_IGN) {
+    // Returning retries the faulting access, which now gets the default action.
+    sigaction(sig, prev, NULL);
+  } else {
+    prev->sa_handler(sig);
+  }
+}
+
+int os_install_fault_handler(void (*handler)(void* fault_addr)) {
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  sigemptyset(&action.sa_mask);
+  // Traps leave the signal handler with longjmp, which doesn't restore the
+  // signal mask, so the signal must not be blocked while it is handled.
+  action.sa_flags = SA_SIGINFO | SA_ONSTACK | SA_NODEFER;
+  action.sa_sigaction = os_fault_signal_handler;
+  g_fault_handler = handler;
+  if (sigaction(SIGSEGV, &action, &g_prev_sigsegv_action) != 0 ||
+      sigaction(SIGBUS, &action, &g_prev_sigbus_action) != 0) {
+    return -1;
+  }
+  return 0;
+}
+
+static WASM_RT_THREAD_LOCAL void* g_signal_stack = NULL;
+
+int os_alloc_signal_stack() {
+  stack_t current;
+  if (sigaltstack(NULL, &current) != 0) {
+    return -1;
+  }
+  if (!(current.ss_flags & SS_DISABLE)) {
+    return 0;
+  }
+  size_t size = SIGSTKSZ < 65536 ? 65536 : SIGSTKSZ;
+  void* stack = malloc(size);
+  if (!stack) {
+    return -1;
+  }
+  stack_t signal_stack;
+  memset(&signal_stack, 0, sizeof(signal_stack));
+  signal_stack.ss_sp = stack;
+  signal_stack.ss_size = size;
+  if (sigaltstack(&signal_stack, NULL) != 0) {
+    free(stack);
+    return -1;
+  }
+  g_signal_stack = stack;
+  return 0;
+}
+
+void os_free_signal_stack() {
+  if (!g_signal_stack) {
+    return;
+  }
+  stack_t signal_stack;
+  memset(&signal_stack, 0, sizeof(signal_stack));
+  signal_stack.ss_flags = SS_DISABLE;
+  signal_stack.ss_size = MINSIGSTKSZ;
+  sigaltstack(&signal_stack, NULL);
+  free(g_signal_stack);
+  g_signal_stack = NULL;
+}
+
+int os_get_stack_low(uintptr_t* stack_low) {
+#if defined(__linux__)
+  pthread_attr_t attr;
+  if (pthread_getattr_np(pthread_self(), &attr) != 0) {
+    return -1;
+  }
+  void* addr;
+  size_t size;
+  int ret = pthread_attr_getstack(&attr, &addr, &size);
+  pthread_attr_destroy(&attr);
+  if (ret != 0) {
+    return -1;
+  }
+  *stack_low = (uintptr_t)addr;
+  return 0;
+#elif defined(__APPLE__) && defined(__MACH__)
+  pthread_t self = pthread_self();
+  *stack_low = (uintptr_t)pthread_get_stackaddr_np(self) -
+               pthread_get_stacksize_np(self);
+  return 0;
+#else
+  return -1;
+#endif
+}
+
 void os_print_last_error(const char* msg) {
   perror(msg);
 }
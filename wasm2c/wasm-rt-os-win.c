@@ -228,6 +228,25 @@ int os_mmap_commit(void* curr_heap_end_pointer,
   return ret;
 }
 
+int os_mmap_decommit(void* addr, size_t size) {
+  return VirtualFree(addr, size, MEM_DECOMMIT) ? 0 : -1;
+}
+
+// Memory images are not supported on Windows yet.
+int os_mmap_reset(void* addr, size_t size) {
+  return os_mmap_decommit(addr, size);
+}
+
+int os_mmap_file_private(void* addr, size_t size, int fd) {
+  return -1;
+}
+
+int os_memfd_create(const char* name, const uint8_t* data, size_t size) {
+  return -1;
+}
+
+void os_memfd_close(int fd) {}
+
 typedef struct {
   LARGE_INTEGER counts_per_sec;
 } wasi_win_clock_info_t;
@@ -297,6 +316,34 @@ int os_clock_getres(void* clock_data,
   return 0;
 }
 
+int os_atomic_wait(void* addr,
+                   uint64_t expected,
+                   uint32_t size,
+                   int64_t timeout_ns) {
+  printf("memory.atomic.wait is not supported on Windows\n");
+  abort();
+}
+
+uint32_t os_atomic_notify(void* addr, uint32_t count) {
+  printf("memory.atomic.notify is not supported on Windows\n");
+  abort();
+}
+
+// Faults are not turned into traps on Windows yet.
+int os_install_fault_handler(void (*handler)(void* fault_addr)) {
+  return -1;
+}
+
+int os_alloc_signal_stack() {
+  return -1;
+}
+
+void os_free_signal_stack() {}
+
+int os_get_stack_low(uintptr_t* stack_low) {
+  return -1;
+}
+
 void os_print_last_error(const char* msg) {
   DWORD errorMessageID = GetLastError();
   if (errorMessageID != 0) {
@@ -42,6 +42,22 @@ void* os_mmap_aligned(void* addr,
 // Commits and sets the permissions on an already allocated memory region
 // Returns 0 on success, non zero on failure.
 int os_mmap_commit(void* curr_heap_end_pointer, size_t expanded_size, int prot);
+// Discards the contents of a committed region and makes it inaccessible, but
+// keeps it reserved. It reads as zero when committed again.
+// Returns 0 on success, non zero on failure.
+int os_mmap_decommit(void* addr, size_t size);
+// Replaces a region, including file mappings, with fresh inaccessible pages.
+// Returns 0 on success, non zero on failure.
+int os_mmap_reset(void* addr, size_t size);
+// Maps size bytes of the file fd at addr, readable and writable, such that
+// writes are private to this mapping and copy only the pages they touch.
+// Returns 0 on success, non zero on failure.
+int os_mmap_file_private(void* addr, size_t size, int fd);
+
+// Create an anonymous in-memory file holding a copy of data, which can't be
+// modified afterwards. Returns the file descriptor, or -1 on failure.
+int os_memfd_create(const char* name, const uint8_t* data, size_t size);
+void os_memfd_close(int fd);
 
 void os_clock_init(void** clock_data_pointer);
 void os_clock_cleanup(void** clock_data_pointer);
@@ -52,6 +68,33 @@ int os_clock_getres(void* clock_data,
                     int clock_id,
                     struct timespec* out_struct);
 
+// Block the calling thread if the size (4 or 8) bytes at addr equal expected,
+// until woken by os_atomic_notify, or for at most timeout_ns nanoseconds if
+// timeout_ns is not negative. Returns 0 if woken, 1 if the value differs, 2 on
+// timeout.
+int os_atomic_wait(void* addr,
+                   uint64_t expected,
+                   uint32_t size,
+                   int64_t timeout_ns);
+// Wake up to count threads blocked in os_atomic_wait on addr.
+// Returns the number of threads woken.
+uint32_t os_atomic_notify(void* addr, uint32_t count);
+
+// Install handler to be called with the faulting address on memory access
+// faults. It runs on the alternate signal stack of the faulting thread. If it
+// returns, the fault is passed on to the previously installed handler.
+// Returns 0 on success, non zero on failure.
+int os_install_fault_handler(void (*handler)(void* fault_addr));
+// Give the calling thread an alternate signal stack, unless it already has
+// one, so faults caused by stack overflow can be handled.
+// Returns 0 on success, non zero on failure.
+int os_alloc_signal_stack();
+// Free the alternate signal stack allocated by os_alloc_signal_stack.
+void os_free_signal_stack();
+// Get the lowest address of the calling thread's stack.
+// Returns 0 on success, non zero on failure.
+int os_get_stack_low(uintptr_t* stack_low);
+
 // print the error message
 void os_print_last_error(const char* msg);
 
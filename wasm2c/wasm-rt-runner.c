@@ -124,7 +124,12 @@ int main(int argc, char const* argv[]) {
   }
 
   wasm2c_start_func_t start_func =
-      (wasm2c_start_func_t)symbol_lookup(library, "w2c__start");
+      (wasm2c_start_func_t)sandbox_info.lookup_wasm2c_func_export(
+          sandbox, "w2c__start", NULL);
+  if (!start_func) {
+    printf("Error: Could not find w2c__start" LINETERM);
+    exit(1);
+  }
   start_func(sandbox);
 
   free(info_func_name);
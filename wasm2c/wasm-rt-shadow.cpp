@@ -12,8 +12,12 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include <map>
-#include <functional>
+#include <algorithm>
+#include <vector>
+
+extern "C" {
+#include "wasm-rt-os.h"
+}
 
 typedef enum class ALLOC_STATE : uint8_t {
   UNINIT = 0, ALLOCED, INITIALIZED,
@@ -45,77 +49,281 @@ typedef struct {
   OWN_STATE own_state;
 } cell_data_t;
 
-static wasm2c_shadow_memory_cell_t pack(cell_data_t data) {
-  uint8_t alloc_bits = ((uint8_t)data.alloc_state) & 0b11;
-  uint8_t used_bits = (((uint8_t)data.used_state) & 0b11) << 2;
-  uint8_t own_bits = (((uint8_t)data.own_state) & 0b11) << 4;
-  uint8_t ret = alloc_bits | used_bits | own_bits;
-  return ret;
+// Each byte of memory has four bits of shadow state: the allocation state in
+// the low two bits and the used state in the next bit. The states of two bytes
+// are packed into a cell, and scanned 16 bytes at a time as 64-bit words, so
+// the common case of an access to memory in the expected state needs a few
+// bitwise operations per word rather than a branch per byte. The owner of each
+// byte is only tracked below the heap base, in a separate array.
+
+static const uint32_t STATES_PER_WORD = 16;
+// The lowest bit of each state in a word
+static const uint64_t STATE_LOW_BITS = 0x1111111111111111ull;
+
+static uint8_t get_state(const wasm2c_shadow_memory_t* shadow, uint32_t index) {
+  return (shadow->data[index >> 1] >> ((index & 1) * 4)) & 0xF;
+}
+
+static void set_state(wasm2c_shadow_memory_t* shadow, uint32_t index, uint8_t state) {
+  uint32_t shift = (index & 1) * 4;
+  uint8_t* cell = &shadow->data[index >> 1];
+  *cell = (uint8_t) ((*cell & ~(0xF << shift)) | (state << shift));
 }
 
-static cell_data_t unpack(wasm2c_shadow_memory_cell_t byte) {
-  uint8_t alloc_bits = byte & 0b11;
-  uint8_t used_bits = (byte & 0b1100) >> 2;
-  uint8_t own_bits = (byte & 0b110000) >> 4;
-  cell_data_t ret { (ALLOC_STATE) alloc_bits, (USED_STATE) used_bits, (OWN_STATE) own_bits};
+static cell_data_t unpack(const wasm2c_shadow_memory_t* shadow, uint32_t index) {
+  uint8_t state = get_state(shadow, index);
+  OWN_STATE own_state = OWN_STATE::UNKNOWN;
+  if (index < shadow->heap_base) {
+    own_state = (OWN_STATE) shadow->globals_owner[index];
+  }
+  cell_data_t ret { (ALLOC_STATE) (state & 0b11), (USED_STATE) ((state >> 2) & 0b1), own_state };
   return ret;
 }
 
+static void pack(wasm2c_shadow_memory_t* shadow, uint32_t index, cell_data_t data) {
+  uint8_t alloc_bits = ((uint8_t)data.alloc_state) & 0b11;
+  uint8_t used_bits = (((uint8_t)data.used_state) & 0b1) << 2;
+  set_state(shadow, index, alloc_bits | used_bits);
+  if (index < shadow->heap_base) {
+    shadow->globals_owner[index] = (uint8_t) data.own_state;
+  }
+}
+
+static uint64_t load_word(const wasm2c_shadow_memory_t* shadow, uint64_t offset) {
+  uint64_t word;
+  memcpy(&word, shadow->data + offset, sizeof(word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  word = __builtin_bswap64(word);
+#endif
+  return word;
+}
+
+static void store_word(wasm2c_shadow_memory_t* shadow, uint64_t offset, uint64_t word) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  word = __builtin_bswap64(word);
+#endif
+  memcpy(shadow->data + offset, &word, sizeof(word));
+}
+
+// Select the low bit of each state in a word with the given allocation state
+static inline uint64_t uninit_states(uint64_t word) {
+  return ~(word | (word >> 1)) & STATE_LOW_BITS;
+}
+
+static inline uint64_t alloced_states(uint64_t word) {
+  return word & ~(word >> 1) & STATE_LOW_BITS;
+}
+
+static inline uint64_t initialized_states(uint64_t word) {
+  return (word >> 1) & ~word & STATE_LOW_BITS;
+}
+
+// Calls callback(offset, states) for each word of shadow state overlapping
+// [ptr, ptr + ptr_size), where offset is the byte offset of the word and
+// states selects the low bit of the states in range. Stops early if the
+// callback returns false, and returns whether it always returned true.
+template <typename F>
+static inline bool shadow_words_iterate(uint32_t ptr, uint32_t ptr_size, F callback) {
+  uint64_t begin = ptr;
+  uint64_t end = ((uint64_t) ptr) + ptr_size;
+  while (begin < end) {
+    uint64_t word_begin = begin - begin % STATES_PER_WORD;
+    uint64_t word_end = word_begin + STATES_PER_WORD;
+    uint64_t states = STATE_LOW_BITS << ((begin - word_begin) * 4);
+    if (end < word_end) {
+      states &= (1ull << ((end - word_begin) * 4)) - 1;
+    }
+    if (!callback(word_begin / 2, states)) {
+      return false;
+    }
+    begin = word_end;
+  }
+  return true;
+}
+
+// Whether no byte in the range has a state picked by select
+template <typename F>
+static inline bool range_has_none(const wasm2c_shadow_memory_t* shadow, uint32_t ptr, uint32_t ptr_size, F select) {
+  return shadow_words_iterate(ptr, ptr_size, [&](uint64_t offset, uint64_t states) {
+    return (select(load_word(shadow, offset)) & states) == 0;
+  });
+}
+
+// Replace each word in the range by update(word, states)
+template <typename F>
+static inline void range_update(wasm2c_shadow_memory_t* shadow, uint32_t ptr, uint32_t ptr_size, F update) {
+  shadow_words_iterate(ptr, ptr_size, [&](uint64_t offset, uint64_t states) {
+    store_word(shadow, offset, update(load_word(shadow, offset), states));
+    return true;
+  });
+}
+
+static bool globals_owned_by(const wasm2c_shadow_memory_t* shadow, uint32_t ptr, uint32_t ptr_size, OWN_STATE owner) {
+  const uint8_t* owners = shadow->globals_owner + ptr;
+  for (uint32_t i = 0; i < ptr_size; i++) {
+    if (owners[i] != (uint8_t) owner) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static size_t round_up_to_page(uint64_t size) {
+  uint64_t page_size = os_getpagesize();
+  return (size_t) ((size + page_size - 1) & ~(page_size - 1));
+}
+
 void wasm2c_shadow_memory_create(wasm_rt_memory_t* mem) {
-  uint64_t new_size = ((uint64_t) mem->size) * sizeof(wasm2c_shadow_memory_cell_t);
-  mem->shadow_memory.data = (wasm2c_shadow_memory_cell_t*) calloc(new_size, 1);
-  assert(mem->shadow_memory.data != 0);
-  mem->shadow_memory.data_size = new_size;
-  mem->shadow_memory.allocation_sizes_map = new std::map<uint32_t, uint32_t>;
-  mem->shadow_memory.heap_base = 0;
+  wasm2c_shadow_memory_t* shadow = &mem->shadow_memory;
+  // Like the memory itself, the shadow is reserved for the largest size the
+  // memory can grow to, and committed as it grows.
+  uint64_t max_size = ((uint64_t) mem->max_pages) * 65536;
+  if (max_size > (((uint64_t) 1) << 32)) {
+    max_size = ((uint64_t) 1) << 32;
+  }
+  shadow->reserved_size = round_up_to_page(max_size / 2 + 1);
+  shadow->data = (wasm2c_shadow_memory_cell_t*) os_mmap(NULL, shadow->reserved_size, MMAP_PROT_NONE, MMAP_MAP_NONE);
+  assert(shadow->data != 0);
+  shadow->data_size = 0;
+  shadow->globals_owner = 0;
+  shadow->allocations = 0;
+  shadow->allocation_count = 0;
+  shadow->allocation_capacity = 0;
+  shadow->heap_base = 0;
+  shadow->sample_rate = 1;
+  wasm2c_shadow_memory_expand(mem);
 }
 
 void wasm2c_shadow_memory_expand(wasm_rt_memory_t* mem) {
-  uint64_t new_size = ((uint64_t) mem->size) * sizeof(wasm2c_shadow_memory_cell_t);
-  uint8_t* new_data = (uint8_t*) realloc(mem->shadow_memory.data, new_size);
-  assert(mem->shadow_memory.data != 0);
-  uint64_t old_size = mem->shadow_memory.data_size;
-  memset(new_data + old_size, 0, new_size - old_size);
-  mem->shadow_memory.data = new_data;
-  mem->shadow_memory.data_size = new_size;
+  wasm2c_shadow_memory_t* shadow = &mem->shadow_memory;
+  size_t new_size = round_up_to_page(((uint64_t) mem->size) / 2 + 1);
+  assert(new_size <= shadow->reserved_size);
+  if (new_size > shadow->data_size) {
+    // Committed pages read as zero, i.e. UNINIT and UNUSED
+    int ret = os_mmap_commit(shadow->data + shadow->data_size, new_size - shadow->data_size, MMAP_PROT_READ | MMAP_PROT_WRITE);
+    assert(ret == 0);
+    (void) ret;
+    shadow->data_size = new_size;
+  }
 }
 
-#define allocation_sizes_map(mem) ((std::map<uint32_t, uint32_t>*) mem->shadow_memory.allocation_sizes_map)
-
 void wasm2c_shadow_memory_destroy(wasm_rt_memory_t* mem) {
-  free(mem->shadow_memory.data);
-  mem->shadow_memory.data = 0;
-  mem->shadow_memory.data_size = 0;
-  delete allocation_sizes_map(mem);
-  mem->shadow_memory.allocation_sizes_map = 0;
-  mem->shadow_memory.heap_base = 0;
+  wasm2c_shadow_memory_t* shadow = &mem->shadow_memory;
+  os_munmap(shadow->data, shadow->reserved_size);
+  shadow->data = 0;
+  shadow->data_size = 0;
+  shadow->reserved_size = 0;
+  free(shadow->globals_owner);
+  shadow->globals_owner = 0;
+  free(shadow->allocations);
+  shadow->allocations = 0;
+  shadow->allocation_count = 0;
+  shadow->allocation_capacity = 0;
+  shadow->heap_base = 0;
+}
+
+static uint32_t hash_allocation_ptr(uint32_t ptr) {
+  // Allocations are aligned, so mix the high bits into the low ones
+  ptr ^= ptr >> 16;
+  ptr *= 0x85ebca6bu;
+  ptr ^= ptr >> 13;
+  ptr *= 0xc2b2ae35u;
+  ptr ^= ptr >> 16;
+  return ptr;
+}
+
+// Returns the slot holding ptr, or the empty slot where it would be inserted
+static wasm2c_shadow_allocation_t* find_allocation_slot(wasm2c_shadow_memory_t* shadow, uint32_t ptr) {
+  uint32_t mask = shadow->allocation_capacity - 1;
+  uint32_t i = hash_allocation_ptr(ptr) & mask;
+  while (shadow->allocations[i].ptr != 0 && shadow->allocations[i].ptr != ptr) {
+    i = (i + 1) & mask;
+  }
+  return &shadow->allocations[i];
 }
 
-typedef void (iterate_t)(uint32_t index, cell_data_t* data);
+static void insert_allocation(wasm2c_shadow_memory_t* shadow, uint32_t ptr, uint32_t ptr_size) {
+  if ((shadow->allocation_count + 1) * 4 > shadow->allocation_capacity * 3) {
+    wasm2c_shadow_allocation_t* old_allocations = shadow->allocations;
+    uint32_t old_capacity = shadow->allocation_capacity;
+    shadow->allocation_capacity = old_capacity ? old_capacity * 2 : 64;
+    shadow->allocations = (wasm2c_shadow_allocation_t*) calloc(shadow->allocation_capacity, sizeof(wasm2c_shadow_allocation_t));
+    assert(shadow->allocations != 0);
+    for (uint32_t i = 0; i < old_capacity; i++) {
+      if (old_allocations[i].ptr != 0) {
+        *find_allocation_slot(shadow, old_allocations[i].ptr) = old_allocations[i];
+      }
+    }
+    free(old_allocations);
+  }
+  wasm2c_shadow_allocation_t* slot = find_allocation_slot(shadow, ptr);
+  if (slot->ptr == 0) {
+    shadow->allocation_count++;
+  }
+  slot->ptr = ptr;
+  slot->size = ptr_size;
+}
+
+// Removes ptr from the allocations, returning false if it isn't there
+static bool remove_allocation(wasm2c_shadow_memory_t* shadow, uint32_t ptr, uint32_t* ptr_size) {
+  if (shadow->allocation_count == 0) {
+    return false;
+  }
+  wasm2c_shadow_allocation_t* slot = find_allocation_slot(shadow, ptr);
+  if (slot->ptr == 0) {
+    return false;
+  }
+  *ptr_size = slot->size;
+  shadow->allocation_count--;
+
+  // Shift back the following entries of the probe sequence that would no
+  // longer be found past the emptied slot.
+  uint32_t mask = shadow->allocation_capacity - 1;
+  uint32_t hole = (uint32_t) (slot - shadow->allocations);
+  uint32_t i = hole;
+  for (;;) {
+    i = (i + 1) & mask;
+    wasm2c_shadow_allocation_t entry = shadow->allocations[i];
+    if (entry.ptr == 0) {
+      break;
+    }
+    uint32_t home = hash_allocation_ptr(entry.ptr) & mask;
+    if (((i - home) & mask) >= ((i - hole) & mask)) {
+      shadow->allocations[hole] = entry;
+      hole = i;
+    }
+  }
+  shadow->allocations[hole].ptr = 0;
+  shadow->allocations[hole].size = 0;
+  return true;
+}
 
-static inline void memory_state_iterate(wasm_rt_memory_t* mem, uint32_t ptr, uint32_t ptr_size, std::function<iterate_t> callback) {
+template <typename F>
+static inline void memory_state_iterate(wasm_rt_memory_t* mem, uint32_t ptr, uint32_t ptr_size, F callback) {
   uint64_t max = ((uint64_t) ptr) + ptr_size;
   assert(max <= UINT32_MAX);
 
-  assert(max <= mem->shadow_memory.data_size);
+  assert(max <= mem->size);
 
   for (uint32_t i = ptr; i < ptr + ptr_size; i++) {
-    wasm2c_shadow_memory_cell_t curr_state = mem->shadow_memory.data[i];
-    cell_data_t unpacked = unpack(curr_state);
+    cell_data_t unpacked = unpack(&mem->shadow_memory, i);
     callback(i, &unpacked);
-    wasm2c_shadow_memory_cell_t new_state = pack(unpacked);
-    mem->shadow_memory.data[i] = new_state;
+    pack(&mem->shadow_memory, i, unpacked);
   }
 }
 
-void wasm2c_shadow_memory_reserve(wasm_rt_memory_t* mem, uint32_t ptr, uint32_t ptr_size) {
-  memory_state_iterate(mem, ptr, ptr_size, [&](uint32_t index, cell_data_t* data){
-    if (data->alloc_state == ALLOC_STATE::UNINIT) {
-      data->alloc_state = ALLOC_STATE::ALLOCED;
-    }
+// Mark the bytes in the range that are UNINIT as ALLOCED
+static void mark_alloced(wasm2c_shadow_memory_t* shadow, uint32_t ptr, uint32_t ptr_size) {
+  range_update(shadow, ptr, ptr_size, [](uint64_t word, uint64_t states) {
+    return word | (uninit_states(word) & states);
   });
 }
 
+void wasm2c_shadow_memory_reserve(wasm_rt_memory_t* mem, uint32_t ptr, uint32_t ptr_size) {
+  assert(((uint64_t) ptr) + ptr_size <= mem->size);
+  mark_alloced(&mem->shadow_memory, ptr, ptr_size);
+}
+
 static void report_error(wasm_rt_memory_t* mem, const char* func_name, const char* error_message, uint32_t index, cell_data_t* data) {
   const char* alloc_state_string = "<>";
   const char* used_state_string = "<>";
@@ -149,16 +357,20 @@ void wasm2c_shadow_memory_dlmalloc(wasm_rt_memory_t* mem, uint32_t ptr, uint32_t
     report_error(mem, func_name, "malloc returning a pointer outside the heap", ptr, 0);
   }
 
-  memory_state_iterate(mem, ptr, ptr_size, [&](uint32_t index, cell_data_t* data){
-    if (data->alloc_state != ALLOC_STATE::UNINIT) {
-      report_error(mem, func_name, "Malloc returned a pointer in already occupied memory!", index, data);
-    } else {
-      data->alloc_state = ALLOC_STATE::ALLOCED;
-    }
-  });
+  wasm2c_shadow_memory_t* shadow = &mem->shadow_memory;
+  if (range_has_none(shadow, ptr, ptr_size, [](uint64_t word) { return ~uninit_states(word); })) {
+    mark_alloced(shadow, ptr, ptr_size);
+  } else {
+    memory_state_iterate(mem, ptr, ptr_size, [&](uint32_t index, cell_data_t* data){
+      if (data->alloc_state != ALLOC_STATE::UNINIT) {
+        report_error(mem, func_name, "Malloc returned a pointer in already occupied memory!", index, data);
+      } else {
+        data->alloc_state = ALLOC_STATE::ALLOCED;
+      }
+    });
+  }
 
-  auto alloc_map = allocation_sizes_map(mem);
-  (*alloc_map)[ptr] = ptr_size;
+  insert_allocation(shadow, ptr, ptr_size);
 }
 
 void wasm2c_shadow_memory_dlfree(wasm_rt_memory_t* mem, uint32_t ptr) {
@@ -169,14 +381,16 @@ void wasm2c_shadow_memory_dlfree(wasm_rt_memory_t* mem, uint32_t ptr) {
 
   const char* func_name = "<FREE>";
 
-  auto alloc_map = allocation_sizes_map(mem);
-  auto it = alloc_map->find(ptr);
-  if (it == alloc_map->end()) {
+  wasm2c_shadow_memory_t* shadow = &mem->shadow_memory;
+  uint32_t ptr_size;
+  if (!remove_allocation(shadow, ptr, &ptr_size)) {
     report_error(mem, func_name, "Freeing a pointer that was not allocated!", ptr, 0);
+  } else if (range_has_none(shadow, ptr, ptr_size, [](uint64_t word) { return uninit_states(word); })) {
+    // Every byte becomes UNINIT and FREED
+    range_update(shadow, ptr, ptr_size, [](uint64_t word, uint64_t states) {
+      return (word & ~(states * 0xF)) | (states * 0x4);
+    });
   } else {
-    uint32_t ptr_size = it->second;
-    alloc_map->erase(it);
-
     memory_state_iterate(mem, ptr, ptr_size, [&](uint32_t index, cell_data_t* data){
       if (data->alloc_state == ALLOC_STATE::UNINIT) {
         report_error(mem, func_name, "Freeing uninitialized memory", index, data);
@@ -191,7 +405,14 @@ void wasm2c_shadow_memory_dlfree(wasm_rt_memory_t* mem, uint32_t ptr) {
 }
 
 void wasm2c_shadow_memory_mark_globals_heap_boundary(wasm_rt_memory_t* mem, uint32_t ptr) {
-  mem->shadow_memory.heap_base = ptr;
+  wasm2c_shadow_memory_t* shadow = &mem->shadow_memory;
+  uint8_t* owners = (uint8_t*) realloc(shadow->globals_owner, ptr ? ptr : 1);
+  assert(owners != 0);
+  if (ptr > shadow->heap_base) {
+    memset(owners + shadow->heap_base, (int) OWN_STATE::UNKNOWN, ptr - shadow->heap_base);
+  }
+  shadow->globals_owner = owners;
+  shadow->heap_base = ptr;
   wasm2c_shadow_memory_reserve(mem, 0, ptr);
 }
 
@@ -207,36 +428,94 @@ static void check_heap_base_straddle(wasm_rt_memory_t* mem, const char* func_nam
   }
 }
 
-static bool is_malloc_family_function(const char* func_name, bool include_calloc, bool include_realloc) {
-  if(strcmp(func_name, "w2c_dlmalloc") == 0 || strcmp(func_name, "w2c_dlfree") == 0 || strcmp(func_name, "w2c_sbrk") == 0) {
-    return true;
+// Classes of functions that are allowed to access allocator metadata. The
+// class of each function is computed by wasm2c, so no names are compared here.
+static const uint32_t malloc_core_classes = WASM2C_SHADOW_FUNC_MALLOC_CORE;
+static const uint32_t malloc_any_classes =
+    WASM2C_SHADOW_FUNC_MALLOC_CORE | WASM2C_SHADOW_FUNC_CALLOC | WASM2C_SHADOW_FUNC_REALLOC;
+// calloc shouldn't modify metadata
+static const uint32_t malloc_write_classes =
+    WASM2C_SHADOW_FUNC_MALLOC_CORE | WASM2C_SHADOW_FUNC_REALLOC;
+
+// The owner a function leaves on the C globals it accesses, or UNKNOWN if the
+// access leaves them unchanged
+static OWN_STATE globals_owner_after_access(bool malloc_core_family, bool malloc_any_family) {
+  if (malloc_core_family) {
+    return OWN_STATE::MALLOC;
+  } else if (malloc_any_family) {
+    return OWN_STATE::UNKNOWN;
   }
-  if (include_calloc) {
-    if(strcmp(func_name, "w2c_calloc") == 0) {
-      return true;
-    }
+  return OWN_STATE::PROGRAM;
+}
+
+// Whether an access to the C globals leaves their owner unchanged
+static bool globals_access_is_clean(const wasm2c_shadow_memory_t* shadow, uint32_t ptr, uint32_t ptr_size, bool malloc_core_family, bool malloc_any_family) {
+  OWN_STATE owner = globals_owner_after_access(malloc_core_family, malloc_any_family);
+  return owner == OWN_STATE::UNKNOWN || globals_owned_by(shadow, ptr, ptr_size, owner);
+}
+
+// Whether the access can't report an error or change any state, other than
+// making ALLOCED bytes INITIALIZED, which store_is_clean does itself. This
+// covers the common case of accesses entirely on one side of the heap base to
+// memory in the expected state. Other accesses are checked byte by byte.
+static bool load_is_clean(const wasm2c_shadow_memory_t* shadow, uint32_t ptr, uint32_t ptr_size, bool malloc_read_family, bool malloc_core_family, bool malloc_any_family, bool overread_func_family) {
+  uint64_t end = ((uint64_t) ptr) + ptr_size;
+  bool in_heap = ptr >= shadow->heap_base;
+  if (!in_heap && end > shadow->heap_base) {
+    return false;
   }
-  if (include_realloc) {
-    if(strcmp(func_name, "w2c_realloc") == 0) {
-      return true;
-    }
+  if (in_heap && malloc_read_family) {
+    return true;
   }
-  return false;
+  if (!in_heap && !globals_access_is_clean(shadow, ptr, ptr_size, malloc_core_family, malloc_any_family)) {
+    return false;
+  }
+  uint32_t checked_size = overread_func_family && ptr_size > 0 ? 1 : ptr_size;
+#ifdef WASM_CHECK_SHADOW_MEMORY_UNINIT_READ
+  return range_has_none(shadow, ptr, checked_size, [](uint64_t word) { return ~initialized_states(word); });
+#else
+  return range_has_none(shadow, ptr, checked_size, [](uint64_t word) { return uninit_states(word); });
+#endif
 }
 
-// Functions that intentionally read beyond the end of an allocation for performance
-// The limit is upto 7 bytes past the end of the allocation
-static bool is_overread_function(const char* func_name) {
-  return strcmp(func_name, "w2c_strlen") == 0;
+static bool store_is_clean(wasm2c_shadow_memory_t* shadow, uint32_t ptr, uint32_t ptr_size, bool malloc_write_family, bool malloc_core_family, bool malloc_any_family) {
+  uint64_t end = ((uint64_t) ptr) + ptr_size;
+  bool in_heap = ptr >= shadow->heap_base;
+  if (!in_heap && end > shadow->heap_base) {
+    return false;
+  }
+  if (in_heap && malloc_write_family) {
+    return true;
+  }
+  if (!in_heap && !globals_access_is_clean(shadow, ptr, ptr_size, malloc_core_family, malloc_any_family)) {
+    return false;
+  }
+  // ALLOCED (0b01) bytes become INITIALIZED (0b10), stopping at the first
+  // word with an UNINIT byte. Updating the words before it makes no
+  // difference to the byte by byte check that follows.
+  return shadow_words_iterate(ptr, ptr_size, [&](uint64_t offset, uint64_t states) {
+    uint64_t word = load_word(shadow, offset);
+    if (uninit_states(word) & states) {
+      return false;
+    }
+    store_word(shadow, offset, word ^ ((alloced_states(word) & states) * 0b11));
+    return true;
+  });
 }
 
-WASM2C_FUNC_EXPORT void wasm2c_shadow_memory_load(wasm_rt_memory_t* mem, const char* func_name, uint32_t ptr, uint32_t ptr_size) {
+WASM2C_FUNC_EXPORT void wasm2c_shadow_memory_load(wasm_rt_memory_t* mem, uint32_t shadow_class, const char* func_name, uint32_t ptr, uint32_t ptr_size) {
   check_heap_base_straddle(mem, func_name, ptr, ptr_size);
 
-  bool malloc_read_family = is_malloc_family_function(func_name, true, true);
-  bool malloc_core_family = is_malloc_family_function(func_name, false, false);
+  bool malloc_read_family = (shadow_class & malloc_any_classes) != 0;
+  bool malloc_core_family = (shadow_class & malloc_core_classes) != 0;
   bool malloc_any_family  = malloc_read_family;
-  bool overread_func_family = is_overread_function(func_name);
+  // Functions that intentionally read beyond the end of an allocation for performance
+  // The limit is upto 7 bytes past the end of the allocation
+  bool overread_func_family = (shadow_class & WASM2C_SHADOW_FUNC_OVERREAD) != 0;
+
+  if (load_is_clean(&mem->shadow_memory, ptr, ptr_size, malloc_read_family, malloc_core_family, malloc_any_family, overread_func_family)) {
+    return;
+  }
 
   memory_state_iterate(mem, ptr, ptr_size, [&](uint32_t index, cell_data_t* data){
     // Is this function exempt from checking
@@ -288,12 +567,16 @@ WASM2C_FUNC_EXPORT void wasm2c_shadow_memory_load(wasm_rt_memory_t* mem, const c
   });
 }
 
-WASM2C_FUNC_EXPORT void wasm2c_shadow_memory_store(wasm_rt_memory_t* mem, const char* func_name, uint32_t ptr, uint32_t ptr_size) {
+WASM2C_FUNC_EXPORT void wasm2c_shadow_memory_store(wasm_rt_memory_t* mem, uint32_t shadow_class, const char* func_name, uint32_t ptr, uint32_t ptr_size) {
   check_heap_base_straddle(mem, func_name, ptr, ptr_size);
 
-  bool malloc_write_family = is_malloc_family_function(func_name, false /* calloc shouldn't modify metadata */, true);
-  bool malloc_core_family = is_malloc_family_function(func_name, false, false);
-  bool malloc_any_family  = is_malloc_family_function(func_name, true, true);
+  bool malloc_write_family = (shadow_class & malloc_write_classes) != 0;
+  bool malloc_core_family = (shadow_class & malloc_core_classes) != 0;
+  bool malloc_any_family  = (shadow_class & malloc_any_classes) != 0;
+
+  if (store_is_clean(&mem->shadow_memory, ptr, ptr_size, malloc_write_family, malloc_core_family, malloc_any_family)) {
+    return;
+  }
 
   memory_state_iterate(mem, ptr, ptr_size, [&](uint32_t index, cell_data_t* data){
     // Is this function exempt from checking
@@ -334,13 +617,47 @@ WASM2C_FUNC_EXPORT void wasm2c_shadow_memory_store(wasm_rt_memory_t* mem, const
   });
 }
 
+static WASM_RT_THREAD_LOCAL uint64_t g_sample_rng_state = 0;
+
+WASM2C_FUNC_EXPORT uint32_t wasm2c_shadow_memory_next_sample(wasm_rt_memory_t* mem) {
+  uint32_t rate = __atomic_load_n(&mem->shadow_memory.sample_rate, __ATOMIC_RELAXED);
+  if (rate <= 1) {
+    return 1;
+  }
+  if (g_sample_rng_state == 0) {
+    // Seed each thread differently
+    g_sample_rng_state = (uint64_t) (uintptr_t) &g_sample_rng_state | 1;
+  }
+  // splitmix64
+  uint64_t z = (g_sample_rng_state += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  z ^= z >> 31;
+  // Uniform in [1, 2 * rate - 1], so one in rate accesses is checked on
+  // average
+  return 1 + (uint32_t) (z % (2 * (uint64_t) rate - 1));
+}
+
+WASM2C_FUNC_EXPORT void wasm2c_shadow_memory_set_sample_rate(wasm_rt_memory_t* mem, uint32_t rate) {
+  __atomic_store_n(&mem->shadow_memory.sample_rate, rate, __ATOMIC_RELAXED);
+}
+
 WASM2C_FUNC_EXPORT void wasm2c_shadow_memory_print_allocations(wasm_rt_memory_t* mem) {
-  auto alloc_map = allocation_sizes_map(mem);
+  const wasm2c_shadow_memory_t* shadow = &mem->shadow_memory;
+  std::vector<wasm2c_shadow_allocation_t> allocations;
+  for (uint32_t i = 0; i < shadow->allocation_capacity; i++) {
+    if (shadow->allocations[i].ptr != 0) {
+      allocations.push_back(shadow->allocations[i]);
+    }
+  }
+  std::sort(allocations.begin(), allocations.end(), [](const wasm2c_shadow_allocation_t& a, const wasm2c_shadow_allocation_t& b) {
+    return a.ptr < b.ptr;
+  });
   puts("{ ");
   int counter = 0;
-  for (auto i = alloc_map->begin(); i != alloc_map->end(); ++i)
+  for (auto i = allocations.begin(); i != allocations.end(); ++i)
   {
-    printf("%" PRIu32 ": %" PRIu32 ", ", i->first, i->second);
+    printf("%" PRIu32 ": %" PRIu32 ", ", i->ptr, i->size);
     counter++;
     if (counter >= 40) {
       counter = 0;
@@ -351,11 +668,11 @@ WASM2C_FUNC_EXPORT void wasm2c_shadow_memory_print_allocations(wasm_rt_memory_t*
 }
 
 WASM2C_FUNC_EXPORT uint64_t wasm2c_shadow_memory_print_total_allocations(wasm_rt_memory_t* mem) {
-  auto alloc_map = allocation_sizes_map(mem);
-  uint64_t used_memory = mem->shadow_memory.heap_base;
-  for (auto i = alloc_map->begin(); i != alloc_map->end(); ++i)
+  const wasm2c_shadow_memory_t* shadow = &mem->shadow_memory;
+  uint64_t used_memory = shadow->heap_base;
+  for (uint32_t i = 0; i < shadow->allocation_capacity; i++)
   {
-    used_memory += i->second;
+    used_memory += shadow->allocations[i].size;
   }
   return used_memory;
 }
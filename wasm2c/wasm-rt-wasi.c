@@ -1036,8 +1036,9 @@ u32 Z_wasi_snapshot_preview1Z_clock_res_getZ_iii(
 /////////////////////////////////////////////////////////////
 ////////// Misc
 /////////////////////////////////////////////////////////////
-void wasm_rt_sys_init() {
+bool wasm_rt_sys_init() {
   os_init();
+  return wasm_rt_install_fault_handler();
 }
 
 void wasm_rt_init_wasi(wasm_sandbox_wasi_data* wasi_data) {
@@ -21,6 +21,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 
 #if defined(_WIN32)
 #define WASM2C_FUNC_EXPORT __declspec(dllexport)
@@ -67,6 +68,14 @@ extern "C" {
 #define WASM_RT_NO_RETURN __attribute__((noreturn))
 #endif
 
+#if defined(_MSC_VER)
+#define WASM_RT_THREAD_LOCAL __declspec(thread)
+#elif defined(__cplusplus)
+#define WASM_RT_THREAD_LOCAL thread_local
+#else
+#define WASM_RT_THREAD_LOCAL _Thread_local
+#endif
+
 /** Reason a trap occurred. Provide this to `wasm_rt_trap`.
  * If you update this enum also update the error message in wasm_rt_trap.
  */
@@ -92,6 +101,8 @@ typedef enum {
   WASM_RT_TRAP_EXHAUSTION,                  /** Call stack exhausted. */
   WASM_RT_TRAP_SHADOW_MEM, /** Trap due to shadow memory mismatch */
   WASM_RT_TRAP_WASI,       /** Trap due to WASI error */
+  WASM_RT_TRAP_UNALIGNED,  /** Misaligned atomic access. */
+  WASM_RT_TRAP_UNSHARED_MEMORY, /** memory.atomic.wait on an unshared memory. */
 } wasm_rt_trap_t;
 
 /** Value types. Used to define function signatures. */
@@ -100,6 +111,7 @@ typedef enum {
   WASM_RT_I64,
   WASM_RT_F32,
   WASM_RT_F64,
+  WASM_RT_V128,
 } wasm_rt_type_t;
 
 /** A function type for all `anyfunc` functions in a Table. All functions are
@@ -118,7 +130,9 @@ typedef enum {
 /** A single element of a Table. */
 typedef struct {
   wasm_rt_elem_target_class_t func_class;
-  /** The index as returned from `wasm_rt_register_func_type`. */
+  /** The index as returned from `wasm_rt_register_func_type`, or 0 for an
+   * empty element. No function type has index 0, so checking the type of an
+   * element also checks that it is not empty. */
   uint32_t func_type;
   /** The function. The embedder must know the actual C signature of the
    * function and cast to it before calling. */
@@ -128,10 +142,29 @@ typedef struct {
 typedef uint8_t wasm2c_shadow_memory_cell_t;
 
 typedef struct {
+  uint32_t ptr;
+  uint32_t size;
+} wasm2c_shadow_allocation_t;
+
+typedef struct {
+  /** Four bits of state for each byte of the memory, packed two to a cell.
+   * `reserved_size` bytes are reserved for the largest size the memory can
+   * grow to, and the first `data_size` bytes are committed. */
   wasm2c_shadow_memory_cell_t* data;
   size_t data_size;
-  void* allocation_sizes_map;
+  size_t reserved_size;
+  /** Which code owns each byte below `heap_base`, one byte each. */
+  uint8_t* globals_owner;
+  /** Open addressing hash table of the live allocations, keyed by pointer. An
+   * empty slot has a pointer of 0. */
+  wasm2c_shadow_allocation_t* allocations;
+  uint32_t allocation_count;
+  uint32_t allocation_capacity;
   uint32_t heap_base;
+  /** The average number of loads and stores per checked one, when the
+   * generated code samples them. The generated code sets it from its own
+   * WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE when it allocates the memory. */
+  uint32_t sample_rate;
 } wasm2c_shadow_memory_t;
 
 /** A Memory object. */
@@ -148,6 +181,15 @@ typedef struct {
   uint32_t pages, max_pages;
   /** The current size of the linear memory, in bytes. */
   uint32_t size;
+  /** Whether this memory was allocated with `wasm_rt_allocate_shared_memory`,
+   * and may be used by several threads at once. */
+  bool is_shared;
+  /** Whether `data` is a slot of the memory pool, see
+   * `wasm_rt_init_memory_pool`. */
+  bool is_pooled;
+  /** The number of bytes at the start of `data` that are mapped from a memory
+   * image, see `wasm_rt_allocate_memory_from_image`. */
+  uint32_t image_size;
 
   /** 32-bit platforms use masking for sandboxing. This sets the mask, which is
    * computed based on the heap size */
@@ -169,6 +211,14 @@ typedef struct {
   uint32_t max_size;
   /** The current element count of the table. */
   uint32_t size;
+  /** Elements freed by `wasm_rt_table_free_slot`, to be handed out again by
+   * `wasm_rt_table_alloc_slot`. */
+  uint32_t* free_slots;
+  uint32_t free_slot_count;
+  uint32_t free_slot_capacity;
+  /** Elements from this index on have not been searched for a free element
+   * yet. */
+  uint32_t next_unscanned_slot;
 } wasm_rt_table_t;
 
 typedef struct wasm_func_type_t {
@@ -198,11 +248,14 @@ typedef struct wasm_sandbox_wasi_data {
 
 } wasm_sandbox_wasi_data;
 
-typedef void (*wasm_rt_sys_init_t)(void);
+typedef bool (*wasm_rt_sys_init_t)(void);
 typedef void* (*create_wasm2c_sandbox_t)(uint32_t max_wasm_pages);
 typedef void (*destroy_wasm2c_sandbox_t)(void* sbx_ptr);
 typedef void* (*lookup_wasm2c_nonfunc_export_t)(void* sbx_ptr,
                                                 const char* name);
+typedef wasm_rt_anyfunc_t (*lookup_wasm2c_func_export_t)(void* sbx_ptr,
+                                                         const char* name,
+                                                         uint32_t* func_type);
 typedef uint32_t (*lookup_wasm2c_func_index_t)(void* sbx_ptr,
                                                uint32_t param_count,
                                                uint32_t result_count,
@@ -213,6 +266,25 @@ typedef uint32_t (*add_wasm2c_callback_t)(
     void* func_ptr,
     wasm_rt_elem_target_class_t func_class);
 typedef void (*remove_wasm2c_callback_t)(void* sbx_ptr, uint32_t callback_idx);
+typedef void* (*create_wasm2c_sandbox_thread_t)(void* parent_sbx_ptr);
+typedef void* (*create_wasm2c_sandbox_snapshot_t)(void* sbx_ptr);
+typedef void* (*create_wasm2c_sandbox_from_snapshot_t)(void* snapshot_ptr,
+                                                       uint32_t max_wasm_pages);
+typedef void (*destroy_wasm2c_sandbox_snapshot_t)(void* snapshot_ptr);
+
+/** How `dump_wasm2c_profile` writes the profile of a sandbox. */
+typedef enum {
+  /** One line per function, with the most expensive functions first. */
+  WASM_RT_PROFILE_FLAT,
+  /** One line per call stack, in the "folded" format of flamegraph.pl. */
+  WASM_RT_PROFILE_FOLDED,
+  /** The counts of every function and branch, for `wasm2c --profile-use`. */
+  WASM_RT_PROFILE_COUNTS,
+} wasm_rt_profile_format_t;
+
+typedef bool (*dump_wasm2c_profile_t)(void* sbx_ptr,
+                                      FILE* out,
+                                      wasm_rt_profile_format_t format);
 
 typedef struct wasm2c_sandbox_funcs_t {
   wasm_rt_sys_init_t wasm_rt_sys_init;
@@ -222,10 +294,71 @@ typedef struct wasm2c_sandbox_funcs_t {
   lookup_wasm2c_func_index_t lookup_wasm2c_func_index;
   add_wasm2c_callback_t add_wasm2c_callback;
   remove_wasm2c_callback_t remove_wasm2c_callback;
+  create_wasm2c_sandbox_thread_t create_wasm2c_sandbox_thread;
+  create_wasm2c_sandbox_snapshot_t create_wasm2c_sandbox_snapshot;
+  create_wasm2c_sandbox_from_snapshot_t create_wasm2c_sandbox_from_snapshot;
+  destroy_wasm2c_sandbox_snapshot_t destroy_wasm2c_sandbox_snapshot;
+  lookup_wasm2c_func_export_t lookup_wasm2c_func_export;
+  dump_wasm2c_profile_t dump_wasm2c_profile;
 } wasm2c_sandbox_funcs_t;
 
-/** Stop execution immediately and jump back to the call to `wasm_rt_try`.
- *  The result of `wasm_rt_try` will be the provided trap reason.
+/** The current call depth of the calling thread. The generated code does not
+ * update this itself; embedders that want to limit the call depth can do so
+ * from `FUNC_PROLOGUE` and `FUNC_EPILOGUE`. `wasm_rt_try` restores it when
+ * a trap unwinds. */
+extern WASM_RT_THREAD_LOCAL uint32_t wasm_rt_call_stack_depth;
+
+/** A point that `wasm_rt_trap` can unwind to, set up with `wasm_rt_try`. */
+typedef struct wasm_rt_jmp_buf {
+  jmp_buf buffer;
+  /** The enclosing `wasm_rt_try` of this thread, if any. */
+  struct wasm_rt_jmp_buf* prev;
+  /** The value of `wasm_rt_call_stack_depth` when `wasm_rt_try` was used. */
+  uint32_t saved_call_stack_depth;
+  /** An address on the native stack at `wasm_rt_try`. The frames of the calls
+   * a trap unwinds are all below it. */
+  uintptr_t frame_address;
+  /** The reason of the trap that unwound to this target, or
+   * `WASM_RT_TRAP_NONE`. */
+  wasm_rt_trap_t trap;
+} wasm_rt_jmp_buf;
+
+/** Recover from traps in the calling thread. `wasm_rt_try` is used like the
+ *  `if` of an `if`/`else` statement: the first branch runs the protected
+ *  calls, and if one of them traps, execution continues in the `else` branch,
+ *  with the trap reason in the `trap` field of the target. `wasm_rt_end_try`
+ *  must be called once the protected calls return normally, before the
+ *  function containing `wasm_rt_try` returns.
+ *
+ *  ```
+ *    wasm_rt_jmp_buf jb;
+ *    wasm_rt_try(jb) {
+ *      result = w2c_foo(sbx, 1);
+ *      wasm_rt_end_try(jb);
+ *    } else {
+ *      // jb.trap holds the reason. The sandbox may be used again, or
+ *      // destroyed.
+ *    }
+ *  ```
+ *
+ *  The macro expands to two statements, so it can't be the body of another
+ *  `if` or loop without braces. `setjmp` is the whole controlling expression
+ *  of its `if`, as the C standard requires.
+ *
+ *  Uses of `wasm_rt_try` may be nested. A trap unwinds to the innermost one,
+ *  which is removed, so `wasm_rt_end_try` must not be called after a trap.
+ *  Without an enclosing `wasm_rt_try`, traps call `WASM_RT_CUSTOM_TRAP_HANDLER`
+ *  if it is defined, and abort otherwise. */
+#define wasm_rt_try(target)                \
+  wasm_rt_push_unwind_target(&(target));   \
+  if (setjmp((target).buffer) == 0)
+#define wasm_rt_end_try(target) wasm_rt_pop_unwind_target(&(target))
+
+extern void wasm_rt_push_unwind_target(wasm_rt_jmp_buf*);
+extern void wasm_rt_pop_unwind_target(wasm_rt_jmp_buf*);
+
+/** Stop execution immediately and jump back to the call to `wasm_rt_try`,
+ *  whose target then holds the provided trap reason.
  *
  *  This is typically called by the generated code, and not the embedder. */
 WASM_RT_NO_RETURN extern void wasm_rt_trap(wasm_rt_trap_t);
@@ -239,33 +372,58 @@ WASM_RT_NO_RETURN extern void wasm_rt_callback_error_trap(
     uint32_t func_index,
     uint32_t expected_func_type);
 
+/** Function types with few enough params and results have an index that is
+ * computed from their signature, so that wasm2c can write it out as a
+ * constant: `WASM_RT_INLINE_FUNC_TYPE_BIT`, the param count in bits 28-30,
+ * the result count in bits 26-27, and 3 bits for each of the params and then
+ * the results, starting from bit 0. Indices of other function types are
+ * handed out by the registry, and never have the top bit set. */
+#define WASM_RT_INLINE_FUNC_TYPE_BIT 0x80000000u
+#define WASM_RT_INLINE_FUNC_TYPE_MAX_PARAMS 7
+#define WASM_RT_INLINE_FUNC_TYPE_MAX_RESULTS 3
+#define WASM_RT_INLINE_FUNC_TYPE_MAX_TYPES 8
+
 /** Register a function type with the given signature. The returned function
- * index is guaranteed to be the same for all calls with the same signature.
- * The following varargs must all be of type `wasm_rt_type_t`, first the
- * params` and then the `results`.
+ * index is guaranteed to be the same for all calls with the same signature,
+ * from any module or sandbox in the process, and is never 0. `types` holds
+ * first the `params` and then the `results`; it is copied, so it need not
+ * outlive the call.
  *
  *  ```
  *    // Register (func (param i32 f32) (result i64)).
- *    wasm_rt_register_func_type(2, 1, WASM_RT_I32, WASM_RT_F32, WASM_RT_I64);
- *    => returns 1
+ *    wasm_rt_type_t t1[] = { WASM_RT_I32, WASM_RT_F32, WASM_RT_I64 };
+ *    wasm_rt_register_func_type(2, 1, t1);
+ *    => returns 0xa4000050
  *
  *    // Register (func (result i64)).
- *    wasm_rt_register_func_type(0, 1, WASM_RT_I32);
- *    => returns 2
+ *    wasm_rt_type_t t2[] = { WASM_RT_I64 };
+ *    wasm_rt_register_func_type(0, 1, t2);
+ *    => returns 0x84000001
  *
  *    // Register (func (param i32 f32) (result i64)) again.
- *    wasm_rt_register_func_type(2, 1, WASM_RT_I32, WASM_RT_F32, WASM_RT_I64);
- *    => returns 1
+ *    wasm_rt_register_func_type(2, 1, t1);
+ *    => returns 0xa4000050
  *  ``` */
-extern uint32_t wasm_rt_register_func_type(
-    wasm_func_type_t** p_func_type_structs,
-    uint32_t* p_func_type_count,
-    uint32_t params,
-    uint32_t results,
-    wasm_rt_type_t* types);
+extern uint32_t wasm_rt_register_func_type(uint32_t params,
+                                           uint32_t results,
+                                           const wasm_rt_type_t* types);
 
-extern void wasm_rt_cleanup_func_types(wasm_func_type_t** p_func_type_structs,
-                                       uint32_t* p_func_type_count);
+/** A function signature, as written out statically by wasm2c. */
+typedef struct wasm_rt_func_sig_t {
+  uint32_t param_count;
+  uint32_t result_count;
+  /** The params followed by the results. */
+  const wasm_rt_type_t* types;
+} wasm_rt_func_sig_t;
+
+/** Register the `count` signatures of `sigs` and store their function type
+ * indices in `ids`. `ids` must be zero-initialized before the first call;
+ * once it is filled in, later calls with the same `ids` only take the
+ * registry lock and return, so a module can call this for each new sandbox
+ * at no extra cost. */
+extern void wasm_rt_register_func_types(const wasm_rt_func_sig_t* sigs,
+                                        uint32_t count,
+                                        uint32_t* ids);
 
 /**
  * Return the default value of the maximum size allowed for wasm memory.
@@ -286,6 +444,62 @@ extern bool wasm_rt_allocate_memory(wasm_rt_memory_t*,
 
 extern void wasm_rt_deallocate_memory(wasm_rt_memory_t*);
 
+/** A read-only copy of the contents of a linear memory, see
+ * `wasm_rt_create_memory_image`. */
+typedef struct {
+  /** The file holding the contents of the memory. */
+  int fd;
+  /** The size of the memory when the image was created. */
+  uint32_t pages;
+} wasm_rt_memory_image_t;
+
+/** Copy the contents of `memory` into a new memory image. Returns false if
+ * memory images are not supported, which is the case without guard pages,
+ * with shadow memory checking and on platforms other than Linux. */
+extern bool wasm_rt_create_memory_image(wasm_rt_memory_image_t* image,
+                                        const wasm_rt_memory_t* memory);
+
+/** Free a memory image. Memories allocated from it may still be used. */
+extern void wasm_rt_free_memory_image(wasm_rt_memory_image_t* image);
+
+/** Like `wasm_rt_allocate_memory`, but the memory starts out with the size and
+ * contents of `image`. The contents are mapped copy-on-write, so only the
+ * pages that are written to are copied. */
+extern bool wasm_rt_allocate_memory_from_image(
+    wasm_rt_memory_t* memory,
+    const wasm_rt_memory_image_t* image,
+    uint32_t max_pages);
+
+/** Statistics of the memory pool, see `wasm_rt_get_memory_pool_stats`. */
+typedef struct {
+  /** The number of slots reserved by `wasm_rt_init_memory_pool`. */
+  uint32_t slot_count;
+  /** The number of slots used by linear memories right now. */
+  uint32_t slots_in_use;
+  /** The number of linear memories allocated from the pool. */
+  uint64_t pool_allocations;
+  /** The number of linear memories allocated outside the pool, because all
+   * slots were in use. */
+  uint64_t fallback_allocations;
+} wasm_rt_memory_pool_stats_t;
+
+/** Reserve `slot_count` linear memory slots up front, each large enough for
+ * the largest memory allowed and its guard pages. `wasm_rt_allocate_memory`
+ * then takes a free slot instead of mapping new memory, and
+ * `wasm_rt_deallocate_memory` returns it after discarding its contents. When
+ * all slots are in use, memories are mapped individually as before.
+ *
+ * The pool is only available with guard pages on 64-bit platforms. Returns
+ * false if no slot could be reserved, or if the pool was already created. */
+extern bool wasm_rt_init_memory_pool(uint32_t slot_count);
+
+/** Release the slots of the memory pool. Returns false, and leaves the pool
+ * alone, if memory from the pool is still in use. */
+extern bool wasm_rt_free_memory_pool();
+
+/** Get the statistics of the memory pool. */
+extern void wasm_rt_get_memory_pool_stats(wasm_rt_memory_pool_stats_t* stats);
+
 /** Grow a Memory object by `pages`, and return the previous page count. If
  * this new page count is greater than the maximum page count, the grow fails
  * and 0xffffffffu (UINT32_MAX) is returned instead.
@@ -301,6 +515,60 @@ extern void wasm_rt_deallocate_memory(wasm_rt_memory_t*);
  *  ``` */
 extern uint32_t wasm_rt_grow_memory(wasm_rt_memory_t*, uint32_t pages);
 
+/** Initialize a Memory object that can be shared between threads, as
+ * `wasm_rt_allocate_memory` does. The data of a shared memory never moves, so
+ * this fails if the runtime is built with
+ * `WASM_USE_INCREMENTAL_MOVEABLE_MEMORY_ALLOC` but without
+ * `WASM_USE_GUARD_PAGES`. */
+extern bool wasm_rt_allocate_shared_memory(wasm_rt_memory_t*,
+                                           uint32_t initial_pages,
+                                           uint32_t max_pages);
+
+/** Implementation of `memory.atomic.wait32` and `memory.atomic.wait64` on the
+ * (already bounds checked and aligned) address `addr` of `memory`. Blocks
+ * until notified if `*addr == expected`, for at most `timeout` nanoseconds
+ * when `timeout` is not negative. Returns 0 when woken by a notify, 1 if
+ * `*addr != expected` and 2 on timeout. */
+extern uint32_t wasm_rt_atomic_wait32(wasm_rt_memory_t* memory,
+                                      uint32_t* addr,
+                                      uint32_t expected,
+                                      int64_t timeout);
+extern uint32_t wasm_rt_atomic_wait64(wasm_rt_memory_t* memory,
+                                      uint64_t* addr,
+                                      uint64_t expected,
+                                      int64_t timeout);
+
+/** Implementation of `memory.atomic.notify`: wakes up to `count` threads
+ * waiting on `addr`, and returns the number of threads woken. */
+extern uint32_t wasm_rt_atomic_notify(wasm_rt_memory_t* memory,
+                                      void* addr,
+                                      uint32_t count);
+
+/** Implementation of `memory.copy`: copy `n` bytes from `src` to `dest`, which
+ * may overlap. Traps with `WASM_RT_TRAP_OOB`, without copying anything, if
+ * either range is out of bounds. */
+extern void wasm_rt_memory_copy(wasm_rt_memory_t*,
+                                uint32_t dest,
+                                uint32_t src,
+                                uint32_t n);
+
+/** Implementation of `memory.fill`: set `n` bytes at `dest` to the low byte of
+ * `value`. Traps with `WASM_RT_TRAP_OOB` if the range is out of bounds. */
+extern void wasm_rt_memory_fill(wasm_rt_memory_t*,
+                                uint32_t dest,
+                                uint32_t value,
+                                uint32_t n);
+
+/** Implementation of `memory.init`: copy `n` bytes at offset `src` of the data
+ * segment `data` (of `data_size` bytes) to `dest`. Traps with
+ * `WASM_RT_TRAP_OOB` if either range is out of bounds. */
+extern void wasm_rt_memory_init(wasm_rt_memory_t*,
+                                uint32_t dest,
+                                const uint8_t* data,
+                                uint32_t data_size,
+                                uint32_t src,
+                                uint32_t n);
+
 /** Initialize a Table object with an element count of `elements` and a maximum
  * page size of `max_elements`.
  *
@@ -315,11 +583,94 @@ extern void wasm_rt_allocate_table(wasm_rt_table_t*,
 
 extern void wasm_rt_deallocate_table(wasm_rt_table_t*);
 
+/** Grow a Table object, by at least 32 elements and at most doubling its
+ * size, up to its maximum size. Traps with
+ * `WASM_RT_TRAP_CALL_INDIRECT_TABLE_EXPANSION` if it is already at its maximum
+ * size. */
 extern void wasm_rt_expand_table(wasm_rt_table_t*);
 
+/** Return the index of an empty element of a Table object, other than element
+ * 0, for a callback. Elements freed with `wasm_rt_table_free_slot` are reused
+ * first. Otherwise the table is searched from where the previous search
+ * stopped, and grown with `wasm_rt_expand_table` when the search reaches its
+ * end, so this takes amortized constant time. */
+extern uint32_t wasm_rt_table_alloc_slot(wasm_rt_table_t*);
+
+/** Clear element `index` of a Table object, and make it available to
+ * `wasm_rt_table_alloc_slot` again. Does nothing if the element is already
+ * empty. */
+extern void wasm_rt_table_free_slot(wasm_rt_table_t*, uint32_t index);
+
+typedef struct wasm_rt_profile_tree_t wasm_rt_profile_tree_t;
+
+/** The profile of the functions of a sandbox, collected by the code that
+ * wasm2c generates with `--instrument`. Each sandbox has its own profile, so
+ * no locking is needed as long as a sandbox is used by one thread at a time. */
+typedef struct {
+  /** The number of functions defined by the module, and their names. */
+  uint32_t func_count;
+  const char* const* func_names;
+  /** The number of calls of each function, with `--instrument=calls`. */
+  uint64_t* calls;
+  /** The time spent in each call stack, with `--instrument=cycles`. */
+  wasm_rt_profile_tree_t* tree;
+  /** With `--instrument=branches`, the number of ifs and br_ifs, the function
+   * each one is in, and how often each one was not taken and taken. */
+  uint32_t branch_count;
+  const uint32_t* branch_funcs;
+  uint64_t* branches;
+} wasm_rt_profile_t;
+
+/** Initialize a profile of `func_count` functions. `count_calls` allocates
+ * the call counters, and `time_calls` the tree of call stacks used by
+ * `wasm_rt_profile_enter` and `wasm_rt_profile_exit`. Branch counters are
+ * allocated if `branch_funcs` is not `NULL`. */
+extern void wasm_rt_profile_init(wasm_rt_profile_t*,
+                                 uint32_t func_count,
+                                 const char* const* func_names,
+                                 bool count_calls,
+                                 bool time_calls,
+                                 uint32_t branch_count,
+                                 const uint32_t* branch_funcs);
+
+/** Free what `wasm_rt_profile_init` allocated. */
+extern void wasm_rt_profile_cleanup(wasm_rt_profile_t*);
+
+/** Record a call of function `func_index`, and start timing it. Returns the
+ * depth to pass to `wasm_rt_profile_exit` when the function returns. Calls
+ * that a trap unwound to `wasm_rt_try` are dropped from the stack first. */
+extern uint32_t wasm_rt_profile_enter(wasm_rt_profile_t*, uint32_t func_index);
+
+/** Stop timing the call that `wasm_rt_profile_enter` returned `depth` for. */
+extern void wasm_rt_profile_exit(wasm_rt_profile_t*, uint32_t depth);
+
+/** Write the profile to `out`. Times are in cycles of the time stamp counter
+ * on x86, and in nanoseconds elsewhere. Returns false if the profile has no
+ * data for `format`: a module compiled without `--instrument`, a folded
+ * profile without `--instrument=cycles`, or a flat profile of branches
+ * only. */
+extern bool wasm_rt_profile_dump(const wasm_rt_profile_t*,
+                                 FILE* out,
+                                 wasm_rt_profile_format_t format);
+
 // One time init function for wasm runtime. Should be called once for the
-// current process
-extern void wasm_rt_sys_init();
+// current process. Returns false if the fault handler could not be installed,
+// in which case out-of-bounds accesses that hit a guard page crash the process
+// instead of trapping.
+extern bool wasm_rt_sys_init();
+
+/** Turn faults in the guard pages of linear memories into
+ * `WASM_RT_TRAP_OOB`, and overflows of the native stack into
+ * `WASM_RT_TRAP_EXHAUSTION`, by installing SIGSEGV and SIGBUS handlers. Faults
+ * elsewhere go to the handlers installed before. Called by `wasm_rt_sys_init`.
+ * Returns false if this is not supported on this platform. */
+extern bool wasm_rt_install_fault_handler();
+/** Prepare the calling thread for `wasm_rt_install_fault_handler`, by giving
+ * it an alternate signal stack. This is done by `wasm_rt_try` and
+ * `wasm_rt_install_fault_handler`, so it is usually not called directly. */
+extern bool wasm_rt_init_thread();
+/** Free what `wasm_rt_init_thread` allocated for the calling thread. */
+extern void wasm_rt_free_thread();
 
 // Initialize wasi for the given sandbox. Called prior to sandbox execution.
 extern void wasm_rt_init_wasi(wasm_sandbox_wasi_data*);
@@ -338,16 +689,44 @@ extern void wasm2c_shadow_memory_create(wasm_rt_memory_t* mem);
 extern void wasm2c_shadow_memory_expand(wasm_rt_memory_t* mem);
 // Cleanup
 extern void wasm2c_shadow_memory_destroy(wasm_rt_memory_t* mem);
+// Classes of wasm functions that the shadow memory checks treat specially.
+// wasm2c computes the class of each function when generating code, and passes
+// it with the function name to the load and store checks below. The name is
+// only used when reporting an error.
+#define WASM2C_SHADOW_FUNC_PROGRAM 0u
+// dlmalloc, dlfree and sbrk, which own the allocator's globals and metadata
+#define WASM2C_SHADOW_FUNC_MALLOC_CORE 1u
+#define WASM2C_SHADOW_FUNC_CALLOC 2u
+#define WASM2C_SHADOW_FUNC_REALLOC 4u
+// Functions that intentionally read up to 7 bytes past the end of an
+// allocation for performance, such as strlen
+#define WASM2C_SHADOW_FUNC_OVERREAD 8u
+// Accesses that are checked even when WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE
+// only samples the others, see wasm2c's --shadow-check-function
+#define WASM2C_SHADOW_FUNC_ALWAYS_CHECK 16u
 // Perform checks for the load operation that completed
 WASM2C_FUNC_EXPORT extern void wasm2c_shadow_memory_load(wasm_rt_memory_t* mem,
+                                                         uint32_t shadow_class,
                                                          const char* func_name,
                                                          uint32_t ptr,
                                                          uint32_t ptr_size);
 // Perform checks for the store operation that completed
 WASM2C_FUNC_EXPORT extern void wasm2c_shadow_memory_store(wasm_rt_memory_t* mem,
+                                                          uint32_t shadow_class,
                                                           const char* func_name,
                                                           uint32_t ptr,
                                                           uint32_t ptr_size);
+// Returns the number of loads and stores until the next one to check, when
+// built with WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE. The counts are random, and
+// average the sample rate of the memory.
+WASM2C_FUNC_EXPORT extern uint32_t wasm2c_shadow_memory_next_sample(
+    wasm_rt_memory_t* mem);
+// Change the average number of loads and stores per checked one in the memory,
+// when built with WASM_CHECK_SHADOW_MEMORY_SAMPLE_RATE. A rate of 1 checks all
+// of them.
+WASM2C_FUNC_EXPORT extern void wasm2c_shadow_memory_set_sample_rate(
+    wasm_rt_memory_t* mem,
+    uint32_t rate);
 // Mark an area as allocated, if it is currently unused. If already used, this
 // is a noop.
 extern void wasm2c_shadow_memory_reserve(wasm_rt_memory_t* mem,